@@ -117,6 +117,41 @@ static inline void emit_a64_mov_i(const int is64, const int reg,
 	}
 }
 
+/*
+ * Emit a BPF load or store of size BPF_SIZE(@code) at @rn + @off as a single
+ * unsigned-offset instruction when @off allows it, saving the move of @off
+ * into a temporary. Returns false if the caller must use a register offset.
+ */
+static bool emit_ldst_imm(const u8 code, const u8 rt, const u8 rn,
+			  const s16 off, const bool load, struct jit_ctx *ctx)
+{
+	const int bytes = bpf_size_to_bytes(BPF_SIZE(code));
+	enum aarch64_insn_size_type size;
+
+	if (off < 0 || off % bytes || off / bytes > 0xfff)
+		return false;
+
+	switch (bytes) {
+	case sizeof(u8):
+		size = AARCH64_INSN_SIZE_8;
+		break;
+	case sizeof(u16):
+		size = AARCH64_INSN_SIZE_16;
+		break;
+	case sizeof(u32):
+		size = AARCH64_INSN_SIZE_32;
+		break;
+	default:
+		size = AARCH64_INSN_SIZE_64;
+		break;
+	}
+
+	emit(aarch64_insn_gen_load_store_imm(rt, rn, off, size,
+			load ? AARCH64_INSN_LDST_LOAD_IMM_OFFSET :
+			       AARCH64_INSN_LDST_STORE_IMM_OFFSET), ctx);
+	return true;
+}
+
 static inline int bpf2a64_offset(int bpf_to, int bpf_from,
 				 const struct jit_ctx *ctx)
 {
@@ -234,8 +269,7 @@ static int emit_bpf_tail_call(struct jit_ctx *ctx)
 	 *     goto out;
 	 */
 	off = offsetof(struct bpf_array, map.max_entries);
-	emit_a64_mov_i64(tmp, off, ctx);
-	emit(A64_LDR32(tmp, r2, tmp), ctx);
+	emit(A64_LDR32I(tmp, r2, off), ctx);
 	emit(A64_MOV(0, r3, r3), ctx);
 	emit(A64_CMP(0, r3, tmp), ctx);
 	emit(A64_B_(A64_COND_CS, jmp_offset), ctx);
@@ -262,8 +296,7 @@ static int emit_bpf_tail_call(struct jit_ctx *ctx)
 
 	/* goto *(prog->bpf_func + prologue_offset); */
 	off = offsetof(struct bpf_prog, bpf_func);
-	emit_a64_mov_i64(tmp, off, ctx);
-	emit(A64_LDR64(tmp, prg, tmp), ctx);
+	emit(A64_LDR64I(tmp, prg, off), ctx);
 	emit(A64_ADD_I(1, tmp, tmp, sizeof(u32) * PROLOGUE_OFFSET), ctx);
 	emit(A64_ADD_I(1, A64_SP, A64_SP, ctx->stack_size), ctx);
 	emit(A64_BR(tmp), ctx);
@@ -640,6 +673,8 @@ static int build_insn(const struct bpf_insn *insn, struct jit_ctx *ctx)
 	case BPF_LDX | BPF_MEM | BPF_H:
 	case BPF_LDX | BPF_MEM | BPF_B:
 	case BPF_LDX | BPF_MEM | BPF_DW:
+		if (emit_ldst_imm(code, dst, src, off, true, ctx))
+			break;
 		emit_a64_mov_i(1, tmp, off, ctx);
 		switch (BPF_SIZE(code)) {
 		case BPF_W:
@@ -663,8 +698,10 @@ static int build_insn(const struct bpf_insn *insn, struct jit_ctx *ctx)
 	case BPF_ST | BPF_MEM | BPF_B:
 	case BPF_ST | BPF_MEM | BPF_DW:
 		/* Load imm to a register then store it */
-		emit_a64_mov_i(1, tmp2, off, ctx);
 		emit_a64_mov_i(1, tmp, imm, ctx);
+		if (emit_ldst_imm(code, tmp, dst, off, false, ctx))
+			break;
+		emit_a64_mov_i(1, tmp2, off, ctx);
 		switch (BPF_SIZE(code)) {
 		case BPF_W:
 			emit(A64_STR32(tmp, dst, tmp2), ctx);
@@ -686,6 +723,8 @@ static int build_insn(const struct bpf_insn *insn, struct jit_ctx *ctx)
 	case BPF_STX | BPF_MEM | BPF_H:
 	case BPF_STX | BPF_MEM | BPF_B:
 	case BPF_STX | BPF_MEM | BPF_DW:
+		if (emit_ldst_imm(code, src, dst, off, false, ctx))
+			break;
 		emit_a64_mov_i(1, tmp, off, ctx);
 		switch (BPF_SIZE(code)) {
 		case BPF_W:
@@ -698,6 +698,13 @@ enum elv_merge blk_try_req_merge(struct request *req, struct request *next)
 	return ELEVATOR_NO_MERGE;
 }
 
+/*
+ * Inline crypto needs the DUN to run on from @bio into @nxt, so callers must
+ * pass the two bios that actually become adjacent: the tail of the front
+ * request and the head of the one that follows it. Comparing against the
+ * head of a request that already holds several bios makes every merge after
+ * the first fail the DUN check.
+ */
 static bool crypto_not_mergeable(const struct bio *bio, const struct bio *nxt)
 {
 	return (!pfk_allow_merge_bio(bio, nxt));
@@ -735,8 +742,8 @@ static struct request *attempt_merge(struct request_queue *q,
 	if (req->write_hint != next->write_hint)
 		return NULL;
 
-	if (crypto_not_mergeable(req->bio, next->bio))
-		return 0;
+	if (crypto_not_mergeable(req->biotail, next->bio))
+		return NULL;
 
 	/*
 	 * If we are allowed to merge, then append bio list
@@ -886,7 +893,7 @@ enum elv_merge blk_try_merge(struct request *rq, struct bio *bio)
 		return ELEVATOR_DISCARD_MERGE;
 	} else if (blk_rq_pos(rq) + blk_rq_sectors(rq) ==
 						bio->bi_iter.bi_sector) {
-		if (crypto_not_mergeable(rq->bio, bio))
+		if (crypto_not_mergeable(rq->biotail, bio))
 			return ELEVATOR_NO_MERGE;
 		return ELEVATOR_BACK_MERGE;
 	} else if (blk_rq_pos(rq) - bio_sectors(bio) ==
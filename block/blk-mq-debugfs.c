@@ -600,6 +600,27 @@ static ssize_t hctx_run_write(void *data, const char __user *buf, size_t count,
 	return count;
 }
 
+static int hctx_tag_alloc_show(void *data, struct seq_file *m)
+{
+	struct blk_mq_hw_ctx *hctx = data;
+
+	seq_printf(m, "throttled=%lu\n", hctx->tag_throttled);
+	seq_printf(m, "nowait_fail=%lu\n", hctx->tag_nowait_fail);
+	seq_printf(m, "waited=%lu\n", hctx->tag_waited);
+	seq_printf(m, "slept=%lu\n", hctx->tag_slept);
+	return 0;
+}
+
+static ssize_t hctx_tag_alloc_write(void *data, const char __user *buf,
+				    size_t count, loff_t *ppos)
+{
+	struct blk_mq_hw_ctx *hctx = data;
+
+	hctx->tag_throttled = hctx->tag_nowait_fail = 0;
+	hctx->tag_waited = hctx->tag_slept = 0;
+	return count;
+}
+
 static int hctx_active_show(void *data, struct seq_file *m)
 {
 	struct blk_mq_hw_ctx *hctx = data;
@@ -776,6 +797,7 @@ static const struct blk_mq_debugfs_attr blk_mq_debugfs_hctx_attrs[] = {
 	{"dispatched", 0600, hctx_dispatched_show, hctx_dispatched_write},
 	{"queued", 0600, hctx_queued_show, hctx_queued_write},
 	{"run", 0600, hctx_run_show, hctx_run_write},
+	{"tag_alloc", 0600, hctx_tag_alloc_show, hctx_tag_alloc_write},
 	{"active", 0400, hctx_active_show},
 	{},
 };
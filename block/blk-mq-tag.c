@@ -94,8 +94,10 @@ static int __blk_mq_get_tag(struct blk_mq_alloc_data *data,
 			    struct sbitmap_queue *bt)
 {
 	if (!(data->flags & BLK_MQ_REQ_INTERNAL) &&
-	    !hctx_may_queue(data->hctx, bt))
+	    !hctx_may_queue(data->hctx, bt)) {
+		data->hctx->tag_throttled++;
 		return -1;
+	}
 	if (data->shallow_depth)
 		return __sbitmap_queue_get_shallow(bt, data->shallow_depth);
 	else
@@ -128,9 +130,14 @@ unsigned int blk_mq_get_tag(struct blk_mq_alloc_data *data)
 	if (tag != -1)
 		goto found_tag;
 
-	if (data->flags & BLK_MQ_REQ_NOWAIT)
+	if (data->flags & BLK_MQ_REQ_NOWAIT) {
+		if (data->hctx)
+			data->hctx->tag_nowait_fail++;
 		return BLK_MQ_TAG_FAIL;
+	}
 
+	if (data->hctx)
+		data->hctx->tag_waited++;
 	ws = bt_wait_ptr(bt, data->hctx);
 	drop_ctx = data->ctx == NULL;
 	do {
@@ -159,6 +166,8 @@ unsigned int blk_mq_get_tag(struct blk_mq_alloc_data *data)
 		if (data->ctx)
 			blk_mq_put_ctx(data->ctx);
 
+		if (data->hctx)
+			data->hctx->tag_slept++;
 		io_schedule();
 
 		data->ctx = blk_mq_get_ctx(data->q);
@@ -921,6 +921,22 @@ void blk_queue_write_cache(struct request_queue *q, bool wc, bool fua)
 }
 EXPORT_SYMBOL_GPL(blk_queue_write_cache);
 
+/**
+ * blk_queue_write_buffer_avail - report free fast write buffer space
+ * @q:		the request queue for the device
+ * @pct:	percentage of the write buffer still free
+ *
+ * Devices that absorb writes in a fast buffer (e.g. an SLC cache in front
+ * of TLC flash) slow down sharply once it fills. Drivers that can read the
+ * buffer level report it here so writeback throttling can back off early.
+ */
+void blk_queue_write_buffer_avail(struct request_queue *q, unsigned int pct)
+{
+	q->write_buffer_avail = min(pct, 100U);
+	wbt_set_write_buffer(q->rq_wb, q->write_buffer_avail);
+}
+EXPORT_SYMBOL_GPL(blk_queue_write_buffer_avail);
+
 static int __init blk_settings_init(void)
 {
 	blk_max_low_pfn = max_low_pfn - 1;
@@ -36,6 +36,12 @@ enum {
 	 */
 	RWB_DEF_DEPTH	= 16,
 
+	/*
+	 * Start shrinking non-sync writeback once less than this percentage
+	 * of the device write buffer is left
+	 */
+	RWB_WBUF_LOW	= 30,
+
 	/*
 	 * 100msec window
 	 */
@@ -244,6 +250,20 @@ static bool calc_wb_limits(struct rq_wb *rwb)
 		rwb->wb_background = (rwb->wb_max + 3) / 4;
 	}
 
+	/*
+	 * Once the device's write buffer runs low, writes are about to drop
+	 * to the speed of the backing media and reads will queue behind them.
+	 * Shrink normal and background writeback with the remaining buffer,
+	 * rather than waiting for the latency spike to scale us down.
+	 */
+	if (rwb->wbuf_avail < RWB_WBUF_LOW) {
+		rwb->wb_normal = 1 + (rwb->wb_normal - 1) * rwb->wbuf_avail /
+					RWB_WBUF_LOW;
+		rwb->wb_background = 1 + (rwb->wb_background - 1) *
+					rwb->wbuf_avail / RWB_WBUF_LOW;
+		ret = true;
+	}
+
 	return ret;
 }
 
@@ -653,6 +673,15 @@ void wbt_set_write_cache(struct rq_wb *rwb, bool write_cache_on)
 		rwb->wc = write_cache_on;
 }
 
+void wbt_set_write_buffer(struct rq_wb *rwb, unsigned int pct)
+{
+	if (rwb && rwb->wbuf_avail != pct) {
+		rwb->wbuf_avail = pct;
+		calc_wb_limits(rwb);
+		rwb_wake_all(rwb);
+	}
+}
+
 /*
  * Disable wbt, if enabled by default.
  */
@@ -733,6 +762,7 @@ int wbt_init(struct request_queue *q)
 
 	rwb->wc = 1;
 	rwb->queue_depth = RWB_DEF_DEPTH;
+	rwb->wbuf_avail = q->write_buffer_avail;
 	rwb->last_comp = rwb->last_issue = jiffies;
 	rwb->queue = q;
 	rwb->win_nsec = RWB_WINDOW_NSEC;
@@ -89,6 +89,7 @@ struct rq_wb {
 
 	unsigned int wc;
 	unsigned int queue_depth;
+	unsigned int wbuf_avail;		/* free write buffer, percent */
 
 	unsigned long last_issue;		/* last non-throttled issue */
 	unsigned long last_comp;		/* last non-throttled comp */
@@ -122,6 +123,7 @@ void wbt_enable_default(struct request_queue *);
 
 void wbt_set_queue_depth(struct rq_wb *, unsigned int);
 void wbt_set_write_cache(struct rq_wb *, bool);
+void wbt_set_write_buffer(struct rq_wb *, unsigned int);
 
 u64 wbt_default_latency_nsec(struct request_queue *);
 
@@ -166,6 +168,9 @@ static inline void wbt_set_queue_depth(struct rq_wb *rwb, unsigned int depth)
 static inline void wbt_set_write_cache(struct rq_wb *rwb, bool wc)
 {
 }
+static inline void wbt_set_write_buffer(struct rq_wb *rwb, unsigned int pct)
+{
+}
 static inline u64 wbt_default_latency_nsec(struct request_queue *q)
 {
 	return 0;
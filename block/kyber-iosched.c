@@ -23,6 +23,9 @@
 #include <linux/elevator.h>
 #include <linux/module.h>
 #include <linux/sbitmap.h>
+#include <linux/blk-cgroup.h>
+#include <linux/ioprio.h>
+#include <linux/iocontext.h>
 
 #include "blk.h"
 #include "blk-mq.h"
@@ -36,6 +39,7 @@ enum {
 	KYBER_READ,
 	KYBER_SYNC_WRITE,
 	KYBER_OTHER, /* Async writes, discard, etc. */
+	KYBER_BACKGROUND, /* Anything from background tasks, see bg_classify */
 	KYBER_NUM_DOMAINS,
 };
 
@@ -61,6 +65,7 @@ static const unsigned int kyber_depth[] = {
 	[KYBER_READ] = 256,
 	[KYBER_SYNC_WRITE] = 128,
 	[KYBER_OTHER] = 64,
+	[KYBER_BACKGROUND] = 64,
 };
 
 /*
@@ -70,6 +75,7 @@ static const unsigned int kyber_batch_size[] = {
 	[KYBER_READ] = 16,
 	[KYBER_SYNC_WRITE] = 8,
 	[KYBER_OTHER] = 8,
+	[KYBER_BACKGROUND] = 8,
 };
 
 struct kyber_queue_data {
@@ -92,6 +98,12 @@ struct kyber_queue_data {
 
 	/* Target latencies in nanoseconds. */
 	u64 read_lat_nsec, write_lat_nsec;
+
+	/*
+	 * Put requests from background tasks in their own domain, which is
+	 * only throttled when foreground requests miss their targets.
+	 */
+	bool bg_classify;
 };
 
 struct kyber_hctx_data {
@@ -103,11 +115,18 @@ struct kyber_hctx_data {
 	atomic_t wait_index[KYBER_NUM_DOMAINS];
 };
 
+static bool rq_is_background(const struct request *rq)
+{
+	return (rq->rq_flags & RQF_ELVPRIV) && rq->elv.priv[1];
+}
+
 static int rq_sched_domain(const struct request *rq)
 {
 	unsigned int op = rq->cmd_flags;
 
-	if ((op & REQ_OP_MASK) == REQ_OP_READ)
+	if (rq_is_background(rq))
+		return KYBER_BACKGROUND;
+	else if ((op & REQ_OP_MASK) == REQ_OP_READ)
 		return KYBER_READ;
 	else if ((op & REQ_OP_MASK) == REQ_OP_WRITE && op_is_sync(op))
 		return KYBER_SYNC_WRITE;
@@ -244,6 +263,40 @@ static void kyber_adjust_other_depth(struct kyber_queue_data *kqd,
 		sbitmap_queue_resize(&kqd->domain_tokens[KYBER_OTHER], depth);
 }
 
+/*
+ * Adjust the depth of background requests given the status of foreground
+ * reads and synchronous writes. Background work keeps its full depth while
+ * both are on target and backs off as soon as either one misses.
+ */
+static void kyber_adjust_bg_depth(struct kyber_queue_data *kqd,
+				  int read_status, int write_status)
+{
+	unsigned int orig_depth, depth;
+
+	orig_depth = depth = kqd->domain_tokens[KYBER_BACKGROUND].sb.depth;
+
+	switch (min(read_status, write_status)) {
+	case GREAT:
+	case NONE:
+		depth += 2;
+		break;
+	case GOOD:
+		depth++;
+		break;
+	case BAD:
+		depth -= max(depth / 4, 1U);
+		break;
+	case AWFUL:
+		depth /= 2;
+		break;
+	}
+
+	depth = clamp(depth, 1U, kyber_depth[KYBER_BACKGROUND]);
+	if (depth != orig_depth)
+		sbitmap_queue_resize(&kqd->domain_tokens[KYBER_BACKGROUND],
+				     depth);
+}
+
 /*
  * Apply heuristics for limiting queue depths based on gathered latency
  * statistics.
@@ -260,14 +313,17 @@ static void kyber_stat_timer_fn(struct blk_stat_callback *cb)
 	kyber_adjust_rw_depth(kqd, KYBER_SYNC_WRITE, write_status, read_status);
 	kyber_adjust_other_depth(kqd, read_status, write_status,
 				 cb->stat[KYBER_OTHER].nr_samples != 0);
+	kyber_adjust_bg_depth(kqd, read_status, write_status);
 
 	/*
 	 * Continue monitoring latencies if we aren't hitting the targets or
-	 * we're still throttling other requests.
+	 * we're still throttling other or background requests.
 	 */
 	if (!blk_stat_is_active(kqd->cb) &&
 	    ((IS_BAD(read_status) || IS_BAD(write_status) ||
-	      kqd->domain_tokens[KYBER_OTHER].sb.depth < kyber_depth[KYBER_OTHER])))
+	      kqd->domain_tokens[KYBER_OTHER].sb.depth < kyber_depth[KYBER_OTHER] ||
+	      kqd->domain_tokens[KYBER_BACKGROUND].sb.depth <
+	      kyber_depth[KYBER_BACKGROUND])))
 		blk_stat_activate_msecs(kqd->cb, 100);
 }
 
@@ -324,6 +380,7 @@ static struct kyber_queue_data *kyber_queue_data_alloc(struct request_queue *q)
 
 	kqd->read_lat_nsec = 2000000ULL;
 	kqd->write_lat_nsec = 10000000ULL;
+	kqd->bg_classify = false;
 
 	return kqd;
 
@@ -439,9 +496,43 @@ static void kyber_limit_depth(unsigned int op, struct blk_mq_alloc_data *data)
 	}
 }
 
+/*
+ * Background work is what Android moves out of the way of the user: tasks
+ * in a non-root blkio cgroup, idle class I/O, and periodic or background
+ * writeback from the flusher threads.
+ */
+static bool kyber_bio_is_background(struct bio *bio)
+{
+	struct io_context *ioc;
+	bool bg = false;
+
+	if (!bio)
+		return false;
+
+	if (bio->bi_opf & REQ_BACKGROUND)
+		return true;
+
+	ioc = rq_ioc(bio);
+	if (IOPRIO_PRIO_CLASS(bio_prio(bio)) == IOPRIO_CLASS_IDLE ||
+	    (!ioprio_valid(bio_prio(bio)) && ioc &&
+	     IOPRIO_PRIO_CLASS(ioc->ioprio) == IOPRIO_CLASS_IDLE))
+		return true;
+
+#ifdef CONFIG_BLK_CGROUP
+	rcu_read_lock();
+	bg = &bio_blkcg(bio)->css != blkcg_root_css;
+	rcu_read_unlock();
+#endif
+	return bg;
+}
+
 static void kyber_prepare_request(struct request *rq, struct bio *bio)
 {
+	struct kyber_queue_data *kqd = rq->q->elevator->elevator_data;
+
 	rq_set_domain_token(rq, -1);
+	rq->elv.priv[1] = (void *)(long)(kqd->bg_classify &&
+					 kyber_bio_is_background(bio));
 }
 
 static void kyber_finish_request(struct request *rq)
@@ -672,10 +763,35 @@ KYBER_LAT_SHOW_STORE(read);
 KYBER_LAT_SHOW_STORE(write);
 #undef KYBER_LAT_SHOW_STORE
 
+static ssize_t kyber_bg_classify_show(struct elevator_queue *e, char *page)
+{
+	struct kyber_queue_data *kqd = e->elevator_data;
+
+	return sprintf(page, "%d\n", kqd->bg_classify);
+}
+
+static ssize_t kyber_bg_classify_store(struct elevator_queue *e,
+				       const char *page, size_t count)
+{
+	struct kyber_queue_data *kqd = e->elevator_data;
+	bool val;
+	int ret;
+
+	ret = kstrtobool(page, &val);
+	if (ret)
+		return ret;
+
+	kqd->bg_classify = val;
+
+	return count;
+}
+
 #define KYBER_LAT_ATTR(op) __ATTR(op##_lat_nsec, 0644, kyber_##op##_lat_show, kyber_##op##_lat_store)
 static struct elv_fs_entry kyber_sched_attrs[] = {
 	KYBER_LAT_ATTR(read),
 	KYBER_LAT_ATTR(write),
+	__ATTR(bg_classify, 0644, kyber_bg_classify_show,
+	       kyber_bg_classify_store),
 	__ATTR_NULL
 };
 #undef KYBER_LAT_ATTR
@@ -738,6 +854,7 @@ static int kyber_##name##_waiting_show(void *data, struct seq_file *m)	\
 KYBER_DEBUGFS_DOMAIN_ATTRS(KYBER_READ, read)
 KYBER_DEBUGFS_DOMAIN_ATTRS(KYBER_SYNC_WRITE, sync_write)
 KYBER_DEBUGFS_DOMAIN_ATTRS(KYBER_OTHER, other)
+KYBER_DEBUGFS_DOMAIN_ATTRS(KYBER_BACKGROUND, background)
 #undef KYBER_DEBUGFS_DOMAIN_ATTRS
 
 static int kyber_async_depth_show(void *data, struct seq_file *m)
@@ -764,6 +881,9 @@ static int kyber_cur_domain_show(void *data, struct seq_file *m)
 	case KYBER_OTHER:
 		seq_puts(m, "OTHER\n");
 		break;
+	case KYBER_BACKGROUND:
+		seq_puts(m, "BACKGROUND\n");
+		break;
 	default:
 		seq_printf(m, "%u\n", khd->cur_domain);
 		break;
@@ -786,6 +906,7 @@ static const struct blk_mq_debugfs_attr kyber_queue_debugfs_attrs[] = {
 	KYBER_QUEUE_DOMAIN_ATTRS(read),
 	KYBER_QUEUE_DOMAIN_ATTRS(sync_write),
 	KYBER_QUEUE_DOMAIN_ATTRS(other),
+	KYBER_QUEUE_DOMAIN_ATTRS(background),
 	{"async_depth", 0400, kyber_async_depth_show},
 	{},
 };
@@ -798,6 +919,7 @@ static const struct blk_mq_debugfs_attr kyber_hctx_debugfs_attrs[] = {
 	KYBER_HCTX_DOMAIN_ATTRS(read),
 	KYBER_HCTX_DOMAIN_ATTRS(sync_write),
 	KYBER_HCTX_DOMAIN_ATTRS(other),
+	KYBER_HCTX_DOMAIN_ATTRS(background),
 	{"cur_domain", 0400, kyber_cur_domain_show},
 	{"batching", 0400, kyber_batching_show},
 	{},
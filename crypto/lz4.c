@@ -29,6 +29,14 @@ struct lz4_ctx {
 	void *lz4_comp_mem;
 };
 
+/*
+ * Higher values skip ahead faster on incompressible input, trading ratio
+ * for speed. Page-sized users such as zram mostly care about the latter.
+ */
+static int acceleration = LZ4_ACCELERATION_DEFAULT;
+module_param(acceleration, int, 0644);
+MODULE_PARM_DESC(acceleration, "LZ4 compression acceleration factor");
+
 static void *lz4_alloc_ctx(struct crypto_scomp *tfm)
 {
 	void *ctx;
@@ -66,8 +74,8 @@ static void lz4_exit(struct crypto_tfm *tfm)
 static int __lz4_compress_crypto(const u8 *src, unsigned int slen,
 				 u8 *dst, unsigned int *dlen, void *ctx)
 {
-	int out_len = LZ4_compress_default(src, dst,
-		slen, *dlen, ctx);
+	int out_len = LZ4_compress_fast(src, dst,
+		slen, *dlen, READ_ONCE(acceleration), ctx);
 
 	if (!out_len)
 		return -EINVAL;
@@ -185,6 +185,171 @@ static inline void binder_stats_created(enum binder_stat_types type)
 	atomic_inc(&binder_stats.obj_created[type]);
 }
 
+#ifdef CONFIG_ANDROID_BINDER_LATENCY_STATS
+static const char * const binder_latency_strings[] = {
+	"queue",
+	"wakeup",
+	"reply",
+	"boosted"
+};
+
+static void binder_latency_add(struct binder_latency_stats *lat,
+			       enum binder_latency_types type, ktime_t delta)
+{
+	s64 us = ktime_to_us(delta);
+	int bucket = 0;
+
+	if (us > 0)
+		bucket = min_t(int, ilog2(us), BINDER_LAT_BUCKETS - 1);
+	atomic_inc(&lat->hist[type][bucket]);
+}
+
+static void binder_stat_latency(struct binder_proc *proc,
+				struct binder_thread *thread,
+				struct binder_node *node,
+				enum binder_latency_types type,
+				ktime_t start, ktime_t end)
+{
+	ktime_t delta = ktime_sub(end, start);
+
+	binder_latency_add(&binder_stats.latency, type, delta);
+	binder_latency_add(&proc->stats.latency, type, delta);
+	binder_latency_add(&thread->stats.latency, type, delta);
+	if (node)
+		binder_latency_add(&node->latency, type, delta);
+}
+
+static inline void binder_latency_mark_enqueue(struct binder_transaction *t)
+{
+	t->enqueue_ts = ktime_get();
+}
+
+static inline void binder_latency_mark_wakeup_ilocked(
+		struct binder_thread *thread)
+{
+	if (!thread->wakeup_ts)
+		thread->wakeup_ts = ktime_get();
+}
+
+static void binder_latency_mark_dequeue_ilocked(struct binder_thread *thread,
+						struct binder_work *w)
+{
+	if (w->type == BINDER_WORK_TRANSACTION) {
+		struct binder_transaction *t =
+			container_of(w, struct binder_transaction, work);
+
+		t->dequeue_ts = ktime_get();
+		t->wakeup_ts = thread->wakeup_ts;
+	}
+	thread->wakeup_ts = 0;
+}
+
+/*
+ * Account a transaction that was just picked up by @thread. The time it
+ * spent queued is split at the point its handler was woken, if it was
+ * woken for it at all; otherwise the whole wait counts as queueing.
+ */
+static void binder_latency_txn_start(struct binder_proc *proc,
+				     struct binder_thread *thread,
+				     struct binder_transaction *t)
+{
+	struct binder_node *node = t->buffer->target_node;
+	ktime_t wakeup_ts = t->wakeup_ts;
+
+	if (!t->enqueue_ts)
+		return;
+
+	if (wakeup_ts && ktime_before(wakeup_ts, t->enqueue_ts))
+		wakeup_ts = t->enqueue_ts;
+	if (wakeup_ts) {
+		binder_stat_latency(proc, thread, node, BINDER_LAT_QUEUE,
+				    t->enqueue_ts, wakeup_ts);
+		binder_stat_latency(proc, thread, node, BINDER_LAT_WAKEUP,
+				    wakeup_ts, t->dequeue_ts);
+	} else {
+		binder_stat_latency(proc, thread, node, BINDER_LAT_QUEUE,
+				    t->enqueue_ts, t->dequeue_ts);
+	}
+
+	/* priority inheritance had to raise the handler for this caller */
+	if (t->set_priority_called &&
+	    t->priority.prio < t->saved_priority.prio)
+		binder_stat_latency(proc, thread, node, BINDER_LAT_BOOSTED,
+				    t->enqueue_ts, t->dequeue_ts);
+}
+
+static void binder_latency_txn_reply(struct binder_proc *proc,
+				     struct binder_thread *thread,
+				     struct binder_transaction *in_reply_to)
+{
+	if (in_reply_to->dequeue_ts)
+		binder_stat_latency(proc, thread, NULL, BINDER_LAT_REPLY,
+				    in_reply_to->dequeue_ts, ktime_get());
+}
+
+static bool binder_latency_empty(struct binder_latency_stats *lat)
+{
+	int type, i;
+
+	for (type = 0; type < BINDER_LAT_COUNT; type++)
+		for (i = 0; i < BINDER_LAT_BUCKETS; i++)
+			if (atomic_read(&lat->hist[type][i]))
+				return false;
+	return true;
+}
+
+static void print_binder_latency(struct seq_file *m, const char *prefix,
+				 struct binder_latency_stats *lat)
+{
+	int type, i;
+
+	BUILD_BUG_ON(ARRAY_SIZE(binder_latency_strings) != BINDER_LAT_COUNT);
+	for (type = 0; type < BINDER_LAT_COUNT; type++) {
+		bool empty = true;
+
+		for (i = 0; i < BINDER_LAT_BUCKETS; i++) {
+			int temp = atomic_read(&lat->hist[type][i]);
+
+			if (!temp)
+				continue;
+			if (empty)
+				seq_printf(m, "%slatency %s (usec:count):",
+					   prefix, binder_latency_strings[type]);
+			empty = false;
+			seq_printf(m, " %lu:%d", i ? 1UL << i : 0UL, temp);
+		}
+		if (!empty)
+			seq_puts(m, "\n");
+	}
+}
+#else
+static inline void binder_latency_mark_enqueue(struct binder_transaction *t)
+{
+}
+
+static inline void binder_latency_mark_wakeup_ilocked(
+		struct binder_thread *thread)
+{
+}
+
+static inline void binder_latency_mark_dequeue_ilocked(
+		struct binder_thread *thread, struct binder_work *w)
+{
+}
+
+static inline void binder_latency_txn_start(struct binder_proc *proc,
+					    struct binder_thread *thread,
+					    struct binder_transaction *t)
+{
+}
+
+static inline void binder_latency_txn_reply(struct binder_proc *proc,
+		struct binder_thread *thread,
+		struct binder_transaction *in_reply_to)
+{
+}
+#endif
+
 struct binder_transaction_log binder_transaction_log;
 struct binder_transaction_log binder_transaction_log_failed;
 
@@ -614,6 +779,7 @@ static void binder_wakeup_thread_ilocked(struct binder_proc *proc,
 	assert_spin_locked(&proc->inner_lock);
 
 	if (thread) {
+		binder_latency_mark_wakeup_ilocked(thread);
 		if (sync)
 			wake_up_interruptible_sync(&thread->wait);
 		else
@@ -2562,6 +2728,7 @@ static int binder_proc_transaction(struct binder_transaction *t,
 		return proc->is_frozen ? BR_FROZEN_REPLY : BR_DEAD_REPLY;
 	}
 
+	binder_latency_mark_enqueue(t);
 	if (!thread && !pending_async)
 		thread = binder_select_thread_ilocked(proc);
 
@@ -3191,7 +3358,7 @@ static void binder_transaction(struct binder_proc *proc,
 				return_error_line = __LINE__;
 				goto err_bad_offset;
 			}
-			if (binder_alloc_copy_user_to_buffer(
+			if (binder_alloc_share_user_to_buffer(
 						&target_proc->alloc,
 						t->buffer,
 						sg_buf_offset,
@@ -3259,6 +3426,7 @@ static void binder_transaction(struct binder_proc *proc,
 		target_proc->outstanding_txns++;
 		binder_inner_proc_unlock(target_proc);
 		wake_up_interruptible_sync(&target_thread->wait);
+		binder_latency_txn_reply(proc, thread, in_reply_to);
 		binder_restore_priority(current, in_reply_to->saved_priority);
 		binder_free_transaction(in_reply_to);
 	} else if (!(t->flags & TF_ONE_WAY)) {
@@ -4098,6 +4266,7 @@ static int binder_thread_read(struct binder_proc *proc,
 		w = binder_dequeue_work_head_ilocked(list);
 		if (binder_worklist_empty_ilocked(&thread->todo))
 			thread->process_todo = false;
+		binder_latency_mark_dequeue_ilocked(thread, w);
 
 		switch (w->type) {
 		case BINDER_WORK_TRANSACTION: {
@@ -4286,6 +4455,7 @@ static int binder_thread_read(struct binder_proc *proc,
 			node_prio.prio = target_node->min_priority;
 			binder_transaction_priority(current, t, node_prio,
 						    target_node->inherit_rt);
+			binder_latency_txn_start(proc, thread, t);
 			cmd = BR_TRANSACTION;
 		} else {
 			trd->target.ptr = 0;
@@ -5914,6 +6084,9 @@ static void print_binder_stats(struct seq_file *m, const char *prefix,
 				created - deleted,
 				created);
 	}
+#ifdef CONFIG_ANDROID_BINDER_LATENCY_STATS
+	print_binder_latency(m, prefix, &stats->latency);
+#endif
 }
 
 static void print_binder_proc_stats(struct seq_file *m,
@@ -5949,6 +6122,20 @@ static void print_binder_proc_stats(struct seq_file *m,
 		count++;
 	binder_inner_proc_unlock(proc);
 	seq_printf(m, "  nodes: %d\n", count);
+#ifdef CONFIG_ANDROID_BINDER_LATENCY_STATS
+	binder_inner_proc_lock(proc);
+	for (n = rb_first(&proc->nodes); n != NULL; n = rb_next(n)) {
+		struct binder_node *node = rb_entry(n, struct binder_node,
+						    rb_node);
+
+		if (binder_latency_empty(&node->latency))
+			continue;
+		seq_printf(m, "  node %d u%016llx:\n", node->debug_id,
+			   (u64)node->ptr);
+		print_binder_latency(m, "    ", &node->latency);
+	}
+	binder_inner_proc_unlock(proc);
+#endif
 	count = 0;
 	strong = 0;
 	weak = 0;
@@ -41,6 +41,14 @@ static uint32_t binder_alloc_debug_mask = BINDER_DEBUG_USER_ERROR;
 module_param_named(debug_mask, binder_alloc_debug_mask,
 		   uint, 0644);
 
+/*
+ * Scatter-gather buffers of at least this many bytes have their shared
+ * memory pages mapped into the target instead of copied. 0 disables it.
+ */
+static unsigned int binder_alloc_share_threshold;
+module_param_named(share_threshold, binder_alloc_share_threshold,
+		   uint, 0644);
+
 #define binder_alloc_debug(mask, x...) \
 	do { \
 		if (binder_alloc_debug_mask & mask) \
@@ -355,6 +363,124 @@ static inline struct vm_area_struct *binder_alloc_get_vma(
 	return vma;
 }
 
+static int binder_alloc_share_page(struct binder_alloc *alloc, size_t index,
+				   const void __user *from)
+{
+	struct binder_lru_page *lru_page = &alloc->pages[index];
+	unsigned long user_page_addr;
+	struct vm_area_struct *vma;
+	struct mm_struct *mm;
+	struct page *page;
+	int ret;
+
+	if (get_user_pages_fast((uintptr_t)from, 1, 0, &page) != 1)
+		return -EFAULT;
+
+	/*
+	 * Anonymous pages cannot be inserted into another mm; only pages
+	 * that are already backed by shared memory can be handed over.
+	 */
+	if (PageAnon(page)) {
+		ret = -EINVAL;
+		goto err_put_page;
+	}
+
+	mm = alloc->vma_vm_mm;
+	if (!mmget_not_zero(mm)) {
+		ret = -ESRCH;
+		goto err_put_page;
+	}
+
+	user_page_addr = (uintptr_t)alloc->buffer + index * PAGE_SIZE;
+	mutex_lock(&alloc->mutex);
+	down_read(&mm->mmap_sem);
+	vma = binder_alloc_get_vma(alloc);
+	if (!vma || lru_page->shared_page || !lru_page->page_ptr) {
+		ret = -ESRCH;
+		goto err_unlock;
+	}
+
+	zap_page_range(vma, user_page_addr, PAGE_SIZE);
+	ret = vm_insert_page(vma, user_page_addr, page);
+	if (ret) {
+		WARN_ON(vm_insert_page(vma, user_page_addr,
+				       lru_page->page_ptr));
+		goto err_unlock;
+	}
+	lru_page->shared_page = page;
+	alloc->shared_pages++;
+	up_read(&mm->mmap_sem);
+	mutex_unlock(&alloc->mutex);
+	mmput_async(mm);
+	return 0;
+
+err_unlock:
+	up_read(&mm->mmap_sem);
+	mutex_unlock(&alloc->mutex);
+	mmput_async(mm);
+err_put_page:
+	put_page(page);
+	return ret;
+}
+
+/*
+ * Put the buffer's own page back in place of a shared one. With @copy the
+ * shared contents are preserved, which is how kernel writes into a shared
+ * page get their copy-on-write semantics.
+ */
+static void binder_alloc_unshare_page_locked(struct binder_alloc *alloc,
+					     size_t index, bool copy)
+{
+	struct binder_lru_page *lru_page = &alloc->pages[index];
+	struct page *page = lru_page->shared_page;
+	struct vm_area_struct *vma;
+	struct mm_struct *mm;
+
+	if (!page)
+		return;
+
+	if (copy)
+		copy_highpage(lru_page->page_ptr, page);
+
+	mm = alloc->vma_vm_mm;
+	if (mmget_not_zero(mm)) {
+		unsigned long user_page_addr;
+
+		user_page_addr = (uintptr_t)alloc->buffer + index * PAGE_SIZE;
+		down_read(&mm->mmap_sem);
+		vma = binder_alloc_get_vma(alloc);
+		if (vma) {
+			zap_page_range(vma, user_page_addr, PAGE_SIZE);
+			WARN_ON(vm_insert_page(vma, user_page_addr,
+					       lru_page->page_ptr));
+		}
+		up_read(&mm->mmap_sem);
+		mmput_async(mm);
+	}
+
+	lru_page->shared_page = NULL;
+	alloc->shared_pages--;
+	put_page(page);
+}
+
+static void binder_alloc_unshare_buf_locked(struct binder_alloc *alloc,
+					    struct binder_buffer *buffer,
+					    size_t buffer_size)
+{
+	void __user *page_addr;
+	void __user *end;
+
+	if (!alloc->shared_pages)
+		return;
+
+	end = (void __user *)
+		(((uintptr_t)buffer->user_data + buffer_size) & PAGE_MASK);
+	for (page_addr = (void __user *)PAGE_ALIGN((uintptr_t)buffer->user_data);
+	     page_addr < end; page_addr += PAGE_SIZE)
+		binder_alloc_unshare_page_locked(alloc,
+				(page_addr - alloc->buffer) / PAGE_SIZE, false);
+}
+
 static bool debug_low_async_space_locked(struct binder_alloc *alloc, int pid)
 {
 	/*
@@ -398,6 +524,69 @@ static bool debug_low_async_space_locked(struct binder_alloc *alloc, int pid)
 	return false;
 }
 
+static void binder_release_buf_locked(struct binder_alloc *alloc,
+				      struct binder_buffer *buffer,
+				      size_t buffer_size);
+
+static struct binder_buffer *binder_alloc_get_cached_buf_locked(
+		struct binder_alloc *alloc, size_t size, size_t max_size)
+{
+	struct binder_buffer *buffer;
+	int i;
+
+	for (i = DIV_ROUND_UP(size, BINDER_SMALL_BUF_GRAIN) - 1;
+	     i < BINDER_SMALL_BUF_CLASSES; i++) {
+		buffer = list_first_entry_or_null(&alloc->small_free[i],
+						  struct binder_buffer,
+						  cache_entry);
+		if (!buffer)
+			continue;
+		if (binder_alloc_buffer_size(alloc, buffer) > max_size)
+			return NULL;
+		list_del(&buffer->cache_entry);
+		alloc->small_free_count[i]--;
+		return buffer;
+	}
+	return NULL;
+}
+
+static bool binder_alloc_cache_buf_locked(struct binder_alloc *alloc,
+					  struct binder_buffer *buffer,
+					  size_t buffer_size)
+{
+	int i;
+
+	if (buffer_size < BINDER_SMALL_BUF_GRAIN ||
+	    buffer_size > BINDER_SMALL_BUF_SIZE || !alloc->vma)
+		return false;
+
+	i = buffer_size / BINDER_SMALL_BUF_GRAIN - 1;
+	if (alloc->small_free_count[i] >= BINDER_SMALL_BUF_DEPTH)
+		return false;
+
+	list_add(&buffer->cache_entry, &alloc->small_free[i]);
+	alloc->small_free_count[i]++;
+	return true;
+}
+
+static int binder_alloc_drain_cache_locked(struct binder_alloc *alloc)
+{
+	struct binder_buffer *buffer, *tmp;
+	int i, count = 0;
+
+	for (i = 0; i < BINDER_SMALL_BUF_CLASSES; i++) {
+		list_for_each_entry_safe(buffer, tmp, &alloc->small_free[i],
+					 cache_entry) {
+			list_del(&buffer->cache_entry);
+			binder_release_buf_locked(alloc, buffer,
+				binder_alloc_buffer_size(alloc, buffer));
+			count++;
+		}
+		alloc->small_free_count[i] = 0;
+	}
+	return count;
+}
+
 static struct binder_buffer *binder_alloc_new_buf_locked(
 				struct binder_alloc *alloc,
 				size_t data_size,
@@ -449,6 +638,20 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 		return ERR_PTR(-ENOSPC);
 	}
 
+	if (size <= BINDER_SMALL_BUF_SIZE) {
+		buffer = binder_alloc_get_cached_buf_locked(alloc, size,
+				is_async ? alloc->free_async_space :
+					   BINDER_SMALL_BUF_SIZE);
+		if (buffer) {
+			size = binder_alloc_buffer_size(alloc, buffer);
+			binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
+				     "%d: binder_alloc_buf size %zd got cached buffer %pK\n",
+				      alloc->pid, size, buffer);
+			goto init_buffer;
+		}
+	}
+
+retry:
 	while (n) {
 		buffer = rb_entry(n, struct binder_buffer, rb_node);
 		BUG_ON(!buffer->free);
@@ -464,6 +667,10 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 			break;
 		}
 	}
+	if (best_fit == NULL && binder_alloc_drain_cache_locked(alloc)) {
+		n = alloc->free_buffers.rb_node;
+		goto retry;
+	}
 	if (best_fit == NULL) {
 		size_t allocated_buffers = 0;
 		size_t largest_alloc_size = 0;
@@ -537,6 +744,7 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 	}
 
 	rb_erase(best_fit, &alloc->free_buffers);
+init_buffer:
 	buffer->free = 0;
 	buffer->allow_user_free = 0;
 	binder_insert_allocated_buffer_locked(alloc, buffer);
@@ -693,12 +901,24 @@ static void binder_free_buf_locked(struct binder_alloc *alloc,
 			      alloc->pid, size, alloc->free_async_space);
 	}
 
+	binder_alloc_unshare_buf_locked(alloc, buffer, buffer_size);
+
+	rb_erase(&buffer->rb_node, &alloc->allocated_buffers);
+	if (binder_alloc_cache_buf_locked(alloc, buffer, buffer_size))
+		return;
+
+	binder_release_buf_locked(alloc, buffer, buffer_size);
+}
+
+static void binder_release_buf_locked(struct binder_alloc *alloc,
+				      struct binder_buffer *buffer,
+				      size_t buffer_size)
+{
 	binder_update_page_range(alloc, 0,
 		(void __user *)PAGE_ALIGN((uintptr_t)buffer->user_data),
 		(void __user *)(((uintptr_t)
 			  buffer->user_data + buffer_size) & PAGE_MASK));
 
-	rb_erase(&buffer->rb_node, &alloc->allocated_buffers);
 	buffer->free = 1;
 	if (!list_is_last(&buffer->entry, &alloc->buffers)) {
 		struct binder_buffer *next = binder_buffer_next(buffer);
@@ -741,6 +961,12 @@ void binder_alloc_free_buf(struct binder_alloc *alloc,
 	 * needed for correctness here.
 	 */
 	if (buffer->clear_on_free) {
+		if (READ_ONCE(alloc->shared_pages)) {
+			mutex_lock(&alloc->mutex);
+			binder_alloc_unshare_buf_locked(alloc, buffer,
+				binder_alloc_buffer_size(alloc, buffer));
+			mutex_unlock(&alloc->mutex);
+		}
 		binder_alloc_clear_buf(alloc, buffer);
 		buffer->clear_on_free = false;
 	}
@@ -840,12 +1066,15 @@ void binder_alloc_deferred_release(struct binder_alloc *alloc)
 		BUG_ON(buffer->transaction);
 
 		if (buffer->clear_on_free) {
+			binder_alloc_unshare_buf_locked(alloc, buffer,
+				binder_alloc_buffer_size(alloc, buffer));
 			binder_alloc_clear_buf(alloc, buffer);
 			buffer->clear_on_free = false;
 		}
 		binder_free_buf_locked(alloc, buffer);
 		buffers++;
 	}
+	binder_alloc_drain_cache_locked(alloc);
 
 	while (!list_empty(&alloc->buffers)) {
 		buffer = list_first_entry(&alloc->buffers,
@@ -1092,9 +1321,13 @@ static struct shrinker binder_shrinker = {
  */
 void binder_alloc_init(struct binder_alloc *alloc)
 {
+	int i;
+
 	alloc->pid = current->group_leader->pid;
 	mutex_init(&alloc->mutex);
 	INIT_LIST_HEAD(&alloc->buffers);
+	for (i = 0; i < BINDER_SMALL_BUF_CLASSES; i++)
+		INIT_LIST_HEAD(&alloc->small_free[i]);
 }
 
 int binder_alloc_shrinker_init(void)
@@ -1173,7 +1406,32 @@ static struct page *binder_alloc_get_page(struct binder_alloc *alloc,
 
 	lru_page = &alloc->pages[index];
 	*pgoffp = pgoff;
-	return lru_page->page_ptr;
+	return lru_page->shared_page ?: lru_page->page_ptr;
+}
+
+/*
+ * Called before the kernel reads or writes @buffer at @buffer_offset so
+ * that it works on the buffer's own page, never on the sender's. Writes
+ * must not reach the sender, and anything the kernel validates, such as
+ * fixup parents and fd arrays, must not change before it is used.
+ */
+static void binder_alloc_prepare_access(struct binder_alloc *alloc,
+				       struct binder_buffer *buffer,
+				       binder_size_t buffer_offset)
+{
+	size_t index;
+
+	if (!READ_ONCE(alloc->shared_pages))
+		return;
+
+	index = (buffer_offset + (buffer->user_data - alloc->buffer)) >>
+		PAGE_SHIFT;
+	if (!alloc->pages[index].shared_page)
+		return;
+
+	mutex_lock(&alloc->mutex);
+	binder_alloc_unshare_page_locked(alloc, index, true);
+	mutex_unlock(&alloc->mutex);
 }
 
 /**
@@ -1235,6 +1493,7 @@ binder_alloc_copy_user_to_buffer(struct binder_alloc *alloc,
 		pgoff_t pgoff;
 		void *kptr;
 
+		binder_alloc_prepare_access(alloc, buffer, buffer_offset);
 		page = binder_alloc_get_page(alloc, buffer,
 					     buffer_offset, &pgoff);
 		size = min_t(size_t, bytes, PAGE_SIZE - pgoff);
@@ -1250,6 +1509,66 @@ binder_alloc_copy_user_to_buffer(struct binder_alloc *alloc,
 	return 0;
 }
 
+/**
+ * binder_alloc_share_user_to_buffer() - map or copy src user to tgt user
+ * @alloc: binder_alloc for this proc
+ * @buffer: binder buffer to be accessed
+ * @buffer_offset: offset into @buffer data
+ * @from: userspace pointer to source buffer
+ * @bytes: bytes to copy
+ *
+ * Same as binder_alloc_copy_user_to_buffer(), except that for transfers
+ * of at least share_threshold bytes whose source and target have the same
+ * offset within a page, whole source pages backed by shared memory are
+ * mapped read-only into the target rather than copied. The sender must not
+ * modify them until the target frees the buffer. Any page that cannot be
+ * mapped is copied, and so is any page the kernel later reads or writes.
+ *
+ * Return: bytes remaining to be copied
+ */
+unsigned long
+binder_alloc_share_user_to_buffer(struct binder_alloc *alloc,
+				  struct binder_buffer *buffer,
+				  binder_size_t buffer_offset,
+				  const void __user *from,
+				  size_t bytes)
+{
+	uintptr_t user_addr = (uintptr_t)buffer->user_data + buffer_offset;
+	size_t size;
+
+	if (!binder_alloc_share_threshold ||
+	    bytes < binder_alloc_share_threshold ||
+	    ((user_addr ^ (uintptr_t)from) & ~PAGE_MASK) ||
+	    !check_buffer(alloc, buffer, buffer_offset, bytes))
+		return binder_alloc_copy_user_to_buffer(alloc, buffer,
+							buffer_offset,
+							from, bytes);
+
+	size = min_t(size_t, bytes, PAGE_ALIGN(user_addr) - user_addr);
+	while (bytes) {
+		unsigned long ret;
+
+		if (!size)
+			size = min_t(size_t, bytes, PAGE_SIZE);
+		if (size < PAGE_SIZE ||
+		    binder_alloc_share_page(alloc,
+				(user_addr - (uintptr_t)alloc->buffer) /
+				PAGE_SIZE, from)) {
+			ret = binder_alloc_copy_user_to_buffer(alloc, buffer,
+							       buffer_offset,
+							       from, size);
+			if (ret)
+				return bytes - size + ret;
+		}
+		bytes -= size;
+		from += size;
+		buffer_offset += size;
+		user_addr += size;
+		size = 0;
+	}
+	return 0;
+}
+
 static int binder_alloc_do_buffer_copy(struct binder_alloc *alloc,
 				       bool to_buffer,
 				       struct binder_buffer *buffer,
@@ -1268,6 +1587,7 @@ static int binder_alloc_do_buffer_copy(struct binder_alloc *alloc,
 		void *tmpptr;
 		void *base_ptr;
 
+		binder_alloc_prepare_access(alloc, buffer, buffer_offset);
 		page = binder_alloc_get_page(alloc, buffer,
 					     buffer_offset, &pgoff);
 		size = min_t(size_t, bytes, PAGE_SIZE - pgoff);
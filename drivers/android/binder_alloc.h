@@ -22,6 +22,7 @@ struct binder_transaction;
  * struct binder_buffer - buffer used for binder transactions
  * @entry:              entry alloc->buffers
  * @rb_node:            node for allocated_buffers/free_buffers rb trees
+ * @cache_entry:        entry in alloc->small_free while parked in the cache
  * @free:               %true if buffer is free
  * @clear_on_free:      %true if buffer must be zeroed after use
  * @allow_user_free:    %true if user is allowed to free buffer
@@ -41,8 +42,11 @@ struct binder_transaction;
  */
 struct binder_buffer {
 	struct list_head entry; /* free and allocated entries by address */
-	struct rb_node rb_node; /* free entry by size or allocated entry */
-				/* by address */
+	union {
+		struct rb_node rb_node; /* free entry by size or allocated */
+					/* entry by address */
+		struct list_head cache_entry; /* parked small buffer */
+	};
 	unsigned free:1;
 	unsigned clear_on_free:1;
 	unsigned allow_user_free:1;
@@ -63,15 +67,29 @@ struct binder_buffer {
 /**
  * struct binder_lru_page - page object used for binder shrinker
  * @page_ptr: pointer to physical page in mmap'd space
+ * @shared_page: sender page mapped in place of @page_ptr, if any
  * @lru:      entry in binder_alloc_lru
  * @alloc:    binder_alloc for a proc
  */
 struct binder_lru_page {
 	struct list_head lru;
 	struct page *page_ptr;
+	struct page *shared_page;
 	struct binder_alloc *alloc;
 };
 
+/*
+ * Small buffers are not returned to the free_buffers tree on free. They are
+ * parked, still mapped, on a per-size-class list and handed straight back
+ * to the next transaction that fits, skipping both the best-fit walk and
+ * binder_update_page_range().
+ */
+#define BINDER_SMALL_BUF_GRAIN		32
+#define BINDER_SMALL_BUF_SIZE		256
+#define BINDER_SMALL_BUF_CLASSES	\
+	(BINDER_SMALL_BUF_SIZE / BINDER_SMALL_BUF_GRAIN)
+#define BINDER_SMALL_BUF_DEPTH		16
+
 /**
  * struct binder_alloc - per-binder proc state for binder allocator
  * @vma:                vm_area_struct passed to mmap_handler
@@ -90,8 +108,11 @@ struct binder_lru_page {
  * @buffer_size:        size of address space specified via mmap
  * @pid:                pid for associated binder_proc (invariant after init)
  * @pages_high:         high watermark of offset in @pages
+ * @shared_pages:       number of @pages currently backed by a sender page
  * @oneway_spam_detected: %true if oneway spam detection fired, clear that
  * flag once the async buffer has returned to a healthy state
+ * @small_free:         parked small buffers, indexed by size class
+ * @small_free_count:   number of buffers on each @small_free list
  *
  * Bookkeeping structure for per-proc address space management for binder
  * buffers. It is normally initialized during binder_init() and binder_mmap()
@@ -112,7 +133,10 @@ struct binder_alloc {
 	uint32_t buffer_free;
 	int pid;
 	size_t pages_high;
+	unsigned int shared_pages;
 	bool oneway_spam_detected;
+	struct list_head small_free[BINDER_SMALL_BUF_CLASSES];
+	unsigned int small_free_count[BINDER_SMALL_BUF_CLASSES];
 };
 
 #ifdef CONFIG_ANDROID_BINDER_IPC_SELFTEST
@@ -173,6 +197,13 @@ binder_alloc_copy_user_to_buffer(struct binder_alloc *alloc,
 				 const void __user *from,
 				 size_t bytes);
 
+unsigned long
+binder_alloc_share_user_to_buffer(struct binder_alloc *alloc,
+				  struct binder_buffer *buffer,
+				  binder_size_t buffer_offset,
+				  const void __user *from,
+				  size_t bytes);
+
 int binder_alloc_copy_to_buffer(struct binder_alloc *alloc,
 				struct binder_buffer *buffer,
 				binder_size_t buffer_offset,
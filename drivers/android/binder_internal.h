@@ -5,6 +5,7 @@
 
 #include <linux/export.h>
 #include <linux/fs.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
 #include <linux/miscdevice.h>
 #include <linux/mutex.h>
@@ -161,11 +162,31 @@ enum binder_stat_types {
 	BINDER_STAT_COUNT
 };
 
+#ifdef CONFIG_ANDROID_BINDER_LATENCY_STATS
+enum binder_latency_types {
+	BINDER_LAT_QUEUE,	/* enqueue until a thread is woken for it */
+	BINDER_LAT_WAKEUP,	/* thread wakeup until dequeue */
+	BINDER_LAT_REPLY,	/* dequeue until the reply is sent */
+	BINDER_LAT_BOOSTED,	/* enqueue to dequeue, priority was raised */
+	BINDER_LAT_COUNT
+};
+
+/* bucket i counts samples in [2^i, 2^(i+1)) usecs, the last is open */
+#define BINDER_LAT_BUCKETS	20
+
+struct binder_latency_stats {
+	atomic_t hist[BINDER_LAT_COUNT][BINDER_LAT_BUCKETS];
+};
+#endif
+
 struct binder_stats {
 	atomic_t br[_IOC_NR(BR_ONEWAY_SPAM_SUSPECT) + 1];
 	atomic_t bc[_IOC_NR(BC_REPLY_SG) + 1];
 	atomic_t obj_created[BINDER_STAT_COUNT];
 	atomic_t obj_deleted[BINDER_STAT_COUNT];
+#ifdef CONFIG_ANDROID_BINDER_LATENCY_STATS
+	struct binder_latency_stats latency;
+#endif
 };
 
 /**
@@ -255,6 +276,8 @@ struct binder_error {
  *                        (invariant after initialized)
  * @async_todo:           list of async work items
  *                        (protected by @proc->inner_lock)
+ * @latency:              transaction latency histograms for this node
+ *                        (atomic)
  *
  * Bookkeeping structure for binder nodes.
  */
@@ -296,6 +319,9 @@ struct binder_node {
 	};
 	bool has_async_transaction;
 	struct list_head async_todo;
+#ifdef CONFIG_ANDROID_BINDER_LATENCY_STATS
+	struct binder_latency_stats latency;
+#endif
 };
 
 struct binder_ref_death {
@@ -520,6 +546,8 @@ struct binder_proc {
  *                        when outstanding transactions are cleaned up
  *                        (protected by @proc->inner_lock)
  * @task:                 struct task_struct for this thread
+ * @wakeup_ts:            time this thread was last woken for proc work
+ *                        (protected by @proc->inner_lock)
  *
  * Bookkeeping structure for binder threads.
  */
@@ -540,6 +568,9 @@ struct binder_thread {
 	atomic_t tmp_ref;
 	bool is_dead;
 	struct task_struct *task;
+#ifdef CONFIG_ANDROID_BINDER_LATENCY_STATS
+	ktime_t wakeup_ts;
+#endif
 };
 
 /**
@@ -579,6 +610,11 @@ struct binder_transaction {
 	kuid_t	sender_euid;
 	struct list_head fd_fixups;
 	binder_uintptr_t security_ctx;
+#ifdef CONFIG_ANDROID_BINDER_LATENCY_STATS
+	ktime_t enqueue_ts;
+	ktime_t wakeup_ts;
+	ktime_t dequeue_ts;
+#endif
 	/**
 	 * @lock:  protects @from, @to_proc, and @to_thread
 	 *
@@ -65,6 +65,27 @@ static pm_message_t pm_transition;
 
 static int async_error;
 
+/*
+ * Handle every device with PM callbacks asynchronously, not only those that
+ * called device_enable_async_suspend(). Ordering then relies entirely on
+ * the parent/child and device link dependencies being complete, so this is
+ * only settable at boot and must not change during a transition.
+ */
+static bool pm_async_all;
+
+static int __init pm_async_all_setup(char *str)
+{
+	pm_async_all = true;
+	return 1;
+}
+__setup("pm_async_all", pm_async_all_setup);
+
+static bool dev_pm_async(struct device *dev)
+{
+	return dev->power.async_suspend ||
+		(pm_async_all && !dev->power.no_pm_callbacks);
+}
+
 static const char *pm_verb(int event)
 {
 	switch (event) {
@@ -255,14 +276,14 @@ static void initcall_debug_report(struct device *dev, ktime_t calltime,
 /**
  * dpm_wait - Wait for a PM operation to complete.
  * @dev: Device to wait for.
- * @async: If unset, wait only if the device's power.async_suspend flag is set.
+ * @async: If unset, wait only if the device is handled asynchronously.
  */
 static void dpm_wait(struct device *dev, bool async)
 {
 	if (!dev)
 		return;
 
-	if (async || (pm_async_enabled && dev->power.async_suspend))
+	if (async || (pm_async_enabled && dev_pm_async(dev)))
 		wait_for_completion(&dev->power.completion);
 }
 
@@ -641,7 +662,7 @@ static int device_resume_noirq(struct device *dev, pm_message_t state, bool asyn
 
 static bool is_async(struct device *dev)
 {
-	return dev->power.async_suspend && pm_async_enabled
+	return dev_pm_async(dev) && pm_async_enabled
 		&& !pm_trace_is_enabled();
 }
 
@@ -1891,7 +1912,7 @@ EXPORT_SYMBOL_GPL(__suspend_report_result);
  */
 int device_pm_wait_for_dev(struct device *subordinate, struct device *dev)
 {
-	dpm_wait(dev, subordinate->power.async_suspend);
+	dpm_wait(dev, dev_pm_async(subordinate));
 	return async_error;
 }
 EXPORT_SYMBOL_GPL(device_pm_wait_for_dev);
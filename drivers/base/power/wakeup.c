@@ -127,6 +127,7 @@ EXPORT_SYMBOL_GPL(wakeup_source_drop);
 static void wakeup_source_record(struct wakeup_source *ws)
 {
 	unsigned long flags;
+	int i;
 
 	spin_lock_irqsave(&deleted_ws.lock, flags);
 
@@ -144,6 +145,8 @@ static void wakeup_source_record(struct wakeup_source *ws)
 		deleted_ws.relax_count += ws->relax_count;
 		deleted_ws.expire_count += ws->expire_count;
 		deleted_ws.wakeup_count += ws->wakeup_count;
+		for (i = 0; i < WS_HOLD_HIST_BUCKETS; i++)
+			deleted_ws.hold_hist[i] += ws->hold_hist[i];
 	}
 
 	spin_unlock_irqrestore(&deleted_ws.lock, flags);
@@ -628,6 +631,17 @@ static inline void update_prevent_sleep_time(struct wakeup_source *ws,
 					     ktime_t now) {}
 #endif
 
+static void wakeup_source_account_hold(struct wakeup_source *ws,
+				       ktime_t duration)
+{
+	s64 us = ktime_to_us(duration);
+	int i;
+
+	for (i = 0; i < WS_HOLD_HIST_BUCKETS - 1 && us >= USEC_PER_MSEC; i++)
+		us = div_s64(us, 10);
+	ws->hold_hist[i]++;
+}
+
 /**
  * wakup_source_deactivate - Mark given wakeup source as inactive.
  * @ws: Wakeup source to handle.
@@ -664,6 +678,7 @@ static void wakeup_source_deactivate(struct wakeup_source *ws)
 	ws->total_time = ktime_add(ws->total_time, duration);
 	if (ktime_to_ns(duration) > ktime_to_ns(ws->max_time))
 		ws->max_time = duration;
+	wakeup_source_account_hold(ws, duration);
 
 	ws->last_time = now;
 	del_timer(&ws->timer);
@@ -1122,10 +1137,66 @@ static const struct file_operations wakeup_sources_stats_fops = {
 	.release = single_release,
 };
 
+static void print_wakeup_source_hist(struct seq_file *m,
+				     struct wakeup_source *ws)
+{
+	unsigned int hist[WS_HOLD_HIST_BUCKETS];
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&ws->lock, flags);
+	memcpy(hist, ws->hold_hist, sizeof(hist));
+	spin_unlock_irqrestore(&ws->lock, flags);
+
+	seq_printf(m, "%-32s", ws->name);
+	for (i = 0; i < WS_HOLD_HIST_BUCKETS; i++)
+		seq_printf(m, "\t%u", hist[i]);
+	seq_putc(m, '\n');
+}
+
+/**
+ * wakeup_sources_hist_show - Print how long wakeup sources were held.
+ * @m: seq_file to print the histograms into.
+ *
+ * Kept apart from wakeup_sources so that its format does not change under
+ * the tools already parsing it.
+ */
+static int wakeup_sources_hist_show(struct seq_file *m, void *unused)
+{
+	struct wakeup_source *ws;
+	int srcuidx;
+
+	seq_puts(m, "name\t\t\t\t\t<1ms\t<10ms\t<100ms\t<1s\t<10s\t>=10s\n");
+
+	srcuidx = srcu_read_lock(&wakeup_srcu);
+	list_for_each_entry_rcu(ws, &wakeup_sources, entry)
+		print_wakeup_source_hist(m, ws);
+	srcu_read_unlock(&wakeup_srcu, srcuidx);
+
+	print_wakeup_source_hist(m, &deleted_ws);
+
+	return 0;
+}
+
+static int wakeup_sources_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wakeup_sources_hist_show, NULL);
+}
+
+static const struct file_operations wakeup_sources_hist_fops = {
+	.owner = THIS_MODULE,
+	.open = wakeup_sources_hist_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int __init wakeup_sources_debugfs_init(void)
 {
 	wakeup_sources_stats_dentry = debugfs_create_file("wakeup_sources",
 			S_IRUGO, NULL, NULL, &wakeup_sources_stats_fops);
+	debugfs_create_file("wakeup_sources_hist", S_IRUGO, NULL, NULL,
+			    &wakeup_sources_hist_fops);
 	return 0;
 }
 
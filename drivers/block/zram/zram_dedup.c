@@ -7,16 +7,23 @@
  * 2 of the License, or (at your option) any later version.
  */
 
-#include <linux/vmalloc.h>
-#include <linux/jhash.h>
+#include <linux/crc32.h>
 #include <linux/highmem.h>
+#include <linux/rhashtable.h>
 
 #include "zram_drv.h"
 
-/* One slot will contain 128 pages theoretically */
-#define ZRAM_HASH_SHIFT		7
-#define ZRAM_HASH_SIZE_MIN	(1 << 10)
-#define ZRAM_HASH_SIZE_MAX	(1 << 31)
+/*
+ * Entries with the same checksum are chained on one rhlist, so lookups
+ * walk the chain under RCU and only take the bucket lock on insert and
+ * removal. The table grows and shrinks with the number of stored pages.
+ */
+static const struct rhashtable_params zram_dedup_params = {
+	.key_len		= sizeof(u32),
+	.key_offset		= offsetof(struct zram_entry, checksum),
+	.head_offset		= offsetof(struct zram_entry, rhlist),
+	.automatic_shrinking	= true,
+};
 
 u64 zram_dedup_dup_size(struct zram *zram)
 {
@@ -28,42 +35,24 @@ u64 zram_dedup_meta_size(struct zram *zram)
 	return (u64)atomic64_read(&zram->stats.meta_data_size);
 }
 
+/* crc32_le() is done with the CRC instructions where the CPU has them */
 static u32 zram_dedup_checksum(unsigned char *mem)
 {
-	return jhash(mem, PAGE_SIZE, 0);
+	return crc32_le(~0, mem, PAGE_SIZE);
 }
 
 void zram_dedup_insert(struct zram *zram, struct zram_entry *new,
 				u32 checksum)
 {
-	struct zram_hash *hash;
-	struct rb_root *rb_root;
-	struct rb_node **rb_node, *parent = NULL;
-	struct zram_entry *entry;
-
 	if (!zram_dedup_enabled(zram))
 		return;
 
 	new->checksum = checksum;
-	hash = &zram->hash[checksum % zram->hash_size];
-	rb_root = &hash->rb_root;
-
-	spin_lock(&hash->lock);
-	rb_node = &rb_root->rb_node;
-	while (*rb_node) {
-		parent = *rb_node;
-		entry = rb_entry(parent, struct zram_entry, rb_node);
-		if (checksum < entry->checksum)
-			rb_node = &parent->rb_left;
-		else if (checksum > entry->checksum)
-			rb_node = &parent->rb_right;
-		else
-			rb_node = &parent->rb_left;
-	}
-
-	rb_link_node(&new->rb_node, parent, rb_node);
-	rb_insert_color(&new->rb_node, rb_root);
-	spin_unlock(&hash->lock);
+	/*
+	 * A failed insertion only costs a missed deduplication later on,
+	 * and removing an entry which is not in the table is harmless.
+	 */
+	rhltable_insert(&zram->hash_table, &new->rhlist, zram_dedup_params);
 }
 
 static bool zram_dedup_match(struct zram *zram, struct zram_entry *entry,
@@ -90,93 +79,40 @@ static bool zram_dedup_match(struct zram *zram, struct zram_entry *entry,
 static unsigned long zram_dedup_put(struct zram *zram,
 				struct zram_entry *entry)
 {
-	struct zram_hash *hash;
-	u32 checksum;
 	unsigned long val;
 
-	checksum = entry->checksum;
-	hash = &zram->hash[checksum % zram->hash_size];
-
-	spin_lock(&hash->lock);
-
-	val = --entry->refcount;
-	if (!entry->refcount)
-		rb_erase(&entry->rb_node, &hash->rb_root);
+	val = atomic_long_dec_return(&entry->refcount);
+	if (!val)
+		rhltable_remove(&zram->hash_table, &entry->rhlist,
+				zram_dedup_params);
 	else
 		atomic64_sub(entry->len, &zram->stats.dup_data_size);
 
-	spin_unlock(&hash->lock);
-
 	return val;
 }
 
-static struct zram_entry *__zram_dedup_get(struct zram *zram,
-				struct zram_hash *hash, unsigned char *mem,
-				struct zram_entry *entry)
-{
-	struct zram_entry *tmp, *prev = NULL;
-	struct rb_node *rb_node;
-
-	/* find left-most entry with same checksum */
-	while ((rb_node = rb_prev(&entry->rb_node))) {
-		tmp = rb_entry(rb_node, struct zram_entry, rb_node);
-		if (tmp->checksum != entry->checksum)
-			break;
-
-		entry = tmp;
-	}
-
-again:
-	entry->refcount++;
-	atomic64_add(entry->len, &zram->stats.dup_data_size);
-	spin_unlock(&hash->lock);
-
-	if (prev)
-		zram_entry_free(zram, prev);
-
-	if (zram_dedup_match(zram, entry, mem))
-		return entry;
-
-	spin_lock(&hash->lock);
-	tmp = NULL;
-	rb_node = rb_next(&entry->rb_node);
-	if (rb_node)
-		tmp = rb_entry(rb_node, struct zram_entry, rb_node);
-
-	if (tmp && (tmp->checksum == entry->checksum)) {
-		prev = entry;
-		entry = tmp;
-		goto again;
-	}
-
-	spin_unlock(&hash->lock);
-	zram_entry_free(zram, entry);
-
-	return NULL;
-}
-
 static struct zram_entry *zram_dedup_get(struct zram *zram,
 				unsigned char *mem, u32 checksum)
 {
-	struct zram_hash *hash;
+	struct rhlist_head *list, *pos;
 	struct zram_entry *entry;
-	struct rb_node *rb_node;
 
-	hash = &zram->hash[checksum % zram->hash_size];
-
-	spin_lock(&hash->lock);
-	rb_node = hash->rb_root.rb_node;
-	while (rb_node) {
-		entry = rb_entry(rb_node, struct zram_entry, rb_node);
-		if (checksum == entry->checksum)
-			return __zram_dedup_get(zram, hash, mem, entry);
-
-		if (checksum < entry->checksum)
-			rb_node = rb_node->rb_left;
-		else
-			rb_node = rb_node->rb_right;
+	rcu_read_lock();
+	list = rhltable_lookup(&zram->hash_table, &checksum,
+			       zram_dedup_params);
+	rhl_for_each_entry_rcu(entry, pos, list, rhlist) {
+		/* lost the race against the last zram_entry_free() */
+		if (!atomic_long_inc_not_zero(&entry->refcount))
+			continue;
+
+		atomic64_add(entry->len, &zram->stats.dup_data_size);
+		if (zram_dedup_match(zram, entry, mem)) {
+			rcu_read_unlock();
+			return entry;
+		}
+		zram_entry_free(zram, entry);
 	}
-	spin_unlock(&hash->lock);
+	rcu_read_unlock();
 
 	return NULL;
 }
@@ -206,7 +142,7 @@ void zram_dedup_init_entry(struct zram *zram, struct zram_entry *entry,
 		return;
 
 	entry->handle = handle;
-	entry->refcount = 1;
+	atomic_long_set(&entry->refcount, 1);
 	entry->len = len;
 }
 
@@ -223,33 +159,22 @@ bool zram_dedup_put_entry(struct zram *zram, struct zram_entry *entry)
 
 int zram_dedup_init(struct zram *zram, size_t num_pages)
 {
-	int i;
-	struct zram_hash *hash;
+	int ret;
 
 	if (!zram_dedup_enabled(zram))
 		return 0;
 
-	zram->hash_size = num_pages >> ZRAM_HASH_SHIFT;
-	zram->hash_size = min_t(size_t, ZRAM_HASH_SIZE_MAX, zram->hash_size);
-	zram->hash_size = max_t(size_t, ZRAM_HASH_SIZE_MIN, zram->hash_size);
-	zram->hash = vzalloc(zram->hash_size * sizeof(struct zram_hash));
-	if (!zram->hash) {
+	ret = rhltable_init(&zram->hash_table, &zram_dedup_params);
+	if (ret)
 		pr_err("Error allocating zram entry hash\n");
-		return -ENOMEM;
-	}
-
-	for (i = 0; i < zram->hash_size; i++) {
-		hash = &zram->hash[i];
-		spin_lock_init(&hash->lock);
-		hash->rb_root = RB_ROOT;
-	}
 
-	return 0;
+	return ret;
 }
 
 void zram_dedup_fini(struct zram *zram)
 {
-	vfree(zram->hash);
-	zram->hash = NULL;
-	zram->hash_size = 0;
+	if (!zram_dedup_enabled(zram))
+		return;
+
+	rhltable_destroy(&zram->hash_table);
 }
@@ -32,6 +32,8 @@
 #include <linux/idr.h>
 #include <linux/sysfs.h>
 #include <linux/cpuhotplug.h>
+#include <linux/topology.h>
+#include <linux/workqueue.h>
 
 #include "zram_drv.h"
 
@@ -437,6 +439,44 @@ static void put_entry_bdev(struct zram *zram, unsigned long entry)
 	WARN_ON_ONCE(!was_set);
 }
 
+/*
+ * Grab up to @nr contiguous blocks on the backing device, returns the
+ * first one and stores the number actually taken in @got, or returns
+ * 0 if the device is full.
+ */
+static unsigned long get_entry_bdev_range(struct zram *zram,
+			unsigned int nr, unsigned int *got)
+{
+	unsigned long entry, end;
+
+	spin_lock(&zram->bitmap_lock);
+	/* prefer a hole that takes the whole batch */
+	entry = bitmap_find_next_zero_area(zram->bitmap, zram->nr_pages,
+					   1, nr, 0);
+	if (entry >= zram->nr_pages) {
+		entry = find_next_zero_bit(zram->bitmap, zram->nr_pages, 1);
+		if (entry == zram->nr_pages) {
+			spin_unlock(&zram->bitmap_lock);
+			return 0;
+		}
+	}
+
+	end = find_next_bit(zram->bitmap, zram->nr_pages, entry);
+	*got = min_t(unsigned long, nr, end - entry);
+	bitmap_set(zram->bitmap, entry, *got);
+	spin_unlock(&zram->bitmap_lock);
+
+	return entry;
+}
+
+static void put_entry_bdev_range(struct zram *zram, unsigned long entry,
+			unsigned int nr)
+{
+	spin_lock(&zram->bitmap_lock);
+	bitmap_clear(zram->bitmap, entry, nr);
+	spin_unlock(&zram->bitmap_lock);
+}
+
 void zram_page_end_io(struct bio *bio)
 {
 	struct page *page = bio->bi_io_vec[0].bv_page;
@@ -530,6 +570,7 @@ static int read_from_bdev_sync(struct zram *zram, struct bio_vec *bvec,
 static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
 			unsigned long entry, struct bio *parent, bool sync)
 {
+	atomic64_inc(&zram->stats.bd_reads);
 	if (sync)
 		return read_from_bdev_sync(zram, bvec, entry, parent);
 	else
@@ -572,6 +613,8 @@ static int write_to_bdev(struct zram *zram, struct bio_vec *bvec,
 
 	submit_bio(bio);
 	*pentry = entry;
+	atomic64_inc(&zram->stats.bd_count);
+	atomic64_inc(&zram->stats.bd_writes);
 
 	return 0;
 }
@@ -584,6 +627,30 @@ static void zram_wb_clear(struct zram *zram, u32 index)
 	entry = zram_get_element(zram, index);
 	zram_set_element(zram, index, 0);
 	put_entry_bdev(zram, entry);
+	atomic64_dec(&zram->stats.bd_count);
+}
+
+static void zram_accessed(struct zram *zram, u32 index)
+{
+	zram->table[index].ac_time = ktime_get_boottime();
+	zram_clear_flag(zram, index, ZRAM_IDLE);
+}
+
+static ssize_t bd_stat_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	ssize_t ret;
+
+	down_read(&zram->init_lock);
+	ret = scnprintf(buf, PAGE_SIZE,
+		"%8llu %8llu %8llu\n",
+			(u64)atomic64_read(&zram->stats.bd_count),
+			(u64)atomic64_read(&zram->stats.bd_reads),
+			(u64)atomic64_read(&zram->stats.bd_writes));
+	up_read(&zram->init_lock);
+
+	return ret;
 }
 
 #else
@@ -603,6 +670,7 @@ static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
 	return -EIO;
 }
 static void zram_wb_clear(struct zram *zram, u32 index) {}
+static inline void zram_accessed(struct zram *zram, u32 index) {}
 #endif
 
 
@@ -850,7 +918,8 @@ void zram_entry_free(struct zram *zram, struct zram_entry *entry)
 	if (!zram_dedup_enabled(zram))
 		return;
 
-	kfree(entry);
+	/* zram_dedup_get() may still be looking at it under RCU */
+	kfree_rcu(entry, rcu);
 
 	atomic64_sub(sizeof(*entry), &zram->stats.meta_data_size);
 }
@@ -902,6 +971,10 @@ static void zram_free_page(struct zram *zram, size_t index)
 {
 	struct zram_entry *entry;
 
+	/* a running writeback must not touch the slot's new content */
+	zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+	zram_clear_flag(zram, index, ZRAM_IDLE);
+
 	if (zram_wb_enabled(zram) && zram_test_flag(zram, index, ZRAM_WB)) {
 		zram_wb_clear(zram, index);
 		atomic64_dec(&zram->stats.pages_stored);
@@ -934,32 +1007,15 @@ static void zram_free_page(struct zram *zram, size_t index)
 	zram_set_obj_size(zram, index, 0);
 }
 
-static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
-				struct bio *bio, bool partial_io)
+/* Caller should hold the slot lock. */
+static int zram_read_from_zspool(struct zram *zram, struct page *page,
+				u32 index)
 {
 	int ret;
 	struct zram_entry *entry;
 	unsigned int size;
 	void *src, *dst;
 
-	if (zram_wb_enabled(zram)) {
-		zram_slot_lock(zram, index);
-		if (zram_test_flag(zram, index, ZRAM_WB)) {
-			struct bio_vec bvec;
-
-			zram_slot_unlock(zram, index);
-
-			bvec.bv_page = page;
-			bvec.bv_len = PAGE_SIZE;
-			bvec.bv_offset = 0;
-			return read_from_bdev(zram, &bvec,
-					zram_get_element(zram, index),
-					bio, partial_io);
-		}
-		zram_slot_unlock(zram, index);
-	}
-
-	zram_slot_lock(zram, index);
 	entry = zram_get_entry(zram, index);
 	if (!entry || zram_test_flag(zram, index, ZRAM_SAME)) {
 		unsigned long value;
@@ -969,7 +1025,6 @@ static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
 		mem = kmap_atomic(page);
 		zram_fill_page(mem, PAGE_SIZE, value);
 		kunmap_atomic(mem);
-		zram_slot_unlock(zram, index);
 		return 0;
 	}
 
@@ -991,6 +1046,34 @@ static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
 		zcomp_stream_put(zram->comp);
 	}
 	zs_unmap_object(zram->mem_pool, zram_entry_handle(zram, entry));
+
+	return ret;
+}
+
+static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
+				struct bio *bio, bool partial_io)
+{
+	int ret;
+
+	if (zram_wb_enabled(zram)) {
+		zram_slot_lock(zram, index);
+		if (zram_test_flag(zram, index, ZRAM_WB)) {
+			struct bio_vec bvec;
+
+			zram_slot_unlock(zram, index);
+
+			bvec.bv_page = page;
+			bvec.bv_len = PAGE_SIZE;
+			bvec.bv_offset = 0;
+			return read_from_bdev(zram, &bvec,
+					zram_get_element(zram, index),
+					bio, partial_io);
+		}
+		zram_slot_unlock(zram, index);
+	}
+
+	zram_slot_lock(zram, index);
+	ret = zram_read_from_zspool(zram, page, index);
 	zram_slot_unlock(zram, index);
 
 	/* Should NEVER happen. Return bio error if it does. */
@@ -1033,6 +1116,338 @@ static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 	return ret;
 }
 
+#ifdef CONFIG_ZRAM_WRITEBACK
+/* 512KB with 4K pages, so that flash sees a few large writes */
+#define ZRAM_WB_BATCH_PAGES	128
+
+struct zram_wb_batch {
+	struct page *pages[ZRAM_WB_BATCH_PAGES];
+	u32 index[ZRAM_WB_BATCH_PAGES];
+	unsigned int nr;
+};
+
+enum zram_wb_mode {
+	ZRAM_WB_IDLE,
+	ZRAM_WB_HUGE,
+};
+
+static bool zram_slot_stored(struct zram *zram, u32 index)
+{
+	if (zram_test_flag(zram, index, ZRAM_SAME) ||
+	    zram_test_flag(zram, index, ZRAM_WB))
+		return true;
+
+	return zram_get_entry(zram, index);
+}
+
+static ssize_t idle_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned long nr_pages, index;
+	ktime_t cutoff = KTIME_MAX;
+	u64 age;
+
+	/*
+	 * "all" marks every stored page idle, a number of seconds only the
+	 * pages which were not accessed for at least that long. Writing
+	 * growing ages lets user space keep several generations apart.
+	 */
+	if (!sysfs_streq(buf, "all")) {
+		if (kstrtou64(buf, 10, &age))
+			return -EINVAL;
+		cutoff = ktime_sub(ktime_get_boottime(),
+				   ktime_set(age, 0));
+	}
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		up_read(&zram->init_lock);
+		return -EINVAL;
+	}
+
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		zram_slot_lock(zram, index);
+		if (zram_slot_stored(zram, index) &&
+		    !zram_test_flag(zram, index, ZRAM_WB) &&
+		    !zram_test_flag(zram, index, ZRAM_SAME) &&
+		    ktime_compare(zram->table[index].ac_time, cutoff) <= 0)
+			zram_set_flag(zram, index, ZRAM_IDLE);
+		zram_slot_unlock(zram, index);
+		cond_resched();
+	}
+	up_read(&zram->init_lock);
+
+	return len;
+}
+
+static bool zram_wb_candidate(struct zram *zram, u32 index,
+			enum zram_wb_mode mode)
+{
+	if (!zram_slot_stored(zram, index) ||
+	    zram_test_flag(zram, index, ZRAM_WB) ||
+	    zram_test_flag(zram, index, ZRAM_SAME) ||
+	    zram_test_flag(zram, index, ZRAM_UNDER_WB))
+		return false;
+
+	if (mode == ZRAM_WB_IDLE)
+		return zram_test_flag(zram, index, ZRAM_IDLE);
+
+	return zram_get_obj_size(zram, index) == PAGE_SIZE;
+}
+
+static void zram_wb_abort(struct zram *zram, u32 index)
+{
+	zram_slot_lock(zram, index);
+	zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+	zram_slot_unlock(zram, index);
+}
+
+/*
+ * Write @nr pages of the batch starting at @first to @nr contiguous
+ * blocks of the backing device, and switch the slots which were left
+ * alone meanwhile over to their on-disk copy.
+ */
+static int zram_wb_submit(struct zram *zram, struct zram_wb_batch *wb,
+			unsigned int first, unsigned int nr,
+			unsigned long blk, enum zram_wb_mode mode)
+{
+	struct bio *bio;
+	unsigned int i;
+	int ret;
+
+	bio = bio_alloc(GFP_KERNEL, nr);
+	if (!bio)
+		return -ENOMEM;
+
+	bio->bi_iter.bi_sector = blk * (PAGE_SIZE >> 9);
+	bio_set_dev(bio, zram->bdev);
+	bio->bi_opf = REQ_OP_WRITE | REQ_SYNC;
+	for (i = 0; i < nr; i++)
+		bio_add_page(bio, wb->pages[first + i], PAGE_SIZE, 0);
+
+	ret = submit_bio_wait(bio);
+	bio_put(bio);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < nr; i++) {
+		u32 index = wb->index[first + i];
+
+		zram_slot_lock(zram, index);
+		if (!zram_test_flag(zram, index, ZRAM_UNDER_WB) ||
+		    (mode == ZRAM_WB_IDLE &&
+		     !zram_test_flag(zram, index, ZRAM_IDLE))) {
+			/* freed, rewritten or accessed during the write */
+			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+			zram_slot_unlock(zram, index);
+			put_entry_bdev(zram, blk + i);
+			continue;
+		}
+
+		zram_free_page(zram, index);
+		zram_set_flag(zram, index, ZRAM_WB);
+		zram_set_element(zram, index, blk + i);
+		zram_slot_unlock(zram, index);
+
+		atomic64_inc(&zram->stats.pages_stored);
+		atomic64_inc(&zram->stats.bd_count);
+		atomic64_inc(&zram->stats.bd_writes);
+	}
+
+	return 0;
+}
+
+static int zram_wb_flush(struct zram *zram, struct zram_wb_batch *wb,
+			enum zram_wb_mode mode)
+{
+	unsigned int done = 0, got, i;
+	unsigned long blk;
+	int ret = 0;
+
+	while (done < wb->nr) {
+		blk = get_entry_bdev_range(zram, wb->nr - done, &got);
+		if (!blk) {
+			ret = -ENOSPC;
+			break;
+		}
+
+		ret = zram_wb_submit(zram, wb, done, got, blk, mode);
+		if (ret) {
+			put_entry_bdev_range(zram, blk, got);
+			break;
+		}
+		done += got;
+	}
+
+	for (i = done; i < wb->nr; i++)
+		zram_wb_abort(zram, wb->index[i]);
+	wb->nr = 0;
+
+	return ret;
+}
+
+static int zram_writeback(struct zram *zram, enum zram_wb_mode mode)
+{
+	struct zram_wb_batch *wb;
+	unsigned long nr_pages, index;
+	unsigned int i;
+	int ret = 0;
+
+	wb = kzalloc(sizeof(*wb), GFP_KERNEL);
+	if (!wb)
+		return -ENOMEM;
+
+	for (i = 0; i < ZRAM_WB_BATCH_PAGES; i++) {
+		wb->pages[i] = alloc_page(GFP_KERNEL);
+		if (!wb->pages[i]) {
+			ret = -ENOMEM;
+			goto out_free;
+		}
+	}
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	if (!zram_wb_enabled(zram)) {
+		ret = -ENODEV;
+		goto out_unlock;
+	}
+
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		zram_slot_lock(zram, index);
+		if (!zram_wb_candidate(zram, index, mode)) {
+			zram_slot_unlock(zram, index);
+			continue;
+		}
+		ret = zram_read_from_zspool(zram, wb->pages[wb->nr], index);
+		if (ret) {
+			zram_slot_unlock(zram, index);
+			pr_err("Decompression failed! err=%d, page=%lu\n",
+				ret, index);
+			ret = 0;
+			continue;
+		}
+		zram_set_flag(zram, index, ZRAM_UNDER_WB);
+		zram_slot_unlock(zram, index);
+
+		wb->index[wb->nr++] = index;
+		if (wb->nr == ZRAM_WB_BATCH_PAGES) {
+			ret = zram_wb_flush(zram, wb, mode);
+			if (ret)
+				break;
+		}
+		cond_resched();
+	}
+
+	if (wb->nr)
+		ret = zram_wb_flush(zram, wb, mode);
+
+out_unlock:
+	up_read(&zram->init_lock);
+out_free:
+	for (i = 0; i < ZRAM_WB_BATCH_PAGES && wb->pages[i]; i++)
+		__free_page(wb->pages[i]);
+	kfree(wb);
+
+	return ret;
+}
+
+static ssize_t writeback_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	enum zram_wb_mode mode;
+	int ret;
+
+	if (sysfs_streq(buf, "idle"))
+		mode = ZRAM_WB_IDLE;
+	else if (sysfs_streq(buf, "huge"))
+		mode = ZRAM_WB_HUGE;
+	else
+		return -EINVAL;
+
+	ret = zram_writeback(zram, mode);
+
+	return ret ? ret : len;
+}
+
+/*
+ * Once the slots kept in memory reach writeback_watermark percent of the
+ * disk, idle pages are demoted to the backing device in the background.
+ * This keeps memory free for freshly swapped out pages, so zram can be
+ * sized well beyond the memory it may use, and cold data ends up on flash
+ * instead of hot data spilling to a second swap device. The scans are
+ * spaced at least ZRAM_WB_AUTO_INTERVAL apart.
+ */
+#define ZRAM_WB_AUTO_INTERVAL	HZ
+
+static void zram_wb_workfn(struct work_struct *work)
+{
+	struct zram *zram = container_of(work, struct zram, wb_work);
+
+	zram_writeback(zram, ZRAM_WB_IDLE);
+	WRITE_ONCE(zram->wb_next, jiffies + ZRAM_WB_AUTO_INTERVAL);
+}
+
+static void zram_wb_check_watermark(struct zram *zram)
+{
+	unsigned int wmark = READ_ONCE(zram->wb_watermark);
+	u64 in_mem;
+
+	if (!wmark || !zram_wb_enabled(zram) ||
+	    time_before(jiffies, READ_ONCE(zram->wb_next)))
+		return;
+
+	in_mem = atomic64_read(&zram->stats.pages_stored) -
+		 atomic64_read(&zram->stats.bd_count);
+	if (in_mem * 100 >= (u64)wmark * (zram->disksize >> PAGE_SHIFT))
+		schedule_work(&zram->wb_work);
+}
+
+static ssize_t writeback_watermark_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			READ_ONCE(zram->wb_watermark));
+}
+
+static ssize_t writeback_watermark_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned int val;
+
+	if (kstrtouint(buf, 10, &val) || val > 100)
+		return -EINVAL;
+
+	WRITE_ONCE(zram->wb_watermark, val);
+
+	return len;
+}
+
+static void zram_wb_init(struct zram *zram)
+{
+	INIT_WORK(&zram->wb_work, zram_wb_workfn);
+}
+
+static void zram_wb_cancel(struct zram *zram)
+{
+	cancel_work_sync(&zram->wb_work);
+}
+#else
+static inline void zram_wb_check_watermark(struct zram *zram) {}
+static inline void zram_wb_init(struct zram *zram) {}
+static inline void zram_wb_cancel(struct zram *zram) {}
+#endif
+
 static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 				u32 index, struct bio *bio)
 {
@@ -1166,6 +1581,7 @@ static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 
 	/* Update stats */
 	atomic64_inc(&zram->stats.pages_stored);
+	zram_wb_check_watermark(zram);
 	return ret;
 }
 
@@ -1275,6 +1691,12 @@ static int zram_bvec_rw(struct zram *zram, struct bio_vec *bvec, u32 index,
 
 	generic_end_io_acct(q, rw_acct, &zram->disk->part0, start_time);
 
+	if (likely(ret >= 0) && zram_wb_enabled(zram)) {
+		zram_slot_lock(zram, index);
+		zram_accessed(zram, index);
+		zram_slot_unlock(zram, index);
+	}
+
 	if (unlikely(ret < 0)) {
 		if (!is_write)
 			atomic64_inc(&zram->stats.failed_reads);
@@ -1331,6 +1753,167 @@ static void __zram_make_request(struct zram *zram, struct bio *bio)
 	bio_io_error(bio);
 }
 
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+static struct workqueue_struct *zram_async_wq;
+static DEFINE_PER_CPU(int, zram_async_cursor);
+
+static bool zram_async_enabled(struct zram *zram)
+{
+	return READ_ONCE(zram->use_async_write);
+}
+
+static void zram_async_work(struct work_struct *work)
+{
+	struct zram_async_queue *aq = container_of(work,
+					struct zram_async_queue, work);
+	struct bio_list bios;
+	struct blk_plug plug;
+	struct bio *bio;
+
+	spin_lock_irq(&aq->lock);
+	bios = aq->bios;
+	bio_list_init(&aq->bios);
+	spin_unlock_irq(&aq->lock);
+
+	/* backing device I/O from one batch goes out together */
+	blk_start_plug(&plug);
+	while ((bio = bio_list_pop(&bios)))
+		__zram_make_request(aq->zram, bio);
+	blk_finish_plug(&plug);
+}
+
+/*
+ * Spread the queued bios over the online CPUs of the submitter's cluster, so
+ * that reclaim is compressed and readahead decompressed by all of its cores
+ * instead of only the one kswapd or the faulting task happens to run on.
+ */
+static int zram_async_pick_cpu(void)
+{
+	int this_cpu = get_cpu();
+	const struct cpumask *cluster = topology_core_cpumask(this_cpu);
+	int cpu;
+
+	cpu = cpumask_next_and(__this_cpu_read(zram_async_cursor),
+			cluster, cpu_online_mask);
+	if (cpu >= nr_cpu_ids)
+		cpu = cpumask_first_and(cluster, cpu_online_mask);
+	if (cpu >= nr_cpu_ids)
+		cpu = this_cpu;
+	__this_cpu_write(zram_async_cursor, cpu);
+	put_cpu();
+
+	return cpu;
+}
+
+static void zram_async_queue_bio(struct zram *zram, struct bio *bio)
+{
+	int cpu = zram_async_pick_cpu();
+	struct zram_async_queue *aq = per_cpu_ptr(zram->async_queue, cpu);
+	unsigned long flags;
+
+	spin_lock_irqsave(&aq->lock, flags);
+	bio_list_add(&aq->bios, bio);
+	spin_unlock_irqrestore(&aq->lock, flags);
+
+	queue_work_on(cpu, zram_async_wq, &aq->work);
+}
+
+/* Swap readahead is decompressed by the workers too, the fault is not */
+static bool zram_async_bio(struct bio *bio)
+{
+	switch (bio_op(bio)) {
+	case REQ_OP_WRITE:
+		return true;
+	case REQ_OP_READ:
+		return bio->bi_opf & REQ_RAHEAD;
+	default:
+		return false;
+	}
+}
+
+/* Hand writes and swap readahead to the workers, see zram_async_bio() */
+static bool zram_async_submit(struct zram *zram, struct bio *bio)
+{
+	if (!zram_async_enabled(zram) || !zram_async_bio(bio))
+		return false;
+
+	zram_async_queue_bio(zram, bio);
+	return true;
+}
+
+static void zram_async_flush(struct zram *zram)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		flush_work(&per_cpu_ptr(zram->async_queue, cpu)->work);
+}
+
+static int zram_async_init(struct zram *zram)
+{
+	int cpu;
+
+	zram->async_queue = alloc_percpu(struct zram_async_queue);
+	if (!zram->async_queue)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct zram_async_queue *aq = per_cpu_ptr(zram->async_queue,
+							  cpu);
+
+		spin_lock_init(&aq->lock);
+		bio_list_init(&aq->bios);
+		INIT_WORK(&aq->work, zram_async_work);
+		aq->zram = zram;
+	}
+	return 0;
+}
+
+static void zram_async_fini(struct zram *zram)
+{
+	zram_async_flush(zram);
+	free_percpu(zram->async_queue);
+}
+
+static ssize_t async_write_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n",
+			(int)zram_async_enabled(zram));
+}
+
+static ssize_t async_write_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	bool val;
+
+	if (kstrtobool(buf, &val))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	WRITE_ONCE(zram->use_async_write, val);
+	up_write(&zram->init_lock);
+
+	/* bios queued before the switch still complete asynchronously */
+	if (!val)
+		zram_async_flush(zram);
+
+	return len;
+}
+#else
+static inline bool zram_async_enabled(struct zram *zram) { return false; }
+static inline bool zram_async_submit(struct zram *zram, struct bio *bio)
+{
+	return false;
+}
+static inline void zram_async_flush(struct zram *zram) {}
+static inline int zram_async_init(struct zram *zram) { return 0; }
+static inline void zram_async_fini(struct zram *zram) {}
+#endif
+
 /*
  * Handler function for all zram I/O requests.
  */
@@ -1344,6 +1927,9 @@ static blk_qc_t zram_make_request(struct request_queue *queue, struct bio *bio)
 		goto error;
 	}
 
+	if (zram_async_submit(zram, bio))
+		return BLK_QC_T_NONE;
+
 	__zram_make_request(zram, bio);
 	return BLK_QC_T_NONE;
 
@@ -1377,6 +1963,13 @@ static int zram_rw_page(struct block_device *bdev, sector_t sector,
 		return -ENOTSUPP;
 	zram = bdev->bd_disk->private_data;
 
+	/*
+	 * Make the caller fall back to a bio, which is completed from the
+	 * compression worker through the bio's own end_io handler.
+	 */
+	if (is_write && zram_async_enabled(zram))
+		return -EOPNOTSUPP;
+
 	if (!valid_io_request(zram, sector, PAGE_SIZE)) {
 		atomic64_inc(&zram->stats.invalid_io);
 		ret = -EINVAL;
@@ -1421,6 +2014,7 @@ static void zram_reset_device(struct zram *zram)
 	struct zcomp *comp;
 	u64 disksize;
 
+	zram_wb_cancel(zram);
 	down_write(&zram->init_lock);
 
 	zram->limit_pages = 0;
@@ -1438,6 +2032,7 @@ static void zram_reset_device(struct zram *zram)
 	part_stat_set_all(&zram->disk->part0, 0);
 
 	up_write(&zram->init_lock);
+	zram_async_flush(zram);
 	/* I/O operation under all of CPU are done so let's free */
 	zram_meta_free(zram, disksize);
 	memset(&zram->stats, 0, sizeof(zram->stats));
@@ -1571,12 +2166,19 @@ static DEVICE_ATTR_RW(max_comp_streams);
 static DEVICE_ATTR_RW(comp_algorithm);
 #ifdef CONFIG_ZRAM_WRITEBACK
 static DEVICE_ATTR_RW(backing_dev);
+static DEVICE_ATTR_WO(idle);
+static DEVICE_ATTR_WO(writeback);
+static DEVICE_ATTR_RW(writeback_watermark);
+static DEVICE_ATTR_RO(bd_stat);
 #endif
 #ifdef CONFIG_ZRAM_DEDUP
 static DEVICE_ATTR_RW(use_dedup);
 #else
 static DEVICE_ATTR_RO(use_dedup);
 #endif
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+static DEVICE_ATTR_RW(async_write);
+#endif
 
 static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_disksize.attr,
@@ -1589,8 +2191,15 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_comp_algorithm.attr,
 #ifdef CONFIG_ZRAM_WRITEBACK
 	&dev_attr_backing_dev.attr,
+	&dev_attr_idle.attr,
+	&dev_attr_writeback.attr,
+	&dev_attr_writeback_watermark.attr,
+	&dev_attr_bd_stat.attr,
 #endif
 	&dev_attr_use_dedup.attr,
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+	&dev_attr_async_write.attr,
+#endif
 	&dev_attr_io_stat.attr,
 	&dev_attr_mm_stat.attr,
 	&dev_attr_debug_stat.attr,
@@ -1626,13 +2235,18 @@ static int zram_add(void)
 	device_id = ret;
 
 	init_rwsem(&zram->init_lock);
+	zram_wb_init(zram);
+
+	ret = zram_async_init(zram);
+	if (ret)
+		goto out_free_idr;
 
 	queue = blk_alloc_queue(GFP_KERNEL);
 	if (!queue) {
 		pr_err("Error allocating disk queue for device %d\n",
 			device_id);
 		ret = -ENOMEM;
-		goto out_free_idr;
+		goto out_free_async;
 	}
 
 	blk_queue_make_request(queue, zram_make_request);
@@ -1696,6 +2310,8 @@ static int zram_add(void)
 
 out_free_queue:
 	blk_cleanup_queue(queue);
+out_free_async:
+	zram_async_fini(zram);
 out_free_idr:
 	idr_remove(&zram_index_idr, device_id);
 out_free_dev:
@@ -1731,6 +2347,7 @@ static int zram_remove(struct zram *zram)
 	blk_cleanup_queue(zram->disk->queue);
 	del_gendisk(zram->disk);
 	put_disk(zram->disk);
+	zram_async_fini(zram);
 	kfree(zram);
 	return 0;
 }
@@ -1817,6 +2434,9 @@ static void destroy_devices(void)
 	idr_destroy(&zram_index_idr);
 	unregister_blkdev(zram_major, "zram");
 	cpuhp_remove_multi_state(CPUHP_ZCOMP_PREPARE);
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+	destroy_workqueue(zram_async_wq);
+#endif
 }
 
 static int __init zram_init(void)
@@ -1828,19 +2448,31 @@ static int __init zram_init(void)
 	if (ret < 0)
 		return ret;
 
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+	/*
+	 * Writes are issued from the reclaim path, so the workers must be
+	 * able to make forward progress under memory pressure.
+	 */
+	zram_async_wq = alloc_workqueue("zram_async",
+					WQ_HIGHPRI | WQ_MEM_RECLAIM, 0);
+	if (!zram_async_wq) {
+		cpuhp_remove_multi_state(CPUHP_ZCOMP_PREPARE);
+		return -ENOMEM;
+	}
+#endif
+
 	ret = class_register(&zram_control_class);
 	if (ret) {
 		pr_err("Unable to register zram-control class\n");
-		cpuhp_remove_multi_state(CPUHP_ZCOMP_PREPARE);
-		return ret;
+		goto out_destroy_wq;
 	}
 
 	zram_major = register_blkdev(0, "zram");
 	if (zram_major <= 0) {
 		pr_err("Unable to get major number\n");
 		class_unregister(&zram_control_class);
-		cpuhp_remove_multi_state(CPUHP_ZCOMP_PREPARE);
-		return -EBUSY;
+		ret = -EBUSY;
+		goto out_destroy_wq;
 	}
 
 	while (num_devices != 0) {
@@ -1857,6 +2489,13 @@ static int __init zram_init(void)
 out_error:
 	destroy_devices();
 	return ret;
+
+out_destroy_wq:
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+	destroy_workqueue(zram_async_wq);
+#endif
+	cpuhp_remove_multi_state(CPUHP_ZCOMP_PREPARE);
+	return ret;
 }
 
 static void __exit zram_exit(void)
@@ -15,10 +15,13 @@
 #ifndef _ZRAM_DRV_H_
 #define _ZRAM_DRV_H_
 
+#include <linux/bio.h>
+#include <linux/rhashtable.h>
 #include <linux/rwsem.h>
 #include <linux/zsmalloc.h>
 #include <linux/crypto.h>
 #include <linux/spinlock.h>
+#include <linux/workqueue.h>
 
 #include "zcomp.h"
 #include "zram_dedup.h"
@@ -65,6 +68,8 @@ enum zram_pageflags {
 	ZRAM_SAME = ZRAM_FLAG_SHIFT,
 	ZRAM_ACCESS,	/* page is now accessed */
 	ZRAM_WB,	/* page is stored on backing_device */
+	ZRAM_UNDER_WB,	/* page is being written to backing_device */
+	ZRAM_IDLE,	/* not accessed since the last idle marking */
 
 	__NR_ZRAM_PAGEFLAGS,
 };
@@ -72,11 +77,12 @@ enum zram_pageflags {
 /*-- Data structures */
 
 struct zram_entry {
-	struct rb_node rb_node;
+	struct rhlist_head rhlist;
 	u32 len;
 	u32 checksum;
-	unsigned long refcount;
+	atomic_long_t refcount;
 	unsigned long handle;
+	struct rcu_head rcu;
 };
 
 /* Allocated for each disk page */
@@ -86,6 +92,9 @@ struct zram_table_entry {
 		unsigned long element;
 	};
 	unsigned long value;
+#ifdef CONFIG_ZRAM_WRITEBACK
+	ktime_t ac_time;	/* last read or write of the slot */
+#endif
 };
 
 struct zram_stats {
@@ -105,20 +114,31 @@ struct zram_stats {
 					 * duplicated
 					 */
 	atomic64_t meta_data_size;	/* size of zram_entries */
+#ifdef CONFIG_ZRAM_WRITEBACK
+	atomic64_t bd_count;		/* no. of pages in backing device */
+	atomic64_t bd_reads;		/* no. of reads from backing device */
+	atomic64_t bd_writes;		/* no. of writes to backing device */
+#endif
 };
 
-struct zram_hash {
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+/* Write and readahead bios waiting for one CPU's worker */
+struct zram_async_queue {
 	spinlock_t lock;
-	struct rb_root rb_root;
+	struct bio_list bios;
+	struct work_struct work;
+	struct zram *zram;
 };
+#endif
 
 struct zram {
 	struct zram_table_entry *table;
 	struct zs_pool *mem_pool;
 	struct zcomp *comp;
 	struct gendisk *disk;
-	struct zram_hash *hash;
-	size_t hash_size;
+#ifdef CONFIG_ZRAM_DEDUP
+	struct rhltable hash_table;
+#endif
 	/* Prevent concurrent execution of device init */
 	struct rw_semaphore init_lock;
 	/*
@@ -138,6 +158,10 @@ struct zram {
 	 */
 	bool claim; /* Protected by bdev->bd_mutex */
 	bool use_dedup;
+#ifdef CONFIG_ZRAM_ASYNC_WRITE
+	bool use_async_write;
+	struct zram_async_queue __percpu *async_queue;
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 	struct file *backing_dev;
 	struct block_device *bdev;
@@ -145,6 +169,9 @@ struct zram {
 	unsigned long *bitmap;
 	unsigned long nr_pages;
 	spinlock_t bitmap_lock;
+	unsigned int wb_watermark;	/* percent of disksize, 0 is off */
+	unsigned long wb_next;		/* jiffies of the next auto writeback */
+	struct work_struct wb_work;
 #endif
 };
 
@@ -49,6 +49,9 @@
 /* set this module parameter to enable debug info */
 int bt_dbg_param = 0;
 
+/* set this module parameter to hand several rx packets to each read() */
+static bool rx_batch;
+
 /* Debugging for BT protocol driver */
 #if BTDRV_DEBUG
 #define BT_DRV_DBG(flag, fmt, arg...) \
@@ -290,6 +293,47 @@ static int brcm_bt_drv_close(struct inode *i, struct file *f)
 }
 
 
+/*****************************************************************************
+**
+** Function - brcm_bt_drv_read_more
+**
+** Description - Appends further queued packets to a read, as long as they fit
+**               whole in the user buffer. Every packet starts with its H4
+**               packet type, so user-space parses the result as it would a
+**               byte stream from the UART.
+**
+** Returns - Number of bytes appended.
+*****************************************************************************/
+static size_t brcm_bt_drv_read_more(struct brcm_bt_dev *bt_dev_p,
+  char __user *buf, size_t len)
+{
+    struct sk_buff *skb;
+    size_t copied = 0;
+    unsigned long flags;
+
+    for (;;) {
+        spin_lock_irqsave(&bt_dev_p->rx_q_lock, flags);
+        skb = skb_peek(&bt_dev_p->rx_q);
+        spin_unlock_irqrestore(&bt_dev_p->rx_q_lock, flags);
+
+        if (!skb || skb->len > len - copied)
+            break;
+
+        if (copy_to_user(buf + copied, skb->data, skb->len))
+            break;
+        copied += skb->len;
+
+        spin_lock_irqsave(&bt_dev_p->rx_q_lock, flags);
+        skb = skb_dequeue(&bt_dev_p->rx_q);
+        spin_unlock_irqrestore(&bt_dev_p->rx_q_lock, flags);
+        kfree_skb(skb);
+    }
+
+    BT_DRV_DBG(V4L2_DBG_RX, "copied=%zu", copied);
+    return copied;
+}
+
+
 /*****************************************************************************
 **
 ** Function - brcm_bt_drv_read
@@ -334,6 +378,10 @@ static ssize_t brcm_bt_drv_read(struct file *f, char __user *buf, size_t
             skb = skb_dequeue(&bt_dev_p->rx_q);
             spin_unlock_irqrestore(&bt_dev_p->rx_q_lock, flags);
             kfree_skb(skb);
+            if (rx_batch)
+                skb_size += brcm_bt_drv_read_more(bt_dev_p, buf + skb_size,
+                                                  len > skb_size ?
+                                                  len - skb_size : 0);
             return skb_size;
          }
     }
@@ -536,6 +584,7 @@ static long brcm_bt_st_receive(void *priv_data, struct sk_buff *skb)
 {
     int err = 0;
     unsigned long flags;
+    bool was_empty;
 
     struct brcm_bt_dev *brcm_bt_dev_p= (struct brcm_bt_dev *)priv_data;
 
@@ -559,10 +608,15 @@ static long brcm_bt_st_receive(void *priv_data, struct sk_buff *skb)
     }
 
     spin_lock_irqsave(&brcm_bt_dev_p->rx_q_lock, flags);
+    was_empty = skb_queue_empty(&brcm_bt_dev_p->rx_q);
     skb_queue_tail(&brcm_bt_dev_p->rx_q, skb);
     spin_unlock_irqrestore(&brcm_bt_dev_p->rx_q_lock, flags);
 
-    wake_up_interruptible(&brcm_bt_dev_p->inq);
+    /* A reader only sleeps on an empty queue. With rx_batch it also
+     * drains everything queued behind the packet it was woken for, so
+     * the wakeup is only needed when the queue was empty. */
+    if (!rx_batch || was_empty)
+        wake_up_interruptible(&brcm_bt_dev_p->inq);
 
     BT_DRV_DBG(V4L2_DBG_RX, "rx_q len = %d",skb_queue_len(&brcm_bt_dev_p->rx_q));
 
@@ -672,6 +726,11 @@ MODULE_PARM_DESC(ldisc_dbg_param, \
                "Set to integer value from 1 to 31 for enabling/disabling" \
                " specific categories of logs");
 
+module_param(rx_batch, bool, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(rx_batch, \
+               "Return all queued packets that fit in the buffer of each" \
+               " read, and wake the reader only when the queue was empty");
+
 
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("Broadcom");
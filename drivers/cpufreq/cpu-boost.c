@@ -42,6 +42,13 @@ module_param(input_boost_ms, uint, 0644);
 static unsigned int sched_boost_on_input;
 module_param(sched_boost_on_input, uint, 0644);
 
+/*
+ * Skip the input boost while userspace provides frame deadlines to the
+ * scheduler, which then ramps the frequency for the frame itself.
+ */
+static bool skip_boost_on_frame_hint = true;
+module_param(skip_boost_on_frame_hint, bool, 0644);
+
 static bool sched_boost_active;
 
 static struct delayed_work input_boost_rem;
@@ -229,6 +236,9 @@ static void cpuboost_input_event(struct input_handle *handle,
 	if (!input_boost_enabled)
 		return;
 
+	if (skip_boost_on_frame_hint && sched_frame_hint_active())
+		return;
+
 	now = ktime_to_us(ktime_get());
 	if (now - last_input_time < MIN_INPUT_INTERVAL)
 		return;
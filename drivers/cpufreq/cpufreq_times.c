@@ -20,15 +20,26 @@
 #include <linux/jiffies.h>
 #include <linux/proc_fs.h>
 #include <linux/sched.h>
+#include <linux/sched/topology.h>
 #include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/threads.h>
 
+#ifdef CONFIG_GENERIC_ARCH_TOPOLOGY
+#include <linux/sched/energy.h>
+#endif
+
 #define UID_HASH_BITS 10
 
 static DECLARE_HASHTABLE(uid_hash_table, UID_HASH_BITS);
 
+/*
+ * task->time_in_state is only written from accounting of the task itself,
+ * so the lock is needed just when the array is reallocated or read by
+ * someone else. uid_lock serializes changes to uid_hash_table, the times
+ * of a registered uid are updated atomically under RCU.
+ */
 static DEFINE_SPINLOCK(task_time_in_state_lock); /* task->time_in_state */
 static DEFINE_SPINLOCK(uid_lock); /* uid_hash_table */
 
@@ -43,7 +54,7 @@ struct uid_entry {
 	struct hlist_node hash;
 	struct rcu_head rcu;
 	struct concurrent_times *concurrent_times;
-	u64 time_in_state[0];
+	atomic64_t time_in_state[0];
 };
 
 /**
@@ -51,15 +62,29 @@ struct uid_entry {
  * @offset: start of these freqs' stats in task time_in_state array
  * @max_state: number of entries in freq_table
  * @last_index: index in freq_table of last frequency switched to
+ * @related_cpus: cpus of the policy these freqs belong to
+ * @power: energy model cost of each frequency, NULL without a model
  * @freq_table: list of available frequencies
  */
 struct cpu_freqs {
 	unsigned int offset;
 	unsigned int max_state;
 	unsigned int last_index;
+	cpumask_t related_cpus;
+	struct freq_power *power;
 	unsigned int freq_table[0];
 };
 
+/**
+ * struct freq_power - busy power at one frequency
+ * @core: power of a single busy cpu
+ * @cluster: power of the cluster, shared by its busy cpus
+ */
+struct freq_power {
+	unsigned long core;
+	unsigned long cluster;
+};
+
 static struct cpu_freqs *all_freqs[NR_CPUS];
 
 static unsigned int next_offset;
@@ -155,7 +180,8 @@ static int single_uid_time_in_state_show(struct seq_file *m, void *ptr)
 	}
 
 	for (i = 0; i < uid_entry->max_state; ++i) {
-		u64 time = nsec_to_clock_t(uid_entry->time_in_state[i]);
+		u64 time = nsec_to_clock_t(
+			atomic64_read(&uid_entry->time_in_state[i]));
 		seq_write(m, &time, sizeof(time));
 	}
 
@@ -215,7 +241,8 @@ static int uid_time_in_state_seq_show(struct seq_file *m, void *v)
 			seq_putc(m, ':');
 		}
 		for (i = 0; i < uid_entry->max_state; ++i) {
-			u64 time = nsec_to_clock_t(uid_entry->time_in_state[i]);
+			u64 time = nsec_to_clock_t(
+				atomic64_read(&uid_entry->time_in_state[i]));
 			seq_put_decimal_ull(m, " ", time);
 		}
 		if (uid_entry->max_state)
@@ -314,6 +341,7 @@ void cpufreq_task_times_init(struct task_struct *p)
 	p->time_in_state = NULL;
 	spin_unlock_irqrestore(&task_time_in_state_lock, flags);
 	p->max_state = 0;
+	p->cpu_energy = 0;
 }
 
 void cpufreq_task_times_alloc(struct task_struct *p)
@@ -394,42 +422,81 @@ int proc_time_in_state_show(struct seq_file *m, struct pid_namespace *ns,
 	return 0;
 }
 
+/**
+ * cpufreq_task_cpu_energy() - energy estimate of a task, for taskstats
+ * @p: the task
+ *
+ * The estimate is the energy model busy power of the frequency @p ran at,
+ * times its cputime, with the cluster cost split evenly between the busy
+ * cpus of the cluster. Idle state costs are not attributed to tasks.
+ */
+u64 cpufreq_task_cpu_energy(struct task_struct *p)
+{
+	return READ_ONCE(p->cpu_energy);
+}
+
 void cpufreq_acct_update_power(struct task_struct *p, u64 cputime)
 {
 	unsigned long flags;
-	unsigned int state;
+	unsigned int state, index;
 	unsigned int active_cpu_cnt = 0;
 	unsigned int policy_cpu_cnt = 0;
 	unsigned int policy_first_cpu;
 	struct uid_entry *uid_entry;
+	struct freq_power *power;
 	struct cpu_freqs *freqs = all_freqs[task_cpu(p)];
-	struct cpufreq_policy *policy;
 	uid_t uid = from_kuid_munged(current_user_ns(), task_uid(p));
 	int cpu = 0;
 
 	if (!freqs || is_idle_task(p) || p->flags & PF_EXITING)
 		return;
 
-	state = freqs->offset + READ_ONCE(freqs->last_index);
+	index = READ_ONCE(freqs->last_index);
+	state = freqs->offset + index;
 
-	spin_lock_irqsave(&task_time_in_state_lock, flags);
-	if ((state < p->max_state || !cpufreq_task_times_realloc_locked(p)) &&
-	    p->time_in_state)
+	/* only a new policy makes the array grow, don't lock until then */
+	if (state < p->max_state && p->time_in_state) {
 		p->time_in_state[state] += cputime;
-	spin_unlock_irqrestore(&task_time_in_state_lock, flags);
+	} else {
+		spin_lock_irqsave(&task_time_in_state_lock, flags);
+		if ((state < p->max_state ||
+		     !cpufreq_task_times_realloc_locked(p)) &&
+		    p->time_in_state)
+			p->time_in_state[state] += cputime;
+		spin_unlock_irqrestore(&task_time_in_state_lock, flags);
+	}
 
-	spin_lock_irqsave(&uid_lock, flags);
-	uid_entry = find_or_register_uid_locked(uid);
-	if (uid_entry && state < uid_entry->max_state)
-		uid_entry->time_in_state[state] += cputime;
-	spin_unlock_irqrestore(&uid_lock, flags);
+	/*
+	 * The policy cpus are cached in freqs, so that the tick does not have
+	 * to take cpufreq_driver_lock through cpufreq_cpu_get().
+	 */
+	for_each_cpu(cpu, &freqs->related_cpus)
+		if (!idle_cpu(cpu))
+			++policy_cpu_cnt;
+
+	/* the cluster cost is split between the cpus keeping it busy */
+	power = READ_ONCE(freqs->power);
+	if (power) {
+		u64 usecs = div_u64(cputime, NSEC_PER_USEC);
+
+		p->cpu_energy += usecs * power[index].core +
+			div_u64(usecs * power[index].cluster,
+				max(policy_cpu_cnt, 1U));
+	}
 
 	rcu_read_lock();
 	uid_entry = find_uid_entry_rcu(uid);
+	if (!uid_entry || state >= uid_entry->max_state) {
+		spin_lock_irqsave(&uid_lock, flags);
+		uid_entry = find_or_register_uid_locked(uid);
+		spin_unlock_irqrestore(&uid_lock, flags);
+	}
 	if (!uid_entry) {
 		rcu_read_unlock();
 		return;
 	}
+	if (state < uid_entry->max_state)
+		atomic64_add(cputime, &uid_entry->time_in_state[state]);
 
 	for_each_possible_cpu(cpu)
 		if (!idle_cpu(cpu))
@@ -438,22 +505,7 @@ void cpufreq_acct_update_power(struct task_struct *p, u64 cputime)
 	atomic64_add(cputime,
 		     &uid_entry->concurrent_times->active[active_cpu_cnt - 1]);
 
-	policy = cpufreq_cpu_get(task_cpu(p));
-	if (!policy) {
-		/*
-		 * This CPU may have just come up and not have a cpufreq policy
-		 * yet.
-		 */
-		rcu_read_unlock();
-		return;
-	}
-
-	for_each_cpu(cpu, policy->related_cpus)
-		if (!idle_cpu(cpu))
-			++policy_cpu_cnt;
-
-	policy_first_cpu = cpumask_first(policy->related_cpus);
-	cpufreq_cpu_put(policy);
+	policy_first_cpu = cpumask_first(&freqs->related_cpus);
 
 	atomic64_add(cputime,
 		     &uid_entry->concurrent_times->policy[policy_first_cpu +
@@ -471,6 +523,68 @@ static int cpufreq_times_get_index(struct cpu_freqs *freqs, unsigned int freq)
 	return -1;
 }
 
+#ifdef CONFIG_GENERIC_ARCH_TOPOLOGY
+/* busy power of the lowest model state at or above @freq */
+static unsigned long sge_busy_power(struct sched_group_energy *sge,
+				    unsigned int freq)
+{
+	int i;
+
+	for (i = 0; i < sge->nr_cap_states - 1; i++)
+		if (sge->cap_states[i].frequency >= freq)
+			break;
+
+	return sge->cap_states[i].power;
+}
+
+static void cpufreq_times_init_power(struct cpu_freqs *freqs, int cpu)
+{
+	struct sched_group_energy *core = sge_array[cpu][SD_LEVEL0];
+	struct sched_group_energy *cluster = sge_array[cpu][SD_LEVEL1];
+	struct freq_power *power;
+	int i;
+
+	if (freqs->power || !core || !core->nr_cap_states)
+		return;
+	if (cluster && !cluster->nr_cap_states)
+		cluster = NULL;
+
+	power = kcalloc(freqs->max_state, sizeof(*power), GFP_KERNEL);
+	if (!power)
+		return;
+
+	for (i = 0; i < freqs->max_state; i++) {
+		power[i].core = sge_busy_power(core, freqs->freq_table[i]);
+		if (cluster)
+			power[i].cluster =
+				sge_busy_power(cluster, freqs->freq_table[i]);
+	}
+	smp_store_release(&freqs->power, power);
+}
+
+/**
+ * cpufreq_times_energy_model_ready() - fill in the costs of existing policies
+ *
+ * The energy model is parsed once every cpu has a policy, which can be long
+ * after boot when the cpufreq driver is a module. Policies created before
+ * that get their costs here, later ones in cpufreq_times_create_policy().
+ */
+void cpufreq_times_energy_model_ready(void)
+{
+	struct cpu_freqs *freqs;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		freqs = all_freqs[cpu];
+		if (freqs && cpu == cpumask_first(&freqs->related_cpus))
+			cpufreq_times_init_power(freqs, cpu);
+	}
+}
+#else
+void cpufreq_times_energy_model_ready(void) {}
+static void cpufreq_times_init_power(struct cpu_freqs *freqs, int cpu) {}
+#endif
+
 void cpufreq_times_create_policy(struct cpufreq_policy *policy)
 {
 	int cpu, index = 0;
@@ -503,6 +617,8 @@ void cpufreq_times_create_policy(struct cpufreq_policy *policy)
 	index = cpufreq_times_get_index(freqs, policy->cur);
 	if (index >= 0)
 		WRITE_ONCE(freqs->last_index, index);
+	cpumask_copy(&freqs->related_cpus, policy->related_cpus);
+	cpufreq_times_init_power(freqs, policy->cpu);
 
 	freqs->offset = next_offset;
 	WRITE_ONCE(next_offset, freqs->offset + count);
@@ -37,6 +37,7 @@
 #include <linux/cpuhotplug.h>
 #include <linux/sched/clock.h>
 #include <linux/sched/stat.h>
+#include <linux/kernel_stat.h>
 #include <soc/qcom/pm.h>
 #include <soc/qcom/event_timer.h>
 #include <soc/qcom/lpm_levels.h>
@@ -107,6 +108,62 @@ struct lpm_history {
 
 static DEFINE_PER_CPU(struct lpm_history, hist);
 
+/*
+ * Residency histogram predictor. Every idle exit is filed by wakeup source
+ * in a log2 histogram of residencies in usec. Wakeups by timer are known in
+ * advance, so they only tell that no interrupt arrived before them; the
+ * predictor uses them as lower bounds. The predicted residency is the
+ * longest one that is reached with lpm_hist_confidence percent probability.
+ */
+#define LPM_HIST_BUCKETS	16
+#define LPM_HIST_MIN_SAMPLES	16
+#define LPM_HIST_DECAY		256
+#define LPM_TIMER_SLACK_US	50
+
+enum lpm_wakeup_src {
+	LPM_WAKEUP_TIMER,
+	LPM_WAKEUP_IPI,
+	LPM_WAKEUP_IRQ,
+	LPM_WAKEUP_NR,
+};
+
+struct lpm_res_hist {
+	uint16_t count[LPM_WAKEUP_NR][LPM_HIST_BUCKETS];
+	uint32_t nsamp;
+	uint32_t next_wakeup_us;
+	uint64_t too_deep;
+	uint64_t too_shallow;
+};
+
+static DEFINE_PER_CPU(struct lpm_res_hist, res_hist);
+
+static bool lpm_hist_predict;
+module_param_named(lpm_hist_predict, lpm_hist_predict, bool, 0664);
+
+static uint32_t lpm_hist_confidence = 75;
+module_param_named(lpm_hist_confidence, lpm_hist_confidence, uint, 0664);
+
+static int lpm_mispredictions_get(char *buf, const struct kernel_param *kp)
+{
+	struct lpm_res_hist *h;
+	int cpu, cnt = 0;
+
+	for_each_possible_cpu(cpu) {
+		h = &per_cpu(res_hist, cpu);
+		cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt,
+				"cpu%d too_deep=%llu too_shallow=%llu\n", cpu,
+				h->too_deep, h->too_shallow);
+	}
+
+	return cnt;
+}
+
+static const struct kernel_param_ops param_ops_lpm_mispredictions = {
+	.get = lpm_mispredictions_get,
+};
+module_param_cb(lpm_mispredictions, &param_ops_lpm_mispredictions, NULL,
+		0444);
+
 static DEFINE_PER_CPU(struct lpm_cpu*, cpu_lpm);
 static bool suspend_in_progress;
 static struct hrtimer lpm_hrtimer;
@@ -587,6 +644,86 @@ static uint64_t lpm_cpuidle_predict(struct cpuidle_device *dev,
 	return 0;
 }
 
+static inline int lpm_hist_bucket(uint32_t resi)
+{
+	return min_t(int, fls(resi), LPM_HIST_BUCKETS - 1);
+}
+
+static uint32_t lpm_hist_predict_resi(struct cpuidle_device *dev,
+		struct lpm_cpu *cpu, uint32_t next_wakeup_us)
+{
+	struct lpm_res_hist *h = &per_cpu(res_hist, dev->cpu);
+	uint32_t ge = 0, timer_ge = 0, timer_total = 0;
+	uint32_t denom;
+	int b, src;
+
+	if (!lpm_prediction || !cpu->lpm_prediction)
+		return 0;
+
+	if (h->nsamp < LPM_HIST_MIN_SAMPLES)
+		return 0;
+
+	for (b = 0; b < LPM_HIST_BUCKETS; b++)
+		timer_total += h->count[LPM_WAKEUP_TIMER][b];
+
+	for (b = LPM_HIST_BUCKETS - 1; b > 0; b--) {
+		for (src = 0; src < LPM_WAKEUP_NR; src++)
+			ge += h->count[src][b];
+		timer_ge += h->count[LPM_WAKEUP_TIMER][b];
+
+		/* Timer wakeups shorter than this bucket say nothing about it */
+		denom = h->nsamp - (timer_total - timer_ge);
+		if (denom && ge * 100 >= lpm_hist_confidence * denom)
+			return min_t(uint32_t, 1 << (b - 1), next_wakeup_us);
+	}
+
+	return 1;
+}
+
+static void lpm_hist_record(struct lpm_res_hist *h, int src, uint32_t resi)
+{
+	int b, s;
+
+	if (h->nsamp >= LPM_HIST_DECAY) {
+		h->nsamp = 0;
+		for (s = 0; s < LPM_WAKEUP_NR; s++) {
+			for (b = 0; b < LPM_HIST_BUCKETS; b++) {
+				h->count[s][b] >>= 1;
+				h->nsamp += h->count[s][b];
+			}
+		}
+	}
+
+	h->count[src][lpm_hist_bucket(resi)]++;
+	h->nsamp++;
+}
+
+/*
+ * Account a mode choice against the residency actually seen: too deep if
+ * the CPU woke up before the break-even of the mode, too shallow if the
+ * next mode was allowed and its break-even was met.
+ */
+static void lpm_hist_check(struct cpuidle_device *dev, struct lpm_cpu *cpu,
+		struct lpm_res_hist *h, int idx, uint32_t resi)
+{
+	struct power_params *next;
+
+	if (idx && resi < cpu->levels[idx].pwr.min_residency) {
+		h->too_deep++;
+		return;
+	}
+
+	if (idx + 1 >= cpu->nlevels)
+		return;
+
+	next = &cpu->levels[idx + 1].pwr;
+	if (resi >= next->min_residency &&
+	    pm_qos_request_for_cpu(PM_QOS_CPU_DMA_LATENCY, dev->cpu) >=
+							next->exit_latency &&
+	    lpm_cpu_mode_allow(dev->cpu, idx + 1, true))
+		h->too_shallow++;
+}
+
 static inline void invalidate_predict_history(struct cpuidle_device *dev)
 {
 	struct lpm_history *history = &per_cpu(hist, dev->cpu);
@@ -707,8 +844,13 @@ static int cpu_power_select(struct cpuidle_device *dev,
 			 * call prediction.
 			 */
 			if (next_wakeup_us > max_residency) {
-				predicted = lpm_cpuidle_predict(dev, cpu,
-					&idx_restrict, &idx_restrict_time);
+				if (lpm_hist_predict)
+					predicted = lpm_hist_predict_resi(dev,
+						cpu, next_wakeup_us);
+				else
+					predicted = lpm_cpuidle_predict(dev,
+						cpu, &idx_restrict,
+						&idx_restrict_time);
 				if (predicted && (predicted < min_residency))
 					predicted = min_residency;
 			} else
@@ -756,6 +898,8 @@ static int cpu_power_select(struct cpuidle_device *dev,
 	}
 
 done_select:
+	per_cpu(res_hist, dev->cpu).next_wakeup_us = next_wakeup_us;
+
 	trace_cpu_power_select(best_level, sleep_us, latency_us, next_event_us);
 
 	trace_cpu_pred_select(idx_restrict_time ? 2 : (predicted ? 1 : 0),
@@ -1465,6 +1609,10 @@ static int lpm_cpuidle_enter(struct cpuidle_device *dev,
 		struct cpuidle_driver *drv, int idx)
 {
 	struct lpm_cpu *cpu = per_cpu(cpu_lpm, dev->cpu);
+	struct lpm_res_hist *h = &per_cpu(res_hist, dev->cpu);
+	unsigned long irqs = 0;
+	u64 ipis = 0;
+	int src;
 	bool success = false;
 	const struct cpumask *cpumask = get_cpu_mask(dev->cpu);
 	ktime_t start = ktime_get();
@@ -1498,7 +1646,35 @@ static int lpm_cpuidle_enter(struct cpuidle_device *dev,
 		biastimer_cancel();
 		cpu->bias = 0;
 	}
+
+	if (lpm_prediction && cpu->lpm_prediction) {
+		lpm_hist_check(dev, cpu, h, idx, dev->last_residency);
+		irqs = kstat_cpu_irqs_sum(dev->cpu);
+#ifdef arch_irq_stat_cpu
+		ipis = arch_irq_stat_cpu(dev->cpu);
+#endif
+	}
+
+	/* The wakeup interrupt, if any, is handled right here */
 	local_irq_enable();
+
+	if (lpm_prediction && cpu->lpm_prediction) {
+		struct lpm_history *history = &per_cpu(hist, dev->cpu);
+
+		if (history->hinvalid || dev->last_residency +
+				LPM_TIMER_SLACK_US >= h->next_wakeup_us)
+			src = LPM_WAKEUP_TIMER;
+#ifdef arch_irq_stat_cpu
+		else if (arch_irq_stat_cpu(dev->cpu) != ipis &&
+			 kstat_cpu_irqs_sum(dev->cpu) == irqs)
+			src = LPM_WAKEUP_IPI;
+#endif
+		else
+			src = LPM_WAKEUP_IRQ;
+
+		lpm_hist_record(h, src, dev->last_residency);
+	}
+
 	return idx;
 }
 
@@ -29,6 +29,8 @@
 #include <linux/platform_device.h>
 #include <linux/of.h>
 #include <linux/devfreq.h>
+#include <linux/cpufreq.h>
+#include <linux/workqueue.h>
 #include <trace/events/power.h>
 #include "governor.h"
 #include "governor_bw_hwmon.h"
@@ -49,6 +51,9 @@ struct hwmon_node {
 	unsigned int hyst_length;
 	unsigned int idle_mbps;
 	unsigned int use_ab;
+	unsigned int cpufreq_boost_khz;
+	unsigned int cpufreq_boost_mbps;
+	unsigned int cpufreq_boost_ms;
 	unsigned int mbps_zones[NUM_MBPS_ZONES];
 
 	unsigned long prev_ab;
@@ -68,6 +73,8 @@ struct hwmon_node {
 	unsigned int down_cnt;
 	ktime_t prev_ts;
 	ktime_t hist_max_ts;
+	ktime_t boost_until;
+	struct work_struct boost_work;
 	bool sampled;
 	bool mon_started;
 	struct list_head list;
@@ -87,6 +94,7 @@ static DEFINE_MUTEX(list_lock);
 
 static int use_cnt;
 static DEFINE_MUTEX(state_lock);
+static bool cpufreq_nb_registered;
 
 #define show_attr(name) \
 static ssize_t show_##name(struct device *dev,				\
@@ -422,6 +430,15 @@ static unsigned long get_bw_and_set_irq(struct hwmon_node *node,
 			req_mbps = max(req_mbps, node->hyst_mbps);
 	}
 
+	/*
+	 * A CPU just ramped past cpufreq_boost_khz. Hold the floor until the
+	 * measurements have had a chance to catch up with the new load.
+	 */
+	if (node->cpufreq_boost_mbps &&
+	    ktime_before(ktime_get(), node->boost_until))
+		req_mbps = max_t(unsigned long, req_mbps,
+				 node->cpufreq_boost_mbps);
+
 	/* Stretch the short sample window size, if the traffic is too low */
 	if (meas_mbps < MIN_MBPS) {
 		hw->up_wake_mbps = (max(MIN_MBPS, req_mbps)
@@ -539,6 +556,53 @@ int update_bw_hwmon(struct bw_hwmon *hwmon)
 	return 0;
 }
 
+static void bw_hwmon_boost_work(struct work_struct *work)
+{
+	struct hwmon_node *node = container_of(work, struct hwmon_node,
+						boost_work);
+
+	update_bw_hwmon(node->hw);
+}
+
+/*
+ * DDR traffic follows a CPU frequency ramp only after the next sample
+ * window has closed. Re-evaluate every monitor as soon as a CPU crosses
+ * the configured frequency so the vote goes up with the CPU rather than
+ * up to sample_ms later.
+ */
+static int bw_hwmon_cpufreq_trans(struct notifier_block *nb,
+				  unsigned long val, void *data)
+{
+	struct cpufreq_freqs *freq = data;
+	struct hwmon_node *node;
+	ktime_t now;
+
+	if (val != CPUFREQ_POSTCHANGE || freq->new <= freq->old)
+		return NOTIFY_DONE;
+
+	now = ktime_get();
+	mutex_lock(&list_lock);
+	list_for_each_entry(node, &hwmon_list, list) {
+		if (!node->cpufreq_boost_mbps || !node->mon_started)
+			continue;
+		if (freq->new < node->cpufreq_boost_khz ||
+		    freq->old >= node->cpufreq_boost_khz)
+			continue;
+		if (ktime_before(now, node->boost_until))
+			continue;
+
+		node->boost_until = ktime_add_ms(now, node->cpufreq_boost_ms);
+		schedule_work(&node->boost_work);
+	}
+	mutex_unlock(&list_lock);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block bw_hwmon_cpufreq_nb = {
+	.notifier_call = bw_hwmon_cpufreq_trans,
+};
+
 static int start_monitor(struct devfreq *df, bool init)
 {
 	struct hwmon_node *node = df->data;
@@ -585,6 +649,7 @@ static void stop_monitor(struct devfreq *df, bool init)
 	mutex_lock(&node->mon_lock);
 	node->mon_started = false;
 	mutex_unlock(&node->mon_lock);
+	cancel_work_sync(&node->boost_work);
 
 	if (init) {
 		devfreq_monitor_stop(df);
@@ -814,6 +879,9 @@ gov_attr(hyst_trigger_count, 0U, 90U);
 gov_attr(hyst_length, 0U, 90U);
 gov_attr(idle_mbps, 0U, 2000U);
 gov_attr(use_ab, 0U, 1U);
+gov_attr(cpufreq_boost_khz, 0U, UINT_MAX);
+gov_attr(cpufreq_boost_mbps, 0U, 20000U);
+gov_attr(cpufreq_boost_ms, 0U, 500U);
 gov_list_attr(mbps_zones, NUM_MBPS_ZONES, 0U, UINT_MAX);
 
 static struct attribute *dev_attr[] = {
@@ -831,6 +899,9 @@ static struct attribute *dev_attr[] = {
 	&dev_attr_hyst_length.attr,
 	&dev_attr_idle_mbps.attr,
 	&dev_attr_use_ab.attr,
+	&dev_attr_cpufreq_boost_khz.attr,
+	&dev_attr_cpufreq_boost_mbps.attr,
+	&dev_attr_cpufreq_boost_ms.attr,
 	&dev_attr_mbps_zones.attr,
 	&dev_attr_throttle_adj.attr,
 	NULL,
@@ -980,10 +1051,14 @@ int register_bw_hwmon(struct device *dev, struct bw_hwmon *hwmon)
 	node->hyst_length = 0;
 	node->idle_mbps = 400;
 	node->use_ab = 1;
+	node->cpufreq_boost_khz = 0;
+	node->cpufreq_boost_mbps = 0;
+	node->cpufreq_boost_ms = 50;
 	node->mbps_zones[0] = 0;
 	node->hw = hwmon;
 
 	mutex_init(&node->mon_lock);
+	INIT_WORK(&node->boost_work, bw_hwmon_boost_work);
 	mutex_lock(&list_lock);
 	list_add_tail(&node->list, &hwmon_list);
 	mutex_unlock(&list_lock);
@@ -999,6 +1074,13 @@ int register_bw_hwmon(struct device *dev, struct bw_hwmon *hwmon)
 		mutex_unlock(&state_lock);
 	}
 
+	mutex_lock(&state_lock);
+	if (!ret && !cpufreq_nb_registered &&
+	    !cpufreq_register_notifier(&bw_hwmon_cpufreq_nb,
+					CPUFREQ_TRANSITION_NOTIFIER))
+		cpufreq_nb_registered = true;
+	mutex_unlock(&state_lock);
+
 	if (!ret)
 		dev_info(dev, "BW HWmon governor registered.\n");
 	else
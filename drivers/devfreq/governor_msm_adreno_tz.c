@@ -331,6 +331,22 @@ static inline int devfreq_get_freq_level(struct devfreq *devfreq,
 	return -EINVAL;
 }
 
+/*
+ * Pick the lowest frequency that is still fast enough for the frame deadline.
+ * The frequency table is sorted from the fastest to the slowest level.
+ */
+static unsigned long tz_deadline_freq(struct devfreq *devfreq,
+		unsigned long target)
+{
+	int lev;
+
+	for (lev = devfreq->profile->max_state - 1; lev > 0; lev--)
+		if (devfreq->profile->freq_table[lev] >= target)
+			break;
+
+	return devfreq->profile->freq_table[lev];
+}
+
 static int tz_get_target_freq(struct devfreq *devfreq, unsigned long *freq)
 {
 	int result = 0;
@@ -356,6 +372,17 @@ static int tz_get_target_freq(struct devfreq *devfreq, unsigned long *freq)
 
 	/* Update the GPU load statistics */
 	compute_work_load(&stats, priv, devfreq);
+
+	/*
+	 * While userspace is sending frame deadlines they replace the busy
+	 * time heuristics: the bus governor follows whatever level we pick.
+	 */
+	if (priv->deadline_freq) {
+		*freq = tz_deadline_freq(devfreq, priv->deadline_freq);
+		priv->bin.total_time = 0;
+		priv->bin.busy_time = 0;
+		return 0;
+	}
 	/*
 	 * Do not waste CPU cycles running this algorithm if
 	 * the GPU just started, or if less than FLOOR time
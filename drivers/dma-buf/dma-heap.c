@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Framework for userspace DMA-BUF allocations
+ *
+ * Every heap gets its own character device under /dev/dma_heap/, and an
+ * allocation is a single ioctl on it returning a dma-buf fd. There is no
+ * heap list to walk and no lock shared between heaps on the allocation
+ * path: the chardev leads straight to the heap.
+ */
+
+#include <linux/cdev.h>
+#include <linux/device.h>
+#include <linux/dma-buf.h>
+#include <linux/err.h>
+#include <linux/idr.h>
+#include <linux/list.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/dma-heap.h>
+#include <uapi/linux/dma-heap.h>
+
+#define DEVNAME "dma_heap"
+
+#define NUM_HEAP_MINORS 128
+
+/**
+ * struct dma_heap - represents a dmabuf heap in the system
+ * @name:		used for debugging/device-node name
+ * @ops:		ops struct for this heap
+ * @priv:		private data for this heap
+ * @heap_devt:		heap device node
+ * @list:		list head connecting to list of heaps
+ * @heap_cdev:		heap char device
+ *
+ * Represents a heap of memory from which buffers can be made.
+ */
+struct dma_heap {
+	const char *name;
+	const struct dma_heap_ops *ops;
+	void *priv;
+	dev_t heap_devt;
+	struct list_head list;
+	struct cdev heap_cdev;
+};
+
+static LIST_HEAD(heap_list);
+static DEFINE_MUTEX(heap_list_lock);
+static dev_t dma_heap_devt;
+static struct class *dma_heap_class;
+static DEFINE_IDA(dma_heap_minors);
+
+static int dma_heap_buffer_alloc(struct dma_heap *heap, u64 len,
+				 unsigned int fd_flags,
+				 unsigned long heap_flags)
+{
+	struct dma_buf *dmabuf;
+	int fd;
+
+	/*
+	 * Allocations from all heaps have to begin
+	 * and end on page boundaries.
+	 */
+	if (!len || len > SIZE_MAX - PAGE_SIZE)
+		return -EINVAL;
+	len = PAGE_ALIGN(len);
+
+	dmabuf = heap->ops->allocate(heap, len, fd_flags, heap_flags);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+
+	fd = dma_buf_fd(dmabuf, fd_flags);
+	if (fd < 0)
+		dma_buf_put(dmabuf);
+
+	return fd;
+}
+
+static int dma_heap_open(struct inode *inode, struct file *file)
+{
+	/* heaps are never removed, so the cdev leads to a live heap */
+	file->private_data = container_of(inode->i_cdev, struct dma_heap,
+					  heap_cdev);
+
+	return nonseekable_open(inode, file);
+}
+
+static long dma_heap_ioctl_allocate(struct file *file, void __user *argp)
+{
+	struct dma_heap_allocation_data data;
+	struct dma_heap *heap = file->private_data;
+	int fd;
+
+	if (copy_from_user(&data, argp, sizeof(data)))
+		return -EFAULT;
+
+	if (data.fd)
+		return -EINVAL;
+
+	if (data.fd_flags & ~DMA_HEAP_VALID_FD_FLAGS)
+		return -EINVAL;
+
+	fd = dma_heap_buffer_alloc(heap, data.len, data.fd_flags,
+				   data.heap_flags);
+	if (fd < 0)
+		return fd;
+
+	data.fd = fd;
+	if (copy_to_user(argp, &data, sizeof(data)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static long dma_heap_ioctl(struct file *file, unsigned int cmd,
+			   unsigned long arg)
+{
+	switch (cmd) {
+	case DMA_HEAP_IOCTL_ALLOC:
+		return dma_heap_ioctl_allocate(file, (void __user *)arg);
+	default:
+		return -ENOTTY;
+	}
+}
+
+static const struct file_operations dma_heap_fops = {
+	.owner          = THIS_MODULE,
+	.open		= dma_heap_open,
+	.unlocked_ioctl = dma_heap_ioctl,
+#ifdef CONFIG_COMPAT
+	.compat_ioctl	= dma_heap_ioctl,
+#endif
+};
+
+void *dma_heap_get_drvdata(struct dma_heap *heap)
+{
+	return heap->priv;
+}
+EXPORT_SYMBOL_GPL(dma_heap_get_drvdata);
+
+const char *dma_heap_get_name(struct dma_heap *heap)
+{
+	return heap->name;
+}
+EXPORT_SYMBOL_GPL(dma_heap_get_name);
+
+struct dma_heap *dma_heap_add(const struct dma_heap_export_info *exp_info)
+{
+	struct dma_heap *heap, *h;
+	struct device *dev_ret;
+	int minor;
+	int ret;
+
+	if (!exp_info->name || !strcmp(exp_info->name, "")) {
+		pr_err("dma_heap: Cannot add heap without a name\n");
+		return ERR_PTR(-EINVAL);
+	}
+
+	if (!exp_info->ops || !exp_info->ops->allocate) {
+		pr_err("dma_heap: Cannot add heap with invalid ops struct\n");
+		return ERR_PTR(-EINVAL);
+	}
+
+	if (!dma_heap_class)
+		return ERR_PTR(-ENODEV);
+
+	heap = kzalloc(sizeof(*heap), GFP_KERNEL);
+	if (!heap)
+		return ERR_PTR(-ENOMEM);
+
+	heap->name = exp_info->name;
+	heap->ops = exp_info->ops;
+	heap->priv = exp_info->priv;
+
+	mutex_lock(&heap_list_lock);
+	list_for_each_entry(h, &heap_list, list) {
+		if (!strcmp(h->name, exp_info->name)) {
+			pr_err("dma_heap: Already registered heap named %s\n",
+			       exp_info->name);
+			ret = -EEXIST;
+			goto err_unlock;
+		}
+	}
+
+	minor = ida_simple_get(&dma_heap_minors, 0, NUM_HEAP_MINORS,
+			       GFP_KERNEL);
+	if (minor < 0) {
+		pr_err("dma_heap: Unable to get minor number for heap\n");
+		ret = minor;
+		goto err_unlock;
+	}
+
+	/* Create device */
+	heap->heap_devt = MKDEV(MAJOR(dma_heap_devt), minor);
+
+	cdev_init(&heap->heap_cdev, &dma_heap_fops);
+	ret = cdev_add(&heap->heap_cdev, heap->heap_devt, 1);
+	if (ret < 0) {
+		pr_err("dma_heap: Unable to add char device\n");
+		goto err_minor;
+	}
+
+	dev_ret = device_create(dma_heap_class, NULL, heap->heap_devt, NULL,
+				heap->name);
+	if (IS_ERR(dev_ret)) {
+		pr_err("dma_heap: Unable to create device\n");
+		ret = PTR_ERR(dev_ret);
+		goto err_cdev;
+	}
+
+	list_add(&heap->list, &heap_list);
+	mutex_unlock(&heap_list_lock);
+
+	return heap;
+
+err_cdev:
+	cdev_del(&heap->heap_cdev);
+err_minor:
+	ida_simple_remove(&dma_heap_minors, minor);
+err_unlock:
+	mutex_unlock(&heap_list_lock);
+	kfree(heap);
+	return ERR_PTR(ret);
+}
+EXPORT_SYMBOL_GPL(dma_heap_add);
+
+static char *dma_heap_devnode(struct device *dev, umode_t *mode)
+{
+	return kasprintf(GFP_KERNEL, "dma_heap/%s", dev_name(dev));
+}
+
+static int __init dma_heap_init(void)
+{
+	struct class *class;
+	int ret;
+
+	ret = alloc_chrdev_region(&dma_heap_devt, 0, NUM_HEAP_MINORS, DEVNAME);
+	if (ret)
+		return ret;
+
+	class = class_create(THIS_MODULE, DEVNAME);
+	if (IS_ERR(class)) {
+		unregister_chrdev_region(dma_heap_devt, NUM_HEAP_MINORS);
+		return PTR_ERR(class);
+	}
+	class->devnode = dma_heap_devnode;
+	dma_heap_class = class;
+
+	return 0;
+}
+subsys_initcall(dma_heap_init);
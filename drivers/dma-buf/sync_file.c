@@ -206,6 +206,25 @@ static void add_fence(struct dma_fence **fences,
 	}
 }
 
+/*
+ * Returns a new reference to @sync_file's fence if it holds exactly
+ * @fences, so that merging into a superset doesn't allocate another array.
+ */
+static struct dma_fence *sync_file_same_fences(struct sync_file *sync_file,
+					       struct dma_fence **fences,
+					       int num_fences)
+{
+	struct dma_fence **own;
+	int num_own;
+
+	own = get_fences(sync_file, &num_own);
+	if (num_own != num_fences ||
+	    memcmp(own, fences, num_fences * sizeof(*fences)))
+		return NULL;
+
+	return dma_fence_get(sync_file->fence);
+}
+
 /**
  * sync_file_merge() - merge two sync_files
  * @name:	name of new fence
@@ -221,6 +240,7 @@ static struct sync_file *sync_file_merge(const char *name, struct sync_file *a,
 {
 	struct sync_file *sync_file;
 	struct dma_fence **fences = NULL, **nfences, **a_fences, **b_fences;
+	struct dma_fence *same;
 	int i = 0, i_a, i_b, num_fences, a_num_fences, b_num_fences;
 
 	sync_file = sync_file_alloc();
@@ -277,6 +297,23 @@ static struct sync_file *sync_file_merge(const char *name, struct sync_file *a,
 	if (i == 0)
 		fences[i++] = dma_fence_get(a_fences[0]);
 
+	/*
+	 * Compositors keep merging fences that one side already has; hand
+	 * out that side's fence instead of building an identical array.
+	 */
+	if (i > 1) {
+		same = sync_file_same_fences(a, fences, i);
+		if (!same)
+			same = sync_file_same_fences(b, fences, i);
+		if (same) {
+			while (i)
+				dma_fence_put(fences[--i]);
+			kfree(fences);
+			sync_file->fence = same;
+			goto out;
+		}
+	}
+
 	if (num_fences > i) {
 		nfences = krealloc(fences, i * sizeof(*fences),
 				  GFP_KERNEL);
@@ -289,6 +326,7 @@ static struct sync_file *sync_file_merge(const char *name, struct sync_file *a,
 	if (sync_file_set_fence(sync_file, fences, i) < 0)
 		goto err;
 
+out:
 	strlcpy(sync_file->user_name, name, sizeof(sync_file->user_name));
 	return sync_file;
 
@@ -1751,8 +1751,8 @@ static int adreno_init(struct kgsl_device *device)
 
 	if (!adreno_is_a3xx(adreno_dev)) {
 		int r = kgsl_allocate_global(device,
-			&adreno_dev->profile_buffer, PAGE_SIZE,
-			0, 0, "alwayson");
+			&adreno_dev->profile_buffer,
+			ADRENO_DRAWOBJ_PROFILE_SIZE, 0, 0, "alwayson");
 
 		adreno_dev->profile_index = 0;
 
@@ -1761,7 +1761,7 @@ static int adreno_init(struct kgsl_device *device)
 				&adreno_dev->priv);
 			kgsl_sharedmem_set(device,
 				&adreno_dev->profile_buffer, 0, 0,
-				PAGE_SIZE);
+				ADRENO_DRAWOBJ_PROFILE_SIZE);
 		}
 
 	}
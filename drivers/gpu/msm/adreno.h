@@ -268,6 +268,9 @@ struct adreno_gpudev;
 /* Time to allow preemption to complete (in ms) */
 #define ADRENO_PREEMPT_TIMEOUT 10000
 
+/* Number of log2 usec buckets in the preemption latency histograms */
+#define ADRENO_PREEMPT_HIST_BUCKETS 16
+
 #define ADRENO_INT_BIT(a, _bit) (((a)->gpucore->gpudev->int_bits) ? \
 		(adreno_get_int(a, _bit) < 0 ? 0 : \
 		BIT(adreno_get_int(a, _bit))) : 0)
@@ -304,6 +307,14 @@ enum adreno_preempt_states {
  * skipsaverestore: To skip saverestore during L1 preemption (for 6XX)
  * usesgmem: enable GMEM save/restore across preemption (for 6XX)
  * count: Track the number of preemptions triggered
+ * @budget_timer: Fires when a deferred ringbuffer uses up its latency budget
+ * (for 5XX)
+ * @trigger_time: Time the current preemption was triggered
+ * @switch_us: Running average of the trigger to completion latency in usecs
+ * @switch_hist: log2 usec histogram of the trigger to completion latency
+ * @wait_hist: Per ringbuffer log2 usec histogram of the time from the first
+ * waiting submission until the ringbuffer went current
+ * @budget_miss: Per ringbuffer count of waits that overran the latency budget
  */
 struct adreno_preemption {
 	atomic_t state;
@@ -315,6 +326,13 @@ struct adreno_preemption {
 	bool skipsaverestore;
 	bool usesgmem;
 	unsigned int count;
+	struct timer_list budget_timer;
+	ktime_t trigger_time;
+	unsigned int switch_us;
+	unsigned int switch_hist[ADRENO_PREEMPT_HIST_BUCKETS];
+	unsigned int wait_hist[KGSL_PRIORITY_MAX_RB_LEVELS]
+		[ADRENO_PREEMPT_HIST_BUCKETS];
+	unsigned int budget_miss[KGSL_PRIORITY_MAX_RB_LEVELS];
 };
 
 
@@ -658,14 +676,21 @@ enum adreno_device_flags {
  * kernel profiling buffer
  * @started: Number of GPU ticks at start of the drawobj
  * @retired: Number of GPU ticks at the end of the drawobj
+ * @counter_started: Low 32 bits of each kgsl_gpu_stat perfcounter at start
+ * @counter_retired: Low 32 bits of each kgsl_gpu_stat perfcounter at the end
  */
 struct adreno_drawobj_profile_entry {
 	uint64_t started;
 	uint64_t retired;
+	uint32_t counter_started[KGSL_GPU_STAT_MAX];
+	uint32_t counter_retired[KGSL_GPU_STAT_MAX];
 };
 
+#define ADRENO_DRAWOBJ_PROFILE_SIZE (2 * PAGE_SIZE)
+
 #define ADRENO_DRAWOBJ_PROFILE_COUNT \
-	(PAGE_SIZE / sizeof(struct adreno_drawobj_profile_entry))
+	(ADRENO_DRAWOBJ_PROFILE_SIZE / \
+	 sizeof(struct adreno_drawobj_profile_entry))
 
 #define ADRENO_DRAWOBJ_PROFILE_OFFSET(_index, _member) \
 	 ((_index) * sizeof(struct adreno_drawobj_profile_entry) \
@@ -2019,6 +2044,32 @@ static inline bool adreno_has_gbif(struct adreno_device *adreno_dev)
 		return true;
 }
 
+/**
+ * adreno_gpu_stat_reg() - Perfcounter sampled around each drawobj for a stat
+ * @adreno_dev: Pointer to the adreno device
+ * @stat: The kgsl_gpu_stat to look up
+ *
+ * Return the low register of the kernel perfcounter that backs @stat, or 0
+ * if the counter wasn't reserved on this target. The bus counters are only
+ * reserved when bus DCVS is enabled.
+ */
+static inline unsigned int adreno_gpu_stat_reg(struct adreno_device *adreno_dev,
+		enum kgsl_gpu_stat stat)
+{
+	switch (stat) {
+	case KGSL_GPU_STAT_BUSY:
+		return adreno_dev->perfctr_pwr_lo;
+	case KGSL_GPU_STAT_RAM_STALL:
+		return adreno_dev->starved_ram_lo;
+	case KGSL_GPU_STAT_RAM_READ:
+		return adreno_dev->ram_cycles_lo;
+	case KGSL_GPU_STAT_RAM_WRITE:
+		return adreno_dev->ram_cycles_lo_ch0_write;
+	default:
+		return 0;
+	}
+}
+
 /**
  * adreno_wait_for_halt_ack() - wait for GBIF/VBIF acknowledgment
  * for given HALT request.
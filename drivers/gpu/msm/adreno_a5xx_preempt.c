@@ -10,6 +10,8 @@
  * GNU General Public License for more details.
  */
 
+#include <linux/moduleparam.h>
+
 #include "adreno.h"
 #include "adreno_a5xx.h"
 #include "a5xx_reg.h"
@@ -22,6 +24,58 @@
 #define PREEMPT_SMMU_RECORD(_field) \
 		offsetof(struct a5xx_cp_smmu_info, _field)
 
+/*
+ * Latency budget in usecs for each ringbuffer level. Work on a higher priority
+ * ringbuffer may wait behind the current one for up to its budget before a
+ * preemption is forced, so a burst of medium priority work doesn't pay for a
+ * context switch per submission. Zero keeps the old behaviour of preempting
+ * as soon as there is work. Compositor and VR contexts ask for the highest
+ * priority and therefore run on RB0.
+ */
+static unsigned int adreno_preempt_budget_us[KGSL_PRIORITY_MAX_RB_LEVELS];
+module_param_array_named(preempt_budget_us, adreno_preempt_budget_us, uint,
+	NULL, 0644);
+MODULE_PARM_DESC(preempt_budget_us,
+	"Per ringbuffer preemption latency budget in usecs (0 = immediate)");
+
+static inline unsigned int _preempt_hist_bucket(s64 us)
+{
+	if (us <= 0)
+		return 0;
+
+	return min_t(unsigned int, ilog2(us), ADRENO_PREEMPT_HIST_BUCKETS - 1);
+}
+
+/*
+ * Record the switch latency and how long the incoming ringbuffer waited.
+ * Called on preemption completion before next_rb becomes current.
+ */
+static void _a5xx_preemption_account(struct adreno_device *adreno_dev)
+{
+	struct adreno_preemption *preempt = &adreno_dev->preempt;
+	struct adreno_ringbuffer *next = adreno_dev->next_rb;
+	unsigned int budget = READ_ONCE(adreno_preempt_budget_us[next->id]);
+	ktime_t now = ktime_get();
+	s64 us;
+
+	preempt->count++;
+
+	us = ktime_us_delta(now, preempt->trigger_time);
+	preempt->switch_hist[_preempt_hist_bucket(us)]++;
+	preempt->switch_us = (unsigned int) (((u64) preempt->switch_us * 7 +
+		clamp_t(s64, us, 0, UINT_MAX)) >> 3);
+
+	if (ktime_to_ns(next->preempt_wait) == 0)
+		return;
+
+	us = ktime_us_delta(now, next->preempt_wait);
+	preempt->wait_hist[next->id][_preempt_hist_bucket(us)]++;
+	if (budget && us > budget)
+		preempt->budget_miss[next->id]++;
+
+	next->preempt_wait = 0;
+}
+
 static void _update_wptr(struct adreno_device *adreno_dev, bool reset_timer)
 {
 	struct adreno_ringbuffer *rb = adreno_dev->cur_rb;
@@ -90,6 +144,8 @@ static void _a5xx_preemption_done(struct adreno_device *adreno_dev)
 
 	trace_adreno_preempt_done(adreno_dev->cur_rb, adreno_dev->next_rb, 0);
 
+	_a5xx_preemption_account(adreno_dev);
+
 	/* Clean up all the bits */
 	adreno_dev->prev_rb = adreno_dev->cur_rb;
 	adreno_dev->cur_rb = adreno_dev->next_rb;
@@ -169,26 +225,111 @@ static void _a5xx_preemption_timer(unsigned long data)
 	queue_work(system_unbound_wq, &adreno_dev->preempt.work);
 }
 
-/* Find the highest priority active ringbuffer */
+static void _a5xx_budget_timer(unsigned long data)
+{
+	struct adreno_device *adreno_dev = (struct adreno_device *) data;
+
+	/* The dispatcher will retry the trigger now that the budget is spent */
+	adreno_dispatcher_schedule(KGSL_DEVICE(adreno_dev));
+}
+
+static bool _a5xx_rb_empty(struct adreno_ringbuffer *rb)
+{
+	unsigned long flags;
+	bool empty;
+
+	spin_lock_irqsave(&rb->preempt_lock, flags);
+	empty = adreno_rb_empty(rb);
+	spin_unlock_irqrestore(&rb->preempt_lock, flags);
+
+	return empty;
+}
+
+/* Note the time that a non current ringbuffer started waiting for the GPU */
+static void _a5xx_stamp_waiters(struct adreno_device *adreno_dev, ktime_t now)
+{
+	struct adreno_ringbuffer *rb;
+	unsigned int i;
+
+	FOR_EACH_RINGBUFFER(adreno_dev, rb, i) {
+		if (rb == adreno_dev->cur_rb ||
+			ktime_to_ns(rb->preempt_wait) != 0)
+			continue;
+
+		if (!_a5xx_rb_empty(rb))
+			rb->preempt_wait = now;
+	}
+}
+
+/*
+ * Return true if @rb has waited long enough to preempt the current
+ * ringbuffer. The switch is started early by the average switch latency so
+ * that it completes inside the budget. Otherwise *expires is pulled in to the
+ * time at which the budget will be spent.
+ */
+static bool _a5xx_budget_spent(struct adreno_device *adreno_dev,
+		struct adreno_ringbuffer *rb, ktime_t now, ktime_t *expires)
+{
+	unsigned int budget = READ_ONCE(adreno_preempt_budget_us[rb->id]);
+	ktime_t deadline;
+
+	if (budget == 0 || ktime_to_ns(rb->preempt_wait) == 0)
+		return true;
+
+	budget -= min(budget, adreno_dev->preempt.switch_us);
+	deadline = ktime_add_us(rb->preempt_wait, budget);
+
+	if (!ktime_before(now, deadline))
+		return true;
+
+	if (ktime_to_ns(*expires) == 0 || ktime_before(deadline, *expires))
+		*expires = deadline;
+
+	return false;
+}
+
+/*
+ * Find the highest priority active ringbuffer that should run. A higher
+ * priority ringbuffer only preempts a busy current one once its latency budget
+ * is spent; if the current ringbuffer is idle anything with work goes next.
+ */
 static struct adreno_ringbuffer *a5xx_next_ringbuffer(
 		struct adreno_device *adreno_dev)
 {
-	struct adreno_ringbuffer *rb;
-	unsigned long flags;
+	struct adreno_ringbuffer *cur = adreno_dev->cur_rb;
+	struct adreno_ringbuffer *rb, *ret = NULL;
+	ktime_t now = ktime_get();
+	ktime_t expires = 0;
+	bool cur_busy;
 	unsigned int i;
 
+	_a5xx_stamp_waiters(adreno_dev, now);
+
+	cur_busy = !_a5xx_rb_empty(cur);
+
 	FOR_EACH_RINGBUFFER(adreno_dev, rb, i) {
-		bool empty;
+		if (rb == cur) {
+			if (cur_busy) {
+				ret = rb;
+				break;
+			}
+			continue;
+		}
 
-		spin_lock_irqsave(&rb->preempt_lock, flags);
-		empty = adreno_rb_empty(rb);
-		spin_unlock_irqrestore(&rb->preempt_lock, flags);
+		if (_a5xx_rb_empty(rb))
+			continue;
 
-		if (empty == false)
+		if (!cur_busy || _a5xx_budget_spent(adreno_dev, rb, now,
+			&expires))
 			return rb;
 	}
 
-	return NULL;
+	/* Come back when the earliest deferred budget runs out */
+	if (ktime_to_ns(expires) != 0)
+		mod_timer(&adreno_dev->preempt.budget_timer, jiffies +
+			usecs_to_jiffies(ktime_us_delta(expires, now)) + 1);
+
+	return ret;
 }
 
 void a5xx_preemption_trigger(struct adreno_device *adreno_dev)
@@ -267,6 +408,7 @@ void a5xx_preemption_trigger(struct adreno_device *adreno_dev)
 		upper_32_bits(next->preemption_desc.gpuaddr));
 
 	adreno_dev->next_rb = next;
+	adreno_dev->preempt.trigger_time = ktime_get();
 
 	/* Start the timer to detect a stuck preemption */
 	mod_timer(&adreno_dev->preempt.timer,
@@ -310,6 +452,8 @@ void a5xx_preempt_callback(struct adreno_device *adreno_dev, int bit)
 
 	trace_adreno_preempt_done(adreno_dev->cur_rb, adreno_dev->next_rb, 0);
 
+	_a5xx_preemption_account(adreno_dev);
+
 	adreno_dev->prev_rb = adreno_dev->cur_rb;
 	adreno_dev->cur_rb = adreno_dev->next_rb;
 	adreno_dev->next_rb = NULL;
@@ -335,6 +479,8 @@ void a5xx_preemption_schedule(struct adreno_device *adreno_dev)
 
 	mutex_lock(&device->mutex);
 
+	_a5xx_stamp_waiters(adreno_dev, ktime_get());
+
 	if (adreno_in_preempt_state(adreno_dev, ADRENO_PREEMPT_COMPLETE))
 		_a5xx_preemption_done(adreno_dev);
 
@@ -497,6 +643,8 @@ void a5xx_preemption_start(struct adreno_device *adreno_dev)
 
 		adreno_ringbuffer_set_pagetable(rb,
 			device->mmu.defaultpagetable);
+
+		rb->preempt_wait = 0;
 	}
 
 }
@@ -575,6 +723,7 @@ static void _preemption_close(struct adreno_device *adreno_dev)
 	unsigned int i;
 
 	del_timer(&preempt->timer);
+	del_timer(&preempt->budget_timer);
 	kgsl_free_global(device, &preempt->counters);
 	a5xx_preemption_iommu_close(adreno_dev);
 
@@ -610,6 +759,9 @@ int a5xx_preemption_init(struct adreno_device *adreno_dev)
 	setup_timer(&preempt->timer, _a5xx_preemption_timer,
 		(unsigned long) adreno_dev);
 
+	setup_timer(&preempt->budget_timer, _a5xx_budget_timer,
+		(unsigned long) adreno_dev);
+
 	/* Allocate mem for storing preemption counters */
 	ret = kgsl_allocate_global(device, &preempt->counters,
 		adreno_dev->num_ringbuffers *
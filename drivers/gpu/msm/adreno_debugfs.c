@@ -116,6 +116,51 @@ static int _active_count_get(void *data, u64 *val)
 
 DEFINE_SIMPLE_ATTRIBUTE(_active_count_fops, _active_count_get, NULL, "%llu\n");
 
+static void preempt_hist_print(struct seq_file *s, const char *name,
+		unsigned int *hist)
+{
+	int i;
+
+	seq_printf(s, "%s:", name);
+	for (i = 0; i < ADRENO_PREEMPT_HIST_BUCKETS; i++)
+		seq_printf(s, " %u", hist[i]);
+	seq_puts(s, "\n");
+}
+
+static int preempt_latency_print(struct seq_file *s, void *unused)
+{
+	struct adreno_device *adreno_dev = s->private;
+	struct adreno_preemption *preempt = &adreno_dev->preempt;
+	char name[16];
+	int i;
+
+	seq_printf(s, "count: %u avg_switch_us: %u\n", preempt->count,
+		preempt->switch_us);
+	seq_puts(s, "buckets: log2 usec\n");
+	preempt_hist_print(s, "switch", preempt->switch_hist);
+
+	for (i = 0; i < adreno_dev->num_ringbuffers; i++) {
+		snprintf(name, sizeof(name), "rb%d wait", i);
+		preempt_hist_print(s, name, preempt->wait_hist[i]);
+		seq_printf(s, "rb%d budget_miss: %u\n", i,
+			preempt->budget_miss[i]);
+	}
+
+	return 0;
+}
+
+static int preempt_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, preempt_latency_print, inode->i_private);
+}
+
+static const struct file_operations preempt_latency_fops = {
+	.open = preempt_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 typedef void (*reg_read_init_t)(struct kgsl_device *device);
 typedef void (*reg_read_fill_t)(struct kgsl_device *device, int i,
 	unsigned int *vals, int linec);
@@ -298,6 +343,13 @@ static int ctx_print(struct seq_file *s, void *unused)
 		   queued, consumed, retired,
 		   drawctxt->internal_timestamp);
 
+	seq_printf(s, "gpu: ticks: %llu busy: %llu ram_stall: %llu ram_read: %llu ram_write: %llu\n",
+		   drawctxt->gpu_ticks,
+		   drawctxt->gpu_stats[KGSL_GPU_STAT_BUSY],
+		   drawctxt->gpu_stats[KGSL_GPU_STAT_RAM_STALL],
+		   drawctxt->gpu_stats[KGSL_GPU_STAT_RAM_READ],
+		   drawctxt->gpu_stats[KGSL_GPU_STAT_RAM_WRITE]);
+
 	seq_puts(s, "drawqueue:\n");
 
 	spin_lock(&drawctxt->lock);
@@ -387,4 +439,9 @@ void adreno_debugfs_init(struct adreno_device *adreno_dev)
 	if (adreno_is_a5xx(adreno_dev))
 		debugfs_create_file("isdb", 0644, device->d_debugfs,
 			device, &_isdb_fops);
+
+	if (adreno_is_a5xx(adreno_dev) &&
+		ADRENO_FEATURE(adreno_dev, ADRENO_PREEMPTION))
+		debugfs_create_file("preempt_latency", 0444,
+			device->d_debugfs, adreno_dev, &preempt_latency_fops);
 }
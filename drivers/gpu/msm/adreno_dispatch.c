@@ -66,6 +66,9 @@ unsigned int adreno_drawobj_timeout = 2000;
 /* Interval for reading and comparing fault detection registers */
 static unsigned int _fault_timer_interval = 200;
 
+/* Submit from the calling thread when the target ringbuffer is idle */
+static unsigned int _direct_submit = 1;
+
 #define DRAWQUEUE_RB(_drawqueue) \
 	((struct adreno_ringbuffer *) \
 		container_of((_drawqueue),\
@@ -576,6 +579,11 @@ static int sendcmd(struct adreno_device *adreno_dev,
 	if (test_bit(ADRENO_DEVICE_DRAWOBJ_PROFILE, &adreno_dev->priv)) {
 		set_bit(CMDOBJ_PROFILE, &cmdobj->priv);
 		cmdobj->profile_index = adreno_dev->profile_index;
+		/* Don't let a skipped command account the previous user's data */
+		memset(adreno_dev->profile_buffer.hostptr +
+			ADRENO_DRAWOBJ_PROFILE_OFFSET(cmdobj->profile_index,
+				started), 0,
+			sizeof(struct adreno_drawobj_profile_entry));
 		adreno_dev->profile_index =
 			(adreno_dev->profile_index + 1) %
 			ADRENO_DRAWOBJ_PROFILE_COUNT;
@@ -1015,6 +1023,69 @@ static void adreno_dispatcher_issuecmds(struct adreno_device *adreno_dev)
 	adreno_dispatcher_schedule(device);
 }
 
+/**
+ * _dispatcher_direct_submit() - Send commands from the submitting thread
+ * @adreno_dev: Pointer to the adreno device struct
+ * @drawctxt: Pointer to the adreno context that just queued commands
+ * @dispatch_q: Pointer to the drawqueue of the context's ringbuffer
+ *
+ * If nothing is inflight on the ringbuffer and no other context is waiting
+ * in the dispatcher, skip the pending list and send the context's commands
+ * right away. Anything that gets in the way (a fault, a halt, slumber,
+ * unsignaled sync points or a busy dispatcher) leaves the commands to the
+ * regular dispatcher path. Returns true if the context queue was drained.
+ */
+static bool _dispatcher_direct_submit(struct adreno_device *adreno_dev,
+		struct adreno_context *drawctxt,
+		struct adreno_dispatcher_drawqueue *dispatch_q)
+{
+	struct adreno_dispatcher *dispatcher = &adreno_dev->dispatcher;
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+	bool empty;
+	int ret;
+
+	if (!_direct_submit || dispatch_q->inflight ||
+		(drawctxt->base.flags & KGSL_CONTEXT_SPARSE))
+		return false;
+
+	if (adreno_gpu_fault(adreno_dev) != 0 ||
+		adreno_gpu_halt(adreno_dev) != 0)
+		return false;
+
+	/* Don't jump ahead of contexts that are already waiting */
+	spin_lock(&dispatcher->plist_lock);
+	empty = plist_head_empty(&dispatcher->pending);
+	spin_unlock(&dispatcher->plist_lock);
+	if (!empty)
+		return false;
+
+	spin_lock(&device->submit_lock);
+	if (device->slumber == true) {
+		spin_unlock(&device->submit_lock);
+		return false;
+	}
+	device->submit_now++;
+	spin_unlock(&device->submit_lock);
+
+	if (!mutex_trylock(&dispatcher->mutex)) {
+		_decrement_submit_now(device);
+		return false;
+	}
+
+	ret = dispatcher_context_sendcmds(adreno_dev, drawctxt);
+	mutex_unlock(&dispatcher->mutex);
+	_decrement_submit_now(device);
+
+	if (ret <= 0)
+		return false;
+
+	spin_lock(&drawctxt->lock);
+	empty = (drawctxt->drawqueue_head == drawctxt->drawqueue_tail);
+	spin_unlock(&drawctxt->lock);
+
+	return empty;
+}
+
 /**
  * get_timestamp() - Return the next timestamp for the context
  * @drawctxt - Pointer to an adreno draw context struct
@@ -1475,6 +1546,9 @@ int adreno_dispatcher_queue_cmds(struct kgsl_device_private *dev_priv,
 		kgsl_pwrctrl_update_l2pc(&adreno_dev->dev,
 				KGSL_L2PC_QUEUE_TIMEOUT);
 
+	if (_dispatcher_direct_submit(adreno_dev, drawctxt, dispatch_q))
+		goto done;
+
 	/* Add the context to the dispatcher pending list */
 	dispatcher_queue_context(adreno_dev, drawctxt);
 
@@ -2320,10 +2394,12 @@ static void _print_recovery(struct kgsl_device *device,
 }
 
 static void cmdobj_profile_ticks(struct adreno_device *adreno_dev,
-	struct kgsl_drawobj_cmd *cmdobj, uint64_t *start, uint64_t *retire)
+	struct kgsl_drawobj_cmd *cmdobj, uint64_t *start, uint64_t *retire,
+	uint32_t *stats)
 {
 	void *ptr = adreno_dev->profile_buffer.hostptr;
 	struct adreno_drawobj_profile_entry *entry;
+	int i;
 
 	entry = (struct adreno_drawobj_profile_entry *)
 		(ptr + (cmdobj->profile_index * sizeof(*entry)));
@@ -2332,6 +2408,33 @@ static void cmdobj_profile_ticks(struct adreno_device *adreno_dev,
 	rmb();
 	*start = entry->started;
 	*retire = entry->retired;
+
+	/* The counters are sampled 32 bits wide, let the deltas wrap */
+	for (i = 0; i < KGSL_GPU_STAT_MAX; i++)
+		stats[i] = entry->counter_retired[i] - entry->counter_started[i];
+}
+
+/*
+ * Charge a retired command's GPU time and counters to its context and
+ * process so that GPU load can be attributed to the apps causing it
+ */
+static void cmdobj_account_stats(struct kgsl_drawobj *drawobj,
+		uint64_t start, uint64_t end, const uint32_t *stats)
+{
+	struct adreno_context *drawctxt = ADRENO_CONTEXT(drawobj->context);
+	struct kgsl_process_private *proc = drawobj->context->proc_priv;
+	uint64_t ticks = end > start ? end - start : 0;
+	int i;
+
+	drawctxt->gpu_ticks += ticks;
+	atomic64_add(ticks, &proc->gpu_ticks);
+
+	for (i = 0; i < KGSL_GPU_STAT_MAX; i++) {
+		drawctxt->gpu_stats[i] += stats[i];
+		atomic64_add(stats[i], &proc->gpu_stats[i]);
+	}
+
+	trace_adreno_cmdbatch_gpu_stats(drawobj, ticks, stats);
 }
 
 static void retire_cmdobj(struct adreno_device *adreno_dev,
@@ -2341,14 +2444,17 @@ static void retire_cmdobj(struct adreno_device *adreno_dev,
 	struct kgsl_drawobj *drawobj = DRAWOBJ(cmdobj);
 	struct adreno_context *drawctxt = ADRENO_CONTEXT(drawobj->context);
 	uint64_t start = 0, end = 0;
+	uint32_t stats[KGSL_GPU_STAT_MAX];
 
 	if (cmdobj->fault_recovery != 0) {
 		set_bit(ADRENO_CONTEXT_FAULT, &drawobj->context->priv);
 		_print_recovery(KGSL_DEVICE(adreno_dev), cmdobj);
 	}
 
-	if (test_bit(CMDOBJ_PROFILE, &cmdobj->priv))
-		cmdobj_profile_ticks(adreno_dev, cmdobj, &start, &end);
+	if (test_bit(CMDOBJ_PROFILE, &cmdobj->priv)) {
+		cmdobj_profile_ticks(adreno_dev, cmdobj, &start, &end, stats);
+		cmdobj_account_stats(drawobj, start, end, stats);
+	}
 
 	/*
 	 * For A3xx we still get the rptr from the CP_RB_RPTR instead of
@@ -2728,6 +2834,14 @@ struct dispatcher_attribute {
 		.value = &(_value), \
 	}
 
+#define DISPATCHER_BOOL_ATTR(_name, _mode, _value) \
+	struct dispatcher_attribute dispatcher_attr_##_name =  { \
+		.attr = { .name = __stringify(_name), .mode = _mode }, \
+		.show = _show_uint, \
+		.store = _store_bool, \
+		.value = &(_value), \
+	}
+
 #define to_dispatcher_attr(_a) \
 	container_of((_a), struct dispatcher_attribute, attr)
 #define to_dispatcher(k) container_of(k, struct adreno_dispatcher, kobj)
@@ -2750,6 +2864,21 @@ static ssize_t _store_uint(struct adreno_dispatcher *dispatcher,
 	return size;
 }
 
+static ssize_t _store_bool(struct adreno_dispatcher *dispatcher,
+		struct dispatcher_attribute *attr,
+		const char *buf, size_t size)
+{
+	unsigned int val = 0;
+	int ret;
+
+	ret = kgsl_sysfs_store(buf, &val);
+	if (ret)
+		return ret;
+
+	*((unsigned int *) attr->value) = val ? 1 : 0;
+	return size;
+}
+
 static ssize_t _show_uint(struct adreno_dispatcher *dispatcher,
 		struct dispatcher_attribute *attr,
 		char *buf)
@@ -2782,6 +2911,7 @@ static DISPATCHER_UINT_ATTR(fault_throttle_time, 0644, 0,
 	_fault_throttle_time);
 static DISPATCHER_UINT_ATTR(fault_throttle_burst, 0644, 0,
 	_fault_throttle_burst);
+static DISPATCHER_BOOL_ATTR(direct_submit, 0644, _direct_submit);
 
 static struct attribute *dispatcher_attrs[] = {
 	&dispatcher_attr_inflight.attr,
@@ -2793,6 +2923,7 @@ static struct attribute *dispatcher_attrs[] = {
 	&dispatcher_attr_fault_detect_interval.attr,
 	&dispatcher_attr_fault_throttle_time.attr,
 	&dispatcher_attr_fault_throttle_burst.attr,
+	&dispatcher_attr_direct_submit.attr,
 	NULL,
 };
 
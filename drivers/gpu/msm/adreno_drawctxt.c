@@ -164,6 +164,12 @@ int adreno_drawctxt_wait(struct adreno_device *adreno_dev,
 
 	trace_adreno_drawctxt_wait_start(-1, context->id, timestamp);
 
+	/* Skip the event and the sleep if the timestamp is about to retire */
+	if (kgsl_spin_for_timestamp(device, context, timestamp)) {
+		ret = 0;
+		goto done;
+	}
+
 	ret = kgsl_add_event(device, &context->events, timestamp,
 		wait_callback, (void *) drawctxt);
 	if (ret)
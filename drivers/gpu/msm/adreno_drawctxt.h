@@ -53,6 +53,9 @@ struct kgsl_context;
  *		 be written.
  * @active_node: Linkage for nodes in active_list
  * @active_time: Time when this context last seen
+ * @gpu_ticks: Always on ticks spent executing this context's commands
+ * @gpu_stats: Perfcounter deltas summed over this context's commands, indexed
+ *		by enum kgsl_gpu_stat
  */
 struct adreno_context {
 	struct kgsl_context base;
@@ -82,6 +85,9 @@ struct adreno_context {
 
 	struct list_head active_node;
 	unsigned long active_time;
+
+	uint64_t gpu_ticks;
+	uint64_t gpu_stats[KGSL_GPU_STAT_MAX];
 };
 
 /* Flag definitions for flag field in adreno_context */
@@ -875,6 +875,33 @@ static inline int _get_alwayson_counter(struct adreno_device *adreno_dev,
 	return (unsigned int)(p - cmds);
 }
 
+/*
+ * Copy the low word of each perfcounter backing a kgsl_gpu_stat into the
+ * drawobj profile entry, alongside the always on timestamps
+ */
+static unsigned int _get_gpu_stat_counters(struct adreno_device *adreno_dev,
+		unsigned int *cmds, unsigned int index, bool retired)
+{
+	unsigned int *p = cmds;
+	uint64_t gpuaddr = adreno_dev->profile_buffer.gpuaddr + (retired ?
+		ADRENO_DRAWOBJ_PROFILE_OFFSET(index, counter_retired) :
+		ADRENO_DRAWOBJ_PROFILE_OFFSET(index, counter_started));
+	int i;
+
+	for (i = 0; i < KGSL_GPU_STAT_MAX; i++) {
+		unsigned int reg = adreno_gpu_stat_reg(adreno_dev, i);
+
+		if (reg == 0)
+			continue;
+
+		*p++ = cp_mem_packet(adreno_dev, CP_REG_TO_MEM, 2, 1);
+		*p++ = reg;
+		p += cp_gpuaddr(adreno_dev, p, gpuaddr + i * sizeof(uint32_t));
+	}
+
+	return (unsigned int)(p - cmds);
+}
+
 /* This is the maximum possible size for 64 bit targets */
 #define PROFILE_IB_DWORDS 4
 #define PROFILE_IB_SLOTS (PAGE_SIZE / (PROFILE_IB_DWORDS << 2))
@@ -1031,6 +1058,8 @@ int adreno_ringbuffer_submitcmd(struct adreno_device *adreno_dev,
 		dwords += 6;
 		if (!ADRENO_LEGACY_PM4(adreno_dev))
 			dwords += 2;
+		/* Up to four dwords per counter at both ends */
+		dwords += KGSL_GPU_STAT_MAX * 8;
 	}
 
 	if (adreno_is_preemption_enabled(adreno_dev))
@@ -1067,6 +1096,8 @@ int adreno_ringbuffer_submitcmd(struct adreno_device *adreno_dev,
 			adreno_dev->profile_buffer.gpuaddr +
 			ADRENO_DRAWOBJ_PROFILE_OFFSET(cmdobj->profile_index,
 				started));
+		cmds += _get_gpu_stat_counters(adreno_dev, cmds,
+			cmdobj->profile_index, false);
 	}
 
 	/*
@@ -1115,6 +1146,8 @@ int adreno_ringbuffer_submitcmd(struct adreno_device *adreno_dev,
 			cmds += gpudev->preemption_yield_enable(cmds);
 
 	if (kernel_profiling) {
+		cmds += _get_gpu_stat_counters(adreno_dev, cmds,
+			cmdobj->profile_index, true);
 		cmds += _get_alwayson_counter(adreno_dev, cmds,
 			adreno_dev->profile_buffer.gpuaddr +
 			ADRENO_DRAWOBJ_PROFILE_OFFSET(cmdobj->profile_index,
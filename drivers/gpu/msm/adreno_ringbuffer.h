@@ -110,6 +110,8 @@ struct adreno_ringbuffer_pagetable_info {
  * @preempt_lock: Lock to protect the wptr pointer while it is being updated
  * @skip_inline_wptr: Used during preemption to make sure wptr is updated in
  * hardware
+ * @preempt_wait: Time at which commands on this RB started waiting for it to
+ * be switched in, zero if it is current or has nothing queued
  */
 struct adreno_ringbuffer {
 	uint32_t flags;
@@ -133,6 +135,7 @@ struct adreno_ringbuffer {
 	int preempted_midway;
 	spinlock_t preempt_lock;
 	bool skip_inline_wptr;
+	ktime_t preempt_wait;
 	/**
 	 * @profile_desc: global memory to construct IB1s to do user side
 	 * profiling
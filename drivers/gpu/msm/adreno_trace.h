@@ -148,6 +148,38 @@ TRACE_EVENT(adreno_cmdbatch_retired,
 	)
 );
 
+TRACE_EVENT(adreno_cmdbatch_gpu_stats,
+	TP_PROTO(struct kgsl_drawobj *drawobj, uint64_t ticks,
+		const uint32_t *stats),
+	TP_ARGS(drawobj, ticks, stats),
+	TP_STRUCT__entry(
+		__field(unsigned int, id)
+		__field(pid_t, pid)
+		__field(unsigned int, timestamp)
+		__field(uint64_t, ticks)
+		__field(uint32_t, busy)
+		__field(uint32_t, ram_stall)
+		__field(uint32_t, ram_read)
+		__field(uint32_t, ram_write)
+	),
+	TP_fast_assign(
+		__entry->id = drawobj->context->id;
+		__entry->pid = drawobj->context->proc_priv->pid;
+		__entry->timestamp = drawobj->timestamp;
+		__entry->ticks = ticks;
+		__entry->busy = stats[KGSL_GPU_STAT_BUSY];
+		__entry->ram_stall = stats[KGSL_GPU_STAT_RAM_STALL];
+		__entry->ram_read = stats[KGSL_GPU_STAT_RAM_READ];
+		__entry->ram_write = stats[KGSL_GPU_STAT_RAM_WRITE];
+	),
+	TP_printk(
+		"ctx=%u pid=%d ts=%u ticks=%llu busy=%u ram_stall=%u ram_read=%u ram_write=%u",
+		__entry->id, __entry->pid, __entry->timestamp, __entry->ticks,
+		__entry->busy, __entry->ram_stall, __entry->ram_read,
+		__entry->ram_write
+	)
+);
+
 TRACE_EVENT(adreno_cmdbatch_sync,
 	TP_PROTO(struct adreno_context *drawctxt,
 		uint64_t ticks),
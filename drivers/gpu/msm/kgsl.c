@@ -71,6 +71,15 @@ static char *kgsl_mmu_type;
 module_param_named(mmutype, kgsl_mmu_type, charp, 0000);
 MODULE_PARM_DESC(kgsl_mmu_type, "Type of MMU to be used for graphics");
 
+static bool kgsl_lazy_map;
+module_param_named(lazy_map, kgsl_lazy_map, bool, 0644);
+MODULE_PARM_DESC(lazy_map, "Defer GPU mappings until the next submission");
+
+static unsigned int kgsl_wait_spin_us;
+module_param_named(wait_spin_us, kgsl_wait_spin_us, uint, 0644);
+MODULE_PARM_DESC(wait_spin_us,
+	"Time to poll a timestamp before sleeping on it (usecs)");
+
 /* Mutex used for the IOMMU sync quirk */
 DEFINE_MUTEX(kgsl_mmu_sync);
 EXPORT_SYMBOL(kgsl_mmu_sync);
@@ -278,6 +287,7 @@ kgsl_mem_entry_create(void)
 		kref_init(&entry->refcount);
 		/* put this ref in userspace memory alloc and map ioctls */
 		kref_get(&entry->refcount);
+		INIT_LIST_HEAD(&entry->lazy_node);
 	}
 
 	return entry;
@@ -452,6 +462,27 @@ static void kgsl_mem_entry_commit_process(struct kgsl_mem_entry *entry)
 	spin_unlock(&entry->priv->mem_lock);
 }
 
+/*
+ * Plain user allocations can have their GPU mapping deferred. Sparse, secure,
+ * global and SVM buffers have their own mapping rules and are always mapped
+ * right away.
+ */
+static bool kgsl_mem_entry_can_map_lazy(struct kgsl_mem_entry *entry)
+{
+	struct kgsl_memdesc *memdesc = &entry->memdesc;
+
+	if (!kgsl_lazy_map)
+		return false;
+
+	if (memdesc->flags & (KGSL_MEMFLAGS_SPARSE_VIRT |
+				KGSL_MEMFLAGS_SPARSE_PHYS))
+		return false;
+
+	return !kgsl_memdesc_is_secured(memdesc) &&
+		!kgsl_memdesc_is_global(memdesc) &&
+		!kgsl_memdesc_use_cpu_map(memdesc);
+}
+
 /*
  * Attach the memory object to a process by (possibly) getting a GPU address and
  * (possibly) mapping it
@@ -499,7 +530,12 @@ static int kgsl_mem_entry_attach_process(struct kgsl_device *device,
 				entry->memdesc.pagetable,
 				&entry->memdesc, 0,
 				kgsl_memdesc_footprint(&entry->memdesc));
-		else if (entry->memdesc.gpuaddr)
+		else if (kgsl_mem_entry_can_map_lazy(entry)) {
+			entry->memdesc.priv |= KGSL_MEMDESC_LAZY_MAP;
+			spin_lock(&process->mem_lock);
+			list_add_tail(&entry->lazy_node, &process->lazy_list);
+			spin_unlock(&process->mem_lock);
+		} else if (entry->memdesc.gpuaddr)
 			ret = kgsl_mmu_map(entry->memdesc.pagetable,
 					&entry->memdesc);
 
@@ -513,6 +549,73 @@ static int kgsl_mem_entry_attach_process(struct kgsl_device *device,
 	return ret;
 }
 
+/*
+ * Take a reference to the next entry waiting for a mapping. The entry stays
+ * queued until it is mapped, so that a racing submitter finds the list busy
+ * and waits on lazy_map_lock instead of running ahead of the mapping.
+ */
+static struct kgsl_mem_entry *
+_kgsl_lazy_map_peek(struct kgsl_process_private *private)
+{
+	struct kgsl_mem_entry *entry, *ret = NULL;
+
+	spin_lock(&private->mem_lock);
+	while (ret == NULL && !list_empty(&private->lazy_list)) {
+		entry = list_first_entry(&private->lazy_list,
+				struct kgsl_mem_entry, lazy_node);
+
+		/* Entries on their way out never need the mapping */
+		if (kgsl_mem_entry_get(entry))
+			ret = entry;
+		else
+			list_del_init(&entry->lazy_node);
+	}
+	spin_unlock(&private->mem_lock);
+
+	return ret;
+}
+
+/**
+ * kgsl_process_map_lazy() - Map the entries whose GPU mapping was deferred
+ * @private: Process that is about to queue commands
+ *
+ * Must be called before any command from @private is queued so that
+ * everything the process allocated so far is visible to the GPU.
+ * Allocations freed before their first submission are never mapped.
+ * Return 0 on success or the mapping error, in which case the failed entry
+ * stays queued for the next submission.
+ */
+static int kgsl_process_map_lazy(struct kgsl_process_private *private)
+{
+	struct kgsl_mem_entry *entry;
+	int ret = 0;
+
+	if (list_empty(&private->lazy_list))
+		return 0;
+
+	/* Hold off other submitters until everything is mapped */
+	mutex_lock(&private->lazy_map_lock);
+
+	while ((entry = _kgsl_lazy_map_peek(private)) != NULL) {
+		ret = kgsl_mmu_map(entry->memdesc.pagetable, &entry->memdesc);
+		if (!ret) {
+			entry->memdesc.priv &= ~KGSL_MEMDESC_LAZY_MAP;
+			spin_lock(&private->mem_lock);
+			list_del_init(&entry->lazy_node);
+			spin_unlock(&private->mem_lock);
+		}
+
+		kgsl_mem_entry_put(entry);
+
+		if (ret)
+			break;
+	}
+
+	mutex_unlock(&private->lazy_map_lock);
+
+	return ret;
+}
+
 /* Detach a memory entry from a process and unmap it from the MMU */
 static void kgsl_mem_entry_detach_process(struct kgsl_mem_entry *entry)
 {
@@ -530,6 +633,8 @@ static void kgsl_mem_entry_detach_process(struct kgsl_mem_entry *entry)
 		idr_remove(&entry->priv->mem_idr, entry->id);
 	entry->id = 0;
 
+	list_del_init(&entry->lazy_node);
+
 	type = kgsl_memdesc_usermem_type(&entry->memdesc);
 
 	if (type != KGSL_MEM_ENTRY_ION)
@@ -826,6 +931,38 @@ int kgsl_check_timestamp(struct kgsl_device *device,
 }
 EXPORT_SYMBOL(kgsl_check_timestamp);
 
+/**
+ * kgsl_spin_for_timestamp() - Poll the memstore for a timestamp before sleeping
+ * @device: Pointer to the KGSL device to check
+ * @context: Pointer to the context for the timestamp
+ * @timestamp: The timestamp to wait for
+ *
+ * Waiters that are about to sleep on a timestamp that is nearly done lose
+ * the interrupt plus event worker plus wakeup latency. Spin for up to
+ * kgsl.wait_spin_us on the retired timestamp first. Returns true if the
+ * timestamp retired while spinning.
+ */
+bool kgsl_spin_for_timestamp(struct kgsl_device *device,
+	struct kgsl_context *context, unsigned int timestamp)
+{
+	unsigned int spin = READ_ONCE(kgsl_wait_spin_us);
+	ktime_t end;
+
+	if (spin == 0)
+		return false;
+
+	end = ktime_add_us(ktime_get(), spin);
+
+	do {
+		if (kgsl_check_timestamp(device, context, timestamp))
+			return true;
+
+		cpu_relax();
+	} while (!need_resched() && ktime_before(ktime_get(), end));
+
+	return false;
+}
+
 static int kgsl_suspend_device(struct kgsl_device *device, pm_message_t state)
 {
 	int status = -EINVAL;
@@ -1047,6 +1184,9 @@ static struct kgsl_process_private *kgsl_process_private_new(
 	idr_init(&private->mem_idr);
 	idr_init(&private->syncsource_idr);
 
+	INIT_LIST_HEAD(&private->lazy_list);
+	mutex_init(&private->lazy_map_lock);
+
 	/* Allocate a pagetable for the new process object */
 	private->pagetable = kgsl_mmu_getpagetable(&device->mmu, tgid);
 	if (IS_ERR(private->pagetable)) {
@@ -1758,6 +1898,9 @@ long kgsl_ioctl_rb_issueibcmds(struct kgsl_device_private *dev_priv,
 		result = kgsl_drawobj_cmd_add_ibdesc(device, cmdobj, &ibdesc);
 	}
 
+	if (result == 0)
+		result = kgsl_process_map_lazy(dev_priv->process_priv);
+
 	if (result == 0)
 		result = dev_priv->device->ftbl->queue_cmds(dev_priv, context,
 				&drawobj, 1, &param->timestamp);
@@ -1872,6 +2015,10 @@ long kgsl_ioctl_submit_commands(struct kgsl_device_private *dev_priv,
 				~(unsigned long)KGSL_DRAWOBJ_PROFILING;
 	}
 
+	result = kgsl_process_map_lazy(dev_priv->process_priv);
+	if (result)
+		goto done;
+
 	result = device->ftbl->queue_cmds(dev_priv, context, drawobj,
 			i, &param->timestamp);
 
@@ -1962,6 +2109,10 @@ long kgsl_ioctl_gpu_command(struct kgsl_device_private *dev_priv,
 				~(unsigned long)KGSL_DRAWOBJ_PROFILING;
 	}
 
+	result = kgsl_process_map_lazy(dev_priv->process_priv);
+	if (result)
+		goto done;
+
 	result = device->ftbl->queue_cmds(dev_priv, context, drawobj,
 				i, &param->timestamp);
 
@@ -4216,6 +4367,25 @@ long kgsl_ioctl_gpu_sparse_command(struct kgsl_device_private *dev_priv,
 	return result;
 }
 
+long kgsl_ioctl_frame_deadline(struct kgsl_device_private *dev_priv,
+		unsigned int cmd, void *data)
+{
+	struct kgsl_frame_deadline *param = data;
+	struct kgsl_device *device = dev_priv->device;
+	struct kgsl_context *context;
+	long result;
+
+	context = kgsl_context_get_owner(dev_priv, param->context_id);
+	if (context == NULL)
+		return -EINVAL;
+
+	result = kgsl_pwrscale_frame_deadline(device, context,
+			param->timestamp, param->deadline);
+
+	kgsl_context_put(context);
+	return result;
+}
+
 void kgsl_sparse_bind(struct kgsl_process_private *private,
 		struct kgsl_drawobj_sparse *sparseobj)
 {
@@ -5113,6 +5283,7 @@ static void kgsl_core_exit(void)
 	}
 
 	kgsl_drawobjs_cache_exit();
+	kgsl_sync_exit();
 
 	kgsl_memfree_exit();
 	unregister_chrdev_region(kgsl_driver.major, KGSL_DEVICE_MAX);
@@ -5207,6 +5378,10 @@ static int __init kgsl_core_init(void)
 	if (result)
 		goto err;
 
+	result = kgsl_sync_init();
+	if (result)
+		goto err;
+
 	kgsl_memfree_init();
 
 	return 0;
@@ -203,6 +203,8 @@ struct kgsl_memdesc_ops {
 #define KGSL_MEMDESC_UCODE BIT(9)
 /* For global buffers, randomly assign an address from the region */
 #define KGSL_MEMDESC_RANDOM BIT(10)
+/* The GPU mapping is deferred until the owner next submits work */
+#define KGSL_MEMDESC_LAZY_MAP BIT(11)
 
 /**
  * struct kgsl_memdesc - GPU memory object descriptor
@@ -279,6 +281,7 @@ struct kgsl_memdesc {
  * @work: Work struct used to schedule a kgsl_mem_entry_put in atomic contexts
  * @bind_lock: Lock for sparse memory bindings
  * @bind_tree: RB Tree for sparse memory bindings
+ * @lazy_node: Node in the process list of entries waiting for a GPU mapping
  */
 struct kgsl_mem_entry {
 	struct kref refcount;
@@ -292,6 +295,7 @@ struct kgsl_mem_entry {
 	struct work_struct work;
 	spinlock_t bind_lock;
 	struct rb_root bind_tree;
+	struct list_head lazy_node;
 };
 
 struct kgsl_device_private;
@@ -449,6 +453,8 @@ long kgsl_ioctl_sparse_unbind(struct kgsl_device_private *dev_priv,
 					unsigned int cmd, void *data);
 long kgsl_ioctl_gpu_sparse_command(struct kgsl_device_private *dev_priv,
 					unsigned int cmd, void *data);
+long kgsl_ioctl_frame_deadline(struct kgsl_device_private *dev_priv,
+					unsigned int cmd, void *data);
 
 void kgsl_mem_entry_destroy(struct kref *kref);
 
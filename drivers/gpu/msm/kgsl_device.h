@@ -483,6 +483,28 @@ struct kgsl_process_private {
 	int fd_count;
 	atomic_t ctxt_count;
 	spinlock_t ctxt_count_lock;
+	/* Entries waiting for a GPU mapping, protected by mem_lock */
+	struct list_head lazy_list;
+	/* Serializes submissions mapping the entries on lazy_list */
+	struct mutex lazy_map_lock;
+	/* Always-on ticks and counters accumulated by retired commands */
+	atomic64_t gpu_ticks;
+	atomic64_t gpu_stats[KGSL_GPU_STAT_MAX];
+};
+
+/**
+ * enum kgsl_gpu_stat - GPU usage sampled around every command of a process
+ * @KGSL_GPU_STAT_BUSY: GPU busy cycles
+ * @KGSL_GPU_STAT_RAM_STALL: Cycles the bus interface was stalled by DDR
+ * @KGSL_GPU_STAT_RAM_READ: DDR read beats (all beats on VBIF targets)
+ * @KGSL_GPU_STAT_RAM_WRITE: DDR write beats (GBIF targets only)
+ */
+enum kgsl_gpu_stat {
+	KGSL_GPU_STAT_BUSY = 0,
+	KGSL_GPU_STAT_RAM_STALL,
+	KGSL_GPU_STAT_RAM_READ,
+	KGSL_GPU_STAT_RAM_WRITE,
+	KGSL_GPU_STAT_MAX,
 };
 
 /**
@@ -724,6 +746,9 @@ int kgsl_readtimestamp(struct kgsl_device *device, void *priv,
 int kgsl_check_timestamp(struct kgsl_device *device,
 		struct kgsl_context *context, unsigned int timestamp);
 
+bool kgsl_spin_for_timestamp(struct kgsl_device *device,
+		struct kgsl_context *context, unsigned int timestamp);
+
 int kgsl_device_platform_probe(struct kgsl_device *device);
 
 void kgsl_device_platform_remove(struct kgsl_device *device);
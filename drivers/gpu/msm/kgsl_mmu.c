@@ -439,7 +439,9 @@ void kgsl_mmu_put_gpuaddr(struct kgsl_memdesc *memdesc)
 	if (memdesc->size == 0 || memdesc->gpuaddr == 0)
 		return;
 
-	if (!kgsl_memdesc_is_global(memdesc))
+	/* A deferred mapping that never happened has nothing to unmap */
+	if (!kgsl_memdesc_is_global(memdesc) &&
+			!(memdesc->priv & KGSL_MEMDESC_LAZY_MAP))
 		unmap_fail = kgsl_mmu_unmap(pagetable, memdesc);
 
 	/*
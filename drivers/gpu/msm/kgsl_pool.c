@@ -16,6 +16,8 @@
 #include <linux/slab.h>
 #include <linux/highmem.h>
 #include <linux/version.h>
+#include <linux/kthread.h>
+#include <linux/freezer.h>
 
 #include "kgsl.h"
 #include "kgsl_device.h"
@@ -25,6 +27,31 @@
 #define KGSL_MAX_POOL_ORDER 8
 #define KGSL_MAX_RESERVED_PAGES 4096
 
+/* Per-cpu magazines hold up to this many 4K pages worth of a pool order */
+#define KGSL_POOL_MAG_PAGES 64
+#define KGSL_POOL_MAG_MAX_ORDER 4
+
+/* Upper bound of an adaptive pool target, in 4K pages */
+#define KGSL_POOL_TARGET_MAX_PAGES 8192
+
+/* How long to hold off refill after the shrinker ran */
+#define KGSL_POOL_PRESSURE_BACKOFF msecs_to_jiffies(1000)
+
+/* How long to skip the buddy allocator for an order after it failed */
+#define KGSL_POOL_HIGHORDER_BACKOFF msecs_to_jiffies(100)
+
+/**
+ * struct kgsl_pool_magazine - Per-cpu cache of zeroed pages for a pool
+ * @lock: Protects the magazine against a drain from another cpu
+ * @count: Number of pages in the magazine
+ * @pages: Cached pages, each of the pool order
+ */
+struct kgsl_pool_magazine {
+	spinlock_t lock;
+	unsigned int count;
+	struct page *pages[KGSL_POOL_MAG_PAGES];
+};
+
 /**
  * struct kgsl_page_pool - Structure to hold information for the pool
  * @pool_order: Page order describing the size of the page
@@ -34,6 +61,12 @@
  * from system memory
  * @list_lock: Spinlock for page list in the pool
  * @page_list: List of pages held/reserved in this pool
+ * @mag: Per-cpu magazines in front of the page list, NULL for high orders
+ * @mag_size: Capacity of each magazine
+ * @mag_count: Number of pages sitting in the magazines
+ * @alloc_count: Pages handed out since the last refill run
+ * @target: Number of pages the refill thread keeps in the pool
+ * @highorder_backoff: Until when allocations skip the buddy allocator
  */
 struct kgsl_page_pool {
 	unsigned int pool_order;
@@ -42,12 +75,23 @@ struct kgsl_page_pool {
 	bool allocation_allowed;
 	spinlock_t list_lock;
 	struct list_head page_list;
+	struct kgsl_pool_magazine __percpu *mag;
+	unsigned int mag_size;
+	atomic_t mag_count;
+	atomic_t alloc_count;
+	unsigned int target;
+	unsigned long highorder_backoff;
 };
 
 static struct kgsl_page_pool kgsl_pools[KGSL_MAX_POOLS];
 static int kgsl_num_pools;
 static int kgsl_pool_max_pages;
 
+static struct task_struct *kgsl_pool_refill_task;
+static DECLARE_WAIT_QUEUE_HEAD(kgsl_pool_refill_wq);
+static bool kgsl_pool_refill_pending;
+static unsigned long kgsl_pool_pressure_until;
+
 
 /* Returns KGSL pool corresponding to input page order*/
 static struct kgsl_page_pool *
@@ -79,33 +123,122 @@ _kgsl_pool_zero_page(struct page *p, unsigned int pool_order)
 	}
 }
 
-/* Add a page to specified pool */
+/* Put a zeroed page in this cpu's magazine, false if it is full */
+static bool
+_kgsl_pool_mag_put(struct kgsl_page_pool *pool, struct page *p)
+{
+	struct kgsl_pool_magazine *mag;
+	bool added = false;
+
+	if (pool->mag == NULL)
+		return false;
+
+	mag = get_cpu_ptr(pool->mag);
+	spin_lock(&mag->lock);
+	if (mag->count < pool->mag_size) {
+		mag->pages[mag->count++] = p;
+		added = true;
+	}
+	spin_unlock(&mag->lock);
+	put_cpu_ptr(pool->mag);
+
+	if (added)
+		atomic_inc(&pool->mag_count);
+	return added;
+}
+
+/* Take a page from this cpu's magazine */
+static struct page *
+_kgsl_pool_mag_get(struct kgsl_page_pool *pool)
+{
+	struct kgsl_pool_magazine *mag;
+	struct page *p = NULL;
+
+	if (pool->mag == NULL)
+		return NULL;
+
+	mag = get_cpu_ptr(pool->mag);
+	spin_lock(&mag->lock);
+	if (mag->count)
+		p = mag->pages[--mag->count];
+	spin_unlock(&mag->lock);
+	put_cpu_ptr(pool->mag);
+
+	if (p != NULL)
+		atomic_dec(&pool->mag_count);
+	return p;
+}
+
+/* Move every magazine's pages back on the pool list */
 static void
-_kgsl_pool_add_page(struct kgsl_page_pool *pool, struct page *p)
+_kgsl_pool_mag_drain(struct kgsl_page_pool *pool)
+{
+	int cpu;
+
+	if (pool->mag == NULL)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct kgsl_pool_magazine *mag = per_cpu_ptr(pool->mag, cpu);
+
+		spin_lock(&mag->lock);
+		while (mag->count) {
+			struct page *p = mag->pages[--mag->count];
+
+			atomic_dec(&pool->mag_count);
+			spin_lock(&pool->list_lock);
+			list_add_tail(&p->lru, &pool->page_list);
+			pool->page_count++;
+			spin_unlock(&pool->list_lock);
+		}
+		spin_unlock(&mag->lock);
+	}
+}
+
+/*
+ * Add a page to specified pool. Freed pages go to the local magazine
+ * first, pages from the refill thread go straight to the shared list.
+ */
+static void
+__kgsl_pool_add_page(struct kgsl_page_pool *pool, struct page *p,
+		bool local)
 {
 	_kgsl_pool_zero_page(p, pool->pool_order);
 
+	mod_node_page_state(page_pgdat(p), NR_INDIRECTLY_RECLAIMABLE_BYTES,
+				(PAGE_SIZE << pool->pool_order));
+
+	if (local && _kgsl_pool_mag_put(pool, p))
+		return;
+
 	spin_lock(&pool->list_lock);
 	list_add_tail(&p->lru, &pool->page_list);
 	pool->page_count++;
 	spin_unlock(&pool->list_lock);
-	mod_node_page_state(page_pgdat(p), NR_INDIRECTLY_RECLAIMABLE_BYTES,
-				(PAGE_SIZE << pool->pool_order));
+}
+
+static void
+_kgsl_pool_add_page(struct kgsl_page_pool *pool, struct page *p)
+{
+	__kgsl_pool_add_page(pool, p, false);
 }
 
 /* Returns a page from specified pool */
 static struct page *
 _kgsl_pool_get_page(struct kgsl_page_pool *pool)
 {
-	struct page *p = NULL;
-
-	spin_lock(&pool->list_lock);
-	if (pool->page_count) {
-		p = list_first_entry(&pool->page_list, struct page, lru);
-		pool->page_count--;
-		list_del(&p->lru);
+	struct page *p = _kgsl_pool_mag_get(pool);
+
+	if (p == NULL) {
+		spin_lock(&pool->list_lock);
+		if (pool->page_count) {
+			p = list_first_entry(&pool->page_list, struct page,
+					lru);
+			pool->page_count--;
+			list_del(&p->lru);
+		}
+		spin_unlock(&pool->list_lock);
 	}
-	spin_unlock(&pool->list_lock);
 
 	if (p != NULL)
 		mod_node_page_state(page_pgdat(p),
@@ -121,10 +254,35 @@ kgsl_pool_size(struct kgsl_page_pool *kgsl_pool)
 	int size;
 
 	spin_lock(&kgsl_pool->list_lock);
-	size = kgsl_pool->page_count * (1 << kgsl_pool->pool_order);
+	size = kgsl_pool->page_count + atomic_read(&kgsl_pool->mag_count);
 	spin_unlock(&kgsl_pool->list_lock);
 
-	return size;
+	return size * (1 << kgsl_pool->pool_order);
+}
+
+/* Lockless count of pool entries, good enough for watermark checks */
+static unsigned int
+kgsl_pool_entries(struct kgsl_page_pool *pool)
+{
+	return READ_ONCE(pool->page_count) + atomic_read(&pool->mag_count);
+}
+
+/* Record an allocation and kick the refill thread if the pool runs low */
+static void
+kgsl_pool_note_alloc(struct kgsl_page_pool *pool)
+{
+	atomic_inc(&pool->alloc_count);
+
+	if (!pool->allocation_allowed || kgsl_pool_refill_task == NULL)
+		return;
+
+	if (kgsl_pool_entries(pool) > READ_ONCE(pool->target) / 2)
+		return;
+
+	if (!READ_ONCE(kgsl_pool_refill_pending)) {
+		WRITE_ONCE(kgsl_pool_refill_pending, true);
+		wake_up(&kgsl_pool_refill_wq);
+	}
 }
 
 /* Returns the number of pages in all kgsl page pools */
@@ -197,6 +355,8 @@ kgsl_pool_reduce(unsigned int target_pages, bool exit)
 		if (!pool->allocation_allowed && !exit)
 			continue;
 
+		_kgsl_pool_mag_drain(pool);
+
 		total_pages -= pcount;
 
 		nr_removed = total_pages - target_pages;
@@ -362,6 +522,7 @@ int kgsl_pool_alloc_page(int *page_size, struct page **pages,
 
 	pool_idx = kgsl_pool_idx_lookup(order);
 	page = _kgsl_pool_get_page(pool);
+	kgsl_pool_note_alloc(pool);
 
 	/* Allocate a new page if not allocated from pool */
 	if (page == NULL) {
@@ -374,10 +535,22 @@ int kgsl_pool_alloc_page(int *page_size, struct page **pages,
 			goto eagain;
 		}
 
+		/*
+		 * The buddy allocator failed this order recently, go to the
+		 * smaller pool and leave this one to the refill thread
+		 */
+		if (pool_idx > 0 && time_before(jiffies,
+				READ_ONCE(pool->highorder_backoff))) {
+			size = PAGE_SIZE << kgsl_pools[pool_idx-1].pool_order;
+			goto eagain;
+		}
+
 		page = alloc_pages(gfp_mask, order);
 
 		if (!page) {
 			if (pool_idx > 0) {
+				WRITE_ONCE(pool->highorder_backoff, jiffies +
+					KGSL_POOL_HIGHORDER_BACKOFF);
 				/* Retry with lower order pages */
 				size = PAGE_SIZE <<
 					kgsl_pools[pool_idx-1].pool_order;
@@ -424,7 +597,7 @@ void kgsl_pool_free_page(struct page *page)
 			(kgsl_pool_size_total() < kgsl_pool_max_pages)) {
 		pool = _kgsl_get_pool_from_order(page_order);
 		if (pool != NULL) {
-			_kgsl_pool_add_page(pool, page);
+			__kgsl_pool_add_page(pool, page, true);
 			return;
 		}
 	}
@@ -481,6 +654,13 @@ kgsl_pool_shrink_scan_objects(struct shrinker *shrinker,
 
 	/* Target pages represents new  pool size */
 	int target_pages = (nr > total_pages) ? 0 : (total_pages - nr);
+	int i;
+
+	/* Forget the allocation history and stop refilling for a while */
+	WRITE_ONCE(kgsl_pool_pressure_until,
+			jiffies + KGSL_POOL_PRESSURE_BACKOFF);
+	for (i = 0; i < kgsl_num_pools; i++)
+		WRITE_ONCE(kgsl_pools[i].target, kgsl_pools[i].reserved_pages);
 
 	/* Reduce pool size to target_pages */
 	return kgsl_pool_reduce(target_pages, false);
@@ -502,6 +682,100 @@ static struct shrinker kgsl_pool_shrinker = {
 	.batch = 0,
 };
 
+static void kgsl_pool_init_magazines(struct kgsl_page_pool *pool)
+{
+	int cpu;
+
+	if (pool->pool_order > KGSL_POOL_MAG_MAX_ORDER)
+		return;
+
+	pool->mag = alloc_percpu(struct kgsl_pool_magazine);
+	if (pool->mag == NULL)
+		return;
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(pool->mag, cpu)->lock);
+
+	pool->mag_size = max(1, KGSL_POOL_MAG_PAGES >> pool->pool_order);
+}
+
+/*
+ * Move the pool target toward the demand seen since the last run:
+ * follow bursts right away, decay slowly when allocations calm down.
+ */
+static void kgsl_pool_update_target(struct kgsl_page_pool *pool)
+{
+	unsigned int demand = atomic_xchg(&pool->alloc_count, 0);
+	unsigned int max_target = max_t(unsigned int, pool->reserved_pages,
+			KGSL_POOL_TARGET_MAX_PAGES >> pool->pool_order);
+	unsigned int target = READ_ONCE(pool->target);
+
+	if (demand > target)
+		target = demand;
+	else
+		target = (target * 3 + demand) / 4;
+
+	WRITE_ONCE(pool->target, clamp(target, pool->reserved_pages,
+				max_target));
+}
+
+static void kgsl_pool_refill(struct kgsl_page_pool *pool)
+{
+	unsigned int order = pool->pool_order;
+
+	if (!pool->allocation_allowed)
+		return;
+
+	kgsl_pool_update_target(pool);
+
+	while (kgsl_pool_entries(pool) < READ_ONCE(pool->target)) {
+		struct page *page;
+
+		if (time_before(jiffies, READ_ONCE(kgsl_pool_pressure_until)))
+			break;
+
+		if (kgsl_pool_max_pages &&
+			kgsl_pool_size_total() >= kgsl_pool_max_pages)
+			break;
+
+		page = alloc_pages(kgsl_gfp_mask(order) | __GFP_NOWARN, order);
+		if (page == NULL) {
+			if (order > 0)
+				WRITE_ONCE(pool->highorder_backoff, jiffies +
+					KGSL_POOL_HIGHORDER_BACKOFF);
+			break;
+		}
+
+		_kgsl_pool_add_page(pool, page);
+		cond_resched();
+	}
+}
+
+/*
+ * Keep the pools at their targets from the background so that bursts of
+ * GPU allocations, like texture uploads at game load, find pages ready
+ * instead of stalling in the buddy allocator.
+ */
+static int kgsl_pool_refill_thread(void *data)
+{
+	int i;
+
+	set_freezable();
+
+	while (!kthread_should_stop()) {
+		wait_event_freezable(kgsl_pool_refill_wq,
+			READ_ONCE(kgsl_pool_refill_pending) ||
+			kthread_should_stop());
+
+		WRITE_ONCE(kgsl_pool_refill_pending, false);
+
+		for (i = 0; i < kgsl_num_pools; i++)
+			kgsl_pool_refill(&kgsl_pools[i]);
+	}
+
+	return 0;
+}
+
 static void kgsl_pool_config(unsigned int order, unsigned int reserved_pages,
 		bool allocation_allowed)
 {
@@ -518,8 +792,10 @@ static void kgsl_pool_config(unsigned int order, unsigned int reserved_pages,
 	kgsl_pools[kgsl_num_pools].pool_order = order;
 	kgsl_pools[kgsl_num_pools].reserved_pages = reserved_pages;
 	kgsl_pools[kgsl_num_pools].allocation_allowed = allocation_allowed;
+	kgsl_pools[kgsl_num_pools].target = reserved_pages;
 	spin_lock_init(&kgsl_pools[kgsl_num_pools].list_lock);
 	INIT_LIST_HEAD(&kgsl_pools[kgsl_num_pools].page_list);
+	kgsl_pool_init_magazines(&kgsl_pools[kgsl_num_pools]);
 	kgsl_num_pools++;
 }
 
@@ -577,14 +853,37 @@ void kgsl_init_page_pools(struct platform_device *pdev)
 
 	/* Initialize shrinker */
 	register_shrinker(&kgsl_pool_shrinker);
+
+	if (kgsl_num_pools) {
+		struct task_struct *task;
+
+		task = kthread_run(kgsl_pool_refill_thread, NULL,
+				"kgsl_pool_refill");
+		if (IS_ERR(task))
+			pr_err("kgsl: unable to start pool refill thread\n");
+		else
+			kgsl_pool_refill_task = task;
+	}
 }
 
 void kgsl_exit_page_pools(void)
 {
+	int i;
+
+	if (kgsl_pool_refill_task != NULL) {
+		kthread_stop(kgsl_pool_refill_task);
+		kgsl_pool_refill_task = NULL;
+	}
+
 	/* Release all pages in pools, if any.*/
 	kgsl_pool_reduce(0, true);
 
 	/* Unregister shrinker */
 	unregister_shrinker(&kgsl_pool_shrinker);
+
+	for (i = 0; i < kgsl_num_pools; i++) {
+		free_percpu(kgsl_pools[i].mag);
+		kgsl_pools[i].mag = NULL;
+	}
 }
 
@@ -16,6 +16,7 @@
 #include <linux/hrtimer.h>
 #include <linux/devfreq_cooling.h>
 #include <linux/pm_opp.h>
+#include <linux/math64.h>
 
 #include "kgsl.h"
 #include "kgsl_pwrscale.h"
@@ -33,6 +34,9 @@
 #define MIN_SLEEP_PERIODS	3
 #define MIN_SLEEP_PERCENT	5
 
+/* Frame hints older than this are ignored and the governor runs as usual */
+#define KGSL_FRAME_HINT_TIMEOUT_US	100000
+
 static struct kgsl_popp popp_param[POPP_MAX] = {
 	{0, 0},
 	{-5, 20},
@@ -153,6 +157,14 @@ void kgsl_pwrscale_update_stats(struct kgsl_device *device)
 		struct kgsl_power_stats stats;
 
 		device->ftbl->power_stats(device, &stats);
+
+		/* Only busy time spent on an outstanding frame counts */
+		spin_lock(&psc->frame.lock);
+		if (ktime_to_ns(psc->frame.deadline))
+			psc->frame.cycles += stats.busy_time *
+				(kgsl_pwrctrl_active_freq(pwrctrl) / 1000000);
+		spin_unlock(&psc->frame.lock);
+
 		if (psc->popp_level) {
 			u64 x = stats.busy_time;
 			u64 y = stats.ram_time;
@@ -589,6 +601,111 @@ int kgsl_devfreq_target(struct device *dev, unsigned long *freq, u32 flags)
 }
 EXPORT_SYMBOL(kgsl_devfreq_target);
 
+/* The frame a deadline was set for has retired */
+static void kgsl_pwrscale_frame_done(struct kgsl_device *device,
+		struct kgsl_event_group *group, void *priv, int result)
+{
+	struct kgsl_frame_hint *frame = &device->pwrscale.frame;
+
+	spin_lock(&frame->lock);
+	if (result == KGSL_EVENT_RETIRED) {
+		if (frame->frame_cycles)
+			frame->frame_cycles = (frame->frame_cycles * 3 +
+				frame->cycles) / 4;
+		else
+			frame->frame_cycles = frame->cycles;
+		frame->cycles = 0;
+	}
+
+	/* Leave the deadline alone if a newer frame has already set one */
+	if (frame->seq == (unsigned long) priv)
+		frame->deadline = 0;
+	spin_unlock(&frame->lock);
+}
+
+/**
+ * kgsl_pwrscale_frame_deadline() - Set the deadline for a submitted frame
+ * @device: The device
+ * @context: Context the frame was submitted on
+ * @timestamp: Timestamp that completes the frame
+ * @deadline: CLOCK_MONOTONIC time in ns the frame should be done by
+ *
+ * The governor picks the lowest frequency that retires the average frame
+ * workload before @deadline, for as long as userspace keeps sending hints.
+ */
+int kgsl_pwrscale_frame_deadline(struct kgsl_device *device,
+		struct kgsl_context *context, unsigned int timestamp,
+		u64 deadline)
+{
+	struct kgsl_pwrscale *psc = &device->pwrscale;
+	unsigned long seq;
+	int ret;
+
+	if (!psc->enabled)
+		return 0;
+
+	spin_lock(&psc->frame.lock);
+	/*
+	 * Start counting afresh if no frame was outstanding, otherwise the
+	 * work done between hints would be billed to this frame.
+	 */
+	if (ktime_to_ns(psc->frame.deadline) == 0)
+		psc->frame.cycles = 0;
+	seq = ++psc->frame.seq;
+	psc->frame.deadline = ns_to_ktime(deadline);
+	psc->frame.last_hint = ktime_get();
+	spin_unlock(&psc->frame.lock);
+
+	ret = kgsl_add_event(device, &context->events, timestamp,
+		kgsl_pwrscale_frame_done, (void *) seq);
+	if (ret) {
+		spin_lock(&psc->frame.lock);
+		if (psc->frame.seq == seq)
+			psc->frame.deadline = 0;
+		spin_unlock(&psc->frame.lock);
+		return ret;
+	}
+
+	/* Let the governor see the new deadline right away */
+	queue_work(psc->devfreq_wq, &psc->devfreq_notify_ws);
+
+	return 0;
+}
+EXPORT_SYMBOL(kgsl_pwrscale_frame_deadline);
+
+/*
+ * Work out the frequency that finishes what is left of the average frame
+ * before the pending deadline. Return 0 when there is no usable hint.
+ */
+static unsigned long kgsl_pwrscale_deadline_freq(struct kgsl_pwrscale *psc)
+{
+	struct kgsl_frame_hint *frame = &psc->frame;
+	ktime_t now = ktime_get();
+	unsigned long freq = 0;
+	u64 remaining;
+	s64 left;
+
+	spin_lock(&frame->lock);
+
+	if (ktime_us_delta(now, frame->last_hint) > KGSL_FRAME_HINT_TIMEOUT_US ||
+			frame->frame_cycles == 0 ||
+			ktime_to_ns(frame->deadline) == 0)
+		goto out;
+
+	remaining = frame->frame_cycles > frame->cycles ?
+		frame->frame_cycles - frame->cycles : 0;
+	left = ktime_us_delta(frame->deadline, now);
+
+	/* Already late, go as fast as we can */
+	if (left <= 0)
+		freq = ULONG_MAX;
+	else
+		freq = max_t(u64, div64_u64(remaining * USEC_PER_SEC, left), 1);
+out:
+	spin_unlock(&frame->lock);
+	return freq;
+}
+
 /*
  * kgsl_devfreq_get_dev_status - devfreq_dev_profile.get_dev_status callback
  * @dev: see devfreq.h
@@ -633,6 +750,9 @@ int kgsl_devfreq_get_dev_status(struct device *dev,
 
 	stat->private_data = &device->active_context_count;
 
+	pwrscale->gpu_profile.private_data->deadline_freq =
+		kgsl_pwrscale_deadline_freq(pwrscale);
+
 	/*
 	 * keep the latest devfreq_dev_status values
 	 * and vbif counters data
@@ -930,6 +1050,8 @@ int kgsl_pwrscale_init(struct device *dev, const char *governor)
 	if (profile->max_state == 1)
 		governor = "performance";
 
+	spin_lock_init(&pwrscale->frame.lock);
+
 	/* initialize msm-adreno-tz governor specific data here */
 	data = gpu_profile->private_data;
 
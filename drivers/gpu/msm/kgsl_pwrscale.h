@@ -68,6 +68,24 @@ struct kgsl_pwr_history {
 	unsigned int size;
 };
 
+/**
+ * struct kgsl_frame_hint - Frame deadline state for the GPU governor
+ * @lock - Protects the fields below
+ * @deadline - When the pending frame has to be done, 0 if none is pending
+ * @last_hint - When userspace last sent a deadline
+ * @frame_cycles - Running average of GPU busy cycles per frame
+ * @cycles - GPU busy cycles spent on the outstanding frames
+ * @seq - Incremented for every hint, tells stale frame callbacks apart
+ */
+struct kgsl_frame_hint {
+	spinlock_t lock;
+	ktime_t deadline;
+	ktime_t last_hint;
+	u64 frame_cycles;
+	u64 cycles;
+	unsigned long seq;
+};
+
 /**
  * struct kgsl_pwrscale - Power scaling settings for a KGSL device
  * @devfreqptr - Pointer to the devfreq device
@@ -96,6 +114,7 @@ struct kgsl_pwr_history {
  * ctxt aware power level jump
  * @ctxt_aware_target_pwrlevel - pwrlevel to jump on in case of ctxt aware
  * power level jump
+ * @frame - Frame deadline hints from userspace
  */
 struct kgsl_pwrscale {
 	struct devfreq *devfreqptr;
@@ -121,8 +140,11 @@ struct kgsl_pwrscale {
 	bool ctxt_aware_enable;
 	unsigned int ctxt_aware_target_pwrlevel;
 	unsigned int ctxt_aware_busy_penalty;
+	struct kgsl_frame_hint frame;
 };
 
+struct kgsl_context;
+
 int kgsl_pwrscale_init(struct device *dev, const char *governor);
 void kgsl_pwrscale_close(struct kgsl_device *device);
 
@@ -138,6 +160,10 @@ void kgsl_pwrscale_midframe_timer_cancel(struct kgsl_device *device);
 void kgsl_pwrscale_enable(struct kgsl_device *device);
 void kgsl_pwrscale_disable(struct kgsl_device *device, bool turbo);
 
+int kgsl_pwrscale_frame_deadline(struct kgsl_device *device,
+		struct kgsl_context *context, unsigned int timestamp,
+		u64 deadline);
+
 int kgsl_devfreq_target(struct device *dev, unsigned long *freq, u32 flags);
 int kgsl_devfreq_get_dev_status(struct device *dev,
 			struct devfreq_dev_status *stat);
@@ -159,11 +159,33 @@ gpumem_unmapped_show(struct kgsl_process_private *priv, int type, char *buf)
 			priv->stats[type].cur - priv->gpumem_mapped);
 }
 
+static ssize_t
+gpu_ticks_show(struct kgsl_process_private *priv, int type, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%lld\n",
+			atomic64_read(&priv->gpu_ticks));
+}
+
+/* The memtype slot holds the kgsl_gpu_stat index for these */
+static ssize_t
+gpu_stat_show(struct kgsl_process_private *priv, int type, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%lld\n",
+			atomic64_read(&priv->gpu_stats[type]));
+}
+
 static struct kgsl_mem_entry_attribute debug_memstats[] = {
 	__MEM_ENTRY_ATTR(0, imported_mem, imported_mem_show),
 	__MEM_ENTRY_ATTR(0, gpumem_mapped, gpumem_mapped_show),
 	__MEM_ENTRY_ATTR(KGSL_MEM_ENTRY_KERNEL, gpumem_unmapped,
 				gpumem_unmapped_show),
+	__MEM_ENTRY_ATTR(0, gpu_ticks, gpu_ticks_show),
+	__MEM_ENTRY_ATTR(KGSL_GPU_STAT_BUSY, gpu_busy, gpu_stat_show),
+	__MEM_ENTRY_ATTR(KGSL_GPU_STAT_RAM_STALL, gpu_ram_stall,
+				gpu_stat_show),
+	__MEM_ENTRY_ATTR(KGSL_GPU_STAT_RAM_READ, gpu_ram_read, gpu_stat_show),
+	__MEM_ENTRY_ATTR(KGSL_GPU_STAT_RAM_WRITE, gpu_ram_write,
+				gpu_stat_show),
 };
 
 /**
@@ -26,11 +26,48 @@ static void kgsl_sync_timeline_signal(struct kgsl_sync_timeline *timeline,
 
 static const struct dma_fence_ops kgsl_sync_fence_ops;
 
+static struct kmem_cache *kgsl_sync_fence_cache;
+static struct kmem_cache *kgsl_sync_fence_cb_cache;
+
+/*
+ * Look for a fence on the timeline that already has an event pending for
+ * @timestamp and take a reference to it. Userspace often asks for several
+ * fences on the same timestamp (one per buffer in a frame); those can all
+ * share one fence and one event.
+ */
+static struct kgsl_sync_fence *kgsl_sync_fence_find(
+		struct kgsl_sync_timeline *ktimeline, unsigned int timestamp)
+{
+	struct kgsl_sync_fence *kfence, *ret = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ktimeline->lock, flags);
+	list_for_each_entry_reverse(kfence, &ktimeline->child_list_head,
+			child_list) {
+		if (timestamp_cmp(kfence->timestamp, timestamp) < 0)
+			break;
+
+		if (kfence->timestamp == timestamp && kfence->armed) {
+			ret = kfence;
+			dma_fence_get(&ret->fence);
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&ktimeline->lock, flags);
+
+	return ret;
+}
+
+/*
+ * Create a new fence and add it to the timeline. The child list is kept in
+ * timestamp order so that signaling can stop at the first pending fence.
+ * The caller gets a reference in addition to the one owned by the list.
+ */
 static struct kgsl_sync_fence *kgsl_sync_fence_create(
 					struct kgsl_context *context,
 					unsigned int timestamp)
 {
-	struct kgsl_sync_fence *kfence;
+	struct kgsl_sync_fence *kfence, *pos;
 	struct kgsl_sync_timeline *ktimeline = context->ktimeline;
 	unsigned long flags;
 
@@ -38,7 +75,7 @@ static struct kgsl_sync_fence *kgsl_sync_fence_create(
 	if (!kref_get_unless_zero(&ktimeline->kref))
 		return NULL;
 
-	kfence = kzalloc(sizeof(*kfence), GFP_KERNEL);
+	kfence = kmem_cache_zalloc(kgsl_sync_fence_cache, GFP_KERNEL);
 	if (kfence == NULL) {
 		kgsl_sync_timeline_put(ktimeline);
 		KGSL_DRV_ERR(context->device, "Couldn't allocate fence\n");
@@ -51,22 +88,15 @@ static struct kgsl_sync_fence *kgsl_sync_fence_create(
 
 	dma_fence_init(&kfence->fence, &kgsl_sync_fence_ops, &ktimeline->lock,
 		ktimeline->fence_context, timestamp);
-
-	/*
-	 * sync_file_create() takes a refcount to the fence. This refcount is
-	 * put when the fence is signaled.
-	 */
-	kfence->sync_file = sync_file_create(&kfence->fence);
-
-	if (kfence->sync_file == NULL) {
-		kgsl_sync_timeline_put(ktimeline);
-		KGSL_DRV_ERR(context->device, "Create sync_file failed\n");
-		kfree(kfence);
-		return NULL;
-	}
+	dma_fence_get(&kfence->fence);
 
 	spin_lock_irqsave(&ktimeline->lock, flags);
-	list_add_tail(&kfence->child_list, &ktimeline->child_list_head);
+	list_for_each_entry_reverse(pos, &ktimeline->child_list_head,
+			child_list) {
+		if (timestamp_cmp(pos->timestamp, timestamp) <= 0)
+			break;
+	}
+	list_add(&kfence->child_list, &pos->child_list);
 	spin_unlock_irqrestore(&ktimeline->lock, flags);
 
 	return kfence;
@@ -77,7 +107,7 @@ static void kgsl_sync_fence_release(struct dma_fence *fence)
 	struct kgsl_sync_fence *kfence = (struct kgsl_sync_fence *)fence;
 
 	kgsl_sync_timeline_put(kfence->parent);
-	kfree(kfence);
+	kmem_cache_free(kgsl_sync_fence_cache, kfence);
 }
 
 /* Called with ktimeline->lock held */
@@ -95,11 +125,6 @@ bool kgsl_enable_signaling(struct dma_fence *fence)
 	return !kgsl_sync_fence_has_signaled(fence);
 }
 
-struct kgsl_sync_fence_event_priv {
-	struct kgsl_context *context;
-	unsigned int timestamp;
-};
-
 /**
  * kgsl_sync_fence_event_cb - Event callback for a fence timestamp event
  * @device - The KGSL device that expired the timestamp
@@ -113,44 +138,37 @@ struct kgsl_sync_fence_event_priv {
 static void kgsl_sync_fence_event_cb(struct kgsl_device *device,
 		struct kgsl_event_group *group, void *priv, int result)
 {
-	struct kgsl_sync_fence_event_priv *ev = priv;
+	struct kgsl_sync_fence *kfence = priv;
 
-	kgsl_sync_timeline_signal(ev->context->ktimeline, ev->timestamp);
-	kgsl_context_put(ev->context);
-	kfree(ev);
+	kgsl_sync_timeline_signal(kfence->parent, kfence->timestamp);
+	dma_fence_put(&kfence->fence);
 }
 
+/*
+ * The event holds a reference to the fence, which in turn keeps the timeline
+ * and the context alive until the callback has run.
+ */
 static int _add_fence_event(struct kgsl_device *device,
-	struct kgsl_context *context, unsigned int timestamp)
+	struct kgsl_context *context, struct kgsl_sync_fence *kfence)
 {
-	struct kgsl_sync_fence_event_priv *event;
+	unsigned long flags;
 	int ret;
 
-	event = kmalloc(sizeof(*event), GFP_KERNEL);
-	if (event == NULL)
-		return -ENOMEM;
+	dma_fence_get(&kfence->fence);
 
-	/*
-	 * Increase the refcount for the context to keep it through the
-	 * callback
-	 */
-	if (!_kgsl_context_get(context)) {
-		kfree(event);
-		return -ENOENT;
-	}
-
-	event->context = context;
-	event->timestamp = timestamp;
-
-	ret = kgsl_add_event(device, &context->events, timestamp,
-		kgsl_sync_fence_event_cb, event);
+	ret = kgsl_add_event(device, &context->events, kfence->timestamp,
+		kgsl_sync_fence_event_cb, kfence);
 
 	if (ret) {
-		kgsl_context_put(context);
-		kfree(event);
+		dma_fence_put(&kfence->fence);
+		return ret;
 	}
 
-	return ret;
+	spin_lock_irqsave(&kfence->parent->lock, flags);
+	kfence->armed = true;
+	spin_unlock_irqrestore(&kfence->parent->lock, flags);
+
+	return 0;
 }
 
 /* Only to be used if creating a related event failed */
@@ -184,6 +202,8 @@ int kgsl_add_fence_event(struct kgsl_device *device,
 	struct kgsl_timestamp_event_fence priv;
 	struct kgsl_context *context;
 	struct kgsl_sync_fence *kfence = NULL;
+	struct sync_file *sync_file = NULL;
+	bool shared = false;
 	int ret = -EINVAL;
 	unsigned int cur;
 
@@ -200,7 +220,12 @@ int kgsl_add_fence_event(struct kgsl_device *device,
 	if (test_bit(KGSL_CONTEXT_PRIV_INVALID, &context->priv))
 		goto out;
 
-	kfence = kgsl_sync_fence_create(context, timestamp);
+	kfence = kgsl_sync_fence_find(context->ktimeline, timestamp);
+	if (kfence != NULL)
+		shared = true;
+	else
+		kfence = kgsl_sync_fence_create(context, timestamp);
+
 	if (kfence == NULL) {
 		KGSL_DRV_CRIT_RATELIMIT(device,
 					"kgsl_sync_fence_create failed\n");
@@ -208,6 +233,17 @@ int kgsl_add_fence_event(struct kgsl_device *device,
 		goto out;
 	}
 
+	/*
+	 * sync_file_create() takes a refcount to the fence which is put when
+	 * the sync_file is released.
+	 */
+	sync_file = sync_file_create(&kfence->fence);
+	if (sync_file == NULL) {
+		KGSL_DRV_ERR(device, "Create sync_file failed\n");
+		ret = -ENOMEM;
+		goto out;
+	}
+
 	priv.fence_fd = get_unused_fd_flags(0);
 	if (priv.fence_fd < 0) {
 		KGSL_DRV_CRIT_RATELIMIT(device,
@@ -220,7 +256,8 @@ int kgsl_add_fence_event(struct kgsl_device *device,
 	/*
 	 * If the timestamp hasn't expired yet create an event to trigger it.
 	 * Otherwise, just signal the fence - there is no reason to go through
-	 * the effort of creating a fence we don't need.
+	 * the effort of creating a fence we don't need. A shared fence already
+	 * has its event.
 	 */
 
 	kgsl_readtimestamp(device, context, KGSL_TIMESTAMP_RETIRED, &cur);
@@ -228,8 +265,8 @@ int kgsl_add_fence_event(struct kgsl_device *device,
 	if (timestamp_cmp(cur, timestamp) >= 0) {
 		ret = 0;
 		kgsl_sync_timeline_signal(context->ktimeline, cur);
-	} else {
-		ret = _add_fence_event(device, context, timestamp);
+	} else if (!shared) {
+		ret = _add_fence_event(device, context, kfence);
 		if (ret)
 			goto out;
 	}
@@ -238,7 +275,7 @@ int kgsl_add_fence_event(struct kgsl_device *device,
 		ret = -EFAULT;
 		goto out;
 	}
-	fd_install(priv.fence_fd, kfence->sync_file->file);
+	fd_install(priv.fence_fd, sync_file->file);
 
 out:
 	kgsl_context_put(context);
@@ -246,15 +283,18 @@ int kgsl_add_fence_event(struct kgsl_device *device,
 		if (priv.fence_fd >= 0)
 			put_unused_fd(priv.fence_fd);
 
-		if (kfence) {
+		/* An armed fence may be shared; its event will retire it */
+		if (kfence && !kfence->armed)
 			kgsl_sync_cancel(kfence);
-			/*
-			 * Put the refcount of sync file. This will release
-			 * kfence->fence as well.
-			 */
-			fput(kfence->sync_file->file);
-		}
+
+		/* Put the refcount of sync file */
+		if (sync_file)
+			fput(sync_file->file);
 	}
+
+	if (kfence)
+		dma_fence_put(&kfence->fence);
+
 	return ret;
 }
 
@@ -378,12 +418,14 @@ static void kgsl_sync_timeline_signal(struct kgsl_sync_timeline *ktimeline,
 	if (timestamp_cmp(timestamp, ktimeline->last_timestamp) > 0)
 		ktimeline->last_timestamp = timestamp;
 
+	/* The list is in timestamp order so stop at the first pending fence */
 	list_for_each_entry_safe(kfence, next, &ktimeline->child_list_head,
 				child_list) {
-		if (dma_fence_is_signaled_locked(&kfence->fence)) {
-			list_del_init(&kfence->child_list);
-			dma_fence_put(&kfence->fence);
-		}
+		if (!dma_fence_is_signaled_locked(&kfence->fence))
+			break;
+
+		list_del_init(&kfence->child_list);
+		dma_fence_put(&kfence->fence);
 	}
 
 	spin_unlock_irqrestore(&ktimeline->lock, flags);
@@ -413,12 +455,32 @@ void kgsl_sync_timeline_put(struct kgsl_sync_timeline *ktimeline)
 		kref_put(&ktimeline->kref, kgsl_sync_timeline_release);
 }
 
+/*
+ * In-kernel waiters (the display driver waiting on a GPU release fence, for
+ * example) can poll the memstore for a short while before falling back to
+ * the default sleeping wait.
+ */
+static signed long kgsl_sync_fence_wait(struct dma_fence *fence, bool intr,
+		signed long timeout)
+{
+	struct kgsl_sync_fence *kfence = (struct kgsl_sync_fence *)fence;
+	struct kgsl_sync_timeline *ktimeline = kfence->parent;
+
+	if (ktimeline->device && kgsl_spin_for_timestamp(ktimeline->device,
+			ktimeline->context, kfence->timestamp)) {
+		kgsl_sync_timeline_signal(ktimeline, kfence->timestamp);
+		return timeout ? timeout : 1;
+	}
+
+	return dma_fence_default_wait(fence, intr, timeout);
+}
+
 static const struct dma_fence_ops kgsl_sync_fence_ops = {
 	.get_driver_name = kgsl_sync_fence_driver_name,
 	.get_timeline_name = kgsl_sync_timeline_name,
 	.enable_signaling = kgsl_enable_signaling,
 	.signaled = kgsl_sync_fence_has_signaled,
-	.wait = dma_fence_default_wait,
+	.wait = kgsl_sync_fence_wait,
 	.release = kgsl_sync_fence_release,
 
 	.fence_value_str = kgsl_sync_fence_value_str,
@@ -436,7 +498,7 @@ static void kgsl_sync_fence_callback(struct dma_fence *fence,
 	 */
 	if (kcb->func(kcb->priv)) {
 		dma_fence_put(kcb->fence);
-		kfree(kcb);
+		kmem_cache_free(kgsl_sync_fence_cb_cache, kcb);
 	}
 }
 
@@ -498,7 +560,7 @@ struct kgsl_sync_fence_cb *kgsl_sync_fence_async_wait(int fd,
 		return ERR_PTR(-EINVAL);
 
 	/* create the callback */
-	kcb = kzalloc(sizeof(*kcb), GFP_ATOMIC);
+	kcb = kmem_cache_zalloc(kgsl_sync_fence_cb_cache, GFP_ATOMIC);
 	if (kcb == NULL) {
 		dma_fence_put(fence);
 		return ERR_PTR(-ENOMEM);
@@ -515,7 +577,7 @@ struct kgsl_sync_fence_cb *kgsl_sync_fence_async_wait(int fd,
 				kgsl_sync_fence_callback);
 
 	if (status) {
-		kfree(kcb);
+		kmem_cache_free(kgsl_sync_fence_cb_cache, kcb);
 		if (!dma_fence_is_signaled(fence))
 			kcb = ERR_PTR(status);
 		else
@@ -543,7 +605,7 @@ void kgsl_sync_fence_async_cancel(struct kgsl_sync_fence_cb *kcb)
 	 */
 	dma_fence_remove_callback(kcb->fence, &kcb->fence_cb);
 	dma_fence_put(kcb->fence);
-	kfree(kcb);
+	kmem_cache_free(kgsl_sync_fence_cb_cache, kcb);
 }
 
 struct kgsl_syncsource {
@@ -900,3 +962,26 @@ static const struct dma_fence_ops kgsl_syncsource_fence_ops = {
 	.fence_value_str = kgsl_syncsource_fence_value_str,
 };
 
+
+/**
+ * kgsl_sync_exit() - Destroy the fence kmem caches on module exit
+ */
+void kgsl_sync_exit(void)
+{
+	kmem_cache_destroy(kgsl_sync_fence_cache);
+	kmem_cache_destroy(kgsl_sync_fence_cb_cache);
+}
+
+/**
+ * kgsl_sync_init() - Create the fence kmem caches on module start
+ */
+int __init kgsl_sync_init(void)
+{
+	kgsl_sync_fence_cache = KMEM_CACHE(kgsl_sync_fence, 0);
+	kgsl_sync_fence_cb_cache = KMEM_CACHE(kgsl_sync_fence_cb, 0);
+
+	if (!kgsl_sync_fence_cache || !kgsl_sync_fence_cb_cache)
+		return -ENOMEM;
+
+	return 0;
+}
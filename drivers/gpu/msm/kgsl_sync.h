@@ -48,19 +48,20 @@ struct kgsl_sync_timeline {
  * struct kgsl_sync_fence - A struct containing a fence and other data
  *				associated with it
  * @fence: The fence struct
- * @sync_file: Pointer to the sync file
  * @parent: Pointer to the kgsl sync timeline this fence is on
- * @child_list: List of fences on the same timeline
+ * @child_list: List of fences on the same timeline, in timestamp order
  * @context_id: kgsl context id
  * @timestamp: Context timestamp that this fence is associated with
+ * @armed: A timestamp event is registered for this fence, so it can be shared
+ * by later requests for the same timestamp
  */
 struct kgsl_sync_fence {
 	struct dma_fence fence;
-	struct sync_file *sync_file;
 	struct kgsl_sync_timeline *parent;
 	struct list_head child_list;
 	u32 context_id;
 	unsigned int timestamp;
+	bool armed;
 };
 
 /**
@@ -81,6 +82,10 @@ struct kgsl_sync_fence_cb {
 struct kgsl_syncsource;
 
 #if defined(CONFIG_SYNC_FILE)
+int kgsl_sync_init(void);
+
+void kgsl_sync_exit(void);
+
 int kgsl_add_fence_event(struct kgsl_device *device,
 	u32 context_id, u32 timestamp, void __user *data, int len,
 	struct kgsl_device_private *owner);
@@ -112,6 +117,15 @@ void kgsl_syncsource_process_release_syncsources(
 		struct kgsl_process_private *private);
 
 #else
+static inline int kgsl_sync_init(void)
+{
+	return 0;
+}
+
+static inline void kgsl_sync_exit(void)
+{
+}
+
 static inline int kgsl_add_fence_event(struct kgsl_device *device,
 	u32 context_id, u32 timestamp, void __user *data, int len,
 	struct kgsl_device_private *owner)
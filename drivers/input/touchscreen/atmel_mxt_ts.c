@@ -1118,6 +1118,21 @@ static irqreturn_t mxt_process_messages(struct mxt_data *data)
 	return IRQ_HANDLED;
 }
 
+/*
+ * Stamp the touch frame when the controller raises the line rather than
+ * when the thread gets around to reading it over I2C.
+ */
+static irqreturn_t mxt_hard_interrupt(int irq, void *dev_id)
+{
+	struct mxt_data *data = dev_id;
+	struct input_dev *input_dev = READ_ONCE(data->input_dev);
+
+	if (input_dev)
+		input_set_timestamp(input_dev, ktime_get());
+
+	return IRQ_WAKE_THREAD;
+}
+
 static irqreturn_t mxt_interrupt(int irq, void *dev_id)
 {
 	struct mxt_data *data = dev_id;
@@ -3188,7 +3203,7 @@ static int mxt_probe(struct i2c_client *client, const struct i2c_device_id *id)
 	}
 
 	error = devm_request_threaded_irq(&client->dev, client->irq,
-					  NULL, mxt_interrupt,
+					  mxt_hard_interrupt, mxt_interrupt,
 					  pdata->irqflags | IRQF_ONESHOT,
 					  client->name, data);
 	if (error) {
@@ -285,6 +285,10 @@ static int copy_data(struct bow_context const *bc,
 	if (checksum)
 		*checksum = sector_to_page(bc, source->sector);
 
+	/* Issue the reads of the whole range at once, not block by block */
+	dm_bufio_prefetch(bc->bufio, sector_to_page(bc, source->sector),
+			  range_size(source) >> bc->block_shift);
+
 	for (i = 0; i < range_size(source) >> bc->block_shift; ++i) {
 		struct dm_buffer *read_buffer, *write_buffer;
 		u8 *read, *write;
@@ -883,13 +887,19 @@ static void bow_write(struct work_struct *work)
 	kfree(ww);
 
 	mutex_lock(&bc->ranges_lock);
-	do {
+	/*
+	 * The write was queued without the lock, nothing needs backing up if
+	 * the checkpoint has been committed since.
+	 */
+	while (atomic_read(&bc->state) == CHECKPOINT) {
 		ret = prepare_one_range(bc, &bi_iter);
 		bi_iter.bi_sector += bi_iter.bi_size / SECTOR_SIZE;
 		bi_iter.bi_size = bio->bi_iter.bi_size
 			- (bi_iter.bi_sector - bio->bi_iter.bi_sector)
 			  * SECTOR_SIZE;
-	} while (!ret && bi_iter.bi_size);
+		if (ret || !bi_iter.bi_size)
+			break;
+	}
 
 	mutex_unlock(&bc->ranges_lock);
 
@@ -1051,6 +1061,15 @@ static int dm_bow_map(struct dm_target *ti, struct bio *bio)
 	if (bio_data_dir(bio) == READ && bio->bi_iter.bi_sector != 0)
 		return remap_unless_illegal_trim(bc, bio);
 
+	/*
+	 * Checkpoint writes only look at the ranges from the workqueue, which
+	 * takes the lock itself. Don't hold up the map path behind a backup
+	 * in progress.
+	 */
+	if (atomic_read(&bc->state) == CHECKPOINT &&
+	    bio->bi_iter.bi_sector != 0 && bio_data_dir(bio) == WRITE)
+		return queue_write(bc, bio);
+
 	if (atomic_read(&bc->state) != COMMITTED) {
 		enum state state;
 
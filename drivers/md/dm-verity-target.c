@@ -12,6 +12,11 @@
  * hash device. Setting this greatly improves performance when data and hash
  * are on the same disk on different partitions on devices with poor random
  * access behavior.
+ *
+ * Readahead bios prefetch at least the readahead window of the verity device.
+ * With "/sys/module/dm_verity/parameters/prefetch_inline" set, hash blocks
+ * are prefetched from the map function instead of a workqueue, so they are
+ * submitted together with the data bio.
  */
 
 #include "dm-verity.h"
@@ -40,9 +45,14 @@ static unsigned dm_verity_prefetch_cluster = DM_VERITY_DEFAULT_PREFETCH_SIZE;
 
 module_param_named(prefetch_cluster, dm_verity_prefetch_cluster, uint, S_IRUGO | S_IWUSR);
 
+static bool dm_verity_prefetch_inline;
+
+module_param_named(prefetch_inline, dm_verity_prefetch_inline, bool, S_IRUGO | S_IWUSR);
+
 struct dm_verity_prefetch_work {
 	struct work_struct work;
 	struct dm_verity *v;
+	unsigned cluster;
 	sector_t block;
 	unsigned n_blocks;
 };
@@ -332,6 +342,11 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 
 	aux = dm_bufio_get_aux_data(buf);
 
+	/* verified before the buffer was evicted from dm-bufio */
+	if (!aux->hash_verified && v->verified_hash_blocks &&
+	    test_bit(hash_block, v->verified_hash_blocks))
+		aux->hash_verified = 1;
+
 	if (!aux->hash_verified) {
 		if (skip_unverified) {
 			r = 1;
@@ -357,6 +372,9 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 			r = -EIO;
 			goto release_ret_r;
 		}
+
+		if (aux->hash_verified && v->verified_hash_blocks)
+			set_bit(hash_block, v->verified_hash_blocks);
 	}
 
 	data += offset;
@@ -631,21 +649,17 @@ static void verity_end_io(struct bio *bio)
  * The root buffer is not prefetched, it is assumed that it will be cached
  * all the time.
  */
-static void verity_prefetch_io(struct work_struct *work)
+static void verity_do_prefetch(struct dm_verity *v, sector_t block,
+			       unsigned n_blocks, unsigned cluster)
 {
-	struct dm_verity_prefetch_work *pw =
-		container_of(work, struct dm_verity_prefetch_work, work);
-	struct dm_verity *v = pw->v;
 	int i;
 
 	for (i = v->levels - 2; i >= 0; i--) {
 		sector_t hash_block_start;
 		sector_t hash_block_end;
-		verity_hash_at_level(v, pw->block, i, &hash_block_start, NULL);
-		verity_hash_at_level(v, pw->block + pw->n_blocks - 1, i, &hash_block_end, NULL);
+		verity_hash_at_level(v, block, i, &hash_block_start, NULL);
+		verity_hash_at_level(v, block + n_blocks - 1, i, &hash_block_end, NULL);
 		if (!i) {
-			unsigned cluster = ACCESS_ONCE(dm_verity_prefetch_cluster);
-
 			cluster >>= v->data_dev_block_bits;
 			if (unlikely(!cluster))
 				goto no_prefetch_cluster;
@@ -662,14 +676,47 @@ static void verity_prefetch_io(struct work_struct *work)
 		dm_bufio_prefetch(v->bufio, hash_block_start,
 				  hash_block_end - hash_block_start + 1);
 	}
+}
+
+static void verity_prefetch_io(struct work_struct *work)
+{
+	struct dm_verity_prefetch_work *pw =
+		container_of(work, struct dm_verity_prefetch_work, work);
 
+	verity_do_prefetch(pw->v, pw->block, pw->n_blocks, pw->cluster);
 	kfree(pw);
 }
 
-static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io)
+/*
+ * Readahead bios prefetch hash blocks for the whole readahead window of
+ * the verity device, so the next readahead of the stream finds them cached.
+ */
+static unsigned verity_prefetch_cluster(struct bio *bio)
+{
+	unsigned cluster = ACCESS_ONCE(dm_verity_prefetch_cluster);
+	unsigned long ra_bytes;
+
+	if (!(bio->bi_opf & REQ_RAHEAD) || !cluster)
+		return cluster;
+
+	ra_bytes = bio->bi_disk->queue->backing_dev_info->ra_pages << PAGE_SHIFT;
+	return max_t(unsigned long, cluster, ra_bytes);
+}
+
+static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io,
+				   unsigned cluster)
 {
 	struct dm_verity_prefetch_work *pw;
 
+	/*
+	 * Called from the map function, the hash bios are queued on the same
+	 * bio list and plug as the data bio instead of trailing it.
+	 */
+	if (ACCESS_ONCE(dm_verity_prefetch_inline)) {
+		verity_do_prefetch(v, io->block, io->n_blocks, cluster);
+		return;
+	}
+
 	pw = kmalloc(sizeof(struct dm_verity_prefetch_work),
 		GFP_NOIO | __GFP_NORETRY | __GFP_NOMEMALLOC | __GFP_NOWARN);
 
@@ -680,6 +727,7 @@ static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io)
 	pw->v = v;
 	pw->block = io->block;
 	pw->n_blocks = io->n_blocks;
+	pw->cluster = cluster;
 	queue_work(v->verify_wq, &pw->work);
 }
 
@@ -691,7 +739,10 @@ int verity_map(struct dm_target *ti, struct bio *bio)
 {
 	struct dm_verity *v = ti->private;
 	struct dm_verity_io *io;
+	unsigned cluster;
 
+	/* sample the verity device's readahead before remapping */
+	cluster = verity_prefetch_cluster(bio);
 	bio_set_dev(bio, v->data_dev->bdev);
 	bio->bi_iter.bi_sector = verity_map_sector(v, bio->bi_iter.bi_sector);
 
@@ -722,7 +773,7 @@ int verity_map(struct dm_target *ti, struct bio *bio)
 
 	verity_fec_init_io(io);
 
-	verity_submit_prefetch(v, io);
+	verity_submit_prefetch(v, io, cluster);
 
 	generic_make_request(bio);
 
@@ -846,6 +897,7 @@ void verity_dtr(struct dm_target *ti)
 		dm_bufio_client_destroy(v->bufio);
 
 	kvfree(v->validated_blocks);
+	kvfree(v->verified_hash_blocks);
 	kfree(v->salt);
 	kfree(v->root_digest);
 	kfree(v->zero_digest);
@@ -1193,6 +1245,22 @@ int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 	}
 	v->hash_blocks = hash_position;
 
+	/*
+	 * With check_at_most_once data is trusted not to change underneath
+	 * us, so remember verified hash blocks beyond the life of their
+	 * dm-bufio buffers as well.
+	 */
+	if (v->validated_blocks) {
+		v->verified_hash_blocks = kvzalloc(BITS_TO_LONGS(v->hash_blocks) *
+						   sizeof(unsigned long),
+						   GFP_KERNEL);
+		if (!v->verified_hash_blocks) {
+			ti->error = "failed to allocate bitset for hash blocks";
+			r = -ENOMEM;
+			goto bad;
+		}
+	}
+
 	v->bufio = dm_bufio_client_create(v->hash_dev->bdev,
 		1 << v->hash_dev_block_bits, 1, sizeof(struct buffer_aux),
 		dm_bufio_alloc_callback, NULL);
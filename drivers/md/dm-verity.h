@@ -64,6 +64,7 @@ struct dm_verity {
 
 	struct dm_verity_fec *fec;	/* forward error correction */
 	unsigned long *validated_blocks; /* bitset blocks validated */
+	unsigned long *verified_hash_blocks; /* bitset hash blocks verified */
 };
 
 struct dm_verity_io {
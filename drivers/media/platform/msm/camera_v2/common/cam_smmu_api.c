@@ -23,6 +23,7 @@
 #include <linux/msm_dma_iommu_mapping.h>
 #include <linux/workqueue.h>
 #include <linux/sizes.h>
+#include <linux/shrinker.h>
 #include <soc/qcom/scm.h>
 #include <soc/qcom/secure_buffer.h>
 #include <linux/ion_kernel.h>
@@ -106,6 +107,7 @@ struct cam_context_bank_info {
 	uint8_t scratch_buf_support;
 	struct scratch_mapping scratch_map;
 	struct list_head smmu_buf_list;
+	struct list_head pool_list;
 	struct mutex lock;
 	int handle;
 	enum cam_smmu_ops_param state;
@@ -125,6 +127,11 @@ struct cam_iommu_cb_set {
 	struct work_struct smmu_work;
 	struct mutex payload_list_lock;
 	struct list_head payload_list;
+	struct delayed_work pool_work;
+	struct shrinker pool_shrinker;
+	atomic_long_t pool_pages;
+	atomic_t pool_reap;
+	bool pool_ready;
 };
 
 static const struct of_device_id msm_cam_smmu_dt_match[] = {
@@ -145,6 +152,7 @@ struct cam_dma_buff_info {
 	int ion_fd;
 	size_t len;
 	size_t phys_len;
+	unsigned long idle_since;
 };
 
 struct cam_sec_buff_info {
@@ -161,6 +169,18 @@ struct cam_sec_buff_info {
 
 static struct cam_iommu_cb_set iommu_cb_set;
 
+/*
+ * When set, mappings whose last user has put them are parked on a per context
+ * bank pool for this long instead of being unmapped. The pool keeps the
+ * dma_buf reference, so the buffer stays pinned and keeps its IOVA, and the
+ * next session mapping the same buffer skips the attach and IOMMU map. The
+ * pool is dropped under memory pressure through a shrinker.
+ */
+static unsigned int cam_smmu_pool_ms;
+module_param_named(pool_ms, cam_smmu_pool_ms, uint, 0644);
+MODULE_PARM_DESC(pool_ms,
+	"Keep idle buffer mappings for this many ms (0 disables pooling)");
+
 static enum dma_data_direction cam_smmu_translate_dir(
 	enum cam_smmu_map_dir dir);
 
@@ -217,6 +237,9 @@ static int cam_smmu_probe(struct platform_device *pdev);
 
 static void cam_smmu_check_vaddr_in_range(int idx, void *vaddr);
 
+static struct cam_dma_buff_info *cam_smmu_pool_take(int idx,
+		struct dma_buf *buf, enum dma_data_direction dma_dir);
+
 static void cam_smmu_page_fault_work(struct work_struct *work)
 {
 	int j;
@@ -472,6 +495,7 @@ static void cam_smmu_reset_iommu_table(enum cam_smmu_init_dir ops)
 	for (i = 0; i < iommu_cb_set.cb_num; i++) {
 		iommu_cb_set.cb_info[i].handle = HANDLE_INIT;
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_list);
+		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].pool_list);
 		iommu_cb_set.cb_info[i].state = CAM_SMMU_DETACH;
 		iommu_cb_set.cb_info[i].dev = NULL;
 		iommu_cb_set.cb_info[i].cb_count = 0;
@@ -1021,6 +1045,21 @@ static int cam_smmu_map_buffer_and_add_to_list(int idx, int ion_fd,
 		goto err_out;
 	}
 
+	mapping_info = cam_smmu_pool_take(idx, buf, dma_dir);
+	if (mapping_info) {
+		/* the pooled mapping still holds its own reference */
+		dma_buf_put(buf);
+		mapping_info->ion_fd = ion_fd;
+		mapping_info->ref_count = 1;
+		*paddr_ptr = mapping_info->paddr;
+		*len_ptr = mapping_info->len;
+		CDBG("ion_fd = %d reused pooled mapping, paddr= %pK\n",
+			ion_fd, (void *)*paddr_ptr);
+		list_add(&mapping_info->list,
+			&iommu_cb_set.cb_info[idx].smmu_buf_list);
+		return 0;
+	}
+
 	attach = dma_buf_attach(buf, iommu_cb_set.cb_info[idx].dev);
 	if (IS_ERR_OR_NULL(attach)) {
 		rc = PTR_ERR(attach);
@@ -1124,6 +1163,111 @@ static int cam_smmu_unmap_buf_and_remove_from_list(
 	return 0;
 }
 
+static struct cam_dma_buff_info *cam_smmu_pool_take(int idx,
+		struct dma_buf *buf, enum dma_data_direction dma_dir)
+{
+	struct cam_dma_buff_info *mapping;
+
+	list_for_each_entry(mapping, &iommu_cb_set.cb_info[idx].pool_list,
+			list) {
+		if (mapping->buf == buf && mapping->dir == dma_dir) {
+			list_del_init(&mapping->list);
+			atomic_long_sub(mapping->len >> PAGE_SHIFT,
+				&iommu_cb_set.pool_pages);
+			return mapping;
+		}
+	}
+	return NULL;
+}
+
+static bool cam_smmu_pool_put(int idx, struct cam_dma_buff_info *mapping)
+{
+	if (!cam_smmu_pool_ms || !iommu_cb_set.pool_ready)
+		return false;
+
+	mapping->ion_fd = -1;
+	mapping->idle_since = jiffies;
+	/* newest at the head, so trimming walks from the tail */
+	list_move(&mapping->list, &iommu_cb_set.cb_info[idx].pool_list);
+	atomic_long_add(mapping->len >> PAGE_SHIFT, &iommu_cb_set.pool_pages);
+
+	if (!delayed_work_pending(&iommu_cb_set.pool_work))
+		schedule_delayed_work(&iommu_cb_set.pool_work,
+			msecs_to_jiffies(cam_smmu_pool_ms));
+	return true;
+}
+
+/*
+ * Unmap pooled buffers idle for longer than @timeout jiffies, or all of them
+ * when @timeout is 0. dma_buf_unmap_attachment() goes through the device's
+ * IOMMU dma ops, so a context bank that was detached at session close is
+ * attached around the release. Called with the context bank lock held.
+ */
+static void cam_smmu_pool_trim(int idx, unsigned long timeout)
+{
+	struct cam_context_bank_info *cb = &iommu_cb_set.cb_info[idx];
+	struct cam_dma_buff_info *mapping, *temp;
+	unsigned long pages;
+	bool attached = false;
+
+	list_for_each_entry_safe_reverse(mapping, temp, &cb->pool_list, list) {
+		if (timeout &&
+			time_before(jiffies, mapping->idle_since + timeout))
+			break;
+
+		if (cb->state != CAM_SMMU_ATTACH && !attached) {
+			if (cam_smmu_attach_device(idx) < 0)
+				break;
+			attached = true;
+		}
+
+		pages = mapping->len >> PAGE_SHIFT;
+		if (cam_smmu_unmap_buf_and_remove_from_list(mapping, idx) < 0)
+			continue;
+		atomic_long_sub(pages, &iommu_cb_set.pool_pages);
+	}
+
+	if (attached)
+		arm_iommu_detach_device(cb->dev);
+}
+
+static void cam_smmu_pool_work(struct work_struct *work)
+{
+	unsigned long timeout = msecs_to_jiffies(cam_smmu_pool_ms);
+	unsigned int i;
+
+	if (atomic_xchg(&iommu_cb_set.pool_reap, 0))
+		timeout = 0;
+
+	for (i = 0; i < iommu_cb_set.cb_num; i++) {
+		mutex_lock(&iommu_cb_set.cb_info[i].lock);
+		cam_smmu_pool_trim(i, timeout);
+		mutex_unlock(&iommu_cb_set.cb_info[i].lock);
+	}
+
+	if (atomic_long_read(&iommu_cb_set.pool_pages))
+		schedule_delayed_work(&iommu_cb_set.pool_work,
+			timeout ? timeout : HZ);
+}
+
+static unsigned long cam_smmu_pool_count(struct shrinker *shrinker,
+		struct shrink_control *sc)
+{
+	return atomic_long_read(&iommu_cb_set.pool_pages);
+}
+
+static unsigned long cam_smmu_pool_scan(struct shrinker *shrinker,
+		struct shrink_control *sc)
+{
+	/*
+	 * Releasing may have to attach a context bank, which is not something
+	 * to do from reclaim; let the worker drop the whole pool instead.
+	 */
+	atomic_set(&iommu_cb_set.pool_reap, 1);
+	mod_delayed_work(system_wq, &iommu_cb_set.pool_work, 0);
+	return SHRINK_STOP;
+}
+
 static enum cam_smmu_buf_state cam_smmu_check_fd_in_list(int idx,
 					int ion_fd, dma_addr_t *paddr_ptr,
 					size_t *len_ptr)
@@ -1985,6 +2129,11 @@ int cam_smmu_put_phy_addr(int handle, int ion_fd)
 		goto put_addr_end;
 	}
 
+	if (cam_smmu_pool_put(idx, mapping_info)) {
+		rc = 0;
+		goto put_addr_end;
+	}
+
 	/* unmapping one buffer from device */
 	rc = cam_smmu_unmap_buf_and_remove_from_list(mapping_info, idx);
 	if (rc < 0) {
@@ -2293,11 +2442,39 @@ static int cam_smmu_probe(struct platform_device *pdev)
 	mutex_init(&iommu_cb_set.payload_list_lock);
 	INIT_LIST_HEAD(&iommu_cb_set.payload_list);
 
+	INIT_DELAYED_WORK(&iommu_cb_set.pool_work, cam_smmu_pool_work);
+	iommu_cb_set.pool_shrinker.count_objects = cam_smmu_pool_count;
+	iommu_cb_set.pool_shrinker.scan_objects = cam_smmu_pool_scan;
+	iommu_cb_set.pool_shrinker.seeks = DEFAULT_SEEKS;
+	if (!register_shrinker(&iommu_cb_set.pool_shrinker))
+		iommu_cb_set.pool_ready = true;
+	else
+		pr_err("Error: buffer pool shrinker registration failed\n");
+
 	return rc;
 }
 
+static void cam_smmu_pool_flush(void)
+{
+	unsigned int i;
+
+	if (!iommu_cb_set.pool_ready)
+		return;
+
+	iommu_cb_set.pool_ready = false;
+	unregister_shrinker(&iommu_cb_set.pool_shrinker);
+	cancel_delayed_work_sync(&iommu_cb_set.pool_work);
+	for (i = 0; i < iommu_cb_set.cb_num; i++) {
+		mutex_lock(&iommu_cb_set.cb_info[i].lock);
+		cam_smmu_pool_trim(i, 0);
+		mutex_unlock(&iommu_cb_set.cb_info[i].lock);
+	}
+}
+
 static int cam_smmu_remove(struct platform_device *pdev)
 {
+	if (of_device_is_compatible(pdev->dev.of_node, "qcom,msm-cam-smmu"))
+		cam_smmu_pool_flush();
 	/* release all the context banks and memory allocated */
 	cam_smmu_reset_iommu_table(CAM_SMMU_TABLE_DEINIT);
 	if (of_device_is_compatible(pdev->dev.of_node, "qcom,msm-cam-smmu"))
@@ -194,6 +194,132 @@ void msm_smem_put_dma_buf(void *dma_buf)
 	return;
 }
 
+/*
+ * An idle device mapping kept on inst->smem_maps after its last unmap. The
+ * entry owns the dma_buf reference and the attachment, so a client that
+ * queues the same buffers over and over (the usual case in playback) skips
+ * the attach, map_attachment, detach cycle on every QBUF/DQBUF.
+ */
+struct msm_smem_map {
+	struct list_head list;
+	struct dma_buf *dma_buf;
+	enum hal_buffer buffer_type;
+	unsigned long flags;
+	u32 iova;
+	struct dma_mapping_info mapping_info;
+};
+
+static void msm_smem_map_release(struct msm_smem_map *map)
+{
+	if (msm_dma_put_device_address(map->flags, &map->mapping_info,
+			map->buffer_type))
+		dprintk(VIDC_ERR, "%s: Failed to put device address\n",
+			__func__);
+
+	msm_smem_put_dma_buf(map->dma_buf);
+	kfree(map);
+}
+
+/* Take over a parked mapping for @dbuf if there is one */
+static bool msm_smem_map_lookup(struct msm_vidc_inst *inst,
+		struct msm_smem *smem, struct dma_buf *dbuf)
+{
+	struct msm_smem_map *map;
+	bool found = false;
+
+	mutex_lock(&inst->smem_maps.lock);
+	list_for_each_entry(map, &inst->smem_maps.list, list) {
+		if (map->dma_buf == dbuf &&
+			map->buffer_type == smem->buffer_type &&
+			map->flags == smem->flags) {
+			list_del(&map->list);
+			inst->smem_map_count--;
+			found = true;
+			break;
+		}
+	}
+	mutex_unlock(&inst->smem_maps.lock);
+
+	if (!found)
+		return false;
+
+	smem->mapping_info = map->mapping_info;
+	smem->device_addr = map->iova + smem->offset;
+
+	/* smem already holds its own reference to the dma_buf */
+	msm_smem_put_dma_buf(map->dma_buf);
+	kfree(map);
+
+	return true;
+}
+
+/*
+ * Park the mapping of @smem at the head of the cache instead of tearing it
+ * down, evicting the least recently used entry if the cache is full. Returns
+ * false if the mapping should be released as usual.
+ */
+static bool msm_smem_map_park(struct msm_vidc_inst *inst,
+		struct msm_smem *smem)
+{
+	struct msm_smem_map *map, *evict = NULL;
+	u32 max = READ_ONCE(msm_vidc_map_cache_size);
+
+	/* CVP clients expect unregistered buffers to be unmapped at once */
+	if (!max || !smem->dma_buf || !smem->mapping_info.attach ||
+		inst->session_type == MSM_VIDC_CVP)
+		return false;
+
+	map = kzalloc(sizeof(*map), GFP_KERNEL);
+	if (!map)
+		return false;
+
+	map->dma_buf = smem->dma_buf;
+	map->buffer_type = smem->buffer_type;
+	map->flags = smem->flags;
+	map->iova = smem->device_addr - smem->offset;
+	map->mapping_info = smem->mapping_info;
+
+	mutex_lock(&inst->smem_maps.lock);
+	list_add(&map->list, &inst->smem_maps.list);
+	if (++inst->smem_map_count > max) {
+		evict = list_last_entry(&inst->smem_maps.list,
+			struct msm_smem_map, list);
+		list_del(&evict->list);
+		inst->smem_map_count--;
+	}
+	mutex_unlock(&inst->smem_maps.lock);
+
+	if (evict)
+		msm_smem_map_release(evict);
+
+	memset(&smem->mapping_info, 0, sizeof(smem->mapping_info));
+
+	return true;
+}
+
+/**
+ * msm_smem_flush_maps() - release every parked device mapping
+ * @inst: instance that owns the mappings
+ *
+ * Called when the client frees its buffers and when the session is torn down
+ * so that the cache does not keep freed buffers alive.
+ */
+void msm_smem_flush_maps(struct msm_vidc_inst *inst)
+{
+	struct msm_smem_map *map, *next;
+	LIST_HEAD(list);
+
+	mutex_lock(&inst->smem_maps.lock);
+	list_splice_init(&inst->smem_maps.list, &list);
+	inst->smem_map_count = 0;
+	mutex_unlock(&inst->smem_maps.lock);
+
+	list_for_each_entry_safe(map, next, &list, list) {
+		list_del(&map->list);
+		msm_smem_map_release(map);
+	}
+}
+
 int msm_smem_map_dma_buf(struct msm_vidc_inst *inst, struct msm_smem *smem)
 {
 	int rc = 0;
@@ -236,6 +362,12 @@ int msm_smem_map_dma_buf(struct msm_vidc_inst *inst, struct msm_smem *smem)
 	if (ion_flags & ION_FLAG_SECURE)
 		smem->flags |= SMEM_SECURE;
 
+	if (dbuf->size >= smem->size &&
+		msm_smem_map_lookup(inst, smem, dbuf)) {
+		smem->refcount++;
+		goto exit;
+	}
+
 	buffer_size = smem->size;
 
 	rc = msm_dma_get_device_address(dbuf, align, &iova, &buffer_size,
@@ -281,6 +413,10 @@ int msm_smem_unmap_dma_buf(struct msm_vidc_inst *inst, struct msm_smem *smem)
 	if (smem->refcount)
 		goto exit;
 
+	/* The parked mapping keeps the dma_buf reference */
+	if (msm_smem_map_park(inst, smem))
+		goto done;
+
 	rc = msm_dma_put_device_address(smem->flags, &smem->mapping_info,
 		smem->buffer_type);
 	if (rc) {
@@ -290,6 +426,7 @@ int msm_smem_unmap_dma_buf(struct msm_vidc_inst *inst, struct msm_smem *smem)
 
 	msm_smem_put_dma_buf(smem->dma_buf);
 
+done:
 	smem->device_addr = 0x0;
 	smem->dma_buf = NULL;
 
@@ -503,6 +503,9 @@ int msm_vidc_release_buffer(void *instance, int type, unsigned int index)
 	}
 	mutex_unlock(&inst->registeredbufs.lock);
 
+	/* The client is freeing its buffers, drop the parked mappings too */
+	msm_smem_flush_maps(inst);
+
 	return rc;
 }
 EXPORT_SYMBOL(msm_vidc_release_buffer);
@@ -1892,6 +1895,7 @@ void *msm_vidc_open(int core_id, int session_type)
 	INIT_MSM_VIDC_LIST(&inst->eosbufs);
 	INIT_MSM_VIDC_LIST(&inst->etb_data);
 	INIT_MSM_VIDC_LIST(&inst->fbd_data);
+	INIT_MSM_VIDC_LIST(&inst->smem_maps);
 
 	kref_init(&inst->kref);
 
@@ -2016,6 +2020,7 @@ void *msm_vidc_open(int core_id, int session_type)
 	DEINIT_MSM_VIDC_LIST(&inst->buffer_tags);
 	DEINIT_MSM_VIDC_LIST(&inst->etb_data);
 	DEINIT_MSM_VIDC_LIST(&inst->fbd_data);
+	DEINIT_MSM_VIDC_LIST(&inst->smem_maps);
 
 	kfree(inst);
 	inst = NULL;
@@ -2065,6 +2070,8 @@ static void msm_vidc_cleanup_instance(struct msm_vidc_inst *inst)
 	}
 	mutex_unlock(&inst->registeredbufs.lock);
 
+	msm_smem_flush_maps(inst);
+
 	del_timer(&inst->batch_timer);
 
 	cancel_work_sync(&inst->batch_work);
@@ -2151,6 +2158,7 @@ int msm_vidc_destroy(struct msm_vidc_inst *inst)
 	DEINIT_MSM_VIDC_LIST(&inst->input_crs);
 	DEINIT_MSM_VIDC_LIST(&inst->etb_data);
 	DEINIT_MSM_VIDC_LIST(&inst->fbd_data);
+	DEINIT_MSM_VIDC_LIST(&inst->smem_maps);
 
 	mutex_destroy(&inst->sync_lock);
 	mutex_destroy(&inst->bufq[CAPTURE_PORT].lock);
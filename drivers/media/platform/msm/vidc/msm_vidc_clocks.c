@@ -465,6 +465,79 @@ static void msm_vidc_update_freq_entry(struct msm_vidc_inst *inst,
 	mutex_unlock(&inst->freqs.lock);
 }
 
+/* Upper bound on the clock_lookahead debugfs knob, in frames */
+#define MSM_VIDC_LOOKAHEAD_MAX 16
+
+/**
+ * msm_vidc_update_frame_stats() - learn bitstream sizes from input done
+ * @inst: decode instance
+ * @filled_len: bytes the client queued in the consumed input buffer
+ * @sync_frame: firmware flagged the buffer as a sync (I/IDR) frame
+ *
+ * Sync frames are tracked apart from P/B frames, together with the distance
+ * between them, so that the size predicted for frames that are not queued
+ * yet carries the amortised cost of the next I frame without being thrown
+ * off by each one.
+ */
+void msm_vidc_update_frame_stats(struct msm_vidc_inst *inst,
+	u32 filled_len, bool sync_frame)
+{
+	struct clock_data *dcvs = &inst->clk_data;
+
+	if (!filled_len)
+		return;
+
+	if (sync_frame) {
+		dcvs->key_bytes = dcvs->key_bytes ?
+			(dcvs->key_bytes * 3 + filled_len) / 4 : filled_len;
+		if (dcvs->frames_since_key)
+			dcvs->key_interval = dcvs->key_interval ?
+				(dcvs->key_interval * 3 +
+				 dcvs->frames_since_key) / 4 :
+				dcvs->frames_since_key;
+		dcvs->frames_since_key = 0;
+	} else {
+		dcvs->frame_bytes = dcvs->frame_bytes ?
+			(dcvs->frame_bytes * 7 + filled_len) / 8 : filled_len;
+		dcvs->frames_since_key++;
+	}
+}
+
+static u32 msm_vidc_predict_frame_bytes(struct clock_data *dcvs)
+{
+	u32 bytes = dcvs->frame_bytes;
+
+	if (dcvs->key_interval && dcvs->key_bytes > bytes)
+		bytes += (dcvs->key_bytes - bytes) / (dcvs->key_interval + 1);
+
+	return bytes;
+}
+
+/*
+ * Average bitstream size over the lookahead window. Every queued input has to
+ * be decoded within as many frame periods as there are frames in the window,
+ * so the clock needs to cover the average rather than the largest one. Slots
+ * in the window with nothing queued yet use the predicted frame size.
+ */
+static u32 msm_vidc_window_filled_len(struct msm_vidc_inst *inst,
+	u32 queued_bytes, u32 queued_count, u32 max_len)
+{
+	u32 window = min_t(u32, msm_vidc_clock_lookahead,
+		MSM_VIDC_LOOKAHEAD_MAX);
+	u64 total = queued_bytes;
+
+	if (!window || !is_decode_session(inst) || !inst->clk_data.frame_bytes)
+		return max_len;
+
+	if (queued_count < window)
+		total += (u64)(window - queued_count) *
+			msm_vidc_predict_frame_bytes(&inst->clk_data);
+	else
+		window = queued_count;
+
+	return max_t(u32, div_u64(total, window), 1);
+}
+
 void msm_vidc_clear_freq_entry(struct msm_vidc_inst *inst,
 	u32 device_addr)
 {
@@ -833,6 +906,15 @@ int msm_vidc_set_clocks(struct msm_vidc_core *core)
 	} else if (decrement) {
 		if (i < (core->resources.allowed_clks_tbl_size - 1))
 			rate = allowed_clks_tbl[i+1].clock_rate;
+	} else if (msm_vidc_clock_hysteresis && rate < core->curr_freq &&
+		(u64)freq_core_max * 100 > (u64)rate *
+		(100 - min(msm_vidc_clock_hysteresis, 100))) {
+		/*
+		 * The current rate still meets the deadline. Only drop once
+		 * the demand is clearly below the lower level so a load that
+		 * sits on a level boundary doesn't bounce the clock.
+		 */
+		rate = core->curr_freq;
 	}
 
 	core->min_freq = freq_core_max;
@@ -939,6 +1021,7 @@ int msm_comm_scale_clocks(struct msm_vidc_inst *inst)
 	struct msm_vidc_buffer *temp, *next;
 	unsigned long freq = 0;
 	u32 filled_len = 0;
+	u32 queued_bytes = 0, queued_count = 0;
 	u32 device_addr = 0;
 	bool is_turbo = false;
 
@@ -954,6 +1037,8 @@ int msm_comm_scale_clocks(struct msm_vidc_inst *inst)
 				V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE) {
 			filled_len = max(filled_len,
 				temp->vvb.vb2_buf.planes[0].bytesused);
+			queued_bytes += temp->vvb.vb2_buf.planes[0].bytesused;
+			queued_count++;
 			if (inst->session_type == MSM_VIDC_ENCODER &&
 				(temp->vvb.flags &
 				V4L2_QCOM_BUF_FLAG_PERF_MODE)) {
@@ -970,6 +1055,9 @@ int msm_comm_scale_clocks(struct msm_vidc_inst *inst)
 		return 0;
 	}
 
+	filled_len = msm_vidc_window_filled_len(inst, queued_bytes,
+		queued_count, filled_len);
+
 	freq = call_core_op(inst->core, calc_freq, inst, filled_len);
 	inst->clk_data.min_freq = freq;
 	/* update dcvs flags */
@@ -1149,6 +1237,10 @@ void msm_clock_data_reset(struct msm_vidc_inst *inst)
 		dcvs->load_norm;
 
 	inst->clk_data.buffer_counter = 0;
+	dcvs->frame_bytes = 0;
+	dcvs->key_bytes = 0;
+	dcvs->key_interval = 0;
+	dcvs->frames_since_key = 0;
 
 	msm_dcvs_print_dcvs_stats(dcvs);
 
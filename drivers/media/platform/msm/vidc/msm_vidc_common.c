@@ -2517,6 +2517,10 @@ static void handle_ebd(enum hal_command_response cmd, void *data)
 	mbuf->flags &= ~MSM_VIDC_FLAG_QUEUED;
 	vb = &mbuf->vvb.vb2_buf;
 
+	if (inst->session_type == MSM_VIDC_DECODER)
+		msm_vidc_update_frame_stats(inst, vb->planes[0].bytesused,
+			empty_buf_done->flags & HAL_BUFFERFLAG_SYNCFRAME);
+
 	vb->planes[0].bytesused = response->input_done.filled_len;
 	if (vb->planes[0].bytesused > vb->planes[0].length)
 		dprintk(VIDC_INFO, "bytesused overflow length\n");
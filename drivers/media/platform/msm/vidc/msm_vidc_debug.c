@@ -30,6 +30,9 @@ bool msm_vidc_fw_coverage = !true;
 bool msm_vidc_thermal_mitigation_disabled = !true;
 int msm_vidc_clock_voting = !1;
 bool msm_vidc_syscache_disable = !true;
+int msm_vidc_map_cache_size;
+int msm_vidc_clock_lookahead;
+int msm_vidc_clock_hysteresis;
 
 #define MAX_DBG_BUF_SIZE 4096
 
@@ -204,7 +207,13 @@ struct dentry *msm_vidc_debugfs_init_drv(void)
 	__debugfs_create(u32, "core_clock_voting",
 			&msm_vidc_clock_voting) &&
 	__debugfs_create(bool, "disable_video_syscache",
-			&msm_vidc_syscache_disable);
+			&msm_vidc_syscache_disable) &&
+	__debugfs_create(u32, "map_cache_size",
+			&msm_vidc_map_cache_size) &&
+	__debugfs_create(u32, "clock_lookahead",
+			&msm_vidc_clock_lookahead) &&
+	__debugfs_create(u32, "clock_hysteresis",
+			&msm_vidc_clock_hysteresis);
 
 #undef __debugfs_create
 
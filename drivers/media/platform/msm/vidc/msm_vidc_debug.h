@@ -68,6 +68,9 @@ extern bool msm_vidc_fw_coverage;
 extern bool msm_vidc_thermal_mitigation_disabled;
 extern int msm_vidc_clock_voting;
 extern bool msm_vidc_syscache_disable;
+extern int msm_vidc_map_cache_size;
+extern int msm_vidc_clock_lookahead;
+extern int msm_vidc_clock_hysteresis;
 
 #define dprintk(__level, __fmt, arg...)	\
 	do { \
@@ -383,6 +383,10 @@ struct clock_data {
 	bool turbo_mode;
 	u32 work_route;
 	u32 dcvs_flags;
+	u32 frame_bytes;
+	u32 key_bytes;
+	u32 key_interval;
+	u32 frames_since_key;
 };
 
 struct profile_data {
@@ -465,6 +469,8 @@ struct msm_vidc_inst {
 	struct msm_vidc_list cvpbufs;
 	struct msm_vidc_list etb_data;
 	struct msm_vidc_list fbd_data;
+	struct msm_vidc_list smem_maps;
+	u32 smem_map_count;
 	struct buffer_requirements buff_req;
 	struct v4l2_ctrl_handler ctrl_handler;
 	struct completion completions[SESSION_MSG_END - SESSION_MSG_START + 1];
@@ -566,6 +572,7 @@ struct context_bank_info *msm_smem_get_context_bank(u32 session_type,
 	enum hal_buffer buffer_type);
 int msm_smem_map_dma_buf(struct msm_vidc_inst *inst, struct msm_smem *smem);
 int msm_smem_unmap_dma_buf(struct msm_vidc_inst *inst, struct msm_smem *smem);
+void msm_smem_flush_maps(struct msm_vidc_inst *inst);
 struct dma_buf *msm_smem_get_dma_buf(int fd);
 void msm_smem_put_dma_buf(void *dma_buf);
 int msm_smem_cache_operations(struct dma_buf *dbuf,
@@ -44,37 +44,56 @@ static int mmc_prep_request(struct request_queue *q, struct request *req)
 	return BLKPREP_OK;
 }
 
-static struct request *mmc_peek_request(struct mmc_queue *mq)
+static inline bool mmc_cmdq_is_dcmd_op(struct request *req)
 {
-	struct request_queue *q = mq->queue;
+	return req_op(req) == REQ_OP_FLUSH ||
+	       req_op(req) == REQ_OP_DISCARD ||
+	       req_op(req) == REQ_OP_SECURE_ERASE;
+}
 
-	mq->cmdq_req_peeked = NULL;
+/*
+ * Peek the next request and, if it can be issued, start its tag. This is
+ * evaluated on every wakeup of the issue thread, so do it all under one
+ * hold of the queue lock instead of taking it once for peeking and once
+ * more for the tag.
+ */
+static bool mmc_cmdq_fetch_request(struct mmc_host *host,
+				   struct mmc_queue *mq)
+{
+	struct mmc_cmdq_context_info *ctx = &host->cmdq_ctx;
+	struct mmc_card *card = host->card;
+	struct request_queue *q = mq->queue;
+	struct request *req = NULL;
+	bool ready = false;
 
 	spin_lock_irq(q->queue_lock);
 	if (!blk_queue_stopped(q))
-		mq->cmdq_req_peeked = blk_peek_request(q);
-	spin_unlock_irq(q->queue_lock);
-
-	return mq->cmdq_req_peeked;
-}
+		req = blk_peek_request(q);
+	mq->cmdq_req_peeked = req;
+	if (!req)
+		goto out;
 
-static bool mmc_check_blk_queue_start_tag(struct request_queue *q,
-					  struct request *req)
-{
-	int ret;
+	if (mmc_cmdq_is_dcmd_op(req) &&
+	    test_bit(CMDQ_STATE_DCMD_ACTIVE, &ctx->curr_state))
+		goto out;
+	if (!card->part_curr && !mmc_card_suspended(card) &&
+	    (mmc_host_halt(host) || mmc_host_cq_disable(host)))
+		goto out;
+	if (test_bit(CMDQ_STATE_ERR, &ctx->curr_state) ||
+	    atomic_read(&host->rpmb_req_pending))
+		goto out;
 
-	spin_lock_irq(q->queue_lock);
-	ret = blk_queue_start_tag(q, req);
+	ready = !blk_queue_start_tag(q, req);
+out:
 	spin_unlock_irq(q->queue_lock);
 
-	return !!ret;
+	return ready;
 }
 
 static inline void mmc_cmdq_ready_wait(struct mmc_host *host,
 					struct mmc_queue *mq)
 {
 	struct mmc_cmdq_context_info *ctx = &host->cmdq_ctx;
-	struct request_queue *q = mq->queue;
 
 	/*
 	 * Wait until all of the following conditions are true:
@@ -88,19 +107,8 @@ static inline void mmc_cmdq_ready_wait(struct mmc_host *host,
 	 * 6. free tag available to process the new request.
 	 *    (This must be the last condtion to check)
 	 */
-	wait_event(ctx->wait, kthread_should_stop()
-		|| (mmc_peek_request(mq) &&
-		!(((req_op(mq->cmdq_req_peeked) == REQ_OP_FLUSH) ||
-		   (req_op(mq->cmdq_req_peeked) == REQ_OP_DISCARD) ||
-		   (req_op(mq->cmdq_req_peeked) == REQ_OP_SECURE_ERASE))
-		  && test_bit(CMDQ_STATE_DCMD_ACTIVE, &ctx->curr_state))
-		&& !(!host->card->part_curr && !mmc_card_suspended(host->card)
-		     && mmc_host_halt(host))
-		&& !(!host->card->part_curr && mmc_host_cq_disable(host) &&
-			!mmc_card_suspended(host->card))
-		&& !test_bit(CMDQ_STATE_ERR, &ctx->curr_state)
-		&& !atomic_read(&host->rpmb_req_pending)
-		&& !mmc_check_blk_queue_start_tag(q, mq->cmdq_req_peeked)));
+	wait_event(ctx->wait, kthread_should_stop() ||
+		   mmc_cmdq_fetch_request(host, mq));
 }
 
 static void mmc_cmdq_softirq_done(struct request *rq)
@@ -169,8 +177,14 @@ static int mmc_cmdq_thread(void *d)
 static void mmc_cmdq_dispatch_req(struct request_queue *q)
 {
 	struct mmc_queue *mq = q->queuedata;
+	wait_queue_head_t *wait = &mq->card->host->cmdq_ctx.wait;
 
-	wake_up(&mq->card->host->cmdq_ctx.wait);
+	/*
+	 * Called for every request inserted. While the issue thread is busy
+	 * it rechecks the queue before sleeping again, so skip the wakeup.
+	 */
+	if (wq_has_sleeper(wait))
+		wake_up(wait);
 }
 
 static void mmc_queue_setup_discard(struct request_queue *q,
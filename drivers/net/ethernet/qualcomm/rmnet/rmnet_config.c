@@ -50,6 +50,7 @@
 enum {
 	IFLA_RMNET_DFC_QOS = __IFLA_RMNET_MAX,
 	IFLA_RMNET_UL_AGG_PARAMS,
+	IFLA_RMNET_TX_PACING_SHIFT,
 	__IFLA_RMNET_EXT_MAX,
 };
 
@@ -66,6 +67,9 @@ static const struct nla_policy rmnet_policy[__IFLA_RMNET_EXT_MAX] = {
 	[IFLA_RMNET_UL_AGG_PARAMS] = {
 		.len = sizeof(struct rmnet_egress_agg_params)
 	},
+	[IFLA_RMNET_TX_PACING_SHIFT] = {
+		.type = NLA_U8
+	},
 };
 
 int rmnet_is_real_dev_registered(const struct net_device *real_dev)
@@ -229,6 +233,13 @@ static int rmnet_newlink(struct net *src_net, struct net_device *dev,
 		spin_unlock_irqrestore(&port->agg_lock, irq_flags);
 	}
 
+	if (data[IFLA_RMNET_TX_PACING_SHIFT]) {
+		struct rmnet_priv *priv = netdev_priv(dev);
+
+		priv->tx_pacing_shift =
+			nla_get_u8(data[IFLA_RMNET_TX_PACING_SHIFT]);
+	}
+
 	return 0;
 
 err1:
@@ -359,6 +370,14 @@ static int rmnet_rtnl_validate(struct nlattr *tb[], struct nlattr *data[],
 			if (agg_params->agg_time < 3000000)
 				return -EINVAL;
 		}
+
+		/* uplink completions come in bursts, allow up to 1/16s */
+		if (data[IFLA_RMNET_TX_PACING_SHIFT]) {
+			u8 shift = nla_get_u8(data[IFLA_RMNET_TX_PACING_SHIFT]);
+
+			if (shift < RMNET_TX_PACING_SHIFT_MIN || shift > 31)
+				return -ERANGE;
+		}
 	}
 
 	return 0;
@@ -419,6 +438,10 @@ static int rmnet_changelink(struct net_device *dev, struct nlattr *tb[],
 					       agg_params->agg_time);
 	}
 
+	if (data[IFLA_RMNET_TX_PACING_SHIFT])
+		WRITE_ONCE(priv->tx_pacing_shift,
+			   nla_get_u8(data[IFLA_RMNET_TX_PACING_SHIFT]));
+
 	return 0;
 }
 
@@ -432,7 +455,9 @@ static size_t rmnet_get_size(const struct net_device *dev)
 		/* IFLA_RMNET_DFC_QOS */
 		nla_total_size(sizeof(struct tcmsg)) +
 		/* IFLA_RMNET_UL_AGG_PARAMS */
-		nla_total_size(sizeof(struct rmnet_egress_agg_params));
+		nla_total_size(sizeof(struct rmnet_egress_agg_params)) +
+		/* IFLA_RMNET_TX_PACING_SHIFT */
+		nla_total_size(1);
 }
 
 static int rmnet_fill_info(struct sk_buff *skb, const struct net_device *dev)
@@ -459,6 +484,9 @@ static int rmnet_fill_info(struct sk_buff *skb, const struct net_device *dev)
 	if (nla_put(skb, IFLA_RMNET_FLAGS, sizeof(f), &f))
 		goto nla_put_failure;
 
+	if (nla_put_u8(skb, IFLA_RMNET_TX_PACING_SHIFT, priv->tx_pacing_shift))
+		goto nla_put_failure;
+
 	if (port) {
 		if (nla_put(skb, IFLA_RMNET_UL_AGG_PARAMS,
 			    sizeof(port->egress_agg_params),
@@ -154,15 +154,23 @@ struct rmnet_priv_stats {
 	u64 csum_hw;
 	struct rmnet_coal_stats coal;
 	u64 ul_prio;
+	u64 ul_gso_sw;
+	u64 xdp_consumed;
 };
 
+/* TSQ budget of uplink sockets, sk_pacing_rate >> RMNET_TX_PACING_SHIFT */
+#define RMNET_TX_PACING_SHIFT		8
+#define RMNET_TX_PACING_SHIFT_MIN	4
+
 struct rmnet_priv {
 	u8 mux_id;
+	u8 tx_pacing_shift;
 	struct net_device *real_dev;
 	struct rmnet_pcpu_stats __percpu *pcpu_stats;
 	struct gro_cells gro_cells;
 	struct rmnet_priv_stats stats;
 	void __rcu *qos_info;
+	struct bpf_prog __rcu *xdp_prog;
 };
 
 enum rmnet_dl_marker_prio {
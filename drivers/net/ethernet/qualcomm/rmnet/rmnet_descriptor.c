@@ -751,7 +751,7 @@ rmnet_frag_segment_coal_data(struct rmnet_frag_descriptor *coal_desc,
 	struct rmnet_map_v5_coal_header *coal_hdr;
 	u16 pkt_len;
 	u8 pkt, total_pkt = 0;
-	u8 nlo;
+	u8 nlo, gso_segs;
 	bool gro = coal_desc->dev->features & NETIF_F_GRO_HW;
 	bool zero_csum = false;
 
@@ -836,16 +836,18 @@ rmnet_frag_segment_coal_data(struct rmnet_frag_descriptor *coal_desc,
 		return;
 	}
 
-	/* Fast-forward the case where we have 1 NLO (i.e. 1 packet length),
-	 * no checksum errors, and are allowing GRO. We can just reuse this
+	/* Fast-forward the case where the frame is one run of equal sized
+	 * packets, optionally followed by a single shorter one, with no
+	 * checksum errors, and we are allowing GRO. We can just reuse this
 	 * descriptor unchanged.
 	 */
-	if (gro && coal_hdr->num_nlos == 1 && coal_hdr->csum_valid) {
+	gso_segs = gro ? rmnet_map_v5_coal_gso_segs(coal_hdr) : 0;
+	if (gso_segs) {
 		coal_desc->csum_valid = true;
 		coal_desc->hdr_ptr = rmnet_frag_data_ptr(coal_desc);
 		coal_desc->gso_size = ntohs(coal_hdr->nl_pairs[0].pkt_len);
 		coal_desc->gso_size -= coal_desc->ip_len + coal_desc->trans_len;
-		coal_desc->gso_segs = coal_hdr->nl_pairs[0].num_packets;
+		coal_desc->gso_segs = gso_segs;
 		list_add_tail(&coal_desc->list, list);
 		return;
 	}
@@ -14,6 +14,7 @@
  */
 
 #include <linux/netdevice.h>
+#include <linux/bpf.h>
 #include <linux/netdev_features.h>
 #include <linux/if_arp.h>
 #include <linux/ip.h>
@@ -97,6 +98,40 @@ int (*rmnet_shs_skb_entry_wq)(struct sk_buff *skb,
 			      struct rmnet_port *port) __rcu __read_mostly;
 EXPORT_SYMBOL(rmnet_shs_skb_entry_wq);
 
+/* Run the XDP program attached to the rmnet device, if any. Returns true
+ * when the program consumed the packet (drop, tx or redirect).
+ */
+static bool rmnet_deliver_xdp(struct sk_buff *skb)
+{
+	struct rmnet_priv *priv = netdev_priv(skb->dev);
+	struct bpf_prog *xdp_prog;
+	int act = XDP_PASS;
+
+	if (!rcu_access_pointer(priv->xdp_prog))
+		return false;
+
+	/* The flush timer path delivers from workqueue context */
+	local_bh_disable();
+	rcu_read_lock();
+	xdp_prog = rcu_dereference(priv->xdp_prog);
+	if (xdp_prog)
+		act = do_xdp_generic(xdp_prog, skb);
+	rcu_read_unlock();
+	local_bh_enable();
+
+	if (act != XDP_PASS) {
+		priv->stats.xdp_consumed++;
+		return true;
+	}
+
+	/* The program may have moved the start of the packet */
+	skb_reset_transport_header(skb);
+	skb_reset_network_header(skb);
+	skb_set_mac_header(skb, 0);
+	rmnet_set_skb_proto(skb);
+	return false;
+}
+
 /* Generic handler */
 
 void
@@ -114,6 +149,9 @@ rmnet_deliver_skb(struct sk_buff *skb, struct rmnet_port *port)
 	skb->pkt_type = PACKET_HOST;
 	skb_set_mac_header(skb, 0);
 
+	if (rmnet_deliver_xdp(skb))
+		return;
+
 	rcu_read_lock();
 	rmnet_shs_stamp = rcu_dereference(rmnet_shs_skb_entry);
 	if (rmnet_shs_stamp) {
@@ -159,6 +197,9 @@ rmnet_deliver_skb_wq(struct sk_buff *skb, struct rmnet_port *port,
 	skb->pkt_type = PACKET_HOST;
 	skb_set_mac_header(skb, 0);
 
+	if (rmnet_deliver_xdp(skb))
+		return;
+
 	/* packets coming from work queue context due to packet flush timer
 	 * must go through the special workqueue path in SHS driver
 	 */
@@ -447,31 +488,27 @@ rx_handler_result_t rmnet_rx_handler(struct sk_buff **pskb)
 }
 EXPORT_SYMBOL(rmnet_rx_handler);
 
-/* Modifies packet as per logical endpoint configuration and egress data format
- * for egress device configured in logical endpoint. Packet is then transmitted
- * on the egress device.
+/* Features GSO skbs are segmented against. Segments keep pointing
+ * at the page frags of the super skb and keep CHECKSUM_PARTIAL when the MAP
+ * checksum offload header can take care of it.
  */
-void rmnet_egress_handler(struct sk_buff *skb)
+static netdev_features_t rmnet_egress_gso_features(struct rmnet_port *port)
 {
-	struct net_device *orig_dev;
-	struct rmnet_port *port;
-	struct rmnet_priv *priv;
-	u8 mux_id;
-	int err;
-	u32 skb_len;
+	netdev_features_t features = NETIF_F_SG;
 
-	trace_rmnet_low(RMNET_MODULE, RMNET_TX_UL_PKT, 0xDEF, 0xDEF, 0xDEF,
-			0xDEF, (void *)skb, NULL);
-	sk_pacing_shift_update(skb->sk, 8);
+	if (port->data_format & (RMNET_FLAGS_EGRESS_MAP_CKSUMV4 |
+				 RMNET_FLAGS_EGRESS_MAP_CKSUMV5))
+		features |= NETIF_F_IP_CSUM | NETIF_F_IPV6_CSUM;
 
-	orig_dev = skb->dev;
-	priv = netdev_priv(orig_dev);
-	skb->dev = priv->real_dev;
-	mux_id = priv->mux_id;
+	return features;
+}
 
-	port = rmnet_get_port(skb->dev);
-	if (!port)
-		goto drop;
+static void rmnet_egress_xmit(struct sk_buff *skb, struct rmnet_port *port,
+			      u8 mux_id, struct net_device *orig_dev)
+{
+	struct rmnet_priv *priv = netdev_priv(orig_dev);
+	u32 skb_len;
+	int err;
 
 	skb_len = skb->len;
 	err = rmnet_map_egress_handler(skb, port, mux_id, orig_dev);
@@ -491,3 +528,73 @@ void rmnet_egress_handler(struct sk_buff *skb)
 	this_cpu_inc(priv->pcpu_stats->stats.tx_drops);
 	kfree_skb(skb);
 }
+
+/* Segments a GSO skb and sends each segment on its own. MAP has no
+ * documented uplink segmentation header, so it is never handed down whole.
+ * This is done once here rather than by the stack in front of rmnet so the
+ * segments still get the MAP checksum offload and UL aggregation.
+ */
+static void rmnet_egress_segment(struct sk_buff *skb, struct rmnet_port *port,
+				 u8 mux_id, struct net_device *orig_dev)
+{
+	struct rmnet_priv *priv = netdev_priv(orig_dev);
+	struct sk_buff *segs, *seg;
+
+	segs = skb_gso_segment(skb, rmnet_egress_gso_features(port));
+	if (IS_ERR(segs)) {
+		this_cpu_inc(priv->pcpu_stats->stats.tx_drops);
+		kfree_skb(skb);
+		return;
+	}
+
+	if (!segs) {
+		skb_gso_reset(skb);
+		rmnet_egress_xmit(skb, port, mux_id, orig_dev);
+		return;
+	}
+
+	priv->stats.ul_gso_sw++;
+	consume_skb(skb);
+
+	while (segs) {
+		seg = segs;
+		segs = segs->next;
+		seg->next = NULL;
+		rmnet_egress_xmit(seg, port, mux_id, orig_dev);
+	}
+}
+
+/* Modifies packet as per logical endpoint configuration and egress data format
+ * for egress device configured in logical endpoint. Packet is then transmitted
+ * on the egress device.
+ */
+void rmnet_egress_handler(struct sk_buff *skb)
+{
+	struct net_device *orig_dev;
+	struct rmnet_port *port;
+	struct rmnet_priv *priv;
+	u8 mux_id;
+
+	trace_rmnet_low(RMNET_MODULE, RMNET_TX_UL_PKT, 0xDEF, 0xDEF, 0xDEF,
+			0xDEF, (void *)skb, NULL);
+	orig_dev = skb->dev;
+	priv = netdev_priv(orig_dev);
+	sk_pacing_shift_update(skb->sk, READ_ONCE(priv->tx_pacing_shift));
+
+	skb->dev = priv->real_dev;
+	mux_id = priv->mux_id;
+
+	port = rmnet_get_port(skb->dev);
+	if (!port) {
+		this_cpu_inc(priv->pcpu_stats->stats.tx_drops);
+		kfree_skb(skb);
+		return;
+	}
+
+	if (skb_is_gso(skb)) {
+		rmnet_egress_segment(skb, port, mux_id, orig_dev);
+		return;
+	}
+
+	rmnet_egress_xmit(skb, port, mux_id, orig_dev);
+}
@@ -599,6 +599,28 @@ bool rmnet_map_v5_csum_buggy(struct rmnet_map_v5_coal_header *coal_hdr)
 	return false;
 }
 
+/* Number of GSO segments a coalesced frame can be passed up as without
+ * being split, or 0 if it has to be segmented. A single NLO is a run of
+ * equal sized packets, and a trailing NLO holding one shorter packet is
+ * just the short last segment GSO already allows for.
+ */
+u8 rmnet_map_v5_coal_gso_segs(struct rmnet_map_v5_coal_header *coal_hdr)
+{
+	if (!coal_hdr->csum_valid)
+		return 0;
+
+	if (coal_hdr->num_nlos == 1)
+		return coal_hdr->nl_pairs[0].num_packets;
+
+	if (coal_hdr->num_nlos == 2 &&
+	    coal_hdr->nl_pairs[1].num_packets == 1 &&
+	    ntohs(coal_hdr->nl_pairs[1].pkt_len) <
+	    ntohs(coal_hdr->nl_pairs[0].pkt_len))
+		return coal_hdr->nl_pairs[0].num_packets + 1;
+
+	return 0;
+}
+
 static void rmnet_map_move_headers(struct sk_buff *skb)
 {
 	struct iphdr *iph;
@@ -895,7 +917,7 @@ static void rmnet_map_segment_coal_skb(struct sk_buff *coal_skb,
 	struct rmnet_map_coal_metadata coal_meta;
 	u16 pkt_len;
 	u8 pkt, total_pkt = 0;
-	u8 nlo;
+	u8 nlo, gso_segs;
 	bool gro = coal_skb->dev->features & NETIF_F_GRO_HW;
 	bool zero_csum = false;
 
@@ -977,16 +999,18 @@ static void rmnet_map_segment_coal_skb(struct sk_buff *coal_skb,
 		return;
 	}
 
-	/* Fast-forward the case where we have 1 NLO (i.e. 1 packet length),
-	 * no checksum errors, and are allowing GRO. We can just reuse this
+	/* Fast-forward the case where the frame is one run of equal sized
+	 * packets, optionally followed by a single shorter one, with no
+	 * checksum errors, and we are allowing GRO. We can just reuse this
 	 * SKB unchanged.
 	 */
-	if (gro && coal_hdr->num_nlos == 1 && coal_hdr->csum_valid) {
+	gso_segs = gro ? rmnet_map_v5_coal_gso_segs(coal_hdr) : 0;
+	if (gso_segs) {
 		rmnet_map_move_headers(coal_skb);
 		coal_skb->ip_summed = CHECKSUM_UNNECESSARY;
 		coal_meta.data_len = ntohs(coal_hdr->nl_pairs[0].pkt_len);
 		coal_meta.data_len -= coal_meta.ip_len + coal_meta.trans_len;
-		coal_meta.pkt_count = coal_hdr->nl_pairs[0].num_packets;
+		coal_meta.pkt_count = gso_segs;
 		if (coal_meta.pkt_count > 1) {
 			rmnet_map_partial_csum(coal_skb, &coal_meta);
 			rmnet_map_gso_stamp(coal_skb, &coal_meta);
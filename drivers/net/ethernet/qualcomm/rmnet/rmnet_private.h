@@ -17,6 +17,7 @@
 #define RMNET_DFLT_PACKET_SIZE     1500
 #define RMNET_NEEDED_HEADROOM      16
 #define RMNET_TX_QUEUE_LEN         1000
+#define RMNET_GSO_MAX_SIZE         (U16_MAX - RMNET_NEEDED_HEADROOM)
 
 /* Constants */
 #define RMNET_EGRESS_FORMAT_AGGREGATION         BIT(31)
@@ -16,6 +16,7 @@
 
 #include <linux/etherdevice.h>
 #include <linux/if_arp.h>
+#include <linux/bpf.h>
 #include <linux/ip.h>
 #include <net/pkt_sched.h>
 #include "rmnet_config.h"
@@ -121,8 +122,14 @@ static int rmnet_vnd_init(struct net_device *dev)
 static void rmnet_vnd_uninit(struct net_device *dev)
 {
 	struct rmnet_priv *priv = netdev_priv(dev);
+	struct bpf_prog *xdp_prog;
 	void *qos;
 
+	xdp_prog = rtnl_dereference(priv->xdp_prog);
+	RCU_INIT_POINTER(priv->xdp_prog, NULL);
+	if (xdp_prog)
+		bpf_prog_put(xdp_prog);
+
 	gro_cells_destroy(&priv->gro_cells);
 	free_percpu(priv->pcpu_stats);
 
@@ -177,6 +184,61 @@ static u16 rmnet_vnd_select_queue(struct net_device *dev,
 	return (txq < dev->real_num_tx_queues) ? txq : 0;
 }
 
+static netdev_features_t rmnet_vnd_fix_features(struct net_device *dev,
+						netdev_features_t features)
+{
+	struct rmnet_priv *priv = netdev_priv(dev);
+
+	/* Coalesced frames would reach the program as one GSO packet */
+	if (rtnl_dereference(priv->xdp_prog))
+		features &= ~NETIF_F_GRO_HW;
+
+	return features;
+}
+
+static int rmnet_vnd_xdp_set(struct net_device *dev, struct bpf_prog *prog,
+			     struct netlink_ext_ack *extack)
+{
+	struct rmnet_priv *priv = netdev_priv(dev);
+	struct bpf_prog *old_prog;
+
+	old_prog = rtnl_dereference(priv->xdp_prog);
+	rcu_assign_pointer(priv->xdp_prog, prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	if (!old_prog != !prog)
+		netdev_update_features(dev);
+
+	return 0;
+}
+
+static u32 rmnet_vnd_xdp_query(struct net_device *dev)
+{
+	struct rmnet_priv *priv = netdev_priv(dev);
+	const struct bpf_prog *xdp_prog;
+
+	xdp_prog = rtnl_dereference(priv->xdp_prog);
+	if (xdp_prog)
+		return xdp_prog->aux->id;
+
+	return 0;
+}
+
+static int rmnet_vnd_xdp(struct net_device *dev, struct netdev_bpf *xdp)
+{
+	switch (xdp->command) {
+	case XDP_SETUP_PROG:
+		return rmnet_vnd_xdp_set(dev, xdp->prog, xdp->extack);
+	case XDP_QUERY_PROG:
+		xdp->prog_id = rmnet_vnd_xdp_query(dev);
+		xdp->prog_attached = !!xdp->prog_id;
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
 static const struct net_device_ops rmnet_vnd_ops = {
 	.ndo_start_xmit = rmnet_vnd_start_xmit,
 	.ndo_change_mtu = rmnet_vnd_change_mtu,
@@ -187,6 +249,8 @@ static const struct net_device_ops rmnet_vnd_ops = {
 	.ndo_uninit     = rmnet_vnd_uninit,
 	.ndo_get_stats64 = rmnet_get_stats64,
 	.ndo_select_queue = rmnet_vnd_select_queue,
+	.ndo_fix_features = rmnet_vnd_fix_features,
+	.ndo_bpf        = rmnet_vnd_xdp,
 };
 
 static const char rmnet_gstrings_stats[][ETH_GSTRING_LEN] = {
@@ -222,6 +286,8 @@ static const char rmnet_gstrings_stats[][ETH_GSTRING_LEN] = {
 	"Coalescing packets over VEID2",
 	"Coalescing packets over VEID3",
 	"Uplink priority packets",
+	"Uplink software segmented packets",
+	"XDP consumed packets",
 };
 
 static const char rmnet_port_gstrings_stats[][ETH_GSTRING_LEN] = {
@@ -355,8 +421,14 @@ int rmnet_vnd_newlink(u8 id, struct net_device *rmnet_dev,
 	rmnet_dev->hw_features |= NETIF_F_IP_CSUM | NETIF_F_IPV6_CSUM;
 	rmnet_dev->hw_features |= NETIF_F_SG;
 	rmnet_dev->hw_features |= NETIF_F_GRO_HW;
+	rmnet_dev->hw_features |= NETIF_F_TSO | NETIF_F_TSO6;
+	rmnet_dev->hw_features |= NETIF_F_GSO_UDP_L4;
+
+	/* A GSO skb still has to fit in one MAP frame */
+	netif_set_gso_max_size(rmnet_dev, RMNET_GSO_MAX_SIZE);
 
 	priv->real_dev = real_dev;
+	priv->tx_pacing_shift = RMNET_TX_PACING_SHIFT;
 
 	rc = register_netdevice(rmnet_dev);
 	if (!rc) {
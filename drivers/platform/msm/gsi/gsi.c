@@ -1944,6 +1944,46 @@ int gsi_reset_evt_ring(unsigned long evt_ring_hdl)
 }
 EXPORT_SYMBOL(gsi_reset_evt_ring);
 
+int gsi_set_evt_ring_int_mod(unsigned long evt_ring_hdl, uint16_t int_modt,
+		uint8_t int_modc)
+{
+	struct gsi_evt_ctx *ctx;
+	unsigned long flags;
+	uint32_t val;
+
+	if (!gsi_ctx) {
+		pr_err("%s:%d gsi context not allocated\n", __func__, __LINE__);
+		return -GSI_STATUS_NODEV;
+	}
+
+	if (evt_ring_hdl >= gsi_ctx->max_ev || !int_modc) {
+		GSIERR("bad params evt_ring_hdl=%lu modc=%u\n", evt_ring_hdl,
+				int_modc);
+		return -GSI_STATUS_INVALID_PARAMS;
+	}
+
+	ctx = &gsi_ctx->evtr[evt_ring_hdl];
+
+	if (ctx->state != GSI_EVT_RING_STATE_ALLOCATED) {
+		GSIERR("bad state %d\n", ctx->state);
+		return -GSI_STATUS_UNSUPPORTED_OP;
+	}
+
+	spin_lock_irqsave(&ctx->ring.slock, flags);
+	ctx->props.int_modt = int_modt;
+	ctx->props.int_modc = int_modc;
+	val = (((int_modt << GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODT_SHFT) &
+		GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODT_BMSK) |
+		((int_modc << GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODC_SHFT) &
+		 GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODC_BMSK));
+	gsi_writel(val, gsi_ctx->base +
+		GSI_EE_n_EV_CH_k_CNTXT_8_OFFS(ctx->id, gsi_ctx->per.ee));
+	spin_unlock_irqrestore(&ctx->ring.slock, flags);
+
+	return GSI_STATUS_SUCCESS;
+}
+EXPORT_SYMBOL(gsi_set_evt_ring_int_mod);
+
 int gsi_get_evt_ring_cfg(unsigned long evt_ring_hdl,
 		struct gsi_evt_ring_props *props, union gsi_evt_scratch *scr)
 {
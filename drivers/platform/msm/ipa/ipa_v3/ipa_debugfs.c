@@ -1120,6 +1120,10 @@ static ssize_t ipa3_read_stats(struct file *file, char __user *ubuf,
 		"wan_repl_rx_empty=%u\n"
 		"lan_rx_empty=%u\n"
 		"lan_repl_rx_empty=%u\n"
+		"wan_repl_alloc_fail=%u\n"
+		"wan_repl_starved=%u\n"
+		"lan_repl_alloc_fail=%u\n"
+		"lan_repl_starved=%u\n"
 		"flow_enable=%u\n"
 		"flow_disable=%u\n",
 		ipa3_ctx->stats.tx_sw_pkts,
@@ -1136,6 +1140,10 @@ static ssize_t ipa3_read_stats(struct file *file, char __user *ubuf,
 		ipa3_ctx->stats.wan_repl_rx_empty,
 		ipa3_ctx->stats.lan_rx_empty,
 		ipa3_ctx->stats.lan_repl_rx_empty,
+		ipa3_ctx->stats.wan_repl_alloc_fail,
+		ipa3_ctx->stats.wan_repl_starved,
+		ipa3_ctx->stats.lan_repl_alloc_fail,
+		ipa3_ctx->stats.lan_repl_starved,
 		ipa3_ctx->stats.flow_enable,
 		ipa3_ctx->stats.flow_disable);
 	cnt += nbytes;
@@ -92,9 +92,41 @@
 
 #define IPA_QMAP_ID_BYTE 0
 
+/*
+ * Deliver WAN downlink aggregates as page frags taken from a page pool
+ * instead of linear skbs, so the pages and their IOMMU mappings are
+ * reused once rmnet is done with them. Only used when the aggregates go
+ * to rmnet as is (GRO aggregation), rmnet then takes its frag path.
+ */
+static bool wan_rx_page_pool;
+module_param(wan_rx_page_pool, bool, 0444);
+MODULE_PARM_DESC(wan_rx_page_pool, "Recycle WAN RX buffers from a page pool");
+
+/*
+ * Ring the TX channel doorbell once per burst the stack hands over
+ * (skb->xmit_more) instead of once per packet.
+ */
+static bool tx_db_batch;
+module_param(tx_db_batch, bool, 0644);
+MODULE_PARM_DESC(tx_db_batch, "Batch TX doorbells using xmit_more");
+
+/*
+ * Retune the interrupt moderation of NAPI RX event rings from the
+ * packet rate seen by the poll loop: a short timer and no count at low
+ * rate for latency, a longer timer at high rate against IRQ storms.
+ */
+static bool rx_adaptive_modt;
+module_param(rx_adaptive_modt, bool, 0644);
+MODULE_PARM_DESC(rx_adaptive_modt, "Adapt RX interrupt moderation to rate");
+
+#define IPA_DIM_WINDOW_MS 100
+#define IPA_DIM_LOW_PPS 2000
+#define IPA_DIM_HIGH_PPS 100000
+
 static struct sk_buff *ipa3_get_skb_ipa_rx(unsigned int len, gfp_t flags);
 static void ipa3_replenish_wlan_rx_cache(struct ipa3_sys_context *sys);
 static void ipa3_replenish_rx_cache(struct ipa3_sys_context *sys);
+static void ipa3_replenish_rx_page_recycle(struct ipa3_sys_context *sys);
 static void ipa3_replenish_rx_work_func(struct work_struct *work);
 static void ipa3_fast_replenish_rx_cache(struct ipa3_sys_context *sys);
 static void ipa3_wq_handle_rx(struct work_struct *work);
@@ -458,12 +490,13 @@ int ipa3_send(struct ipa3_sys_context *sys,
 
 	IPADBG_LOW("ch:%lu queue xfer\n", sys->ep->gsi_chan_hdl);
 	result = gsi_queue_xfer(sys->ep->gsi_chan_hdl, num_desc,
-			gsi_xfer, true);
+			gsi_xfer, !sys->tx_db_defer);
 	if (result != GSI_STATUS_SUCCESS) {
 		IPAERR("GSI xfer failed.\n");
 		result = -EFAULT;
 		goto failure;
 	}
+	sys->tx_db_pending = sys->tx_db_defer;
 
 	if (send_nop && !sys->nop_pending)
 		sys->nop_pending = true;
@@ -1119,8 +1152,12 @@ int ipa3_setup_sys_pipe(struct ipa_sys_connect_params *sys_in, u32 *clnt_hdl)
 		}
 	}
 
-	if (IPA_CLIENT_IS_CONS(sys_in->client))
-		ipa3_replenish_rx_cache(ep->sys);
+	if (IPA_CLIENT_IS_CONS(sys_in->client)) {
+		if (ep->sys->page_pool)
+			ipa3_replenish_rx_page_recycle(ep->sys);
+		else
+			ipa3_replenish_rx_cache(ep->sys);
+	}
 
 	if (IPA_CLIENT_IS_WLAN_CONS(sys_in->client)) {
 		ipa3_alloc_wlan_rx_common_cache(IPA_WLAN_COMM_RX_POOL_LOW);
@@ -1184,6 +1221,7 @@ int ipa3_setup_sys_pipe(struct ipa_sys_connect_params *sys_in, u32 *clnt_hdl)
 	ep->sys->repl->capacity = 0;
 	kfree(ep->sys->repl);
 fail_gen2:
+	page_pool_destroy(ep->sys->page_pool);
 	if (ipa3_ctx->use_ipa_pm)
 		ipa_pm_deregister(ep->sys->pm_hdl);
 fail_pm:
@@ -1300,7 +1338,10 @@ static int ipa_setup_coal_def_pipe(struct ipa_sys_connect_params *sys_in,
 	}
 
 	ep->sys->repl = ep_coalescing->sys->repl;
-	ipa3_replenish_rx_cache(ep->sys);
+	if (ep->sys->page_pool)
+		ipa3_replenish_rx_page_recycle(ep->sys);
+	else
+		ipa3_replenish_rx_cache(ep->sys);
 
 	ipa3_ctx->skip_ep_cfg_shadow[ipa_ep_idx] = ep->skip_ep_cfg;
 
@@ -1324,6 +1365,8 @@ static int ipa_setup_coal_def_pipe(struct ipa_sys_connect_params *sys_in,
 fail_start_channel:
 	ipa3_disable_data_path(ipa_ep_idx);
 fail_wq:
+	if (ep->sys)
+		page_pool_destroy(ep->sys->page_pool);
 	kfree(ep->sys);
 	memset(&ipa3_ctx->ep[ipa_ep_idx], 0, sizeof(struct ipa3_ep_context));
 fail_gen:
@@ -1564,6 +1607,23 @@ void ipa3_tx_cmd_comp(void *user1, int user2)
 	ipahal_destroy_imm_cmd(user1);
 }
 
+/*
+ * Ring the doorbell for transfers left behind a deferred doorbell, for
+ * when the packet that was to ring it could not be queued.
+ */
+static void ipa3_tx_flush_db(struct ipa3_sys_context *sys)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&sys->spinlock, flags);
+	sys->tx_db_defer = false;
+	if (sys->tx_db_pending) {
+		gsi_queue_xfer(sys->ep->gsi_chan_hdl, 0, NULL, true);
+		sys->tx_db_pending = false;
+	}
+	spin_unlock_irqrestore(&sys->spinlock, flags);
+}
+
 /**
  * ipa3_tx_dp() - Data-path tx handler
  * @dst:	[in] which IPA destination to route tx packets to
@@ -1595,7 +1655,7 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 	struct ipa3_desc _desc[3];
 	int dst_ep_idx;
 	struct ipahal_imm_cmd_pyld *cmd_pyld = NULL;
-	struct ipa3_sys_context *sys;
+	struct ipa3_sys_context *sys = NULL;
 	int src_ep_idx;
 	int num_frags, f;
 	const struct ipa_gsi_ep_config *gsi_ep;
@@ -1687,6 +1747,14 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 		desc = &_desc[0];
 	}
 
+	/*
+	 * The stack serialises callers per pipe under its TX queue lock. It
+	 * only sends the rest of an xmit_more burst while the queue runs.
+	 */
+	sys->tx_db_defer = tx_db_batch && skb->xmit_more &&
+		!(skb->dev &&
+		  netif_xmit_stopped(skb_get_tx_queue(skb->dev, skb)));
+
 	if (dst_ep_idx != -1) {
 		/* SW data path */
 		data_idx = 0;
@@ -1794,6 +1862,7 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 		}
 		IPA_STATS_INC_CNT(ipa3_ctx->stats.tx_hw_pkts);
 	}
+	sys->tx_db_defer = false;
 
 	if (num_frags) {
 		kfree(desc);
@@ -1807,11 +1876,40 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 	if (num_frags)
 		kfree(desc);
 fail_gen:
+	if (sys)
+		ipa3_tx_flush_db(sys);
 	return -EFAULT;
 fail_pipe_not_valid:
 	return -EPIPE;
 }
 
+/**
+ * ipa3_tx_dp_flush() - Ring a doorbell deferred by ipa3_tx_dp()
+ * @dst:	[in] the client passed to ipa3_tx_dp()
+ *
+ * Callers batching with skb->xmit_more must call this when they return
+ * early for a packet and so will not pass it to ipa3_tx_dp().
+ */
+void ipa3_tx_dp_flush(enum ipa_client_type dst)
+{
+	int src_ep_idx;
+	struct ipa3_sys_context *sys;
+
+	if (unlikely(!ipa3_ctx))
+		return;
+
+	if (IPA_CLIENT_IS_CONS(dst))
+		src_ep_idx = ipa3_get_ep_mapping(IPA_CLIENT_APPS_LAN_PROD);
+	else
+		src_ep_idx = ipa3_get_ep_mapping(dst);
+	if (src_ep_idx == -1)
+		return;
+
+	sys = ipa3_ctx->ep[src_ep_idx].sys;
+	if (sys && sys->ep->valid)
+		ipa3_tx_flush_db(sys);
+}
+
 static void ipa3_wq_handle_rx(struct work_struct *work)
 {
 	struct ipa3_sys_context *sys;
@@ -2052,6 +2150,26 @@ static void ipa3_alloc_wlan_rx_common_cache(u32 size)
 }
 
 
+/*
+ * Account a replenish pass that could not get a buffer. A pipe left
+ * with no buffer posted at all is counted separately: that is when the
+ * hardware starts to back-pressure and drop.
+ */
+static void ipa3_count_repl_fail(struct ipa3_sys_context *sys,
+		int rx_len_cached)
+{
+	if (sys->ep->client == IPA_CLIENT_APPS_WAN_CONS ||
+		sys->ep->client == IPA_CLIENT_APPS_WAN_COAL_CONS) {
+		IPA_STATS_INC_CNT(ipa3_ctx->stats.wan_repl_alloc_fail);
+		if (!rx_len_cached)
+			IPA_STATS_INC_CNT(ipa3_ctx->stats.wan_repl_starved);
+	} else if (sys->ep->client == IPA_CLIENT_APPS_LAN_CONS) {
+		IPA_STATS_INC_CNT(ipa3_ctx->stats.lan_repl_alloc_fail);
+		if (!rx_len_cached)
+			IPA_STATS_INC_CNT(ipa3_ctx->stats.lan_repl_starved);
+	}
+}
+
 /**
  * ipa3_replenish_rx_cache() - Replenish the Rx packets cache.
  *
@@ -2140,6 +2258,107 @@ static void ipa3_replenish_rx_cache(struct ipa3_sys_context *sys)
 fail_skb_alloc:
 	kmem_cache_free(ipa3_ctx->rx_pkt_wrapper_cache, rx_pkt);
 fail_kmem_cache_alloc:
+	ipa3_count_repl_fail(sys, rx_len_cached);
+	if (rx_len_cached == 0)
+		queue_delayed_work(sys->wq, &sys->replenish_rx_work,
+				msecs_to_jiffies(1));
+done:
+	/* only ring doorbell once here */
+	ret = gsi_queue_xfer(sys->ep->gsi_chan_hdl, idx,
+		gsi_xfer_elem_array, true);
+	if (ret == GSI_STATUS_SUCCESS) {
+		sys->len = rx_len_cached;
+	} else {
+		/* we don't expect this will happen */
+		IPAERR("failed to provide buffer: %d\n", ret);
+		WARN_ON(1);
+	}
+}
+
+/**
+ * ipa3_replenish_rx_page_recycle() - Replenish the Rx packets cache
+ * from the page pool of the pipe.
+ *
+ * Same as ipa3_replenish_rx_cache() but the buffers are pages which
+ * already carry their DMA mapping when the pool recycles them. The
+ * wrappers come back through rcycl_list as well, so in steady state a
+ * replenish only pops a wrapper and a page and writes the descriptor.
+ */
+static void ipa3_replenish_rx_page_recycle(struct ipa3_sys_context *sys)
+{
+	struct ipa3_rx_pkt_wrapper *rx_pkt;
+	int ret;
+	int idx = 0;
+	int rx_len_cached = 0;
+	struct gsi_xfer_elem gsi_xfer_elem_array[IPA_REPL_XFER_MAX];
+	gfp_t flag = GFP_NOWAIT | __GFP_NOWARN;
+
+	rx_len_cached = sys->len;
+
+	/* start replenish only when buffers go lower than the threshold */
+	if (sys->rx_pool_sz - sys->len < IPA_REPL_XFER_THRESH)
+		return;
+
+	while (rx_len_cached < sys->rx_pool_sz) {
+		rx_pkt = NULL;
+		spin_lock_bh(&sys->spinlock);
+		if (!list_empty(&sys->rcycl_list)) {
+			rx_pkt = list_first_entry(&sys->rcycl_list,
+				struct ipa3_rx_pkt_wrapper, link);
+			list_del_init(&rx_pkt->link);
+		}
+		spin_unlock_bh(&sys->spinlock);
+
+		if (!rx_pkt) {
+			rx_pkt = kmem_cache_zalloc(
+				ipa3_ctx->rx_pkt_wrapper_cache, flag);
+			if (!rx_pkt)
+				goto fail_kmem_cache_alloc;
+
+			INIT_LIST_HEAD(&rx_pkt->link);
+			INIT_WORK(&rx_pkt->work, ipa3_wq_rx_avail);
+			rx_pkt->sys = sys;
+		}
+
+		rx_pkt->page = page_pool_alloc_pages(sys->page_pool, flag);
+		if (!rx_pkt->page) {
+			IPAERR("failed to alloc page\n");
+			goto fail_page_alloc;
+		}
+		rx_pkt->data.dma_addr = page_pool_get_dma_addr(rx_pkt->page);
+
+		list_add_tail(&rx_pkt->link, &sys->head_desc_list);
+		gsi_xfer_elem_array[idx].addr = rx_pkt->data.dma_addr;
+		gsi_xfer_elem_array[idx].len = sys->rx_buff_sz;
+		gsi_xfer_elem_array[idx].flags = GSI_XFER_FLAG_EOT;
+		gsi_xfer_elem_array[idx].flags |= GSI_XFER_FLAG_EOB;
+		gsi_xfer_elem_array[idx].flags |= GSI_XFER_FLAG_BEI;
+		gsi_xfer_elem_array[idx].type = GSI_XFER_ELEM_DATA;
+		gsi_xfer_elem_array[idx].xfer_user_data = rx_pkt;
+		idx++;
+		rx_len_cached++;
+		/*
+		 * gsi_xfer_elem_buffer has a size of IPA_REPL_XFER_MAX.
+		 * If this size is reached we need to queue the xfers.
+		 */
+		if (idx == IPA_REPL_XFER_MAX) {
+			ret = gsi_queue_xfer(sys->ep->gsi_chan_hdl, idx,
+				gsi_xfer_elem_array, false);
+			if (ret != GSI_STATUS_SUCCESS) {
+				/* we don't expect this will happen */
+				IPAERR("failed to provide buffer: %d\n", ret);
+				WARN_ON(1);
+				break;
+			}
+			idx = 0;
+		}
+	}
+	goto done;
+
+fail_page_alloc:
+	sys->free_rx_wrapper(rx_pkt);
+fail_kmem_cache_alloc:
+	ipa3_count_repl_fail(sys, rx_len_cached);
 	if (rx_len_cached == 0)
 		queue_delayed_work(sys->wq, &sys->replenish_rx_work,
 				msecs_to_jiffies(1));
@@ -2250,6 +2469,7 @@ static void ipa3_replenish_rx_cache_recycle(struct ipa3_sys_context *sys)
 	INIT_LIST_HEAD(&rx_pkt->link);
 	spin_unlock_bh(&sys->spinlock);
 fail_kmem_cache_alloc:
+	ipa3_count_repl_fail(sys, rx_len_cached);
 	if (rx_len_cached == 0)
 		queue_delayed_work(sys->wq, &sys->replenish_rx_work,
 		msecs_to_jiffies(1));
@@ -2388,19 +2608,28 @@ static void ipa3_cleanup_rx(struct ipa3_sys_context *sys)
 	list_for_each_entry_safe(rx_pkt, r,
 				 &sys->head_desc_list, link) {
 		list_del(&rx_pkt->link);
-		dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
-			sys->rx_buff_sz, DMA_FROM_DEVICE);
-		sys->free_skb(rx_pkt->data.skb);
+		if (rx_pkt->page) {
+			page_pool_put_page(sys->page_pool, rx_pkt->page);
+		} else {
+			dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
+				sys->rx_buff_sz, DMA_FROM_DEVICE);
+			sys->free_skb(rx_pkt->data.skb);
+		}
 		kmem_cache_free(ipa3_ctx->rx_pkt_wrapper_cache, rx_pkt);
 	}
+	page_pool_destroy(sys->page_pool);
+	sys->page_pool = NULL;
 
 	spin_lock_bh(&sys->spinlock);
 	list_for_each_entry_safe(rx_pkt, r,
 				 &sys->rcycl_list, link) {
 		list_del(&rx_pkt->link);
-		dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
-			sys->rx_buff_sz, DMA_FROM_DEVICE);
-		sys->free_skb(rx_pkt->data.skb);
+		/* page pool wrappers are parked without a buffer */
+		if (rx_pkt->data.skb) {
+			dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
+				sys->rx_buff_sz, DMA_FROM_DEVICE);
+			sys->free_skb(rx_pkt->data.skb);
+		}
 		kmem_cache_free(ipa3_ctx->rx_pkt_wrapper_cache, rx_pkt);
 	}
 	spin_unlock_bh(&sys->spinlock);
@@ -3001,6 +3230,36 @@ static void ipa3_recycle_rx_wrapper(struct ipa3_rx_pkt_wrapper *rx_pkt)
 	spin_unlock_bh(&rx_pkt->sys->spinlock);
 }
 
+/*
+ * Wrap a received page pool buffer in an skb. The skb takes its own
+ * page reference and the pool gets the page back right away, it hands
+ * the page out again once rmnet released every packet cut from it.
+ */
+static struct sk_buff *ipa3_rx_page_to_skb(struct ipa3_sys_context *sys,
+		struct ipa3_rx_pkt_wrapper *rx_pkt)
+{
+	struct page *page = rx_pkt->page;
+	struct sk_buff *skb;
+
+	dma_sync_single_for_cpu(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
+		rx_pkt->len, DMA_FROM_DEVICE);
+
+	skb = sys->get_skb(0, GFP_ATOMIC);
+	if (unlikely(!skb)) {
+		IPAERR("failed to alloc skb\n");
+		page_pool_put_page(sys->page_pool, page);
+		return NULL;
+	}
+
+	get_page(page);
+	skb_add_rx_frag(skb, 0, page, 0, rx_pkt->len,
+			page_pool_buf_size(sys->page_pool));
+	page_pool_put_page(sys->page_pool, page);
+	*(unsigned int *)skb->cb = skb->len;
+
+	return skb;
+}
+
 static void ipa3_wq_rx_common(struct ipa3_sys_context *sys, u32 size)
 {
 	struct ipa3_rx_pkt_wrapper *rx_pkt_expected;
@@ -3019,6 +3278,14 @@ static void ipa3_wq_rx_common(struct ipa3_sys_context *sys, u32 size)
 	if (size)
 		rx_pkt_expected->len = size;
 	spin_unlock_bh(&sys->spinlock);
+	if (sys->page_pool) {
+		rx_skb = ipa3_rx_page_to_skb(sys, rx_pkt_expected);
+		if (rx_skb)
+			sys->pyld_hdlr(rx_skb, sys);
+		sys->free_rx_wrapper(rx_pkt_expected);
+		sys->repl_hdlr(sys);
+		return;
+	}
 	rx_skb = rx_pkt_expected->data.skb;
 	dma_unmap_single(ipa3_ctx->pdev, rx_pkt_expected->data.dma_addr,
 			sys->rx_buff_sz, DMA_FROM_DEVICE);
@@ -3053,11 +3320,20 @@ static void ipa3_wq_rx_napi_chain(struct ipa3_sys_context *sys,
 		if (mem_info[i].size)
 			rx_pkt_expected->len = mem_info[i].size;
 		spin_unlock_bh(&sys->spinlock);
-		rx_skb = rx_pkt_expected->data.skb;
-		dma_unmap_single(ipa3_ctx->pdev, rx_pkt_expected->data.dma_addr,
-				sys->rx_buff_sz, DMA_FROM_DEVICE);
-		skb_set_tail_pointer(rx_skb, rx_pkt_expected->len);
-		rx_skb->len = rx_pkt_expected->len;
+		if (sys->page_pool) {
+			rx_skb = ipa3_rx_page_to_skb(sys, rx_pkt_expected);
+			if (!rx_skb) {
+				sys->free_rx_wrapper(rx_pkt_expected);
+				continue;
+			}
+		} else {
+			rx_skb = rx_pkt_expected->data.skb;
+			dma_unmap_single(ipa3_ctx->pdev,
+					rx_pkt_expected->data.dma_addr,
+					sys->rx_buff_sz, DMA_FROM_DEVICE);
+			skb_set_tail_pointer(rx_skb, rx_pkt_expected->len);
+			rx_skb->len = rx_pkt_expected->len;
+		}
 
 		if (!first_skb)
 			first_skb = rx_skb;
@@ -3069,8 +3345,11 @@ static void ipa3_wq_rx_napi_chain(struct ipa3_sys_context *sys,
 		sys->free_rx_wrapper(rx_pkt_expected);
 	}
 
-	skb_shinfo(prev_skb)->frag_list = NULL;
-	sys->pyld_hdlr(first_skb, sys);
+	/* page pool pipes drop the buffers they fail to wrap */
+	if (likely(prev_skb)) {
+		skb_shinfo(prev_skb)->frag_list = NULL;
+		sys->pyld_hdlr(first_skb, sys);
+	}
 	sys->repl_hdlr(sys);
 }
 
@@ -3163,6 +3442,19 @@ static void ipa3_free_rx_wrapper(struct ipa3_rx_pkt_wrapper *rk_pkt)
 	kmem_cache_free(ipa3_ctx->rx_pkt_wrapper_cache, rk_pkt);
 }
 
+/*
+ * The page went back to the pool (or up the stack) already, only park
+ * the wrapper for ipa3_replenish_rx_page_recycle() to reuse.
+ */
+static void ipa3_recycle_page_rx_wrapper(struct ipa3_rx_pkt_wrapper *rx_pkt)
+{
+	rx_pkt->page = NULL;
+	rx_pkt->data.dma_addr = 0;
+	spin_lock_bh(&rx_pkt->sys->spinlock);
+	list_add_tail(&rx_pkt->link, &rx_pkt->sys->rcycl_list);
+	spin_unlock_bh(&rx_pkt->sys->spinlock);
+}
+
 static void ipa3_set_aggr_limit(struct ipa_sys_connect_params *in,
 		struct ipa3_sys_context *sys)
 {
@@ -3190,6 +3482,33 @@ static void ipa3_set_aggr_limit(struct ipa_sys_connect_params *in,
 	IPAERR("set aggr_limit %lu\n", (unsigned long int) *aggr_byte_limit);
 }
 
+/*
+ * Switch a WAN pipe to page pool buffers, the pipe keeps using skbs if
+ * the pool can't be created.
+ */
+static void ipa3_create_rx_page_pool(struct ipa3_sys_context *sys)
+{
+	struct page_pool_params pp = {
+		.flags = PP_FLAG_DMA_MAP,
+		.order = get_order(sys->rx_buff_sz),
+		/* room for the ring and as many pages in flight */
+		.pool_size = 2 * sys->rx_pool_sz,
+		.dev = ipa3_ctx->pdev,
+		.dma_dir = DMA_FROM_DEVICE,
+	};
+	struct page_pool *pool;
+
+	pool = page_pool_create(&pp);
+	if (IS_ERR(pool)) {
+		IPAERR("page pool failed %ld, using skbs\n", PTR_ERR(pool));
+		return;
+	}
+
+	sys->page_pool = pool;
+	sys->repl_hdlr = ipa3_replenish_rx_page_recycle;
+	sys->free_rx_wrapper = ipa3_recycle_page_rx_wrapper;
+}
+
 static int ipa3_assign_policy(struct ipa_sys_connect_params *in,
 		struct ipa3_sys_context *sys)
 {
@@ -3293,6 +3612,8 @@ static int ipa3_assign_policy(struct ipa_sys_connect_params *in,
 					= true;
 				if (apps_wan_cons_agg_gro_flag) {
 					ipa3_set_aggr_limit(in, sys);
+					if (wan_rx_page_pool)
+						ipa3_create_rx_page_pool(sys);
 				} else {
 					in->ipa_ep_cfg.aggr.aggr_byte_limit =
 					IPA_GENERIC_AGGR_BYTE_LIMIT;
@@ -4357,6 +4678,54 @@ static int ipa_poll_gsi_n_pkt(struct ipa3_sys_context *sys,
 	return ret;
 }
 
+/*
+ * Pick the event ring moderation for the packet rate of the last
+ * IPA_DIM_WINDOW_MS and program it when the level changes.
+ */
+static void ipa3_rx_dim_update(struct ipa3_sys_context *sys, int cnt)
+{
+	unsigned long now = jiffies;
+	unsigned long elapsed;
+	u32 rate;
+	u16 modt;
+	u8 modc;
+
+	if (!sys->dim_ts) {
+		sys->dim_ts = now;
+		return;
+	}
+
+	sys->dim_pkts += cnt;
+	elapsed = now - sys->dim_ts;
+	if (elapsed < msecs_to_jiffies(IPA_DIM_WINDOW_MS))
+		return;
+
+	rate = (u32)div_u64((u64)sys->dim_pkts * HZ, elapsed);
+	sys->dim_pkts = 0;
+	sys->dim_ts = now;
+
+	if (rate < IPA_DIM_LOW_PPS) {
+		modt = IPA_GSI_EVT_RING_INT_MODT / 4;
+		modc = 1;
+	} else if (rate > IPA_DIM_HIGH_PPS) {
+		modt = IPA_GSI_EVT_RING_INT_MODT * 4;
+		modc = IPA_GSI_EVT_RING_INT_MODC * 2;
+	} else {
+		modt = IPA_GSI_EVT_RING_INT_MODT;
+		modc = IPA_GSI_EVT_RING_INT_MODC;
+	}
+
+	if (modt == sys->dim_modt)
+		return;
+
+	if (gsi_set_evt_ring_int_mod(sys->ep->gsi_evt_ring_hdl, modt,
+			modc) == GSI_STATUS_SUCCESS) {
+		IPADBG_LOW("ep %d rate %u pps modt %u modc %u\n",
+			ipa3_get_ep_mapping(sys->ep->client), rate, modt, modc);
+		sys->dim_modt = modt;
+	}
+}
+
 /**
  * ipa3_rx_poll() - Poll the rx packets from IPA HW. This
  * function is exectued in the softirq context
@@ -4420,6 +4789,8 @@ int ipa3_rx_poll(u32 clnt_hdl, int weight)
 		}
 	}
 	cnt += weight - remain_aggr_weight * IPA_WAN_AGGR_PKT_CNT;
+	if (rx_adaptive_modt)
+		ipa3_rx_dim_update(ep->sys, cnt);
 	if (cnt < weight) {
 		napi_complete(ep->sys->napi_obj);
 		ret = ipa3_rx_switch_to_intr_mode(ep->sys);
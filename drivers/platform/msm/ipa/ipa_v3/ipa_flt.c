@@ -500,6 +500,8 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 	u32 tbl_hdr_width;
 	struct ipa3_flt_tbl *tbl;
 	u16 entries;
+	struct ipa3_fltrt_shadow *shadow = &ipa3_ctx->flt_shadow[ip];
+	bool hash_dirty;
 
 	tbl_hdr_width = ipahal_get_hw_tbl_hdr_width();
 	memset(&alloc_params, 0, sizeof(alloc_params));
@@ -584,11 +586,18 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 		goto fail_size_valid;
 	}
 
+	hash_dirty = ipa3_fltrt_shadow_differs(shadow, IPA_RULE_HASHABLE,
+		true, 0, alloc_params.hash_hdr.base,
+		alloc_params.hash_hdr.size) ||
+		(lcl_hash && ipa3_fltrt_shadow_differs(shadow,
+		IPA_RULE_HASHABLE, false, 0, alloc_params.hash_bdy.base,
+		alloc_params.hash_bdy.size));
+
 	/*
 	 * SRAM memory not allocated to hash tables. Sending
 	 * command to hash tables(filer/routing) operation not supported.
 	 */
-	if (!ipa3_ctx->ipa_fltrt_not_hashable) {
+	if (!ipa3_ctx->ipa_fltrt_not_hashable && hash_dirty) {
 		/* flushing ipa internal hashable flt rules cache */
 		memset(&flush, 0, sizeof(flush));
 		if (ip == IPA_IP_v4)
@@ -637,30 +646,41 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 		IPADBG_LOW("Prepare imm cmd for hdr at index %d for pipe %d\n",
 			hdr_idx, i);
 
-		mem_cmd.is_read = false;
-		mem_cmd.skip_pipeline_clear = false;
-		mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
-		mem_cmd.size = tbl_hdr_width;
-		mem_cmd.system_addr = alloc_params.nhash_hdr.phys_base +
-			hdr_idx * tbl_hdr_width;
-		mem_cmd.local_addr = lcl_nhash_hdr +
-			hdr_idx * tbl_hdr_width;
-		cmd_pyld[num_cmd] = ipahal_construct_imm_cmd(
-			IPA_IMM_CMD_DMA_SHARED_MEM, &mem_cmd, false);
-		if (!cmd_pyld[num_cmd]) {
-			IPAERR("fail construct dma_shared_mem cmd: IP = %d\n",
-				ip);
-			rc = -ENOMEM;
-			goto fail_imm_cmd_construct;
+		if (ipa3_fltrt_shadow_differs(shadow, IPA_RULE_NON_HASHABLE,
+			true, hdr_idx * tbl_hdr_width,
+			alloc_params.nhash_hdr.base + hdr_idx * tbl_hdr_width,
+			tbl_hdr_width)) {
+			mem_cmd.is_read = false;
+			mem_cmd.skip_pipeline_clear = false;
+			mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
+			mem_cmd.size = tbl_hdr_width;
+			mem_cmd.system_addr = alloc_params.nhash_hdr.phys_base +
+				hdr_idx * tbl_hdr_width;
+			mem_cmd.local_addr = lcl_nhash_hdr +
+				hdr_idx * tbl_hdr_width;
+			cmd_pyld[num_cmd] = ipahal_construct_imm_cmd(
+				IPA_IMM_CMD_DMA_SHARED_MEM, &mem_cmd, false);
+			if (!cmd_pyld[num_cmd]) {
+				IPAERR(
+				"fail construct dma_shared_mem cmd: IP = %d\n",
+					ip);
+				rc = -ENOMEM;
+				goto fail_imm_cmd_construct;
+			}
+			ipa3_init_imm_cmd_desc(&desc[num_cmd],
+						cmd_pyld[num_cmd]);
+			++num_cmd;
 		}
-		ipa3_init_imm_cmd_desc(&desc[num_cmd], cmd_pyld[num_cmd]);
-		++num_cmd;
 
 		/*
 		 * SRAM memory not allocated to hash tables. Sending command
 		 * to hash tables(filer/routing) operation not supported.
 		 */
-		if (!ipa3_ctx->ipa_fltrt_not_hashable) {
+		if (!ipa3_ctx->ipa_fltrt_not_hashable &&
+			ipa3_fltrt_shadow_differs(shadow, IPA_RULE_HASHABLE,
+			true, hdr_idx * tbl_hdr_width,
+			alloc_params.hash_hdr.base + hdr_idx * tbl_hdr_width,
+			tbl_hdr_width)) {
 			mem_cmd.is_read = false;
 			mem_cmd.skip_pipeline_clear = false;
 			mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
@@ -686,7 +706,9 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 		++hdr_idx;
 	}
 
-	if (lcl_nhash) {
+	if (lcl_nhash && ipa3_fltrt_shadow_differs(shadow,
+		IPA_RULE_NON_HASHABLE, false, 0, alloc_params.nhash_bdy.base,
+		alloc_params.nhash_bdy.size)) {
 		if (num_cmd >= entries) {
 			IPAERR("number of commands is out of range: IP = %d\n",
 				ip);
@@ -711,7 +733,9 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 		ipa3_init_imm_cmd_desc(&desc[num_cmd], cmd_pyld[num_cmd]);
 		++num_cmd;
 	}
-	if (lcl_hash) {
+	if (lcl_hash && ipa3_fltrt_shadow_differs(shadow,
+		IPA_RULE_HASHABLE, false, 0, alloc_params.hash_bdy.base,
+		alloc_params.hash_bdy.size)) {
 		if (num_cmd >= entries) {
 			IPAERR("number of commands is out of range: IP = %d\n",
 				ip);
@@ -737,11 +761,13 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 		++num_cmd;
 	}
 
-	if (ipa3_send_cmd(num_cmd, desc)) {
+	if (num_cmd && ipa3_send_cmd(num_cmd, desc)) {
 		IPAERR("fail to send immediate command\n");
+		ipa3_fltrt_shadow_invalidate(shadow);
 		rc = -EFAULT;
 		goto fail_imm_cmd_construct;
 	}
+	ipa3_fltrt_shadow_update(shadow, &alloc_params, lcl_hash, lcl_nhash);
 
 	IPADBG_LOW("Hashable HEAD\n");
 	IPA_DUMP_BUFF(alloc_params.hash_hdr.base,
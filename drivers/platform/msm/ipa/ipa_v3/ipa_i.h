@@ -40,6 +40,7 @@
 #include "ipa_pm.h"
 #include <linux/mailbox_client.h>
 #include <linux/mailbox/qmp.h>
+#include <net/page_pool.h>
 
 #define IPA_DEV_NAME_MAX_LEN 15
 #define DRV_NAME "ipa"
@@ -662,6 +663,22 @@ struct ipa3_flt_tbl {
 	struct idr *rule_ids;
 };
 
+/**
+ * struct ipa3_fltrt_shadow - copy of the flt/rt images last written to SRAM
+ * @valid: the copy matches what the HW holds
+ * @hdr: header images, per rule type
+ * @hdr_sz: size of @hdr
+ * @bdy: local body images, per rule type
+ * @bdy_sz: size of @bdy
+ */
+struct ipa3_fltrt_shadow {
+	bool valid;
+	u8 *hdr[IPA_RULE_TYPE_MAX];
+	u32 hdr_sz[IPA_RULE_TYPE_MAX];
+	u8 *bdy[IPA_RULE_TYPE_MAX];
+	u32 bdy_sz[IPA_RULE_TYPE_MAX];
+};
+
 /**
  * struct ipa3_rt_entry - IPA routing table entry
  * @link: entry's link in global routing table entries list
@@ -882,6 +899,12 @@ struct ipa3_repl_ctx {
  * @len: the size of the above list
  * @spinlock: protects the list and its size
  * @ep: IPA EP context
+ * @page_pool: recycled DMA mapped RX pages, NULL when the pipe uses skbs
+ * @tx_db_defer: queue the next transfer without ringing the doorbell
+ * @tx_db_pending: transfers were queued behind a deferred doorbell
+ * @dim_pkts: packets polled in the current moderation window
+ * @dim_ts: start of the current moderation window, in jiffies
+ * @dim_modt: moderation timer currently programmed on the event ring
  *
  * IPA context specific to the GPI pipes a.k.a LAN IN/OUT and WAN
  */
@@ -911,6 +934,12 @@ struct ipa3_sys_context {
 	struct ipa3_repl_ctx *repl;
 	u32 pkt_sent;
 	struct napi_struct *napi_obj;
+	struct page_pool *page_pool;
+	bool tx_db_defer;
+	bool tx_db_pending;
+	u32 dim_pkts;
+	unsigned long dim_ts;
+	u16 dim_modt;
 
 	/* ordering is important - mutable fields go above */
 	struct ipa3_ep_context *ep;
@@ -1030,11 +1059,13 @@ struct ipa3_desc {
  * @dma_address: DMA address of this Rx packet
  * @link: linked to the Rx packets on that pipe
  * @len: how many bytes are copied into skb's flat buffer
+ * @page: page pool buffer used instead of the skb on page pool pipes
  */
 struct ipa3_rx_pkt_wrapper {
 	struct list_head link;
 	struct ipa_rx_data data;
 	u32 len;
+	struct page *page;
 	struct work_struct work;
 	struct ipa3_sys_context *sys;
 };
@@ -1184,6 +1215,10 @@ struct ipa3_stats {
 	u32 wan_repl_rx_empty;
 	u32 lan_rx_empty;
 	u32 lan_repl_rx_empty;
+	u32 wan_repl_alloc_fail;
+	u32 wan_repl_starved;
+	u32 lan_repl_alloc_fail;
+	u32 lan_repl_starved;
 	u32 flow_enable;
 	u32 flow_disable;
 	u32 tx_non_linear;
@@ -1562,6 +1597,8 @@ struct ipa3_context {
 	struct ipa3_hdr_proc_ctx_tbl hdr_proc_ctx_tbl;
 	struct ipa3_rt_tbl_set rt_tbl_set[IPA_IP_MAX];
 	struct ipa3_rt_tbl_set reap_rt_tbl_set[IPA_IP_MAX];
+	struct ipa3_fltrt_shadow flt_shadow[IPA_IP_MAX];
+	struct ipa3_fltrt_shadow rt_shadow[IPA_IP_MAX];
 	struct kmem_cache *flt_rule_cache;
 	struct kmem_cache *rt_rule_cache;
 	struct kmem_cache *hdr_cache;
@@ -2208,6 +2245,7 @@ int ipa3_set_single_ndp_per_mbim(bool enable);
  */
 int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 		struct ipa_tx_meta *metadata);
+void ipa3_tx_dp_flush(enum ipa_client_type dst);
 
 /*
  * To transfer multiple data packets
@@ -2506,6 +2544,13 @@ int _ipa_init_flt6_v3(void);
 int __ipa_commit_flt_v3(enum ipa_ip_type ip);
 int __ipa_commit_rt_v3(enum ipa_ip_type ip);
 
+bool ipa3_fltrt_shadow_differs(struct ipa3_fltrt_shadow *shadow,
+	enum ipa_rule_type rlt, bool hdr, u32 ofst, const u8 *buf, u32 len);
+void ipa3_fltrt_shadow_update(struct ipa3_fltrt_shadow *shadow,
+	struct ipahal_fltrt_alloc_imgs_params *imgs, bool lcl_hash,
+	bool lcl_nhash);
+void ipa3_fltrt_shadow_invalidate(struct ipa3_fltrt_shadow *shadow);
+
 int __ipa_commit_hdr_v3_0(void);
 void ipa3_skb_recycle(struct sk_buff *skb);
 void ipa3_install_dflt_flt_rules(u32 ipa_ep_idx);
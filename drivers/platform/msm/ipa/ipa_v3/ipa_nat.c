@@ -36,7 +36,11 @@
 
 #define IPA_NAT_MAX_NUM_OF_INIT_CMD_DESC 3
 #define IPA_IPV6CT_MAX_NUM_OF_INIT_CMD_DESC 2
-#define IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC 4
+/*
+ * One NOP plus the TABLE_DMA commands of a batch; bounded by what fits
+ * in the APPS_CMD_PROD ring while other commands are in flight.
+ */
+#define IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC 64
 
 /*
  * The base table max entries is limited by index into table 13 bits number.
@@ -1287,8 +1291,8 @@ int ipa3_table_dma_cmd(struct ipa_ioc_nat_dma_cmd *dma)
 {
 	struct ipahal_imm_cmd_table_dma cmd;
 	enum ipahal_imm_cmd_name cmd_name = IPA_IMM_CMD_NAT_DMA;
-	struct ipahal_imm_cmd_pyld *cmd_pyld[IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC];
-	struct ipa3_desc desc[IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC];
+	struct ipahal_imm_cmd_pyld **cmd_pyld;
+	struct ipa3_desc *desc;
 	uint8_t cnt, num_cmd = 0;
 	int result = 0;
 
@@ -1315,6 +1319,14 @@ int ipa3_table_dma_cmd(struct ipa_ioc_nat_dma_cmd *dma)
 		}
 	}
 
+	/* the whole batch goes down as one command chain: one extra for NOP */
+	desc = kcalloc(dma->entries + 1, sizeof(*desc), GFP_KERNEL);
+	cmd_pyld = kcalloc(dma->entries + 1, sizeof(*cmd_pyld), GFP_KERNEL);
+	if (!desc || !cmd_pyld) {
+		result = -ENOMEM;
+		goto free_desc;
+	}
+
 	/* NO-OP IC for ensuring that IPA pipeline is empty */
 	cmd_pyld[num_cmd] =
 		ipahal_construct_nop_imm_cmd(false, IPAHAL_HPS_CLEAR, false);
@@ -1354,6 +1366,9 @@ int ipa3_table_dma_cmd(struct ipa_ioc_nat_dma_cmd *dma)
 destroy_imm_cmd:
 	for (cnt = 0; cnt < num_cmd; ++cnt)
 		ipahal_destroy_imm_cmd(cmd_pyld[cnt]);
+free_desc:
+	kfree(cmd_pyld);
+	kfree(desc);
 bail:
 	return result;
 }
@@ -483,6 +483,8 @@ int __ipa_commit_rt_v3(enum ipa_ip_type ip)
 	struct ipa3_rt_tbl_set *set;
 	struct ipa3_rt_tbl *tbl;
 	u32 tbl_hdr_width;
+	struct ipa3_fltrt_shadow *shadow = &ipa3_ctx->rt_shadow[ip];
+	bool hash_dirty;
 
 	tbl_hdr_width = ipahal_get_hw_tbl_hdr_width();
 	memset(desc, 0, sizeof(desc));
@@ -573,11 +575,18 @@ int __ipa_commit_rt_v3(enum ipa_ip_type ip)
 		goto fail_size_valid;
 	}
 
+	hash_dirty = ipa3_fltrt_shadow_differs(shadow, IPA_RULE_HASHABLE,
+		true, 0, alloc_params.hash_hdr.base,
+		alloc_params.hash_hdr.size) ||
+		(lcl_hash && ipa3_fltrt_shadow_differs(shadow,
+		IPA_RULE_HASHABLE, false, 0, alloc_params.hash_bdy.base,
+		alloc_params.hash_bdy.size));
+
 	/*
 	 * SRAM memory not allocated to hash tables. Sending
 	 * command to hash tables(filer/routing) operation not supported.
 	 */
-	if (!ipa3_ctx->ipa_fltrt_not_hashable) {
+	if (!ipa3_ctx->ipa_fltrt_not_hashable && hash_dirty) {
 		/* flushing ipa internal hashable rt rules cache */
 		memset(&flush, 0, sizeof(flush));
 		if (ip == IPA_IP_v4)
@@ -603,26 +612,32 @@ int __ipa_commit_rt_v3(enum ipa_ip_type ip)
 		num_cmd++;
 	}
 
-	mem_cmd.is_read = false;
-	mem_cmd.skip_pipeline_clear = false;
-	mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
-	mem_cmd.size = alloc_params.nhash_hdr.size;
-	mem_cmd.system_addr = alloc_params.nhash_hdr.phys_base;
-	mem_cmd.local_addr = lcl_nhash_hdr;
-	cmd_pyld[num_cmd] = ipahal_construct_imm_cmd(
-		IPA_IMM_CMD_DMA_SHARED_MEM, &mem_cmd, false);
-	if (!cmd_pyld[num_cmd]) {
-		IPAERR("fail construct dma_shared_mem imm cmd. IP %d\n", ip);
-		goto fail_imm_cmd_construct;
+	if (ipa3_fltrt_shadow_differs(shadow, IPA_RULE_NON_HASHABLE, true, 0,
+		alloc_params.nhash_hdr.base, alloc_params.nhash_hdr.size)) {
+		mem_cmd.is_read = false;
+		mem_cmd.skip_pipeline_clear = false;
+		mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
+		mem_cmd.size = alloc_params.nhash_hdr.size;
+		mem_cmd.system_addr = alloc_params.nhash_hdr.phys_base;
+		mem_cmd.local_addr = lcl_nhash_hdr;
+		cmd_pyld[num_cmd] = ipahal_construct_imm_cmd(
+			IPA_IMM_CMD_DMA_SHARED_MEM, &mem_cmd, false);
+		if (!cmd_pyld[num_cmd]) {
+			IPAERR("fail construct dma_shared_mem imm cmd. IP %d\n",
+				ip);
+			goto fail_imm_cmd_construct;
+		}
+		ipa3_init_imm_cmd_desc(&desc[num_cmd], cmd_pyld[num_cmd]);
+		num_cmd++;
 	}
-	ipa3_init_imm_cmd_desc(&desc[num_cmd], cmd_pyld[num_cmd]);
-	num_cmd++;
 
 	/*
 	 * SRAM memory not allocated to hash tables. Sending
 	 * command to hash tables(filer/routing) operation not supported.
 	 */
-	if (!ipa3_ctx->ipa_fltrt_not_hashable) {
+	if (!ipa3_ctx->ipa_fltrt_not_hashable &&
+		ipa3_fltrt_shadow_differs(shadow, IPA_RULE_HASHABLE, true, 0,
+		alloc_params.hash_hdr.base, alloc_params.hash_hdr.size)) {
 		mem_cmd.is_read = false;
 		mem_cmd.skip_pipeline_clear = false;
 		mem_cmd.pipeline_clear_options = IPAHAL_HPS_CLEAR;
@@ -640,7 +655,9 @@ int __ipa_commit_rt_v3(enum ipa_ip_type ip)
 		num_cmd++;
 	}
 
-	if (lcl_nhash) {
+	if (lcl_nhash && ipa3_fltrt_shadow_differs(shadow,
+		IPA_RULE_NON_HASHABLE, false, 0, alloc_params.nhash_bdy.base,
+		alloc_params.nhash_bdy.size)) {
 		if (num_cmd >= IPA_RT_MAX_NUM_OF_COMMIT_TABLES_CMD_DESC) {
 			IPAERR("number of commands is out of range: IP = %d\n",
 				ip);
@@ -664,7 +681,9 @@ int __ipa_commit_rt_v3(enum ipa_ip_type ip)
 		ipa3_init_imm_cmd_desc(&desc[num_cmd], cmd_pyld[num_cmd]);
 		num_cmd++;
 	}
-	if (lcl_hash) {
+	if (lcl_hash && ipa3_fltrt_shadow_differs(shadow,
+		IPA_RULE_HASHABLE, false, 0, alloc_params.hash_bdy.base,
+		alloc_params.hash_bdy.size)) {
 		if (num_cmd >= IPA_RT_MAX_NUM_OF_COMMIT_TABLES_CMD_DESC) {
 			IPAERR("number of commands is out of range: IP = %d\n",
 				ip);
@@ -689,11 +708,13 @@ int __ipa_commit_rt_v3(enum ipa_ip_type ip)
 		num_cmd++;
 	}
 
-	if (ipa3_send_cmd(num_cmd, desc)) {
+	if (num_cmd && ipa3_send_cmd(num_cmd, desc)) {
 		IPAERR_RL("fail to send immediate command\n");
+		ipa3_fltrt_shadow_invalidate(shadow);
 		rc = -EFAULT;
 		goto fail_imm_cmd_construct;
 	}
+	ipa3_fltrt_shadow_update(shadow, &alloc_params, lcl_hash, lcl_nhash);
 
 	IPADBG_LOW("Hashable HEAD\n");
 	IPA_DUMP_BUFF(alloc_params.hash_hdr.base,
@@ -5544,6 +5544,126 @@ int ipa3_init_mem_partition(enum ipa_hw_type type)
 	return 0;
 }
 
+/*
+ * Only write the flt/rt header entries and local bodies that differ from
+ * what the previous commit left in SRAM, and skip the hash cache flush
+ * when no hashable table changed. Tables in system memory are rebuilt
+ * into a new buffer on every commit, so their header entries are always
+ * rewritten.
+ */
+static bool fltrt_delta_commit;
+module_param(fltrt_delta_commit, bool, 0644);
+MODULE_PARM_DESC(fltrt_delta_commit, "Write only changed flt/rt SRAM entries");
+
+/**
+ * ipa3_fltrt_shadow_differs() - check an image range against the shadow
+ * @shadow: flt or rt shadow of the ip family
+ * @rlt: hashable or non-hashable image
+ * @hdr: compare against the header image, else the local body image
+ * @ofst: offset of the range in the image
+ * @buf: the new content of the range
+ * @len: length of the range
+ *
+ * Return: true if the range has to be written to SRAM
+ */
+bool ipa3_fltrt_shadow_differs(struct ipa3_fltrt_shadow *shadow,
+	enum ipa_rule_type rlt, bool hdr, u32 ofst, const u8 *buf, u32 len)
+{
+	u8 *img = hdr ? shadow->hdr[rlt] : shadow->bdy[rlt];
+	u32 sz = hdr ? shadow->hdr_sz[rlt] : shadow->bdy_sz[rlt];
+
+	if (!fltrt_delta_commit || !shadow->valid)
+		return true;
+
+	if (!hdr && len != sz)
+		return true;
+
+	if (!img || ofst + len > sz)
+		return true;
+
+	return memcmp(img + ofst, buf, len) != 0;
+}
+
+static int ipa3_fltrt_shadow_copy(u8 **img, u32 *sz,
+	struct ipa_mem_buffer *mem)
+{
+	u8 *p;
+
+	if (!mem->size) {
+		*sz = 0;
+		return 0;
+	}
+
+	if (*sz != mem->size) {
+		p = krealloc(*img, mem->size, GFP_KERNEL);
+		if (!p)
+			return -ENOMEM;
+		*img = p;
+	}
+	memcpy(*img, mem->base, mem->size);
+	*sz = mem->size;
+
+	return 0;
+}
+
+/**
+ * ipa3_fltrt_shadow_update() - record the images a commit wrote to SRAM
+ * @shadow: flt or rt shadow of the ip family
+ * @imgs: the images that were committed
+ * @lcl_hash: the hashable body lives in SRAM
+ * @lcl_nhash: the non-hashable body lives in SRAM
+ *
+ * Caller needs to hold ipa3_ctx->lock
+ */
+void ipa3_fltrt_shadow_update(struct ipa3_fltrt_shadow *shadow,
+	struct ipahal_fltrt_alloc_imgs_params *imgs, bool lcl_hash,
+	bool lcl_nhash)
+{
+	struct ipa_mem_buffer none = {0};
+
+	if (!fltrt_delta_commit) {
+		ipa3_fltrt_shadow_invalidate(shadow);
+		return;
+	}
+
+	if (ipa3_fltrt_shadow_copy(&shadow->hdr[IPA_RULE_HASHABLE],
+		&shadow->hdr_sz[IPA_RULE_HASHABLE], &imgs->hash_hdr) ||
+	    ipa3_fltrt_shadow_copy(&shadow->hdr[IPA_RULE_NON_HASHABLE],
+		&shadow->hdr_sz[IPA_RULE_NON_HASHABLE], &imgs->nhash_hdr) ||
+	    ipa3_fltrt_shadow_copy(&shadow->bdy[IPA_RULE_HASHABLE],
+		&shadow->bdy_sz[IPA_RULE_HASHABLE],
+		lcl_hash ? &imgs->hash_bdy : &none) ||
+	    ipa3_fltrt_shadow_copy(&shadow->bdy[IPA_RULE_NON_HASHABLE],
+		&shadow->bdy_sz[IPA_RULE_NON_HASHABLE],
+		lcl_nhash ? &imgs->nhash_bdy : &none)) {
+		IPAERR_RL("no memory for flt/rt shadow, full commits\n");
+		ipa3_fltrt_shadow_invalidate(shadow);
+		return;
+	}
+
+	shadow->valid = true;
+}
+
+/**
+ * ipa3_fltrt_shadow_invalidate() - forget the recorded images so the next
+ *  commit writes all of SRAM
+ * @shadow: flt or rt shadow of the ip family
+ */
+void ipa3_fltrt_shadow_invalidate(struct ipa3_fltrt_shadow *shadow)
+{
+	int i;
+
+	shadow->valid = false;
+	for (i = 0; i < IPA_RULE_TYPE_MAX; i++) {
+		kfree(shadow->hdr[i]);
+		shadow->hdr[i] = NULL;
+		shadow->hdr_sz[i] = 0;
+		kfree(shadow->bdy[i]);
+		shadow->bdy[i] = NULL;
+		shadow->bdy_sz[i] = 0;
+	}
+}
+
 /**
  * ipa_ctrl_static_bind() - set the appropriate methods for
  *  IPA Driver based on the HW version
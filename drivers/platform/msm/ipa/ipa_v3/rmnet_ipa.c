@@ -1121,6 +1121,7 @@ static int ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 		current->comm);
 		dev_kfree_skb_any(skb);
 		dev->stats.tx_dropped++;
+		ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
 		return NETDEV_TX_OK;
 	}
 
@@ -1133,6 +1134,7 @@ static int ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 	if (atomic_read(&rmnet_ipa3_ctx->ap_suspend)) {
 		netif_stop_queue(dev);
 		spin_unlock_irqrestore(&wwan_ptr->lock, flags);
+		ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
 		return NETDEV_TX_BUSY;
 	}
 	if (netif_queue_stopped(dev)) {
@@ -1146,6 +1148,7 @@ static int ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 			IPAWANERR("[%s]fatal: %s stopped\n", dev->name,
 							__func__);
 			spin_unlock_irqrestore(&wwan_ptr->lock, flags);
+			ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
 			return NETDEV_TX_BUSY;
 		}
 	}
@@ -1161,6 +1164,7 @@ static int ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 			IPAWANDBG_LOW("qmap_chk(%d)\n", qmap_check);
 			netif_stop_queue(dev);
 			spin_unlock_irqrestore(&wwan_ptr->lock, flags);
+			ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
 			return NETDEV_TX_BUSY;
 		}
 	}
@@ -1178,6 +1182,7 @@ static int ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 	if (ret == -EINPROGRESS) {
 		netif_stop_queue(dev);
 		spin_unlock_irqrestore(&wwan_ptr->lock, flags);
+		ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
 		return NETDEV_TX_BUSY;
 	}
 	if (ret) {
@@ -1186,6 +1191,7 @@ static int ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 		dev_kfree_skb_any(skb);
 		dev->stats.tx_dropped++;
 		spin_unlock_irqrestore(&wwan_ptr->lock, flags);
+		ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
 		return NETDEV_TX_OK;
 	}
 	/* IPA_RM checking end */
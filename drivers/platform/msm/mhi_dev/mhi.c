@@ -657,12 +657,12 @@ static int mhi_dev_send_multiple_tr_events(struct mhi_dev *mhi, int evnt_ring,
 	union mhi_dev_ring_ctx *ctx;
 	struct mhi_addr transfer_addr;
 
-	rc = ep_pcie_get_msi_config(mhi->phandle, &mhi->msi_cfg);
-	if (rc) {
-		pr_err("Error retrieving pcie msi logic\n");
-		return rc;
-	}
-
+	/*
+	 * No ep_pcie_get_msi_config() here: it rereads the MSI capability
+	 * and reprograms the MSI iATU entry, which is done already by the
+	 * state change and EE events the host waits for before it starts
+	 * any channel. ep_pcie_trigger_msi() still fails if MSI got disabled.
+	 */
 	if (evnt_ring_idx > mhi->cfg.event_rings) {
 		pr_err("Invalid event ring idx: %lld\n", evnt_ring_idx);
 		return -EINVAL;
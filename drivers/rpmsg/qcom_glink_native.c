@@ -28,6 +28,7 @@
 #include <linux/slab.h>
 #include <linux/workqueue.h>
 #include <linux/kthread.h>
+#include <linux/log2.h>
 #include <linux/mailbox_client.h>
 #include <linux/ipc_logging.h>
 #include <linux/suspend.h>
@@ -66,6 +67,18 @@ do {									  \
 
 static int should_wake;
 
+/*
+ * Intents allocated because the remote asked for one are single use, so a
+ * channel carrying messages bigger than its advertised intents pays an
+ * intent request round trip for each of them. Allow up to this many of
+ * them per channel to be kept as reusable intents instead, rounded up to
+ * a power of two so they also serve the neighbouring sizes.
+ */
+static unsigned int rx_intent_pool_max;
+module_param(rx_intent_pool_max, uint, 0644);
+MODULE_PARM_DESC(rx_intent_pool_max,
+		 "Requested intents kept for reuse per channel");
+
 struct glink_msg {
 	__le16 cmd;
 	__le16 param1;
@@ -201,6 +214,7 @@ enum {
  * @intent_req_result: Result of intent request
  * @intent_req_comp: Status of intent request completion
  * @intent_req_event: Waitqueue for @intent_req_comp
+ * @pooled_intents: requested intents turned reusable, see rx_intent_pool_max
  */
 struct glink_channel {
 	struct rpmsg_endpoint ept;
@@ -236,6 +250,8 @@ struct glink_channel {
 	bool intent_req_result;
 	atomic_t intent_req_comp;
 	wait_queue_head_t intent_req_event;
+
+	unsigned int pooled_intents;
 };
 
 #define to_glink_channel(_ept) container_of(_ept, struct glink_channel, ept)
@@ -897,7 +913,14 @@ static void qcom_glink_handle_intent_req(struct qcom_glink *glink,
 		return;
 	}
 
-	intent = qcom_glink_alloc_intent(glink, channel, size, false);
+	if (size && channel->pooled_intents < READ_ONCE(rx_intent_pool_max)) {
+		intent = qcom_glink_alloc_intent(glink, channel,
+				roundup_pow_of_two(size), true);
+		if (intent)
+			channel->pooled_intents++;
+	}
+	if (!intent)
+		intent = qcom_glink_alloc_intent(glink, channel, size, false);
 	if (intent)
 		qcom_glink_advertise_intent(glink, channel, intent);
 
@@ -18,11 +18,14 @@
 #include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/module.h>
+#include <linux/sort.h>
 #include <linux/test-iosched.h>
+#include <linux/vmalloc.h>
 #include <scsi/scsi_device.h>
 #include <scsi/scsi_cmnd.h>
 #include <linux/delay.h>
 #include <../sd.h>
+#include "ufshcd.h"
 
 #define MODULE_NAME "ufs_test"
 
@@ -58,6 +61,10 @@
 /* translation mask from sectors to block */
 #define SECTOR_TO_BLOCK_MASK 0x7
 
+#define LAT_TEST_DEFAULT_QD		8
+#define LAT_TEST_DEFAULT_NUM_REQS	1024
+#define LAT_TEST_MAX_NUM_REQS		16384
+
 #define TEST_OPS(test_name, upper_case_name)				\
 static int ufs_test_ ## test_name ## _show(struct seq_file *file,	\
 		void *data)						\
@@ -96,6 +103,8 @@ enum ufs_test_testcases {
 	UFS_TEST_PARALLEL_READ_AND_WRITE,
 	UFS_TEST_LUN_DEPTH,
 
+	UFS_TEST_LATENCY,
+
 	NUM_TESTS,
 };
 
@@ -110,6 +119,42 @@ enum ufs_test_stage {
 	UFS_TEST_LUN_DEPTH_DONE_ISSUING_REQ,
 };
 
+enum ufs_test_lat_pattern {
+	LAT_TEST_READ,
+	LAT_TEST_WRITE,
+	LAT_TEST_MIXED,
+};
+
+enum ufs_test_lat_phase {
+	LAT_PHASE_HOST,		/* insertion to doorbell */
+	LAT_PHASE_DEVICE,	/* doorbell to completion interrupt */
+	LAT_PHASE_COMPL,	/* completion interrupt to end_io */
+	LAT_PHASE_TOTAL,	/* insertion to end_io */
+	LAT_PHASE_MAX,
+};
+
+static const char * const lat_phase_str[LAT_PHASE_MAX] = {
+	"host", "device", "compl", "total",
+};
+
+/* timestamps of one latency test request */
+struct ufs_test_lat_sample {
+	ktime_t submit;
+	ktime_t doorbell;
+	ktime_t irq;
+	ktime_t done;
+	bool write;
+};
+
+/* percentiles of one phase, in ns */
+struct ufs_test_lat_result {
+	u32 count;
+	u64 p50;
+	u64 p90;
+	u64 p99;
+	u64 max;
+};
+
 struct ufs_test_data {
 	/* Data structure for debugfs dentrys */
 	struct dentry **test_list;
@@ -145,6 +190,21 @@ struct ufs_test_data {
 	u32 sector_range;
 	/* total number of requests to be submitted in long test */
 	u32 long_test_num_reqs;
+
+	/* latency test parameters */
+	u32 lat_test_qd;
+	u32 lat_test_num_reqs;
+	u32 lat_test_pattern;
+	/* latency test state and results of the last run */
+	struct ufs_test_lat_sample *lat_samples;
+	int lat_first_req_id;
+	atomic_t lat_inflight;
+	int lat_saved_hist;
+	u32 lat_run_qd;
+	u32 lat_run_pattern;
+	u32 lat_gate_cnt;
+	u32 lat_hibern8_cnt;
+	struct ufs_test_lat_result lat_res[2][LAT_PHASE_MAX];
 };
 
 static struct ufs_test_data *utd;
@@ -253,6 +313,8 @@ static char *ufs_test_get_test_case_str(struct test_data *td)
 		return "UFS parallel read and write test";
 	case UFS_TEST_LUN_DEPTH:
 		return "UFS LUN depth test";
+	case UFS_TEST_LATENCY:
+		return "UFS latency test";
 	default:
 		return "Unknown test";
 	}
@@ -414,6 +476,18 @@ static int ufs_test_show(struct seq_file *file, int test_case)
 		 "The test will test for each iteration once only reads and "
 		 "once only writes.\n";
 		break;
+	case UFS_TEST_LATENCY:
+		test_description = "\nufs_test_latency\n"
+		 "=========\n"
+		 "Description:\n"
+		 "This test issues lat_test_num_reqs random 4KB requests, keeping "
+		 "lat_test_qd of them in flight. lat_test_pattern selects reads "
+		 "(0), writes (1) or a random mix of both (2).\n"
+		 "Every request is timed at insertion, doorbell, completion "
+		 "interrupt and end_io. The percentiles of each phase and the "
+		 "number of clock gating and hibern8 exits during the run are "
+		 "reported in lat_test_results.\n";
+		break;
 	default:
 		test_description = "Unknown test";
 	}
@@ -1093,6 +1167,274 @@ static int long_seq_test_calc_throughput(struct test_data *td)
 	return 0;
 }
 
+static struct ufs_hba *ufs_test_get_hba(struct test_data *td)
+{
+	struct scsi_device *sdev;
+
+	BUG_ON(!td || !td->req_q || !td->req_q->queuedata);
+	sdev = (struct scsi_device *)td->req_q->queuedata;
+	BUG_ON(!sdev->host);
+
+	return shost_priv(sdev->host);
+}
+
+static void lat_test_end_io_fn(struct request *rq, int err)
+{
+	struct test_request *test_rq;
+	struct test_data *ptd = test_get_test_data();
+	struct ufs_test_lat_sample *s;
+	ktime_t done = ktime_get();
+	unsigned long flags;
+	int idx;
+
+	BUG_ON(!rq);
+	test_rq = (struct test_request *)rq->elv.priv[0];
+	BUG_ON(!test_rq);
+
+	idx = test_rq->req_id - utd->lat_first_req_id;
+	if (idx >= 0 && idx < utd->long_test_num_reqs && !err) {
+		s = &utd->lat_samples[idx];
+		s->doorbell = rq->lat_hist_io_doorbell;
+		s->irq = rq->lat_hist_io_compl;
+		s->done = done;
+		s->write = rq_data_dir(rq) == WRITE;
+	}
+
+	spin_lock_irqsave(&test_iosched->lock, flags);
+	ptd->dispatched_count--;
+	list_del_init(&test_rq->queuelist);
+	__blk_put_request(ptd->req_q, test_rq->rq);
+	utd->completed_req_count++;
+	spin_unlock_irqrestore(&test_iosched->lock, flags);
+
+	if (err)
+		pr_err("%s: request %d completed, err=%d", __func__,
+			test_rq->req_id, err);
+
+	test_iosched_free_test_req_data_buffer(test_rq);
+	kfree(test_rq);
+
+	atomic_dec(&utd->lat_inflight);
+	wake_up(&utd->wait_q);
+	check_test_completion();
+}
+
+/**
+ * run_latency_test - keep a fixed number of timed requests in flight
+ * @td - test specific data
+ *
+ * Requests are inserted one by one as soon as the number in flight drops
+ * below the queue depth, so that each phase is measured at a controlled
+ * load. The UFS latency histogram is switched on for the duration of the
+ * test, which makes ufshcd stamp the doorbell and completion interrupt
+ * times into the request.
+ */
+static int run_latency_test(struct test_data *td)
+{
+	struct ufs_hba *hba = ufs_test_get_hba(td);
+	u32 i, qd, sector, span, seed;
+	int direction, ret = 0;
+
+	qd = clamp_t(u32, utd->lat_test_qd, 1, QUEUE_MAX_REQUESTS);
+	utd->long_test_num_reqs = clamp_t(u32, utd->lat_test_num_reqs, 1,
+					  LAT_TEST_MAX_NUM_REQS);
+	utd->lat_run_qd = qd;
+	utd->lat_run_pattern = utd->lat_test_pattern;
+	utd->completed_req_count = 0;
+
+	if (test_iosched->sector_range)
+		utd->sector_range = test_iosched->sector_range;
+	else
+		utd->sector_range = TEST_DEFAULT_SECTOR_RANGE;
+	span = utd->sector_range > TEST_BIO_SIZE / SECTOR_SIZE ?
+	       utd->sector_range - TEST_BIO_SIZE / SECTOR_SIZE : 1;
+
+	utd->lat_samples = vzalloc(utd->long_test_num_reqs *
+				   sizeof(*utd->lat_samples));
+	if (!utd->lat_samples) {
+		pr_err("%s: failed to allocate latency samples", __func__);
+		return -ENOMEM;
+	}
+
+	atomic_set(&utd->lat_inflight, 0);
+	utd->lat_first_req_id = td->wr_rd_next_req_id;
+	utd->lat_gate_cnt = hba->ufs_stats.clk_gate_cnt;
+	utd->lat_hibern8_cnt = hba->ufs_stats.hibern8_exit_cnt;
+	utd->lat_saved_hist = hba->latency_hist_enabled;
+	hba->latency_hist_enabled = 1;
+
+	seed = utd->random_test_seed ? utd->random_test_seed : MAGIC_SEED;
+
+	pr_info("%s: Adding %d requests at queue depth %d, first req_id=%d",
+		__func__, utd->long_test_num_reqs, qd, utd->lat_first_req_id);
+
+	for (i = 0; i < utd->long_test_num_reqs; i++) {
+		wait_event(utd->wait_q, atomic_read(&utd->lat_inflight) < qd);
+
+		switch (utd->lat_run_pattern) {
+		case LAT_TEST_READ:
+			direction = READ;
+			break;
+		case LAT_TEST_WRITE:
+			direction = WRITE;
+			break;
+		default:
+			direction = ufs_test_pseudo_random_seed(&seed, 0, 2) ?
+				WRITE : READ;
+		}
+		/* the helper draws modulo its max, so draw an offset */
+		sector = td->start_sector +
+			 ufs_test_pseudo_random_seed(&seed, 0, span);
+		sector &= ~SECTOR_TO_BLOCK_MASK;
+
+		atomic_inc(&utd->lat_inflight);
+		utd->lat_samples[i].submit = ktime_get();
+		ret = test_iosched_add_wr_rd_test_req(0, direction, sector, 1,
+				TEST_PATTERN_5A, lat_test_end_io_fn);
+		if (ret) {
+			pr_err("%s: failed to create request", __func__);
+			atomic_dec(&utd->lat_inflight);
+			utd->long_test_num_reqs = i;
+			hba->latency_hist_enabled = utd->lat_saved_hist;
+			break;
+		}
+		blk_run_queue(td->req_q);
+	}
+
+	return ret;
+}
+
+static int lat_test_cmp_u64(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static u64 lat_test_phase_ns(struct ufs_test_lat_sample *s, int phase)
+{
+	switch (phase) {
+	case LAT_PHASE_HOST:
+		return ktime_to_ns(ktime_sub(s->doorbell, s->submit));
+	case LAT_PHASE_DEVICE:
+		return ktime_to_ns(ktime_sub(s->irq, s->doorbell));
+	case LAT_PHASE_COMPL:
+		return ktime_to_ns(ktime_sub(s->done, s->irq));
+	default:
+		return ktime_to_ns(ktime_sub(s->done, s->submit));
+	}
+}
+
+static int lat_test_calc_results(struct test_data *td)
+{
+	struct ufs_hba *hba = ufs_test_get_hba(td);
+	struct ufs_test_lat_sample *s;
+	struct ufs_test_lat_result *res;
+	u32 i, cnt, n = utd->long_test_num_reqs;
+	int dir, phase;
+	u64 *ns;
+
+	if (!utd->lat_samples)
+		return 0;
+
+	hba->latency_hist_enabled = utd->lat_saved_hist;
+	utd->lat_gate_cnt = hba->ufs_stats.clk_gate_cnt - utd->lat_gate_cnt;
+	utd->lat_hibern8_cnt = hba->ufs_stats.hibern8_exit_cnt -
+			       utd->lat_hibern8_cnt;
+	memset(utd->lat_res, 0, sizeof(utd->lat_res));
+
+	ns = vmalloc(max_t(u32, n, 1) * sizeof(*ns));
+	if (!ns) {
+		pr_err("%s: failed to allocate sort buffer", __func__);
+		goto out;
+	}
+
+	for (dir = 0; dir < 2; dir++) {
+		for (phase = 0; phase < LAT_PHASE_MAX; phase++) {
+			res = &utd->lat_res[dir][phase];
+			cnt = 0;
+			for (i = 0; i < n; i++) {
+				s = &utd->lat_samples[i];
+				/* failed or not stamped by ufshcd */
+				if (!ktime_to_ns(s->done) ||
+				    !ktime_to_ns(s->doorbell) ||
+				    !ktime_to_ns(s->irq) || s->write != dir)
+					continue;
+				ns[cnt++] = lat_test_phase_ns(s, phase);
+			}
+			if (!cnt)
+				continue;
+
+			sort(ns, cnt, sizeof(*ns), lat_test_cmp_u64, NULL);
+			res->count = cnt;
+			res->p50 = ns[cnt * 50 / 100];
+			res->p90 = ns[cnt * 90 / 100];
+			res->p99 = ns[cnt * 99 / 100];
+			res->max = ns[cnt - 1];
+		}
+	}
+	vfree(ns);
+
+	for (dir = 0; dir < 2; dir++) {
+		res = &utd->lat_res[dir][LAT_PHASE_TOTAL];
+		if (res->count)
+			pr_info("%s: %s: %u requests, p50 %llu us, p99 %llu us",
+				__func__, dir ? "write" : "read", res->count,
+				div_u64(res->p50, NSEC_PER_USEC),
+				div_u64(res->p99, NSEC_PER_USEC));
+	}
+	pr_info("%s: %u clock gatings, %u hibern8 exits", __func__,
+		utd->lat_gate_cnt, utd->lat_hibern8_cnt);
+out:
+	vfree(utd->lat_samples);
+	utd->lat_samples = NULL;
+
+	return 0;
+}
+
+static int lat_test_results_show(struct seq_file *file, void *data)
+{
+	static const char * const pattern_str[] = { "read", "write", "mixed" };
+	struct ufs_test_lat_result *res;
+	int dir, phase;
+
+	seq_printf(file, "queue depth %u, pattern %s\n", utd->lat_run_qd,
+		   pattern_str[min_t(u32, utd->lat_run_pattern,
+				     LAT_TEST_MIXED)]);
+	seq_printf(file, "clock gatings %u, hibern8 exits %u\n",
+		   utd->lat_gate_cnt, utd->lat_hibern8_cnt);
+	seq_printf(file, "%-6s %-7s %8s %10s %10s %10s %10s\n", "dir",
+		   "phase", "count", "p50(ns)", "p90(ns)", "p99(ns)",
+		   "max(ns)");
+
+	for (dir = 0; dir < 2; dir++) {
+		for (phase = 0; phase < LAT_PHASE_MAX; phase++) {
+			res = &utd->lat_res[dir][phase];
+			if (!res->count)
+				continue;
+			seq_printf(file,
+				   "%-6s %-7s %8u %10llu %10llu %10llu %10llu\n",
+				   dir ? "write" : "read", lat_phase_str[phase],
+				   res->count, res->p50, res->p90, res->p99,
+				   res->max);
+		}
+	}
+
+	return 0;
+}
+
+static int lat_test_results_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lat_test_results_show, inode->i_private);
+}
+
+static const struct file_operations lat_test_results_ops = {
+	.open = lat_test_results_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static bool ufs_data_integrity_completion(void)
 {
 	struct test_data *ptd = test_get_test_data();
@@ -1258,6 +1600,13 @@ static ssize_t ufs_test_write(struct file *file, const char __user *buf,
 	case UFS_TEST_LUN_DEPTH:
 		utd->test_info.run_test_fn = ufs_test_run_lun_depth_test;
 		break;
+	case UFS_TEST_LATENCY:
+		utd->test_info.run_test_fn = run_latency_test;
+		utd->test_info.post_test_fn = lat_test_calc_results;
+		utd->test_info.check_test_result_fn = ufs_test_check_result;
+		utd->test_info.check_test_completion_fn =
+			long_rand_test_check_completion;
+		break;
 	default:
 		pr_err("%s: Unknown test-case: %d", __func__, test_case);
 		WARN_ON(true);
@@ -1294,6 +1643,7 @@ TEST_OPS(long_sequential_write, LONG_SEQUENTIAL_WRITE);
 TEST_OPS(long_sequential_mixed, LONG_SEQUENTIAL_MIXED);
 TEST_OPS(parallel_read_and_write, PARALLEL_READ_AND_WRITE);
 TEST_OPS(lun_depth, LUN_DEPTH);
+TEST_OPS(latency, LATENCY);
 
 static void ufs_test_debugfs_cleanup(void)
 {
@@ -1332,6 +1682,20 @@ static int ufs_test_debugfs_init(void)
 		goto exit_err;
 	}
 
+	if (!debugfs_create_u32("lat_test_qd", S_IRUGO | S_IWUGO, utils_root,
+				&utd->lat_test_qd) ||
+	    !debugfs_create_u32("lat_test_num_reqs", S_IRUGO | S_IWUGO,
+				utils_root, &utd->lat_test_num_reqs) ||
+	    !debugfs_create_u32("lat_test_pattern", S_IRUGO | S_IWUGO,
+				utils_root, &utd->lat_test_pattern) ||
+	    !debugfs_create_file("lat_test_results", S_IRUGO, utils_root,
+				 NULL, &lat_test_results_ops)) {
+		pr_err("%s: Could not create debugfs latency test files.",
+				__func__);
+		ret = -ENOMEM;
+		goto exit_err;
+	}
+
 	ret = add_test(utd, write_read_test, WRITE_READ_TEST);
 	if (ret)
 		goto exit_err;
@@ -1360,6 +1724,9 @@ static int ufs_test_debugfs_init(void)
 	if (ret)
 		goto exit_err;
 	add_test(utd, lun_depth, LUN_DEPTH);
+	if (ret)
+		goto exit_err;
+	ret = add_test(utd, latency, LATENCY);
 	if (ret)
 		goto exit_err;
 
@@ -1390,6 +1757,8 @@ int __init ufs_test_init(void)
 	}
 
 	init_waitqueue_head(&utd->wait_q);
+	utd->lat_test_qd = LAT_TEST_DEFAULT_QD;
+	utd->lat_test_num_reqs = LAT_TEST_DEFAULT_NUM_REQS;
 	utd->bdt.init_fn = ufs_test_probe;
 	utd->bdt.exit_fn = ufs_test_remove;
 	INIT_LIST_HEAD(&utd->bdt.list);
@@ -1877,6 +1877,19 @@ static void ufshcd_clk_scaling_suspend_work(struct work_struct *work)
 	__ufshcd_suspend_clkscaling(hba);
 }
 
+static void ufshcd_clk_scaling_boost_work(struct work_struct *work)
+{
+	struct ufs_hba *hba = container_of(work, struct ufs_hba,
+					   clk_scaling.boost_work);
+
+	if (!hba->devfreq || !hba->clk_scaling.boost_pending)
+		return;
+
+	mutex_lock(&hba->devfreq->lock);
+	update_devfreq(hba->devfreq);
+	mutex_unlock(&hba->devfreq->lock);
+}
+
 static void ufshcd_clk_scaling_resume_work(struct work_struct *work)
 {
 	struct ufs_hba *hba = container_of(work, struct ufs_hba,
@@ -1977,7 +1990,11 @@ static int ufshcd_devfreq_get_dev_status(struct device *dev,
 	stat->total_time = jiffies_to_usecs((long)jiffies -
 				(long)scaling->window_start_t);
 	stat->busy_time = scaling->tot_busy_t;
+	/* report a boosted window as fully busy so the governor scales up */
+	if (scaling->boost_pending)
+		stat->busy_time = stat->total_time;
 start_window:
+	scaling->boost_pending = false;
 	scaling->window_start_t = jiffies;
 	scaling->tot_busy_t = 0;
 
@@ -2102,6 +2119,27 @@ static ssize_t ufshcd_clkscale_enable_store(struct device *dev,
 	return count;
 }
 
+static ssize_t ufshcd_clkscale_boost_qd_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", hba->clk_scaling.boost_qd);
+}
+
+static ssize_t ufshcd_clkscale_boost_qd_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	u32 value;
+
+	if (kstrtou32(buf, 0, &value) || value > hba->nutrs)
+		return -EINVAL;
+
+	hba->clk_scaling.boost_qd = value;
+	return count;
+}
+
 static void ufshcd_clkscaling_init_sysfs(struct ufs_hba *hba)
 {
 	hba->clk_scaling.enable_attr.show = ufshcd_clkscale_enable_show;
@@ -2111,6 +2149,14 @@ static void ufshcd_clkscaling_init_sysfs(struct ufs_hba *hba)
 	hba->clk_scaling.enable_attr.attr.mode = 0644;
 	if (device_create_file(hba->dev, &hba->clk_scaling.enable_attr))
 		dev_err(hba->dev, "Failed to create sysfs for clkscale_enable\n");
+
+	hba->clk_scaling.boost_qd_attr.show = ufshcd_clkscale_boost_qd_show;
+	hba->clk_scaling.boost_qd_attr.store = ufshcd_clkscale_boost_qd_store;
+	sysfs_attr_init(&hba->clk_scaling.boost_qd_attr.attr);
+	hba->clk_scaling.boost_qd_attr.attr.name = "clkscale_boost_qd";
+	hba->clk_scaling.boost_qd_attr.attr.mode = 0644;
+	if (device_create_file(hba->dev, &hba->clk_scaling.boost_qd_attr))
+		dev_err(hba->dev, "Failed to create sysfs for clkscale_boost_qd\n");
 }
 
 static void ufshcd_ungate_work(struct work_struct *work)
@@ -2332,6 +2378,7 @@ static void ufshcd_gate_work(struct work_struct *work)
 	spin_lock_irqsave(hba->host->host_lock, flags);
 	if (hba->clk_gating.state == REQ_CLKS_OFF) {
 		hba->clk_gating.state = CLKS_OFF;
+		hba->ufs_stats.clk_gate_cnt++;
 		trace_ufshcd_clk_gating(dev_name(hba->dev),
 					hba->clk_gating.state);
 	}
@@ -2608,6 +2655,60 @@ static void ufshcd_set_auto_hibern8_timer(struct ufs_hba *hba, u32 delay)
 	mb();
 }
 
+/*
+ * Hibern8 only saves power once the link stays down for some multiple of
+ * the enter + exit transition time, shorter gaps just add exit latency to
+ * the first request that follows them.
+ */
+#define UFSHCD_H8_BREAK_EVEN_MULT	2
+
+/* host lock must be held before calling this */
+static void ufshcd_hibern8_idle_end(struct ufs_hba *hba)
+{
+	struct ufs_hibern8_on_idle *h8 = &hba->hibern8_on_idle;
+	u64 gap_us;
+
+	if (!ktime_to_ns(h8->idle_start_t))
+		return;
+
+	gap_us = ktime_us_delta(ktime_get(), h8->idle_start_t);
+	h8->avg_idle_us = h8->avg_idle_us - (h8->avg_idle_us >> 3) +
+			  (gap_us >> 3);
+	h8->idle_start_t = ktime_set(0, 0);
+}
+
+/*
+ * Pick the hibern8 enter delay for the idle gap that is starting now. When
+ * recent gaps were longer than the break-even time the configured delay is
+ * used as is. Otherwise the link is kept up until the gap has outlasted a
+ * typical one by the break-even time, so bursts with short pauses between
+ * them never pay the exit latency.
+ */
+static unsigned long ufshcd_hibern8_enter_delay_ms(struct ufs_hba *hba)
+{
+	struct ufs_hibern8_on_idle *h8 = &hba->hibern8_on_idle;
+	unsigned long delay_ms = h8->delay_ms;
+	unsigned long max_ms = hba->clk_gating.delay_ms;
+	u64 break_even_us;
+
+	if (!h8->predict)
+		return delay_ms;
+
+	break_even_us = UFSHCD_H8_BREAK_EVEN_MULT *
+			(h8->enter_lat_us + h8->exit_lat_us);
+	if (!break_even_us || h8->avg_idle_us >= break_even_us)
+		return delay_ms;
+
+	delay_ms = max_t(unsigned long, delay_ms,
+			 DIV_ROUND_UP_ULL(h8->avg_idle_us + break_even_us,
+					  USEC_PER_MSEC));
+	/* clock gating waits for hibern8, keep entering ahead of it */
+	if (max_ms > 1 && delay_ms >= max_ms)
+		delay_ms = max_ms - 1;
+
+	return delay_ms;
+}
+
 /**
  * ufshcd_hibern8_hold - Make sure that link is not in hibern8.
  *
@@ -2628,6 +2729,7 @@ static int ufshcd_hibern8_hold(struct ufs_hba *hba, bool async)
 
 	spin_lock_irqsave(hba->host->host_lock, flags);
 	hba->hibern8_on_idle.active_reqs++;
+	ufshcd_hibern8_idle_end(hba);
 
 	if (ufshcd_eh_in_progress(hba)) {
 		spin_unlock_irqrestore(hba->host->host_lock, flags);
@@ -2704,6 +2806,7 @@ static void __ufshcd_hibern8_release(struct ufs_hba *hba, bool no_sched)
 	hba->hibern8_on_idle.state = REQ_HIBERN8_ENTER;
 	trace_ufshcd_hibern8_on_idle(dev_name(hba->dev),
 		hba->hibern8_on_idle.state);
+	hba->hibern8_on_idle.idle_start_t = ktime_get();
 	/*
 	 * Scheduling the delayed work after 1 jiffies will make the work to
 	 * get schedule any time from 0ms to 1000/HZ ms which is not desirable
@@ -2712,7 +2815,7 @@ static void __ufshcd_hibern8_release(struct ufs_hba *hba, bool no_sched)
 	 * work gets scheduled atleast after 2 jiffies (any time between
 	 * 1000/HZ ms to 2000/HZ ms).
 	 */
-	delay_in_jiffies = msecs_to_jiffies(hba->hibern8_on_idle.delay_ms);
+	delay_in_jiffies = msecs_to_jiffies(ufshcd_hibern8_enter_delay_ms(hba));
 	if (delay_in_jiffies == 1)
 		delay_in_jiffies++;
 
@@ -2927,6 +3030,32 @@ static ssize_t ufshcd_hibern8_on_idle_enable_store(struct device *dev,
 	return count;
 }
 
+static ssize_t ufshcd_hibern8_on_idle_predict_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE,
+			"%d avg_idle_us=%llu enter_us=%llu exit_us=%llu\n",
+			hba->hibern8_on_idle.predict,
+			hba->hibern8_on_idle.avg_idle_us,
+			hba->hibern8_on_idle.enter_lat_us,
+			hba->hibern8_on_idle.exit_lat_us);
+}
+
+static ssize_t ufshcd_hibern8_on_idle_predict_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	u32 value;
+
+	if (kstrtou32(buf, 0, &value))
+		return -EINVAL;
+
+	hba->hibern8_on_idle.predict = !!value;
+	return count;
+}
+
 static void ufshcd_init_hibern8_on_idle(struct ufs_hba *hba)
 {
 	/* initialize the state variable here */
@@ -2973,6 +3102,20 @@ static void ufshcd_init_hibern8_on_idle(struct ufs_hba *hba)
 	hba->hibern8_on_idle.enable_attr.attr.mode = S_IRUGO | S_IWUSR;
 	if (device_create_file(hba->dev, &hba->hibern8_on_idle.enable_attr))
 		dev_err(hba->dev, "Failed to create sysfs for hibern8_on_idle_enable\n");
+
+	/* auto hibern8 is timed by the controller, nothing to predict */
+	if (ufshcd_is_auto_hibern8_supported(hba))
+		return;
+
+	hba->hibern8_on_idle.predict_attr.show =
+					ufshcd_hibern8_on_idle_predict_show;
+	hba->hibern8_on_idle.predict_attr.store =
+					ufshcd_hibern8_on_idle_predict_store;
+	sysfs_attr_init(&hba->hibern8_on_idle.predict_attr.attr);
+	hba->hibern8_on_idle.predict_attr.attr.name = "hibern8_on_idle_predict";
+	hba->hibern8_on_idle.predict_attr.attr.mode = S_IRUGO | S_IWUSR;
+	if (device_create_file(hba->dev, &hba->hibern8_on_idle.predict_attr))
+		dev_err(hba->dev, "Failed to create sysfs for hibern8_on_idle_predict\n");
 }
 
 static void ufshcd_exit_hibern8_on_idle(struct ufs_hba *hba)
@@ -2982,6 +3125,9 @@ static void ufshcd_exit_hibern8_on_idle(struct ufs_hba *hba)
 		return;
 	device_remove_file(hba->dev, &hba->hibern8_on_idle.delay_attr);
 	device_remove_file(hba->dev, &hba->hibern8_on_idle.enable_attr);
+	if (!ufshcd_is_auto_hibern8_supported(hba))
+		device_remove_file(hba->dev,
+				   &hba->hibern8_on_idle.predict_attr);
 }
 
 static void ufshcd_hold_all(struct ufs_hba *hba)
@@ -3024,6 +3170,19 @@ static void ufshcd_clk_scaling_start_busy(struct ufs_hba *hba)
 		hba->clk_scaling.busy_start_t = ktime_get();
 		hba->clk_scaling.is_busy_started = true;
 	}
+
+	/*
+	 * A deep queue means a burst is under way, don't wait for the end of
+	 * the devfreq polling window to leave the low gear.
+	 */
+	if (hba->clk_scaling.boost_qd && !hba->clk_scaling.is_scaled_up &&
+	    !hba->clk_scaling.boost_pending &&
+	    hweight_long(hba->outstanding_reqs) + 1 >=
+	    hba->clk_scaling.boost_qd) {
+		hba->clk_scaling.boost_pending = true;
+		queue_work(hba->clk_scaling.workq,
+			   &hba->clk_scaling.boost_work);
+	}
 }
 
 static void ufshcd_clk_scaling_update_busy(struct ufs_hba *hba)
@@ -3048,10 +3207,14 @@ static void ufshcd_clk_scaling_update_busy(struct ufs_hba *hba)
 static inline
 int ufshcd_send_command(struct ufs_hba *hba, unsigned int task_tag)
 {
+	struct scsi_cmnd *cmd = hba->lrb[task_tag].cmd;
 	int ret = 0;
 
 	hba->lrb[task_tag].issue_time_stamp = ktime_get();
 	hba->lrb[task_tag].complete_time_stamp = ktime_set(0, 0);
+	if (cmd && cmd->request && cmd->request->lat_hist_enabled)
+		cmd->request->lat_hist_io_doorbell =
+			hba->lrb[task_tag].issue_time_stamp;
 	ufshcd_clk_scaling_start_busy(hba);
 	__set_bit(task_tag, &hba->outstanding_reqs);
 	ufshcd_writel(hba, 1 << task_tag, REG_UTP_TRANSFER_REQ_DOOR_BELL);
@@ -3687,6 +3850,16 @@ static inline void ufshcd_put_read_lock(struct ufs_hba *hba)
 	up_read(&hba->lock);
 }
 
+/* host lock must be held before calling this */
+static void ufshcd_wbuf_kick(struct ufs_hba *hba)
+{
+	struct ufs_write_buffer *wbuf = &hba->wbuf;
+
+	if (!wbuf->unsupported && !delayed_work_pending(&wbuf->poll_work))
+		schedule_delayed_work(&wbuf->poll_work,
+				      msecs_to_jiffies(wbuf->poll_ms));
+}
+
 /**
  * ufshcd_queuecommand - main entry point for SCSI requests
  * @cmd: command from SCSI Midlayer
@@ -3895,6 +4068,10 @@ static int ufshcd_queuecommand(struct Scsi_Host *host, struct scsi_cmnd *cmd)
 		goto out;
 	}
 
+	/* keep the write buffer level fresh while data is being written */
+	if (hba->wbuf.poll_ms && cmd->sc_data_direction == DMA_TO_DEVICE)
+		ufshcd_wbuf_kick(hba);
+
 out_unlock:
 	spin_unlock_irqrestore(hba->host->host_lock, flags);
 out:
@@ -5275,6 +5452,17 @@ static int ufshcd_link_recovery(struct ufs_hba *hba)
 	return ret;
 }
 
+static void ufshcd_hibern8_update_lat(u64 *avg_us, ktime_t start)
+{
+	u64 lat_us = ktime_us_delta(ktime_get(), start);
+
+	/* seed with the first sample, then keep a 1/8 weighted average */
+	if (!*avg_us)
+		*avg_us = lat_us;
+	else
+		*avg_us = *avg_us - (*avg_us >> 3) + (lat_us >> 3);
+}
+
 static int __ufshcd_uic_hibern8_enter(struct ufs_hba *hba)
 {
 	int ret;
@@ -5321,6 +5509,8 @@ static int __ufshcd_uic_hibern8_enter(struct ufs_hba *hba)
 								POST_CHANGE);
 		dev_dbg(hba->dev, "%s: Hibern8 Enter at %lld us", __func__,
 			ktime_to_us(ktime_get()));
+		ufshcd_hibern8_update_lat(&hba->hibern8_on_idle.enter_lat_us,
+					  start);
 	}
 
 	return ret;
@@ -5373,6 +5563,8 @@ int ufshcd_uic_hibern8_exit(struct ufs_hba *hba)
 			ktime_to_us(ktime_get()));
 		hba->ufs_stats.last_hibern8_exit_tstamp = ktime_get();
 		hba->ufs_stats.hibern8_exit_cnt++;
+		ufshcd_hibern8_update_lat(&hba->hibern8_on_idle.exit_lat_us,
+					  start);
 	}
 
 	return ret;
@@ -6422,6 +6614,7 @@ static void __ufshcd_transfer_req_compl(struct ufs_hba *hba,
 					u_int64_t delta_us;
 
 					completion = ktime_get();
+					req->lat_hist_io_compl = completion;
 					delta_us = ktime_us_delta(completion,
 						  req->lat_hist_io_start);
 					/* rq_data_dir() => true if WRITE */
@@ -6539,13 +6732,48 @@ static irqreturn_t ufshcd_transfer_req_compl(struct ufs_hba *hba)
 	completed_reqs = tr_doorbell ^ hba->outstanding_reqs;
 
 	if (completed_reqs) {
+		hba->reqs_polled = false;
 		__ufshcd_transfer_req_compl(hba, completed_reqs);
 		return IRQ_HANDLED;
+	} else if (hba->reqs_polled) {
+		/* ufshcd_poll() got here first */
+		hba->reqs_polled = false;
+		return IRQ_HANDLED;
 	} else {
 		return IRQ_NONE;
 	}
 }
 
+/**
+ * ufshcd_poll - reap completed transfer requests for blk_poll()
+ * @shost: scsi host
+ * @queue_num: hardware queue, UFS has a single doorbell
+ *
+ * Returns the number of requests completed.
+ */
+static int ufshcd_poll(struct Scsi_Host *shost, unsigned int queue_num)
+{
+	struct ufs_hba *hba = shost_priv(shost);
+	unsigned long completed_reqs = 0;
+	unsigned long flags;
+	u32 tr_doorbell;
+
+	spin_lock_irqsave(shost->host_lock, flags);
+	/* clocks are only guaranteed on while requests are outstanding */
+	if (hba->outstanding_reqs) {
+		tr_doorbell = ufshcd_readl(hba,
+				REG_UTP_TRANSFER_REQ_DOOR_BELL);
+		completed_reqs = ~tr_doorbell & hba->outstanding_reqs;
+		if (completed_reqs) {
+			hba->reqs_polled = true;
+			__ufshcd_transfer_req_compl(hba, completed_reqs);
+		}
+	}
+	spin_unlock_irqrestore(shost->host_lock, flags);
+
+	return hweight_long(completed_reqs);
+}
+
 /**
  * ufshcd_disable_ee - disable exception event
  * @hba: per-adapter instance
@@ -9348,6 +9576,7 @@ static struct scsi_host_template ufshcd_driver_template = {
 	.name			= UFSHCD,
 	.proc_name		= UFSHCD,
 	.queuecommand		= ufshcd_queuecommand,
+	.mq_poll		= ufshcd_poll,
 	.slave_alloc		= ufshcd_slave_alloc,
 	.slave_configure	= ufshcd_slave_configure,
 	.slave_destroy		= ufshcd_slave_destroy,
@@ -9366,6 +9595,7 @@ static struct scsi_host_template ufshcd_driver_template = {
 	.can_queue		= UFSHCD_CAN_QUEUE,
 	.max_host_blocked	= 1,
 	.track_queue_depth	= 1,
+	.force_blk_mq		= 1,
 };
 
 static int ufshcd_config_vreg_load(struct device *dev, struct ufs_vreg *vreg,
@@ -10118,6 +10348,8 @@ static int ufshcd_suspend(struct ufs_hba *hba, enum ufs_pm_op pm_op)
 	enum ufs_dev_pwr_mode req_dev_pwr_mode;
 	enum uic_link_state req_link_state;
 
+	cancel_delayed_work_sync(&hba->wbuf.poll_work);
+
 	hba->pm_op_in_progress = 1;
 	if (!ufshcd_is_shutdown_pm(pm_op)) {
 		pm_lvl = ufshcd_is_runtime_pm(pm_op) ?
@@ -10740,16 +10972,117 @@ static void ufshcd_add_spm_lvl_sysfs_nodes(struct ufs_hba *hba)
 		dev_err(hba->dev, "Failed to create sysfs for spm_lvl\n");
 }
 
+static void ufshcd_wbuf_set_avail(struct ufs_hba *hba, unsigned int avail)
+{
+	struct scsi_device *sdev;
+
+	hba->wbuf.avail = avail;
+	shost_for_each_device(sdev, hba->host)
+		blk_queue_write_buffer_avail(sdev->request_queue, avail);
+}
+
+/*
+ * Read how much of the WriteBooster buffer is left and hand it to the block
+ * layer, so writeback throttling can back off before writes fall back to
+ * TLC speed and start holding up reads.
+ */
+static void ufshcd_wbuf_poll_work(struct work_struct *work)
+{
+	struct ufs_hba *hba = container_of(to_delayed_work(work),
+					   struct ufs_hba, wbuf.poll_work);
+	u32 avail, flush_status;
+	int err;
+
+	pm_runtime_get_noresume(hba->dev);
+	if (!pm_runtime_active(hba->dev))
+		goto out;
+
+	err = ufshcd_query_attr_retry(hba, UPIU_QUERY_OPCODE_READ_ATTR,
+			QUERY_ATTR_IDN_AVAIL_WB_BUFF_SIZE, 0, 0, &avail);
+	if (err) {
+		dev_info(hba->dev, "%s: write buffer size not available %d\n",
+			 __func__, err);
+		hba->wbuf.unsupported = true;
+		goto out;
+	}
+
+	if (!ufshcd_query_attr_retry(hba, UPIU_QUERY_OPCODE_READ_ATTR,
+			QUERY_ATTR_IDN_WB_FLUSH_STATUS, 0, 0, &flush_status))
+		hba->wbuf.flush_status = flush_status;
+
+	/* reported in 10% units */
+	ufshcd_wbuf_set_avail(hba, min_t(u32, avail, 10) * 10);
+out:
+	pm_runtime_put(hba->dev);
+}
+
+static ssize_t ufshcd_wbuf_poll_ms_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", hba->wbuf.poll_ms);
+}
+
+static ssize_t ufshcd_wbuf_poll_ms_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	unsigned int value;
+
+	if (kstrtouint(buf, 0, &value))
+		return -EINVAL;
+
+	hba->wbuf.poll_ms = value;
+	hba->wbuf.unsupported = false;
+	if (!value) {
+		cancel_delayed_work_sync(&hba->wbuf.poll_work);
+		ufshcd_wbuf_set_avail(hba, 100);
+	}
+
+	return count;
+}
+
+static ssize_t ufshcd_wbuf_status_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "avail=%u%% flush_status=%u\n",
+			hba->wbuf.avail, hba->wbuf.flush_status);
+}
+
+static void ufshcd_add_wbuf_sysfs_nodes(struct ufs_hba *hba)
+{
+	hba->wbuf.poll_attr.show = ufshcd_wbuf_poll_ms_show;
+	hba->wbuf.poll_attr.store = ufshcd_wbuf_poll_ms_store;
+	sysfs_attr_init(&hba->wbuf.poll_attr.attr);
+	hba->wbuf.poll_attr.attr.name = "wb_buf_poll_ms";
+	hba->wbuf.poll_attr.attr.mode = 0644;
+	if (device_create_file(hba->dev, &hba->wbuf.poll_attr))
+		dev_err(hba->dev, "Failed to create sysfs for wb_buf_poll_ms\n");
+
+	hba->wbuf.status_attr.show = ufshcd_wbuf_status_show;
+	sysfs_attr_init(&hba->wbuf.status_attr.attr);
+	hba->wbuf.status_attr.attr.name = "wb_buf_status";
+	hba->wbuf.status_attr.attr.mode = 0444;
+	if (device_create_file(hba->dev, &hba->wbuf.status_attr))
+		dev_err(hba->dev, "Failed to create sysfs for wb_buf_status\n");
+}
+
 static inline void ufshcd_add_sysfs_nodes(struct ufs_hba *hba)
 {
 	ufshcd_add_rpm_lvl_sysfs_nodes(hba);
 	ufshcd_add_spm_lvl_sysfs_nodes(hba);
+	ufshcd_add_wbuf_sysfs_nodes(hba);
 }
 
 static inline void ufshcd_remove_sysfs_nodes(struct ufs_hba *hba)
 {
 	device_remove_file(hba->dev, &hba->rpm_lvl_attr);
 	device_remove_file(hba->dev, &hba->spm_lvl_attr);
+	device_remove_file(hba->dev, &hba->wbuf.poll_attr);
+	device_remove_file(hba->dev, &hba->wbuf.status_attr);
 }
 
 static void __ufshcd_shutdown_clkscaling(struct ufs_hba *hba)
@@ -10771,6 +11104,7 @@ static void __ufshcd_shutdown_clkscaling(struct ufs_hba *hba)
 	if (ufshcd_is_clkscaling_supported(hba)) {
 		cancel_work_sync(&hba->clk_scaling.suspend_work);
 		cancel_work_sync(&hba->clk_scaling.resume_work);
+		cancel_work_sync(&hba->clk_scaling.boost_work);
 		if (suspend)
 			ufshcd_suspend_clkscaling(hba);
 	}
@@ -10788,6 +11122,7 @@ static void ufshcd_shutdown_clkscaling(struct ufs_hba *hba)
 		return;
 	__ufshcd_shutdown_clkscaling(hba);
 	device_remove_file(hba->dev, &hba->clk_scaling.enable_attr);
+	device_remove_file(hba->dev, &hba->clk_scaling.boost_qd_attr);
 }
 
 /**
@@ -10892,6 +11227,7 @@ ufshcd_exit_latency_hist(struct ufs_hba *hba)
 void ufshcd_remove(struct ufs_hba *hba)
 {
 	ufshcd_remove_sysfs_nodes(hba);
+	cancel_delayed_work_sync(&hba->wbuf.poll_work);
 	scsi_remove_host(hba->host);
 	/* disable interrupts */
 	ufshcd_disable_intr(hba, hba->intr_mask);
@@ -10902,6 +11238,7 @@ void ufshcd_remove(struct ufs_hba *hba)
 	ufshcd_exit_latency_hist(hba);
 	if (ufshcd_is_clkscaling_supported(hba)) {
 		device_remove_file(hba->dev, &hba->clk_scaling.enable_attr);
+		device_remove_file(hba->dev, &hba->clk_scaling.boost_qd_attr);
 		if (hba->devfreq)
 			devfreq_remove_device(hba->devfreq);
 	}
@@ -11067,6 +11404,8 @@ int ufshcd_init(struct ufs_hba *hba, void __iomem *mmio_base, unsigned int irq)
 	/* Initialize work queues */
 	INIT_WORK(&hba->eh_work, ufshcd_err_handler);
 	INIT_WORK(&hba->eeh_work, ufshcd_exception_event_handler);
+	INIT_DELAYED_WORK(&hba->wbuf.poll_work, ufshcd_wbuf_poll_work);
+	hba->wbuf.avail = 100;
 	INIT_WORK(&hba->card_detect_work, ufshcd_card_detect_handler);
 	INIT_WORK(&hba->rls_work, ufshcd_rls_handler);
 
@@ -11142,6 +11481,8 @@ int ufshcd_init(struct ufs_hba *hba, void __iomem *mmio_base, unsigned int irq)
 			  ufshcd_clk_scaling_suspend_work);
 		INIT_WORK(&hba->clk_scaling.resume_work,
 			  ufshcd_clk_scaling_resume_work);
+		INIT_WORK(&hba->clk_scaling.boost_work,
+			  ufshcd_clk_scaling_boost_work);
 
 		snprintf(wq_name, sizeof(wq_name), "ufs_clkscaling_%d",
 			 host->host_no);
@@ -486,6 +486,13 @@ enum ufshcd_hibern8_on_idle_state {
  * @delay_attr: sysfs attribute to control delay_attr
  * @enable_attr: sysfs attribute to enable/disable hibern8 on idle
  * @is_enabled: Indicates the current status of hibern8
+ * @predict: stretch the enter delay when idle gaps are predicted to be
+ * shorter than the hibern8 break-even time
+ * @idle_start_t: start time of the current idle gap
+ * @avg_idle_us: moving average of idle gap length
+ * @enter_lat_us: moving average of measured hibern8 enter latency
+ * @exit_lat_us: moving average of measured hibern8 exit latency
+ * @predict_attr: sysfs attribute to enable/disable idle prediction
  */
 struct ufs_hibern8_on_idle {
 	struct delayed_work enter_work;
@@ -497,6 +504,12 @@ struct ufs_hibern8_on_idle {
 	struct device_attribute delay_attr;
 	struct device_attribute enable_attr;
 	bool is_enabled;
+	bool predict;
+	ktime_t idle_start_t;
+	u64 avg_idle_us;
+	u64 enter_lat_us;
+	u64 exit_lat_us;
+	struct device_attribute predict_attr;
 };
 
 /**
@@ -517,6 +530,11 @@ struct ufs_hibern8_on_idle {
  * @is_busy_started: tracks if busy period has started or not
  * @is_suspended: tracks if devfreq is suspended or not
  * @is_scaled_up: tracks if we are currently scaled up or scaled down
+ * @boost_qd: scale up immediately once this many requests are outstanding,
+ * 0 disables
+ * @boost_pending: a boost was requested and not yet seen by devfreq
+ * @boost_work: worker to re-evaluate devfreq for a boost
+ * @boost_qd_attr: sysfs attribute to control boost_qd
  */
 struct ufs_clk_scaling {
 	int active_reqs;
@@ -532,6 +550,30 @@ struct ufs_clk_scaling {
 	bool is_busy_started;
 	bool is_suspended;
 	bool is_scaled_up;
+	unsigned int boost_qd;
+	bool boost_pending;
+	struct work_struct boost_work;
+	struct device_attribute boost_qd_attr;
+};
+
+/**
+ * struct ufs_write_buffer - state of the device's WriteBooster (SLC) buffer
+ * @poll_work: worker reading the buffer state while writes are issued
+ * @poll_ms: minimum interval between two reads, 0 disables polling
+ * @avail: free buffer space in percent, 100 until read from the device
+ * @flush_status: last bWriteBoosterBufferFlushStatus read from the device
+ * @unsupported: the device rejected the query, don't poll again
+ * @poll_attr: sysfs attribute to control poll_ms
+ * @status_attr: sysfs attribute to show avail and flush_status
+ */
+struct ufs_write_buffer {
+	struct delayed_work poll_work;
+	unsigned int poll_ms;
+	unsigned int avail;
+	u32 flush_status;
+	bool unsupported;
+	struct device_attribute poll_attr;
+	struct device_attribute status_attr;
 };
 
 #define UIC_ERR_REG_HIST_LENGTH 20
@@ -627,6 +669,7 @@ struct ufshcd_clk_ctx {
  * @err_stats: counters to keep track of various errors
  * @req_stats: request handling time statistics per request type
  * @query_stats_arr: array that holds query statistics
+ * @clk_gate_cnt: number of times the clocks were gated
  * @hibern8_exit_cnt: Counter to keep track of number of exits,
  *		reset this after link-startup.
  * @last_hibern8_exit_tstamp: Set time after the hibern8 exit.
@@ -651,6 +694,7 @@ struct ufs_stats {
 	ktime_t last_intr_ts;
 	struct ufshcd_clk_ctx clk_hold;
 	struct ufshcd_clk_ctx clk_rel;
+	u32 clk_gate_cnt;
 	u32 hibern8_exit_cnt;
 	ktime_t last_hibern8_exit_tstamp;
 	u32 power_mode_change_cnt;
@@ -802,11 +846,15 @@ struct ufs_hba {
 	struct device_attribute spm_lvl_attr;
 	int pm_op_in_progress;
 
+	struct ufs_write_buffer wbuf;
+
 	struct ufshcd_lrb *lrb;
 	unsigned long lrb_in_use;
 
 	unsigned long outstanding_tasks;
 	unsigned long outstanding_reqs;
+	/* set when blk_poll() reaped requests ahead of their interrupt */
+	bool reqs_polled;
 
 	u32 capabilities;
 	int nutrs;
@@ -0,0 +1,130 @@
+/* Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <linux/kernel.h>
+#include <linux/atomic.h>
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/smp.h>
+#include <linux/string.h>
+#include <soc/qcom/boot_stats.h>
+
+#define BOOT_EVENT_ENTRIES	CONFIG_MSM_BOOT_EVENT_LOG_ENTRIES
+
+/*
+ * Slots are claimed with a single atomic increment, so recording works from
+ * any context without a lock. @ready tells the reader which claimed slots
+ * have been filled in completely.
+ */
+static struct boot_event boot_events[BOOT_EVENT_ENTRIES];
+static unsigned long boot_events_ready[BITS_TO_LONGS(BOOT_EVENT_ENTRIES)];
+static atomic_t boot_events_next = ATOMIC_INIT(0);
+
+static struct boot_event *boot_event_claim(enum boot_event_type type,
+					   ktime_t start, int *idx)
+{
+	struct boot_event *ev;
+
+	*idx = atomic_inc_return(&boot_events_next) - 1;
+	if (*idx >= BOOT_EVENT_ENTRIES)
+		return NULL;
+
+	ev = &boot_events[*idx];
+	ev->start_ns = ktime_to_ns(start);
+	ev->duration_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	ev->type = type;
+	ev->cpu = raw_smp_processor_id();
+
+	return ev;
+}
+
+static void boot_event_publish(int idx)
+{
+	smp_wmb();
+	set_bit(idx, boot_events_ready);
+}
+
+/**
+ * boot_event_record() - add an event to the boot timeline
+ * @type: what the event is
+ * @name: device, image or filesystem the event is about
+ * @start: boot_event_start() taken when the event began
+ *
+ * The event ends now.
+ */
+void boot_event_record(enum boot_event_type type, const char *name,
+		       ktime_t start)
+{
+	struct boot_event *ev;
+	int idx;
+
+	ev = boot_event_claim(type, start, &idx);
+	if (!ev)
+		return;
+
+	strlcpy(ev->name, name ? name : "", sizeof(ev->name));
+	boot_event_publish(idx);
+}
+EXPORT_SYMBOL(boot_event_record);
+
+/**
+ * boot_event_record_fn() - add an event named after a function
+ * @type: what the event is
+ * @fn: the function, typically an initcall
+ * @start: boot_event_start() taken when the event began
+ */
+void boot_event_record_fn(enum boot_event_type type, void *fn,
+			  ktime_t start)
+{
+	struct boot_event *ev;
+	int idx;
+
+	ev = boot_event_claim(type, start, &idx);
+	if (!ev)
+		return;
+
+	snprintf(ev->name, sizeof(ev->name), "%ps", fn);
+	boot_event_publish(idx);
+}
+EXPORT_SYMBOL(boot_event_record_fn);
+
+static ssize_t boot_events_read(struct file *file, char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	int n = min(atomic_read(&boot_events_next), BOOT_EVENT_ENTRIES);
+	int i;
+
+	/* only hand out the prefix of slots that are filled in */
+	for (i = 0; i < n; i++)
+		if (!test_bit(i, boot_events_ready))
+			break;
+	smp_rmb();
+
+	return simple_read_from_buffer(buf, count, ppos, boot_events,
+				       i * sizeof(struct boot_event));
+}
+
+static const struct file_operations boot_events_fops = {
+	.open = simple_open,
+	.read = boot_events_read,
+	.llseek = default_llseek,
+};
+
+static int __init boot_event_log_init(void)
+{
+	debugfs_create_file("boot_events", 0400, NULL, NULL,
+			    &boot_events_fops);
+	return 0;
+}
+late_initcall(boot_event_log_init);
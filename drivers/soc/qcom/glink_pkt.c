@@ -13,6 +13,7 @@
 
 #include <linux/platform_device.h>
 #include <linux/ipc_logging.h>
+#include <linux/hrtimer.h>
 #include <linux/refcount.h>
 #include <linux/device.h>
 #include <linux/module.h>
@@ -107,6 +108,8 @@ static DEFINE_IDA(glink_pkt_minor_ida);
  * @queue_lock:	synchronization of @queue operations
  * @queue:	incoming message queue
  * @readq:	wait object for incoming queue
+ * @rx_batch_timer:	deferred wakeup of @readq when batching
+ * @rx_batch_us:	how long to hold back readers after a first packet
  * @sig_change:	flag to indicate serial signal change
  * @dev_name:	/dev/@dev_name for glink_pkt device
  * @ch_name:	glink channel to match to
@@ -126,6 +129,8 @@ struct glink_pkt_device {
 	spinlock_t queue_lock;
 	struct sk_buff_head queue;
 	wait_queue_head_t readq;
+	struct hrtimer rx_batch_timer;
+	unsigned int rx_batch_us;
 	int sig_change;
 
 	const char *dev_name;
@@ -195,6 +200,7 @@ static int glink_pkt_rpdev_cb(struct rpmsg_device *rpdev, void *buf, int len,
 			      void *priv, u32 addr)
 {
 	struct glink_pkt_device *gpdev = dev_get_drvdata(&rpdev->dev);
+	unsigned int batch_us = READ_ONCE(gpdev->rx_batch_us);
 	unsigned long flags;
 	struct sk_buff *skb;
 
@@ -206,14 +212,34 @@ static int glink_pkt_rpdev_cb(struct rpmsg_device *rpdev, void *buf, int len,
 
 	spin_lock_irqsave(&gpdev->queue_lock, flags);
 	skb_queue_tail(&gpdev->queue, skb);
+	/*
+	 * High rate streams such as sensor samples would otherwise wake the
+	 * reader once per packet. The first packet arms the timer, the ones
+	 * arriving before it fires are delivered with the same wakeup.
+	 */
+	if (batch_us && !hrtimer_is_queued(&gpdev->rx_batch_timer))
+		hrtimer_start(&gpdev->rx_batch_timer,
+			      ns_to_ktime((u64)batch_us * NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
 	spin_unlock_irqrestore(&gpdev->queue_lock, flags);
 
 	/* wake up any blocking processes, waiting for new data */
-	wake_up_interruptible(&gpdev->readq);
+	if (!batch_us)
+		wake_up_interruptible(&gpdev->readq);
 
 	return 0;
 }
 
+static enum hrtimer_restart glink_pkt_rx_batch_fn(struct hrtimer *timer)
+{
+	struct glink_pkt_device *gpdev;
+
+	gpdev = container_of(timer, struct glink_pkt_device, rx_batch_timer);
+	wake_up_interruptible(&gpdev->readq);
+
+	return HRTIMER_NORESTART;
+}
+
 static int glink_pkt_rpdev_sigs(struct rpmsg_device *rpdev, u32 old, u32 new)
 {
 	struct device_driver *drv = rpdev->dev.driver;
@@ -625,8 +651,35 @@ static ssize_t name_show(struct device *dev, struct device_attribute *attr,
 }
 static DEVICE_ATTR_RO(name);
 
+static ssize_t rx_batch_us_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct glink_pkt_device *gpdev = dev_to_gpdev(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", READ_ONCE(gpdev->rx_batch_us));
+}
+
+static ssize_t rx_batch_us_store(struct device *dev,
+				 struct device_attribute *attr,
+				 const char *buf, size_t n)
+{
+	struct glink_pkt_device *gpdev = dev_to_gpdev(dev);
+	unsigned int tmp;
+
+	if (kstrtouint(buf, 0, &tmp) || tmp > USEC_PER_SEC) {
+		GLINK_PKT_ERR("invalid rx batch time:%s for /dev/%s\n",
+			      buf, gpdev->dev_name);
+		return -EINVAL;
+	}
+	WRITE_ONCE(gpdev->rx_batch_us, tmp);
+
+	return n;
+}
+static DEVICE_ATTR_RW(rx_batch_us);
+
 static struct attribute *glink_pkt_device_attrs[] = {
 	&dev_attr_name.attr,
+	&dev_attr_rx_batch_us.attr,
 	NULL
 };
 ATTRIBUTE_GROUPS(glink_pkt_device);
@@ -673,6 +726,7 @@ static void glink_pkt_release_device(struct device *dev)
 {
 	struct glink_pkt_device *gpdev = dev_to_gpdev(dev);
 
+	hrtimer_cancel(&gpdev->rx_batch_timer);
 	ida_simple_remove(&glink_pkt_minor_ida, MINOR(gpdev->dev.devt));
 	cdev_del(&gpdev->cdev);
 	kfree(gpdev);
@@ -744,6 +798,8 @@ static int glink_pkt_create_device(struct device *parent,
 	spin_lock_init(&gpdev->queue_lock);
 	skb_queue_head_init(&gpdev->queue);
 	init_waitqueue_head(&gpdev->readq);
+	hrtimer_init(&gpdev->rx_batch_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	gpdev->rx_batch_timer.function = glink_pkt_rx_batch_fn;
 
 	device_initialize(dev);
 	dev->class = glink_pkt_class;
@@ -16,6 +16,7 @@
 #include <linux/slab.h>
 #include <linux/rtmutex.h>
 #include <linux/clk.h>
+#include <linux/workqueue.h>
 #include <linux/msm-bus.h>
 #include "msm_bus_core.h"
 #include "msm_bus_adhoc.h"
@@ -42,6 +43,20 @@ static LIST_HEAD(commit_list);
 
 DEFINE_RT_MUTEX(msm_bus_adhoc_lock);
 
+/*
+ * Votes that only lower bandwidth may be held back for up to
+ * coalesce_us so that a burst of updates from frequent voters ends up
+ * in a single commit of the graph. Any vote that raises bandwidth is
+ * still committed synchronously and takes pending decreases with it.
+ * Zero (the default) commits every update immediately.
+ */
+static unsigned int coalesce_us;
+module_param(coalesce_us, uint, 0644);
+
+static bool commit_has_increase;
+static void msm_bus_commit_work(struct work_struct *work);
+static DECLARE_DELAYED_WORK(msm_bus_commit_dwork, msm_bus_commit_work);
+
 static bool chk_bl_list(struct list_head *black_list, unsigned int id)
 {
 	struct msm_bus_node_device_type *bus_node = NULL;
@@ -654,6 +669,35 @@ static void commit_data(void)
 	INIT_LIST_HEAD(&input_list);
 	INIT_LIST_HEAD(&apply_list);
 	INIT_LIST_HEAD(&commit_list);
+	commit_has_increase = false;
+}
+
+static void msm_bus_commit_work(struct work_struct *work)
+{
+	rt_mutex_lock(&msm_bus_adhoc_lock);
+	if (!list_empty(&commit_list))
+		commit_data();
+	rt_mutex_unlock(&msm_bus_adhoc_lock);
+}
+
+/*
+ * Commit the dirty nodes now, or defer them to the coalescing window if
+ * nothing queued since the last commit raises bandwidth. The window is
+ * not re-armed by later votes, so a decrease is never held back for
+ * longer than coalesce_us.
+ */
+static void commit_data_coalesced(void)
+{
+	unsigned int window = READ_ONCE(coalesce_us);
+
+	if (!window || commit_has_increase) {
+		commit_data();
+		return;
+	}
+
+	if (!list_empty(&commit_list))
+		schedule_delayed_work(&msm_bus_commit_dwork,
+					usecs_to_jiffies(window));
 }
 
 static void add_node_to_clist(struct msm_bus_node_device_type *node)
@@ -719,6 +763,12 @@ static int update_path(struct device *src_dev, int dest, uint64_t act_req_ib,
 			ret = -ENXIO;
 			goto exit_update_path;
 		}
+		if (act_req_ib > lnode->lnode_ib[ACTIVE_CTX] ||
+			act_req_bw > lnode->lnode_ab[ACTIVE_CTX] ||
+			slp_req_ib > lnode->lnode_ib[DUAL_CTX] ||
+			slp_req_bw > lnode->lnode_ab[DUAL_CTX])
+			commit_has_increase = true;
+
 		lnode->lnode_ib[ACTIVE_CTX] = act_req_ib;
 		lnode->lnode_ab[ACTIVE_CTX] = act_req_bw;
 		lnode->lnode_ib[DUAL_CTX] = slp_req_ib;
@@ -1101,7 +1151,7 @@ static int update_client_paths(struct msm_bus_client *client, bool log_trns,
 		if (log_trns)
 			getpath_debug(src, lnode, pdata->active_only);
 	}
-	commit_data();
+	commit_data_coalesced();
 exit_update_client_paths:
 	return ret;
 }
@@ -1275,7 +1325,7 @@ static int update_bw_adhoc(struct msm_bus_client_handle *cl, u64 ab, u64 ib)
 		goto exit_update_request;
 	}
 
-	commit_data();
+	commit_data_coalesced();
 	cl->cur_act_ib = ib;
 	cl->cur_act_ab = ab;
 	cl->cur_dual_ib = slp_ib;
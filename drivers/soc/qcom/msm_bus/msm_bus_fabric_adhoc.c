@@ -26,6 +26,26 @@
 
 static int msm_bus_dev_init_qos(struct device *dev, void *data);
 
+/*
+ * With batch_rpm set, the RPM messages of one commit are sent without
+ * waiting for each ack and only the last message of the set is acked.
+ * RPM processes the SMD channel in order, so that single ack still
+ * means every vote of the commit has been applied.
+ */
+static bool batch_rpm;
+module_param(batch_rpm, bool, 0644);
+
+struct msm_bus_rpm_pending {
+	bool valid;
+	int rpm_ctx;
+	int rsc_type;
+	int rsc_id;
+	uint64_t bw;
+};
+
+static struct msm_bus_rpm_pending rpm_pending;
+static bool rpm_batching;
+
 ssize_t bw_show(struct device *dev, struct device_attribute *attr,
 			  char *buf)
 {
@@ -218,12 +238,71 @@ static int setrate_nodeclk(struct nodeclk *nclk, long rate)
 	return ret;
 }
 
+static int msm_bus_rpm_send(int rpm_ctx, int rsc_type, int rsc_id,
+				uint64_t *bw, bool noack)
+{
+	struct msm_rpm_kvp rpm_kvp;
+	void *ret;
+
+	rpm_kvp.length = sizeof(uint64_t);
+	rpm_kvp.key = RPM_MASTER_FIELD_BW;
+	rpm_kvp.data = (uint8_t *)bw;
+
+	if (!noack)
+		return msm_rpm_send_message(rpm_ctx, rsc_type, rsc_id,
+						&rpm_kvp, 1);
+
+	ret = msm_rpm_send_message_noack(rpm_ctx, rsc_type, rsc_id,
+						&rpm_kvp, 1);
+	return IS_ERR(ret) ? PTR_ERR(ret) : 0;
+}
+
+/*
+ * Queue one vote while a commit is being batched. The previously queued
+ * vote goes out without an ack; the newest one is held back so that
+ * msm_bus_rpm_flush() can send it with an ack.
+ */
+static int msm_bus_rpm_queue(int rpm_ctx, int rsc_type, int rsc_id,
+				uint64_t bw)
+{
+	struct msm_bus_rpm_pending *p = &rpm_pending;
+	int ret = 0;
+
+	if (p->valid)
+		ret = msm_bus_rpm_send(p->rpm_ctx, p->rsc_type, p->rsc_id,
+					&p->bw, true);
+
+	p->rpm_ctx = rpm_ctx;
+	p->rsc_type = rsc_type;
+	p->rsc_id = rsc_id;
+	p->bw = bw;
+	p->valid = true;
+	return ret;
+}
+
+static int msm_bus_rpm_flush(void)
+{
+	struct msm_bus_rpm_pending *p = &rpm_pending;
+	int ret;
+
+	if (!p->valid)
+		return 0;
+
+	p->valid = false;
+	ret = msm_bus_rpm_send(p->rpm_ctx, p->rsc_type, p->rsc_id,
+				&p->bw, false);
+	if (ret)
+		MSM_BUS_ERR("%s: Failed to flush RPM batch rsc %d id %d",
+				__func__, p->rsc_type, p->rsc_id);
+	return ret;
+}
+
 static int send_rpm_msg(struct msm_bus_node_device_type *ndev, int ctx)
 {
 	int ret = 0;
 	int rsc_type;
-	struct msm_rpm_kvp rpm_kvp;
 	int rpm_ctx;
+	uint64_t *bw;
 
 	if (!ndev) {
 		MSM_BUS_ERR("%s: Error getting node info.", __func__);
@@ -231,20 +310,21 @@ static int send_rpm_msg(struct msm_bus_node_device_type *ndev, int ctx)
 		goto exit_send_rpm_msg;
 	}
 
-	rpm_kvp.length = sizeof(uint64_t);
-	rpm_kvp.key = RPM_MASTER_FIELD_BW;
-
 	if (ctx == DUAL_CTX)
 		rpm_ctx = MSM_RPM_CTX_SLEEP_SET;
 	else
 		rpm_ctx = MSM_RPM_CTX_ACTIVE_SET;
 
-	rpm_kvp.data = (uint8_t *)&ndev->node_bw[ctx].sum_ab;
+	bw = &ndev->node_bw[ctx].sum_ab;
 
 	if (ndev->node_info->mas_rpm_id != -1) {
 		rsc_type = RPM_BUS_MASTER_REQ;
-		ret = msm_rpm_send_message(rpm_ctx, rsc_type,
-			ndev->node_info->mas_rpm_id, &rpm_kvp, 1);
+		if (rpm_batching)
+			ret = msm_bus_rpm_queue(rpm_ctx, rsc_type,
+				ndev->node_info->mas_rpm_id, *bw);
+		else
+			ret = msm_bus_rpm_send(rpm_ctx, rsc_type,
+				ndev->node_info->mas_rpm_id, bw, false);
 		if (ret) {
 			MSM_BUS_ERR("%s: Failed to send RPM message:",
 					__func__);
@@ -260,8 +340,12 @@ static int send_rpm_msg(struct msm_bus_node_device_type *ndev, int ctx)
 
 	if (ndev->node_info->slv_rpm_id != -1) {
 		rsc_type = RPM_BUS_SLAVE_REQ;
-		ret = msm_rpm_send_message(rpm_ctx, rsc_type,
-			ndev->node_info->slv_rpm_id, &rpm_kvp, 1);
+		if (rpm_batching)
+			ret = msm_bus_rpm_queue(rpm_ctx, rsc_type,
+				ndev->node_info->slv_rpm_id, *bw);
+		else
+			ret = msm_bus_rpm_send(rpm_ctx, rsc_type,
+				ndev->node_info->slv_rpm_id, bw, false);
 		if (ret) {
 			MSM_BUS_ERR("%s: Failed to send RPM message:",
 						__func__);
@@ -418,6 +502,8 @@ int msm_bus_commit_data(struct list_head *clist)
 	struct msm_bus_node_device_type *node;
 	struct msm_bus_node_device_type *node_tmp;
 
+	rpm_batching = READ_ONCE(batch_rpm);
+
 	list_for_each_entry(node, clist, link) {
 		/* Aggregate the bus clocks */
 		if (node->node_info->is_fab_dev)
@@ -441,6 +527,14 @@ int msm_bus_commit_data(struct list_head *clist)
 		node->dirty = false;
 		list_del_init(&node->link);
 	}
+
+	if (rpm_batching) {
+		int err = msm_bus_rpm_flush();
+
+		if (err)
+			ret = err;
+		rpm_batching = false;
+	}
 	return ret;
 }
 
@@ -35,6 +35,7 @@
 #include <soc/qcom/ramdump.h>
 #include <soc/qcom/subsystem_restart.h>
 #include <soc/qcom/secure_buffer.h>
+#include <soc/qcom/boot_stats.h>
 #include <linux/soc/qcom/smem.h>
 #include <linux/kthread.h>
 
@@ -1227,6 +1228,7 @@ int pil_boot(struct pil_desc *desc)
 	struct pil_priv *priv = desc->priv;
 	bool mem_protect = false;
 	bool hyp_assign = false;
+	ktime_t start = boot_event_start();
 
 	ret = pil_notify_aop(desc, "on");
 	if (ret < 0) {
@@ -1360,12 +1362,16 @@ int pil_boot(struct pil_desc *desc)
 		hyp_assign = false;
 	}
 
+	boot_event_record(BOOT_EVENT_PIL_LOAD, desc->name, start);
+
 	trace_pil_event("before_auth_reset", desc);
+	start = boot_event_start();
 	ret = desc->ops->auth_and_reset(desc);
 	if (ret) {
 		pil_err(desc, "Failed to bring out of reset(rc:%d)\n", ret);
 		goto err_auth_and_reset;
 	}
+	boot_event_record(BOOT_EVENT_PIL_AUTH, desc->name, start);
 	trace_pil_event("reset_done", desc);
 	pil_info(desc, "Brought out of reset\n");
 	desc->modem_ssr = false;
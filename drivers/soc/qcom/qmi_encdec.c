@@ -721,10 +721,48 @@ static int qmi_decode(struct qmi_elem_info *ei_array, void *out_c_struct,
 void *qmi_encode_message(int type, unsigned int msg_id, size_t *len,
 			 unsigned int txn_id, struct qmi_elem_info *ei,
 			 const void *c_struct)
+{
+	ssize_t msglen;
+	void *msg;
+
+	msg = kzalloc(sizeof(struct qmi_header) + *len, GFP_KERNEL);
+	if (!msg)
+		return ERR_PTR(-ENOMEM);
+
+	msglen = qmi_encode_message_buf(msg, *len, type, msg_id, txn_id,
+					ei, c_struct);
+	if (msglen < 0) {
+		kfree(msg);
+		return ERR_PTR(msglen);
+	}
+
+	*len = msglen;
+
+	return msg;
+}
+EXPORT_SYMBOL(qmi_encode_message);
+
+/**
+ * qmi_encode_message_buf() - Encode C structure as QMI message into @buf
+ * @buf:	Buffer of at least sizeof(struct qmi_header) + @len bytes
+ * @len:	Max length of the message, header excluded
+ * @type:	Type of QMI message
+ * @msg_id:	Message ID of the message
+ * @txn_id:	Transaction ID
+ * @ei:		QMI message descriptor
+ * @c_struct:	Reference to structure to encode
+ *
+ * Like qmi_encode_message(), for callers that reuse their own buffer.
+ *
+ * Returns the size of the encoded message including the header, or negative
+ * errno on error.
+ */
+ssize_t qmi_encode_message_buf(void *buf, size_t len, int type,
+			       unsigned int msg_id, unsigned int txn_id,
+			       struct qmi_elem_info *ei, const void *c_struct)
 {
 	struct qmi_header *hdr;
 	ssize_t msglen = 0;
-	void *msg;
 	int ret;
 
 	/* Check the possibility of a zero length QMI message */
@@ -733,36 +771,28 @@ void *qmi_encode_message(int type, unsigned int msg_id, size_t *len,
 		if (ret) {
 			pr_err("%s: Calc. len %d != 0, but NULL c_struct\n",
 			       __func__, ret);
-			return ERR_PTR(-EINVAL);
+			return -EINVAL;
 		}
 	}
 	if (WARN_ON(ei && !c_struct))
-		return ERR_PTR(-EINVAL);
-
-	msg = kzalloc(sizeof(*hdr) + *len, GFP_KERNEL);
-	if (!msg)
-		return ERR_PTR(-ENOMEM);
+		return -EINVAL;
 
 	/* Encode message, if we have a message */
 	if (c_struct) {
-		msglen = qmi_encode(ei, msg + sizeof(*hdr), c_struct, *len, 1);
-		if (msglen < 0) {
-			kfree(msg);
-			return ERR_PTR(msglen);
-		}
+		msglen = qmi_encode(ei, buf + sizeof(*hdr), c_struct, len, 1);
+		if (msglen < 0)
+			return msglen;
 	}
 
-	hdr = msg;
+	hdr = buf;
 	hdr->type = type;
 	hdr->txn_id = txn_id;
 	hdr->msg_id = msg_id;
 	hdr->msg_len = msglen;
 
-	*len = sizeof(*hdr) + msglen;
-
-	return msg;
+	return sizeof(*hdr) + msglen;
 }
-EXPORT_SYMBOL(qmi_encode_message);
+EXPORT_SYMBOL(qmi_encode_message_buf);
 
 /**
  * qmi_decode_message() - Decode QMI encoded message to C structure
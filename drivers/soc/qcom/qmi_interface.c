@@ -411,9 +411,18 @@ static void qmi_invoke_handler(struct qmi_handle *qmi, struct sockaddr_qrtr *sq,
 	if (!handler->fn)
 		return;
 
-	dest = kzalloc(handler->decoded_size, GFP_KERNEL);
-	if (!dest)
-		return;
+	/*
+	 * Messages are handled one at a time from qmi->work, so the decode
+	 * buffer sized for the largest handler at init can be reused.
+	 */
+	if (handler->decoded_size <= qmi->decode_buf_size) {
+		dest = qmi->decode_buf;
+		memset(dest, 0, handler->decoded_size);
+	} else {
+		dest = kzalloc(handler->decoded_size, GFP_KERNEL);
+		if (!dest)
+			return;
+	}
 
 	ret = qmi_decode_message(buf, len, handler->ei, dest);
 	if (ret < 0)
@@ -421,7 +430,8 @@ static void qmi_invoke_handler(struct qmi_handle *qmi, struct sockaddr_qrtr *sq,
 	else
 		handler->fn(qmi, sq, txn, dest);
 
-	kfree(dest);
+	if (dest != qmi->decode_buf)
+		kfree(dest);
 }
 
 /**
@@ -645,6 +655,7 @@ EXPORT_SYMBOL(qmi_set_sndtimeo);
 int qmi_handle_init(struct qmi_handle *qmi, size_t recv_buf_size,
 		    struct qmi_ops *ops, struct qmi_msg_handler *handlers)
 {
+	struct qmi_msg_handler *handler;
 	int ret;
 
 	mutex_init(&qmi->txn_lock);
@@ -672,6 +683,20 @@ int qmi_handle_init(struct qmi_handle *qmi, size_t recv_buf_size,
 	if (!qmi->recv_buf)
 		return -ENOMEM;
 
+	qmi->decode_buf_size = 0;
+	for (handler = handlers; handler && handler->fn; handler++)
+		qmi->decode_buf_size = max(qmi->decode_buf_size,
+					   handler->decoded_size);
+	if (qmi->decode_buf_size) {
+		/* without it messages are decoded into a kzalloc'd buffer */
+		qmi->decode_buf = kzalloc(qmi->decode_buf_size, GFP_KERNEL);
+		if (!qmi->decode_buf)
+			qmi->decode_buf_size = 0;
+	}
+
+	qmi->send_buf = NULL;
+	qmi->send_buf_size = 0;
+
 	qmi->wq = alloc_workqueue("qmi_msg_handler", WQ_UNBOUND, 1);
 	if (!qmi->wq) {
 		ret = -ENOMEM;
@@ -690,6 +715,7 @@ int qmi_handle_init(struct qmi_handle *qmi, size_t recv_buf_size,
 err_destroy_wq:
 	destroy_workqueue(qmi->wq);
 err_free_recv_buf:
+	kfree(qmi->decode_buf);
 	kfree(qmi->recv_buf);
 
 	return ret;
@@ -734,6 +760,8 @@ void qmi_handle_release(struct qmi_handle *qmi)
 	idr_destroy(&qmi->txns);
 
 	kfree(qmi->recv_buf);
+	kfree(qmi->decode_buf);
+	kfree(qmi->send_buf);
 
 	/* Free registered lookup requests */
 	list_for_each_entry_safe(svc, tmp, &qmi->lookups, list_node) {
@@ -772,37 +800,53 @@ static ssize_t qmi_send_message(struct qmi_handle *qmi,
 				struct qmi_elem_info *ei, const void *c_struct)
 {
 	struct msghdr msghdr = {0};
+	size_t size = sizeof(struct qmi_header) + len;
 	struct kvec iv;
+	ssize_t msglen;
 	void *msg;
 	int ret;
 
-	msg = qmi_encode_message(type,
-				 msg_id, &len,
-				 txn->id, ei,
-				 c_struct);
-	if (IS_ERR(msg))
-		return PTR_ERR(msg);
-
-	iv.iov_base = msg;
-	iv.iov_len = len;
-
 	if (sq) {
 		msghdr.msg_name = sq;
 		msghdr.msg_namelen = sizeof(*sq);
 	}
 
+	/*
+	 * Encode into the handle's send buffer, grown to the largest message
+	 * sent so far, instead of allocating one per message. sock_lock
+	 * already serializes the senders.
+	 */
 	mutex_lock(&qmi->sock_lock);
+	if (size > qmi->send_buf_size) {
+		msg = krealloc(qmi->send_buf, size, GFP_KERNEL);
+		if (!msg) {
+			ret = -ENOMEM;
+			goto out_unlock;
+		}
+		qmi->send_buf = msg;
+		qmi->send_buf_size = size;
+	}
+
+	msglen = qmi_encode_message_buf(qmi->send_buf, len, type, msg_id,
+					txn->id, ei, c_struct);
+	if (msglen < 0) {
+		ret = msglen;
+		goto out_unlock;
+	}
+
+	iv.iov_base = qmi->send_buf;
+	iv.iov_len = msglen;
+
 	if (qmi->sock) {
-		ret = kernel_sendmsg(qmi->sock, &msghdr, &iv, 1, len);
+		ret = kernel_sendmsg(qmi->sock, &msghdr, &iv, 1, msglen);
 		if (ret < 0)
 			pr_info("failed to send QMI message %d\n", ret);
 	} else {
 		ret = -EPIPE;
 	}
+out_unlock:
 	mutex_unlock(&qmi->sock_lock);
 
-	kfree(msg);
-
 	return ret < 0 ? ret : 0;
 }
 
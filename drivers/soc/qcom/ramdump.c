@@ -20,6 +20,7 @@
 #include <linux/mm.h>
 #include <linux/slab.h>
 #include <linux/poll.h>
+#include <linux/shmem_fs.h>
 #include <linux/uaccess.h>
 #include <linux/elf.h>
 #include <linux/wait.h>
@@ -42,9 +43,19 @@ static bool ramdump_devnode_inited;
 #define MAX_STRTBL_SIZE 512
 #define MAX_NAME_LENGTH 16
 
+/*
+ * Copy the dump into a shmem file and let the subsystem restart right
+ * away, instead of holding the restart until userspace has read it all.
+ */
+static bool ramdump_capture;
+module_param(ramdump_capture, bool, 0644);
+MODULE_PARM_DESC(ramdump_capture,
+		 "Capture dumps in memory and don't wait for the reader");
+
 struct consumer_entry {
 	bool data_ready;
 	struct ramdump_device *rd_dev;
+	struct file *capture;
 	struct list_head list;
 };
 
@@ -114,6 +125,8 @@ static int ramdump_release(struct inode *inode, struct file *filep)
 	 */
 	if (entry->data_ready)
 		reset_ramdump_entry(entry);
+	if (entry->capture)
+		fput(entry->capture);
 	rd_dev->consumers--;
 	list_del(&entry->list);
 	mutex_unlock(&rd_dev->consumer_lock);
@@ -156,16 +169,80 @@ static unsigned long offset_translate(loff_t user_offset,
 
 #define MAX_IOREMAP_SIZE SZ_1M
 
+/* device memory is only accessed with aligned 64 bit copies */
+static void ramdump_copy_from_dev(void *dst, void *src, size_t size)
+{
+	size_t bytes_before, bytes_after;
+
+	if ((unsigned long)src & 0x7) {
+		bytes_before = 8 - ((unsigned long)src & 0x7);
+		memcpy_fromio(dst, src, bytes_before);
+		src += bytes_before;
+		dst += bytes_before;
+		size -= bytes_before;
+	}
+
+	if (size & 0x7) {
+		bytes_after = size & 0x7;
+		memcpy(dst, src, size - bytes_after);
+		src += size - bytes_after;
+		dst += size - bytes_after;
+		memcpy_fromio(dst, src, bytes_after);
+	} else
+		memcpy(dst, src, size);
+}
+
+static ssize_t ramdump_read_capture(struct consumer_entry *entry,
+		char __user *buf, size_t count, loff_t *pos)
+{
+	loff_t size = i_size_read(file_inode(entry->capture));
+	size_t copy_size;
+	ssize_t ret = 0;
+	void *kbuf;
+
+	if (*pos >= size)
+		goto capture_done;
+
+	copy_size = min_t(size_t, count, MAX_IOREMAP_SIZE);
+	copy_size = min_t(loff_t, copy_size, size - *pos);
+	kbuf = kmalloc(copy_size, GFP_KERNEL);
+	if (!kbuf) {
+		ret = -ENOMEM;
+		goto capture_done;
+	}
+
+	ret = kernel_read(entry->capture, kbuf, copy_size, pos);
+	if (ret > 0 && copy_to_user(buf, kbuf, ret))
+		ret = -EFAULT;
+	kfree(kbuf);
+	if (ret > 0)
+		return ret;
+	if (!ret)
+		ret = -EIO;
+
+capture_done:
+	if (!ret)
+		pr_debug("Ramdump(%s): Captured ramdump read. %lld bytes read.",
+			 entry->rd_dev->name, *pos);
+	*pos = 0;
+	mutex_lock(&entry->rd_dev->consumer_lock);
+	fput(entry->capture);
+	entry->capture = NULL;
+	reset_ramdump_entry(entry);
+	mutex_unlock(&entry->rd_dev->consumer_lock);
+	return ret;
+}
+
 static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 			loff_t *pos)
 {
 	struct consumer_entry *entry = filep->private_data;
 	struct ramdump_device *rd_dev = entry->rd_dev;
-	void *device_mem = NULL, *origdevice_mem = NULL, *vaddr = NULL;
-	unsigned long data_left = 0, bytes_before, bytes_after;
+	void *device_mem = NULL, *vaddr = NULL;
+	unsigned long data_left = 0;
 	unsigned long addr = 0;
-	size_t copy_size = 0, alignsize;
-	unsigned char *alignbuf = NULL, *finalbuf = NULL;
+	size_t copy_size = 0;
+	unsigned char *finalbuf = NULL;
 	int ret = 0;
 	loff_t orig_pos = *pos;
 
@@ -176,6 +253,9 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 	if (ret)
 		return ret;
 
+	if (entry->capture)
+		return ramdump_read_capture(entry, buf, count, pos);
+
 	if (*pos < rd_dev->elfcore_size) {
 		copy_size = rd_dev->elfcore_size - *pos;
 		copy_size = min(copy_size, count);
@@ -210,7 +290,6 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 	rd_dev->attrs |= DMA_ATTR_SKIP_ZEROING;
 	device_mem = vaddr ?: dma_remap(rd_dev->dev->parent, NULL, addr,
 						copy_size, rd_dev->attrs);
-	origdevice_mem = device_mem;
 
 	if (device_mem == NULL) {
 		pr_err("Ramdump(%s): Unable to ioremap: addr %lx, size %zd\n",
@@ -220,33 +299,14 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 		goto ramdump_done;
 	}
 
-	alignbuf = kzalloc(copy_size, GFP_KERNEL);
-	if (!alignbuf) {
+	finalbuf = kzalloc(copy_size, GFP_KERNEL);
+	if (!finalbuf) {
 		rd_dev->ramdump_status = -1;
 		ret = -ENOMEM;
 		goto ramdump_done;
 	}
 
-	finalbuf = alignbuf;
-	alignsize = copy_size;
-
-	if ((unsigned long)device_mem & 0x7) {
-		bytes_before = 8 - ((unsigned long)device_mem & 0x7);
-		memcpy_fromio(alignbuf, device_mem, bytes_before);
-		device_mem += bytes_before;
-		alignbuf += bytes_before;
-		alignsize -= bytes_before;
-	}
-
-	if (alignsize & 0x7) {
-		bytes_after = alignsize & 0x7;
-		memcpy(alignbuf, device_mem, alignsize - bytes_after);
-		device_mem += alignsize - bytes_after;
-		alignbuf += (alignsize - bytes_after);
-		alignsize = bytes_after;
-		memcpy_fromio(alignbuf, device_mem, alignsize);
-	} else
-		memcpy(alignbuf, device_mem, alignsize);
+	ramdump_copy_from_dev(finalbuf, device_mem, copy_size);
 
 	if (copy_to_user(buf, finalbuf, copy_size)) {
 		pr_err("Ramdump(%s): Couldn't copy all data to user.",
@@ -257,8 +317,8 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 	}
 
 	kfree(finalbuf);
-	if (!vaddr && origdevice_mem)
-		dma_unremap(rd_dev->dev->parent, origdevice_mem, copy_size);
+	if (!vaddr && device_mem)
+		dma_unremap(rd_dev->dev->parent, device_mem, copy_size);
 
 	*pos += copy_size;
 
@@ -268,8 +328,8 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 	return *pos - orig_pos;
 
 ramdump_done:
-	if (!vaddr && origdevice_mem)
-		dma_unremap(rd_dev->dev->parent, origdevice_mem, copy_size);
+	if (!vaddr && device_mem)
+		dma_unremap(rd_dev->dev->parent, device_mem, copy_size);
 
 	kfree(finalbuf);
 	*pos = 0;
@@ -412,6 +472,105 @@ void destroy_ramdump_device(void *dev)
 }
 EXPORT_SYMBOL(destroy_ramdump_device);
 
+/*
+ * Called with consumer_lock held, which is dropped here. The ELF header
+ * and all segments are copied into a shmem file that is handed to the
+ * current readers, and the dump returns without waiting for them.
+ */
+static int ramdump_capture_dump(struct ramdump_device *rd_dev)
+{
+	struct consumer_entry *entry;
+	struct ramdump_segment *seg;
+	struct file *file;
+	loff_t pos = 0, size = rd_dev->elfcore_size;
+	unsigned long addr, off, len;
+	void *device_mem, *buf = NULL;
+	ssize_t written;
+	int i, readers = 0, ret = 0;
+
+	for (i = 0; i < rd_dev->nsegments; i++)
+		size += rd_dev->segments[i].size;
+
+	file = shmem_file_setup(rd_dev->name, size, VM_NORESERVE);
+	if (IS_ERR(file)) {
+		ret = PTR_ERR(file);
+		goto capture_out;
+	}
+
+	buf = kmalloc(MAX_IOREMAP_SIZE, GFP_KERNEL);
+	if (!buf) {
+		ret = -ENOMEM;
+		goto capture_fput;
+	}
+
+	if (rd_dev->elfcore_size) {
+		written = kernel_write(file, rd_dev->elfcore_buf,
+				       rd_dev->elfcore_size, &pos);
+		if (written != (ssize_t)rd_dev->elfcore_size) {
+			ret = written < 0 ? written : -ENOSPC;
+			goto capture_fput;
+		}
+	}
+
+	for (i = 0; i < rd_dev->nsegments; i++) {
+		seg = &rd_dev->segments[i];
+		for (off = 0; off < seg->size; off += len) {
+			len = min_t(unsigned long, seg->size - off,
+				    MAX_IOREMAP_SIZE);
+			addr = seg->address + off;
+			device_mem = seg->v_address ? seg->v_address + off :
+				dma_remap(rd_dev->dev->parent, NULL, addr, len,
+					  DMA_ATTR_SKIP_ZEROING);
+			if (!device_mem) {
+				pr_err("Ramdump(%s): Unable to ioremap: addr %lx, size %lu\n",
+					rd_dev->name, addr, len);
+				ret = -ENOMEM;
+				goto capture_fput;
+			}
+
+			ramdump_copy_from_dev(buf, device_mem, len);
+			if (!seg->v_address)
+				dma_unremap(rd_dev->dev->parent, device_mem,
+					    len);
+
+			written = kernel_write(file, buf, len, &pos);
+			if (written != (ssize_t)len) {
+				ret = written < 0 ? written : -ENOSPC;
+				goto capture_fput;
+			}
+		}
+	}
+
+	list_for_each_entry(entry, &rd_dev->consumer_list, list) {
+		/* still reading an earlier capture */
+		if (entry->capture)
+			continue;
+		entry->capture = get_file(file);
+		entry->data_ready = true;
+		readers++;
+	}
+	atomic_set(&rd_dev->readers_left, readers);
+
+	/* Tell userspace that the data is ready */
+	wake_up(&rd_dev->dump_wait_q);
+	pr_info("Ramdump(%s): Captured %lld bytes for %d readers\n",
+		rd_dev->name, size, readers);
+
+capture_fput:
+	fput(file);
+capture_out:
+	mutex_unlock(&rd_dev->consumer_lock);
+	kfree(buf);
+	if (ret)
+		pr_err("Ramdump(%s): Capture failed (%d)\n", rd_dev->name,
+		       ret);
+
+	rd_dev->elfcore_size = 0;
+	kfree(rd_dev->elfcore_buf);
+	rd_dev->elfcore_buf = NULL;
+	return ret;
+}
+
 static int _do_ramdump(void *handle, struct ramdump_segment *segments,
 		int nsegments, bool use_elf)
 {
@@ -484,6 +643,9 @@ static int _do_ramdump(void *handle, struct ramdump_segment *segments,
 		}
 	}
 
+	if (ramdump_capture)
+		return ramdump_capture_dump(rd_dev);
+
 	list_for_each_entry(entry, &rd_dev->consumer_list, list)
 		entry->data_ready = true;
 	rd_dev->ramdump_status = -1;
@@ -613,6 +775,9 @@ static int _do_minidump(void *handle, struct ramdump_segment *segments,
 	}
 	ehdr->e_shnum = nsegments + 2;
 
+	if (ramdump_capture)
+		return ramdump_capture_dump(rd_dev);
+
 	list_for_each_entry(entry, &rd_dev->consumer_list, list)
 		entry->data_ready = true;
 	rd_dev->ramdump_status = -1;
@@ -36,6 +36,7 @@
 #include <linux/vmalloc.h>
 #include <linux/debugfs.h>
 #include <linux/dma-buf.h>
+#include <linux/dma-heap.h>
 #include <linux/idr.h>
 #include <linux/sched/task.h>
 #include <linux/bitops.h>
@@ -104,7 +105,10 @@ static void ion_buffer_add(struct ion_device *dev,
 	rb_insert_color(&buffer->node, &dev->buffers);
 }
 
-/* this function should only be called while dev->lock is held */
+/*
+ * dev->lock only protects the heap list; callers that already hold a heap
+ * (such as the dma-buf heap chardevs) may call this without it.
+ */
 static struct ion_buffer *ion_buffer_create(struct ion_heap *heap,
 					    struct ion_device *dev,
 					    unsigned long len,
@@ -1042,15 +1046,37 @@ static const struct dma_buf_ops dma_buf_ops = {
 	.get_flags = ion_dma_buf_get_flags,
 };
 
+static struct dma_buf *ion_buffer_export(struct ion_buffer *buffer)
+{
+	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+	struct dma_buf *dmabuf;
+	char task_comm[TASK_COMM_LEN];
+
+	get_task_comm(task_comm, current->group_leader);
+
+	exp_info.ops = &dma_buf_ops;
+	exp_info.size = buffer->size;
+	exp_info.flags = O_RDWR;
+	exp_info.priv = buffer;
+	exp_info.exp_name = kasprintf(GFP_KERNEL, "%s-%s-%d-%s", KBUILD_MODNAME,
+				      buffer->heap->name, current->tgid,
+				      task_comm);
+
+	dmabuf = dma_buf_export(&exp_info);
+	if (IS_ERR(dmabuf)) {
+		_ion_buffer_destroy(buffer);
+		kfree(exp_info.exp_name);
+	}
+
+	return dmabuf;
+}
+
 struct dma_buf *ion_alloc_dmabuf(size_t len, unsigned int heap_id_mask,
 				 unsigned int flags)
 {
 	struct ion_device *dev = internal_dev;
 	struct ion_buffer *buffer = NULL;
 	struct ion_heap *heap;
-	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
-	struct dma_buf *dmabuf;
-	char task_comm[TASK_COMM_LEN];
 
 	pr_debug("%s: len %zu heap_id_mask %u flags %x\n", __func__,
 		 len, heap_id_mask, flags);
@@ -1082,22 +1108,7 @@ struct dma_buf *ion_alloc_dmabuf(size_t len, unsigned int heap_id_mask,
 	if (IS_ERR(buffer))
 		return ERR_CAST(buffer);
 
-	get_task_comm(task_comm, current->group_leader);
-
-	exp_info.ops = &dma_buf_ops;
-	exp_info.size = buffer->size;
-	exp_info.flags = O_RDWR;
-	exp_info.priv = buffer;
-	exp_info.exp_name = kasprintf(GFP_KERNEL, "%s-%s-%d-%s", KBUILD_MODNAME,
-				      heap->name, current->tgid, task_comm);
-
-	dmabuf = dma_buf_export(&exp_info);
-	if (IS_ERR(dmabuf)) {
-		_ion_buffer_destroy(buffer);
-		kfree(exp_info.exp_name);
-	}
-
-	return dmabuf;
+	return ion_buffer_export(buffer);
 }
 
 struct dma_buf *ion_alloc(size_t len, unsigned int heap_id_mask,
@@ -1248,6 +1259,54 @@ static int debug_shrink_get(void *data, u64 *val)
 DEFINE_SIMPLE_ATTRIBUTE(debug_shrink_fops, debug_shrink_get,
 			debug_shrink_set, "%llu\n");
 
+#ifdef CONFIG_DMABUF_HEAPS
+/*
+ * Allocation through /dev/dma_heap/<heap name>: the heap is known from the
+ * chardev, so neither the heap list nor dev->lock is involved. heap_flags
+ * carry the ION_FLAG_* bits, e.g. ION_FLAG_CACHED.
+ */
+static struct dma_buf *ion_dma_heap_allocate(struct dma_heap *dma_heap,
+					     unsigned long len,
+					     unsigned long fd_flags,
+					     unsigned long heap_flags)
+{
+	struct ion_heap *heap = dma_heap_get_drvdata(dma_heap);
+	struct ion_buffer *buffer;
+
+	if (heap_flags > UINT_MAX)
+		return ERR_PTR(-EINVAL);
+
+	buffer = ion_buffer_create(heap, heap->dev, len, heap_flags);
+	if (IS_ERR(buffer))
+		return ERR_CAST(buffer);
+
+	return ion_buffer_export(buffer);
+}
+
+static const struct dma_heap_ops ion_dma_heap_ops = {
+	.allocate = ion_dma_heap_allocate,
+};
+
+static void ion_add_dma_heap(struct ion_heap *heap)
+{
+	struct dma_heap_export_info exp_info = {
+		.name = heap->name,
+		.ops = &ion_dma_heap_ops,
+		.priv = heap,
+	};
+	struct dma_heap *dma_heap;
+
+	dma_heap = dma_heap_add(&exp_info);
+	if (IS_ERR(dma_heap))
+		pr_warn("%s: no dma-buf heap for %s: %ld\n", __func__,
+			heap->name, PTR_ERR(dma_heap));
+}
+#else
+static inline void ion_add_dma_heap(struct ion_heap *heap)
+{
+}
+#endif
+
 void ion_device_add_heap(struct ion_device *dev, struct ion_heap *heap)
 {
 	struct dentry *debug_file;
@@ -1292,6 +1351,8 @@ void ion_device_add_heap(struct ion_device *dev, struct ion_heap *heap)
 
 	dev->heap_cnt++;
 	up_write(&dev->lock);
+
+	ion_add_dma_heap(heap);
 }
 EXPORT_SYMBOL(ion_device_add_heap);
 
@@ -420,6 +420,24 @@ struct ion_heap *ion_secure_carveout_heap_create(
  * many systems
  */
 
+/*
+ * Each pool has a small per-cpu magazine in front of its shared lists, sized
+ * in base pages and holding at least one item of any order.
+ */
+#define ION_PAGE_POOL_PCP_PAGES	256
+
+/**
+ * struct ion_page_pool_pcp - per-cpu page magazine
+ * @lock:		protects @items and @count
+ * @count:		number of items in the magazine
+ * @items:		list of cached items, highmem and lowmem mixed
+ */
+struct ion_page_pool_pcp {
+	spinlock_t lock;
+	int count;
+	struct list_head items;
+};
+
 /**
  * struct ion_page_pool - pagepool struct
  * @high_count:		number of highmem items in the pool
@@ -432,6 +450,10 @@ struct ion_heap *ion_secure_carveout_heap_create(
  * @order:		order of pages in the pool
  * @list:		plist node for list of pools
  * @cached:		it's cached pool or not
+ * @pcp:		per-cpu magazines checked before the shared lists
+ * @pcp_high:		capacity of each magazine in items
+ * @low_mark:		background refill starts below this many items
+ * @high_mark:		background refill stops at this many items
  *
  * Allows you to keep a pool of pre allocated pages to use from your heap.
  * Keeping a pool of pages that is ready for dma, ie any cached mapping have
@@ -449,6 +471,10 @@ struct ion_page_pool {
 	gfp_t gfp_mask;
 	unsigned int order;
 	struct plist_node list;
+	struct ion_page_pool_pcp __percpu *pcp;
+	int pcp_high;
+	int low_mark;
+	int high_mark;
 };
 
 struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order,
@@ -462,6 +488,22 @@ struct page *ion_page_pool_alloc_pool_only(struct ion_page_pool *a);
 void ion_page_pool_free_immediate(struct ion_page_pool *pool,
 				  struct page *page);
 int ion_page_pool_total(struct ion_page_pool *pool, bool high);
+int ion_page_pool_pcp_count(struct ion_page_pool *pool);
+
+#ifdef CONFIG_ION_POOL_AUTO_REFILL
+bool ion_page_pool_needs_refill(struct ion_page_pool *pool);
+void ion_page_pool_refill(struct ion_page_pool *pool, struct device *dev);
+#else
+static inline bool ion_page_pool_needs_refill(struct ion_page_pool *pool)
+{
+	return false;
+}
+
+static inline void ion_page_pool_refill(struct ion_page_pool *pool,
+					struct device *dev)
+{
+}
+#endif
 size_t ion_system_heap_secure_page_pool_total(struct ion_heap *heap, int vmid);
 
 /** ion_page_pool_shrink - shrinks the size of the memory cached in the pool
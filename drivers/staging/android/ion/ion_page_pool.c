@@ -20,6 +20,8 @@
 #include <linux/fs.h>
 #include <linux/list.h>
 #include <linux/init.h>
+#include <linux/kthread.h>
+#include <linux/percpu.h>
 #include <linux/slab.h>
 #include <linux/swap.h>
 #include <linux/sched/signal.h>
@@ -44,19 +46,73 @@ static void ion_page_pool_free_pages(struct ion_page_pool *pool,
 	mod_node_page_state(page_pgdat(page), NR_ION_HEAP, -(1 << pool->order));
 }
 
-static int ion_page_pool_add(struct ion_page_pool *pool, struct page *page)
+static void ion_page_pool_put_batch(struct ion_page_pool *pool,
+				    struct list_head *batch)
 {
-	mutex_lock(&pool->mutex);
-	if (PageHighMem(page)) {
-		list_add_tail(&page->lru, &pool->high_items);
-		pool->high_count++;
-	} else {
-		list_add_tail(&page->lru, &pool->low_items);
-		pool->low_count++;
+	struct page *page, *tmp;
+
+	list_for_each_entry_safe(page, tmp, batch, lru) {
+		if (PageHighMem(page)) {
+			list_move_tail(&page->lru, &pool->high_items);
+			pool->high_count++;
+		} else {
+			list_move_tail(&page->lru, &pool->low_items);
+			pool->low_count++;
+		}
+	}
+}
+
+static int ion_page_pool_take_batch(struct ion_page_pool *pool,
+				    struct list_head *batch, int nr)
+{
+	struct page *page;
+	int taken = 0;
+
+	while (taken < nr) {
+		if (pool->high_count) {
+			page = list_first_entry(&pool->high_items,
+						struct page, lru);
+			pool->high_count--;
+		} else if (pool->low_count) {
+			page = list_first_entry(&pool->low_items,
+						struct page, lru);
+			pool->low_count--;
+		} else {
+			break;
+		}
+		list_move_tail(&page->lru, batch);
+		taken++;
 	}
+	return taken;
+}
+
+static int ion_page_pool_add(struct ion_page_pool *pool, struct page *page)
+{
+	struct ion_page_pool_pcp *pcp = raw_cpu_ptr(pool->pcp);
+	LIST_HEAD(batch);
+	int nr;
 
 	mod_node_page_state(page_pgdat(page), NR_ION_HEAP_POOL,
 			    (1 << pool->order));
+
+	spin_lock(&pcp->lock);
+	if (pcp->count < pool->pcp_high) {
+		list_add(&page->lru, &pcp->items);
+		pcp->count++;
+		spin_unlock(&pcp->lock);
+		return 0;
+	}
+
+	/* Magazine is full, push the older half back to the shared lists */
+	for (nr = pcp->count / 2; nr; nr--) {
+		list_move(pcp->items.prev, &batch);
+		pcp->count--;
+	}
+	spin_unlock(&pcp->lock);
+	list_add_tail(&page->lru, &batch);
+
+	mutex_lock(&pool->mutex);
+	ion_page_pool_put_batch(pool, &batch);
 	mutex_unlock(&pool->mutex);
 	return 0;
 }
@@ -81,6 +137,82 @@ static struct page *ion_page_pool_remove(struct ion_page_pool *pool, bool high)
 	return page;
 }
 
+/*
+ * Take a page from this cpu's magazine. An empty magazine is refilled with
+ * half its capacity from the shared lists in one go, so pool->mutex is only
+ * touched once per batch rather than once per page.
+ */
+static struct page *ion_page_pool_fetch(struct ion_page_pool *pool)
+{
+	struct ion_page_pool_pcp *pcp = raw_cpu_ptr(pool->pcp);
+	struct page *page = NULL;
+	LIST_HEAD(batch);
+	int nr;
+
+	spin_lock(&pcp->lock);
+	if (pcp->count) {
+		page = list_first_entry(&pcp->items, struct page, lru);
+		list_del(&page->lru);
+		pcp->count--;
+	}
+	spin_unlock(&pcp->lock);
+
+	if (!page) {
+		if (!mutex_trylock(&pool->mutex))
+			return NULL;
+		nr = ion_page_pool_take_batch(pool, &batch,
+					      max(pool->pcp_high / 2, 1));
+		mutex_unlock(&pool->mutex);
+		if (!nr)
+			return NULL;
+
+		page = list_first_entry(&batch, struct page, lru);
+		list_del(&page->lru);
+		if (--nr) {
+			spin_lock(&pcp->lock);
+			list_splice(&batch, &pcp->items);
+			pcp->count += nr;
+			spin_unlock(&pcp->lock);
+		}
+	}
+
+	mod_node_page_state(page_pgdat(page), NR_ION_HEAP_POOL,
+			    -(1 << pool->order));
+	return page;
+}
+
+static void ion_page_pool_drain_pcp(struct ion_page_pool *pool)
+{
+	LIST_HEAD(batch);
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct ion_page_pool_pcp *pcp = per_cpu_ptr(pool->pcp, cpu);
+
+		spin_lock(&pcp->lock);
+		list_splice_init(&pcp->items, &batch);
+		pcp->count = 0;
+		spin_unlock(&pcp->lock);
+	}
+
+	if (list_empty(&batch))
+		return;
+
+	mutex_lock(&pool->mutex);
+	ion_page_pool_put_batch(pool, &batch);
+	mutex_unlock(&pool->mutex);
+}
+
+int ion_page_pool_pcp_count(struct ion_page_pool *pool)
+{
+	int cpu, count = 0;
+
+	for_each_possible_cpu(cpu)
+		count += READ_ONCE(per_cpu_ptr(pool->pcp, cpu)->count);
+
+	return count;
+}
+
 struct page *ion_page_pool_alloc(struct ion_page_pool *pool, bool *from_pool)
 {
 	struct page *page = NULL;
@@ -90,13 +222,8 @@ struct page *ion_page_pool_alloc(struct ion_page_pool *pool, bool *from_pool)
 	if (fatal_signal_pending(current))
 		return ERR_PTR(-EINTR);
 
-	if (*from_pool && mutex_trylock(&pool->mutex)) {
-		if (pool->high_count)
-			page = ion_page_pool_remove(pool, true);
-		else if (pool->low_count)
-			page = ion_page_pool_remove(pool, false);
-		mutex_unlock(&pool->mutex);
-	}
+	if (*from_pool)
+		page = ion_page_pool_fetch(pool);
 	if (!page) {
 		page = ion_page_pool_alloc_pages(pool);
 		*from_pool = false;
@@ -112,19 +239,12 @@ struct page *ion_page_pool_alloc(struct ion_page_pool *pool, bool *from_pool)
  */
 struct page *ion_page_pool_alloc_pool_only(struct ion_page_pool *pool)
 {
-	struct page *page = NULL;
+	struct page *page;
 
 	if (!pool)
 		return ERR_PTR(-EINVAL);
 
-	if (mutex_trylock(&pool->mutex)) {
-		if (pool->high_count)
-			page = ion_page_pool_remove(pool, true);
-		else if (pool->low_count)
-			page = ion_page_pool_remove(pool, false);
-		mutex_unlock(&pool->mutex);
-	}
-
+	page = ion_page_pool_fetch(pool);
 	if (!page)
 		return ERR_PTR(-ENOMEM);
 	return page;
@@ -146,7 +266,7 @@ void ion_page_pool_free_immediate(struct ion_page_pool *pool, struct page *page)
 
 int ion_page_pool_total(struct ion_page_pool *pool, bool high)
 {
-	int count = pool->low_count;
+	int count = pool->low_count + ion_page_pool_pcp_count(pool);
 
 	if (high)
 		count += pool->high_count;
@@ -154,6 +274,66 @@ int ion_page_pool_total(struct ion_page_pool *pool, bool high)
 	return count << pool->order;
 }
 
+#ifdef CONFIG_ION_POOL_AUTO_REFILL
+static int ion_page_pool_count(struct ion_page_pool *pool)
+{
+	return pool->high_count + pool->low_count +
+		ion_page_pool_pcp_count(pool);
+}
+
+bool ion_page_pool_needs_refill(struct ion_page_pool *pool)
+{
+	return pool->low_mark && ion_page_pool_count(pool) < pool->low_mark;
+}
+
+/* Keeping the pool warm must never eat into the page allocator reserves */
+static bool ion_page_pool_refill_ok(struct ion_page_pool *pool)
+{
+	return global_zone_page_state(NR_FREE_PAGES) >
+		2 * totalreserve_pages + (1 << pool->order);
+}
+
+/**
+ * ion_page_pool_refill - top up a pool to its high mark
+ * @pool:		the pool
+ * @dev:		device the pages are flushed for
+ *
+ * Allocates zeroed pages with the pool's gfp mask, which never enters
+ * direct reclaim for high orders, and cleans them out of the CPU caches
+ * so they can go straight to a device. Meant to be called from a low
+ * priority thread; stops early when free memory gets tight.
+ */
+void ion_page_pool_refill(struct ion_page_pool *pool, struct device *dev)
+{
+	LIST_HEAD(batch);
+	int count = ion_page_pool_count(pool);
+
+	while (count < pool->high_mark && ion_page_pool_refill_ok(pool)) {
+		struct page *page = ion_page_pool_alloc_pages(pool);
+
+		if (!page)
+			break;
+		ion_pages_sync_for_device(dev, page, PAGE_SIZE << pool->order,
+					  DMA_BIDIRECTIONAL);
+		mod_node_page_state(page_pgdat(page), NR_ION_HEAP_POOL,
+				    (1 << pool->order));
+		list_add_tail(&page->lru, &batch);
+		count++;
+
+		if (kthread_should_stop())
+			break;
+		cond_resched();
+	}
+
+	if (list_empty(&batch))
+		return;
+
+	mutex_lock(&pool->mutex);
+	ion_page_pool_put_batch(pool, &batch);
+	mutex_unlock(&pool->mutex);
+}
+#endif
+
 int ion_page_pool_shrink(struct ion_page_pool *pool, gfp_t gfp_mask,
 			 int nr_to_scan)
 {
@@ -168,6 +348,8 @@ int ion_page_pool_shrink(struct ion_page_pool *pool, gfp_t gfp_mask,
 	if (nr_to_scan == 0)
 		return ion_page_pool_total(pool, high);
 
+	ion_page_pool_drain_pcp(pool);
+
 	while (freed < nr_to_scan) {
 		struct page *page;
 
@@ -192,9 +374,25 @@ struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order,
 					   bool cached)
 {
 	struct ion_page_pool *pool = kmalloc(sizeof(*pool), GFP_KERNEL);
+	int cpu;
 
 	if (!pool)
 		return NULL;
+	pool->pcp = alloc_percpu(struct ion_page_pool_pcp);
+	if (!pool->pcp) {
+		kfree(pool);
+		return NULL;
+	}
+	for_each_possible_cpu(cpu) {
+		struct ion_page_pool_pcp *pcp = per_cpu_ptr(pool->pcp, cpu);
+
+		spin_lock_init(&pcp->lock);
+		pcp->count = 0;
+		INIT_LIST_HEAD(&pcp->items);
+	}
+	pool->pcp_high = max(ION_PAGE_POOL_PCP_PAGES >> order, 1);
+	pool->low_mark = 0;
+	pool->high_mark = 0;
 	pool->high_count = 0;
 	pool->low_count = 0;
 	INIT_LIST_HEAD(&pool->low_items);
@@ -211,6 +409,7 @@ struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order,
 
 void ion_page_pool_destroy(struct ion_page_pool *pool)
 {
+	free_percpu(pool->pcp);
 	kfree(pool);
 }
 
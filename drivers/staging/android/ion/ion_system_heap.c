@@ -18,12 +18,16 @@
 #include <asm/page.h>
 #include <linux/dma-mapping.h>
 #include <linux/err.h>
+#include <linux/freezer.h>
 #include <linux/highmem.h>
+#include <linux/kthread.h>
 #include <linux/mm.h>
 #include <linux/scatterlist.h>
 #include <linux/seq_file.h>
+#include <linux/sizes.h>
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
+#include <uapi/linux/sched/types.h>
 #include <soc/qcom/secure_buffer.h>
 #include "ion_system_heap.h"
 #include "ion.h"
@@ -84,6 +88,12 @@ static struct page *alloc_buffer_page(struct ion_system_heap *heap,
 	if (IS_ERR(page))
 		return page;
 
+	/*
+	 * Pages fresh from the buddy allocator may still have their zeroing
+	 * in the cache. Clean them whether or not the buffer is cached:
+	 * importers such as camera and video map with DMA_ATTR_SKIP_CPU_SYNC,
+	 * so no later maintenance is guaranteed before a device reads them.
+	 */
 	if ((MAKE_ION_ALLOC_DMA_READY && vmid <= 0) || !(*from_pool))
 		ion_pages_sync_for_device(dev, page, PAGE_SIZE << order,
 					  DMA_BIDIRECTIONAL);
@@ -262,6 +272,107 @@ static void ion_heap_free_pages_mem(struct pages_mem *pages_mem)
 	kvfree(pages_mem->pages);
 }
 
+#ifdef CONFIG_ION_POOL_AUTO_REFILL
+static bool ion_system_heap_needs_refill(struct ion_system_heap *sys_heap)
+{
+	int i;
+
+	for (i = 0; i < NUM_ORDERS; i++) {
+		if (ion_page_pool_needs_refill(sys_heap->uncached_pools[i]) ||
+		    ion_page_pool_needs_refill(sys_heap->cached_pools[i]))
+			return true;
+	}
+	return false;
+}
+
+static void ion_system_heap_kick_refill(struct ion_system_heap *sys_heap)
+{
+	if (!sys_heap->refill_task || READ_ONCE(sys_heap->refill_pending) ||
+	    !ion_system_heap_needs_refill(sys_heap))
+		return;
+
+	WRITE_ONCE(sys_heap->refill_pending, true);
+	wake_up(&sys_heap->refill_wait);
+}
+
+static int ion_system_heap_refill(void *data)
+{
+	struct ion_system_heap *sys_heap = data;
+	int i;
+
+	while (!kthread_should_stop()) {
+		wait_event_freezable(sys_heap->refill_wait,
+				     READ_ONCE(sys_heap->refill_pending) ||
+				     kthread_should_stop());
+		/*
+		 * Clear the request before refilling so that a pass cut short
+		 * by low memory waits for the next allocation to retry.
+		 */
+		WRITE_ONCE(sys_heap->refill_pending, false);
+		for (i = 0; i < NUM_ORDERS; i++) {
+			struct device *dev = sys_heap->heap.priv;
+
+			ion_page_pool_refill(sys_heap->uncached_pools[i], dev);
+			ion_page_pool_refill(sys_heap->cached_pools[i], dev);
+		}
+	}
+
+	return 0;
+}
+
+static void ion_system_heap_set_marks(struct ion_page_pool **pools)
+{
+	unsigned long fill_pages = ((unsigned long)CONFIG_ION_POOL_FILL_MARK *
+				    SZ_1M) >> PAGE_SHIFT;
+	int nr_pools = 0;
+	int i;
+
+	for (i = 0; i < NUM_ORDERS; i++)
+		if (orders[i])
+			nr_pools++;
+	if (!nr_pools)
+		return;
+
+	/* split the fill mark between the uncached and cached pools */
+	fill_pages /= 2 * nr_pools;
+	for (i = 0; i < NUM_ORDERS; i++) {
+		if (!orders[i])
+			continue;
+		pools[i]->high_mark = max(fill_pages >> orders[i], 1UL);
+		pools[i]->low_mark = max(pools[i]->high_mark * 2 / 5, 1);
+	}
+}
+
+static void ion_system_heap_init_refill(struct ion_system_heap *sys_heap)
+{
+	struct sched_param param = { .sched_priority = 0 };
+
+	ion_system_heap_set_marks(sys_heap->uncached_pools);
+	ion_system_heap_set_marks(sys_heap->cached_pools);
+
+	init_waitqueue_head(&sys_heap->refill_wait);
+	sys_heap->refill_task = kthread_run(ion_system_heap_refill, sys_heap,
+					    "ion_pool_refill");
+	if (IS_ERR(sys_heap->refill_task)) {
+		pr_err("%s: creating thread for pool refill failed\n",
+		       __func__);
+		sys_heap->refill_task = NULL;
+		return;
+	}
+	sched_setscheduler(sys_heap->refill_task, SCHED_IDLE, &param);
+}
+#else
+static inline void ion_system_heap_kick_refill(
+		struct ion_system_heap *sys_heap)
+{
+}
+
+static inline void ion_system_heap_init_refill(
+		struct ion_system_heap *sys_heap)
+{
+}
+#endif
+
 static int ion_system_heap_allocate(struct ion_heap *heap,
 				    struct ion_buffer *buffer,
 				    unsigned long size,
@@ -393,6 +504,7 @@ static int ion_system_heap_allocate(struct ion_heap *heap,
 	if (nents_sync)
 		sg_free_table(&table_sync);
 	ion_heap_free_pages_mem(&data);
+	ion_system_heap_kick_refill(sys_heap);
 	return 0;
 
 err_free_sg2:
@@ -528,12 +640,19 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 				   pool->low_count, pool->order,
 				   (1 << pool->order) * PAGE_SIZE *
 					pool->low_count);
+			seq_printf(s,
+				   "%d order %u pages in uncached per-cpu caches = %lu total\n",
+				   ion_page_pool_pcp_count(pool), pool->order,
+				   (1 << pool->order) * PAGE_SIZE *
+					ion_page_pool_pcp_count(pool));
 		}
 
 		uncached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->high_count;
 		uncached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->low_count;
+		uncached_total += (1 << pool->order) * PAGE_SIZE *
+			ion_page_pool_pcp_count(pool);
 	}
 
 	for (i = 0; i < NUM_ORDERS; i++) {
@@ -549,12 +668,19 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 				   pool->low_count, pool->order,
 				   (1 << pool->order) * PAGE_SIZE *
 					pool->low_count);
+			seq_printf(s,
+				   "%d order %u pages in cached per-cpu caches = %lu total\n",
+				   ion_page_pool_pcp_count(pool), pool->order,
+				   (1 << pool->order) * PAGE_SIZE *
+					ion_page_pool_pcp_count(pool));
 		}
 
 		cached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->high_count;
 		cached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->low_count;
+		cached_total += (1 << pool->order) * PAGE_SIZE *
+			ion_page_pool_pcp_count(pool);
 	}
 
 	for (i = 0; i < NUM_ORDERS; i++) {
@@ -667,6 +793,7 @@ struct ion_heap *ion_system_heap_create(struct ion_platform_heap *data)
 		goto destroy_uncached_pools;
 
 	mutex_init(&heap->split_page_mutex);
+	ion_system_heap_init_refill(heap);
 
 	heap->heap.debug_show = ion_system_heap_debug_show;
 	return &heap->heap;
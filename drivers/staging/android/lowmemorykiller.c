@@ -203,7 +203,8 @@ static int lmk_vmpressure_notifier(struct notifier_block *nb,
 
 	if (!enable_adaptive_lmk) {
 #ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_TNG
-		balance_cache(pressure);
+		if (!lmk_psi_active())
+			balance_cache(pressure);
 #endif
 		return 0;
 	}
@@ -249,7 +250,8 @@ static int lmk_vmpressure_notifier(struct notifier_block *nb,
 		atomic_set(&shift_adj, 0);
 	}
 #ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_TNG
-	balance_cache(pressure);
+	if (!lmk_psi_active())
+		balance_cache(pressure);
 #endif
 	return 0;
 }
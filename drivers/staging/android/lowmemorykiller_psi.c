@@ -0,0 +1,90 @@
+/*
+ *  lowmemorykiller_psi
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ */
+
+/* Drive the TNG kill path from memory stall information instead of
+ * vmpressure. A psi trigger on the system group wakes a realtime
+ * thread that kills the first task in the oom_score_adj ordered watch
+ * tree, the tree itself is kept up to date by the oom score notifier
+ * so no task scan is needed on the kill path.
+ */
+
+/* add fake print format with original module name */
+#define pr_fmt(fmt) "lowmemorykiller: " fmt
+
+#include <linux/kernel.h>
+#include <linux/kthread.h>
+#include <linux/moduleparam.h>
+#include <linux/mm.h>
+#include <linux/oom.h>
+#include <linux/psi.h>
+#include <linux/sched.h>
+#include <uapi/linux/sched/types.h>
+
+#include "lowmemorykiller.h"
+#include "lowmemorykiller_tng.h"
+#include "lowmemorykiller_stats.h"
+
+#undef MODULE_PARAM_PREFIX
+#define MODULE_PARAM_PREFIX "lowmemorykiller."
+
+/* same format as /proc/pressure/memory triggers: <some|full> <us> <us> */
+static char psi_trigger[32] = "some 70000 1000000";
+module_param_string(psi_trigger, psi_trigger, sizeof(psi_trigger), 0444);
+
+static struct psi_trigger *lmk_psi_trigger;
+
+bool lmk_psi_active(void)
+{
+	return READ_ONCE(lmk_psi_trigger) != NULL;
+}
+
+static int lmk_psi_thread(void *data)
+{
+	struct psi_trigger *t = data;
+
+	while (!kthread_should_stop()) {
+		if (wait_event_interruptible(t->event_wait,
+					     READ_ONCE(t->event) ||
+					     kthread_should_stop()))
+			continue;
+
+		if (cmpxchg(&t->event, 1, 0) != 1)
+			continue;
+
+		lmk_inc_stats(LMK_PSI_EVENT);
+		lmk_balance_kill(LMK_PSI);
+	}
+	return 0;
+}
+
+int __init lmk_psi_init(void)
+{
+	struct sched_param param = {
+		.sched_priority = MAX_RT_PRIO - 2,
+	};
+	struct psi_trigger *t;
+	struct task_struct *tsk;
+
+	t = psi_system_trigger_create(psi_trigger, strlen(psi_trigger),
+				      PSI_MEM);
+	if (IS_ERR(t)) {
+		pr_err("psi trigger '%s' failed %ld, using vmpressure\n",
+		       psi_trigger, PTR_ERR(t));
+		return PTR_ERR(t);
+	}
+
+	tsk = kthread_run(lmk_psi_thread, t, "lmk_psi");
+	if (IS_ERR(tsk)) {
+		psi_trigger_replace((void **)&t, NULL);
+		return PTR_ERR(tsk);
+	}
+	sched_setscheduler_nocheck(tsk, SCHED_FIFO, &param);
+
+	WRITE_ONCE(lmk_psi_trigger, t);
+	return 0;
+}
@@ -43,6 +43,8 @@ struct lmk_stats {
 	atomic_long_t balance_kill;
 	atomic_long_t balance_waste;
 	atomic_long_t mem_error;
+	atomic_long_t psi_event;
+	atomic_long_t psi_kill;
 
 	atomic_long_t unknown; /* internal */
 } st;
@@ -95,6 +97,12 @@ void lmk_inc_stats(int key)
 	case LMK_MEM_ERROR:
 		atomic_long_inc(&st.mem_error);
 		break;
+	case LMK_PSI_EVENT:
+		atomic_long_inc(&st.psi_event);
+		break;
+	case LMK_PSI_KILL:
+		atomic_long_inc(&st.psi_kill);
+		break;
 	default:
 		atomic_long_inc(&st.unknown);
 		break;
@@ -121,6 +129,10 @@ static int lmk_proc_show(struct seq_file *m, void *v)
 		   atomic_long_read(&st.balance_waste));
 	seq_printf(m, "mem error: %ld\n",
 		   atomic_long_read(&st.mem_error));
+	seq_printf(m, "psi event: %ld\n",
+		   atomic_long_read(&st.psi_event));
+	seq_printf(m, "psi kill: %ld\n",
+		   atomic_long_read(&st.psi_kill));
 	seq_printf(m, "unknown: %ld (internal)\n",
 		   atomic_long_read(&st.unknown));
 
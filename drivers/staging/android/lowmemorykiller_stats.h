@@ -35,6 +35,8 @@ enum  lmk_kill_stats {
 	LMK_BALANCE_WASTE = 14,
 	LMK_MORGUE_COUNT = 15,
 	LMK_MEM_ERROR = 16,
+	LMK_PSI_EVENT = 17,
+	LMK_PSI_KILL = 18,
 };
 
 #define LMK_PROCFS_NAME "lmkstats"
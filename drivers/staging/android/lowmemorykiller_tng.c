@@ -56,6 +56,7 @@ void __init lowmem_init_tng(struct shrinker *shrinker)
 	lowmemorykiller_register_oom_notifier();
 	shrinker->count_objects = lowmem_count_tng;
 	shrinker->scan_objects = lowmem_scan_tng;
+	lmk_psi_init();
 }
 
 ssize_t get_task_rss(struct task_struct *tsk)
@@ -221,6 +222,14 @@ static void calc_params(struct calculated_params *cp, gfp_t mask)
 			break;
 		}
 	}
+	/* A memory stall means we are thrashing even if the minfree
+	 * levels are not reached yet, so allow the lowest priority
+	 * level to be killed.
+	 */
+	if ((cp->kill_reason & LMK_PSI) && cp->min_score_adj == SHRT_MAX &&
+	    array_size > 0)
+		cp->min_score_adj = lowmem_adj[array_size - 1];
+
 	cp->dynamic_max_queue_len = (array_size - i) / 2 + 1;
 
 	/* If there is a lot of reclaimable we dont kill more
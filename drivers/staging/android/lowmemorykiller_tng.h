@@ -24,6 +24,7 @@ extern int oom_reaper;
 #define LMK_SHRINKER_SCAN	(0x2)
 #define LMK_OOM			(0x4)
 #define LMK_SHRINKER_COUNT	(0x8)
+#define LMK_PSI			(0x10)
 /* calc option reason */
 #define LMK_LOW_RESERVE		(0x0100)
 #define LMK_CANT_SWAP		(0x0200)
@@ -37,5 +38,14 @@ void tune_lmk_param(int *other_free, int *other_file,
 void tune_lmk_param_mask(int *other_free, int *other_file, gfp_t mask);
 void __init lowmem_init_tng(struct shrinker *shrinker);
 void balance_cache(unsigned long vmpressure);
+void lmk_balance_kill(int kill_reason);
 void mark_lmk_victim(struct task_struct *tsk);
+
+#ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_PSI
+int __init lmk_psi_init(void);
+bool lmk_psi_active(void);
+#else
+static inline int __init lmk_psi_init(void) { return 0; }
+static inline bool lmk_psi_active(void) { return false; }
+#endif
 #endif
@@ -42,13 +42,6 @@ static unsigned long oldvmp;
 
 void balance_cache(unsigned long vmpressure)
 {
-	struct task_struct *selected = NULL;
-	struct lmk_rb_watch *lrw;
-	int do_kill;
-	struct calculated_params cp;
-	gfp_t mask = ___GFP_KSWAPD_RECLAIM |
-	  ___GFP_DIRECT_RECLAIM | __GFP_FS | __GFP_IO;
-
 	if (vmpressure < 50) {
 		oldvmp = vmpressure;
 		return;
@@ -60,9 +53,25 @@ void balance_cache(unsigned long vmpressure)
 	}
 
 	oldvmp = vmpressure;
+	lmk_balance_kill(LMK_VMPRESSURE);
+}
+
+/* Kill the first task in the watch tree if the current memory state
+ * calls for it. Used by the asynchronous triggers (vmpressure, psi)
+ * that run outside of the shrinker.
+ */
+void lmk_balance_kill(int kill_reason)
+{
+	struct task_struct *selected = NULL;
+	struct lmk_rb_watch *lrw;
+	int do_kill;
+	struct calculated_params cp;
+	gfp_t mask = ___GFP_KSWAPD_RECLAIM |
+	  ___GFP_DIRECT_RECLAIM | __GFP_FS | __GFP_IO;
+
 	cp.selected_tasksize = 0;
 	cp.dynamic_max_queue_len = 1;
-	cp.kill_reason = LMK_VMPRESSURE;
+	cp.kill_reason = kill_reason;
 	spin_lock_bh(&lmk_task_lock);
 
 	lrw = __lmk_task_first();
@@ -142,7 +151,10 @@ void balance_cache(unsigned long vmpressure)
 
 			task_unlock(selected);
 
-			lmk_inc_stats(LMK_BALANCE_KILL);
+			if (kill_reason & LMK_PSI)
+				lmk_inc_stats(LMK_PSI_KILL);
+			else
+				lmk_inc_stats(LMK_BALANCE_KILL);
 			goto out;
 		} else {
 			lowmem_print(3, "No kill");
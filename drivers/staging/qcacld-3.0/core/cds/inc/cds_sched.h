@@ -63,6 +63,7 @@
 ** OL Rx thread.
 */
 #define CDS_MAX_OL_RX_PKT 4000
+#define CDS_OL_RX_PKT_FREE_BATCH 32
 #endif
 
 typedef void (*cds_ol_rx_thread_cb)(void *context,
@@ -753,6 +753,21 @@ void cds_drop_rxpkt_by_staid(p_cds_sched_context pSchedContext, uint16_t staId)
 	}
 }
 
+/**
+ * cds_free_ol_rx_pkt_list() - return a list of cds messages to the freeq
+ * @pSchedContext: Pointer to the global CDS Sched Context
+ * @list: list of already cleared CDS message buffers
+ *
+ * Return: none
+ */
+static void cds_free_ol_rx_pkt_list(p_cds_sched_context pSchedContext,
+				    struct list_head *list)
+{
+	spin_lock_bh(&pSchedContext->cds_ol_rx_pkt_freeq_lock);
+	list_splice_tail_init(list, &pSchedContext->cds_ol_rx_pkt_freeq);
+	spin_unlock_bh(&pSchedContext->cds_ol_rx_pkt_freeq_lock);
+}
+
 /**
  * cds_rx_from_queue() - function to process pending Rx packets
  * @pSchedContext: Pointer to the global CDS Sched Context
@@ -760,12 +775,19 @@ void cds_drop_rxpkt_by_staid(p_cds_sched_context pSchedContext, uint16_t staId)
  * This api traverses the pending buffer list and calling the callback.
  * This callback would essentially send the packet to HDD.
  *
+ * Consumed messages are handed back to the free queue in batches of
+ * CDS_OL_RX_PKT_FREE_BATCH so the free queue lock is not taken once per
+ * packet at high rates. Packets are still dequeued one at a time so
+ * cds_drop_rxpkt_by_staid() keeps seeing everything not yet delivered.
+ *
  * Return: none
  */
 static void cds_rx_from_queue(p_cds_sched_context pSchedContext)
 {
 	struct cds_ol_rx_pkt *pkt;
 	uint16_t sta_id;
+	LIST_HEAD(free_list);
+	int nr_free = 0;
 
 	spin_lock_bh(&pSchedContext->ol_rx_queue_lock);
 	while (!list_empty(&pSchedContext->ol_rx_thread_queue)) {
@@ -775,10 +797,18 @@ static void cds_rx_from_queue(p_cds_sched_context pSchedContext)
 		spin_unlock_bh(&pSchedContext->ol_rx_queue_lock);
 		sta_id = pkt->staId;
 		pkt->callback(pkt->context, pkt->Rxpkt, sta_id);
-		cds_free_ol_rx_pkt(pSchedContext, pkt);
+		memset(pkt, 0, sizeof(*pkt));
+		list_add_tail(&pkt->list, &free_list);
+		if (++nr_free >= CDS_OL_RX_PKT_FREE_BATCH) {
+			cds_free_ol_rx_pkt_list(pSchedContext, &free_list);
+			nr_free = 0;
+		}
 		spin_lock_bh(&pSchedContext->ol_rx_queue_lock);
 	}
 	spin_unlock_bh(&pSchedContext->ol_rx_queue_lock);
+
+	if (nr_free)
+		cds_free_ol_rx_pkt_list(pSchedContext, &free_list);
 }
 
 /**
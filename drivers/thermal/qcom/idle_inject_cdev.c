@@ -0,0 +1,313 @@
+/* Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Idle injection cooling device.
+ *
+ * Instead of capping frequency, each cooling device forces all CPUs of a
+ * cluster into idle for the same window at the same time, so that the
+ * cluster level low power modes can be entered while the CPUs otherwise
+ * keep running at an efficient OPP. The cooling state selects the share of
+ * time spent idle, in IDLE_INJECT_STEP_PCT steps.
+ *
+ * One cooling device is registered per child node:
+ *
+ *	idle-inject-cooling-device {
+ *		compatible = "qcom,idle-inject-cooling-device";
+ *
+ *		gold_idle: gold {
+ *			qcom,cpus = <&CPU4 &CPU5 &CPU6 &CPU7>;
+ *			qcom,idle-duration-ms = <10>;	(optional)
+ *			qcom,max-idle-pct = <50>;	(optional)
+ *			#cooling-cells = <2>;
+ *		};
+ *	};
+ */
+
+#define pr_fmt(fmt) "%s:%s " fmt, KBUILD_MODNAME, __func__
+
+#include <linux/cpu.h>
+#include <linux/cpumask.h>
+#include <linux/err.h>
+#include <linux/hrtimer.h>
+#include <linux/list.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/of.h>
+#include <linux/platform_device.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/smpboot.h>
+#include <linux/thermal.h>
+#include <uapi/linux/sched/types.h>
+
+#define IDLE_INJECT_CDEV_DRIVER		"idle-inject-cooling-device"
+#define IDLE_INJECT_STEP_PCT		5
+#define IDLE_INJECT_DEFAULT_MAX_PCT	50
+#define IDLE_INJECT_DEFAULT_IDLE_MS	10
+
+struct idle_inject_cdev {
+	struct list_head		node;
+	struct device_node		*np;
+	struct thermal_cooling_device	*cool_dev;
+	char				cdev_name[THERMAL_NAME_LENGTH];
+	struct hrtimer			timer;
+	struct mutex			lock;
+	cpumask_t			cpus;
+	unsigned int			idle_ms;
+	unsigned int			run_ms;
+	unsigned long			state;
+	unsigned long			max_state;
+};
+
+struct idle_inject_thread {
+	struct task_struct		*tsk;
+	unsigned int			idle_ms;
+	int				should_run;
+};
+
+static DEFINE_PER_CPU(struct idle_inject_thread, idle_inject_thread);
+
+static int idle_inject_should_run(unsigned int cpu)
+{
+	return READ_ONCE(per_cpu(idle_inject_thread, cpu).should_run);
+}
+
+static void idle_inject_fn(unsigned int cpu)
+{
+	struct idle_inject_thread *t = per_cpu_ptr(&idle_inject_thread, cpu);
+
+	WRITE_ONCE(t->should_run, 0);
+	play_idle(READ_ONCE(t->idle_ms));
+}
+
+static void idle_inject_setup(unsigned int cpu)
+{
+	struct sched_param param = { .sched_priority = MAX_USER_RT_PRIO / 2 };
+
+	/* play_idle() must only ever run from a per-cpu FIFO kthread */
+	sched_setscheduler(current, SCHED_FIFO, &param);
+}
+
+static struct smp_hotplug_thread idle_inject_threads = {
+	.store = &idle_inject_thread.tsk,
+	.thread_should_run = idle_inject_should_run,
+	.thread_fn = idle_inject_fn,
+	.setup = idle_inject_setup,
+	.thread_comm = "idle_inject/%u",
+};
+
+/*
+ * Start of an idle window: kick every online CPU of the cluster at once so
+ * that their idle periods line up, then rearm for the next period.
+ */
+static enum hrtimer_restart idle_inject_timer_fn(struct hrtimer *timer)
+{
+	struct idle_inject_cdev *ii_dev =
+		container_of(timer, struct idle_inject_cdev, timer);
+	unsigned int idle_ms = READ_ONCE(ii_dev->idle_ms);
+	unsigned int run_ms = READ_ONCE(ii_dev->run_ms);
+	int cpu;
+
+	if (!run_ms)
+		return HRTIMER_NORESTART;
+
+	for_each_cpu_and(cpu, &ii_dev->cpus, cpu_online_mask) {
+		struct idle_inject_thread *t =
+			per_cpu_ptr(&idle_inject_thread, cpu);
+
+		WRITE_ONCE(t->idle_ms, idle_ms);
+		WRITE_ONCE(t->should_run, 1);
+		wake_up_process(t->tsk);
+	}
+
+	hrtimer_forward_now(timer, ms_to_ktime(idle_ms + run_ms));
+
+	return HRTIMER_RESTART;
+}
+
+static int idle_inject_get_max_state(struct thermal_cooling_device *cdev,
+				     unsigned long *state)
+{
+	struct idle_inject_cdev *ii_dev = cdev->devdata;
+
+	*state = ii_dev->max_state;
+
+	return 0;
+}
+
+static int idle_inject_get_cur_state(struct thermal_cooling_device *cdev,
+				     unsigned long *state)
+{
+	struct idle_inject_cdev *ii_dev = cdev->devdata;
+
+	*state = ii_dev->state;
+
+	return 0;
+}
+
+static int idle_inject_set_cur_state(struct thermal_cooling_device *cdev,
+				     unsigned long state)
+{
+	struct idle_inject_cdev *ii_dev = cdev->devdata;
+	unsigned int pct;
+
+	if (state > ii_dev->max_state)
+		state = ii_dev->max_state;
+
+	mutex_lock(&ii_dev->lock);
+	if (ii_dev->state == state)
+		goto unlock;
+
+	hrtimer_cancel(&ii_dev->timer);
+	ii_dev->state = state;
+
+	if (!state) {
+		WRITE_ONCE(ii_dev->run_ms, 0);
+		goto unlock;
+	}
+
+	pct = state * IDLE_INJECT_STEP_PCT;
+	WRITE_ONCE(ii_dev->run_ms,
+		   DIV_ROUND_UP(ii_dev->idle_ms * (100 - pct), pct));
+	hrtimer_start(&ii_dev->timer, ms_to_ktime(ii_dev->run_ms),
+		      HRTIMER_MODE_REL);
+unlock:
+	mutex_unlock(&ii_dev->lock);
+
+	return 0;
+}
+
+static struct thermal_cooling_device_ops idle_inject_cdev_ops = {
+	.get_max_state = idle_inject_get_max_state,
+	.get_cur_state = idle_inject_get_cur_state,
+	.set_cur_state = idle_inject_set_cur_state,
+};
+
+static int idle_inject_parse_cpus(struct device *dev, struct device_node *np,
+				  cpumask_t *cpus)
+{
+	struct device_node *cpu_np;
+	int i, cpu, cnt;
+
+	cnt = of_count_phandle_with_args(np, "qcom,cpus", NULL);
+	if (cnt <= 0) {
+		dev_err(dev, "%s: no qcom,cpus\n", np->name);
+		return -EINVAL;
+	}
+
+	cpumask_clear(cpus);
+	for (i = 0; i < cnt; i++) {
+		cpu_np = of_parse_phandle(np, "qcom,cpus", i);
+		cpu = cpu_np ? of_cpu_node_to_id(cpu_np) : -ENODEV;
+		of_node_put(cpu_np);
+		if (cpu < 0) {
+			dev_err(dev, "%s: invalid cpu phandle %d\n",
+				np->name, i);
+			return -EINVAL;
+		}
+		cpumask_set_cpu(cpu, cpus);
+	}
+
+	return 0;
+}
+
+static int idle_inject_cdev_probe(struct platform_device *pdev)
+{
+	struct device_node *np = dev_of_node(&pdev->dev), *child;
+	struct idle_inject_cdev *ii_dev;
+	LIST_HEAD(ii_devs);
+	cpumask_t claimed;
+	u32 val;
+	int ret;
+
+	if (!np) {
+		dev_err(&pdev->dev, "of node not available\n");
+		return -EINVAL;
+	}
+
+	cpumask_clear(&claimed);
+	for_each_available_child_of_node(np, child) {
+		ii_dev = devm_kzalloc(&pdev->dev, sizeof(*ii_dev),
+				      GFP_KERNEL);
+		if (!ii_dev) {
+			of_node_put(child);
+			return -ENOMEM;
+		}
+
+		ret = idle_inject_parse_cpus(&pdev->dev, child, &ii_dev->cpus);
+		if (ret)
+			continue;
+		if (cpumask_intersects(&ii_dev->cpus, &claimed)) {
+			dev_err(&pdev->dev, "%s: cpus already in use\n",
+				child->name);
+			continue;
+		}
+		cpumask_or(&claimed, &claimed, &ii_dev->cpus);
+
+		ii_dev->idle_ms = IDLE_INJECT_DEFAULT_IDLE_MS;
+		if (!of_property_read_u32(child, "qcom,idle-duration-ms", &val)
+		    && val)
+			ii_dev->idle_ms = val;
+
+		val = IDLE_INJECT_DEFAULT_MAX_PCT;
+		of_property_read_u32(child, "qcom,max-idle-pct", &val);
+		ii_dev->max_state = clamp_t(u32, val, IDLE_INJECT_STEP_PCT,
+					    100 - IDLE_INJECT_STEP_PCT) /
+				    IDLE_INJECT_STEP_PCT;
+
+		mutex_init(&ii_dev->lock);
+		hrtimer_init(&ii_dev->timer, CLOCK_MONOTONIC,
+			     HRTIMER_MODE_REL);
+		ii_dev->timer.function = idle_inject_timer_fn;
+		ii_dev->np = of_node_get(child);
+		list_add_tail(&ii_dev->node, &ii_devs);
+	}
+
+	if (cpumask_empty(&claimed))
+		return -ENODEV;
+
+	/* the threads must exist before any cooling device can be set */
+	ret = smpboot_register_percpu_thread_cpumask(&idle_inject_threads,
+						     &claimed);
+	if (ret) {
+		dev_err(&pdev->dev, "idle inject threads err:%d\n", ret);
+		return ret;
+	}
+
+	list_for_each_entry(ii_dev, &ii_devs, node) {
+		snprintf(ii_dev->cdev_name, THERMAL_NAME_LENGTH,
+			 "idle-inject-%s", ii_dev->np->name);
+		ii_dev->cool_dev = thermal_of_cooling_device_register(
+					ii_dev->np, ii_dev->cdev_name, ii_dev,
+					&idle_inject_cdev_ops);
+		if (IS_ERR(ii_dev->cool_dev))
+			dev_err(&pdev->dev, "%s: cdev register err:%ld\n",
+				ii_dev->np->name, PTR_ERR(ii_dev->cool_dev));
+	}
+
+	return 0;
+}
+
+static const struct of_device_id idle_inject_cdev_of_match[] = {
+	{.compatible = "qcom,idle-inject-cooling-device", },
+	{}
+};
+
+static struct platform_driver idle_inject_cdev_driver = {
+	.driver = {
+		.name = IDLE_INJECT_CDEV_DRIVER,
+		.of_match_table = idle_inject_cdev_of_match,
+	},
+	.probe = idle_inject_cdev_probe,
+};
+builtin_platform_driver(idle_inject_cdev_driver);
@@ -22,11 +22,38 @@
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
 
+#include <linux/module.h>
 #include <linux/thermal.h>
 #include <trace/events/thermal.h>
 
 #include "thermal_core.h"
 
+/*
+ * How far ahead, in milliseconds, to extrapolate the zone temperature when
+ * deciding whether to throttle. With a non-zero value mitigation starts
+ * ramping up one step per poll before the trip is crossed, instead of
+ * jumping once it is. 0 keeps the classic behaviour.
+ */
+static unsigned int lookahead_ms;
+module_param(lookahead_ms, uint, 0644);
+
+/*
+ * Linear extrapolation of the zone temperature lookahead_ms from now, based
+ * on the change seen over the last polling interval. Zones that are not
+ * polled have no interval to scale by and are not extrapolated.
+ */
+static int get_predicted_temp(struct thermal_zone_device *tz)
+{
+	int delay = tz->passive ? tz->passive_delay : tz->polling_delay;
+	int delta = tz->temperature - tz->last_temperature;
+	unsigned int ahead = READ_ONCE(lookahead_ms);
+
+	if (!ahead || delay <= 0 || delta <= 0)
+		return tz->temperature;
+
+	return tz->temperature + (int)div_u64((u64)delta * ahead, delay);
+}
+
 /*
  * If the temperature is higher than a trip point,
  *    a. if the trend is THERMAL_TREND_RAISING, use higher cooling
@@ -133,6 +160,7 @@ static void thermal_zone_trip_update(struct thermal_zone_device *tz, int trip)
 	struct thermal_instance *instance;
 	bool throttle = false;
 	int old_target;
+	int predicted;
 
 	if (trip == THERMAL_TRIPS_NONE) {
 		hyst_temp = trip_temp = tz->forced_passive;
@@ -149,6 +177,7 @@ static void thermal_zone_trip_update(struct thermal_zone_device *tz, int trip)
 	}
 
 	trend = get_tz_trend(tz, trip);
+	predicted = get_predicted_temp(tz);
 
 	dev_dbg(&tz->device, "Trip%d[type=%d,temp=%d]:trend=%d,throttle=%d\n",
 				trip, trip_type, trip_temp, trend, throttle);
@@ -168,6 +197,8 @@ static void thermal_zone_trip_update(struct thermal_zone_device *tz, int trip)
 		 * temperature.
 		 */
 		if (tz->temperature >= trip_temp ||
+			(predicted >= trip_temp &&
+			 trend == THERMAL_TREND_RAISING) ||
 			(tz->temperature > hyst_temp &&
 			 old_target != THERMAL_NO_TARGET))
 			throttle = true;
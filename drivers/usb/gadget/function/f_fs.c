@@ -24,6 +24,7 @@
 #include <linux/hid.h>
 #include <linux/module.h>
 #include <linux/sched/signal.h>
+#include <linux/scatterlist.h>
 #include <linux/uio.h>
 #include <asm/unaligned.h>
 
@@ -42,6 +43,16 @@
 
 #define FUNCTIONFS_MAGIC	0xa647361 /* Chosen by a honest dice roll ;) */
 
+/*
+ * Transfers of at least this many bytes pin the caller's pages and hand them
+ * to the UDC as an sg list instead of bouncing through a kernel buffer.
+ * 0 disables it.
+ */
+static unsigned int sg_min_len;
+module_param(sg_min_len, uint, 0644);
+MODULE_PARM_DESC(sg_min_len,
+		 "Minimum transfer size mapped straight from user pages (0 = off)");
+
 /* Reference counter handling */
 static void ffs_data_get(struct ffs_data *ffs);
 static void ffs_data_put(struct ffs_data *ffs);
@@ -225,6 +236,12 @@ struct ffs_io_data {
 	struct usb_request *req;
 
 	struct ffs_data *ffs;
+
+	/* pinned user pages, when the transfer skips the bounce buffer */
+	struct sg_table sgt;
+	struct page **pages;
+	unsigned int nr_pages;
+	unsigned int num_sgs;
 };
 
 struct ffs_desc_helper {
@@ -758,6 +775,83 @@ static ssize_t ffs_copy_to_iter(void *data, int data_len, struct iov_iter *iter)
 	return ret;
 }
 
+static void ffs_io_unpin(struct ffs_io_data *io_data)
+{
+	unsigned int i;
+
+	if (!io_data->pages)
+		return;
+
+	for (i = 0; i < io_data->nr_pages; i++) {
+		if (io_data->read)
+			set_page_dirty_lock(io_data->pages[i]);
+		put_page(io_data->pages[i]);
+	}
+	sg_free_table(&io_data->sgt);
+	kvfree(io_data->pages);
+	io_data->pages = NULL;
+	io_data->nr_pages = 0;
+	io_data->num_sgs = 0;
+}
+
+/*
+ * Pin the user pages behind the first @len bytes of io_data->data and
+ * describe them with an sg table, so the UDC moves the data to or from them
+ * directly.  OUT transfers need every entry but the last to be a whole number
+ * of packets; buffers that don't fit are refused and use the bounce buffer.
+ */
+static int ffs_io_pin(struct ffs_io_data *io_data, size_t len,
+		      unsigned int maxpacket)
+{
+	struct iov_iter iter = io_data->data;
+	struct scatterlist *sg, *last = NULL;
+	int npages = iov_iter_npages(&iter, INT_MAX);
+	size_t done = 0, start, chunk;
+	struct page **pages;
+	ssize_t n;
+	int i, cnt;
+
+	io_data->pages = kvmalloc_array(npages, sizeof(*pages), GFP_KERNEL);
+	if (!io_data->pages)
+		return -ENOMEM;
+	if (sg_alloc_table(&io_data->sgt, npages, GFP_KERNEL)) {
+		kvfree(io_data->pages);
+		io_data->pages = NULL;
+		return -ENOMEM;
+	}
+
+	sg = io_data->sgt.sgl;
+	while (done < len) {
+		pages = io_data->pages + io_data->nr_pages;
+		n = iov_iter_get_pages(&iter, pages, len - done,
+				       npages - io_data->nr_pages, &start);
+		if (n <= 0)
+			goto fail;
+		iov_iter_advance(&iter, n);
+
+		cnt = DIV_ROUND_UP(start + n, PAGE_SIZE);
+		io_data->nr_pages += cnt;
+		for (i = 0; i < cnt; i++) {
+			if (io_data->read && last && last->length % maxpacket)
+				goto fail;
+			chunk = min_t(size_t, n, PAGE_SIZE - start);
+			sg_set_page(sg, pages[i], chunk, start);
+			last = sg;
+			sg = sg_next(sg);
+			io_data->num_sgs++;
+			start = 0;
+			n -= chunk;
+			done += chunk;
+		}
+	}
+	sg_mark_end(last);
+	return 0;
+
+fail:
+	ffs_io_unpin(io_data);
+	return -EINVAL;
+}
+
 static void ffs_user_copy_worker(struct work_struct *work)
 {
 	struct ffs_io_data *io_data = container_of(work, struct ffs_io_data,
@@ -767,7 +861,7 @@ static void ffs_user_copy_worker(struct work_struct *work)
 	bool kiocb_has_eventfd = io_data->kiocb->ki_flags & IOCB_EVENTFD;
 	unsigned long flags;
 
-	if (io_data->read && ret > 0) {
+	if (io_data->read && ret > 0 && !io_data->num_sgs) {
 		mm_segment_t oldfs = get_fs();
 
 		set_fs(USER_DS);
@@ -776,6 +870,7 @@ static void ffs_user_copy_worker(struct work_struct *work)
 		unuse_mm(io_data->mm);
 		set_fs(oldfs);
 	}
+	ffs_io_unpin(io_data);
 
 	io_data->kiocb->ki_complete(io_data->kiocb, ret, ret);
 
@@ -973,16 +1068,25 @@ static ssize_t ffs_epfile_io(struct file *file, struct ffs_io_data *io_data)
 		spin_unlock_irq(&epfile->ffs->eps_lock);
 
 		extra_buf_alloc = epfile->ffs->gadget->extra_buf_alloc;
-		if (!io_data->read)
+		if (sg_min_len && data_len >= sg_min_len &&
+		    gadget->sg_supported && iter_is_iovec(&io_data->data) &&
+		    (io_data->read ?
+		     data_len == iov_iter_count(&io_data->data) :
+		     !extra_buf_alloc) &&
+		    !ffs_io_pin(io_data, data_len, ep->ep->maxpacket)) {
+			/* the request points at the caller's pages */
+			if (!io_data->read)
+				iov_iter_advance(&io_data->data, data_len);
+		} else if (!io_data->read)
 			data = kmalloc(data_len + extra_buf_alloc,
 					GFP_KERNEL);
 		else
 			data = kmalloc(data_len, GFP_KERNEL);
-		if (unlikely(!data)) {
+		if (unlikely(!data && !io_data->num_sgs)) {
 			ret = -ENOMEM;
 			goto error_mutex;
 		}
-		if (!io_data->read &&
+		if (!io_data->read && data &&
 		    !copy_from_iter_full(data, data_len, &io_data->data)) {
 			ret = -EFAULT;
 			goto error_mutex;
@@ -1019,6 +1123,8 @@ static ssize_t ffs_epfile_io(struct file *file, struct ffs_io_data *io_data)
 		req = ep->req;
 		req->buf      = data;
 		req->length   = data_len;
+		req->sg       = io_data->num_sgs ? io_data->sgt.sgl : NULL;
+		req->num_sgs  = io_data->num_sgs;
 
 		req->context  = &done;
 		req->complete = ffs_epfile_io_complete;
@@ -1066,7 +1172,9 @@ static ssize_t ffs_epfile_io(struct file *file, struct ffs_io_data *io_data)
 			ret = ep->status;
 
 		spin_unlock_irq(&epfile->ffs->eps_lock);
-		if (io_data->read && ret > 0)
+		if (io_data->read && ret > 0 && io_data->num_sgs)
+			iov_iter_advance(&io_data->data, ret);
+		else if (io_data->read && ret > 0)
 			ret = __ffs_epfile_read_data(epfile, data, ep->status,
 						     &io_data->data);
 		goto error_mutex;
@@ -1075,6 +1183,8 @@ static ssize_t ffs_epfile_io(struct file *file, struct ffs_io_data *io_data)
 	} else {
 		req->buf      = data;
 		req->length   = data_len;
+		req->sg       = io_data->num_sgs ? io_data->sgt.sgl : NULL;
+		req->num_sgs  = io_data->num_sgs;
 
 		io_data->buf = data;
 		io_data->ep = ep->ep;
@@ -1104,6 +1214,8 @@ static ssize_t ffs_epfile_io(struct file *file, struct ffs_io_data *io_data)
 error_mutex:
 	mutex_unlock(&epfile->mutex);
 error:
+	if (ret != -EIOCBQUEUED)
+		ffs_io_unpin(io_data);
 	kfree(data);
 	return ret;
 }
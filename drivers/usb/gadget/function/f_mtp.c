@@ -32,6 +32,8 @@
 #include <linux/file.h>
 #include <linux/device.h>
 #include <linux/miscdevice.h>
+#include <linux/pagemap.h>
+#include <linux/scatterlist.h>
 
 #include <linux/usb.h>
 #include <linux/usb_usual.h>
@@ -89,6 +91,14 @@ module_param(mtp_tx_req_len, uint, 0644);
 unsigned int mtp_tx_reqs = MTP_TX_REQ_MAX;
 module_param(mtp_tx_reqs, uint, 0644);
 
+/*
+ * Send file data straight from page cache pages with scatter-gather requests
+ * instead of copying it into the request buffers. Only used when the UDC
+ * supports sg and the file can be read through its page cache.
+ */
+bool mtp_tx_zero_copy;
+module_param(mtp_tx_zero_copy, bool, 0644);
+
 static const char mtp_shortname[] = DRIVER_NAME "_usb";
 
 struct mtp_dev {
@@ -369,6 +379,14 @@ struct mtp_data_header {
 	__le32	transaction_id;
 };
 
+/* page cache pages referenced by a zero-copy tx request, in req->context */
+struct mtp_tx_sg {
+	struct scatterlist *sg;
+	struct page **pages;
+	unsigned int max_pages;
+	unsigned int nr_pages;
+};
+
 struct mtp_instance {
 	struct usb_function_instance func_inst;
 	const char *name;
@@ -402,9 +420,31 @@ static struct usb_request *mtp_request_new(struct usb_ep *ep, int buffer_size)
 	return req;
 }
 
+static void mtp_tx_sg_release(struct usb_request *req)
+{
+	struct mtp_tx_sg *tx = req->context;
+
+	if (!tx)
+		return;
+
+	while (tx->nr_pages)
+		put_page(tx->pages[--tx->nr_pages]);
+	req->sg = NULL;
+	req->num_sgs = 0;
+}
+
 static void mtp_request_free(struct usb_request *req, struct usb_ep *ep)
 {
+	struct mtp_tx_sg *tx;
+
 	if (req) {
+		tx = req->context;
+		if (tx) {
+			mtp_tx_sg_release(req);
+			kfree(tx->sg);
+			kfree(tx->pages);
+			kfree(tx);
+		}
 		kfree(req->buf);
 		usb_ep_free_request(ep, req);
 	}
@@ -461,6 +501,7 @@ static void mtp_complete_in(struct usb_ep *ep, struct usb_request *req)
 	if (req->status != 0 && dev->state != STATE_OFFLINE)
 		dev->state = STATE_ERROR;
 
+	mtp_tx_sg_release(req);
 	mtp_req_put(dev, &dev->tx_idle, req);
 
 	wake_up(&dev->write_wq);
@@ -794,6 +835,116 @@ static ssize_t mtp_write(struct file *fp, const char __user *buf,
 }
 
 /* read from a local file and write to USB */
+static bool mtp_tx_can_zero_copy(struct mtp_dev *dev, struct file *filp)
+{
+	struct address_space *mapping = filp->f_mapping;
+
+	return mtp_tx_zero_copy && dev->cdev->gadget->sg_supported &&
+		S_ISREG(file_inode(filp)->i_mode) &&
+		!(filp->f_flags & O_DIRECT) &&
+		mapping && mapping->a_ops->readpage;
+}
+
+static struct mtp_tx_sg *mtp_tx_sg_get(struct usb_request *req)
+{
+	struct mtp_tx_sg *tx = req->context;
+
+	if (tx)
+		return tx;
+
+	tx = kzalloc(sizeof(*tx), GFP_KERNEL);
+	if (!tx)
+		return NULL;
+
+	/* an unaligned file offset spans one extra page */
+	tx->max_pages = DIV_ROUND_UP(mtp_tx_req_len, PAGE_SIZE) + 1;
+	tx->pages = kcalloc(tx->max_pages, sizeof(*tx->pages), GFP_KERNEL);
+	/* plus one entry for the MTP data header */
+	tx->sg = kcalloc(tx->max_pages + 1, sizeof(*tx->sg), GFP_KERNEL);
+	if (!tx->pages || !tx->sg) {
+		kfree(tx->pages);
+		kfree(tx->sg);
+		kfree(tx);
+		return NULL;
+	}
+
+	req->context = tx;
+	return tx;
+}
+
+/*
+ * Point @req at the page cache pages backing @len bytes of @filp at @offset
+ * instead of copying them into req->buf. A header already written to req->buf
+ * goes out as the first sg entry. The pages are held until the request
+ * completes. Returns the number of file bytes covered, which is short at EOF,
+ * or a negative error.
+ */
+static int mtp_tx_sg_fill(struct usb_request *req, struct file *filp,
+		loff_t *offset, int hdr_size, int len)
+{
+	struct address_space *mapping = filp->f_mapping;
+	struct mtp_tx_sg *tx = mtp_tx_sg_get(req);
+	loff_t isize = i_size_read(file_inode(filp));
+	loff_t pos = *offset;
+	pgoff_t index, last;
+	struct page *page;
+	unsigned int off, n;
+	int nents = 0, done = 0;
+
+	if (!tx)
+		return -ENOMEM;
+	if (pos >= isize)
+		return 0;
+
+	len = min_t(loff_t, len, isize - pos);
+	len = min_t(loff_t, len,
+		((loff_t)tx->max_pages << PAGE_SHIFT) - offset_in_page(pos));
+	index = pos >> PAGE_SHIFT;
+	last = (pos + len - 1) >> PAGE_SHIFT;
+
+	sg_init_table(tx->sg, tx->max_pages + 1);
+	if (hdr_size)
+		sg_set_buf(&tx->sg[nents++], req->buf, hdr_size);
+
+	while (done < len) {
+		page = find_get_page(mapping, index);
+		if (!page) {
+			page_cache_sync_readahead(mapping, &filp->f_ra, filp,
+				index, last + 1 - index);
+		} else {
+			if (PageReadahead(page))
+				page_cache_async_readahead(mapping, &filp->f_ra,
+					filp, page, index, last + 1 - index);
+			put_page(page);
+		}
+
+		page = read_mapping_page(mapping, index, filp);
+		if (IS_ERR(page)) {
+			if (!done) {
+				mtp_tx_sg_release(req);
+				return PTR_ERR(page);
+			}
+			break;
+		}
+		mark_page_accessed(page);
+
+		off = offset_in_page(pos);
+		n = min_t(unsigned int, PAGE_SIZE - off, len - done);
+		tx->pages[tx->nr_pages++] = page;
+		sg_set_page(&tx->sg[nents++], page, n, off);
+
+		pos += n;
+		done += n;
+		index++;
+	}
+
+	sg_mark_end(&tx->sg[nents - 1]);
+	req->sg = tx->sg;
+	req->num_sgs = nents;
+	*offset = pos;
+	return done;
+}
+
 static void send_file_work(struct work_struct *data)
 {
 	struct mtp_dev *dev = container_of(data, struct mtp_dev,
@@ -807,6 +958,7 @@ static void send_file_work(struct work_struct *data)
 	int xfer, ret, hdr_size;
 	int r = 0;
 	int sendZLP = 0;
+	bool zero_copy;
 	ktime_t start_time;
 
 	/* read our parameters */
@@ -814,8 +966,10 @@ static void send_file_work(struct work_struct *data)
 	filp = dev->xfer_file;
 	offset = dev->xfer_file_offset;
 	count = dev->xfer_file_length;
+	zero_copy = mtp_tx_can_zero_copy(dev, filp);
 
-	DBG(cdev, "send_file_work(%lld %lld)\n", offset, count);
+	DBG(cdev, "send_file_work(%lld %lld) zero_copy %d\n", offset, count,
+		zero_copy);
 
 	if (dev->xfer_send_header) {
 		hdr_size = sizeof(struct mtp_data_header);
@@ -872,8 +1026,12 @@ static void send_file_work(struct work_struct *data)
 					__cpu_to_le32(dev->xfer_transaction_id);
 		}
 		start_time = ktime_get();
-		ret = vfs_read(filp, req->buf + hdr_size, xfer - hdr_size,
-								&offset);
+		if (zero_copy && xfer > hdr_size)
+			ret = mtp_tx_sg_fill(req, filp, &offset, hdr_size,
+						xfer - hdr_size);
+		else
+			ret = vfs_read(filp, req->buf + hdr_size,
+						xfer - hdr_size, &offset);
 		if (ret < 0) {
 			r = ret;
 			break;
@@ -892,6 +1050,7 @@ static void send_file_work(struct work_struct *data)
 			DBG(cdev, "send_file_work: xfer error %d\n", ret);
 			if (dev->state != STATE_OFFLINE)
 				dev->state = STATE_ERROR;
+			mtp_tx_sg_release(req);
 			r = -EIO;
 			break;
 		}
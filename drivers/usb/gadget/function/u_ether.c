@@ -95,6 +95,8 @@ struct eth_dev {
 
 	struct work_struct	work;
 	struct work_struct	rx_work;
+	struct napi_struct	napi;
+	bool			use_napi;
 
 	unsigned long		todo;
 	unsigned long		flags;
@@ -150,6 +152,15 @@ static inline int qlen(struct usb_gadget *gadget, unsigned qmult)
 static unsigned int u_ether_rx_pending_thld = U_ETHER_RX_PENDING_TSHOLD;
 module_param(u_ether_rx_pending_thld, uint, 0644);
 
+/*
+ * Deliver received frames from a NAPI poll through GRO instead of handing
+ * them one at a time to netif_rx_ni() from the rx workqueue. Takes effect
+ * on the next connect.
+ */
+static bool u_ether_napi;
+module_param(u_ether_napi, bool, 0644);
+MODULE_PARM_DESC(u_ether_napi, "Use NAPI and GRO for received frames");
+
 /* REVISIT there must be a better way than having two sets
  * of debug calls ...
  */
@@ -408,8 +419,12 @@ static void rx_complete(struct usb_ep *ep, struct usb_request *req)
 		req = NULL;
 	}
 
-	if (queue)
-		queue_work(uether_wq, &dev->rx_work);
+	if (queue) {
+		if (dev->use_napi && netif_running(dev->net))
+			napi_schedule(&dev->napi);
+		else
+			queue_work(uether_wq, &dev->rx_work);
+	}
 }
 
 static int prealloc(struct list_head *list, struct usb_ep *ep, unsigned n)
@@ -542,6 +557,29 @@ static __be16 ether_ip_type_trans(struct sk_buff *skb,
 	return protocol;
 }
 
+/* check a received frame and set its protocol, dropping it if malformed */
+static bool eth_rx_frame(struct eth_dev *dev, struct sk_buff *skb, int status)
+{
+	if (status < 0
+			|| ETH_HLEN > skb->len
+			|| skb->len > ETH_FRAME_LEN) {
+		dev->net->stats.rx_errors++;
+		dev->net->stats.rx_length_errors++;
+		DBG(dev, "rx length %d\n", skb->len);
+		dev_kfree_skb_any(skb);
+		return false;
+	}
+
+	if (test_bit(RMNET_MODE_LLP_IP, &dev->flags))
+		skb->protocol = ether_ip_type_trans(skb, dev->net);
+	else
+		skb->protocol = eth_type_trans(skb, dev->net);
+
+	dev->net->stats.rx_packets++;
+	dev->net->stats.rx_bytes += skb->len;
+	return true;
+}
+
 static void process_rx_w(struct work_struct *work)
 {
 	struct eth_dev	*dev = container_of(work, struct eth_dev, rx_work);
@@ -552,29 +590,37 @@ static void process_rx_w(struct work_struct *work)
 		return;
 
 	while ((skb = skb_dequeue(&dev->rx_frames))) {
-		if (status < 0
-				|| ETH_HLEN > skb->len
-				|| skb->len > ETH_FRAME_LEN) {
-			dev->net->stats.rx_errors++;
-			dev->net->stats.rx_length_errors++;
-			DBG(dev, "rx length %d\n", skb->len);
-			dev_kfree_skb_any(skb);
-			continue;
-		}
+		if (eth_rx_frame(dev, skb, status))
+			status = netif_rx_ni(skb);
+	}
 
-		if (test_bit(RMNET_MODE_LLP_IP, &dev->flags))
-			skb->protocol = ether_ip_type_trans(skb, dev->net);
-		else
-			skb->protocol = eth_type_trans(skb, dev->net);
+	if (netif_running(dev->net))
+		rx_fill(dev, GFP_KERNEL);
+}
 
-		dev->net->stats.rx_packets++;
-		dev->net->stats.rx_bytes += skb->len;
+static int eth_napi_poll(struct napi_struct *napi, int budget)
+{
+	struct eth_dev	*dev = container_of(napi, struct eth_dev, napi);
+	struct sk_buff	*skb;
+	int		work_done = 0;
 
-		status = netif_rx_ni(skb);
+	while (work_done < budget &&
+			(skb = skb_dequeue(&dev->rx_frames))) {
+		if (eth_rx_frame(dev, skb, 0))
+			napi_gro_receive(napi, skb);
+		work_done++;
 	}
 
-	if (netif_running(dev->net))
-		rx_fill(dev, GFP_KERNEL);
+	if (work_done < budget) {
+		napi_complete_done(napi, work_done);
+		/* requests parked by rx_complete() throttling */
+		if (netif_running(dev->net))
+			rx_fill(dev, GFP_ATOMIC);
+		if (!skb_queue_empty(&dev->rx_frames))
+			napi_schedule(napi);
+	}
+
+	return work_done;
 }
 
 static void eth_work(struct work_struct *work)
@@ -1035,6 +1081,7 @@ static int eth_open(struct net_device *net)
 	struct gether	*link;
 
 	DBG(dev, "%s\n", __func__);
+	napi_enable(&dev->napi);
 	if (netif_carrier_ok(dev->net))
 		eth_start(dev, GFP_KERNEL);
 
@@ -1054,6 +1101,7 @@ static int eth_stop(struct net_device *net)
 
 	VDBG(dev, "%s\n", __func__);
 	netif_stop_queue(net);
+	napi_disable(&dev->napi);
 
 	DBG(dev, "stop stats: rx/tx %ld/%ld, errs %ld/%ld\n",
 		dev->net->stats.rx_packets, dev->net->stats.tx_packets,
@@ -1342,6 +1390,7 @@ struct eth_dev *gether_setup_name(struct usb_gadget *g,
 	spin_lock_init(&dev->req_lock);
 	INIT_WORK(&dev->work, eth_work);
 	INIT_WORK(&dev->rx_work, process_rx_w);
+	netif_napi_add(net, &dev->napi, eth_napi_poll, NAPI_POLL_WEIGHT);
 	INIT_LIST_HEAD(&dev->tx_reqs);
 	INIT_LIST_HEAD(&dev->rx_reqs);
 
@@ -1417,6 +1466,7 @@ struct net_device *gether_setup_name_default(const char *netname)
 	spin_lock_init(&dev->req_lock);
 	INIT_WORK(&dev->work, eth_work);
 	INIT_WORK(&dev->rx_work, process_rx_w);
+	netif_napi_add(net, &dev->napi, eth_napi_poll, NAPI_POLL_WEIGHT);
 	INIT_LIST_HEAD(&dev->tx_reqs);
 	INIT_LIST_HEAD(&dev->rx_reqs);
 
@@ -1668,6 +1718,7 @@ struct net_device *gether_connect(struct gether *link)
 		DBG(dev, "qlen %d\n", qlen(dev->gadget, dev->qmult));
 
 		dev->header_len = link->header_len;
+		dev->use_napi = u_ether_napi;
 		dev->unwrap = link->unwrap;
 		dev->wrap = link->wrap;
 		dev->ul_max_pkts_per_xfer = link->ul_max_pkts_per_xfer;
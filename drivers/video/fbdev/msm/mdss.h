@@ -439,6 +439,7 @@ struct mdss_data_type {
 	u32 enable_gate;
 	u32 enable_bw_release;
 	u32 enable_rotator_bw_release;
+	u32 cache_bw_check;
 	u32 enable_cdp;
 	u32 serialize_wait4pp;
 	u32 wait4autorefresh;
@@ -1224,6 +1224,9 @@ static int mdss_debugfs_perf_init(struct mdss_debug_data *mdd,
 	debugfs_create_u32("enable_rotator_bw_release", 0644, mdd->perf,
 		(u32 *)&mdata->enable_rotator_bw_release);
 
+	debugfs_create_u32("cache_bw_check", 0644, mdd->perf,
+		(u32 *)&mdata->cache_bw_check);
+
 	debugfs_create_file("ab_factor", 0644, mdd->perf,
 		&mdata->ab_factor, &mdss_factor_fops);
 
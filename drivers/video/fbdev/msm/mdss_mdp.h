@@ -517,6 +517,11 @@ struct mdss_mdp_ctl {
 	int force_screen_state;
 	struct mdss_mdp_perf_params cur_perf;
 	struct mdss_mdp_perf_params new_perf;
+	/* last full perf calculation, reused for an unchanged stack */
+	struct mdss_mdp_perf_params calc_perf;
+	u32 calc_perf_fps;
+	bool calc_perf_valid;
+	bool perf_stack_same;
 	u32 perf_transaction_status;
 	bool perf_release_ctl_bw;
 	u64 bw_pending;
@@ -934,6 +939,20 @@ struct mdss_mdp_writeback_arg {
 
 struct mdss_mdp_wfd;
 
+/* inputs of the last bandwidth check that passed for a layer stack */
+struct mdss_mdp_bw_check_key {
+	u32 pipe_ndx[MDSS_MDP_PIPE_MAX_RECTS];
+	u32 layer_cnt;
+	u32 fps;
+	u32 mode_switch;
+	u32 max_bw_low;
+	u32 max_bw_high;
+	u32 max_bw;
+	u64 other_bw;
+	struct mdp_rect l_roi;
+	struct mdp_rect r_roi;
+};
+
 struct mdss_overlay_private {
 	bool vsync_en;
 	ktime_t vsync_time;
@@ -1000,6 +1019,10 @@ struct mdss_overlay_private {
 	u8 secure_transition_state;
 
 	bool cache_null_commit; /* Cache if preceding commit was NULL */
+
+	struct mdss_mdp_bw_check_key bw_check_key;
+	u64 bw_check_pending;
+	bool bw_check_cached;
 };
 
 struct mdss_mdp_set_ot_params {
@@ -1766,6 +1789,7 @@ int mdss_mdp_ctl_stop(struct mdss_mdp_ctl *ctl, int panel_power_mode);
 int mdss_mdp_ctl_intf_event(struct mdss_mdp_ctl *ctl, int event, void *arg,
 	u32 flags);
 int mdss_mdp_get_prefetch_lines(struct mdss_panel_info *pinfo, bool is_fixed);
+int mdss_mdp_set_threshold_max_bandwidth(struct mdss_mdp_ctl *ctl);
 int mdss_mdp_perf_bw_check(struct mdss_mdp_ctl *ctl,
 		struct mdss_mdp_pipe **left_plist, int left_cnt,
 		struct mdss_mdp_pipe **right_plist, int right_cnt);
@@ -1696,7 +1696,7 @@ static u32 mdss_check_for_flip(struct mdss_mdp_ctl *ctl)
 	return flags;
 }
 
-static int mdss_mdp_set_threshold_max_bandwidth(struct mdss_mdp_ctl *ctl)
+int mdss_mdp_set_threshold_max_bandwidth(struct mdss_mdp_ctl *ctl)
 {
 	u32 mode, threshold = 0, max = INT_MAX;
 	u32 i = 0;
@@ -1905,6 +1905,30 @@ static void mdss_mdp_perf_calc_ctl(struct mdss_mdp_ctl *ctl,
 		 perf->bw_overlap, perf->bw_prefill, perf->prefill_bytes);
 }
 
+/*
+ * Kickoff tells us through perf_stack_same that neither the staged pipes nor
+ * the mixers changed since the last frame. A command mode bandwidth release
+ * still forces perf_update to run, but the numbers would come out the same,
+ * so only the vote is redone and the calculation is reused.
+ */
+static void mdss_mdp_perf_calc_ctl_cached(struct mdss_mdp_ctl *ctl,
+		struct mdss_mdp_perf_params *perf)
+{
+	u32 fps = ctl->panel_data ?
+		mdss_panel_get_framerate(&ctl->panel_data->panel_info) : 0;
+
+	if (ctl->perf_stack_same && ctl->calc_perf_valid &&
+			ctl->calc_perf_fps == fps) {
+		*perf = ctl->calc_perf;
+		return;
+	}
+
+	mdss_mdp_perf_calc_ctl(ctl, perf);
+	ctl->calc_perf = *perf;
+	ctl->calc_perf_fps = fps;
+	ctl->calc_perf_valid = true;
+}
+
 static void set_status(u32 *value, bool status, u32 bit_num)
 {
 	if (status)
@@ -2380,7 +2404,7 @@ static void mdss_mdp_ctl_perf_update(struct mdss_mdp_ctl *ctl,
 			mdata->enable_rotator_bw_release)
 			mdss_mdp_perf_release_ctl_bw(ctl, new);
 		else if (is_bw_released || params_changed)
-			mdss_mdp_perf_calc_ctl(ctl, new);
+			mdss_mdp_perf_calc_ctl_cached(ctl, new);
 
 		if (__mdss_mdp_compare_bw(ctl, new, old, params_changed,
 				stop_req)) {
@@ -2417,6 +2441,7 @@ static void mdss_mdp_ctl_perf_update(struct mdss_mdp_ctl *ctl,
 	} else {
 		memset(old, 0, sizeof(*old));
 		memset(new, 0, sizeof(*new));
+		ctl->calc_perf_valid = false;
 		update_bus = 1;
 		update_clk = 1;
 	}
@@ -5885,6 +5910,11 @@ int mdss_mdp_display_commit(struct mdss_mdp_ctl *ctl, void *arg,
 		ctl->mixer_right->src_split_req =
 			mdata->has_src_split && split_lm_valid;
 
+	ctl->perf_stack_same = mdata->cache_bw_check &&
+		!ctl->force_screen_state &&
+		!ctl->mixer_left->params_changed &&
+		!(ctl->mixer_right && ctl->mixer_right->params_changed);
+
 	if (is_bw_released || ctl->force_screen_state ||
 	    (ctl->mixer_left->params_changed) ||
 	    (ctl->mixer_right && ctl->mixer_right->params_changed)) {
@@ -5902,6 +5932,7 @@ int mdss_mdp_display_commit(struct mdss_mdp_ctl *ctl, void *arg,
 
 		ATRACE_BEGIN("mixer_programming");
 		mdss_mdp_ctl_perf_update(ctl, 1, false);
+		ctl->perf_stack_same = false;
 
 		mdss_mdp_mixer_setup(ctl, MDSS_MDP_MIXER_MUX_LEFT, lm_swap);
 		mdss_mdp_mixer_setup(ctl, MDSS_MDP_MIXER_MUX_RIGHT, lm_swap);
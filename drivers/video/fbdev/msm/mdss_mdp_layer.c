@@ -2418,6 +2418,51 @@ static int __check_source_split(struct mdp_input_layer *layer_list,
 }
 
 
+static void __bw_check_key_get(struct msm_fb_data_type *mfd,
+	struct mdp_layer_commit_v1 *commit, int *rec_ndx,
+	struct mdss_mdp_bw_check_key *key)
+{
+	struct mdss_overlay_private *mdp5_data = mfd_to_mdp5_data(mfd);
+	struct mdss_data_type *mdata = mfd_to_mdata(mfd);
+	struct mdss_mdp_ctl *ctl = mdp5_data->ctl;
+	int i;
+
+	memset(key, 0, sizeof(*key));
+	for (i = 0; i < MDSS_MDP_PIPE_MAX_RECTS; i++)
+		key->pipe_ndx[i] = rec_ndx[i];
+	key->layer_cnt = commit->input_layer_cnt;
+	key->fps = mdss_panel_get_framerate(mfd->panel_info);
+	key->mode_switch = mdss_fb_get_mode_switch(mfd);
+	key->max_bw_low = mdata->max_bw_low;
+	key->max_bw_high = mdata->max_bw_high;
+	key->max_bw = mdss_mdp_set_threshold_max_bandwidth(ctl);
+	key->l_roi = commit->left_roi;
+	key->r_roi = commit->right_roi;
+
+	for (i = 0; i < mdata->nctl; i++) {
+		struct mdss_mdp_ctl *temp = mdata->ctl_off + i;
+
+		if (temp != ctl && temp->power_state == MDSS_PANEL_POWER_ON &&
+				temp->intf_type != MDSS_MDP_NO_INTF)
+			key->other_bw += temp->bw_pending;
+	}
+}
+
+/*
+ * When every layer of a validate request matched a pipe already in the
+ * validate queue, the bandwidth check only has to be redone if one of its
+ * other inputs moved since the last time it passed for this stack.
+ */
+static bool __bw_check_cached(struct msm_fb_data_type *mfd,
+	struct mdss_mdp_bw_check_key *key)
+{
+	struct mdss_overlay_private *mdp5_data = mfd_to_mdp5_data(mfd);
+
+	return mfd_to_mdata(mfd)->cache_bw_check &&
+		mdp5_data->bw_check_cached &&
+		!memcmp(&mdp5_data->bw_check_key, key, sizeof(*key));
+}
+
 /*
  * __validate_layers() - validate input layers
  * @mfd:	Framebuffer data structure for display
@@ -2456,6 +2501,8 @@ static int __validate_layers(struct msm_fb_data_type *mfd,
 	enum mdss_mdp_pipe_rect rect_num;
 	struct mdp_destination_scaler_data *ds_data;
 	struct mdss_mdp_pipe *pipe_list[MAX_LAYER_COUNT] = {0};
+	struct mdss_mdp_bw_check_key bw_key;
+	bool all_reused = true;
 
 	ret = mutex_lock_interruptible(&mdp5_data->ov_lock);
 	if (ret)
@@ -2590,6 +2637,7 @@ static int __validate_layers(struct msm_fb_data_type *mfd,
 			continue;
 		}
 
+		all_reused = false;
 		mixer = mdss_mdp_mixer_get(mdp5_data->ctl, mixer_mux);
 		if (!mixer) {
 			pr_err("unable to get %s mixer\n",
@@ -2707,11 +2755,22 @@ static int __validate_layers(struct msm_fb_data_type *mfd,
 		}
 	}
 
-	ret = mdss_mdp_perf_bw_check(mdp5_data->ctl, left_plist, left_cnt,
-		right_plist, right_cnt);
-	if (ret) {
-		pr_err("bw validation check failed: %d\n", ret);
-		goto validate_exit;
+	__bw_check_key_get(mfd, commit, rec_ndx, &bw_key);
+	if (all_reused && !ds_mode && __bw_check_cached(mfd, &bw_key)) {
+		/* overlay kickoff cleared it, the other interfaces count it */
+		mdp5_data->ctl->bw_pending = mdp5_data->bw_check_pending;
+		pr_debug("layer stack unchanged, bw check skipped\n");
+	} else {
+		mdp5_data->bw_check_cached = false;
+		ret = mdss_mdp_perf_bw_check(mdp5_data->ctl, left_plist,
+			left_cnt, right_plist, right_cnt);
+		if (ret) {
+			pr_err("bw validation check failed: %d\n", ret);
+			goto validate_exit;
+		}
+		mdp5_data->bw_check_key = bw_key;
+		mdp5_data->bw_check_pending = mdp5_data->ctl->bw_pending;
+		mdp5_data->bw_check_cached = true;
 	}
 
 validate_skip:
@@ -40,6 +40,8 @@
 #include <linux/ramfs.h>
 #include <linux/percpu-refcount.h>
 #include <linux/mount.h>
+#include <linux/cred.h>
+#include <linux/sched/mm.h>
 
 #include <asm/kmap_types.h>
 #include <linux/uaccess.h>
@@ -199,6 +201,9 @@ unsigned long aio_max_nr = 0x10000; /* system wide maximum number of aio request
 static struct kmem_cache	*kiocb_cachep;
 static struct kmem_cache	*kioctx_cachep;
 
+/* runs offloaded buffered reads and writes and fsyncs */
+static struct workqueue_struct	*aio_offload_wq;
+
 static struct vfsmount *aio_mnt;
 
 static const struct file_operations aio_ring_fops;
@@ -267,6 +272,10 @@ static int __init aio_setup(void)
 	kiocb_cachep = KMEM_CACHE(aio_kiocb, SLAB_HWCACHE_ALIGN|SLAB_PANIC);
 	kioctx_cachep = KMEM_CACHE(kioctx,SLAB_HWCACHE_ALIGN|SLAB_PANIC);
 
+	aio_offload_wq = alloc_workqueue("aio_offload", WQ_UNBOUND, 0);
+	if (!aio_offload_wq)
+		panic("Failed to create aio offload workqueue.");
+
 	pr_debug("sizeof(struct page) = %zu\n", sizeof(struct page));
 
 	return 0;
@@ -1568,6 +1577,111 @@ static ssize_t aio_write(struct kiocb *req, struct iocb *iocb, bool vectored,
 	return ret;
 }
 
+/*
+ * A request executed by aio_offload_wq in the submitter's mm and with its
+ * credentials. Buffered reads and writes block in ->read_iter/->write_iter,
+ * doing them here lets one io_submit() queue many of them without waiting.
+ */
+struct aio_offload {
+	struct work_struct	work;
+	struct aio_kiocb	*req;
+	struct iocb		iocb;
+	bool			compat;
+	struct mm_struct	*mm;
+	const struct cred	*creds;
+};
+
+static void aio_offload_work(struct work_struct *work)
+{
+	struct aio_offload *ao = container_of(work, struct aio_offload, work);
+	struct kiocb *req = &ao->req->common;
+	struct file *file = req->ki_filp;
+	const struct cred *old_cred;
+	mm_segment_t oldfs;
+	ssize_t ret;
+
+	/* kworkers run at KERNEL_DS, user pointers must still be checked */
+	oldfs = get_fs();
+	set_fs(USER_DS);
+	use_mm(ao->mm);
+	old_cred = override_creds(ao->creds);
+
+	switch (ao->iocb.aio_lio_opcode) {
+	case IOCB_CMD_PREAD:
+		ret = aio_read(req, &ao->iocb, false, ao->compat);
+		break;
+	case IOCB_CMD_PWRITE:
+		ret = aio_write(req, &ao->iocb, false, ao->compat);
+		break;
+	case IOCB_CMD_PREADV:
+		ret = aio_read(req, &ao->iocb, true, ao->compat);
+		break;
+	case IOCB_CMD_PWRITEV:
+		ret = aio_write(req, &ao->iocb, true, ao->compat);
+		break;
+	case IOCB_CMD_FSYNC:
+	case IOCB_CMD_FDSYNC:
+		ret = aio_ret(req, vfs_fsync(file,
+				ao->iocb.aio_lio_opcode == IOCB_CMD_FDSYNC));
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+	/* setup errors can't be returned from io_submit() anymore */
+	if (ret && ret != -EIOCBQUEUED)
+		aio_complete(req, ret, 0);
+
+	revert_creds(old_cred);
+	unuse_mm(ao->mm);
+	set_fs(oldfs);
+
+	put_cred(ao->creds);
+	mmput(ao->mm);
+	fput(file);
+	kfree(ao);
+}
+
+static int aio_offload(struct aio_kiocb *req, struct iocb *iocb, bool compat)
+{
+	struct aio_offload *ao;
+
+	ao = kmalloc(sizeof(*ao), GFP_KERNEL);
+	if (unlikely(!ao))
+		return -ENOMEM;
+
+	INIT_WORK(&ao->work, aio_offload_work);
+	ao->req = req;
+	ao->iocb = *iocb;
+	ao->compat = compat;
+	ao->mm = current->mm;
+	mmget(ao->mm);
+	ao->creds = get_current_cred();
+
+	/* the worker keeps the file until the request is done with it */
+	get_file(req->common.ki_filp);
+	queue_work(aio_offload_wq, &ao->work);
+	return -EIOCBQUEUED;
+}
+
+static bool aio_should_offload(struct aio_kiocb *req, struct iocb *iocb)
+{
+	switch (iocb->aio_lio_opcode) {
+	case IOCB_CMD_FSYNC:
+	case IOCB_CMD_FDSYNC:
+		return true;
+	case IOCB_CMD_PREAD:
+	case IOCB_CMD_PWRITE:
+	case IOCB_CMD_PREADV:
+	case IOCB_CMD_PWRITEV:
+		/* O_DIRECT I/O is already asynchronous */
+		return (iocb->aio_flags & IOCB_FLAG_OFFLOAD) &&
+			!(req->common.ki_flags & IOCB_DIRECT);
+	default:
+		return false;
+	}
+}
+
 static int io_submit_one(struct kioctx *ctx, struct iocb __user *user_iocb,
 			 struct iocb *iocb, bool compat)
 {
@@ -1638,6 +1752,11 @@ static int io_submit_one(struct kioctx *ctx, struct iocb __user *user_iocb,
 	req->ki_user_data = iocb->aio_data;
 
 	get_file(file);
+	if (aio_should_offload(req, iocb)) {
+		ret = aio_offload(req, iocb, compat);
+		goto out_fput;
+	}
+
 	switch (iocb->aio_lio_opcode) {
 	case IOCB_CMD_PREAD:
 		ret = aio_read(&req->common, iocb, false, compat);
@@ -1656,6 +1775,7 @@ static int io_submit_one(struct kioctx *ctx, struct iocb __user *user_iocb,
 		ret = -EINVAL;
 		break;
 	}
+out_fput:
 	fput(file);
 
 	if (ret && ret != -EIOCBQUEUED)
@@ -84,6 +84,12 @@
 int sysctl_vfs_cache_pressure __read_mostly = 100;
 EXPORT_SYMBOL_GPL(sysctl_vfs_cache_pressure);
 
+/*
+ * Per superblock cap on negative dentries, 0 means unlimited. Above it a
+ * negative dentry is freed on its last dput() instead of going to the LRU.
+ */
+unsigned long sysctl_negative_dentry_limit __read_mostly;
+
 __cacheline_aligned_in_smp DEFINE_SEQLOCK(rename_lock);
 
 EXPORT_SYMBOL(rename_lock);
@@ -324,12 +330,27 @@ void release_dentry_name_snapshot(struct name_snapshot *name)
 }
 EXPORT_SYMBOL(release_dentry_name_snapshot);
 
+static inline void d_negative_add(struct dentry *dentry, s64 amount)
+{
+	percpu_counter_add(&dentry->d_sb->s_nr_negative, amount);
+}
+
+static inline bool d_negative_over_limit(struct dentry *dentry)
+{
+	unsigned long limit = READ_ONCE(sysctl_negative_dentry_limit);
+
+	return limit &&
+	       percpu_counter_read_positive(&dentry->d_sb->s_nr_negative) > limit;
+}
+
 static inline void __d_set_inode_and_type(struct dentry *dentry,
 					  struct inode *inode,
 					  unsigned type_flags)
 {
 	unsigned flags;
 
+	if (!dentry->d_inode)
+		d_negative_add(dentry, -1);
 	dentry->d_inode = inode;
 	flags = READ_ONCE(dentry->d_flags);
 	flags &= ~(DCACHE_ENTRY_TYPE | DCACHE_FALLTHRU);
@@ -341,6 +362,9 @@ static inline void __d_clear_type_and_inode(struct dentry *dentry)
 {
 	unsigned flags = READ_ONCE(dentry->d_flags);
 
+	if (dentry->d_inode)
+		d_negative_add(dentry, 1);
+
 	flags &= ~(DCACHE_ENTRY_TYPE | DCACHE_FALLTHRU);
 	WRITE_ONCE(dentry->d_flags, flags);
 	dentry->d_inode = NULL;
@@ -349,6 +373,8 @@ static inline void __d_clear_type_and_inode(struct dentry *dentry)
 static void dentry_free(struct dentry *dentry)
 {
 	WARN_ON(!hlist_unhashed(&dentry->d_u.d_alias));
+	if (!dentry->d_inode)
+		d_negative_add(dentry, -1);
 	if (unlikely(dname_external(dentry))) {
 		struct external_name *p = external_name(dentry);
 		if (likely(atomic_dec_and_test(&p->u.count))) {
@@ -838,6 +864,10 @@ void dput(struct dentry *dentry)
 			goto kill_it;
 	}
 
+	/* don't let failed lookups grow the cache without bound */
+	if (unlikely(d_is_negative(dentry) && d_negative_over_limit(dentry)))
+		goto kill_it;
+
 	dentry_lru_add(dentry);
 
 	dentry->d_lockref.count--;
@@ -1693,6 +1723,7 @@ struct dentry *__d_alloc(struct super_block *sb, const struct qstr *name)
 	}
 
 	this_cpu_inc(nr_dentry);
+	d_negative_add(dentry, 1);
 
 	return dentry;
 }
@@ -1197,6 +1197,72 @@ static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 	}
 }
 
+#ifdef CONFIG_EROFS_FS_PCPU_KTHREAD_SPLIT
+/* pclusters a worker keeps before handing the rest to an idle CPU */
+#define Z_EROFS_SPLIT_PCLUSTERS	4
+
+static struct kthread_worker *z_erofs_idle_worker(void)
+{
+	unsigned int this_cpu = raw_smp_processor_id(), cpu;
+	struct kthread_worker *worker;
+
+	for_each_online_cpu(cpu) {
+		if (cpu == this_cpu || !available_idle_cpu(cpu))
+			continue;
+		worker = rcu_dereference(z_erofs_pcpu_workers[cpu]);
+		if (worker)
+			return worker;
+	}
+	return NULL;
+}
+
+/*
+ * Keep the first Z_EROFS_SPLIT_PCLUSTERS pclusters of @io and queue the
+ * remaining ones to the worker of an idle CPU, which splits them again
+ * when it runs. All pclusters in the chain have been submitted and are
+ * owned by @io, so the chain can be cut without locking.
+ */
+static void z_erofs_split_queue(struct z_erofs_decompressqueue *io)
+{
+	z_erofs_next_pcluster_t owned = io->head;
+	struct z_erofs_decompressqueue *q;
+	struct kthread_worker *worker;
+	struct z_erofs_pcluster *pcl;
+	unsigned int i;
+
+	for (i = 0; i < Z_EROFS_SPLIT_PCLUSTERS; ++i) {
+		if (owned == Z_EROFS_PCLUSTER_TAIL_CLOSED)
+			return;
+		pcl = container_of(owned, struct z_erofs_pcluster, next);
+		owned = READ_ONCE(pcl->next);
+	}
+	if (owned == Z_EROFS_PCLUSTER_TAIL_CLOSED)
+		return;
+
+	q = kvmalloc(sizeof(*q), GFP_NOIO | __GFP_NOWARN);
+	if (!q)
+		return;
+
+	rcu_read_lock();
+	worker = z_erofs_idle_worker();
+	if (worker) {
+		q->sb = io->sb;
+		atomic_set(&q->pending_bios, 0);
+		q->head = owned;
+		kthread_init_work(&q->u.kthread_work,
+				  z_erofs_decompressqueue_kthread_work);
+		WRITE_ONCE(pcl->next, Z_EROFS_PCLUSTER_TAIL_CLOSED);
+		kthread_queue_work(worker, &q->u.kthread_work);
+	}
+	rcu_read_unlock();
+
+	if (!worker)
+		kvfree(q);
+}
+#else
+static inline void z_erofs_split_queue(struct z_erofs_decompressqueue *io) {}
+#endif
+
 static void z_erofs_decompressqueue_work(struct work_struct *work)
 {
 	struct z_erofs_decompressqueue *bgq =
@@ -1204,6 +1270,7 @@ static void z_erofs_decompressqueue_work(struct work_struct *work)
 	LIST_HEAD(pagepool);
 
 	DBG_BUGON(bgq->head == Z_EROFS_PCLUSTER_TAIL_CLOSED);
+	z_erofs_split_queue(bgq);
 	z_erofs_decompress_queue(bgq, &pagepool);
 
 	put_pages_list(&pagepool);
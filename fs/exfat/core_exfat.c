@@ -16,22 +16,6 @@
 #include <asm/byteorder.h>
 #include <asm/unaligned.h>
 
-static u8 free_bit[] = {
-	0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2,/*  0 ~  19*/
-	0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 5, 0, 1, 0, 2, 0, 1, 0, 3,/* 20 ~  39*/
-	0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2,/* 40 ~  59*/
-	0, 1, 0, 6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,/* 60 ~  79*/
-	0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 5, 0, 1, 0, 2,/* 80 ~  99*/
-	0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3,/*100 ~ 119*/
-	0, 1, 0, 2, 0, 1, 0, 7, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2,/*120 ~ 139*/
-	0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 5,/*140 ~ 159*/
-	0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2,/*160 ~ 179*/
-	0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 6, 0, 1, 0, 2, 0, 1, 0, 3,/*180 ~ 199*/
-	0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2,/*200 ~ 219*/
-	0, 1, 0, 5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,/*220 ~ 239*/
-	0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0                /*240 ~ 254*/
-};
-
 static u8 used_bit[] = {
 	0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 1, 2, 2, 3,/*  0 ~  19*/
 	2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5, 1, 2, 2, 3, 2, 3, 3, 4,/* 20 ~  39*/
@@ -1073,20 +1057,31 @@ void exfat_free_alloc_bmp(struct super_block *sb)
 /* WARN :
  * If the value of "clu" is 0, it means cluster 2 which is
  * the first cluster of cluster heap.
+ *
+ * Marks @len clusters from @clu as used, writing each bitmap sector once.
  */
-static s32 set_alloc_bitmap(struct super_block *sb, u32 clu)
+static s32 set_alloc_bitmap_run(struct super_block *sb, u32 clu, u32 len)
 {
-	s32 i, b;
+	u32 i, b, n;
+	u32 bits = (u32)sb->s_blocksize << 3;
 	u64 sector;
 	FS_INFO_T *fsi = &(EXFAT_SB(sb)->fsi);
 
-	i = clu >> (sb->s_blocksize_bits + 3);
-	b = clu & (u32)((sb->s_blocksize << 3) - 1);
+	while (len) {
+		i = clu >> (sb->s_blocksize_bits + 3);
+		b = clu & (bits - 1);
+		n = min(len, bits - b);
 
-	sector = CLUS_TO_SECT(fsi, fsi->map_clu) + i;
-	bitmap_set((unsigned long *)(fsi->vol_amap[i]->b_data), b, 1);
+		sector = CLUS_TO_SECT(fsi, fsi->map_clu) + i;
+		bitmap_set((unsigned long *)(fsi->vol_amap[i]->b_data), b, n);
+		if (exfat_write_sect(sb, sector, fsi->vol_amap[i], 0))
+			return -EIO;
+
+		clu += n;
+		len -= n;
+	}
 
-	return exfat_write_sect(sb, sector, fsi->vol_amap[i], 0);
+	return 0;
 }
 
 /* WARN :
@@ -1133,43 +1128,66 @@ static s32 clr_alloc_bitmap(struct super_block *sb, u32 clu)
  */
 static u32 test_alloc_bitmap(struct super_block *sb, u32 clu)
 {
-	u32 i, map_i, map_b;
-	u32 clu_base, clu_free;
-	u8 k, clu_mask;
+	u32 i, map_i, map_b, end, next;
+	u32 bits = (u32)sb->s_blocksize << 3;
+	u32 total_clus;
 	FS_INFO_T *fsi = &(EXFAT_SB(sb)->fsi);
 
-	clu_base = (clu & ~(0x7)) + 2;
-	clu_mask = (1 << (clu - clu_base + 2)) - 1;
+	total_clus = fsi->num_clusters - CLUS_BASE;
+	if (clu >= total_clus)
+		clu = 0;
 
 	map_i = clu >> (sb->s_blocksize_bits + 3);
-	map_b = (clu >> 3) & (u32)(sb->s_blocksize - 1);
-
-	for (i = 2; i < fsi->num_clusters; i += 8) {
-		k = *(((u8 *) fsi->vol_amap[map_i]->b_data) + map_b);
-		if (clu_mask > 0) {
-			k |= clu_mask;
-			clu_mask = 0;
-		}
-		if (k < 0xFF) {
-			clu_free = clu_base + free_bit[k];
-			if (clu_free < fsi->num_clusters)
-				return clu_free;
-		}
-		clu_base += 8;
+	map_b = clu & (bits - 1);
 
-		if (((++map_b) >= (u32)sb->s_blocksize) ||
-			(clu_base >= fsi->num_clusters)) {
-			if ((++map_i) >= fsi->map_sectors) {
-				clu_base = 2;
-				map_i = 0;
-			}
-			map_b = 0;
-		}
+	/*
+	 * Scan a word at a time up to the end of the cluster heap and wrap
+	 * around. The extra pass revisits the part of the first sector in
+	 * front of @clu.
+	 */
+	for (i = 0; i <= fsi->map_sectors; i++) {
+		end = min(bits, total_clus - (map_i * bits));
+		next = find_next_zero_bit_le(fsi->vol_amap[map_i]->b_data,
+				end, map_b);
+		if (next < end)
+			return map_i * bits + next + CLUS_BASE;
+
+		map_b = 0;
+		if ((++map_i) >= fsi->map_sectors)
+			map_i = 0;
 	}
 
 	return CLUS_EOF;
 }
 
+/* WARN :
+ * If the value of "clu" is 0, it means cluster 2 which is
+ * the first cluster of cluster heap.
+ *
+ * Returns the number of free clusters starting at @clu, at most @max.
+ */
+static u32 count_free_run(struct super_block *sb, u32 clu, u32 max)
+{
+	u32 i, b, end, next, len = 0;
+	u32 bits = (u32)sb->s_blocksize << 3;
+	FS_INFO_T *fsi = &(EXFAT_SB(sb)->fsi);
+
+	max = min(max, fsi->num_clusters - CLUS_BASE - clu);
+
+	while (len < max) {
+		i = (clu + len) >> (sb->s_blocksize_bits + 3);
+		b = (clu + len) & (bits - 1);
+		end = min(bits, b + (max - len));
+
+		next = find_next_bit_le(fsi->vol_amap[i]->b_data, end, b);
+		len += next - b;
+		if (next < end)
+			break;
+	}
+
+	return len;
+}
+
 s32 exfat_chain_cont_cluster(struct super_block *sb, u32 chain, u32 len)
 {
 	if (!len)
@@ -1264,7 +1282,7 @@ static s32 exfat_free_cluster(struct super_block *sb, CHAIN_T *p_chain, s32 do_r
 static s32 exfat_alloc_cluster(struct super_block *sb, u32 num_alloc, CHAIN_T *p_chain, s32 dest)
 {
 	s32 ret = -ENOSPC;
-	u32 num_clusters = 0, total_cnt;
+	u32 num_clusters = 0, total_cnt, run;
 	u32 hint_clu, new_clu, last_clu = CLUS_EOF;
 	FS_INFO_T *fsi = &(EXFAT_SB(sb)->fsi);
 
@@ -1320,17 +1338,24 @@ static s32 exfat_alloc_cluster(struct super_block *sb, u32 num_alloc, CHAIN_T *p
 			p_chain->flags = 0x01;
 		}
 
+		/*
+		 * Claim the whole free run at once, as streaming writers ask
+		 * for many clusters and the bitmap is then updated once per
+		 * sector rather than once per cluster.
+		 */
+		run = count_free_run(sb, new_clu - CLUS_BASE, num_alloc);
+
 		/* update allocation bitmap */
-		if (set_alloc_bitmap(sb, new_clu - CLUS_BASE)) {
+		if (set_alloc_bitmap_run(sb, new_clu - CLUS_BASE, run)) {
 			ret = -EIO;
 			goto error;
 		}
 
-		num_clusters++;
+		num_clusters += run;
 
 		/* update FAT table */
 		if (p_chain->flags == 0x01) {
-			if (exfat_ent_set(sb, new_clu, CLUS_EOF)) {
+			if (exfat_chain_cont_cluster(sb, new_clu, run)) {
 				ret = -EIO;
 				goto error;
 			}
@@ -1344,17 +1369,18 @@ static s32 exfat_alloc_cluster(struct super_block *sb, u32 num_alloc, CHAIN_T *p
 				goto error;
 			}
 		}
-		last_clu = new_clu;
+		last_clu = new_clu + run - 1;
 
-		if ((--num_alloc) == 0) {
-			fsi->clu_srch_ptr = hint_clu;
+		num_alloc -= run;
+		if (num_alloc == 0) {
+			fsi->clu_srch_ptr = last_clu;
 			fsi->used_clusters += num_clusters;
 
 			p_chain->size += num_clusters;
 			return 0;
 		}
 
-		hint_clu = new_clu + 1;
+		hint_clu = last_clu + 1;
 		if (hint_clu >= fsi->num_clusters) {
 			hint_clu = CLUS_BASE;
 
@@ -1637,6 +1637,22 @@ static int exfat_bmap(struct inode *inode, sector_t sector, sector_t *phys,
 
 		*phys = CLUS_TO_SECT(fsi, cluster) + sec_offset;
 		*mapped_blocks = fsi->sect_per_clus - sec_offset;
+
+		/*
+		 * The clusters of a no-fat-chain file are contiguous on disk,
+		 * so map up to i_size in one go and let mpage build large bios
+		 * without a bmap call per cluster.
+		 */
+		if ((EXFAT_I(inode)->fid.flags == 0x03) &&
+			(sector + *mapped_blocks < last_block)) {
+			sector_t ondisk_last;
+
+			ondisk_last = (EXFAT_I(inode)->i_size_ondisk +
+				(blocksize - 1)) >> blocksize_bits;
+			ondisk_last = min(ondisk_last, last_block);
+			if (sector + *mapped_blocks < ondisk_last)
+				*mapped_blocks = ondisk_last - sector;
+		}
 	}
 #if 0
 	else {
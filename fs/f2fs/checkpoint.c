@@ -1115,6 +1115,23 @@ static int block_operations(struct f2fs_sb_info *sbi)
 
 	blk_start_plug(&plug);
 
+	/*
+	 * Write back most of the dirty node pages before freezing the
+	 * filesystem, so that the pass below only has to catch up with what
+	 * got dirtied meanwhile while everyone waits on cp_rwsem.
+	 */
+	if (get_pages(sbi, F2FS_DIRTY_NODES)) {
+		struct writeback_control pre_wbc = {
+			.sync_mode = WB_SYNC_NONE,
+			.nr_to_write = LONG_MAX,
+			.for_reclaim = 0,
+		};
+
+		err = sync_node_pages(sbi, &pre_wbc, false, FS_CP_NODE_IO);
+		if (err)
+			goto out;
+	}
+
 retry_flush_dents:
 	f2fs_lock_all(sbi);
 	/* write all the dirty dentry pages */
@@ -1169,6 +1186,57 @@ static int block_operations(struct f2fs_sb_info *sbi)
 	return err;
 }
 
+struct nat_flush_work {
+	struct work_struct work;
+	struct f2fs_sb_info *sbi;
+	struct cp_control *cpc;
+	int err;
+};
+
+static void nat_flush_workfn(struct work_struct *work)
+{
+	struct nat_flush_work *nfw = container_of(work,
+					struct nat_flush_work, work);
+	struct blk_plug plug;
+
+	blk_start_plug(&plug);
+	nfw->err = flush_nat_entries(nfw->sbi, nfw->cpc);
+	blk_finish_plug(&plug);
+}
+
+/*
+ * NAT entries go to the hot data journal and NAT blocks under nat_tree_lock,
+ * SIT entries to the cold data journal and SIT blocks under sentry_lock, so
+ * the two flushes don't depend on each other and can run side by side.
+ */
+static int flush_nat_sit_entries(struct f2fs_sb_info *sbi,
+						struct cp_control *cpc)
+{
+	struct nat_flush_work nfw;
+	int err;
+
+	if (!sbi->cp_parallel_flush || !NM_I(sbi)->dirty_nat_cnt ||
+					!SIT_I(sbi)->dirty_sentries) {
+		err = flush_nat_entries(sbi, cpc);
+		if (err)
+			return err;
+		flush_sit_entries(sbi, cpc);
+		return 0;
+	}
+
+	INIT_WORK_ONSTACK(&nfw.work, nat_flush_workfn);
+	nfw.sbi = sbi;
+	nfw.cpc = cpc;
+	nfw.err = 0;
+	queue_work(system_unbound_wq, &nfw.work);
+
+	flush_sit_entries(sbi, cpc);
+
+	flush_work(&nfw.work);
+	destroy_work_on_stack(&nfw.work);
+	return nfw.err;
+}
+
 static void unblock_operations(struct f2fs_sb_info *sbi)
 {
 	up_write(&sbi->node_write);
@@ -1499,12 +1567,10 @@ int write_checkpoint(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 	ckpt->checkpoint_ver = cpu_to_le64(++ckpt_ver);
 
 	/* write cached NAT/SIT entries to NAT/SIT area */
-	err = flush_nat_entries(sbi, cpc);
+	err = flush_nat_sit_entries(sbi, cpc);
 	if (err)
 		goto stop;
 
-	flush_sit_entries(sbi, cpc);
-
 	/* unlock all the fs_lock[] in do_checkpoint() */
 	err = do_checkpoint(sbi, cpc);
 	if (err)
@@ -0,0 +1,602 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * fs/f2fs/compress.c: per-cluster file compression for f2fs
+ *
+ * A regular file is compressed in place by F2FS_IOC_COMPRESS_FILE. Each
+ * aligned cluster of F2FS_CLUSTER_PAGES pages which shrinks by at least
+ * one block is rewritten as a COMPRESS_ADDR head followed by the compressed
+ * blocks, see struct f2fs_compress_header. Clusters that do not shrink stay
+ * as they are, so a compressed file freely mixes both kinds. Compressed
+ * files are read-only: reads decompress a whole cluster into the page
+ * cache, and GC moves the compressed blocks raw through META_MAPPING, the
+ * same way it moves encrypted blocks.
+ */
+
+#include <linux/fs.h>
+#include <linux/f2fs_fs.h>
+#include <linux/lz4.h>
+#include <linux/sched/mm.h>
+
+#include "f2fs.h"
+#include "node.h"
+#include "segment.h"
+
+#define CLUSTER_BYTES		(F2FS_CLUSTER_PAGES * PAGE_SIZE)
+#define CBUF_BYTES		((F2FS_CLUSTER_PAGES - 1) * PAGE_SIZE)
+#define NULL_CLUSTER		ULONG_MAX
+
+struct f2fs_decompress_ctx {
+	pgoff_t cluster;		/* cluster described below */
+	bool compressed;		/* cluster is decoded in rbuf */
+	unsigned int nr_pages;		/* # of pages decoded in rbuf */
+	block_t addr[F2FS_CLUSTER_PAGES];	/* addresses of the cluster */
+	void *rbuf;			/* decompressed cluster */
+	void *cbuf;			/* compressed blocks */
+};
+
+static void *f2fs_compress_alloc(size_t size)
+{
+	unsigned int nofs_flag;
+	void *ret;
+
+	/* reads can run under fs reclaim, let vmalloc fall back safely */
+	nofs_flag = memalloc_nofs_save();
+	ret = kvmalloc(size, GFP_KERNEL);
+	memalloc_nofs_restore(nofs_flag);
+	return ret;
+}
+
+static void init_decompress_ctx(struct f2fs_decompress_ctx *dc)
+{
+	memset(dc, 0, sizeof(*dc));
+	dc->cluster = NULL_CLUSTER;
+}
+
+static void release_decompress_ctx(struct f2fs_decompress_ctx *dc)
+{
+	kvfree(dc->rbuf);
+	kvfree(dc->cbuf);
+}
+
+static int f2fs_decompress(struct f2fs_decompress_ctx *dc,
+			unsigned char algorithm, const void *src,
+			size_t clen, size_t rlen)
+{
+	size_t ret;
+
+	switch (algorithm) {
+	case F2FS_COMPRESS_LZ4:
+		ret = LZ4_decompress_safe(src, dc->rbuf, clen, rlen);
+		return ret == rlen ? 0 : -EFSCORRUPTED;
+	}
+	return -EFSCORRUPTED;
+}
+
+/*
+ * Read the compressed blocks of the cluster in @dc and decode them into
+ * dc->rbuf. The caller keeps the dnode locked, so GC can't move the blocks
+ * under us.
+ */
+static int f2fs_decompress_cluster(struct inode *inode,
+					struct f2fs_decompress_ctx *dc)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
+	struct page *cpages[F2FS_CLUSTER_PAGES - 1] = { NULL, };
+	struct f2fs_compress_header *hdr;
+	unsigned int nr_cblocks = 0, i;
+	size_t clen;
+	int err = 0;
+
+	while (nr_cblocks < F2FS_CLUSTER_PAGES - 1 &&
+			__is_valid_data_blkaddr(dc->addr[nr_cblocks + 1]))
+		nr_cblocks++;
+	if (!nr_cblocks)
+		return -EFSCORRUPTED;
+
+	if (!dc->rbuf)
+		dc->rbuf = f2fs_compress_alloc(CLUSTER_BYTES);
+	if (!dc->cbuf)
+		dc->cbuf = f2fs_compress_alloc(CBUF_BYTES);
+	if (!dc->rbuf || !dc->cbuf)
+		return -ENOMEM;
+
+	for (i = 0; i < nr_cblocks; i++) {
+		struct f2fs_io_info fio = {
+			.sbi = sbi,
+			.ino = inode->i_ino,
+			.type = DATA,
+			.op = REQ_OP_READ,
+			.op_flags = 0,
+			.encrypted_page = NULL,
+		};
+		block_t blkaddr = dc->addr[i + 1];
+
+		if (!f2fs_is_valid_blkaddr(sbi, blkaddr, DATA_GENERIC)) {
+			err = -EFSCORRUPTED;
+			goto out;
+		}
+
+		cpages[i] = f2fs_pagecache_get_page(META_MAPPING(sbi), blkaddr,
+					FGP_LOCK | FGP_CREAT, GFP_NOFS);
+		if (!cpages[i]) {
+			err = -ENOMEM;
+			goto out;
+		}
+		if (PageUptodate(cpages[i])) {
+			unlock_page(cpages[i]);
+			continue;
+		}
+
+		fio.page = cpages[i];
+		fio.new_blkaddr = fio.old_blkaddr = blkaddr;
+		err = f2fs_submit_page_bio(&fio);
+		if (err) {
+			f2fs_put_page(cpages[i], 1);
+			cpages[i] = NULL;
+			goto out;
+		}
+	}
+
+	for (i = 0; i < nr_cblocks; i++) {
+		lock_page(cpages[i]);
+		if (unlikely(cpages[i]->mapping != META_MAPPING(sbi) ||
+					!PageUptodate(cpages[i]))) {
+			unlock_page(cpages[i]);
+			err = -EIO;
+			goto out;
+		}
+		memcpy(dc->cbuf + i * PAGE_SIZE, page_address(cpages[i]),
+								PAGE_SIZE);
+		unlock_page(cpages[i]);
+	}
+
+	hdr = dc->cbuf;
+	clen = le32_to_cpu(hdr->clen);
+	if (le32_to_cpu(hdr->magic) != F2FS_COMPRESS_MAGIC ||
+			!hdr->nr_pages ||
+			hdr->nr_pages > F2FS_CLUSTER_PAGES ||
+			clen > nr_cblocks * PAGE_SIZE - sizeof(*hdr) ||
+			f2fs_crc32(sbi, hdr + 1, clen) !=
+						le32_to_cpu(hdr->chksum)) {
+		err = -EFSCORRUPTED;
+		goto out;
+	}
+
+	err = f2fs_decompress(dc, hdr->algorithm, hdr + 1, clen,
+					hdr->nr_pages * PAGE_SIZE);
+	if (!err) {
+		dc->compressed = true;
+		dc->nr_pages = hdr->nr_pages;
+	}
+out:
+	for (i = 0; i < nr_cblocks; i++)
+		if (cpages[i])
+			f2fs_put_page(cpages[i], 0);
+
+	if (err == -EFSCORRUPTED)
+		f2fs_msg(sbi->sb, KERN_WARNING,
+			"%s: corrupted compressed cluster, ino = %lx, "
+			"cluster = %lu", __func__, inode->i_ino, dc->cluster);
+	return err;
+}
+
+/*
+ * Fill @dc with the block addresses of @cluster and, if it is compressed,
+ * with its decompressed contents. Only plain clusters can cross a dnode
+ * boundary, holes in them are looked up page by page.
+ */
+static int f2fs_lookup_cluster(struct inode *inode, pgoff_t cluster,
+					struct f2fs_decompress_ctx *dc)
+{
+	pgoff_t start = cluster << F2FS_LOG_CLUSTER_PAGES;
+	struct dnode_of_data dn;
+	unsigned int i = 0, end;
+	int err;
+
+	dc->cluster = cluster;
+	dc->compressed = false;
+	dc->nr_pages = 0;
+	memset(dc->addr, 0, sizeof(dc->addr));
+
+	while (i < F2FS_CLUSTER_PAGES) {
+		bool head = !i;
+
+		set_new_dnode(&dn, inode, NULL, NULL, 0);
+		err = get_dnode_of_data(&dn, start + i, LOOKUP_NODE);
+		if (err == -ENOENT) {
+			i++;
+			continue;
+		}
+		if (err)
+			goto fail;
+
+		end = ADDRS_PER_PAGE(dn.node_page, inode);
+		for (; i < F2FS_CLUSTER_PAGES && dn.ofs_in_node < end;
+						i++, dn.ofs_in_node++)
+			dc->addr[i] = datablock_addr(dn.inode, dn.node_page,
+							dn.ofs_in_node);
+
+		if (head && dc->addr[0] == COMPRESS_ADDR) {
+			err = f2fs_decompress_cluster(inode, dc);
+			f2fs_put_dnode(&dn);
+			if (err)
+				goto fail;
+			return 0;
+		}
+		f2fs_put_dnode(&dn);
+	}
+	return 0;
+fail:
+	dc->cluster = NULL_CLUSTER;
+	return err;
+}
+
+/*
+ * Read @page of a compressed file. Returns 0 once the page is uptodate and
+ * unlocked, or when a read of a plain block was submitted for it; on error
+ * the page is left locked.
+ */
+int f2fs_read_compressed_page(struct inode *inode, struct page *page,
+				struct f2fs_decompress_ctx *dc)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
+	struct f2fs_decompress_ctx local;
+	pgoff_t cluster = page->index >> F2FS_LOG_CLUSTER_PAGES;
+	unsigned int ofs = page->index & (F2FS_CLUSTER_PAGES - 1);
+	loff_t limit = i_size_read(inode);
+	block_t blkaddr;
+	int err = 0;
+
+	if (!dc) {
+		init_decompress_ctx(&local);
+		dc = &local;
+	}
+
+	if ((loff_t)page->index << PAGE_SHIFT >= limit)
+		goto zero_out;
+
+	if (dc->cluster != cluster) {
+		err = f2fs_lookup_cluster(inode, cluster, dc);
+		if (err)
+			goto out;
+	}
+
+	if (dc->compressed) {
+		void *kaddr;
+
+		if (ofs >= dc->nr_pages)
+			goto zero_out;
+
+		kaddr = kmap_atomic(page);
+		memcpy(kaddr, dc->rbuf + ofs * PAGE_SIZE, PAGE_SIZE);
+		kunmap_atomic(kaddr);
+		flush_dcache_page(page);
+		goto uptodate;
+	}
+
+	blkaddr = dc->addr[ofs];
+	if (!is_valid_data_blkaddr(sbi, blkaddr))
+		goto zero_out;
+
+	if (!f2fs_is_valid_blkaddr(sbi, blkaddr, DATA_GENERIC)) {
+		err = -EFSCORRUPTED;
+		goto out;
+	}
+
+	err = f2fs_submit_page_read(inode, page, blkaddr);
+	goto out;
+
+zero_out:
+	zero_user_segment(page, 0, PAGE_SIZE);
+uptodate:
+	if (!PageUptodate(page))
+		SetPageUptodate(page);
+	unlock_page(page);
+out:
+	if (dc == &local)
+		release_decompress_ctx(&local);
+	return err;
+}
+
+int f2fs_read_compressed_pages(struct address_space *mapping,
+			struct list_head *pages, struct page *page,
+			unsigned nr_pages)
+{
+	struct inode *inode = mapping->host;
+	struct f2fs_decompress_ctx dc;
+
+	init_decompress_ctx(&dc);
+
+	for (; nr_pages; nr_pages--) {
+		if (pages) {
+			page = list_last_entry(pages, struct page, lru);
+
+			prefetchw(&page->flags);
+			list_del(&page->lru);
+			if (add_to_page_cache_lru(page, mapping,
+						  page->index,
+						  readahead_gfp_mask(mapping)))
+				goto next_page;
+		}
+
+		if (f2fs_read_compressed_page(inode, page, &dc)) {
+			SetPageError(page);
+			zero_user_segment(page, 0, PAGE_SIZE);
+			unlock_page(page);
+		}
+next_page:
+		if (pages)
+			put_page(page);
+	}
+	BUG_ON(pages && !list_empty(pages));
+
+	release_decompress_ctx(&dc);
+	return 0;
+}
+
+struct f2fs_compress_ctx {
+	unsigned char algorithm;	/* F2FS_COMPRESS_* */
+	void *rbuf;			/* cluster to compress */
+	void *cbuf;			/* header and compressed bytes */
+	void *workspace;		/* compression context */
+};
+
+static int init_compress_ctx(struct f2fs_compress_ctx *cc,
+					unsigned char algorithm)
+{
+	memset(cc, 0, sizeof(*cc));
+	cc->algorithm = algorithm;
+
+	cc->rbuf = kvmalloc(CLUSTER_BYTES, GFP_KERNEL);
+	cc->cbuf = kvmalloc(CBUF_BYTES, GFP_KERNEL);
+	cc->workspace = kvmalloc(LZ4_MEM_COMPRESS, GFP_KERNEL);
+	if (!cc->rbuf || !cc->cbuf || !cc->workspace)
+		return -ENOMEM;
+	return 0;
+}
+
+static void release_compress_ctx(struct f2fs_compress_ctx *cc)
+{
+	kvfree(cc->rbuf);
+	kvfree(cc->cbuf);
+	kvfree(cc->workspace);
+}
+
+/* returns the # of compressed bytes, or 0 if they don't fit in cbuf */
+static size_t f2fs_compress(struct f2fs_compress_ctx *cc, size_t rlen)
+{
+	void *dst = cc->cbuf + sizeof(struct f2fs_compress_header);
+	size_t cap = CBUF_BYTES - sizeof(struct f2fs_compress_header);
+
+	/* lz4 returns 0 when the output doesn't fit */
+	return LZ4_compress_default(cc->rbuf, dst, rlen, cap, cc->workspace);
+}
+
+/*
+ * Write the compressed blocks of a cluster into freshly allocated blocks.
+ * The dnode is only switched over once all of them are in flight, so a
+ * failure leaves the plain cluster untouched.
+ */
+static int write_compressed_blocks(struct f2fs_compress_ctx *cc,
+			struct dnode_of_data *dn, struct page **pages,
+			unsigned int nr_cblocks, block_t *new)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(dn->inode);
+	struct node_info ni;
+	unsigned int i;
+	int err;
+
+	err = get_node_info(sbi, dn->nid, &ni);
+	if (err)
+		return err;
+
+	for (i = 0; i < nr_cblocks; i++) {
+		struct f2fs_io_info fio = {
+			.sbi = sbi,
+			.ino = dn->inode->i_ino,
+			.type = DATA,
+			.temp = COLD,
+			.op = REQ_OP_WRITE,
+			.op_flags = REQ_SYNC,
+			.page = pages[i + 1],
+			.old_blkaddr = NULL_ADDR,
+			.in_list = false,
+		};
+		struct f2fs_summary sum;
+		struct page *cpage;
+
+		set_summary(&sum, dn->nid, dn->ofs_in_node + i + 1, ni.version);
+		allocate_data_block(sbi, NULL, NULL_ADDR, &new[i], &sum,
+					CURSEG_COLD_DATA, NULL, false);
+
+		cpage = f2fs_grab_cache_page(META_MAPPING(sbi), new[i], true);
+		if (!cpage) {
+			err = -ENOMEM;
+			goto fail;
+		}
+		memcpy(page_address(cpage), cc->cbuf + i * PAGE_SIZE,
+								PAGE_SIZE);
+		SetPageUptodate(cpage);
+
+		set_page_dirty(cpage);
+		f2fs_wait_on_page_writeback(cpage, DATA, true);
+		if (clear_page_dirty_for_io(cpage))
+			dec_page_count(sbi, F2FS_DIRTY_META);
+		set_page_writeback(cpage);
+
+		fio.encrypted_page = cpage;
+		fio.new_blkaddr = new[i];
+		err = f2fs_submit_page_write(&fio);
+		if (err) {
+			if (PageWriteback(cpage))
+				end_page_writeback(cpage);
+			f2fs_put_page(cpage, 1);
+			goto fail;
+		}
+		f2fs_put_page(cpage, 1);
+	}
+	return 0;
+fail:
+	do {
+		invalidate_blocks(sbi, new[i]);
+	} while (i--);
+	return err;
+}
+
+/*
+ * Compress the cluster of @nr_pages pages at @start. Clusters which don't
+ * save a block, have holes or are already compressed are skipped.
+ */
+static int f2fs_compress_cluster(struct f2fs_compress_ctx *cc,
+			struct inode *inode, pgoff_t start,
+			unsigned int nr_pages)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
+	struct page *pages[F2FS_CLUSTER_PAGES] = { NULL, };
+	block_t old[F2FS_CLUSTER_PAGES], new[F2FS_CLUSTER_PAGES - 1];
+	struct f2fs_compress_header *hdr = cc->cbuf;
+	struct dnode_of_data dn;
+	unsigned int nr_cblocks, ofs, i;
+	size_t clen;
+	void *kaddr;
+	int err = 0;
+
+	/* keep the pages locked, GC and readers serialize on them */
+	for (i = 0; i < nr_pages; i++) {
+		pages[i] = get_lock_data_page(inode, start + i, false);
+		if (IS_ERR(pages[i])) {
+			err = PTR_ERR(pages[i]);
+			pages[i] = NULL;
+			if (err == -ENOENT)
+				err = 0;
+			goto out;
+		}
+		kaddr = kmap_atomic(pages[i]);
+		memcpy(cc->rbuf + i * PAGE_SIZE, kaddr, PAGE_SIZE);
+		kunmap_atomic(kaddr);
+	}
+
+	clen = f2fs_compress(cc, nr_pages * PAGE_SIZE);
+	if (!clen)
+		goto out;
+
+	nr_cblocks = DIV_ROUND_UP(sizeof(*hdr) + clen, PAGE_SIZE);
+	if (nr_cblocks >= nr_pages)
+		goto out;
+
+	hdr->magic = cpu_to_le32(F2FS_COMPRESS_MAGIC);
+	hdr->clen = cpu_to_le32(clen);
+	hdr->chksum = cpu_to_le32(f2fs_crc32(sbi, hdr + 1, clen));
+	hdr->algorithm = cc->algorithm;
+	hdr->nr_pages = nr_pages;
+	hdr->reserved = 0;
+	memset(cc->cbuf + sizeof(*hdr) + clen, 0,
+			nr_cblocks * PAGE_SIZE - sizeof(*hdr) - clen);
+
+	f2fs_lock_op(sbi);
+
+	set_new_dnode(&dn, inode, NULL, NULL, 0);
+	err = get_dnode_of_data(&dn, start, LOOKUP_NODE);
+	if (err) {
+		if (err == -ENOENT)
+			err = 0;
+		goto unlock_op;
+	}
+
+	ofs = dn.ofs_in_node;
+	if (ofs + F2FS_CLUSTER_PAGES > ADDRS_PER_PAGE(dn.node_page, inode))
+		goto put_dnode;
+
+	for (i = 0; i < F2FS_CLUSTER_PAGES; i++) {
+		old[i] = datablock_addr(dn.inode, dn.node_page, ofs + i);
+		if (i < nr_pages ? !is_valid_data_blkaddr(sbi, old[i]) :
+							old[i] != NULL_ADDR)
+			goto put_dnode;
+	}
+
+	err = write_compressed_blocks(cc, &dn, pages, nr_cblocks, new);
+	if (err)
+		goto put_dnode;
+
+	dn.data_blkaddr = COMPRESS_ADDR;
+	set_data_blkaddr(&dn);
+	for (i = 1; i < nr_pages; i++) {
+		dn.ofs_in_node = ofs + i;
+		if (i <= nr_cblocks) {
+			f2fs_update_data_blkaddr(&dn, new[i - 1]);
+		} else {
+			dn.data_blkaddr = NULL_ADDR;
+			set_data_blkaddr(&dn);
+		}
+	}
+	dn.ofs_in_node = ofs;
+
+	for (i = 0; i < nr_pages; i++)
+		invalidate_blocks(sbi, old[i]);
+	dec_valid_block_count(sbi, inode, nr_pages - nr_cblocks);
+	set_inode_flag(inode, FI_APPEND_WRITE);
+put_dnode:
+	f2fs_put_dnode(&dn);
+unlock_op:
+	f2fs_unlock_op(sbi);
+	f2fs_balance_fs(sbi, dn.node_changed);
+out:
+	for (i = 0; i < nr_pages; i++)
+		if (pages[i])
+			f2fs_put_page(pages[i], 1);
+	return err;
+}
+
+/* called with inode_lock held and write access denied */
+int f2fs_compress_file(struct inode *inode, unsigned char algorithm)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
+	struct f2fs_compress_ctx cc;
+	pgoff_t nr, idx;
+	int err;
+
+	if (!S_ISREG(inode->i_mode))
+		return -EINVAL;
+
+	if (f2fs_encrypted_file(inode) || fsverity_active(inode))
+		return -EOPNOTSUPP;
+
+	if (f2fs_is_atomic_file(inode) || f2fs_is_volatile_file(inode) ||
+			f2fs_is_pinned_file(inode))
+		return -EBUSY;
+
+	err = f2fs_convert_inline_inode(inode);
+	if (err)
+		return err;
+
+	err = filemap_write_and_wait(inode->i_mapping);
+	if (err)
+		return err;
+
+	err = init_compress_ctx(&cc, algorithm);
+	if (err)
+		goto out;
+
+	if (!f2fs_compressed_file(inode)) {
+		f2fs_drop_extent_tree(inode);
+		F2FS_I(inode)->i_flags |= F2FS_COMPRBLK_FL;
+		f2fs_mark_inode_dirty_sync(inode, true);
+	}
+
+	nr = DIV_ROUND_UP(i_size_read(inode), PAGE_SIZE);
+	for (idx = 0; idx < nr; idx += F2FS_CLUSTER_PAGES) {
+		if (fatal_signal_pending(current)) {
+			err = -EINTR;
+			break;
+		}
+		err = f2fs_compress_cluster(&cc, inode, idx,
+				min_t(pgoff_t, F2FS_CLUSTER_PAGES, nr - idx));
+		if (err)
+			break;
+	}
+
+	f2fs_submit_merged_write(sbi, DATA);
+out:
+	release_compress_ctx(&cc);
+	return err;
+}
@@ -638,7 +638,7 @@ static struct bio *f2fs_grab_read_bio(struct inode *inode, block_t blkaddr,
 }
 
 /* This can handle encryption stuffs */
-static int f2fs_submit_page_read(struct inode *inode, struct page *page,
+int f2fs_submit_page_read(struct inode *inode, struct page *page,
 							block_t blkaddr)
 {
 	struct bio *bio = f2fs_grab_read_bio(inode, blkaddr, 1, page->index);
@@ -791,6 +791,17 @@ struct page *get_read_data_page(struct inode *inode, pgoff_t index,
 	if (!page)
 		return ERR_PTR(-ENOMEM);
 
+	if (f2fs_compressed_file(inode)) {
+		if (PageUptodate(page)) {
+			unlock_page(page);
+			return page;
+		}
+		err = f2fs_read_compressed_page(inode, page, NULL);
+		if (err)
+			goto put_err;
+		return page;
+	}
+
 	if (f2fs_lookup_extent_cache(inode, index, &ei)) {
 		dn.data_blkaddr = ei.blk + index - ei.fofs;
 		goto got_it;
@@ -1236,6 +1247,13 @@ int f2fs_map_blocks(struct inode *inode, struct f2fs_map_blocks *map,
 				start_pgofs, map->m_pblk + ofs,
 				map->m_len - ofs);
 		}
+	} else if (!create && flag == F2FS_GET_BLOCK_DEFAULT) {
+		if (map->m_flags & F2FS_MAP_MAPPED) {
+			unsigned int ofs = start_pgofs - map->m_lblk;
+
+			f2fs_cache_read_extent(&dn, start_pgofs,
+				map->m_pblk + ofs, map->m_len - ofs);
+		}
 	}
 
 	f2fs_put_dnode(&dn);
@@ -1257,6 +1275,13 @@ int f2fs_map_blocks(struct inode *inode, struct f2fs_map_blocks *map,
 		}
 		if (map->m_next_extent)
 			*map->m_next_extent = pgofs + 1;
+	} else if (!create && flag == F2FS_GET_BLOCK_DEFAULT && !err) {
+		if (map->m_flags & F2FS_MAP_MAPPED) {
+			unsigned int ofs = start_pgofs - map->m_lblk;
+
+			f2fs_cache_read_extent(&dn, start_pgofs,
+				map->m_pblk + ofs, map->m_len - ofs);
+		}
 	}
 	f2fs_put_dnode(&dn);
 unlock_out:
@@ -1437,6 +1462,10 @@ int f2fs_fiemap(struct inode *inode, struct fiemap_extent_info *fieinfo,
 	u32 flags = 0;
 	int ret = 0;
 
+	/* compressed clusters have no 1:1 logical to physical mapping */
+	if (f2fs_compressed_file(inode))
+		return -EOPNOTSUPP;
+
 	if (fieinfo->fi_flags & FIEMAP_FLAG_CACHE) {
 		ret = f2fs_precache_extents(inode);
 		if (ret)
@@ -1684,6 +1713,8 @@ static int f2fs_read_data_page(struct file *file, struct page *page)
 	/* If the file has inline data, try to read it directly */
 	if (f2fs_has_inline_data(inode))
 		ret = f2fs_read_inline_data(inode, page);
+	if (ret == -EAGAIN && f2fs_compressed_file(inode))
+		return f2fs_read_compressed_pages(page->mapping, NULL, page, 1);
 	if (ret == -EAGAIN)
 		ret = f2fs_mpage_readpages(page->mapping, NULL, page, 1);
 	return ret;
@@ -1702,6 +1733,10 @@ static int f2fs_read_data_pages(struct file *file,
 	if (f2fs_has_inline_data(inode))
 		return 0;
 
+	if (f2fs_compressed_file(inode))
+		return f2fs_read_compressed_pages(mapping, pages, NULL,
+								nr_pages);
+
 	return f2fs_mpage_readpages(mapping, pages, NULL, nr_pages);
 }
 
@@ -2725,7 +2760,7 @@ static sector_t f2fs_bmap(struct address_space *mapping, sector_t block)
 {
 	struct inode *inode = mapping->host;
 
-	if (f2fs_has_inline_data(inode))
+	if (f2fs_has_inline_data(inode) || f2fs_compressed_file(inode))
 		return 0;
 
 	/* make sure allocating whole blocks */
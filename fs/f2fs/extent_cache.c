@@ -788,6 +788,27 @@ void f2fs_update_extent_cache_range(struct dnode_of_data *dn,
 	f2fs_update_extent_tree_range(dn->inode, fofs, blkaddr, len);
 }
 
+/*
+ * Cache a range a read had to look up in the dnode. Called with the dnode
+ * still held, so a concurrent write to that dnode cannot update the tree
+ * in between and leave a stale block address behind.
+ */
+void f2fs_cache_read_extent(struct dnode_of_data *dn,
+				pgoff_t fofs, block_t blkaddr, unsigned int len)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(dn->inode);
+
+	if (!sbi->read_extent_cache || !f2fs_may_extent_tree(dn->inode))
+		return;
+
+	/* leave the memory to the shrinker once the cache is over budget */
+	if (!available_free_memory(sbi, EXTENT_CACHE))
+		return;
+
+	f2fs_update_extent_tree_range(dn->inode, fofs, blkaddr, len);
+	stat_inc_read_ext_fill(sbi);
+}
+
 void init_extent_cache_info(struct f2fs_sb_info *sbi)
 {
 	INIT_RADIX_TREE(&sbi->extent_tree_root, GFP_NOIO);
@@ -495,6 +495,10 @@ static int f2fs_file_open(struct inode *inode, struct file *filp)
 	if (err)
 		return err;
 
+	/* compressed clusters are never rewritten in place */
+	if (f2fs_compressed_file(inode) && (filp->f_mode & FMODE_WRITE))
+		return -EPERM;
+
 	filp->f_mode |= FMODE_NOWAIT;
 
 	return dquot_file_open(inode, filp);
@@ -522,6 +526,10 @@ void truncate_data_blocks_range(struct dnode_of_data *dn, int count)
 		dn->data_blkaddr = NULL_ADDR;
 		set_data_blkaddr(dn);
 
+		/* a compressed cluster head is not accounted as a block */
+		if (blkaddr == COMPRESS_ADDR)
+			continue;
+
 		if (__is_valid_data_blkaddr(blkaddr) &&
 			!f2fs_is_valid_blkaddr(sbi, blkaddr, DATA_GENERIC))
 			continue;
@@ -785,6 +793,11 @@ int f2fs_setattr(struct dentry *dentry, struct iattr *attr)
 	if (err)
 		return err;
 
+	/* a compressed file can only be emptied */
+	if ((attr->ia_valid & ATTR_SIZE) && attr->ia_size &&
+				f2fs_compressed_file(inode))
+		return -EPERM;
+
 	if (is_quota_modification(inode, attr)) {
 		err = dquot_initialize(inode);
 		if (err)
@@ -807,6 +820,10 @@ int f2fs_setattr(struct dentry *dentry, struct iattr *attr)
 			up_write(&F2FS_I(inode)->i_mmap_sem);
 			if (err)
 				return err;
+			if (!attr->ia_size && f2fs_compressed_file(inode)) {
+				F2FS_I(inode)->i_flags &= ~F2FS_COMPRBLK_FL;
+				f2fs_mark_inode_dirty_sync(inode, true);
+			}
 		} else {
 			/*
 			 * do not trim all blocks after i_size if target size is
@@ -2909,6 +2926,46 @@ static int f2fs_ioc_precache_extents(struct file *filp, unsigned long arg)
 	return f2fs_precache_extents(file_inode(filp));
 }
 
+static int f2fs_ioc_compress_file(struct file *filp, unsigned long arg)
+{
+	struct inode *inode = file_inode(filp);
+	__u32 algorithm;
+	int ret;
+
+	if (!f2fs_sb_has_compression(inode->i_sb))
+		return -EOPNOTSUPP;
+
+	if (!inode_owner_or_capable(inode))
+		return -EACCES;
+
+	if (get_user(algorithm, (__u32 __user *)arg))
+		return -EFAULT;
+
+	if (algorithm >= F2FS_COMPRESS_MAX)
+		return -EINVAL;
+
+	/* no writer may exist or show up until the clusters are rewritten */
+	ret = deny_write_access(filp);
+	if (ret)
+		return ret;
+
+	ret = mnt_want_write_file(filp);
+	if (ret)
+		goto out;
+
+	inode_lock(inode);
+	ret = f2fs_compress_file(inode, algorithm);
+	inode_unlock(inode);
+
+	if (!ret)
+		ret = f2fs_sync_fs(inode->i_sb, 1);
+
+	mnt_drop_write_file(filp);
+out:
+	allow_write_access(filp);
+	return ret;
+}
+
 static int f2fs_ioc_enable_verity(struct file *filp, unsigned long arg)
 {
 	struct inode *inode = file_inode(filp);
@@ -3006,6 +3063,8 @@ long f2fs_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 		return f2fs_ioc_set_pin_file(filp, arg);
 	case F2FS_IOC_PRECACHE_EXTENTS:
 		return f2fs_ioc_precache_extents(filp, arg);
+	case F2FS_IOC_COMPRESS_FILE:
+		return f2fs_ioc_compress_file(filp, arg);
 	case FS_IOC_ENABLE_VERITY:
 		return f2fs_ioc_enable_verity(filp, arg);
 	case FS_IOC_MEASURE_VERITY:
@@ -3122,6 +3181,7 @@ long f2fs_compat_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	case F2FS_IOC_GET_PIN_FILE:
 	case F2FS_IOC_SET_PIN_FILE:
 	case F2FS_IOC_PRECACHE_EXTENTS:
+	case F2FS_IOC_COMPRESS_FILE:
 	case FS_IOC_ENABLE_VERITY:
 	case FS_IOC_MEASURE_VERITY:
 		break;
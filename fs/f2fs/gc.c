@@ -86,7 +86,16 @@ static int gc_thread_func(void *data)
 			goto next;
 
 		if (!is_idle(sbi)) {
-			increase_sleep_time(gc_th, &wait_ms);
+			/*
+			 * Come back when the idle interval since the last
+			 * request runs out instead of backing off blindly.
+			 */
+			if (sbi->gc_idle_predict)
+				wait_ms = clamp(f2fs_time_to_wait(sbi, REQ_TIME),
+						gc_th->urgent_sleep_time,
+						gc_th->max_sleep_time);
+			else
+				increase_sleep_time(gc_th, &wait_ms);
 			mutex_unlock(&sbi->gc_mutex);
 			goto next;
 		}
@@ -301,6 +310,53 @@ static unsigned int count_bits(const unsigned long *addr,
 	return sum;
 }
 
+/*
+ * Walk the victim index from the bucket with the fewest valid blocks up.
+ * Greedy selection is done once a bucket gave a candidate, since every
+ * later bucket holds fuller sections; cost-benefit keeps going until
+ * max_search candidates were costed, which now are the emptiest ones
+ * rather than whatever follows last_victim in the segmap.
+ */
+static void get_victim_from_index(struct f2fs_sb_info *sbi,
+			struct victim_sel_policy *p, int gc_type)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned int nsearched = 0;
+	int i;
+
+	for (i = 0; i < NR_VICTIM_BUCKETS; i++) {
+		unsigned int segno;
+
+		if (!dirty_i->nr_bucket[i])
+			continue;
+
+		for_each_set_bit(segno, dirty_i->victim_bucket[i],
+							MAIN_SEGS(sbi)) {
+			unsigned int secno = GET_SEC_FROM_SEG(sbi, segno);
+			unsigned long cost;
+
+			if (sec_usage_check(sbi, secno))
+				continue;
+			if (gc_type == BG_GC &&
+					test_bit(secno, dirty_i->victim_secmap))
+				continue;
+			if (gc_type == FG_GC && no_fggc_candidate(sbi, secno))
+				continue;
+
+			cost = get_gc_cost(sbi, segno, p);
+			if (p->min_cost > cost) {
+				p->min_segno = segno;
+				p->min_cost = cost;
+			}
+			if (++nsearched >= p->max_search)
+				return;
+		}
+
+		if (p->gc_mode == GC_GREEDY && p->min_segno != NULL_SEGNO)
+			return;
+	}
+}
+
 /*
  * This function is called from two paths.
  * One is garbage collection and the other is SSR segment selection.
@@ -344,6 +400,11 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 			goto got_it;
 	}
 
+	if (p.alloc_mode == LFS && sbi->gc_victim_index) {
+		get_victim_from_index(sbi, &p, gc_type);
+		goto got_victim;
+	}
+
 	while (1) {
 		unsigned long cost;
 		unsigned int segno;
@@ -396,6 +457,7 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 			break;
 		}
 	}
+got_victim:
 	if (p.min_segno != NULL_SEGNO) {
 got_it:
 		if (p.alloc_mode == LFS) {
@@ -531,6 +531,14 @@ static int do_recover_data(struct f2fs_sb_info *sbi, struct inode *inode,
 			continue;
 		}
 
+		/* dest is a compressed cluster head, it owns no block */
+		if (dest == COMPRESS_ADDR) {
+			truncate_data_blocks_range(&dn, 1);
+			dn.data_blkaddr = COMPRESS_ADDR;
+			set_data_blkaddr(&dn);
+			continue;
+		}
+
 		if (!file_keep_isize(inode) &&
 			(i_size_read(inode) <= ((loff_t)start << PAGE_SHIFT)))
 			f2fs_i_size_write(inode,
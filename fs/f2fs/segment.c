@@ -744,6 +744,37 @@ int f2fs_flush_device_cache(struct f2fs_sb_info *sbi)
 	return ret;
 }
 
+/*
+ * Keep the GC victim index in step with the dirty segmap. The bucket of a
+ * dirty segment is refreshed each time it is located again, which happens
+ * whenever one of its blocks is invalidated.
+ */
+static void __update_victim_bucket(struct f2fs_sb_info *sbi,
+					unsigned int segno, bool dirty)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned char old, new = NULL_VICTIM_BUCKET;
+
+	if (!dirty_i->seg_bucket)
+		return;
+
+	old = dirty_i->seg_bucket[segno];
+	if (dirty)
+		new = VICTIM_BUCKET(sbi, get_valid_blocks(sbi, segno, true));
+	if (old == new)
+		return;
+
+	if (old != NULL_VICTIM_BUCKET) {
+		clear_bit(segno, dirty_i->victim_bucket[old]);
+		dirty_i->nr_bucket[old]--;
+	}
+	if (new != NULL_VICTIM_BUCKET) {
+		set_bit(segno, dirty_i->victim_bucket[new]);
+		dirty_i->nr_bucket[new]++;
+	}
+	dirty_i->seg_bucket[segno] = new;
+}
+
 static void __locate_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 		enum dirty_type dirty_type)
 {
@@ -766,6 +797,8 @@ static void __locate_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 		}
 		if (!test_and_set_bit(segno, dirty_i->dirty_segmap[t]))
 			dirty_i->nr_dirty[t]++;
+
+		__update_victim_bucket(sbi, segno, true);
 	}
 }
 
@@ -784,6 +817,8 @@ static void __remove_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 		if (test_and_clear_bit(segno, dirty_i->dirty_segmap[t]))
 			dirty_i->nr_dirty[t]--;
 
+		__update_victim_bucket(sbi, segno, false);
+
 		if (get_valid_blocks(sbi, segno, true) == 0)
 			clear_bit(GET_SEC_FROM_SEG(sbi, segno),
 						dirty_i->victim_secmap);
@@ -3857,6 +3892,26 @@ static int init_victim_secmap(struct f2fs_sb_info *sbi)
 	return 0;
 }
 
+static int init_victim_index(struct f2fs_sb_info *sbi)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned int bitmap_size = f2fs_bitmap_size(MAIN_SEGS(sbi));
+	int i;
+
+	for (i = 0; i < NR_VICTIM_BUCKETS; i++) {
+		dirty_i->victim_bucket[i] = f2fs_kvzalloc(sbi, bitmap_size,
+								GFP_KERNEL);
+		if (!dirty_i->victim_bucket[i])
+			return -ENOMEM;
+	}
+
+	dirty_i->seg_bucket = f2fs_kvmalloc(sbi, MAIN_SEGS(sbi), GFP_KERNEL);
+	if (!dirty_i->seg_bucket)
+		return -ENOMEM;
+	memset(dirty_i->seg_bucket, NULL_VICTIM_BUCKET, MAIN_SEGS(sbi));
+	return 0;
+}
+
 static int build_dirty_segmap(struct f2fs_sb_info *sbi)
 {
 	struct dirty_seglist_info *dirty_i;
@@ -3880,6 +3935,9 @@ static int build_dirty_segmap(struct f2fs_sb_info *sbi)
 			return -ENOMEM;
 	}
 
+	if (init_victim_index(sbi))
+		return -ENOMEM;
+
 	init_dirty_segmap(sbi);
 	return init_victim_secmap(sbi);
 }
@@ -4039,6 +4097,16 @@ static void destroy_victim_secmap(struct f2fs_sb_info *sbi)
 	kvfree(dirty_i->victim_secmap);
 }
 
+static void destroy_victim_index(struct f2fs_sb_info *sbi)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	int i;
+
+	for (i = 0; i < NR_VICTIM_BUCKETS; i++)
+		kvfree(dirty_i->victim_bucket[i]);
+	kvfree(dirty_i->seg_bucket);
+}
+
 static void destroy_dirty_segmap(struct f2fs_sb_info *sbi)
 {
 	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
@@ -4052,6 +4120,7 @@ static void destroy_dirty_segmap(struct f2fs_sb_info *sbi)
 		discard_dirty_segmap(sbi, i);
 
 	destroy_victim_secmap(sbi);
+	destroy_victim_index(sbi);
 	SM_I(sbi)->dirty_info = NULL;
 	kfree(dirty_i);
 }
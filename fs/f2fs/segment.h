@@ -90,6 +90,9 @@
 		GET_SEGNO_FROM_SEG0(sbi, blk_addr)))
 #define BLKS_PER_SEC(sbi)					\
 	((sbi)->segs_per_sec * (sbi)->blocks_per_seg)
+#define VICTIM_BUCKET(sbi, vblocks)				\
+	min_t(unsigned int, (u64)(vblocks) * NR_VICTIM_BUCKETS /	\
+		BLKS_PER_SEC(sbi), NR_VICTIM_BUCKETS - 1)
 #define GET_SEC_FROM_SEG(sbi, segno)				\
 	(((segno) == -1) ? -1: (segno) / (sbi)->segs_per_sec)
 #define GET_SEG_FROM_SEC(sbi, secno)				\
@@ -274,12 +277,19 @@ enum dirty_type {
 	NR_DIRTY_TYPE
 };
 
+#define NR_VICTIM_BUCKETS	32
+#define NULL_VICTIM_BUCKET	0xff
+
 struct dirty_seglist_info {
 	const struct victim_selection *v_ops;	/* victim selction operation */
 	unsigned long *dirty_segmap[NR_DIRTY_TYPE];
 	struct mutex seglist_lock;		/* lock for segment bitmaps */
 	int nr_dirty[NR_DIRTY_TYPE];		/* # of dirty segments */
 	unsigned long *victim_secmap;		/* background GC victims */
+	/* dirty segments bucketed by valid blocks of their section */
+	unsigned long *victim_bucket[NR_VICTIM_BUCKETS];
+	unsigned int nr_bucket[NR_VICTIM_BUCKETS];
+	unsigned char *seg_bucket;		/* bucket of each segment */
 };
 
 /* victim selection function for cleaning and SSR */
@@ -1072,8 +1072,6 @@ static void f2fs_put_super(struct super_block *sb)
 	kfree(sbi->ckpt);
 
 	sb->s_fs_info = NULL;
-	if (sbi->s_chksum_driver)
-		crypto_free_shash(sbi->s_chksum_driver);
 	kfree(sbi->raw_super);
 
 	destroy_device_list(sbi);
@@ -2834,15 +2832,6 @@ static int f2fs_fill_super(struct super_block *sb, void *data, int silent)
 
 	sbi->sb = sb;
 
-	/* Load the checksum driver */
-	sbi->s_chksum_driver = crypto_alloc_shash("crc32", 0, 0);
-	if (IS_ERR(sbi->s_chksum_driver)) {
-		f2fs_msg(sb, KERN_ERR, "Cannot load crc32 driver.");
-		err = PTR_ERR(sbi->s_chksum_driver);
-		sbi->s_chksum_driver = NULL;
-		goto free_sbi;
-	}
-
 	/* set a block size */
 	if (unlikely(!sb_set_blocksize(sb, F2FS_BLKSIZE))) {
 		f2fs_msg(sb, KERN_ERR, "unable to set blocksize");
@@ -2877,6 +2866,14 @@ static int f2fs_fill_super(struct super_block *sb, void *data, int silent)
 		err = -EOPNOTSUPP;
 		goto free_sb_buf;
 	}
+#endif
+#ifndef CONFIG_F2FS_FS_COMPRESSION
+	if (f2fs_sb_has_compression(sb)) {
+		f2fs_msg(sb, KERN_ERR,
+			 "Compression support is not enabled\n");
+		err = -EOPNOTSUPP;
+		goto free_sb_buf;
+	}
 #endif
 	default_options(sbi);
 	/* parse mount options */
@@ -3228,8 +3225,6 @@ static int f2fs_fill_super(struct super_block *sb, void *data, int silent)
 free_sb_buf:
 	kfree(raw_super);
 free_sbi:
-	if (sbi->s_chksum_driver)
-		crypto_free_shash(sbi->s_chksum_driver);
 	kfree(sbi);
 
 	/* give only one another chance */
@@ -126,7 +126,8 @@ static int f2fs_begin_enable_verity(struct file *filp)
 	if (f2fs_verity_in_progress(inode))
 		return -EBUSY;
 
-	if (f2fs_is_atomic_file(inode) || f2fs_is_volatile_file(inode))
+	if (f2fs_is_atomic_file(inode) || f2fs_is_volatile_file(inode) ||
+			f2fs_compressed_file(inode))
 		return -EOPNOTSUPP;
 
 	/*
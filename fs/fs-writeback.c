@@ -83,6 +83,15 @@ struct wb_writeback_work {
  */
 unsigned int dirtytime_expire_interval = 12 * 60 * 60;
 
+/*
+ * Number of inodes a flusher writes back at the same time for
+ * WB_SYNC_NONE writeback. 0 or 1 keeps the classic one inode at a time
+ * behaviour.
+ */
+int dirty_writeback_inodes;
+
+static struct workqueue_struct *wb_inodes_wq;
+
 static inline struct inode *wb_inode(struct list_head *head)
 {
 	return list_entry(head, struct inode, i_io_list);
@@ -1540,6 +1549,144 @@ static long writeback_chunk_size(struct bdi_writeback *wb,
 	return pages;
 }
 
+struct writeback_inode_work {
+	struct work_struct	work;
+	struct inode		*inode;
+	struct writeback_control wbc;
+	long			write_chunk;
+};
+
+static void writeback_inode_workfn(struct work_struct *work)
+{
+	struct writeback_inode_work *iw =
+		container_of(work, struct writeback_inode_work, work);
+	struct blk_plug plug;
+
+	blk_start_plug(&plug);
+	__writeback_single_inode(iw->inode, &iw->wbc);
+	blk_finish_plug(&plug);
+}
+
+/*
+ * Parallel variant of writeback_sb_inodes() for WB_SYNC_NONE writeback.
+ *
+ * Up to @max_inodes inodes are taken off b_io at a time, marked
+ * I_SYNC and parked on b_more_io, exactly as a busy inode would be. The
+ * first one is written by the flusher itself, the others by wb_inodes_wq
+ * workers, each with its own writeback_control so cgroup writeback
+ * ownership is accounted per inode. Once the whole batch has finished
+ * the inodes are requeued one by one under the list lock as usual.
+ *
+ * Returns -1 with nothing done if the batch array cannot be allocated,
+ * the caller then falls back to serial writeback.
+ */
+static long writeback_sb_inodes_parallel(struct super_block *sb,
+					 struct bdi_writeback *wb,
+					 struct wb_writeback_work *work,
+					 struct writeback_control *tmpl,
+					 int max_inodes)
+{
+	struct writeback_inode_work *iws;
+	unsigned long start_time = jiffies;
+	long total_wrote = 0;
+
+	iws = kmalloc_array(max_inodes, sizeof(*iws),
+			    GFP_NOWAIT | __GFP_NOWARN);
+	if (!iws)
+		return -1;
+
+	while (!list_empty(&wb->b_io)) {
+		long budget = work->nr_pages;
+		int nr = 0, i;
+
+		while (nr < max_inodes && budget > 0 &&
+		       !list_empty(&wb->b_io)) {
+			struct inode *inode = wb_inode(wb->b_io.prev);
+			struct writeback_inode_work *iw = &iws[nr];
+
+			if (inode->i_sb != sb) {
+				if (work->sb) {
+					redirty_tail(inode, wb);
+					continue;
+				}
+				break;
+			}
+
+			spin_lock(&inode->i_lock);
+			if (inode->i_state &
+			    (I_NEW | I_FREEING | I_WILL_FREE)) {
+				redirty_tail_locked(inode, wb);
+				spin_unlock(&inode->i_lock);
+				continue;
+			}
+			if (inode->i_state & I_SYNC) {
+				spin_unlock(&inode->i_lock);
+				requeue_io(inode, wb);
+				trace_writeback_sb_inodes_requeue(inode);
+				continue;
+			}
+			inode->i_state |= I_SYNC;
+			/* I_SYNC pins it, get it out of the way of the scan */
+			requeue_io(inode, wb);
+
+			iw->inode = inode;
+			iw->wbc = *tmpl;
+			wbc_attach_and_unlock_inode(&iw->wbc, inode);
+			iw->write_chunk = writeback_chunk_size(wb, work);
+			iw->wbc.nr_to_write = iw->write_chunk;
+			budget -= iw->write_chunk;
+			nr++;
+		}
+		if (!nr)
+			break;
+		spin_unlock(&wb->list_lock);
+
+		for (i = 1; i < nr; i++) {
+			INIT_WORK(&iws[i].work, writeback_inode_workfn);
+			queue_work(wb_inodes_wq, &iws[i].work);
+		}
+		__writeback_single_inode(iws[0].inode, &iws[0].wbc);
+		for (i = 1; i < nr; i++)
+			flush_work(&iws[i].work);
+
+		for (i = 0; i < nr; i++) {
+			struct writeback_inode_work *iw = &iws[i];
+			struct inode *inode = iw->inode;
+			struct bdi_writeback *tmp_wb;
+			long wrote;
+
+			wbc_detach_inode(&iw->wbc);
+			work->nr_pages -= iw->write_chunk - iw->wbc.nr_to_write;
+			wrote = iw->write_chunk - iw->wbc.nr_to_write -
+				iw->wbc.pages_skipped;
+			total_wrote += max(wrote, 0L);
+
+			tmp_wb = inode_to_wb_and_lock_list(inode);
+			spin_lock(&inode->i_lock);
+			if (!(inode->i_state & I_DIRTY_ALL))
+				total_wrote++;
+			requeue_inode(inode, tmp_wb, &iw->wbc);
+			inode_sync_complete(inode);
+			spin_unlock(&inode->i_lock);
+			spin_unlock(&tmp_wb->list_lock);
+		}
+
+		cond_resched();
+		spin_lock(&wb->list_lock);
+
+		/* see the same tests at the end of writeback_sb_inodes() */
+		if (total_wrote) {
+			if (time_is_before_jiffies(start_time + HZ / 10UL))
+				break;
+			if (work->nr_pages <= 0)
+				break;
+		}
+	}
+
+	kfree(iws);
+	return total_wrote;
+}
+
 /*
  * Write a portion of b_io inodes which belong to @sb.
  *
@@ -1566,6 +1713,15 @@ static long writeback_sb_inodes(struct super_block *sb,
 	unsigned long start_time = jiffies;
 	long write_chunk;
 	long total_wrote = 0;  /* count both pages and inodes */
+	int nr_parallel = READ_ONCE(dirty_writeback_inodes);
+
+	if (wbc.sync_mode == WB_SYNC_NONE && nr_parallel > 1 && wb_inodes_wq) {
+		total_wrote = writeback_sb_inodes_parallel(sb, wb, work, &wbc,
+							   nr_parallel);
+		if (total_wrote >= 0)
+			return total_wrote;
+		total_wrote = 0;
+	}
 
 	while (!list_empty(&wb->b_io)) {
 		struct inode *inode = wb_inode(wb->b_io.prev);
@@ -2079,6 +2235,15 @@ static int __init start_dirtytime_writeback(void)
 }
 __initcall(start_dirtytime_writeback);
 
+static int __init writeback_inodes_init(void)
+{
+	/* flushers may be reclaiming, the workers must make progress too */
+	wb_inodes_wq = alloc_workqueue("writeback_inodes",
+				       WQ_MEM_RECLAIM | WQ_UNBOUND, 0);
+	return wb_inodes_wq ? 0 : -ENOMEM;
+}
+__initcall(writeback_inodes_init);
+
 int dirtytime_interval_handler(struct ctl_table *table, int write,
 			       void __user *buffer, size_t *lenp, loff_t *ppos)
 {
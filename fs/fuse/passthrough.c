@@ -0,0 +1,236 @@
+/*
+ * FUSE passthrough: forward read, write and mmap on a FUSE file straight
+ * to a lower file registered by the daemon at open time.
+ *
+ * This program can be distributed under the terms of the GNU GPL.
+ * See the file COPYING.
+ */
+
+#include "fuse_i.h"
+
+#include <linux/cred.h>
+#include <linux/file.h>
+#include <linux/idr.h>
+#include <linux/uio.h>
+
+static rwf_t fuse_passthrough_rw_flags(int ki_flags)
+{
+	rwf_t flags = 0;
+
+	if (ki_flags & IOCB_HIPRI)
+		flags |= RWF_HIPRI;
+	if (ki_flags & IOCB_DSYNC)
+		flags |= RWF_DSYNC;
+	if (ki_flags & IOCB_SYNC)
+		flags |= RWF_SYNC;
+
+	return flags;
+}
+
+/* Writes through the lower file change its size behind our back */
+static void fuse_passthrough_copy_size(struct file *fuse_filp,
+				       struct file *lower_filp)
+{
+	i_size_write(file_inode(fuse_filp),
+		     i_size_read(file_inode(lower_filp)));
+}
+
+ssize_t fuse_passthrough_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct fuse_file *ff = iocb->ki_filp->private_data;
+	struct file *lower_filp = ff->passthrough.filp;
+	const struct cred *old_cred;
+	ssize_t ret;
+
+	if (!iov_iter_count(to))
+		return 0;
+
+	/* AIO completes synchronously, which is allowed for ->read_iter */
+	old_cred = override_creds(ff->passthrough.cred);
+	ret = vfs_iter_read(lower_filp, to, &iocb->ki_pos,
+			    fuse_passthrough_rw_flags(iocb->ki_flags));
+	revert_creds(old_cred);
+
+	return ret;
+}
+
+ssize_t fuse_passthrough_write_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct file *fuse_filp = iocb->ki_filp;
+	struct fuse_file *ff = fuse_filp->private_data;
+	struct file *lower_filp = ff->passthrough.filp;
+	struct inode *inode = file_inode(fuse_filp);
+	const struct cred *old_cred;
+	ssize_t ret;
+
+	if (!iov_iter_count(from))
+		return 0;
+
+	inode_lock(inode);
+	/* there is no RWF_APPEND to pass down, append here */
+	if (iocb->ki_flags & IOCB_APPEND)
+		iocb->ki_pos = i_size_read(file_inode(lower_filp));
+
+	old_cred = override_creds(ff->passthrough.cred);
+	file_start_write(lower_filp);
+	ret = vfs_iter_write(lower_filp, from, &iocb->ki_pos,
+			     fuse_passthrough_rw_flags(iocb->ki_flags));
+	file_end_write(lower_filp);
+	revert_creds(old_cred);
+	if (ret > 0) {
+		fuse_passthrough_copy_size(fuse_filp, lower_filp);
+		fuse_invalidate_attr(inode);
+	}
+	inode_unlock(inode);
+
+	return ret;
+}
+
+int fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct fuse_file *ff = file->private_data;
+	struct file *lower_filp = ff->passthrough.filp;
+	const struct cred *old_cred;
+	int ret;
+
+	if (!lower_filp->f_op->mmap)
+		return -ENODEV;
+
+	if (WARN_ON(file != vma->vm_file))
+		return -EIO;
+
+	/* faults are served by the lower file from now on */
+	vma->vm_file = get_file(lower_filp);
+
+	old_cred = override_creds(ff->passthrough.cred);
+	ret = call_mmap(vma->vm_file, vma);
+	revert_creds(old_cred);
+
+	if (ret)
+		fput(lower_filp);
+	else
+		fput(file);
+
+	return ret;
+}
+
+/**
+ * fuse_passthrough_open() - register a lower file for passthrough
+ * @fud: FUSE device the daemon issued the ioctl on
+ * @lower_fd: file descriptor of the lower file
+ *
+ * Called from FUSE_DEV_IOC_PASSTHROUGH_OPEN. The returned id is handed back
+ * by the daemon in fuse_open_out.passthrough_fh of the open reply.
+ *
+ * Return: a positive id on success, a negative errno otherwise.
+ */
+int fuse_passthrough_open(struct fuse_dev *fud, u32 lower_fd)
+{
+	struct fuse_conn *fc = fud->fc;
+	struct fuse_passthrough *passthrough;
+	struct file *lower_filp;
+	int res;
+
+	if (!fc->passthrough)
+		return -EPERM;
+
+	lower_filp = fget(lower_fd);
+	if (!lower_filp)
+		return -EBADF;
+
+	res = -EBADF;
+	if (!lower_filp->f_op->read_iter || !lower_filp->f_op->write_iter)
+		goto out_fput;
+
+	res = -EINVAL;
+	if (file_inode(lower_filp)->i_sb->s_stack_depth >=
+	    FILESYSTEM_MAX_STACK_DEPTH)
+		goto out_fput;
+
+	res = -ENOMEM;
+	passthrough = kmalloc(sizeof(*passthrough), GFP_KERNEL);
+	if (!passthrough)
+		goto out_fput;
+
+	passthrough->filp = lower_filp;
+	passthrough->cred = prepare_creds();
+	if (!passthrough->cred)
+		goto out_free;
+
+	idr_preload(GFP_KERNEL);
+	spin_lock(&fc->passthrough_req_lock);
+	res = idr_alloc(&fc->passthrough_req, passthrough, 1, 0, GFP_ATOMIC);
+	spin_unlock(&fc->passthrough_req_lock);
+	idr_preload_end();
+	if (res > 0)
+		return res;
+
+	put_cred(passthrough->cred);
+out_free:
+	kfree(passthrough);
+out_fput:
+	fput(lower_filp);
+
+	return res;
+}
+
+/**
+ * fuse_passthrough_setup() - bind a lower file to a freshly opened file
+ * @fc: FUSE connection
+ * @ff: the FUSE file being opened
+ * @openarg: the daemon's open reply
+ *
+ * Claims the lower file registered under @openarg->passthrough_fh, if any.
+ * Without one the file keeps going through the daemon.
+ */
+void fuse_passthrough_setup(struct fuse_conn *fc, struct fuse_file *ff,
+			    struct fuse_open_out *openarg)
+{
+	struct fuse_passthrough *passthrough;
+	int id = openarg->passthrough_fh;
+
+	if (!fc->passthrough || id <= 0)
+		return;
+
+	spin_lock(&fc->passthrough_req_lock);
+	passthrough = idr_remove(&fc->passthrough_req, id);
+	spin_unlock(&fc->passthrough_req_lock);
+	if (!passthrough)
+		return;
+
+	/* direct_io files use different file operations, keep them as-is */
+	if (openarg->open_flags & FOPEN_DIRECT_IO)
+		fuse_passthrough_release(passthrough);
+	else
+		ff->passthrough = *passthrough;
+	kfree(passthrough);
+}
+
+void fuse_passthrough_release(struct fuse_passthrough *passthrough)
+{
+	if (passthrough->filp) {
+		fput(passthrough->filp);
+		passthrough->filp = NULL;
+	}
+	if (passthrough->cred) {
+		put_cred(passthrough->cred);
+		passthrough->cred = NULL;
+	}
+}
+
+static int fuse_passthrough_free_req(int id, void *p, void *data)
+{
+	struct fuse_passthrough *passthrough = p;
+
+	fuse_passthrough_release(passthrough);
+	kfree(passthrough);
+
+	return 0;
+}
+
+/* Drop lower files registered by the daemon but never claimed by an open */
+void fuse_passthrough_free_unclaimed(struct fuse_conn *fc)
+{
+	idr_for_each(&fc->passthrough_req, fuse_passthrough_free_req, NULL);
+	idr_destroy(&fc->passthrough_req);
+}
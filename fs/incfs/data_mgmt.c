@@ -121,7 +121,6 @@ static void data_file_segment_init(struct data_file_segment *segment)
 {
 	init_waitqueue_head(&segment->new_data_arrival_wq);
 	mutex_init(&segment->blockmap_mutex);
-	INIT_LIST_HEAD(&segment->reads_list_head);
 }
 
 static void data_file_segment_destroy(struct data_file_segment *segment)
@@ -733,9 +732,29 @@ static void set_read_done(struct pending_read *read)
 	atomic_set_release(&read->done, 1);
 }
 
+/*
+ * Wake function of a pending read, only wakes the reader if @key points
+ * to the index of the block it waits for.
+ */
+static int pending_read_wake(struct wait_queue_entry *wait, unsigned int mode,
+			     int sync, void *key)
+{
+	struct pending_read *read =
+		container_of(wait, struct pending_read, wait);
+
+	if (read->block_index != *(int *)key)
+		return 0;
+
+	set_read_done(read);
+	return default_wake_function(wait, mode, sync, key);
+}
+
 /*
  * Notifies a given data file about pending read from a given block.
  * Returns a new pending read entry.
+ *
+ * Must be called with the segment's blockmap_mutex held, so the read is
+ * on the waitqueue before the block can be filled.
  */
 static struct pending_read *add_pending_read(struct data_file *df,
 					     int block_index)
@@ -754,6 +773,9 @@ static struct pending_read *add_pending_read(struct data_file *df,
 	result->file_id = df->df_id;
 	result->block_index = block_index;
 	result->timestamp_us = ktime_to_us(ktime_get());
+	init_waitqueue_func_entry(&result->wait, pending_read_wake);
+	result->wait.private = current;
+	add_wait_queue(&segment->new_data_arrival_wq, &result->wait);
 
 	mutex_lock(&mi->mi_pending_reads_mutex);
 
@@ -761,7 +783,6 @@ static struct pending_read *add_pending_read(struct data_file *df,
 	mi->mi_pending_reads_count++;
 
 	list_add(&result->mi_reads_list, &mi->mi_reads_list_head);
-	list_add(&result->segment_reads_list, &segment->reads_list_head);
 	mutex_unlock(&mi->mi_pending_reads_mutex);
 
 	wake_up_all(&mi->mi_pending_reads_notif_wq);
@@ -780,10 +801,11 @@ static void remove_pending_read(struct data_file *df, struct pending_read *read)
 	}
 
 	mi = df->df_mount_info;
+	remove_wait_queue(&get_file_segment(df, read->block_index)->new_data_arrival_wq,
+			  &read->wait);
 
 	mutex_lock(&mi->mi_pending_reads_mutex);
 	list_del(&read->mi_reads_list);
-	list_del(&read->segment_reads_list);
 
 	mi->mi_pending_reads_count--;
 	mutex_unlock(&mi->mi_pending_reads_mutex);
@@ -791,21 +813,35 @@ static void remove_pending_read(struct data_file *df, struct pending_read *read)
 	kfree(read);
 }
 
-static void notify_pending_reads(struct mount_info *mi,
-		struct data_file_segment *segment,
-		int index)
+/* Wakes only the pending reads waiting for block @index. */
+static void notify_pending_reads(struct data_file_segment *segment, int index)
 {
-	struct pending_read *entry = NULL;
+	__wake_up(&segment->new_data_arrival_wq, TASK_NORMAL, 0, &index);
+}
 
-	/* Notify pending reads waiting for this block. */
-	mutex_lock(&mi->mi_pending_reads_mutex);
-	list_for_each_entry(entry, &segment->reads_list_head,
-						segment_reads_list) {
-		if (entry->block_index == index)
-			set_read_done(entry);
+/*
+ * Waits until pending_read_wake() marks @read done. Returns a positive
+ * value if it did, 0 on timeout or -ERESTARTSYS if a signal arrived.
+ */
+static long wait_for_pending_read(struct pending_read *read, long timeout)
+{
+	long ret = 0;
+
+	for (;;) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (is_read_done(read))
+			break;
+		if (signal_pending(current)) {
+			ret = -ERESTARTSYS;
+			break;
+		}
+		if (!timeout)
+			break;
+		timeout = schedule_timeout(timeout);
 	}
-	mutex_unlock(&mi->mi_pending_reads_mutex);
-	wake_up_all(&segment->new_data_arrival_wq);
+	__set_current_state(TASK_RUNNING);
+
+	return is_read_done(read) ? 1 : ret;
 }
 
 static int wait_for_data_block(struct data_file *df, int block_index,
@@ -861,10 +897,7 @@ static int wait_for_data_block(struct data_file *df, int block_index,
 		return -ENOMEM;
 
 	/* Wait for notifications about block's arrival */
-	wait_res =
-		wait_event_interruptible_timeout(segment->new_data_arrival_wq,
-						 (is_read_done(read)),
-						 msecs_to_jiffies(timeout_ms));
+	wait_res = wait_for_pending_read(read, msecs_to_jiffies(timeout_ms));
 
 	/* Woke up, the pending read is no longer needed. */
 	remove_pending_read(df, read);
@@ -978,7 +1011,6 @@ ssize_t incfs_read_data_file_block(struct mem_range dst, struct file *f,
 int incfs_process_new_data_block(struct data_file *df,
 				 struct incfs_fill_block *block, u8 *data)
 {
-	struct mount_info *mi = NULL;
 	struct backing_file_context *bfc = NULL;
 	struct data_file_segment *segment = NULL;
 	struct data_file_block existing_block = {};
@@ -989,7 +1021,6 @@ int incfs_process_new_data_block(struct data_file *df,
 		return -EFAULT;
 
 	bfc = df->df_backing_file_context;
-	mi = df->df_mount_info;
 
 	if (block->block_index >= df->df_data_block_count)
 		return -ERANGE;
@@ -1020,7 +1051,7 @@ int incfs_process_new_data_block(struct data_file *df,
 		mutex_unlock(&bfc->bc_mutex);
 	}
 	if (!error)
-		notify_pending_reads(mi, segment, block->block_index);
+		notify_pending_reads(segment, block->block_index);
 
 unlock:
 	mutex_unlock(&segment->blockmap_mutex);
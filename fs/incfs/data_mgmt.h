@@ -101,6 +101,7 @@ struct mount_options {
 	unsigned int read_log_wakeup_count;
 	bool no_backing_file_cache;
 	bool no_backing_file_readahead;
+	bool async_readahead;
 };
 
 struct mount_info {
@@ -127,7 +128,6 @@ struct mount_info {
 	 *  - reads_list_head
 	 *  - mi_pending_reads_count
 	 *  - mi_last_pending_read_number
-	 *  - data_file_segment.reads_list_head
 	 */
 	struct mutex mi_pending_reads_mutex;
 
@@ -174,19 +174,17 @@ struct pending_read {
 
 	struct list_head mi_reads_list;
 
-	struct list_head segment_reads_list;
+	/* Entry on data_file_segment.new_data_arrival_wq, keyed by block */
+	struct wait_queue_entry wait;
 };
 
 struct data_file_segment {
+	/* Pending reads of the segment, woken by block index */
 	wait_queue_head_t new_data_arrival_wq;
 
 	/* Protects reads and writes from the blockmap */
 	/* Good candidate for read/write mutex */
 	struct mutex blockmap_mutex;
-
-	/* List of active pending_read objects belonging to this segment */
-	/* Protected by mount_info.pending_reads_mutex */
-	struct list_head reads_list_head;
 };
 
 /*
@@ -53,6 +53,8 @@ static int dir_rename(struct inode *old_dir, struct dentry *old_dentry,
 static int file_open(struct inode *inode, struct file *file);
 static int file_release(struct inode *inode, struct file *file);
 static int read_single_page(struct file *f, struct page *page);
+static int readpages(struct file *f, struct address_space *mapping,
+		     struct list_head *pages, unsigned int nr_pages);
 static long dispatch_ioctl(struct file *f, unsigned int req, unsigned long arg);
 
 static ssize_t pending_reads_read(struct file *f, char __user *buf, size_t len,
@@ -123,7 +125,7 @@ static const struct dentry_operations incfs_dentry_ops = {
 
 static const struct address_space_operations incfs_address_space_ops = {
 	.readpage = read_single_page,
-	/* .readpages = readpages */
+	.readpages = readpages
 };
 
 static const struct file_operations incfs_file_ops = {
@@ -220,6 +222,7 @@ enum parse_parameter {
 	Opt_no_backing_file_readahead,
 	Opt_rlog_pages,
 	Opt_rlog_wakeup_cnt,
+	Opt_async_readahead,
 	Opt_err
 };
 
@@ -242,6 +245,7 @@ static const match_table_t option_tokens = {
 	{ Opt_no_backing_file_readahead, "no_bf_readahead=%u" },
 	{ Opt_rlog_pages, "rlog_pages=%u" },
 	{ Opt_rlog_wakeup_cnt, "rlog_wakeup_cnt=%u" },
+	{ Opt_async_readahead, "async_readahead=%u" },
 	{ Opt_err, NULL }
 };
 
@@ -260,6 +264,7 @@ static int parse_options(struct mount_options *opts, char *str)
 	opts->read_log_wakeup_count = 10;
 	opts->no_backing_file_cache = false;
 	opts->no_backing_file_readahead = false;
+	opts->async_readahead = false;
 	if (str == NULL || *str == 0)
 		return 0;
 
@@ -302,6 +307,11 @@ static int parse_options(struct mount_options *opts, char *str)
 				return -EINVAL;
 			opts->read_log_wakeup_count = value;
 			break;
+		case Opt_async_readahead:
+			if (match_int(&args[0], &value))
+				return -EINVAL;
+			opts->async_readahead = (value != 0);
+			break;
 		default:
 			return -EINVAL;
 		}
@@ -790,7 +800,14 @@ static struct dentry *open_or_create_index_dir(struct dentry *backing_dir)
 	return index_dentry;
 }
 
-static int read_single_page(struct file *f, struct page *page)
+/*
+ * Fills a locked page from its data block, decompressing and verifying it.
+ * Readahead pages use a zero timeout: missing blocks are left to the
+ * ->readpage of the reader instead of stalling a worker, so they are
+ * neither uptodate nor marked as failed.
+ */
+static int fill_page(struct file *f, struct page *page, int timeout_ms,
+		     struct mem_range tmp, bool readahead)
 {
 	loff_t offset = 0;
 	loff_t size = 0;
@@ -798,30 +815,22 @@ static int read_single_page(struct file *f, struct page *page)
 	ssize_t read_result = 0;
 	struct data_file *df = get_incfs_data_file(f);
 	int result = 0;
-	void *page_start = kmap(page);
+	void *page_start;
 	int block_index;
-	int timeout_ms;
 
 	if (!df)
 		return -EBADF;
 
+	page_start = kmap(page);
 	offset = page_offset(page);
 	block_index = offset / INCFS_DATA_FILE_BLOCK_SIZE;
 	size = df->df_size;
-	timeout_ms = df->df_mount_info->mi_options.read_timeout_ms;
 
 	if (offset < size) {
-		struct mem_range tmp = {
-			.len = 2 * INCFS_DATA_FILE_BLOCK_SIZE
-		};
-
-		tmp.data = (u8 *)__get_free_pages(GFP_NOFS, get_order(tmp.len));
 		bytes_to_read = min_t(loff_t, size - offset, PAGE_SIZE);
 		read_result = incfs_read_data_file_block(
 			range(page_start, bytes_to_read), f, block_index,
 			timeout_ms, tmp);
-
-		free_pages((unsigned long)tmp.data, get_order(tmp.len));
 	} else {
 		bytes_to_read = 0;
 		read_result = 0;
@@ -834,7 +843,7 @@ static int read_single_page(struct file *f, struct page *page)
 
 	if (result == 0)
 		SetPageUptodate(page);
-	else
+	else if (!readahead)
 		SetPageError(page);
 
 	flush_dcache_page(page);
@@ -843,6 +852,128 @@ static int read_single_page(struct file *f, struct page *page)
 	return result;
 }
 
+static int read_single_page(struct file *f, struct page *page)
+{
+	struct data_file *df = get_incfs_data_file(f);
+	struct mem_range tmp = {
+		.len = 2 * INCFS_DATA_FILE_BLOCK_SIZE
+	};
+	int result;
+
+	if (!df)
+		return -EBADF;
+
+	tmp.data = (u8 *)__get_free_pages(GFP_NOFS, get_order(tmp.len));
+	result = fill_page(f, page, df->df_mount_info->mi_options.read_timeout_ms,
+			   tmp, false);
+	free_pages((unsigned long)tmp.data, get_order(tmp.len));
+	return result;
+}
+
+/* Pages filled by one readahead worker */
+#define READAHEAD_BATCH_PAGES 8
+
+struct readahead_work {
+	struct work_struct work;
+
+	struct file *file;
+
+	unsigned int nr_pages;
+
+	struct page *pages[READAHEAD_BATCH_PAGES];
+};
+
+static void readahead_work_fn(struct work_struct *work)
+{
+	struct readahead_work *rw =
+		container_of(work, struct readahead_work, work);
+	struct mem_range tmp = {
+		.len = 2 * INCFS_DATA_FILE_BLOCK_SIZE
+	};
+	unsigned int i;
+
+	tmp.data = (u8 *)__get_free_pages(GFP_NOFS, get_order(tmp.len));
+	for (i = 0; i < rw->nr_pages; i++) {
+		struct page *page = rw->pages[i];
+
+		if (tmp.data)
+			fill_page(rw->file, page, 0, tmp, true);
+		else
+			unlock_page(page);
+		put_page(page);
+	}
+	free_pages((unsigned long)tmp.data, get_order(tmp.len));
+
+	fput(rw->file);
+	kfree(rw);
+}
+
+/*
+ * With async_readahead the readahead window is inserted into the page
+ * cache as locked pages and filled by unbound workers in batches, so
+ * decompression and hash verification run ahead of the reader and in
+ * parallel instead of page by page in the faulting task.
+ */
+static int readpages(struct file *f, struct address_space *mapping,
+		     struct list_head *pages, unsigned int nr_pages)
+{
+	struct mount_info *mi = get_mount_info(file_superblock(f));
+	struct readahead_work *rw = NULL;
+	struct mem_range tmp = {
+		.len = 2 * INCFS_DATA_FILE_BLOCK_SIZE
+	};
+	struct page *page;
+
+	if (!mi->mi_options.async_readahead) {
+		tmp.data = (u8 *)__get_free_pages(GFP_NOFS,
+						  get_order(tmp.len));
+		if (!tmp.data)
+			return -ENOMEM;
+	}
+
+	while (!list_empty(pages)) {
+		page = list_last_entry(pages, struct page, lru);
+		list_del(&page->lru);
+
+		if (add_to_page_cache_lru(page, mapping, page->index,
+					  readahead_gfp_mask(mapping))) {
+			put_page(page);
+			continue;
+		}
+
+		if (!mi->mi_options.async_readahead) {
+			fill_page(f, page, mi->mi_options.read_timeout_ms,
+				  tmp, true);
+			put_page(page);
+			continue;
+		}
+
+		if (!rw) {
+			rw = kzalloc(sizeof(*rw), GFP_NOFS | __GFP_NOWARN);
+			if (!rw) {
+				/* leave it to ->readpage */
+				unlock_page(page);
+				put_page(page);
+				continue;
+			}
+			INIT_WORK(&rw->work, readahead_work_fn);
+			rw->file = get_file(f);
+		}
+
+		rw->pages[rw->nr_pages++] = page;
+		if (rw->nr_pages == READAHEAD_BATCH_PAGES) {
+			queue_work(system_unbound_wq, &rw->work);
+			rw = NULL;
+		}
+	}
+
+	if (rw)
+		queue_work(system_unbound_wq, &rw->work);
+	if (tmp.data)
+		free_pages((unsigned long)tmp.data, get_order(tmp.len));
+	return 0;
+}
+
 static char *file_id_to_str(incfs_uuid_t id)
 {
 	char *result = kmalloc(1 + sizeof(id.bytes) * 2, GFP_NOFS);
@@ -2302,5 +2433,7 @@ static int show_options(struct seq_file *m, struct dentry *root)
 		seq_puts(m, ",no_bf_cache");
 	if (mi->mi_options.no_backing_file_readahead)
 		seq_puts(m, ",no_bf_readahead");
+	if (mi->mi_options.async_readahead)
+		seq_puts(m, ",async_readahead=1");
 	return 0;
 }
@@ -27,6 +27,7 @@
 #include <linux/bootmem.h>
 #include <linux/task_work.h>
 #include <linux/sched/task.h>
+#include <soc/qcom/boot_stats.h>
 
 #include "pnode.h"
 #include "internal.h"
@@ -2618,6 +2619,7 @@ static int do_new_mount(struct path *path, const char *fstype, int sb_flags,
 {
 	struct file_system_type *type;
 	struct vfsmount *mnt;
+	ktime_t start = boot_event_start();
 	int err;
 
 	if (!fstype)
@@ -2647,6 +2649,8 @@ static int do_new_mount(struct path *path, const char *fstype, int sb_flags,
 	err = do_add_mount(real_mount(mnt), path, mnt_flags);
 	if (err)
 		mntput(mnt);
+	else
+		boot_event_record(BOOT_EVENT_MOUNT, fstype, start);
 	return err;
 }
 
@@ -804,6 +804,14 @@ static int do_dentry_open(struct file *f,
 	f->f_write_hint = WRITE_LIFE_NOT_SET;
 	f->f_flags &= ~(O_CREAT | O_EXCL | O_NOCTTY | O_TRUNC);
 
+	/*
+	 * Huge pages collapsed from read-only file text can't be written
+	 * back, drop them before the first write. get_write_access() above
+	 * is a full barrier against the i_writecount check in collapse_file().
+	 */
+	if ((f->f_mode & FMODE_WRITER) && filemap_nr_thps(inode->i_mapping))
+		truncate_pagecache(inode, 0);
+
 	file_ra_state_init(&f->f_ra, f->f_mapping->host->i_mapping);
 
 	return 0;
@@ -142,6 +142,9 @@ static int ovl_copy_up_data(struct path *old, struct path *new, loff_t len)
 	struct file *new_file;
 	loff_t old_pos = 0;
 	loff_t new_pos = 0;
+	loff_t data_pos = -1;
+	loff_t size = len;
+	bool skip_hole = false;
 	int error = 0;
 
 	if (len == 0)
@@ -164,7 +167,10 @@ static int ovl_copy_up_data(struct path *old, struct path *new, loff_t len)
 	/* Couldn't clone, so now we try to copy the data */
 	error = 0;
 
-	/* FIXME: copy up sparse files efficiently */
+	/* Holes are only skipped if the lower fs can tell where they are */
+	if ((old_file->f_mode & FMODE_LSEEK) && old_file->f_op->llseek)
+		skip_hole = true;
+
 	while (len) {
 		size_t this_len = OVL_COPY_UP_CHUNK_SIZE;
 		long bytes;
@@ -177,6 +183,28 @@ static int ovl_copy_up_data(struct path *old, struct path *new, loff_t len)
 			break;
 		}
 
+		/*
+		 * Copying a hole would write zeroes, allocating space in the
+		 * upper fs and taking as long as copying data. Whenever the
+		 * next data in the lower file starts past the current
+		 * position, jump to it. Not every hole is found this way,
+		 * only those in front of a chunk boundary, which is enough
+		 * for the large sparse images this matters for.
+		 */
+		if (skip_hole && data_pos < old_pos) {
+			data_pos = vfs_llseek(old_file, old_pos, SEEK_DATA);
+			if (data_pos > old_pos) {
+				len -= min_t(loff_t, data_pos - old_pos, len);
+				old_pos = new_pos = data_pos;
+				continue;
+			} else if (data_pos == -ENXIO) {
+				/* the rest is a hole */
+				break;
+			} else if (data_pos < 0) {
+				skip_hole = false;
+			}
+		}
+
 		bytes = do_splice_direct(old_file, &old_pos,
 					 new_file, &new_pos,
 					 this_len, SPLICE_F_MOVE);
@@ -188,6 +216,10 @@ static int ovl_copy_up_data(struct path *old, struct path *new, loff_t len)
 
 		len -= bytes;
 	}
+
+	/* a trailing hole was skipped, extend the copy to the full size */
+	if (!error && new_pos < size)
+		error = vfs_truncate(new, size);
 out:
 	if (!error)
 		error = vfs_fsync(new_file, 0);
@@ -1636,6 +1636,80 @@ static const struct file_operations proc_pid_sched_group_id_operations = {
 	.release	= single_release,
 };
 
+static int sched_frame_hint_show(struct seq_file *m, void *v)
+{
+	struct inode *inode = m->private;
+	struct task_struct *p;
+	u64 period, remaining;
+	int err;
+
+	p = get_proc_task(inode);
+	if (!p)
+		return -ESRCH;
+
+	err = sched_get_frame_hint(p, &period, &remaining);
+	if (!err)
+		seq_printf(m, "%llu %llu\n", div_u64(period, NSEC_PER_USEC),
+			   div_u64(remaining, NSEC_PER_USEC));
+
+	put_task_struct(p);
+
+	return err;
+}
+
+/*
+ * Takes "<period_us> [<deadline_us>]": the frame period of the task's
+ * related thread group and the time until the current frame is due.
+ */
+static ssize_t
+sched_frame_hint_write(struct file *file, const char __user *buf,
+	    size_t count, loff_t *offset)
+{
+	struct inode *inode = file_inode(file);
+	struct task_struct *p;
+	char buffer[32];
+	u64 period, deadline = 0;
+	int err;
+
+	memset(buffer, 0, sizeof(buffer));
+	if (count > sizeof(buffer) - 1)
+		count = sizeof(buffer) - 1;
+	if (copy_from_user(buffer, buf, count)) {
+		err = -EFAULT;
+		goto out;
+	}
+
+	if (sscanf(strstrip(buffer), "%llu %llu", &period, &deadline) < 1) {
+		err = -EINVAL;
+		goto out;
+	}
+
+	p = get_proc_task(inode);
+	if (!p)
+		return -ESRCH;
+
+	err = sched_set_frame_hint(p, period * NSEC_PER_USEC,
+				   deadline * NSEC_PER_USEC);
+
+	put_task_struct(p);
+
+out:
+	return err < 0 ? err : count;
+}
+
+static int sched_frame_hint_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, sched_frame_hint_show, inode);
+}
+
+static const struct file_operations proc_pid_sched_frame_hint_operations = {
+	.open		= sched_frame_hint_open,
+	.read		= seq_read,
+	.write		= sched_frame_hint_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 #endif	/* CONFIG_SCHED_WALT */
 
 #ifdef CONFIG_SCHED_AUTOGROUP
@@ -3185,6 +3259,7 @@ static const struct pid_entry tgid_base_stuff[] = {
 #ifdef CONFIG_SCHED_WALT
 	REG("sched_init_task_load", 00644, proc_pid_sched_init_task_load_operations),
 	REG("sched_group_id", 00666, proc_pid_sched_group_id_operations),
+	REG("sched_frame_hint", 00666, proc_pid_sched_frame_hint_operations),
 #endif
 #ifdef CONFIG_SCHED_DEBUG
 	REG("sched",      S_IRUGO|S_IWUSR, proc_pid_sched_operations),
@@ -895,6 +895,11 @@ static int show_smap(struct seq_file *m, void *v, int is_pid)
 			   vma_kernel_pagesize(vma) >> 10,
 			   vma_mmu_pagesize(vma) >> 10);
 
+#ifdef CONFIG_ADAPTIVE_FAULT_AROUND
+	if (!rollup_mode && vma->vm_ops && vma->vm_ops->map_pages)
+		seq_printf(m, "FaultAround:    %8lu kB\n",
+			   vma_fault_around_bytes(vma) >> 10);
+#endif
 
 	if (!rollup_mode || last_vma)
 		seq_printf(m,
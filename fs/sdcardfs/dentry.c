@@ -21,6 +21,64 @@
 #include "sdcardfs.h"
 #include "linux/ctype.h"
 
+/*
+ * rcu-walk variant of sdcardfs_d_revalidate(). Only answers for dentries
+ * without a graft path whose derived state is known to be current, and
+ * leaves anything that may need invalidating to ref-walk.
+ */
+static int sdcardfs_d_revalidate_rcu(struct dentry *dentry, unsigned int flags)
+{
+	struct sdcardfs_dentry_info *di = READ_ONCE(dentry->d_fsdata);
+	struct sdcardfs_dentry_info *pdi;
+	struct dentry *parent, *lower_dentry, *parent_lower_dentry;
+	struct sdcardfs_inode_data *data;
+	struct inode *inode;
+	int err;
+
+	if (IS_ROOT(dentry))
+		return 1;
+
+	if (!di || READ_ONCE(di->orig_path.dentry) ||
+	    READ_ONCE(di->perm_gen) != sdcardfs_read_perm_gen())
+		return -ECHILD;
+
+	parent = READ_ONCE(dentry->d_parent);
+	pdi = READ_ONCE(parent->d_fsdata);
+	if (!pdi)
+		return -ECHILD;
+
+	lower_dentry = READ_ONCE(di->lower_path.dentry);
+	parent_lower_dentry = READ_ONCE(pdi->lower_path.dentry);
+	if (!lower_dentry || !parent_lower_dentry)
+		return -ECHILD;
+
+	if (lower_dentry->d_flags & DCACHE_OP_REVALIDATE) {
+		err = lower_dentry->d_op->d_revalidate(lower_dentry, flags);
+		if (err <= 0)
+			return err ? err : -ECHILD;
+	}
+
+	if (d_unhashed(lower_dentry) ||
+	    READ_ONCE(lower_dentry->d_parent) != parent_lower_dentry)
+		return -ECHILD;
+
+	/* the upper name is revalidated by the caller through d_seq */
+	spin_lock(&lower_dentry->d_lock);
+	err = qstr_case_eq(&dentry->d_name, &lower_dentry->d_name);
+	spin_unlock(&lower_dentry->d_lock);
+	if (!err)
+		return -ECHILD;
+
+	inode = d_inode_rcu(dentry);
+	if (!inode)
+		return -ECHILD;
+	data = top_data_get(SDCARDFS_I(inode));
+	err = data && !data->abandoned ? 1 : -ECHILD;
+	if (data)
+		data_put(data);
+	return err;
+}
+
 /*
  * returns: -ERRNO if error (returned to user)
  *          0: tell VFS to invalidate dentry
@@ -36,9 +94,12 @@ static int sdcardfs_d_revalidate(struct dentry *dentry, unsigned int flags)
 	struct dentry *lower_dentry = NULL;
 	struct inode *inode;
 	struct sdcardfs_inode_data *data;
+	unsigned int perm_gen;
 
 	if (flags & LOOKUP_RCU)
-		return -ECHILD;
+		return sdcardfs_d_revalidate_rcu(dentry, flags);
+
+	perm_gen = sdcardfs_read_perm_gen();
 
 	spin_lock(&dentry->d_lock);
 	if (IS_ROOT(dentry)) {
@@ -114,6 +175,8 @@ static int sdcardfs_d_revalidate(struct dentry *dentry, unsigned int flags)
 			data_put(data);
 		iput(inode);
 	}
+	if (err > 0)
+		SDCARDFS_D(dentry)->perm_gen = perm_gen;
 
 out:
 	dput(parent_dentry);
@@ -37,13 +37,26 @@ int sdcardfs_init_dentry_cache(void)
 
 void sdcardfs_destroy_dentry_cache(void)
 {
+	/* wait for private data freed after a grace period */
+	rcu_barrier();
 	kmem_cache_destroy(sdcardfs_dentry_cachep);
 }
 
+static void free_dentry_private_data_rcu(struct rcu_head *head)
+{
+	struct sdcardfs_dentry_info *info =
+		container_of(head, struct sdcardfs_dentry_info, rcu);
+
+	kmem_cache_free(sdcardfs_dentry_cachep, info);
+}
+
+/* freed after a grace period, rcu-walk of d_revalidate may still use it */
 void free_dentry_private_data(struct dentry *dentry)
 {
-	kmem_cache_free(sdcardfs_dentry_cachep, dentry->d_fsdata);
-	dentry->d_fsdata = NULL;
+	struct sdcardfs_dentry_info *info = dentry->d_fsdata;
+
+	WRITE_ONCE(dentry->d_fsdata, NULL);
+	call_rcu(&info->rcu, free_dentry_private_data_rcu);
 }
 
 /* allocate new dentry private data */
@@ -446,6 +459,8 @@ struct dentry *sdcardfs_lookup(struct inode *dir, struct dentry *dentry,
 	if (ret)
 		dentry = ret;
 	if (d_inode(dentry)) {
+		/* sampled before deriving, so a racing change isn't missed */
+		SDCARDFS_D(dentry)->perm_gen = sdcardfs_read_perm_gen();
 		fsstack_copy_attr_times(d_inode(dentry),
 					sdcardfs_lower_inode(d_inode(dentry)));
 		/* get derived permission */
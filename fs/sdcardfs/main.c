@@ -23,6 +23,12 @@
 #include <linux/types.h>
 #include <linux/parser.h>
 
+static unsigned int shrink_seeks;
+module_param(shrink_seeks, uint, 0644);
+MODULE_PARM_DESC(shrink_seeks,
+	"Cost of recreating a cached dentry or inode, relative to other "
+	"filesystems (default: DEFAULT_SEEKS)");
+
 enum {
 	Opt_fsuid,
 	Opt_fsgid,
@@ -313,6 +319,12 @@ static int sdcardfs_read_super(struct vfsmount *mnt, struct super_block *sb,
 
 	sb->s_magic = SDCARDFS_SUPER_MAGIC;
 	sb->s_op = &sdcardfs_sops;
+	/*
+	 * Our dentries and inodes pin the lower ones, shrinking them puts
+	 * both layers back through lookup on the next access.
+	 */
+	if (shrink_seeks)
+		sb->s_shrink.seeks = shrink_seeks;
 
 	/* get a new inode and allocate our root dentry */
 	inode = sdcardfs_iget(sb, d_inode(lower_path.dentry), 0);
@@ -249,6 +249,8 @@ static int insert_userid_exclude_entry_locked(const struct qstr *key, userid_t v
 	return 0;
 }
 
+atomic_t sdcardfs_perm_gen = ATOMIC_INIT(0);
+
 static void fixup_all_perms_name(const struct qstr *key)
 {
 	struct sdcardfs_sb_info *sbinfo;
@@ -256,6 +258,7 @@ static void fixup_all_perms_name(const struct qstr *key)
 		.flags = BY_NAME,
 		.name = QSTR_INIT(key->name, key->len),
 	};
+	atomic_inc(&sdcardfs_perm_gen);
 	list_for_each_entry(sbinfo, &sdcardfs_super_list, list) {
 		if (sbinfo_has_sdcard_magic(sbinfo))
 			fixup_perms_recursive(sbinfo->sb->s_root, &limit);
@@ -270,6 +273,7 @@ static void fixup_all_perms_name_userid(const struct qstr *key, userid_t userid)
 		.name = QSTR_INIT(key->name, key->len),
 		.userid = userid,
 	};
+	atomic_inc(&sdcardfs_perm_gen);
 	list_for_each_entry(sbinfo, &sdcardfs_super_list, list) {
 		if (sbinfo_has_sdcard_magic(sbinfo))
 			fixup_perms_recursive(sbinfo->sb->s_root, &limit);
@@ -283,6 +287,7 @@ static void fixup_all_perms_userid(userid_t userid)
 		.flags = BY_USERID,
 		.userid = userid,
 	};
+	atomic_inc(&sdcardfs_perm_gen);
 	list_for_each_entry(sbinfo, &sdcardfs_super_list, list) {
 		if (sbinfo_has_sdcard_magic(sbinfo))
 			fixup_perms_recursive(sbinfo->sb->s_root, &limit);
@@ -188,6 +188,9 @@ struct sdcardfs_dentry_info {
 	spinlock_t lock;	/* protects lower_path */
 	struct path lower_path;
 	struct path orig_path;
+	/* sdcardfs_perm_gen when the derived state was last validated */
+	unsigned int perm_gen;
+	struct rcu_head rcu;
 };
 
 struct sdcardfs_mount_options {
@@ -484,6 +487,18 @@ static inline void sdcardfs_put_real_lower(const struct dentry *dent,
 extern struct mutex sdcardfs_super_list_lock;
 extern struct list_head sdcardfs_super_list;
 
+/*
+ * Bumped whenever the package list changes derived permissions, lets
+ * d_revalidate trust a dentry under RCU only if nothing changed since
+ * it was last validated.
+ */
+extern atomic_t sdcardfs_perm_gen;
+
+static inline unsigned int sdcardfs_read_perm_gen(void)
+{
+	return atomic_read(&sdcardfs_perm_gen);
+}
+
 /* for packagelist.c */
 extern appid_t get_appid(const char *app_name);
 extern appid_t get_ext_gid(const char *app_name);
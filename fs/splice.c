@@ -32,8 +32,11 @@
 #include <linux/security.h>
 #include <linux/gfp.h>
 #include <linux/socket.h>
+#include <linux/net.h>
 #include <linux/compat.h>
 #include <linux/sched/signal.h>
+#include <net/sock.h>
+#include <net/tcp.h>
 
 #include "internal.h"
 
@@ -429,6 +432,17 @@ static ssize_t default_file_splice_read(struct file *in, loff_t *ppos,
 	return res;
 }
 
+static int pipe_sendpage_flags(struct pipe_inode_info *pipe,
+			       struct splice_desc *sd)
+{
+	int more = (sd->flags & SPLICE_F_MORE) ? MSG_MORE : 0;
+
+	if (sd->len < sd->total_len && pipe->nrbufs > 1)
+		more |= MSG_SENDPAGE_NOTLAST;
+
+	return more;
+}
+
 /*
  * Send 'sd->len' bytes to socket from 'sd->file' at position 'sd->pos'
  * using sendpage(). Return the number of bytes sent.
@@ -438,16 +452,11 @@ static int pipe_to_sendpage(struct pipe_inode_info *pipe,
 {
 	struct file *file = sd->u.file;
 	loff_t pos = sd->pos;
-	int more;
+	int more = pipe_sendpage_flags(pipe, sd);
 
 	if (!likely(file->f_op->sendpage))
 		return -EINVAL;
 
-	more = (sd->flags & SPLICE_F_MORE) ? MSG_MORE : 0;
-
-	if (sd->len < sd->total_len && pipe->nrbufs > 1)
-		more |= MSG_SENDPAGE_NOTLAST;
-
 	return file->f_op->sendpage(file, buf->page, buf->offset,
 				    sd->len, &pos, more);
 }
@@ -813,6 +822,85 @@ static ssize_t default_file_splice_write(struct pipe_inode_info *pipe,
 	return ret;
 }
 
+#ifdef CONFIG_INET
+/*
+ * Same as pipe_to_sendpage(), for a TCP socket whose lock the caller
+ * already holds.
+ */
+static int pipe_to_tcp_sendpage_locked(struct pipe_inode_info *pipe,
+				       struct pipe_buffer *buf,
+				       struct splice_desc *sd)
+{
+	struct file *file = sd->u.file;
+	struct socket *sock = file->private_data;
+	int flags = pipe_sendpage_flags(pipe, sd);
+
+	if (file->f_flags & O_NONBLOCK)
+		flags |= MSG_DONTWAIT;
+
+	return tcp_sendpage_locked(sock->sk, buf->page, buf->offset,
+				   sd->len, flags);
+}
+
+/*
+ * Splice to a TCP socket, taking the socket lock once for all the buffers
+ * that are in the pipe at a time instead of once per page. The skbs then
+ * get filled from consecutive buffers without backlog processing and
+ * release_sock() in between. Whoever replaced sk_prot (kTLS) has its own
+ * ->sendpage, which is checked under the lock for every batch.
+ */
+static ssize_t splice_to_tcp_socket(struct pipe_inode_info *pipe,
+				    struct file *out, size_t len,
+				    unsigned int flags)
+{
+	struct sock *sk = ((struct socket *)out->private_data)->sk;
+	struct splice_desc sd = {
+		.total_len = len,
+		.flags = flags,
+		.u.file = out,
+	};
+	splice_actor *actor;
+	ssize_t ret;
+
+	sock_rps_record_flow(sk);
+
+	pipe_lock(pipe);
+	splice_from_pipe_begin(&sd);
+	do {
+		cond_resched();
+		ret = splice_from_pipe_next(pipe, &sd);
+		if (ret <= 0)
+			break;
+
+		lock_sock(sk);
+		actor = pipe_to_tcp_sendpage_locked;
+		if (sk->sk_prot->sendpage != tcp_sendpage) {
+			release_sock(sk);
+			actor = pipe_to_sendpage;
+		}
+		ret = splice_from_pipe_feed(pipe, &sd, actor);
+		if (actor == pipe_to_tcp_sendpage_locked)
+			release_sock(sk);
+	} while (ret > 0);
+	splice_from_pipe_end(pipe, &sd);
+	pipe_unlock(pipe);
+
+	return sd.num_spliced ? sd.num_spliced : ret;
+}
+
+static bool splice_out_is_tcp(struct file *out)
+{
+	struct socket *sock;
+	int err;
+
+	sock = sock_from_file(out, &err);
+	return sock && sock->sk && sock->type == SOCK_STREAM &&
+	       sock->sk->sk_protocol == IPPROTO_TCP &&
+	       (sock->sk->sk_family == AF_INET ||
+		sock->sk->sk_family == AF_INET6);
+}
+#endif
+
 /**
  * generic_splice_sendpage - splice data from a pipe to a socket
  * @pipe:	pipe to splice from
@@ -829,6 +917,10 @@ static ssize_t default_file_splice_write(struct pipe_inode_info *pipe,
 ssize_t generic_splice_sendpage(struct pipe_inode_info *pipe, struct file *out,
 				loff_t *ppos, size_t len, unsigned int flags)
 {
+#ifdef CONFIG_INET
+	if (splice_out_is_tcp(out))
+		return splice_to_tcp_socket(pipe, out, len, flags);
+#endif
 	return splice_from_pipe(pipe, out, ppos, len, flags, pipe_to_sendpage);
 }
 
@@ -57,6 +57,12 @@ struct blk_mq_hw_ctx {
 	unsigned long		poll_invoked;
 	unsigned long		poll_success;
 
+	/* tag allocations that did not get a tag on the first try */
+	unsigned long		tag_throttled;
+	unsigned long		tag_nowait_fail;
+	unsigned long		tag_waited;
+	unsigned long		tag_slept;
+
 #ifdef CONFIG_BLK_DEBUG_FS
 	struct dentry		*debugfs_dir;
 	struct dentry		*sched_debugfs_dir;
@@ -251,6 +251,9 @@ struct request {
 
 	ktime_t			lat_hist_io_start;
 	int			lat_hist_enabled;
+	/* doorbell and completion interrupt times, for per phase latency */
+	ktime_t			lat_hist_io_doorbell;
+	ktime_t			lat_hist_io_compl;
 };
 
 static inline bool blk_op_is_scsi(unsigned int op)
@@ -489,6 +492,12 @@ struct request_queue {
 	 */
 	unsigned long		queue_flags;
 
+	/*
+	 * percentage of the device's fast write buffer (e.g. an SLC cache)
+	 * still free, 100 if the device doesn't report it
+	 */
+	unsigned int		write_buffer_avail;
+
 	/*
 	 * ida allocated id for this queue.  Used to index queues from
 	 * ioctx.
@@ -1247,6 +1256,8 @@ extern void blk_queue_rq_timed_out(struct request_queue *, rq_timed_out_fn *);
 extern void blk_queue_rq_timeout(struct request_queue *, unsigned int);
 extern void blk_queue_flush_queueable(struct request_queue *q, bool queueable);
 extern void blk_queue_write_cache(struct request_queue *q, bool enabled, bool fua);
+extern void blk_queue_write_buffer_avail(struct request_queue *q,
+					 unsigned int pct);
 
 /*
  * Number of physical segments as sent to the device.
@@ -31,6 +31,8 @@ void cpufreq_times_record_transition(struct cpufreq_policy *policy,
                                      unsigned int new_freq);
 void cpufreq_task_times_remove_uids(uid_t uid_start, uid_t uid_end);
 int single_uid_time_in_state_open(struct inode *inode, struct file *file);
+u64 cpufreq_task_cpu_energy(struct task_struct *p);
+void cpufreq_times_energy_model_ready(void);
 #else
 static inline void cpufreq_task_times_init(struct task_struct *p) {}
 static inline void cpufreq_task_times_alloc(struct task_struct *p) {}
@@ -42,5 +44,10 @@ static inline void cpufreq_times_record_transition(
 	struct cpufreq_policy *policy, unsigned int new_freq) {}
 static inline void cpufreq_task_times_remove_uids(uid_t uid_start,
 						  uid_t uid_end) {}
+static inline u64 cpufreq_task_cpu_energy(struct task_struct *p)
+{
+	return 0;
+}
+static inline void cpufreq_times_energy_model_ready(void) {}
 #endif /* CONFIG_CPU_FREQ_TIMES */
 #endif /* _LINUX_CPUFREQ_TIMES_H */
@@ -26,6 +26,7 @@
 
 #define NULL_ADDR		((block_t)0)	/* used as block_t addresses */
 #define NEW_ADDR		((block_t)-1)	/* used as block_t addresses */
+#define COMPRESS_ADDR		((block_t)-3)	/* compressed cluster head */
 
 #define F2FS_BYTES_TO_BLK(bytes)	((bytes) >> F2FS_BLKSIZE_BITS)
 #define F2FS_BLK_TO_BYTES(blk)		((blk) << F2FS_BLKSIZE_BITS)
@@ -544,6 +545,31 @@ enum {
 
 #define S_SHIFT 12
 
+/*
+ * Compressed clusters: F2FS_CLUSTER_PAGES aligned pages sharing one dnode.
+ * The first address of a compressed cluster is COMPRESS_ADDR, the next
+ * ones point to the compressed blocks and the rest are NULL_ADDR. The
+ * compressed blocks start with the header below. Clusters which do not
+ * compress, or which cross a dnode boundary, are kept as plain blocks.
+ */
+#define F2FS_LOG_CLUSTER_PAGES	2
+#define F2FS_CLUSTER_PAGES	(1 << F2FS_LOG_CLUSTER_PAGES)
+#define F2FS_COMPRESS_MAGIC	0xF2F5C0DE
+
+enum {
+	F2FS_COMPRESS_LZ4,
+	F2FS_COMPRESS_MAX
+};
+
+struct f2fs_compress_header {
+	__le32 magic;			/* F2FS_COMPRESS_MAGIC */
+	__le32 clen;			/* compressed bytes after header */
+	__le32 chksum;			/* crc32 of the compressed bytes */
+	__u8 algorithm;			/* F2FS_COMPRESS_* */
+	__u8 nr_pages;			/* pages stored in the cluster */
+	__le16 reserved;
+} __packed;
+
 #define	F2FS_DEF_PROJID		0	/* default project ID */
 
 #endif  /* _LINUX_F2FS_FS_H */
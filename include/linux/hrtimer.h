@@ -341,6 +341,8 @@ extern void hrtimers_resume(void);
 
 DECLARE_PER_CPU(struct tick_device, tick_cpu_device);
 
+extern unsigned int sysctl_hrtimer_align_ns;
+
 
 /* Exported timer functions: */
 
@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _LINUX_LAUNCH_READAHEAD_H
+#define _LINUX_LAUNCH_READAHEAD_H
+
+#include <linux/fs.h>
+#include <linux/sched.h>
+
+#ifdef CONFIG_LAUNCH_READAHEAD
+/* tgid of the launch being recorded, 0 when not recording */
+extern pid_t launch_ra_tgid;
+
+void __launch_ra_record(struct inode *inode, pgoff_t start,
+			unsigned long nr);
+
+static inline void launch_ra_record(struct inode *inode, pgoff_t start,
+				    unsigned long nr)
+{
+	pid_t tgid = READ_ONCE(launch_ra_tgid);
+
+	if (likely(!tgid) || current->tgid != tgid)
+		return;
+
+	__launch_ra_record(inode, start, nr);
+}
+#else
+static inline void launch_ra_record(struct inode *inode, pgoff_t start,
+				    unsigned long nr)
+{
+}
+#endif
+
+#endif /* _LINUX_LAUNCH_READAHEAD_H */
@@ -214,6 +214,10 @@ struct mem_cgroup {
 	/* memory.events */
 	struct cgroup_file events_file;
 
+	/* memory.reclaim: pages freed on request and time spent doing so */
+	atomic_long_t proactive_reclaimed;
+	atomic64_t proactive_reclaim_ns;
+
 	/* protect arrays of thresholds */
 	struct mutex thresholds_lock;
 
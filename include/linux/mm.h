@@ -140,6 +140,7 @@ extern int mmap_rnd_compat_bits __read_mostly;
 #define DEFAULT_MAX_MAP_COUNT	(USHRT_MAX - MAPCOUNT_ELF_CORE_MARGIN)
 
 extern int sysctl_max_map_count;
+extern int sysctl_fork_skip_pagecache;
 
 extern unsigned long sysctl_user_reserve_kbytes;
 extern unsigned long sysctl_admin_reserve_kbytes;
@@ -2842,6 +2843,9 @@ static inline void setup_nr_node_ids(void) {}
 #endif
 
 extern int want_old_faultaround_pte;
+#ifdef CONFIG_ADAPTIVE_FAULT_AROUND
+extern unsigned long vma_fault_around_bytes(struct vm_area_struct *vma);
+#endif
 
 #ifdef CONFIG_PROCESS_RECLAIM
 struct reclaim_param {
@@ -2855,6 +2859,13 @@ struct reclaim_param {
 };
 extern struct reclaim_param reclaim_task_anon(struct task_struct *task,
 		int nr_to_reclaim);
+
+static inline void mm_count_swap_refault(struct mm_struct *mm)
+{
+	atomic_long_inc(&mm->swap_refaults);
+}
+#else
+static inline void mm_count_swap_refault(struct mm_struct *mm) { }
 #endif
 
 #endif /* __KERNEL__ */
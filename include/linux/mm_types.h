@@ -342,6 +342,9 @@ struct vm_area_struct {
 	void * vm_private_data;		/* was vm_pte (shared mem) */
 
 	atomic_long_t swap_readahead_info;
+#ifdef CONFIG_ADAPTIVE_FAULT_AROUND
+	atomic_long_t fault_around_info; /* last window, see do_fault_around() */
+#endif
 #ifndef CONFIG_MMU
 	struct vm_region *vm_region;	/* NOMMU mapping region */
 #endif
@@ -522,6 +525,17 @@ struct mm_struct {
 #endif
 #ifdef CONFIG_MSM_APP_SETTINGS
 	int app_setting;
+#endif
+#ifdef CONFIG_LRU_PT_AGING
+	/* on the list of mms walked by page table aging */
+	struct list_head lru_pt_aging_list;
+#endif
+#ifdef CONFIG_PROCESS_RECLAIM
+	/* anon pages faulted back in from swap */
+	atomic_long_t swap_refaults;
+	/* refault count and pages reclaimed at the last process reclaim */
+	unsigned long reclaim_refault_snap;
+	unsigned long reclaim_last_nr;
 #endif
 	struct work_struct async_put_work;
 
@@ -59,6 +59,8 @@ struct devfreq_msm_adreno_tz_data {
 	bool is_64;
 	bool disable_busy_time_burst;
 	bool ctxt_aware_enable;
+	/* Frequency that meets the pending frame deadline, 0 if none */
+	unsigned long deadline_freq;
 };
 
 struct msm_adreno_extended_profile {
@@ -1070,6 +1070,22 @@ int gsi_get_evt_ring_cfg(unsigned long evt_ring_hdl,
 int gsi_set_evt_ring_cfg(unsigned long evt_ring_hdl,
 		struct gsi_evt_ring_props *props, union gsi_evt_scratch *scr);
 
+/**
+ * gsi_set_evt_ring_int_mod - Peripheral should call this function to
+ * change the interrupt moderation of an allocated event ring. Unlike
+ * gsi_set_evt_ring_cfg this does not reset the ring and may be called
+ * from atomic context while the ring is in use.
+ *
+ * @evt_ring_hdl:  Client handle previously obtained from
+ *             gsi_alloc_evt_ring
+ * @int_modt:      moderation timer in 32KHz clock cycles
+ * @int_modc:      moderation counter, must be non-zero
+ *
+ * @Return gsi_status
+ */
+int gsi_set_evt_ring_int_mod(unsigned long evt_ring_hdl, uint16_t int_modt,
+		uint8_t int_modc);
+
 /**
  * gsi_alloc_channel - Peripheral should call this function to
  * allocate a channel
@@ -1668,6 +1684,12 @@ static inline int gsi_set_evt_ring_cfg(unsigned long evt_ring_hdl,
 	return -GSI_STATUS_UNSUPPORTED_OP;
 }
 
+static inline int gsi_set_evt_ring_int_mod(unsigned long evt_ring_hdl,
+		uint16_t int_modt, uint8_t int_modc)
+{
+	return -GSI_STATUS_UNSUPPORTED_OP;
+}
+
 static inline int gsi_configure_regs(
 	phys_addr_t per_base_addr, enum gsi_ver ver)
 {
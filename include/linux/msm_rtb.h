@@ -28,6 +28,9 @@ enum logk_event_type {
 	LOGK_L2CPREAD = 7,
 	LOGK_L2CPWRITE = 8,
 	LOGK_IRQ = 9,
+	LOGK_SCHED = 10,
+	LOGK_CPUFREQ = 11,
+	LOGK_IDLE = 12,
 };
 
 #define LOGTYPE_NOPC 0x80
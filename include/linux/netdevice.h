@@ -2831,6 +2831,8 @@ struct softnet_data {
 	unsigned int		time_squeeze;
 	unsigned int		received_rps;
 	unsigned int            gro_coalesced;
+	unsigned int		rps_batched;
+	unsigned int		rps_batch_locks;
 
 #ifdef CONFIG_RPS
 	struct softnet_data	*rps_ipi_list;
@@ -3944,6 +3946,8 @@ void netdev_stats_to_stats64(struct rtnl_link_stats64 *stats64,
 			     const struct net_device_stats *netdev_stats);
 
 extern int		netdev_max_backlog;
+extern unsigned int	netdev_rps_batch;
+#define NETDEV_RPS_BATCH_MAX	64
 extern int		netdev_tstamp_prequeue;
 extern int		weight_p;
 extern int		dev_weight_rx_bias;
@@ -30,6 +30,9 @@
 
 struct wake_irq;
 
+/* Hold time buckets: <1ms, <10ms, <100ms, <1s, <10s and the rest */
+#define WS_HOLD_HIST_BUCKETS	6
+
 /**
  * struct wakeup_source - Representation of wakeup sources
  *
@@ -48,6 +51,7 @@ struct wake_irq;
  * @relax_count: Number of times the wakeup source was deactivated.
  * @expire_count: Number of times the wakeup source's timeout has expired.
  * @wakeup_count: Number of times the wakeup source might abort suspend.
+ * @hold_hist: Activations by how long they were held, in decade buckets.
  * @active: Status of the wakeup source.
  * @has_timeout: The wakeup source has been activated with a timeout.
  */
@@ -68,6 +72,7 @@ struct wakeup_source {
 	unsigned long		relax_count;
 	unsigned long		expire_count;
 	unsigned long		wakeup_count;
+	unsigned int		hold_hist[WS_HOLD_HIST_BUCKETS];
 	bool			active:1;
 	bool			autosleep_enabled:1;
 };
@@ -1,6 +1,7 @@
 #ifndef _LINUX_PSI_H
 #define _LINUX_PSI_H
 
+#include <linux/err.h>
 #include <linux/jump_label.h>
 #include <linux/psi_types.h>
 #include <linux/sched.h>
@@ -24,6 +25,10 @@ void psi_memstall_leave(unsigned long *flags);
 
 int psi_show(struct seq_file *s, struct psi_group *group, enum psi_res res);
 
+struct psi_trigger *psi_system_trigger_create(char *buf, size_t nbytes,
+					      enum psi_res res);
+void psi_trigger_replace(void **trigger_ptr, struct psi_trigger *t);
+
 #ifdef CONFIG_CGROUPS
 int psi_cgroup_alloc(struct cgroup *cgrp);
 void psi_cgroup_free(struct cgroup *cgrp);
@@ -31,7 +36,6 @@ void cgroup_move_task(struct task_struct *p, struct css_set *to);
 
 struct psi_trigger *psi_trigger_create(struct psi_group *group,
 			char *buf, size_t nbytes, enum psi_res res);
-void psi_trigger_replace(void **trigger_ptr, struct psi_trigger *t);
 
 unsigned int psi_trigger_poll(void **trigger_ptr, struct file *file,
 			      poll_table *wait);
@@ -44,6 +48,14 @@ static inline void psi_init(void) {}
 static inline void psi_memstall_enter(unsigned long *flags) {}
 static inline void psi_memstall_leave(unsigned long *flags) {}
 
+static inline struct psi_trigger *psi_system_trigger_create(char *buf,
+				size_t nbytes, enum psi_res res)
+{
+	return ERR_PTR(-EOPNOTSUPP);
+}
+static inline void psi_trigger_replace(void **trigger_ptr,
+				       struct psi_trigger *t) {}
+
 #ifdef CONFIG_CGROUPS
 static inline int psi_cgroup_alloc(struct cgroup *cgrp)
 {
@@ -538,6 +538,11 @@ extern int register_cpu_cycle_counter_cb(struct cpu_cycle_counter_cb *cb);
 extern void sched_set_io_is_busy(int val);
 extern int sched_set_group_id(struct task_struct *p, unsigned int group_id);
 extern unsigned int sched_get_group_id(struct task_struct *p);
+extern int sched_set_frame_hint(struct task_struct *p, u64 period_ns,
+				u64 deadline_ns);
+extern int sched_get_frame_hint(struct task_struct *p, u64 *period_ns,
+				u64 *remaining_ns);
+extern bool sched_frame_hint_active(void);
 extern int sched_set_init_task_load(struct task_struct *p, int init_load_pct);
 extern u32 sched_get_init_task_load(struct task_struct *p);
 extern void sched_update_cpu_freq_min_max(const cpumask_t *cpus, u32 fmin,
@@ -582,6 +587,10 @@ struct ravg {
 	 * used for prediction
 	 *
 	 * 'demand_scaled' represents task's demand scaled to 1024
+	 *
+	 * 'long_pred' is the long horizon average of the task's busy time
+	 *
+	 * 'window_size' is the window size the history was recorded with
 	 */
 	u64 mark_start;
 	u32 sum, demand;
@@ -594,6 +603,8 @@ struct ravg {
 	u8 busy_buckets[NUM_BUSY_BUCKETS];
 	u16 demand_scaled;
 	u16 pred_demand_scaled;
+	u32 long_pred;
+	u32 window_size;
 };
 #else
 static inline void sched_exit(struct task_struct *p) { }
@@ -608,6 +619,10 @@ static inline int sched_set_boost(int enable)
 {
 	return -EINVAL;
 }
+static inline bool sched_frame_hint_active(void)
+{
+	return false;
+}
 static inline void free_task_load_ptrs(struct task_struct *p) { }
 
 static inline void sched_update_cpu_freq_min_max(const cpumask_t *cpus,
@@ -1012,6 +1027,7 @@ struct task_struct {
 #ifdef CONFIG_CPU_FREQ_TIMES
 	u64				*time_in_state;
 	unsigned int			max_state;
+	u64				cpu_energy;
 #endif
 	struct prev_cputime		prev_cputime;
 #ifdef CONFIG_VIRT_CPU_ACCOUNTING_GEN
@@ -24,6 +24,7 @@ void core_ctl_check(u64 wallclock);
 int core_ctl_set_boost(bool boost);
 void core_ctl_notifier_register(struct notifier_block *n);
 void core_ctl_notifier_unregister(struct notifier_block *n);
+void core_ctl_kick(int cpu);
 #else
 static inline void core_ctl_check(u64 wallclock) {}
 static inline int core_ctl_set_boost(bool boost)
@@ -32,5 +33,6 @@ static inline int core_ctl_set_boost(bool boost)
 }
 static inline void core_ctl_notifier_register(struct notifier_block *n) {}
 static inline void core_ctl_notifier_unregister(struct notifier_block *n) {}
+static inline void core_ctl_kick(int cpu) {}
 #endif
 #endif
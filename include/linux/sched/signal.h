@@ -203,6 +203,7 @@ struct signal_struct {
 #endif
 #ifdef CONFIG_TASKSTATS
 	struct taskstats *stats;
+	u64 cpu_energy;			/* of the exited threads */
 #endif
 #ifdef CONFIG_AUDIT
 	unsigned audit_tty;
@@ -44,6 +44,8 @@ extern unsigned int sysctl_sched_walt_rotate_big_tasks;
 extern unsigned int sysctl_sched_min_task_util_for_boost;
 extern unsigned int sysctl_sched_min_task_util_for_colocation;
 extern unsigned int sysctl_sched_little_cluster_coloc_fmin_khz;
+extern unsigned int sysctl_sched_ravg_window_vsync_hz;
+extern unsigned int sysctl_sched_long_pred_shift;
 
 extern int
 walt_proc_update_handler(struct ctl_table *table, int write,
@@ -141,6 +143,9 @@ extern int sysctl_schedstats(struct ctl_table *table, int write,
 extern int sched_little_cluster_coloc_fmin_khz_handler(struct ctl_table *table,
 					int write, void __user *buffer,
 					size_t *lenp, loff_t *ppos);
+extern int sched_ravg_window_vsync_handler(struct ctl_table *table,
+					int write, void __user *buffer,
+					size_t *lenp, loff_t *ppos);
 #endif
 
 #endif /* _LINUX_SCHED_SYSCTL_H */
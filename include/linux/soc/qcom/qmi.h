@@ -231,6 +231,12 @@ struct qmi_handle {
 	void *recv_buf;
 	size_t recv_buf_size;
 
+	void *decode_buf;
+	size_t decode_buf_size;
+
+	void *send_buf;
+	size_t send_buf_size;
+
 	struct list_head lookups;
 	struct list_head lookup_results;
 	struct list_head services;
@@ -265,6 +271,9 @@ ssize_t qmi_send_indication(struct qmi_handle *qmi, struct sockaddr_qrtr *sq,
 void *qmi_encode_message(int type, unsigned int msg_id, size_t *len,
 			 unsigned int txn_id, struct qmi_elem_info *ei,
 			 const void *c_struct);
+ssize_t qmi_encode_message_buf(void *buf, size_t len, int type,
+			       unsigned int msg_id, unsigned int txn_id,
+			       struct qmi_elem_info *ei, const void *c_struct);
 
 int qmi_decode_message(const void *buf, size_t len,
 		       struct qmi_elem_info *ei, void *c_struct);
@@ -367,6 +367,15 @@ extern unsigned long shrink_all_memory(unsigned long nr_pages);
 extern int vm_swappiness;
 extern int sysctl_swap_ratio;
 extern int sysctl_swap_ratio_enable;
+#ifdef CONFIG_LRU_PT_AGING
+extern int sysctl_lru_pt_aging;
+extern int sysctl_lru_pt_aging_interval_ms;
+extern void lru_pt_aging_add_mm(struct mm_struct *mm);
+extern void lru_pt_aging_del_mm(struct mm_struct *mm);
+#else
+static inline void lru_pt_aging_add_mm(struct mm_struct *mm) { }
+static inline void lru_pt_aging_del_mm(struct mm_struct *mm) { }
+#endif
 extern int remove_mapping(struct address_space *mapping, struct page *page);
 extern unsigned long vm_total_pages;
 
@@ -59,6 +59,7 @@ enum vm_event_item { PGPGIN, PGPGOUT, PGPGOUTCLEAN, PSWPIN, PSWPOUT,
 		COMPACTSTALL, COMPACTFAIL, COMPACTSUCCESS,
 		KCOMPACTD_WAKE,
 		KCOMPACTD_MIGRATE_SCANNED, KCOMPACTD_FREE_SCANNED,
+		KCOMPACTD_PROACTIVE,
 #endif
 #ifdef CONFIG_HUGETLB_PAGE
 		HTLB_BUDDY_PGALLOC, HTLB_BUDDY_PGALLOC_FAIL,
@@ -112,6 +113,12 @@ enum vm_event_item { PGPGIN, PGPGOUT, PGPGOUTCLEAN, PSWPIN, PSWPOUT,
 #endif
 #ifdef CONFIG_SPECULATIVE_PAGE_FAULT
 		SPECULATIVE_PGFAULT,
+		SPF_ABORT_VMA_CHANGED,
+		SPF_ABORT_VMA_NOTSUP,
+		SPF_ABORT_VMA_ACCESS,
+		SPF_ABORT_PMD_CHANGED,
+		SPF_ABORT_PTE_LOCK,
+		SPF_ABORT_NO_PGTABLE,
 #endif
 		NR_VM_EVENT_ITEMS
 };
@@ -9,6 +9,7 @@
 #include <linux/atomic.h>
 
 extern int sysctl_stat_interval;
+extern int sysctl_stat_skip_idle;
 
 #ifdef CONFIG_VM_EVENT_COUNTERS
 /*
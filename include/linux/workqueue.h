@@ -317,7 +317,8 @@ enum {
 	 * contribute significantly to power-consumption are identified and
 	 * marked with this flag and enabling the power_efficient mode
 	 * leads to noticeable power saving at the cost of small
-	 * performance disadvantage.
+	 * performance disadvantage.  workqueue.power_efficient_cpus can
+	 * further confine them, e.g. to the little cluster.
 	 *
 	 * http://thread.gmane.org/gmane.linux.kernel/1480396
 	 */
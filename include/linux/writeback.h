@@ -350,6 +350,8 @@ extern unsigned long vm_dirty_bytes;
 extern unsigned int dirty_writeback_interval;
 extern unsigned int dirty_expire_interval;
 extern unsigned int dirtytime_expire_interval;
+#define DIRTY_WRITEBACK_INODES_MAX	16
+extern int dirty_writeback_inodes;
 extern int vm_highmem_is_dirtyable;
 extern int block_dump;
 extern int laptop_mode;
@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * page_pool.h - recycling of DMA mapped RX pages
+ *
+ * A driver allocates its RX pages from a pool, hands them to the stack
+ * as skb frags and gives them back to the pool right after. The pool
+ * keeps one reference and the DMA mapping of every page it owns, and
+ * hands a page out again once all other references, taken by the skbs
+ * built on top of it, are gone. Consumers further up such as rmnet do
+ * not need to know about the pool, dropping their page reference is
+ * all it takes to return the page.
+ */
+#ifndef _NET_PAGE_POOL_H
+#define _NET_PAGE_POOL_H
+
+#include <linux/dma-mapping.h>
+#include <linux/mm.h>
+#include <linux/spinlock.h>
+
+/* Pool maps pages on allocation and keeps them mapped while recycled */
+#define PP_FLAG_DMA_MAP		BIT(0)
+
+struct page_pool_params {
+	unsigned int		flags;
+	unsigned int		order;
+	/* Number of pages parked waiting for the stack to release them */
+	unsigned int		pool_size;
+	struct device		*dev;
+	enum dma_data_direction	dma_dir;
+};
+
+/* alloc_slow is not serialized against itself, treat it as a hint */
+struct page_pool_stats {
+	/* Pages handed out again from the ring */
+	unsigned long		alloc_fast;
+	/* Pages that had to come from the page allocator */
+	unsigned long		alloc_slow;
+	/* Head of the ring still referenced by the stack */
+	unsigned long		recycle_busy;
+	/* Pages released because the ring was full */
+	unsigned long		ring_full;
+};
+
+struct page_pool {
+	struct page_pool_params	p;
+	spinlock_t		ring_lock;
+	unsigned int		ring_mask;
+	unsigned int		head;
+	unsigned int		tail;
+	struct page		**ring;
+	struct page_pool_stats	stats;
+};
+
+#ifdef CONFIG_PAGE_POOL
+struct page_pool *page_pool_create(const struct page_pool_params *params);
+void page_pool_destroy(struct page_pool *pool);
+struct page *page_pool_alloc_pages(struct page_pool *pool, gfp_t gfp);
+void page_pool_put_page(struct page_pool *pool, struct page *page);
+#else
+static inline struct page_pool *
+page_pool_create(const struct page_pool_params *params)
+{
+	return ERR_PTR(-EOPNOTSUPP);
+}
+
+static inline void page_pool_destroy(struct page_pool *pool)
+{
+}
+
+static inline struct page *page_pool_alloc_pages(struct page_pool *pool,
+						 gfp_t gfp)
+{
+	return NULL;
+}
+
+static inline void page_pool_put_page(struct page_pool *pool,
+				      struct page *page)
+{
+}
+#endif /* CONFIG_PAGE_POOL */
+
+static inline struct page *page_pool_dev_alloc_pages(struct page_pool *pool)
+{
+	return page_pool_alloc_pages(pool, GFP_ATOMIC | __GFP_NOWARN);
+}
+
+static inline unsigned int page_pool_buf_size(const struct page_pool *pool)
+{
+	return PAGE_SIZE << pool->p.order;
+}
+
+static inline dma_addr_t page_pool_get_dma_addr(struct page *page)
+{
+	return (dma_addr_t)page_private(page);
+}
+
+#endif /* _NET_PAGE_POOL_H */
@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _NET_UID_TRAFFIC_H
+#define _NET_UID_TRAFFIC_H
+
+#include <linux/netdevice.h>
+#include <linux/netlink.h>
+#include <linux/skbuff.h>
+#include <net/dst.h>
+#include <net/sock.h>
+
+#ifdef CONFIG_NET_UID_TRAFFIC_STATS
+void __uid_traffic_account(struct sock *sk, const struct sk_buff *skb,
+			   bool tx);
+int uid_traffic_rcv_msg(struct sk_buff *skb, struct nlmsghdr *nlh);
+
+/* sk_filter() also runs for netlink, unix and packet sockets */
+static inline void uid_traffic_rx(struct sock *sk, const struct sk_buff *skb)
+{
+	if ((sk->sk_family == AF_INET || sk->sk_family == AF_INET6) &&
+	    skb->skb_iif != LOOPBACK_IFINDEX)
+		__uid_traffic_account(sk, skb, false);
+}
+
+static inline void uid_traffic_tx(struct sock *sk, const struct sk_buff *skb)
+{
+	if (sk && !(skb_dst(skb)->dev->flags & IFF_LOOPBACK))
+		__uid_traffic_account(sk, skb, true);
+}
+#else
+static inline void uid_traffic_rx(struct sock *sk, const struct sk_buff *skb)
+{
+}
+
+static inline void uid_traffic_tx(struct sock *sk, const struct sk_buff *skb)
+{
+}
+
+static inline int uid_traffic_rcv_msg(struct sk_buff *skb,
+				      struct nlmsghdr *nlh)
+{
+	return -EOPNOTSUPP;
+}
+#endif
+
+#endif /* _NET_UID_TRAFFIC_H */
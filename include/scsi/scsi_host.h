@@ -127,6 +127,15 @@ struct scsi_host_template {
 	 */
 	int (* queuecommand)(struct Scsi_Host *, struct scsi_cmnd *);
 
+	/*
+	 * Reap completed commands of hardware queue @queue_num without
+	 * waiting for the interrupt, used by blk_poll() on scsi-mq hosts.
+	 * Returns the number of commands completed.
+	 *
+	 * STATUS: OPTIONAL
+	 */
+	int (* mq_poll)(struct Scsi_Host *shost, unsigned int queue_num);
+
 	/*
 	 * This is an error handling strategy routine.  You don't need to
 	 * define one of these if you don't want to - there is a default
@@ -10,8 +10,57 @@
  * GNU General Public License for more details.
  */
 
+#ifndef __SOC_QCOM_BOOT_STATS_H
+#define __SOC_QCOM_BOOT_STATS_H
+
+#include <linux/ktime.h>
+#include <linux/types.h>
+
 #ifdef CONFIG_MSM_BOOT_STATS
 int boot_stats_init(void);
 #else
 static inline int boot_stats_init(void) { return 0; }
 #endif
+
+enum boot_event_type {
+	BOOT_EVENT_INITCALL,
+	BOOT_EVENT_PROBE,
+	BOOT_EVENT_PROBE_DEFER,
+	BOOT_EVENT_PIL_LOAD,
+	BOOT_EVENT_PIL_AUTH,
+	BOOT_EVENT_MOUNT,
+};
+
+#define BOOT_EVENT_NAME_LEN	48
+
+/*
+ * Record layout of the boot_events debugfs file, an array of these in the
+ * order they completed. Times are ktime_get() nanoseconds.
+ */
+struct boot_event {
+	u64 start_ns;
+	u64 duration_ns;
+	u32 type;
+	u32 cpu;
+	char name[BOOT_EVENT_NAME_LEN];
+};
+
+#ifdef CONFIG_MSM_BOOT_EVENT_LOG
+void boot_event_record(enum boot_event_type type, const char *name,
+		       ktime_t start);
+void boot_event_record_fn(enum boot_event_type type, void *fn,
+			  ktime_t start);
+
+static inline ktime_t boot_event_start(void)
+{
+	return ktime_get();
+}
+#else
+static inline void boot_event_record(enum boot_event_type type,
+				     const char *name, ktime_t start) { }
+static inline void boot_event_record_fn(enum boot_event_type type, void *fn,
+					ktime_t start) { }
+static inline ktime_t boot_event_start(void) { return 0; }
+#endif
+
+#endif /* __SOC_QCOM_BOOT_STATS_H */
@@ -644,6 +644,35 @@ TRACE_EVENT(sugov_next_freq,
 		      __entry->freq)
 );
 
+TRACE_EVENT(sugov_switch_decision,
+	    TP_PROTO(unsigned int cpu, unsigned int from, unsigned int to,
+		     u64 cost_ns, u64 hold_ns, bool taken),
+	    TP_ARGS(cpu, from, to, cost_ns, hold_ns, taken),
+	    TP_STRUCT__entry(
+		    __field(	unsigned int,	cpu)
+		    __field(	unsigned int,	from)
+		    __field(	unsigned int,	to)
+		    __field(	u64,		cost_ns)
+		    __field(	u64,		hold_ns)
+		    __field(	bool,		taken)
+	    ),
+	    TP_fast_assign(
+		    __entry->cpu = cpu;
+		    __entry->from = from;
+		    __entry->to = to;
+		    __entry->cost_ns = cost_ns;
+		    __entry->hold_ns = hold_ns;
+		    __entry->taken = taken;
+	    ),
+	    TP_printk("cpu=%u from=%u to=%u cost_ns=%llu hold_ns=%llu taken=%d",
+		      __entry->cpu,
+		      __entry->from,
+		      __entry->to,
+		      __entry->cost_ns,
+		      __entry->hold_ns,
+		      __entry->taken)
+);
+
 
 TRACE_EVENT(bw_hwmon_meas,
 
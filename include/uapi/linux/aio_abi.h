@@ -52,8 +52,11 @@ enum {
  *
  * IOCB_FLAG_RESFD - Set if the "aio_resfd" member of the "struct iocb"
  *                   is valid.
+ * IOCB_FLAG_OFFLOAD - Set to run a buffered read or write on a kernel
+ *                   worker instead of in io_submit().
  */
 #define IOCB_FLAG_RESFD		(1 << 0)
+#define IOCB_FLAG_OFFLOAD	(1 << 2)
 
 /* read() from /dev/aio returns these structures. */
 struct io_event {
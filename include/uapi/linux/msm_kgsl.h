@@ -1645,4 +1645,20 @@ struct kgsl_gpu_sparse_command {
 #define IOCTL_KGSL_GPU_SPARSE_COMMAND \
 	_IOWR(KGSL_IOC_TYPE, 0x55, struct kgsl_gpu_sparse_command)
 
+/**
+ * struct kgsl_frame_deadline - Argument for IOCTL_KGSL_FRAME_DEADLINE
+ * @deadline: CLOCK_MONOTONIC time in nanoseconds by which the frame should be
+ * complete, usually the next vsync
+ * @context_id: Context the frame was submitted on
+ * @timestamp: Timestamp of the last submission of the frame
+ */
+struct kgsl_frame_deadline {
+	uint64_t deadline;
+	unsigned int context_id;
+	unsigned int timestamp;
+};
+
+#define IOCTL_KGSL_FRAME_DEADLINE \
+	_IOW(KGSL_IOC_TYPE, 0x56, struct kgsl_frame_deadline)
+
 #endif /* _UAPI_MSM_KGSL_H */
@@ -6,12 +6,31 @@
 
 #define SOCK_DIAG_BY_FAMILY 20
 #define SOCK_DESTROY 21
+#define SOCK_DIAG_UID_STATS 22
 
 struct sock_diag_req {
 	__u8	sdiag_family;
 	__u8	sdiag_protocol;
 };
 
+/* SOCK_DIAG_UID_STATS request, must be sent with NLM_F_DUMP */
+struct uid_traffic_req {
+	__u32	flags;
+};
+
+/* Report absolute totals and leave the delta base untouched */
+#define UID_TRAFFIC_F_TOTALS	0x1
+
+/* One per UID with traffic since the last delta dump */
+struct uid_traffic_msg {
+	__u32	uid;
+	__u32	pad;
+	__u64	rx_bytes;
+	__u64	rx_packets;
+	__u64	tx_bytes;
+	__u64	tx_packets;
+};
+
 enum {
 	SK_MEMINFO_RMEM_ALLOC,
 	SK_MEMINFO_RCVBUF,
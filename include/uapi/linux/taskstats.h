@@ -194,6 +194,7 @@ enum {
 	TASKSTATS_TYPE_AGGR_PID,	/* contains pid + stats */
 	TASKSTATS_TYPE_AGGR_TGID,	/* contains tgid + stats */
 	TASKSTATS_TYPE_NULL,		/* contains nothing */
+	TASKSTATS_TYPE_CPU_ENERGY,	/* u64 in an aggr, power units x usec */
 	__TASKSTATS_TYPE_MAX,
 };
 
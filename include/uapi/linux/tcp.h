@@ -120,6 +120,7 @@ enum {
 #define TCP_FASTOPEN_CONNECT	30	/* Attempt FastOpen with connect */
 #define TCP_ULP			31	/* Attach a ULP to a TCP connection */
 #define TCP_MD5SIG_EXT		32	/* TCP MD5 Signature with extensions */
+#define TCP_ZEROCOPY_RECEIVE	35	/* Map receive queue pages to user */
 
 struct tcp_repair_opt {
 	__u32	opt_code;
@@ -248,6 +249,13 @@ enum {
 /* tcp_md5sig extension flags for TCP_MD5SIG_EXT */
 #define TCP_MD5SIG_FLAG_PREFIX		1	/* address prefix length */
 
+/* getsockopt(fd, IPPROTO_TCP, TCP_ZEROCOPY_RECEIVE, ...) */
+struct tcp_zerocopy_receive {
+	__u64 address;		/* in: address of mapping */
+	__u32 length;		/* in/out: number of bytes to map/mapped */
+	__u32 recv_skip_hint;	/* out: amount of bytes to skip */
+};
+
 struct tcp_md5sig {
 	struct __kernel_sockaddr_storage tcpm_addr;	/* address associated */
 	__u8	tcpm_flags;				/* extension flags */
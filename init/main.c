@@ -90,6 +90,7 @@
 #include <linux/cache.h>
 #include <linux/rodata_test.h>
 #include <linux/scs.h>
+#include <soc/qcom/boot_stats.h>
 
 #include <asm/io.h>
 #include <asm/setup.h>
@@ -814,16 +815,19 @@ static int __init_or_module do_one_initcall_debug(initcall_t fn)
 int __init_or_module do_one_initcall(initcall_t fn)
 {
 	int count = preempt_count();
+	ktime_t start;
 	int ret;
 	char msgbuf[64];
 
 	if (initcall_blacklisted(fn))
 		return -EPERM;
 
+	start = boot_event_start();
 	if (initcall_debug)
 		ret = do_one_initcall_debug(fn);
 	else
 		ret = fn();
+	boot_event_record_fn(BOOT_EVENT_INITCALL, fn, start);
 
 	msgbuf[0] = 0;
 
@@ -136,6 +136,9 @@ struct cpuset {
 
 	/* for custom sched domain */
 	int relax_domain_level;
+
+	/* timer slack forced on member tasks, 0 leaves their own slack */
+	u64 timer_slack_ns;
 };
 
 static inline struct cpuset *css_cs(struct cgroup_subsys_state *css)
@@ -1324,6 +1327,46 @@ static void update_tasks_flags(struct cpuset *cs)
 	css_task_iter_end(&it);
 }
 
+/*
+ * cpuset_update_task_timer_slack - apply a cpuset timer slack to @tsk
+ * @slack_ns:	slack of the cpuset @tsk is in now
+ * @old_ns:	slack of the cpuset, or setting, @tsk was under before
+ *
+ * A task leaving a cpuset which forced a slack on it falls back to its
+ * default slack, anything set through prctl() before is lost.
+ */
+static void cpuset_update_task_timer_slack(u64 slack_ns, u64 old_ns,
+					   struct task_struct *tsk)
+{
+	if (!slack_ns && !old_ns)
+		return;
+
+	task_lock(tsk);
+	tsk->timer_slack_ns = slack_ns ? : tsk->default_timer_slack_ns;
+	task_unlock(tsk);
+}
+
+static int update_timer_slack(struct cpuset *cs, u64 slack_ns)
+{
+	struct css_task_iter it;
+	struct task_struct *task;
+	u64 old_ns = cs->timer_slack_ns;
+
+	if (slack_ns > NSEC_PER_SEC)
+		return -EINVAL;
+	if (old_ns == slack_ns)
+		return 0;
+
+	cs->timer_slack_ns = slack_ns;
+
+	css_task_iter_start(&cs->css, 0, &it);
+	while ((task = css_task_iter_next(&it)))
+		cpuset_update_task_timer_slack(slack_ns, old_ns, task);
+	css_task_iter_end(&it);
+
+	return 0;
+}
+
 /*
  * update_flag - read a 0 or a 1 in a file and update associated flag
  * bit:		the bit to update (see cpuset_flagbits_t)
@@ -1572,6 +1615,8 @@ static void cpuset_attach(struct cgroup_taskset *tset)
 
 		cpuset_change_task_nodemask(task, &cpuset_attach_nodemask_to);
 		cpuset_update_task_spread_flag(cs, task);
+		cpuset_update_task_timer_slack(cs->timer_slack_ns,
+					       oldcs->timer_slack_ns, task);
 	}
 
 	/*
@@ -1628,6 +1673,7 @@ typedef enum {
 	FILE_MEMORY_PRESSURE,
 	FILE_SPREAD_PAGE,
 	FILE_SPREAD_SLAB,
+	FILE_TIMER_SLACK,
 } cpuset_filetype_t;
 
 static int cpuset_write_u64(struct cgroup_subsys_state *css, struct cftype *cft,
@@ -1668,6 +1714,9 @@ static int cpuset_write_u64(struct cgroup_subsys_state *css, struct cftype *cft,
 	case FILE_SPREAD_SLAB:
 		retval = update_flag(CS_SPREAD_SLAB, cs, val);
 		break;
+	case FILE_TIMER_SLACK:
+		retval = update_timer_slack(cs, val);
+		break;
 	default:
 		retval = -EINVAL;
 		break;
@@ -1827,6 +1876,8 @@ static u64 cpuset_read_u64(struct cgroup_subsys_state *css, struct cftype *cft)
 		return is_spread_page(cs);
 	case FILE_SPREAD_SLAB:
 		return is_spread_slab(cs);
+	case FILE_TIMER_SLACK:
+		return cs->timer_slack_ns;
 	default:
 		BUG();
 	}
@@ -1946,6 +1997,13 @@ static struct cftype files[] = {
 		.private = FILE_SPREAD_SLAB,
 	},
 
+	{
+		.name = "timer_slack_ns",
+		.read_u64 = cpuset_read_u64,
+		.write_u64 = cpuset_write_u64,
+		.private = FILE_TIMER_SLACK,
+	},
+
 	{
 		.name = "memory_pressure_enabled",
 		.flags = CFTYPE_ONLY_ON_ROOT,
@@ -2120,6 +2178,15 @@ static void cpuset_bind(struct cgroup_subsys_state *root_css)
  */
 static void cpuset_fork(struct task_struct *task)
 {
+	/*
+	 * The parent's slack may be the forced one, don't let it become the
+	 * default the child falls back to when it leaves this cpuset.
+	 */
+	rcu_read_lock();
+	if (task_cs(task)->timer_slack_ns)
+		task->default_timer_slack_ns = current->default_timer_slack_ns;
+	rcu_read_unlock();
+
 	if (task_css_is_root(task, cpuset_cgrp_id))
 		return;
 
@@ -853,6 +853,11 @@ static struct mm_struct *mm_init(struct mm_struct *mm, struct task_struct *p,
 #endif
 	mm_init_uprobes_state(mm);
 	hugetlb_count_init(mm);
+#ifdef CONFIG_PROCESS_RECLAIM
+	atomic_long_set(&mm->swap_refaults, 0);
+	mm->reclaim_refault_snap = 0;
+	mm->reclaim_last_nr = 0;
+#endif
 
 	if (current->mm) {
 		mm->flags = current->mm->flags & MMF_INIT_MASK;
@@ -869,6 +874,7 @@ static struct mm_struct *mm_init(struct mm_struct *mm, struct task_struct *p,
 		goto fail_nocontext;
 
 	mm->user_ns = get_user_ns(user_ns);
+	lru_pt_aging_add_mm(mm);
 	return mm;
 
 fail_nocontext:
@@ -951,6 +957,7 @@ static inline void __mmput(struct mm_struct *mm)
 		list_del(&mm->mmlist);
 		spin_unlock(&mmlist_lock);
 	}
+	lru_pt_aging_del_mm(mm);
 	if (mm->binfmt)
 		module_put(mm->binfmt->module);
 	mmdrop(mm);
@@ -280,6 +280,24 @@ static struct {
 #define futex_queues   (__futex_data.queues)
 #define futex_hashsize (__futex_data.hashsize)
 
+/*
+ * Buckets per possible CPU. All processes share the table, so on systems
+ * running many heavily threaded processes a larger table makes unrelated
+ * futexes less likely to share a bucket lock.
+ */
+static unsigned long futex_buckets_per_cpu __initdata = 256;
+
+static int __init setup_futex_buckets(char *str)
+{
+	unsigned long n;
+
+	if (kstrtoul(str, 0, &n) || !n || n > 65536)
+		return 0;
+
+	futex_buckets_per_cpu = n;
+	return 1;
+}
+__setup("futex_buckets_per_cpu=", setup_futex_buckets);
 
 /*
  * Fault injections for futexes.
@@ -4181,7 +4199,8 @@ static int __init futex_init(void)
 #if CONFIG_BASE_SMALL
 	futex_hashsize = 16;
 #else
-	futex_hashsize = roundup_pow_of_two(256 * num_possible_cpus());
+	futex_hashsize = roundup_pow_of_two(futex_buckets_per_cpu *
+					    num_possible_cpus());
 #endif
 
 	futex_queues = alloc_large_system_hash("futex", sizeof(*futex_queues),
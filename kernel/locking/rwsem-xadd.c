@@ -18,6 +18,9 @@
 #include <linux/sched/wake_q.h>
 #include <linux/sched/debug.h>
 #include <linux/osq_lock.h>
+#include <linux/sched/clock.h>
+#include <linux/sched/topology.h>
+#include <linux/moduleparam.h>
 
 #include "rwsem.h"
 
@@ -366,6 +369,35 @@ static inline bool rwsem_try_write_lock_unqueued(struct rw_semaphore *sem)
 	}
 }
 
+/*
+ * Don't spin on a writer whose CPU currently delivers less than this
+ * percentage of the spinner's CPU capacity (frequency included): on
+ * big.LITTLE a big core spinning on a slow little core owner burns more
+ * than the sleep and wakeup it saves. 0 disables the check.
+ */
+static unsigned int rwsem_spin_capacity_pct;
+core_param(rwsem_spin_capacity_pct, rwsem_spin_capacity_pct, uint, 0644);
+
+/*
+ * Writers normally stop spinning as soon as readers own the rwsem. When
+ * set, a writer keeps spinning on reader ownership for up to this many
+ * nanoseconds per slowpath entry; the bound keeps a stream of readers from
+ * holding it off, after which it queues and blocks new readers as usual.
+ */
+static unsigned int rwsem_reader_spin_ns;
+core_param(rwsem_reader_spin_ns, rwsem_reader_spin_ns, uint, 0644);
+
+static inline bool rwsem_owner_too_slow(struct task_struct *owner)
+{
+	unsigned int pct = READ_ONCE(rwsem_spin_capacity_pct);
+
+	if (!pct)
+		return false;
+
+	return capacity_curr_of(task_cpu(owner)) * 100 <
+		capacity_curr_of(smp_processor_id()) * pct;
+}
+
 static inline bool rwsem_can_spin_on_owner(struct rw_semaphore *sem)
 {
 	struct task_struct *owner;
@@ -379,7 +411,9 @@ static inline bool rwsem_can_spin_on_owner(struct rw_semaphore *sem)
 	rcu_read_lock();
 	owner = READ_ONCE(sem->owner);
 	if (!owner || !is_rwsem_owner_spinnable(owner)) {
-		ret = !owner;	/* !owner is spinnable */
+		/* !owner is spinnable, readers if rwsem_reader_spin_ns */
+		ret = !owner || (owner == RWSEM_READER_OWNED &&
+				 READ_ONCE(rwsem_reader_spin_ns));
 		goto done;
 	}
 
@@ -387,19 +421,54 @@ static inline bool rwsem_can_spin_on_owner(struct rw_semaphore *sem)
 	 * As lock holder preemption issue, we both skip spinning if task is not
 	 * on cpu or its cpu is preempted
 	 */
-	ret = owner->on_cpu && !vcpu_is_preempted(task_cpu(owner));
+	ret = owner->on_cpu && !vcpu_is_preempted(task_cpu(owner)) &&
+		!rwsem_owner_too_slow(owner);
 done:
 	rcu_read_unlock();
 	return ret;
 }
 
+/*
+ * Spin while readers own the rwsem, until it looks free or @rspin_end,
+ * started on the first call, has passed.
+ */
+static bool rwsem_spin_on_readers(struct rw_semaphore *sem, u64 *rspin_end)
+{
+	unsigned int budget = READ_ONCE(rwsem_reader_spin_ns);
+	long count;
+
+	if (!budget)
+		return false;
+
+	if (!*rspin_end)
+		*rspin_end = local_clock() + budget;
+
+	/* the owner field keeps saying readers after the last one left */
+	while (READ_ONCE(sem->owner) == RWSEM_READER_OWNED) {
+		count = atomic_long_read(&sem->count);
+		if (count == 0 || count == RWSEM_WAITING_BIAS)
+			return true;
+
+		if (need_resched() || local_clock() > *rspin_end)
+			return false;
+
+		cpu_relax();
+	}
+
+	return is_rwsem_owner_spinnable(READ_ONCE(sem->owner));
+}
+
 /*
  * Return true only if we can still spin on the owner field of the rwsem.
  */
-static noinline bool rwsem_spin_on_owner(struct rw_semaphore *sem)
+static noinline bool rwsem_spin_on_owner(struct rw_semaphore *sem,
+					 u64 *rspin_end)
 {
 	struct task_struct *owner = READ_ONCE(sem->owner);
 
+	if (owner == RWSEM_READER_OWNED)
+		return rwsem_spin_on_readers(sem, rspin_end);
+
 	if (!is_rwsem_owner_spinnable(owner))
 		return false;
 
@@ -437,6 +506,7 @@ static noinline bool rwsem_spin_on_owner(struct rw_semaphore *sem)
 static bool rwsem_optimistic_spin(struct rw_semaphore *sem)
 {
 	bool taken = false;
+	u64 rspin_end = 0;
 
 	preempt_disable();
 
@@ -454,7 +524,7 @@ static bool rwsem_optimistic_spin(struct rw_semaphore *sem)
 	 *  2) readers own the lock as we can't determine if they are
 	 *     actively running or not.
 	 */
-	while (rwsem_spin_on_owner(sem)) {
+	while (rwsem_spin_on_owner(sem, &rspin_end)) {
 		/*
 		 * Try to acquire the lock
 		 */
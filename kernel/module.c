@@ -62,6 +62,7 @@
 #include <linux/jump_label.h>
 #include <linux/pfn.h>
 #include <linux/bsearch.h>
+#include <linux/sort.h>
 #include <linux/dynamic_debug.h>
 #include <linux/audit.h>
 #include <uapi/linux/module.h>
@@ -1279,6 +1280,35 @@ static u32 resolve_rel_crc(const s32 *crc)
 	return *(u32 *)((void *)crc + *crc);
 }
 
+static int cmp_version(const void *a, const void *b)
+{
+	const struct modversion_info *va = a, *vb = b;
+
+	return strcmp(va->name, vb->name);
+}
+
+static int cmp_version_name(const void *name, const void *v)
+{
+	return strcmp(name, ((const struct modversion_info *)v)->name);
+}
+
+/*
+ * check_version() runs once for every symbol the module imports, so sort
+ * the table in the temporary image up front instead of scanning all of it
+ * on each lookup.
+ */
+static void sort_versions(const struct load_info *info)
+{
+	Elf_Shdr *vers = &info->sechdrs[info->index.vers];
+
+	if (!info->index.vers)
+		return;
+
+	sort((void *)vers->sh_addr,
+	     vers->sh_size / sizeof(struct modversion_info),
+	     sizeof(struct modversion_info), cmp_version, NULL);
+}
+
 static int check_version(const struct load_info *info,
 			 const char *symname,
 			 struct module *mod,
@@ -1286,8 +1316,9 @@ static int check_version(const struct load_info *info,
 {
 	Elf_Shdr *sechdrs = info->sechdrs;
 	unsigned int versindex = info->index.vers;
-	unsigned int i, num_versions;
+	unsigned int num_versions;
 	struct modversion_info *versions;
+	u32 crcval;
 
 	/* Exporting module didn't supply crcs?  OK, we're already tainted. */
 	if (!crc)
@@ -1301,28 +1332,22 @@ static int check_version(const struct load_info *info,
 	num_versions = sechdrs[versindex].sh_size
 		/ sizeof(struct modversion_info);
 
-	for (i = 0; i < num_versions; i++) {
-		u32 crcval;
-
-		if (strcmp(versions[i].name, symname) != 0)
-			continue;
-
-		if (IS_ENABLED(CONFIG_MODULE_REL_CRCS))
-			crcval = resolve_rel_crc(crc);
-		else
-			crcval = *crc;
-		if (versions[i].crc == crcval)
-			return 1;
-		pr_debug("Found checksum %X vs module %lX\n",
-			 crcval, versions[i].crc);
-		goto bad_version;
+	versions = bsearch(symname, versions, num_versions,
+			   sizeof(struct modversion_info), cmp_version_name);
+	if (!versions) {
+		/* Broken toolchain. Warn once, then let it go.. */
+		pr_warn_once("%s: no symbol version for %s\n",
+			     info->name, symname);
+		return 1;
 	}
 
-	/* Broken toolchain. Warn once, then let it go.. */
-	pr_warn_once("%s: no symbol version for %s\n", info->name, symname);
-	return 1;
-
-bad_version:
+	if (IS_ENABLED(CONFIG_MODULE_REL_CRCS))
+		crcval = resolve_rel_crc(crc);
+	else
+		crcval = *crc;
+	if (versions->crc == crcval)
+		return 1;
+	pr_debug("Found checksum %X vs module %lX\n", crcval, versions->crc);
 	pr_warn("%s: disagrees about version of symbol %s\n",
 	       info->name, symname);
 	return 0;
@@ -1359,6 +1384,10 @@ static inline int same_magic(const char *amagic, const char *bmagic,
 	return strcmp(amagic, bmagic) == 0;
 }
 #else
+static inline void sort_versions(const struct load_info *info)
+{
+}
+
 static inline int check_version(const struct load_info *info,
 				const char *symname,
 				struct module *mod,
@@ -3013,6 +3042,7 @@ static int rewrite_section_headers(struct load_info *info, int flags)
 	else
 		info->index.vers = find_sec(info, "__versions");
 	info->sechdrs[info->index.vers].sh_flags &= ~(unsigned long)SHF_ALLOC;
+	sort_versions(info);
 
 	info->index.info = find_sec(info, ".modinfo");
 	if (!info->index.info)
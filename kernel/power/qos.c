@@ -327,7 +327,7 @@ static inline void pm_qos_set_value_for_cpus(struct pm_qos_constraints *c,
 	for_each_possible_cpu(cpu) {
 		if (c->target_per_cpu[cpu] != qos_val[cpu])
 			cpumask_set_cpu(cpu, cpus);
-		c->target_per_cpu[cpu] = qos_val[cpu];
+		WRITE_ONCE(c->target_per_cpu[cpu], qos_val[cpu]);
 	}
 }
 
@@ -483,7 +483,8 @@ int pm_qos_request_for_cpu(int pm_qos_class, int cpu)
 	if (cpu_isolated(cpu))
 		return INT_MAX;
 
-	return pm_qos_array[pm_qos_class]->constraints->target_per_cpu[cpu];
+	return READ_ONCE(pm_qos_array[pm_qos_class]->constraints->
+			 target_per_cpu[cpu]);
 }
 EXPORT_SYMBOL(pm_qos_request_for_cpu);
 
@@ -493,33 +494,36 @@ int pm_qos_request_active(struct pm_qos_request *req)
 }
 EXPORT_SYMBOL_GPL(pm_qos_request_active);
 
+/*
+ * Called from the cpuidle path of every cluster, so don't take pm_qos_lock:
+ * each per-cpu target is read atomically and a racing update is no worse
+ * than one landing just after we return.
+ */
 int pm_qos_request_for_cpumask(int pm_qos_class, struct cpumask *mask)
 {
-	unsigned long irqflags;
 	int cpu;
 	struct pm_qos_constraints *c = NULL;
-	int val;
+	int val, cpu_val;
 
-	spin_lock_irqsave(&pm_qos_lock, irqflags);
 	c = pm_qos_array[pm_qos_class]->constraints;
 	val = c->default_value;
 
 	for_each_cpu(cpu, mask) {
+		cpu_val = READ_ONCE(c->target_per_cpu[cpu]);
 
 		switch (c->type) {
 		case PM_QOS_MIN:
-			if (c->target_per_cpu[cpu] < val)
-				val = c->target_per_cpu[cpu];
+			if (cpu_val < val)
+				val = cpu_val;
 			break;
 		case PM_QOS_MAX:
-			if (c->target_per_cpu[cpu] > val)
-				val = c->target_per_cpu[cpu];
+			if (cpu_val > val)
+				val = cpu_val;
 			break;
 		default:
 			break;
 		}
 	}
-	spin_unlock_irqrestore(&pm_qos_lock, irqflags);
 
 	return val;
 }
@@ -528,8 +532,15 @@ EXPORT_SYMBOL(pm_qos_request_for_cpumask);
 static void __pm_qos_update_request(struct pm_qos_request *req,
 			   s32 new_value)
 {
+	struct pm_qos_constraints *c =
+		pm_qos_array[req->pm_qos_class]->constraints;
+
 	trace_pm_qos_update_request(req->pm_qos_class, new_value);
 
+	/* resetting an idle request must not walk the whole list again */
+	if (new_value == PM_QOS_DEFAULT_VALUE)
+		new_value = c->default_value;
+
 	if (new_value != req->node.prio)
 		pm_qos_update_target(
 			pm_qos_array[req->pm_qos_class]->constraints,
@@ -42,6 +42,7 @@
 #include <linux/rculist.h>
 #include <linux/poll.h>
 #include <linux/irq_work.h>
+#include <linux/kthread.h>
 #include <linux/utsname.h>
 #include <linux/ctype.h>
 #include <linux/uio.h>
@@ -1901,6 +1902,23 @@ int vprintk_store(int facility, int level,
 			  dict, dictlen, text, text_len);
 }
 
+/*
+ * Leave console output to the printk kthread instead of the caller, so a
+ * driver logging from a hot or atomic path never ends up pushing the whole
+ * backlog out over a slow serial console itself. Oopses and panics still
+ * print synchronously.
+ */
+static bool printk_offload;
+module_param_named(offload, printk_offload, bool, S_IRUGO | S_IWUSR);
+
+static struct task_struct *printk_kthread;
+
+static bool printk_offload_active(void)
+{
+	return READ_ONCE(printk_offload) && printk_kthread &&
+		!oops_in_progress;
+}
+
 asmlinkage int vprintk_emit(int facility, int level,
 			    const char *dict, size_t dictlen,
 			    const char *fmt, va_list args)
@@ -1922,8 +1940,10 @@ asmlinkage int vprintk_emit(int facility, int level,
 	printed_len = vprintk_store(facility, level, dict, dictlen, fmt, args);
 	logbuf_unlock_irqrestore(flags);
 
-	/* If called from the scheduler, we can not call up(). */
-	if (!in_sched) {
+	if (printk_offload_active()) {
+		defer_console_output();
+	} else if (!in_sched) {
+		/* If called from the scheduler, we can not call up(). */
 		/*
 		 * Disable preemption to avoid being preempted while holding
 		 * console_sem which would prevent anyone from printing to
@@ -2890,14 +2910,52 @@ late_initcall(printk_late_init);
 
 static DEFINE_PER_CPU(int, printk_pending);
 
+static bool printk_kthread_pending;
+
+static int printk_kthread_func(void *data)
+{
+	for (;;) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!READ_ONCE(printk_kthread_pending))
+			schedule();
+		__set_current_state(TASK_RUNNING);
+
+		/* anything stored from here on gets another pass */
+		WRITE_ONCE(printk_kthread_pending, false);
+		console_lock();
+		console_unlock();
+	}
+
+	return 0;
+}
+
+static int __init printk_kthread_init(void)
+{
+	struct task_struct *tsk;
+
+	tsk = kthread_run(printk_kthread_func, NULL, "printk");
+	if (IS_ERR(tsk)) {
+		pr_err("printk: unable to create printing thread\n");
+		return PTR_ERR(tsk);
+	}
+	printk_kthread = tsk;
+
+	return 0;
+}
+late_initcall(printk_kthread_init);
+
 static void wake_up_klogd_work_func(struct irq_work *irq_work)
 {
 	int pending = __this_cpu_xchg(printk_pending, 0);
 
 	if (pending & PRINTK_PENDING_OUTPUT) {
-		/* If trylock fails, someone else is doing the printing */
-		if (console_trylock())
+		if (printk_offload_active()) {
+			WRITE_ONCE(printk_kthread_pending, true);
+			wake_up_process(printk_kthread);
+		} else if (console_trylock()) {
+			/* If trylock fails, someone else is doing the printing */
 			console_unlock();
+		}
 	}
 
 	if (pending & PRINTK_PENDING_WAKEUP)
@@ -62,6 +62,8 @@ DEFINE_PER_CPU(char, rcu_cpu_has_work);
 static cpumask_var_t rcu_nocb_mask; /* CPUs to have callbacks offloaded. */
 static bool have_rcu_nocb_mask;	    /* Was rcu_nocb_mask allocated? */
 static bool __read_mostly rcu_nocb_poll;    /* Offload kthread are to poll. */
+static cpumask_var_t rcu_nocb_affinity;	/* CPUs rcuo kthreads run on. */
+static bool have_rcu_nocb_affinity; /* Was rcu_nocb_affinity allocated? */
 #endif /* #ifdef CONFIG_RCU_NOCB_CPU */
 
 /*
@@ -1766,6 +1768,19 @@ static int __init rcu_nocb_setup(char *str)
 }
 __setup("rcu_nocbs=", rcu_nocb_setup);
 
+/*
+ * Parse the boot-time CPU list the rcuo kthreads are confined to, so that
+ * callbacks offloaded from the big cores are invoked on the little ones.
+ */
+static int __init rcu_nocb_affinity_setup(char *str)
+{
+	alloc_bootmem_cpumask_var(&rcu_nocb_affinity);
+	have_rcu_nocb_affinity = true;
+	cpulist_parse(str, rcu_nocb_affinity);
+	return 1;
+}
+__setup("rcu_nocb_affinity=", rcu_nocb_affinity_setup);
+
 static int __init parse_rcu_nocb_poll(char *arg)
 {
 	rcu_nocb_poll = true;
@@ -2325,6 +2340,17 @@ void __init rcu_init_nohz(void)
 		cpumask_pr_args(rcu_nocb_mask));
 	if (rcu_nocb_poll)
 		pr_info("\tPoll for callbacks from no-CBs CPUs.\n");
+	if (have_rcu_nocb_affinity) {
+		cpumask_and(rcu_nocb_affinity, rcu_nocb_affinity,
+			    cpu_possible_mask);
+		if (cpumask_empty(rcu_nocb_affinity)) {
+			pr_info("\tNote: kernel parameter 'rcu_nocb_affinity=' contains no existing CPUs, ignoring.\n");
+			have_rcu_nocb_affinity = false;
+		} else {
+			pr_info("\tInvoke offloaded RCU callbacks on CPUs: %*pbl.\n",
+				cpumask_pr_args(rcu_nocb_affinity));
+		}
+	}
 
 	for_each_rcu_flavor(rsp) {
 		for_each_cpu(cpu, rcu_nocb_mask)
@@ -2389,6 +2415,8 @@ static void rcu_spawn_one_nocb_kthread(struct rcu_state *rsp, int cpu)
 	t = kthread_run(rcu_nocb_kthread, rdp_spawn,
 			"rcuo%c/%d", rsp->abbr, cpu);
 	BUG_ON(IS_ERR(t));
+	if (have_rcu_nocb_affinity)
+		set_cpus_allowed_ptr(t, rcu_nocb_affinity);
 	WRITE_ONCE(rdp_spawn->nocb_kthread, t);
 }
 
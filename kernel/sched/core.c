@@ -4068,7 +4068,7 @@ u64 scheduler_tick_max_deferment(void)
 	if (time_before_eq(next, now))
 		return 0;
 
-	return jiffies_to_nsecs(next - now);
+	return min(jiffies_to_nsecs(next - now), walt_max_tick_deferment(rq));
 }
 #endif
 
@@ -5012,6 +5012,7 @@ int available_idle_cpu(int cpu)
 
 	return 1;
 }
+EXPORT_SYMBOL_GPL(available_idle_cpu);
 
 /**
  * idle_task - return the idle task for a given CPU.
@@ -20,6 +20,7 @@
 #include <linux/sched.h>
 #include <linux/sched/rt.h>
 #include <linux/syscore_ops.h>
+#include <linux/irq_work.h>
 #include <uapi/linux/sched/types.h>
 #include <linux/sched/core_ctl.h>
 
@@ -56,6 +57,8 @@ struct cluster_data {
 	struct task_struct *core_ctl_thread;
 	unsigned int first_cpu;
 	unsigned int boost;
+	bool predictive;
+	unsigned long pred_kick_ts;
 	struct kobject kobj;
 };
 
@@ -82,6 +85,10 @@ static void apply_need(struct cluster_data *state);
 static void wake_up_core_ctl_thread(struct cluster_data *state);
 static bool initialized;
 
+/* Clusters with a predicted burst pending evaluation, by index */
+static unsigned long pred_kick_pending;
+static struct irq_work pred_kick_irq_work;
+
 ATOMIC_NOTIFIER_HEAD(core_ctl_notifier);
 static unsigned int last_nr_big;
 
@@ -287,6 +294,24 @@ static ssize_t show_enable(const struct cluster_data *state, char *buf)
 	return scnprintf(buf, PAGE_SIZE, "%u\n", state->enable);
 }
 
+static ssize_t store_predictive(struct cluster_data *state,
+				const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (sscanf(buf, "%u\n", &val) != 1)
+		return -EINVAL;
+
+	state->predictive = !!val;
+
+	return count;
+}
+
+static ssize_t show_predictive(const struct cluster_data *state, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", state->predictive);
+}
+
 static ssize_t show_need_cpus(const struct cluster_data *state, char *buf)
 {
 	return snprintf(buf, PAGE_SIZE, "%u\n", state->need_cpus);
@@ -421,6 +446,7 @@ core_ctl_attr_ro(active_cpus);
 core_ctl_attr_ro(global_state);
 core_ctl_attr_rw(not_preferred);
 core_ctl_attr_rw(enable);
+core_ctl_attr_rw(predictive);
 
 static struct attribute *default_attrs[] = {
 	&min_cpus.attr,
@@ -431,6 +457,7 @@ static struct attribute *default_attrs[] = {
 	&task_thres.attr,
 	&nr_prev_assist_thresh.attr,
 	&enable.attr,
+	&predictive.attr,
 	&need_cpus.attr,
 	&active_cpus.attr,
 	&global_state.attr,
@@ -888,6 +915,22 @@ static void core_ctl_call_notifier(void)
 	atomic_notifier_call_chain(&core_ctl_notifier, 0, &ndata);
 }
 
+/*
+ * CPU busy percentage for the isolation decision. With prediction enabled
+ * this also takes WALT's predicted demand and top task on the CPU into
+ * account, so CPUs are brought in ahead of a burst rather than a window
+ * after it.
+ */
+static unsigned int get_cpu_busy(struct cluster_data *cluster, int cpu)
+{
+	unsigned int busy = sched_get_cpu_util(cpu);
+
+	if (cluster->predictive)
+		busy = max(busy, walt_cpu_pred_util(cpu));
+
+	return busy;
+}
+
 void core_ctl_check(u64 window_start)
 {
 	int cpu;
@@ -913,7 +956,7 @@ void core_ctl_check(u64 window_start)
 		if (!cluster || !cluster->inited)
 			continue;
 
-		c->busy = sched_get_cpu_util(cpu);
+		c->busy = get_cpu_busy(cluster, cpu);
 	}
 	spin_unlock_irqrestore(&state_lock, flags);
 
@@ -927,6 +970,57 @@ void core_ctl_check(u64 window_start)
 	core_ctl_call_notifier();
 }
 
+/*
+ * Fast path for predicted bursts. Re-evaluates the need of the kicked
+ * clusters right away instead of at the next window rollover. The
+ * unisolation itself still has to sleep and stays in the core_ctl thread.
+ */
+static void core_ctl_pred_kick_work(struct irq_work *work)
+{
+	struct cluster_data *cluster;
+	struct cpu_data *c;
+	unsigned int index = 0;
+	unsigned long flags;
+
+	for_each_cluster(cluster, index) {
+		if (!test_and_clear_bit(index, &pred_kick_pending))
+			continue;
+
+		spin_lock_irqsave(&state_lock, flags);
+		list_for_each_entry(c, &cluster->lru, sib)
+			c->busy = get_cpu_busy(cluster, c->cpu);
+		spin_unlock_irqrestore(&state_lock, flags);
+
+		if (eval_need(cluster))
+			wake_up_core_ctl_thread(cluster);
+	}
+}
+
+/*
+ * Called by WALT, possibly with the rq lock held, when the predicted
+ * demand of a task on @cpu goes up.
+ */
+void core_ctl_kick(int cpu)
+{
+	struct cluster_data *cluster;
+
+	if (unlikely(!initialized))
+		return;
+
+	cluster = per_cpu(cpu_state, cpu).cluster;
+	if (!cluster || !cluster->inited || !cluster->predictive ||
+	    !cluster->nr_isolated_cpus)
+		return;
+
+	/* At most one evaluation per jiffy and cluster */
+	if (cluster->pred_kick_ts == jiffies)
+		return;
+	cluster->pred_kick_ts = jiffies;
+
+	if (!test_and_set_bit(cluster - cluster_state, &pred_kick_pending))
+		irq_work_queue(&pred_kick_irq_work);
+}
+
 static void move_cpu_lru(struct cpu_data *cpu_data)
 {
 	unsigned long flags;
@@ -1295,6 +1389,8 @@ static int __init core_ctl_init(void)
 			"core_ctl/isolation:dead",
 			NULL, core_ctl_isolation_dead_cpu);
 
+	init_irq_work(&pred_kick_irq_work, core_ctl_pred_kick_work);
+
 	for_each_sched_cluster(cluster) {
 		ret = cluster_init(&cluster->cpus);
 		if (ret)
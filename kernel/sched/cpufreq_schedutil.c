@@ -27,6 +27,7 @@ struct sugov_tunables {
 	unsigned int		up_rate_limit_us;
 	unsigned int		down_rate_limit_us;
 	bool iowait_boost_enable;
+	bool switch_cost_filter;
 };
 
 struct sugov_policy {
@@ -45,6 +46,15 @@ struct sugov_policy {
 	unsigned int cached_raw_freq;
 	unsigned int prev_cached_raw_freq;
 
+	/*
+	 * Measured transition cost in ns, indexed by [from][to] position in
+	 * the policy frequency table, and the average time a frequency is
+	 * held before the next change.
+	 */
+	u32 *switch_cost_ns;
+	unsigned int nr_opps;
+	u64 avg_hold_ns;
+
 	/* The next fields are only needed if fast switch cannot be used. */
 	struct irq_work irq_work;
 	struct kthread_work work;
@@ -137,18 +147,125 @@ static bool sugov_up_down_rate_limit(struct sugov_policy *sg_policy, u64 time,
 	return false;
 }
 
+#define SUGOV_HOLD_MAX_NS	(100 * NSEC_PER_MSEC)
+
+static int sugov_opp_index(struct sugov_policy *sg_policy, unsigned int freq)
+{
+	int idx;
+
+	if (!sg_policy->switch_cost_ns)
+		return -EINVAL;
+
+	idx = cpufreq_frequency_table_get_index(sg_policy->policy, freq);
+	if (idx >= (int)sg_policy->nr_opps)
+		return -EINVAL;
+
+	return idx;
+}
+
+static void sugov_record_switch_cost(struct sugov_policy *sg_policy,
+				     unsigned int from, unsigned int to,
+				     u64 delta_ns)
+{
+	int from_idx = sugov_opp_index(sg_policy, from);
+	int to_idx = sugov_opp_index(sg_policy, to);
+	u32 *cost;
+
+	if (from_idx < 0 || to_idx < 0 || from_idx == to_idx)
+		return;
+
+	delta_ns = min_t(u64, delta_ns, U32_MAX);
+	cost = &sg_policy->switch_cost_ns[from_idx * sg_policy->nr_opps + to_idx];
+
+	/* EWMA with a 1/8 weight, seeded by the first sample */
+	if (*cost)
+		*cost = *cost - (*cost >> 3) + ((u32)delta_ns >> 3);
+	else
+		*cost = max_t(u32, delta_ns, 1);
+}
+
+static u64 sugov_switch_cost(struct sugov_policy *sg_policy,
+			     unsigned int from, unsigned int to)
+{
+	int from_idx = sugov_opp_index(sg_policy, from);
+	int to_idx = sugov_opp_index(sg_policy, to);
+	u32 cost = 0;
+
+	if (from_idx >= 0 && to_idx >= 0)
+		cost = sg_policy->switch_cost_ns[from_idx * sg_policy->nr_opps +
+						 to_idx];
+
+	/* Fall back to the driver's estimate until the pair is measured */
+	return cost ? cost : sg_policy->policy->cpuinfo.transition_latency;
+}
+
+/*
+ * A frequency reduction only saves energy if the new frequency is held long
+ * enough to repay the switch. With dynamic power roughly proportional to f^3
+ * the relative saving is 1 - (next / cur)^3 of the power at @cur, while the
+ * switch itself costs about its latency at the power of @cur. Compare the two
+ * over the average time a frequency has been held on this policy and keep the
+ * current frequency when the switch does not pay off.
+ */
+static bool sugov_switch_pays_off(struct sugov_policy *sg_policy,
+				  unsigned int next_freq)
+{
+	unsigned int cur = sg_policy->next_freq;
+	u64 cost, hold, ratio, saving;
+	bool taken;
+
+	if (!sg_policy->tunables->switch_cost_filter)
+		return true;
+
+	if (!cur || next_freq >= cur || !sg_policy->avg_hold_ns)
+		return true;
+
+	cost = sugov_switch_cost(sg_policy, cur, next_freq);
+	hold = sg_policy->avg_hold_ns;
+
+	ratio = div64_u64((u64)next_freq << SCHED_CAPACITY_SHIFT, cur);
+	saving = SCHED_CAPACITY_SCALE -
+		 ((ratio * ratio * ratio) >> (2 * SCHED_CAPACITY_SHIFT));
+	taken = ((hold * saving) >> SCHED_CAPACITY_SHIFT) > cost;
+
+	trace_sugov_switch_decision(sg_policy->policy->cpu, cur, next_freq,
+				    cost, hold, taken);
+
+	return taken;
+}
+
+static void sugov_update_hold_time(struct sugov_policy *sg_policy, u64 time)
+{
+	u64 hold;
+
+	if (!sg_policy->last_freq_update_time)
+		return;
+
+	hold = min_t(u64, time - sg_policy->last_freq_update_time,
+		     SUGOV_HOLD_MAX_NS);
+
+	if (sg_policy->avg_hold_ns)
+		sg_policy->avg_hold_ns = sg_policy->avg_hold_ns -
+					 (sg_policy->avg_hold_ns >> 3) +
+					 (hold >> 3);
+	else
+		sg_policy->avg_hold_ns = hold;
+}
+
 static bool sugov_update_next_freq(struct sugov_policy *sg_policy, u64 time,
 				   unsigned int next_freq)
 {
 	if (sg_policy->next_freq == next_freq)
 		return false;
 
-	if (sugov_up_down_rate_limit(sg_policy, time, next_freq)) {
+	if (sugov_up_down_rate_limit(sg_policy, time, next_freq) ||
+	    !sugov_switch_pays_off(sg_policy, next_freq)) {
 		/* Restore cached freq as next_freq is not changed */
 		sg_policy->cached_raw_freq = sg_policy->prev_cached_raw_freq;
 		return false;
 	}
 
+	sugov_update_hold_time(sg_policy, time);
 	sg_policy->next_freq = next_freq;
 	sg_policy->last_freq_update_time = time;
 
@@ -159,15 +276,21 @@ static void sugov_fast_switch(struct sugov_policy *sg_policy, u64 time,
 			      unsigned int next_freq)
 {
 	struct cpufreq_policy *policy = sg_policy->policy;
+	unsigned int prev_freq = policy->cur;
+	u64 start;
 	int cpu;
 
 	if (!sugov_update_next_freq(sg_policy, time, next_freq))
 		return;
 
+	start = sched_clock();
 	next_freq = cpufreq_driver_fast_switch(policy, next_freq);
 	if (!next_freq)
 		return;
 
+	sugov_record_switch_cost(sg_policy, prev_freq, next_freq,
+				 sched_clock() - start);
+
 	policy->cur = next_freq;
 
 	if (trace_cpu_frequency_enabled()) {
@@ -615,8 +738,10 @@ static void sugov_update_shared(struct update_util_data *hook, u64 time,
 static void sugov_work(struct kthread_work *work)
 {
 	struct sugov_policy *sg_policy = container_of(work, struct sugov_policy, work);
-	unsigned int freq;
+	struct cpufreq_policy *policy = sg_policy->policy;
+	unsigned int freq, prev_freq;
 	unsigned long flags;
+	u64 start;
 
 	/*
 	 * Hold sg_policy->update_lock shortly to handle the case where:
@@ -634,7 +759,11 @@ static void sugov_work(struct kthread_work *work)
 	raw_spin_unlock_irqrestore(&sg_policy->update_lock, flags);
 
 	mutex_lock(&sg_policy->work_lock);
-	__cpufreq_driver_target(sg_policy->policy, freq, CPUFREQ_RELATION_L);
+	prev_freq = policy->cur;
+	start = sched_clock();
+	if (!__cpufreq_driver_target(policy, freq, CPUFREQ_RELATION_L))
+		sugov_record_switch_cost(sg_policy, prev_freq, policy->cur,
+					 sched_clock() - start);
 	mutex_unlock(&sg_policy->work_lock);
 }
 
@@ -743,14 +872,38 @@ static ssize_t iowait_boost_enable_store(struct gov_attr_set *attr_set,
 	return count;
 }
 
+static ssize_t switch_cost_filter_show(struct gov_attr_set *attr_set,
+				       char *buf)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	return sprintf(buf, "%u\n", tunables->switch_cost_filter);
+}
+
+static ssize_t switch_cost_filter_store(struct gov_attr_set *attr_set,
+					const char *buf, size_t count)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+	bool enable;
+
+	if (kstrtobool(buf, &enable))
+		return -EINVAL;
+
+	tunables->switch_cost_filter = enable;
+
+	return count;
+}
+
 static struct governor_attr up_rate_limit_us = __ATTR_RW(up_rate_limit_us);
 static struct governor_attr down_rate_limit_us = __ATTR_RW(down_rate_limit_us);
 static struct governor_attr iowait_boost_enable = __ATTR_RW(iowait_boost_enable);
+static struct governor_attr switch_cost_filter = __ATTR_RW(switch_cost_filter);
 
 static struct attribute *sugov_attributes[] = {
 	&up_rate_limit_us.attr,
 	&down_rate_limit_us.attr,
 	&iowait_boost_enable.attr,
+	&switch_cost_filter.attr,
 	NULL
 };
 
@@ -781,11 +934,28 @@ static struct sugov_policy *sugov_policy_alloc(struct cpufreq_policy *policy)
 
 	sg_policy->policy = policy;
 	raw_spin_lock_init(&sg_policy->update_lock);
+
+	if (policy->freq_table) {
+		struct cpufreq_frequency_table *pos;
+		unsigned int nr = 0;
+
+		cpufreq_for_each_entry(pos, policy->freq_table)
+			nr++;
+
+		/* Cost tracking is best effort, carry on without it */
+		sg_policy->switch_cost_ns = kcalloc(nr * nr,
+						sizeof(*sg_policy->switch_cost_ns),
+						GFP_KERNEL);
+		if (sg_policy->switch_cost_ns)
+			sg_policy->nr_opps = nr;
+	}
+
 	return sg_policy;
 }
 
 static void sugov_policy_free(struct sugov_policy *sg_policy)
 {
+	kfree(sg_policy->switch_cost_ns);
 	kfree(sg_policy);
 }
 
@@ -884,6 +1054,7 @@ static void sugov_tunables_save(struct cpufreq_policy *policy,
 
 	cached->up_rate_limit_us = tunables->up_rate_limit_us;
 	cached->down_rate_limit_us = tunables->down_rate_limit_us;
+	cached->switch_cost_filter = tunables->switch_cost_filter;
 }
 
 static void sugov_clear_global_tunables(void)
@@ -903,6 +1074,7 @@ static void sugov_tunables_restore(struct cpufreq_policy *policy)
 
 	tunables->up_rate_limit_us = cached->up_rate_limit_us;
 	tunables->down_rate_limit_us = cached->down_rate_limit_us;
+	tunables->switch_cost_filter = cached->switch_cost_filter;
 	update_min_rate_limit_ns(sg_policy);
 }
 
@@ -1026,6 +1198,7 @@ static int sugov_start(struct cpufreq_policy *policy)
 	sg_policy->need_freq_update = false;
 	sg_policy->cached_raw_freq = 0;
 	sg_policy->prev_cached_raw_freq = 0;
+	sg_policy->avg_hold_ns = 0;
 
 	for_each_cpu(cpu, policy->cpus) {
 		struct sugov_cpu *sg_cpu = &per_cpu(sugov_cpu, cpu);
@@ -46,6 +46,7 @@ static void free_resources(void)
 				kfree(sge->cap_states);
 				kfree(sge->idle_states);
 				kfree(sge);
+				sge_array[cpu][sd_level] = NULL;
 			}
 		}
 	}
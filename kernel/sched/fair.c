@@ -6302,42 +6302,91 @@ static unsigned long cpu_util_without(int cpu, struct task_struct *p)
 	return min_t(unsigned long, util, capacity_orig_of(cpu));
 }
 
-static unsigned long group_max_util(struct energy_env *eenv, int cpu_idx)
+/*
+ * Per-group state that doesn't depend on the candidate CPU. It is taken
+ * once per group, so that each candidate only has to account for its own
+ * utilization instead of walking every CPU of the group again.
+ */
+struct sg_util_snap {
+	/* the two highest FREQUENCY_UTIL values of sg_cap, without p */
+	unsigned long	fu_max;
+	unsigned long	fu_max2;
+	int		fu_max_cpu;
+
+	/* group_norm_util() for candidates outside sg, at norm_cap */
+	unsigned long	norm_cap;
+	unsigned long	norm_util;
+
+	/* shallowest idle state and summed cpu_util() of sg */
+	int		idle_state;
+	long		grp_util;
+};
+
+static void sg_util_snapshot(struct energy_env *eenv,
+			     struct sg_util_snap *snap)
 {
-	unsigned long max_util = 0;
 	unsigned long util;
-	unsigned long cpu_cap;
-	struct task_struct *tsk;
 	int cpu;
 
+	snap->fu_max = 0;
+	snap->fu_max2 = 0;
+	snap->fu_max_cpu = -1;
+
 	for_each_cpu(cpu, sched_group_span(eenv->sg_cap)) {
 		util = cpu_util_without(cpu, eenv->p);
+		util = schedutil_cpu_util(cpu, util,
+					  arch_scale_cpu_capacity(NULL, cpu),
+					  FREQUENCY_UTIL, NULL);
+
+		if (util > snap->fu_max) {
+			snap->fu_max2 = snap->fu_max;
+			snap->fu_max = util;
+			snap->fu_max_cpu = cpu;
+		} else if (util > snap->fu_max2) {
+			snap->fu_max2 = util;
+		}
+	}
 
-		/*
-		 * If we are looking at the target CPU specified by the eenv,
-		 * then we should add the (estimated) utilization of the task
-		 * assuming we will wake it up on that CPU.
-		 */
-		if (unlikely(cpu == eenv->cpu[cpu_idx].cpu_id))
-			util += eenv->util_delta_boosted;
+	snap->norm_cap = 0;
+	snap->idle_state = INT_MAX;
+	snap->grp_util = 0;
 
-		cpu_cap = arch_scale_cpu_capacity(NULL, cpu);
+	for_each_cpu(cpu, sched_group_span(eenv->sg)) {
+		snap->idle_state = min(snap->idle_state,
+				       idle_get_state_idx(cpu_rq(cpu)));
+		snap->grp_util += cpu_util(cpu);
+	}
+}
 
-		/*
-		 * Performance domain frequency: utilization clamping
-		 * must be considered since it affects the selection
-		 * of the performance domain frequency.
-		 * NOTE: in case RT tasks are running, by default the
-		 * FREQUENCY_UTIL's utilization can be max OPP.
-		 */
-		tsk = unlikely(cpu == eenv->cpu[cpu_idx].cpu_id) ? eenv->p : NULL;
-		util = schedutil_cpu_util(cpu, util, cpu_cap,
-					      FREQUENCY_UTIL, tsk);
+static unsigned long group_max_util(struct energy_env *eenv, int cpu_idx,
+				    const struct sg_util_snap *snap)
+{
+	int cpu = eenv->cpu[cpu_idx].cpu_id;
+	unsigned long max_util;
+	unsigned long util;
 
-		max_util = max(max_util, util);
-	}
+	if (!cpumask_test_cpu(cpu, sched_group_span(eenv->sg_cap)))
+		return snap->fu_max;
+
+	/* the other CPUs of the group are as in the snapshot */
+	max_util = cpu == snap->fu_max_cpu ? snap->fu_max2 : snap->fu_max;
 
-	return max_util;
+	/*
+	 * The target CPU specified by the eenv gets the (estimated)
+	 * utilization of the task added, assuming we will wake it up there.
+	 *
+	 * Performance domain frequency: utilization clamping
+	 * must be considered since it affects the selection
+	 * of the performance domain frequency.
+	 * NOTE: in case RT tasks are running, by default the
+	 * FREQUENCY_UTIL's utilization can be max OPP.
+	 */
+	util = cpu_util_without(cpu, eenv->p) + eenv->util_delta_boosted;
+	util = schedutil_cpu_util(cpu, util,
+				  arch_scale_cpu_capacity(NULL, cpu),
+				  FREQUENCY_UTIL, eenv->p);
+
+	return max(max_util, util);
 }
 
 /*
@@ -6384,10 +6433,11 @@ long group_norm_util(struct energy_env *eenv, int cpu_idx)
 	return util_sum;
 }
 
-static int find_new_capacity(struct energy_env *eenv, int cpu_idx)
+static int find_new_capacity(struct energy_env *eenv, int cpu_idx,
+			     const struct sg_util_snap *snap)
 {
 	const struct sched_group_energy *sge = eenv->sg_cap->sge;
-	unsigned long util = group_max_util(eenv, cpu_idx);
+	unsigned long util = group_max_util(eenv, cpu_idx, snap);
 	int idx, cap_idx;
 
 	cap_idx = sge->nr_cap_states - 1;
@@ -6405,19 +6455,17 @@ static int find_new_capacity(struct energy_env *eenv, int cpu_idx)
 	return cap_idx;
 }
 
-static int group_idle_state(struct energy_env *eenv, int cpu_idx)
+static int group_idle_state(struct energy_env *eenv, int cpu_idx,
+			    const struct sg_util_snap *snap)
 {
 	struct sched_group *sg = eenv->sg;
 	int src_in_grp, dst_in_grp;
-	int i, state = INT_MAX;
+	int state = snap->idle_state;
 	int max_idle_state_idx;
-	long grp_util = 0;
+	long grp_util = snap->grp_util;
 	int new_state;
 
-	/* Find the shallowest idle state in the sched group. */
-	for_each_cpu(i, sched_group_span(sg))
-		state = min(state, idle_get_state_idx(cpu_rq(i)));
-
+	/* The shallowest idle state in the sched group. */
 	if (unlikely(state == INT_MAX))
 		return -EINVAL;
 
@@ -6427,9 +6475,6 @@ static int group_idle_state(struct energy_env *eenv, int cpu_idx)
 	 * Try to estimate if a deeper idle state is
 	 * achievable when we move the task.
 	 */
-	for_each_cpu(i, sched_group_span(sg))
-		grp_util += cpu_util(i);
-
 	src_in_grp = cpumask_test_cpu(eenv->cpu[EAS_CPU_PRV].cpu_id,
 				      sched_group_span(sg));
 	dst_in_grp = cpumask_test_cpu(eenv->cpu[cpu_idx].cpu_id,
@@ -6532,22 +6577,39 @@ static int calc_sg_energy(struct energy_env *eenv)
 	unsigned long busy_energy, idle_energy;
 	unsigned int busy_power, idle_power;
 	unsigned long total_energy = 0;
+	struct sg_util_snap snap;
 	unsigned long sg_util;
 	int cap_idx, idle_idx;
 	int cpu_idx;
 
+	sg_util_snapshot(eenv, &snap);
+
 	for (cpu_idx = EAS_CPU_PRV; cpu_idx < eenv->max_cpu_count; ++cpu_idx) {
 		if (eenv->cpu[cpu_idx].cpu_id == -1)
 			continue;
 
 		/* Compute ACTIVE energy */
-		cap_idx = find_new_capacity(eenv, cpu_idx);
+		cap_idx = find_new_capacity(eenv, cpu_idx, &snap);
 		busy_power = sg->sge->cap_states[cap_idx].power;
-		sg_util = group_norm_util(eenv, cpu_idx);
+
+		/*
+		 * Candidates outside of sg see the same group utilization,
+		 * which only changes with the capacity it is normalized to.
+		 */
+		if (cpumask_test_cpu(eenv->cpu[cpu_idx].cpu_id,
+				     sched_group_span(sg))) {
+			sg_util = group_norm_util(eenv, cpu_idx);
+		} else {
+			if (snap.norm_cap != eenv->cpu[cpu_idx].cap) {
+				snap.norm_cap = eenv->cpu[cpu_idx].cap;
+				snap.norm_util = group_norm_util(eenv, cpu_idx);
+			}
+			sg_util = snap.norm_util;
+		}
 		busy_energy   = sg_util * busy_power;
 
 		/* Compute IDLE energy */
-		idle_idx = group_idle_state(eenv, cpu_idx);
+		idle_idx = group_idle_state(eenv, cpu_idx, &snap);
 		if (unlikely(idle_idx < 0))
 			return idle_idx;
 
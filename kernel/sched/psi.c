@@ -168,8 +168,29 @@ __setup("psi=", setup_psi);
 /* PSI trigger definitions */
 #define WINDOW_MIN_US 500000	/* Min window size is 500ms */
 #define WINDOW_MAX_US 10000000	/* Max window size is 10s */
+#define WINDOW_FLOOR_US 10000	/* Lowest psi_window_min_ms= is 10ms */
 #define UPDATES_PER_WINDOW 10	/* 10 updates per window */
 
+/*
+ * Memory managers that react to a single app thrashing want to be told
+ * within tens of milliseconds. Windows that short can be allowed from the
+ * command line, at the cost of polling every window/10 while a trigger's
+ * state is stalled.
+ */
+static u32 psi_window_min_us __read_mostly = WINDOW_MIN_US;
+
+static int __init setup_psi_window_min(char *str)
+{
+	unsigned int ms;
+
+	if (kstrtouint(str, 0, &ms))
+		return 0;
+	psi_window_min_us = clamp_t(u32, ms * USEC_PER_MSEC, WINDOW_FLOOR_US,
+				    WINDOW_MAX_US);
+	return 1;
+}
+__setup("psi_window_min_ms=", setup_psi_window_min);
+
 /* Sampling frequency in nanoseconds */
 static u64 psi_period __read_mostly;
 
@@ -627,13 +648,11 @@ static void psi_poll_work(struct kthread_work *work)
 	mutex_unlock(&group->trigger_lock);
 }
 
-static void record_times(struct psi_group_cpu *groupc, int cpu,
+static void record_times(struct psi_group_cpu *groupc, u64 now,
 			 bool memstall_tick)
 {
 	u32 delta;
-	u64 now;
 
-	now = cpu_clock(cpu);
 	delta = now - groupc->state_start;
 	groupc->state_start = now;
 
@@ -674,7 +693,7 @@ static void record_times(struct psi_group_cpu *groupc, int cpu,
 }
 
 static u32 psi_group_change(struct psi_group *group, int cpu,
-			    unsigned int clear, unsigned int set)
+			    unsigned int clear, unsigned int set, u64 now)
 {
 	struct psi_group_cpu *groupc;
 	unsigned int t, m;
@@ -693,7 +712,7 @@ static u32 psi_group_change(struct psi_group *group, int cpu,
 	 */
 	write_seqcount_begin(&groupc->seq);
 
-	record_times(groupc, cpu, false);
+	record_times(groupc, now, false);
 
 	for (t = 0, m = clear; m; m &= ~(1 << t), t++) {
 		if (!(m & (1 << t)))
@@ -754,6 +773,7 @@ void psi_task_change(struct task_struct *task, int clear, int set)
 	struct psi_group *group;
 	bool wake_clock = true;
 	void *iter = NULL;
+	u64 now;
 
 	if (!task->pid)
 		return;
@@ -781,8 +801,11 @@ void psi_task_change(struct task_struct *task, int clear, int set)
 		     wq_worker_last_func(task) == psi_avgs_work))
 		wake_clock = false;
 
+	/* one clock read for the whole hierarchy, not one per level */
+	now = cpu_clock(cpu);
+
 	while ((group = iterate_groups(task, &iter))) {
-		u32 state_mask = psi_group_change(group, cpu, clear, set);
+		u32 state_mask = psi_group_change(group, cpu, clear, set, now);
 
 		if (state_mask & group->poll_states)
 			psi_schedule_poll_work(group, 1);
@@ -796,13 +819,14 @@ void psi_memstall_tick(struct task_struct *task, int cpu)
 {
 	struct psi_group *group;
 	void *iter = NULL;
+	u64 now = cpu_clock(cpu);
 
 	while ((group = iterate_groups(task, &iter))) {
 		struct psi_group_cpu *groupc;
 
 		groupc = per_cpu_ptr(group->pcpu, cpu);
 		write_seqcount_begin(&groupc->seq);
-		record_times(groupc, cpu, true);
+		record_times(groupc, now, true);
 		write_seqcount_end(&groupc->seq);
 	}
 }
@@ -1029,7 +1053,7 @@ struct psi_trigger *psi_trigger_create(struct psi_group *group,
 	if (state >= PSI_NONIDLE)
 		return ERR_PTR(-EINVAL);
 
-	if (window_us < WINDOW_MIN_US ||
+	if (window_us < psi_window_min_us ||
 		window_us > WINDOW_MAX_US)
 		return ERR_PTR(-EINVAL);
 
@@ -1083,6 +1107,17 @@ struct psi_trigger *psi_trigger_create(struct psi_group *group,
 	return t;
 }
 
+/*
+ * In-kernel users that want to react to system wide stalls without going
+ * through the pressure files. The trigger is released with
+ * psi_trigger_replace(&ptr, NULL).
+ */
+struct psi_trigger *psi_system_trigger_create(char *buf, size_t nbytes,
+					      enum psi_res res)
+{
+	return psi_trigger_create(&psi_system, buf, nbytes, res);
+}
+
 static void psi_trigger_destroy(struct kref *ref)
 {
 	struct psi_trigger *t = container_of(ref, struct psi_trigger, refcount);
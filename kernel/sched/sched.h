@@ -86,6 +86,33 @@ struct load_subtractions {
 #define NUM_TRACKED_WINDOWS 2
 #define NUM_LOAD_INDICES 1000
 
+/*
+ * Top-task updates posted to a destination rq by a wakeup migration that
+ * only holds the source rq lock. Producers reserve a slot by advancing
+ * @head; the destination folds entries in order, under its own rq lock,
+ * and advances @tail.
+ */
+#define WALT_MIG_RING_SIZE	64
+
+#define WALT_MIG_CURR		0x1
+#define WALT_MIG_PREV		0x2
+#define WALT_MIG_CWD		0x4
+
+struct walt_mig_entry {
+	u64 window_start;
+	s64 cwd_delta;
+	u16 curr_index;
+	u16 prev_index;
+	u8 flags;
+	u8 ready;
+};
+
+struct walt_mig_ring {
+	atomic_t head;
+	unsigned int tail;
+	struct walt_mig_entry slots[WALT_MIG_RING_SIZE];
+};
+
 struct sched_cluster {
 	raw_spinlock_t load_lock;
 	struct list_head list;
@@ -112,6 +139,7 @@ struct sched_cluster {
 	bool wake_up_idle;
 	u64 aggr_grp_load;
 	u64 coloc_boost_load;
+	u64 frame_load;
 };
 
 extern unsigned int sched_disable_window_stats;
@@ -1028,6 +1056,7 @@ struct rq {
 	u8 curr_table;
 	int prev_top;
 	int curr_top;
+	struct walt_mig_ring mig_ring;
 	bool notif_pending;
 	u64 last_cc_update;
 	u64 cycles;
@@ -2936,6 +2965,17 @@ struct related_thread_group {
 	struct sched_cluster *preferred_cluster;
 	struct rcu_head rcu;
 	u64 last_update;
+	/*
+	 * Frame hint set from userspace: the current frame runs from
+	 * frame_start to frame_deadline and frames repeat every
+	 * frame_period. frame_load is the load needed to finish the
+	 * remaining predicted work by the deadline.
+	 */
+	u64 frame_period;
+	u64 frame_start;
+	u64 frame_deadline;
+	u64 frame_hint_ts;
+	u64 frame_load;
 };
 
 extern struct list_head cluster_head;
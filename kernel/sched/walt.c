@@ -220,6 +220,33 @@ static int __init set_sched_ravg_window(char *str)
 
 early_param("sched_ravg_window", set_sched_ravg_window);
 
+/*
+ * Window size as configured at boot. Task history recorded before the
+ * first runtime window change is relative to it.
+ */
+static __read_mostly unsigned int sched_boot_ravg_window;
+
+/*
+ * Window size requested at runtime. walt_irq_work() switches to it at the
+ * next window rollover, with all rq locks held.
+ */
+static unsigned int new_sched_ravg_window;
+
+/*
+ * Display refresh rate the window is aligned to. The window becomes the
+ * shortest whole number of refresh periods that is at least
+ * MIN_SCHED_RAVG_WINDOW. 0 restores the boot time window.
+ */
+unsigned int sysctl_sched_ravg_window_vsync_hz;
+
+/*
+ * Long horizon predictor: an average of the task's busy time with a
+ * weight of 1/2^shift per window. The predicted demand never drops below
+ * it, so a periodic frame workload gets its frequency at the start of the
+ * window rather than one window later. 0 disables it.
+ */
+unsigned int sysctl_sched_long_pred_shift;
+
 static int __init set_sched_predl(char *str)
 {
 	unsigned int predl;
@@ -509,6 +536,7 @@ u64 freq_policy_load(struct rq *rq)
 	u64 aggr_grp_load = cluster->aggr_grp_load;
 	u64 load, tt_load = 0;
 	u64 coloc_boost_load = cluster->coloc_boost_load;
+	u64 frame_load = cluster->frame_load;
 
 	if (rq->ed_task != NULL) {
 		load = sched_ravg_window;
@@ -523,6 +551,9 @@ u64 freq_policy_load(struct rq *rq)
 	if (coloc_boost_load)
 		load = max_t(u64, load, coloc_boost_load);
 
+	if (frame_load)
+		load = max_t(u64, load, frame_load);
+
 	tt_load = top_task_load(rq);
 	switch (reporting_policy) {
 	case FREQ_REPORT_MAX_CPU_LOAD_TOP_TASK:
@@ -705,69 +736,200 @@ static u32 load_to_index(u32 load)
 	return min(index, (u32)(NUM_LOAD_INDICES - 1));
 }
 
+static inline void
+top_tasks_add(struct rq *rq, u8 table, int index, int *top_index)
+{
+	u8 *top_table = rq->top_tasks[table];
+
+	top_table[index] += 1;
+
+	if (top_table[index] == 1)
+		__set_bit(NUM_LOAD_INDICES - index - 1,
+			rq->top_tasks_bitmap[table]);
+
+	if (index > *top_index)
+		*top_index = index;
+}
+
+static inline void
+top_tasks_del(struct rq *rq, u8 table, int index, int *top_index)
+{
+	u8 *top_table = rq->top_tasks[table];
+
+	top_table[index] -= 1;
+
+	if (top_table[index])
+		return;
+
+	__clear_bit(NUM_LOAD_INDICES - index - 1, rq->top_tasks_bitmap[table]);
+
+	if (index == *top_index)
+		*top_index = get_top_index(rq->top_tasks_bitmap[table],
+					   *top_index);
+}
+
 static void
 migrate_top_tasks(struct task_struct *p, struct rq *src_rq, struct rq *dst_rq)
 {
 	int index;
-	int top_index;
 	u32 curr_window = p->ravg.curr_window;
 	u32 prev_window = p->ravg.prev_window;
 	u8 src = src_rq->curr_table;
 	u8 dst = dst_rq->curr_table;
-	u8 *src_table;
-	u8 *dst_table;
 
 	if (curr_window) {
-		src_table = src_rq->top_tasks[src];
-		dst_table = dst_rq->top_tasks[dst];
 		index = load_to_index(curr_window);
-		src_table[index] -= 1;
-		dst_table[index] += 1;
+		top_tasks_del(src_rq, src, index, &src_rq->curr_top);
+		top_tasks_add(dst_rq, dst, index, &dst_rq->curr_top);
+	}
 
-		if (!src_table[index])
-			__clear_bit(NUM_LOAD_INDICES - index - 1,
-				src_rq->top_tasks_bitmap[src]);
+	if (prev_window) {
+		index = load_to_index(prev_window);
+		top_tasks_del(src_rq, 1 - src, index, &src_rq->prev_top);
+		top_tasks_add(dst_rq, 1 - dst, index, &dst_rq->prev_top);
+	}
+}
 
-		if (dst_table[index] == 1)
-			__set_bit(NUM_LOAD_INDICES - index - 1,
-				dst_rq->top_tasks_bitmap[dst]);
+static inline bool walt_mig_pending(struct rq *rq)
+{
+	return rq->mig_ring.tail != (unsigned int)atomic_read(&rq->mig_ring.head);
+}
+
+/*
+ * Reserve a slot in @rq's migration ring. Called with the source rq lock
+ * held; the caller must fill and publish the slot before dropping it, so
+ * a consumer waiting on an unpublished slot never waits on a lock. Nothing
+ * that folds a ring, such as update_task_ravg(), may run in between.
+ */
+static struct walt_mig_entry *walt_mig_reserve(struct rq *rq)
+{
+	struct walt_mig_ring *ring = &rq->mig_ring;
+	unsigned int head = atomic_read(&ring->head);
+	unsigned int old;
 
-		if (index > dst_rq->curr_top)
-			dst_rq->curr_top = index;
+	for (;;) {
+		if (head - smp_load_acquire(&ring->tail) >= WALT_MIG_RING_SIZE)
+			return NULL;
 
-		top_index = src_rq->curr_top;
-		if (index == top_index && !src_table[index])
-			src_rq->curr_top = get_top_index(
-				src_rq->top_tasks_bitmap[src], top_index);
+		old = atomic_cmpxchg(&ring->head, head, head + 1);
+		if (old == head)
+			break;
+		head = old;
 	}
 
-	if (prev_window) {
-		src = 1 - src;
-		dst = 1 - dst;
-		src_table = src_rq->top_tasks[src];
-		dst_table = dst_rq->top_tasks[dst];
-		index = load_to_index(prev_window);
-		src_table[index] -= 1;
-		dst_table[index] += 1;
+	return &ring->slots[head & (WALT_MIG_RING_SIZE - 1)];
+}
 
-		if (!src_table[index])
-			__clear_bit(NUM_LOAD_INDICES - index - 1,
-				src_rq->top_tasks_bitmap[src]);
+static void walt_mig_apply(struct rq *rq, struct walt_mig_entry *e)
+{
+	u8 curr = rq->curr_table;
 
-		if (dst_table[index] == 1)
-			__set_bit(NUM_LOAD_INDICES - index - 1,
-				dst_rq->top_tasks_bitmap[dst]);
+	if (e->window_start == rq->window_start) {
+		if (e->flags & WALT_MIG_CURR)
+			top_tasks_add(rq, curr, e->curr_index, &rq->curr_top);
+		if (e->flags & WALT_MIG_PREV)
+			top_tasks_add(rq, 1 - curr, e->prev_index,
+				      &rq->prev_top);
+		if (e->flags & WALT_MIG_CWD)
+			walt_fixup_cum_window_demand(rq, e->cwd_delta);
+	} else if (e->window_start + sched_ravg_window == rq->window_start) {
+		/*
+		 * The destination rolled over since the entry was posted.
+		 * The task's curr window is now its prev window, the old
+		 * prev window has expired and the cumulative window demand
+		 * was rebuilt from the runnable average at rollover.
+		 */
+		if (e->flags & WALT_MIG_CURR)
+			top_tasks_add(rq, 1 - curr, e->curr_index,
+				      &rq->prev_top);
+	}
+}
 
-		if (index > dst_rq->prev_top)
-			dst_rq->prev_top = index;
+/*
+ * Fold posted migrations into @rq's top-task tables. The tables must be
+ * in sync with rq->window_start, i.e. rq->curr must have been updated in
+ * the current window. Called with rq->lock held.
+ */
+static void walt_fold_migrations(struct rq *rq)
+{
+	struct walt_mig_ring *ring = &rq->mig_ring;
+	unsigned int tail = ring->tail;
+	struct walt_mig_entry *e;
+
+	while (tail != (unsigned int)atomic_read(&ring->head)) {
+		e = &ring->slots[tail & (WALT_MIG_RING_SIZE - 1)];
+
+		/* The producer publishes under its own rq lock; not long. */
+		while (!smp_load_acquire(&e->ready))
+			cpu_relax();
 
-		top_index = src_rq->prev_top;
-		if (index == top_index && !src_table[index])
-			src_rq->prev_top = get_top_index(
-				src_rq->top_tasks_bitmap[src], top_index);
+		if (e->window_start > rq->window_start)
+			break;
+
+		walt_mig_apply(rq, e);
+		e->ready = 0;
+		smp_store_release(&ring->tail, ++tail);
 	}
 }
 
+/*
+ * A wakeup migration within a frequency domain of a task outside any
+ * related thread group only moves top-task counts and window demand
+ * between the two rqs; the busy time sums stay where they are. Post the
+ * destination half to its ring instead of taking both rq locks.
+ */
+static inline bool walt_mig_fast_ok(struct task_struct *p, int new_cpu)
+{
+	return p->state == TASK_WAKING && !p->grp && !is_ed_enabled() &&
+	       same_freq_domain(new_cpu, task_cpu(p));
+}
+
+static bool walt_fixup_busy_time_fast(struct task_struct *p,
+			struct rq *src_rq, struct rq *dest_rq)
+{
+	u64 wallclock = sched_ktime_clock();
+	struct walt_mig_entry *e;
+	u8 curr;
+	int index;
+
+	update_task_ravg(src_rq->curr, src_rq, TASK_UPDATE, wallclock, 0);
+	update_task_ravg(p, src_rq, TASK_MIGRATE, wallclock, 0);
+	update_task_cpu_cycles(p, cpu_of(dest_rq), wallclock);
+
+	/* only reserve once nothing left can fold the rings */
+	e = walt_mig_reserve(dest_rq);
+	if (!e)
+		return false;
+
+	curr = src_rq->curr_table;
+	e->window_start = src_rq->window_start;
+	e->flags = 0;
+
+	if (p->last_sleep_ts >= src_rq->window_start) {
+		walt_fixup_cum_window_demand(src_rq,
+					     -(s64)p->ravg.demand_scaled);
+		e->cwd_delta = p->ravg.demand_scaled;
+		e->flags |= WALT_MIG_CWD;
+	}
+
+	if (p->ravg.curr_window) {
+		index = load_to_index(p->ravg.curr_window);
+		top_tasks_del(src_rq, curr, index, &src_rq->curr_top);
+		e->curr_index = index;
+		e->flags |= WALT_MIG_CURR;
+	}
+
+	if (p->ravg.prev_window) {
+		index = load_to_index(p->ravg.prev_window);
+		top_tasks_del(src_rq, 1 - curr, index, &src_rq->prev_top);
+		e->prev_index = index;
+		e->flags |= WALT_MIG_PREV;
+	}
+
+	smp_store_release(&e->ready, 1);
+	return true;
+}
+
 void fixup_busy_time(struct task_struct *p, int new_cpu)
 {
 	struct rq *src_rq = task_rq(p);
@@ -788,6 +950,16 @@ void fixup_busy_time(struct task_struct *p, int new_cpu)
 		return;
 	}
 
+	if (walt_mig_fast_ok(p, new_cpu)) {
+		raw_spin_lock(&src_rq->lock);
+		if (!sched_disable_window_stats &&
+		    walt_fixup_busy_time_fast(p, src_rq, dest_rq)) {
+			raw_spin_unlock(&src_rq->lock);
+			return;
+		}
+		raw_spin_unlock(&src_rq->lock);
+	}
+
 	if (p->state == TASK_WAKING)
 		double_rq_lock(src_rq, dest_rq);
 
@@ -801,6 +973,8 @@ void fixup_busy_time(struct task_struct *p, int new_cpu)
 			 wallclock, 0);
 	update_task_ravg(dest_rq->curr, dest_rq,
 			 TASK_UPDATE, wallclock, 0);
+	walt_fold_migrations(src_rq);
+	walt_fold_migrations(dest_rq);
 
 	update_task_ravg(p, task_rq(p), TASK_MIGRATE,
 			 wallclock, 0);
@@ -1115,6 +1289,8 @@ void update_task_pred_demand(struct rq *rq, struct task_struct *p, int event)
 
 	p->ravg.pred_demand = new;
 	p->ravg.pred_demand_scaled = new_scaled;
+
+	core_ctl_kick(cpu_of(rq));
 }
 
 void clear_top_tasks_bitmap(unsigned long *bitmap)
@@ -1625,6 +1801,19 @@ static void update_cpu_busy_time(struct task_struct *p, struct rq *rq,
 }
 
 
+static inline u32 update_long_pred(struct task_struct *p, u32 runtime)
+{
+	unsigned int shift = sysctl_sched_long_pred_shift;
+
+	if (!sched_predl || !shift)
+		return 0;
+
+	p->ravg.long_pred = p->ravg.long_pred - (p->ravg.long_pred >> shift) +
+			    (runtime >> shift);
+
+	return p->ravg.long_pred;
+}
+
 static inline u32 predict_and_update_buckets(struct rq *rq,
 			struct task_struct *p, u32 runtime) {
 
@@ -1732,6 +1921,7 @@ static void update_history(struct rq *rq, struct task_struct *p,
 			demand = max(avg, runtime);
 	}
 	pred_demand = predict_and_update_buckets(rq, p, runtime);
+	pred_demand = max(pred_demand, update_long_pred(p, runtime));
 	demand_scaled = scale_demand(demand);
 	pred_demand_scaled = scale_demand(pred_demand);
 
@@ -1759,6 +1949,9 @@ static void update_history(struct rq *rq, struct task_struct *p,
 	p->ravg.demand = demand;
 	p->ravg.demand_scaled = demand_scaled;
 	p->ravg.coloc_demand = div64_u64(sum, sched_ravg_hist_size);
+	if (pred_demand_scaled > p->ravg.pred_demand_scaled)
+		core_ctl_kick(cpu_of(rq));
+
 	p->ravg.pred_demand = pred_demand;
 	p->ravg.pred_demand_scaled = pred_demand_scaled;
 
@@ -1956,6 +2149,39 @@ static inline void run_walt_irq_work(u64 old_window_start, struct rq *rq)
 		irq_work_queue(&walt_cpufreq_irq_work);
 }
 
+static inline u32 walt_rescale(u32 val, u32 new, u32 old)
+{
+	return div64_u64((u64)val * new, old);
+}
+
+/*
+ * Bring a task's demand history over to a window size change. The history
+ * holds busy time per window, so scale it by the ratio of the window
+ * sizes; that keeps demand_scaled unchanged and the rq-wide sums built
+ * from it consistent. curr_window/prev_window are left alone as they are
+ * mirrored in the rq busy time sums and age out within two windows.
+ */
+static void walt_rescale_task_window(struct task_struct *p)
+{
+	u32 old = p->ravg.window_size ?: sched_boot_ravg_window;
+	u32 new = sched_ravg_window;
+	int i;
+
+	p->ravg.window_size = new;
+	if (old == new)
+		return;
+
+	for (i = 0; i < RAVG_HIST_SIZE_MAX; i++)
+		p->ravg.sum_history[i] =
+			walt_rescale(p->ravg.sum_history[i], new, old);
+
+	p->ravg.sum = min(walt_rescale(p->ravg.sum, new, old), new);
+	p->ravg.demand = walt_rescale(p->ravg.demand, new, old);
+	p->ravg.coloc_demand = walt_rescale(p->ravg.coloc_demand, new, old);
+	p->ravg.pred_demand = walt_rescale(p->ravg.pred_demand, new, old);
+	p->ravg.long_pred = walt_rescale(p->ravg.long_pred, new, old);
+}
+
 /* Reflect task activity on its demand and cpu's busy time statistics */
 void update_task_ravg(struct task_struct *p, struct rq *rq, int event,
 						u64 wallclock, u64 irqtime)
@@ -1970,6 +2196,19 @@ void update_task_ravg(struct task_struct *p, struct rq *rq, int event,
 
 	old_window_start = update_window_start(rq, wallclock, event);
 
+	if (unlikely(p->ravg.window_size != sched_ravg_window))
+		walt_rescale_task_window(p);
+
+	/*
+	 * Migrations posted by other CPUs must be folded in before any
+	 * task on this rq touches the top-task tables. Bring rq->curr
+	 * into the current window first so the tables have rolled over.
+	 */
+	if (p != rq->curr && walt_mig_pending(rq)) {
+		update_task_ravg(rq->curr, rq, TASK_UPDATE, wallclock, 0);
+		walt_fold_migrations(rq);
+	}
+
 	if (!p->ravg.mark_start) {
 		update_task_cpu_cycles(p, cpu_of(rq), wallclock);
 		goto done;
@@ -1991,6 +2230,9 @@ void update_task_ravg(struct task_struct *p, struct rq *rq, int event,
 done:
 	p->ravg.mark_start = wallclock;
 
+	if (p == rq->curr && walt_mig_pending(rq))
+		walt_fold_migrations(rq);
+
 	run_walt_irq_work(old_window_start, rq);
 }
 
@@ -2034,6 +2276,7 @@ void init_new_task_load(struct task_struct *p)
 		init_load_windows_scaled = scale_demand(init_load_windows);
 	}
 
+	p->ravg.window_size = sched_ravg_window;
 	p->ravg.demand = init_load_windows;
 	p->ravg.demand_scaled = init_load_windows_scaled;
 	p->ravg.coloc_demand = init_load_windows;
@@ -2340,6 +2583,7 @@ struct sched_cluster init_cluster = {
 	.wake_up_idle		=	0,
 	.aggr_grp_load		=	0,
 	.coloc_boost_load	=	0,
+	.frame_load		=	0,
 };
 
 void init_clusters(void)
@@ -2537,7 +2781,7 @@ group_will_fit(struct sched_cluster *cluster, struct related_thread_group *grp,
 	if (group_boost)
 		return 0;
 
-	if (!demand)
+	if (!demand && !grp->frame_load)
 		return 1;
 
 	if (grp->preferred_cluster)
@@ -2546,6 +2790,10 @@ group_will_fit(struct sched_cluster *cluster, struct related_thread_group *grp,
 	if (cluster->capacity < prev_capacity)
 		threshold = sched_group_downmigrate;
 
+	/* The cluster cannot finish the frame in time even at fmax */
+	if (scale_load_to_cpu(grp->frame_load, cpu) >= threshold)
+		return 0;
+
 	load = scale_load_to_cpu(demand, cpu);
 	if (load < threshold)
 		return 1;
@@ -2865,6 +3113,229 @@ unsigned int sched_get_group_id(struct task_struct *p)
 	return group_id;
 }
 
+/*
+ * A frame hint is dropped once it has not been refreshed for this many
+ * frame periods.
+ */
+#define FRAME_HINT_TIMEOUT_FRAMES	8
+
+/* Number of related thread groups with a frame hint */
+static atomic_t walt_frame_hints = ATOMIC_INIT(0);
+
+bool sched_frame_hint_active(void)
+{
+	return atomic_read(&walt_frame_hints) > 0;
+}
+
+static void clear_frame_hint(struct related_thread_group *grp)
+{
+	if (!grp->frame_period)
+		return;
+
+	grp->frame_period = 0;
+	grp->frame_load = 0;
+	atomic_dec(&walt_frame_hints);
+}
+
+/*
+ * Attach a frame period and the deadline of the current frame, relative to
+ * now, to the related thread group of @p. A deadline of 0 means one period
+ * from now; a period of 0 removes the hint.
+ */
+int sched_set_frame_hint(struct task_struct *p, u64 period_ns, u64 deadline_ns)
+{
+	struct related_thread_group *grp;
+	unsigned long flags;
+	int rc = 0;
+	u64 now;
+
+	if (period_ns && (period_ns < NSEC_PER_MSEC ||
+			  period_ns > MAX_SCHED_RAVG_WINDOW ||
+			  deadline_ns > period_ns))
+		return -EINVAL;
+
+	rcu_read_lock();
+	grp = task_related_thread_group(p);
+	if (!grp) {
+		rc = -EINVAL;
+		goto out;
+	}
+
+	raw_spin_lock_irqsave(&grp->lock, flags);
+	if (!period_ns) {
+		clear_frame_hint(grp);
+	} else {
+		if (!grp->frame_period)
+			atomic_inc(&walt_frame_hints);
+
+		now = sched_ktime_clock();
+		grp->frame_period = period_ns;
+		grp->frame_start = now;
+		grp->frame_deadline = now + (deadline_ns ?: period_ns);
+		grp->frame_hint_ts = now;
+	}
+	raw_spin_unlock_irqrestore(&grp->lock, flags);
+out:
+	rcu_read_unlock();
+	return rc;
+}
+
+int sched_get_frame_hint(struct task_struct *p, u64 *period_ns,
+			 u64 *remaining_ns)
+{
+	struct related_thread_group *grp;
+	unsigned long flags;
+	u64 now;
+
+	*period_ns = *remaining_ns = 0;
+
+	rcu_read_lock();
+	grp = task_related_thread_group(p);
+	if (grp) {
+		raw_spin_lock_irqsave(&grp->lock, flags);
+		now = sched_ktime_clock();
+		*period_ns = grp->frame_period;
+		if (grp->frame_period && grp->frame_deadline > now)
+			*remaining_ns = grp->frame_deadline - now;
+		raw_spin_unlock_irqrestore(&grp->lock, flags);
+	}
+	rcu_read_unlock();
+
+	return grp ? 0 : -EINVAL;
+}
+
+/*
+ * Work the group still has to do in the current frame, per frame, at the
+ * maximum capacity. The predicted work is the demand of the group's recently
+ * active tasks converted from a window to a frame period; subtract what the
+ * tasks have run since the frame started, approximated from their busy time
+ * in the current and previous window.
+ */
+static u64 frame_remaining_work(struct related_thread_group *grp,
+				u64 wallclock, u64 window_start)
+{
+	struct task_struct *p;
+	u64 work = 0, done = 0;
+	u64 overlap = 0;
+	u32 curr, prev;
+
+	if (grp->frame_start < window_start)
+		overlap = min_t(u64, window_start - grp->frame_start,
+				sched_ravg_window);
+
+	list_for_each_entry(p, &grp->tasks, grp_list) {
+		if (p->ravg.mark_start < wallclock -
+		    (sched_ravg_window * sched_ravg_hist_size))
+			continue;
+
+		work += max(p->ravg.demand, p->ravg.pred_demand);
+
+		if (p->ravg.mark_start >= window_start) {
+			curr = p->ravg.curr_window;
+			prev = p->ravg.prev_window;
+		} else if (p->ravg.mark_start >= window_start -
+						sched_ravg_window) {
+			curr = 0;
+			prev = p->ravg.curr_window;
+		} else {
+			continue;
+		}
+
+		done += curr;
+		if (overlap)
+			done += div64_u64((u64)prev * overlap,
+					  sched_ravg_window);
+	}
+
+	work = div64_u64(work * grp->frame_period, sched_ravg_window);
+
+	return work > done ? work - done : 0;
+}
+
+static void update_frame_load(struct related_thread_group *grp,
+			      u64 wallclock, u64 window_start)
+{
+	u64 period = grp->frame_period;
+	u64 remaining, left;
+	u64 nr_frames;
+
+	if (wallclock - grp->frame_hint_ts >
+			FRAME_HINT_TIMEOUT_FRAMES * period) {
+		clear_frame_hint(grp);
+		return;
+	}
+
+	/* Userspace did not post the next frame; assume it is periodic */
+	if (wallclock >= grp->frame_deadline) {
+		nr_frames = div64_u64(wallclock - grp->frame_deadline,
+				      period);
+		grp->frame_start = grp->frame_deadline + nr_frames * period;
+		grp->frame_deadline = grp->frame_start + period;
+	}
+
+	remaining = frame_remaining_work(grp, wallclock, window_start);
+	left = max_t(u64, grp->frame_deadline - wallclock, 1);
+
+	grp->frame_load = min_t(u64, div64_u64(remaining * sched_ravg_window,
+					       left), sched_ravg_window);
+}
+
+/*
+ * Refresh the frame load of every group with a frame hint and re-evaluate
+ * its preferred cluster. The group lock nests outside the rq lock, so this
+ * must be called before walt_irq_work() takes the rq locks.
+ */
+static void walt_update_frame_loads(void)
+{
+	struct related_thread_group *grp;
+	u64 wallclock, window_start;
+	int i;
+
+	if (!sched_frame_hint_active())
+		return;
+
+	wallclock = sched_ktime_clock();
+	window_start = this_rq()->window_start;
+
+	for (i = 1; i < MAX_NUM_CGROUP_COLOC_ID; i++) {
+		grp = lookup_related_thread_group(i);
+		if (!grp || !READ_ONCE(grp->frame_period))
+			continue;
+
+		raw_spin_lock(&grp->lock);
+		if (grp->frame_period) {
+			update_frame_load(grp, wallclock, window_start);
+			_set_preferred_cluster(grp);
+		}
+		raw_spin_unlock(&grp->lock);
+	}
+}
+
+/* Apply the frame load of each hinted group to its preferred cluster */
+static void walt_apply_frame_loads(void)
+{
+	struct related_thread_group *grp;
+	struct sched_cluster *cluster;
+	u64 frame_load;
+	int i;
+
+	if (!sched_frame_hint_active())
+		return;
+
+	for (i = 1; i < MAX_NUM_CGROUP_COLOC_ID; i++) {
+		grp = lookup_related_thread_group(i);
+		if (!grp)
+			continue;
+
+		frame_load = READ_ONCE(grp->frame_load);
+		cluster = READ_ONCE(grp->preferred_cluster);
+		if (!frame_load || !cluster)
+			continue;
+
+		cluster->frame_load = max(cluster->frame_load, frame_load);
+	}
+}
+
 #if defined(CONFIG_SCHED_TUNE)
 /*
  * We create a default colocation group at boot. There is no need to
@@ -3165,6 +3636,72 @@ int sched_little_cluster_coloc_fmin_khz_handler(struct ctl_table *table,
 	return ret;
 }
 
+/* Recompute everything derived from sched_ravg_window */
+static void walt_tunables_fixup(void)
+{
+	walt_cpu_util_freq_divisor =
+	    (sched_ravg_window >> SCHED_CAPACITY_SHIFT) * 100;
+	walt_scale_demand_divisor = sched_ravg_window >> SCHED_CAPACITY_SHIFT;
+
+	sched_init_task_load_windows =
+		div64_u64((u64)sysctl_sched_init_task_load_pct *
+			  (u64)sched_ravg_window, 100);
+	sched_init_task_load_windows_scaled =
+		scale_demand(sched_init_task_load_windows);
+}
+
+/*
+ * Switch to a window size requested through sched_ravg_window_vsync_hz.
+ * Called with all rq locks held right after every rq has been brought up
+ * to the same window_start, so the new windows start from a common
+ * boundary. Task history is rescaled lazily by update_task_ravg().
+ */
+static void walt_update_window_size(void)
+{
+	unsigned int window = READ_ONCE(new_sched_ravg_window);
+
+	if (!window || window == sched_ravg_window)
+		return;
+
+	sched_ravg_window = window;
+	walt_tunables_fixup();
+	walt_map_freq_to_load();
+}
+
+static unsigned int walt_vsync_window(unsigned int hz)
+{
+	u32 period;
+
+	if (!hz)
+		return sched_boot_ravg_window;
+
+	period = NSEC_PER_SEC / hz;
+
+	return min_t(u64, (u64)DIV_ROUND_UP(MIN_SCHED_RAVG_WINDOW, period) *
+		     period, MAX_SCHED_RAVG_WINDOW);
+}
+
+int sched_ravg_window_vsync_handler(struct ctl_table *table, int write,
+				    void __user *buffer, size_t *lenp,
+				    loff_t *ppos)
+{
+	int ret;
+	static DEFINE_MUTEX(mutex);
+
+	mutex_lock(&mutex);
+
+	ret = proc_dointvec_minmax(table, write, buffer, lenp, ppos);
+	if (ret || !write)
+		goto done;
+
+	WRITE_ONCE(new_sched_ravg_window,
+		   walt_vsync_window(sysctl_sched_ravg_window_vsync_hz));
+
+done:
+	mutex_unlock(&mutex);
+	return ret;
+}
+
 /*
  * Runs in hard-irq context. This should ideally run just after the latest
  * window roll-over.
@@ -3183,6 +3720,9 @@ void walt_irq_work(struct irq_work *irq_work)
 	if (irq_work == &walt_migration_irq_work)
 		is_migration = true;
 
+	if (!is_migration)
+		walt_update_frame_loads();
+
 	for_each_cpu(cpu, cpu_possible_mask) {
 		if (level == 0)
 			raw_spin_lock(&cpu_rq(cpu)->lock);
@@ -3211,6 +3751,8 @@ void walt_irq_work(struct irq_work *irq_work)
 		cluster->aggr_grp_load = aggr_grp_load;
 		total_grp_load += aggr_grp_load;
 		cluster->coloc_boost_load = 0;
+		if (!is_migration)
+			cluster->frame_load = 0;
 
 		raw_spin_unlock(&cluster->load_lock);
 	}
@@ -3218,6 +3760,9 @@ void walt_irq_work(struct irq_work *irq_work)
 	if (total_grp_load)
 		walt_update_coloc_boost_load();
 
+	if (!is_migration)
+		walt_apply_frame_loads();
+
 	for_each_sched_cluster(cluster) {
 		cpumask_t cluster_online_cpus;
 		unsigned int num_cpus, i = 1;
@@ -3247,6 +3792,9 @@ void walt_irq_work(struct irq_work *irq_work)
 		}
 	}
 
+	if (!is_migration)
+		walt_update_window_size();
+
 	for_each_cpu(cpu, cpu_possible_mask)
 		raw_spin_unlock(&cpu_rq(cpu)->lock);
 
@@ -3267,6 +3815,30 @@ void walt_rotation_checkpoint(int nr_big)
 	walt_rotation_enabled = nr_big >= num_possible_cpus();
 }
 
+/*
+ * Predicted CPU utilization %: the larger of the summed predicted demand of
+ * the runnable tasks and the biggest task of the last window.
+ */
+unsigned int walt_cpu_pred_util(int cpu)
+{
+	struct rq *rq = cpu_rq(cpu);
+	unsigned long capacity = capacity_orig_of(cpu);
+	unsigned long flags;
+	u64 util;
+
+	if (walt_disabled)
+		return 0;
+
+	raw_spin_lock_irqsave(&rq->lock, flags);
+	util = max_t(u64, rq->walt_stats.pred_demands_sum_scaled,
+		     scale_demand(top_task_load(rq)));
+	raw_spin_unlock_irqrestore(&rq->lock, flags);
+
+	util = min_t(u64, util, capacity);
+
+	return div64_u64(util * 100, capacity);
+}
+
 unsigned int walt_get_default_coloc_group_load(void)
 {
 	struct related_thread_group *grp;
@@ -3344,15 +3916,8 @@ static void walt_init_once(void)
 	init_irq_work(&walt_cpufreq_irq_work, walt_irq_work);
 	walt_rotate_work_init();
 
-	walt_cpu_util_freq_divisor =
-	    (sched_ravg_window >> SCHED_CAPACITY_SHIFT) * 100;
-	walt_scale_demand_divisor = sched_ravg_window >> SCHED_CAPACITY_SHIFT;
-
-	sched_init_task_load_windows =
-		div64_u64((u64)sysctl_sched_init_task_load_pct *
-			  (u64)sched_ravg_window, 100);
-	sched_init_task_load_windows_scaled =
-		scale_demand(sched_init_task_load_windows);
+	sched_boot_ravg_window = sched_ravg_window;
+	walt_tunables_fixup();
 }
 
 void walt_sched_init_rq(struct rq *rq)
@@ -3395,6 +3960,9 @@ void walt_sched_init_rq(struct rq *rq)
 	rq->curr_table = 0;
 	rq->prev_top = 0;
 	rq->curr_top = 0;
+	atomic_set(&rq->mig_ring.head, 0);
+	rq->mig_ring.tail = 0;
+	memset(rq->mig_ring.slots, 0, sizeof(rq->mig_ring.slots));
 	rq->last_cc_update = 0;
 	rq->cycles = 0;
 	for (j = 0; j < NUM_TRACKED_WINDOWS; j++) {
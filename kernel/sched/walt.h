@@ -220,6 +220,20 @@ static inline unsigned int max_task_load(void)
 	return sched_ravg_window;
 }
 
+/*
+ * A busy CPU with its tick stopped does not roll its window over until it
+ * schedules again, and nobody else does it for it while the rest of the
+ * system idles. Keep one tick per window so that its load still reaches
+ * cpufreq; the busy time in between is caught up by that tick.
+ */
+static inline u64 walt_max_tick_deferment(struct rq *rq)
+{
+	u64 next = READ_ONCE(rq->window_start) + sched_ravg_window;
+	u64 now = sched_ktime_clock();
+
+	return now < next ? next - now : 0;
+}
+
 static inline u32 cpu_cycles_to_freq(u64 cycles, u64 period)
 {
 	return div64_u64(cycles, period);
@@ -304,6 +318,7 @@ extern void walt_rotate_work_init(void);
 extern void walt_rotation_checkpoint(int nr_big);
 extern unsigned int walt_rotation_enabled;
 extern unsigned int walt_get_default_coloc_group_load(void);
+extern unsigned int walt_cpu_pred_util(int cpu);
 
 extern __read_mostly bool sched_freq_aggr_en;
 static inline void walt_enable_frequency_aggregation(bool enable)
@@ -322,6 +337,10 @@ static inline unsigned int walt_get_default_coloc_group_load(void)
 {
 	return 0;
 }
+static inline unsigned int walt_cpu_pred_util(int cpu)
+{
+	return 0;
+}
 
 static inline void update_task_ravg(struct task_struct *p, struct rq *rq,
 				int event, u64 wallclock, u64 irqtime) { }
@@ -361,6 +380,7 @@ static inline void init_new_task_load(struct task_struct *p)
 
 static inline void mark_task_starting(struct task_struct *p) { }
 static inline void set_window_start(struct rq *rq) { }
+static inline u64 walt_max_tick_deferment(struct rq *rq) { return U64_MAX; }
 static inline int sched_cpu_high_irqload(int cpu) { return 0; }
 
 static inline void sched_account_irqstart(int cpu, struct task_struct *curr,
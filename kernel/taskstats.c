@@ -31,6 +31,7 @@
 #include <net/genetlink.h>
 #include <linux/atomic.h>
 #include <linux/sched/cputime.h>
+#include <linux/cpufreq_times.h>
 
 /*
  * Maximum length of a cpumask that can be specified in
@@ -168,7 +169,8 @@ static void send_cpu_listeners(struct sk_buff *skb,
 
 static void fill_stats(struct user_namespace *user_ns,
 		       struct pid_namespace *pid_ns,
-		       struct task_struct *tsk, struct taskstats *stats)
+		       struct task_struct *tsk, struct taskstats *stats,
+		       u64 *energy)
 {
 	memset(stats, 0, sizeof(*stats));
 	/*
@@ -188,9 +190,12 @@ static void fill_stats(struct user_namespace *user_ns,
 
 	/* fill in extended acct fields */
 	xacct_add_tsk(stats, tsk);
+
+	if (energy)
+		*energy = cpufreq_task_cpu_energy(tsk);
 }
 
-static int fill_stats_for_pid(pid_t pid, struct taskstats *stats)
+static int fill_stats_for_pid(pid_t pid, struct taskstats *stats, u64 *energy)
 {
 	struct task_struct *tsk;
 
@@ -201,12 +206,14 @@ static int fill_stats_for_pid(pid_t pid, struct taskstats *stats)
 	rcu_read_unlock();
 	if (!tsk)
 		return -ESRCH;
-	fill_stats(current_user_ns(), task_active_pid_ns(current), tsk, stats);
+	fill_stats(current_user_ns(), task_active_pid_ns(current), tsk, stats,
+		   energy);
 	put_task_struct(tsk);
 	return 0;
 }
 
-static int fill_stats_for_tgid(pid_t tgid, struct taskstats *stats)
+static int fill_stats_for_tgid(pid_t tgid, struct taskstats *stats,
+			       u64 *energy)
 {
 	struct task_struct *tsk, *first;
 	unsigned long flags;
@@ -228,6 +235,8 @@ static int fill_stats_for_tgid(pid_t tgid, struct taskstats *stats)
 		memcpy(stats, first->signal->stats, sizeof(*stats));
 	else
 		memset(stats, 0, sizeof(*stats));
+	if (energy)
+		*energy = first->signal->cpu_energy;
 
 	tsk = first;
 	start_time = ktime_get_ns();
@@ -241,6 +250,8 @@ static int fill_stats_for_tgid(pid_t tgid, struct taskstats *stats)
 		 *	per-task-foo(stats, tsk);
 		 */
 		delayacct_add_tsk(stats, tsk);
+		if (energy)
+			*energy += cpufreq_task_cpu_energy(tsk);
 
 		/* calculate task elapsed time in nsec */
 		delta = start_time - tsk->start_time;
@@ -284,6 +295,7 @@ static void fill_tgid_exit(struct task_struct *tsk)
 	 *	per-task-foo(tsk->signal->stats, tsk);
 	 */
 	delayacct_add_tsk(tsk->signal->stats, tsk);
+	tsk->signal->cpu_energy += cpufreq_task_cpu_energy(tsk);
 ret:
 	spin_unlock_irqrestore(&tsk->sighand->siglock, flags);
 	return;
@@ -370,9 +382,14 @@ static int parse(struct nlattr *na, struct cpumask *mask)
 	return ret;
 }
 
-static struct taskstats *mk_reply(struct sk_buff *skb, int type, u32 pid)
+/*
+ * The cpu energy estimate goes into its own attribute of the aggregate, so
+ * that struct taskstats keeps the layout of upstream's version.
+ */
+static struct taskstats *mk_reply(struct sk_buff *skb, int type, u32 pid,
+				  u64 **energy)
 {
-	struct nlattr *na, *ret;
+	struct nlattr *na, *ret, *nrg;
 	int aggr;
 
 	aggr = (type == TASKSTATS_TYPE_PID)
@@ -393,6 +410,17 @@ static struct taskstats *mk_reply(struct sk_buff *skb, int type, u32 pid)
 		nla_nest_cancel(skb, na);
 		goto err;
 	}
+	*energy = NULL;
+	if (IS_ENABLED(CONFIG_CPU_FREQ_TIMES)) {
+		nrg = nla_reserve_64bit(skb, TASKSTATS_TYPE_CPU_ENERGY,
+					sizeof(u64), TASKSTATS_TYPE_NULL);
+		if (!nrg) {
+			nla_nest_cancel(skb, na);
+			goto err;
+		}
+		*energy = nla_data(nrg);
+		**energy = 0;
+	}
 	nla_nest_end(skb, na);
 
 	return nla_data(ret);
@@ -489,6 +517,8 @@ static size_t taskstats_packet_size(void)
 	size = nla_total_size(sizeof(u32)) +
 		nla_total_size_64bit(sizeof(struct taskstats)) +
 		nla_total_size(0);
+	if (IS_ENABLED(CONFIG_CPU_FREQ_TIMES))
+		size += nla_total_size_64bit(sizeof(u64));
 
 	return size;
 }
@@ -498,6 +528,7 @@ static int cmd_attr_pid(struct genl_info *info)
 	struct taskstats *stats;
 	struct sk_buff *rep_skb;
 	size_t size;
+	u64 *energy;
 	u32 pid;
 	int rc;
 
@@ -509,11 +540,11 @@ static int cmd_attr_pid(struct genl_info *info)
 
 	rc = -EINVAL;
 	pid = nla_get_u32(info->attrs[TASKSTATS_CMD_ATTR_PID]);
-	stats = mk_reply(rep_skb, TASKSTATS_TYPE_PID, pid);
+	stats = mk_reply(rep_skb, TASKSTATS_TYPE_PID, pid, &energy);
 	if (!stats)
 		goto err;
 
-	rc = fill_stats_for_pid(pid, stats);
+	rc = fill_stats_for_pid(pid, stats, energy);
 	if (rc < 0)
 		goto err;
 	return send_reply(rep_skb, info);
@@ -527,6 +558,7 @@ static int cmd_attr_tgid(struct genl_info *info)
 	struct taskstats *stats;
 	struct sk_buff *rep_skb;
 	size_t size;
+	u64 *energy;
 	u32 tgid;
 	int rc;
 
@@ -538,11 +570,11 @@ static int cmd_attr_tgid(struct genl_info *info)
 
 	rc = -EINVAL;
 	tgid = nla_get_u32(info->attrs[TASKSTATS_CMD_ATTR_TGID]);
-	stats = mk_reply(rep_skb, TASKSTATS_TYPE_TGID, tgid);
+	stats = mk_reply(rep_skb, TASKSTATS_TYPE_TGID, tgid, &energy);
 	if (!stats)
 		goto err;
 
-	rc = fill_stats_for_tgid(tgid, stats);
+	rc = fill_stats_for_tgid(tgid, stats, energy);
 	if (rc < 0)
 		goto err;
 	return send_reply(rep_skb, info);
@@ -605,6 +637,7 @@ void taskstats_exit(struct task_struct *tsk, int group_dead)
 	struct taskstats *stats;
 	struct sk_buff *rep_skb;
 	size_t size;
+	u64 *energy;
 	int is_thread_group;
 
 	if (!family_registered)
@@ -632,11 +665,11 @@ void taskstats_exit(struct task_struct *tsk, int group_dead)
 		return;
 
 	stats = mk_reply(rep_skb, TASKSTATS_TYPE_PID,
-			 task_pid_nr_ns(tsk, &init_pid_ns));
+			 task_pid_nr_ns(tsk, &init_pid_ns), &energy);
 	if (!stats)
 		goto err;
 
-	fill_stats(&init_user_ns, &init_pid_ns, tsk, stats);
+	fill_stats(&init_user_ns, &init_pid_ns, tsk, stats, energy);
 
 	/*
 	 * Doesn't matter if tsk is the leader or the last group member leaving
@@ -645,11 +678,13 @@ void taskstats_exit(struct task_struct *tsk, int group_dead)
 		goto send;
 
 	stats = mk_reply(rep_skb, TASKSTATS_TYPE_TGID,
-			 task_tgid_nr_ns(tsk, &init_pid_ns));
+			 task_tgid_nr_ns(tsk, &init_pid_ns), &energy);
 	if (!stats)
 		goto err;
 
 	memcpy(stats, tsk->signal->stats, sizeof(*stats));
+	if (energy)
+		*energy = tsk->signal->cpu_energy;
 
 send:
 	send_cpu_listeners(rep_skb, listeners);
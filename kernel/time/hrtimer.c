@@ -963,6 +963,36 @@ static inline ktime_t hrtimer_update_lowres(struct hrtimer *timer, ktime_t tim,
 	return tim;
 }
 
+/*
+ * Timers with at least sysctl_hrtimer_align_ns of slack get their hard
+ * expiry pulled in to a multiple of it on the monotonic clock. Slack only
+ * lets timers which happen to be close together fire at once; aligned,
+ * the timers of idle background tasks on all CPUs of a cluster share
+ * their wakeups and the cluster sees fewer, longer idle periods. The soft
+ * expiry is left alone, the timer never fires earlier than it asked for.
+ */
+unsigned int sysctl_hrtimer_align_ns __read_mostly;
+
+static inline void hrtimer_align_expires(struct hrtimer *timer,
+					 struct hrtimer_clock_base *base,
+					 u64 delta_ns)
+{
+	u64 align = READ_ONCE(sysctl_hrtimer_align_ns);
+	ktime_t hard;
+	u64 rem;
+
+	if (!align || delta_ns < align)
+		return;
+
+	hard = ktime_sub(hrtimer_get_expires(timer), base->offset);
+	if (hard <= 0 || hard == KTIME_MAX)
+		return;
+
+	/* rem < align <= delta_ns keeps the hard expiry after the soft one */
+	div64_u64_rem(hard, align, &rem);
+	timer->node.expires = ktime_add(ktime_sub_ns(hard, rem), base->offset);
+}
+
 /**
  * hrtimer_start_range_ns - (re)start an hrtimer on the current CPU
  * @timer:	the timer to be added
@@ -992,6 +1022,7 @@ void hrtimer_start_range_ns(struct hrtimer *timer, ktime_t tim,
 	tim = hrtimer_update_lowres(timer, tim, mode);
 
 	hrtimer_set_expires_range_ns(timer, tim, delta_ns);
+	hrtimer_align_expires(timer, base, delta_ns);
 
 	/* Switch the timer base, if necessary: */
 	new_base = switch_hrtimer_base(timer, base, mode & HRTIMER_MODE_PINNED);
@@ -27,6 +27,7 @@
 #include <linux/wait.h>
 #include <linux/delay.h>
 #include <linux/completion.h>
+#include <linux/rcupdate.h>
 #include <linux/sched/clock.h>
 #include <linux/ipc_logging.h>
 
@@ -296,8 +297,18 @@ void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 		return;
 	}
 
-	read_lock_irqsave(&context_list_lock_lha1, flags);
-	spin_lock(&ilctxt->context_lock_lhb1);
+	/*
+	 * Only the context lock is taken here: the context list lock is
+	 * shared by all contexts and would bounce between the CPUs of every
+	 * logger. ipc_log_context_destroy() waits for writers that already
+	 * run with interrupts off, and later ones see @destroyed.
+	 */
+	spin_lock_irqsave(&ilctxt->context_lock_lhb1, flags);
+	if (unlikely(ilctxt->destroyed)) {
+		spin_unlock_irqrestore(&ilctxt->context_lock_lhb1, flags);
+		return;
+	}
+
 	while (ilctxt->write_avail <= ectxt->offset)
 		msg_drop(ilctxt);
 
@@ -316,8 +327,8 @@ void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 
 		ilctxt->write_page = get_next_page(ilctxt, ilctxt->write_page);
 		if (WARN_ON(ilctxt->write_page == NULL)) {
-			spin_unlock(&ilctxt->context_lock_lhb1);
-			read_unlock_irqrestore(&context_list_lock_lha1, flags);
+			spin_unlock_irqrestore(&ilctxt->context_lock_lhb1,
+					       flags);
 			return;
 		}
 		ilctxt->write_page->hdr.write_offset = 0;
@@ -330,9 +341,12 @@ void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 	}
 	ilctxt->write_page->hdr.write_offset += bytes_to_write;
 	ilctxt->write_avail -= ectxt->offset;
-	complete(&ilctxt->read_avail);
-	spin_unlock(&ilctxt->context_lock_lhb1);
-	read_unlock_irqrestore(&context_list_lock_lha1, flags);
+	/* the reader only waits once it has found the log empty */
+	if (!ilctxt->read_avail_signaled) {
+		ilctxt->read_avail_signaled = true;
+		complete(&ilctxt->read_avail);
+	}
+	spin_unlock_irqrestore(&ilctxt->context_lock_lhb1, flags);
 }
 EXPORT_SYMBOL(ipc_log_write);
 
@@ -580,10 +594,12 @@ int ipc_log_extract(void *ctxt, char *buff, int size)
 	}
 	ret = size - dctxt.size;
 	if (ret == 0) {
-		if (!ilctxt->destroyed)
+		if (!ilctxt->destroyed) {
 			reinit_completion(&ilctxt->read_avail);
-		else
+			ilctxt->read_avail_signaled = false;
+		} else {
 			ret = -EIO;
+		}
 	}
 done:
 	spin_unlock(&ilctxt->context_lock_lhb1);
@@ -911,19 +927,22 @@ int ipc_log_context_destroy(void *ctxt)
 
 	debugfs_remove_recursive(ilctxt->dent);
 
-	spin_lock(&ilctxt->context_lock_lhb1);
+	spin_lock_irqsave(&ilctxt->context_lock_lhb1, flags);
 	ilctxt->destroyed = true;
 	complete_all(&ilctxt->read_avail);
 	list_for_each_entry_safe(df_info, tmp, &ilctxt->dfunc_info_list, list) {
 		list_del(&df_info->list);
 		kfree(df_info);
 	}
-	spin_unlock(&ilctxt->context_lock_lhb1);
+	spin_unlock_irqrestore(&ilctxt->context_lock_lhb1, flags);
 
 	write_lock_irqsave(&context_list_lock_lha1, flags);
 	list_del(&ilctxt->list);
 	write_unlock_irqrestore(&context_list_lock_lha1, flags);
 
+	/* let writers still spinning on the context lock leave */
+	synchronize_sched();
+
 	ipc_log_context_put(ilctxt);
 
 	return 0;
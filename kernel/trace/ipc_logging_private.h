@@ -95,6 +95,8 @@ struct ipc_log_page {
  * @dfunc_info_list:  List of deserialization functions
  * @context_lock_lhb1:  Lock for entire structure
  * @read_avail:  Completed when new data is added to the log
+ * @read_avail_signaled:  @read_avail completed since the reader last
+ *			  found the log empty
  */
 struct ipc_log_context {
 	uint32_t magic;
@@ -119,6 +121,7 @@ struct ipc_log_context {
 	struct list_head dfunc_info_list;
 	spinlock_t context_lock_lhb1;
 	struct completion read_avail;
+	bool read_avail_signaled;
 	struct kref refcount;
 	bool destroyed;
 };
@@ -29,6 +29,9 @@
 #include <linux/msm_rtb.h>
 #include <asm/timex.h>
 #include <soc/qcom/minidump.h>
+#include <trace/events/irq.h>
+#include <trace/events/power.h>
+#include <trace/events/sched.h>
 
 #define SENTINEL_BYTE_1 0xFF
 #define SENTINEL_BYTE_2 0xAA
@@ -240,6 +243,59 @@ noinline int notrace uncached_logk(enum logk_event_type log_type, void *data)
 }
 EXPORT_SYMBOL(uncached_logk);
 
+/*
+ * Scheduler, IRQ and power events recorded from their tracepoints, so the
+ * last moments before a watchdog or hang reset can be reconstructed from
+ * the buffer left in RAM. Each costs one entry; the probes are only
+ * registered if the event is in the filter at boot.
+ */
+#define RTB_TRACE_EVENTS	((1 << LOGK_SCHED) | (1 << LOGK_IRQ) | \
+				 (1 << LOGK_CPUFREQ) | (1 << LOGK_IDLE))
+
+static void notrace msm_rtb_sched_switch(void *data, bool preempt,
+					 struct task_struct *prev,
+					 struct task_struct *next)
+{
+	uncached_logk_pc(LOGK_SCHED, (void *)(unsigned long)prev->pid,
+			 (void *)(unsigned long)next->pid);
+}
+
+static void notrace msm_rtb_irq_entry(void *data, int irq,
+				      struct irqaction *action)
+{
+	uncached_logk_pc(LOGK_IRQ, action->handler,
+			 (void *)(unsigned long)irq);
+}
+
+static void notrace msm_rtb_cpu_frequency(void *data, unsigned int freq,
+					  unsigned int cpu)
+{
+	uncached_logk_pc(LOGK_CPUFREQ, (void *)(unsigned long)cpu,
+			 (void *)(unsigned long)freq);
+}
+
+static void notrace msm_rtb_cpu_idle(void *data, unsigned int state,
+				     unsigned int cpu)
+{
+	uncached_logk_pc(LOGK_IDLE, (void *)(unsigned long)cpu,
+			 (void *)(unsigned long)state);
+}
+
+static void msm_rtb_register_trace_events(void)
+{
+	if (msm_rtb.filter & (1 << LOGK_SCHED))
+		WARN_ON(register_trace_sched_switch(msm_rtb_sched_switch,
+						    NULL));
+	if (msm_rtb.filter & (1 << LOGK_IRQ))
+		WARN_ON(register_trace_irq_handler_entry(msm_rtb_irq_entry,
+							 NULL));
+	if (msm_rtb.filter & (1 << LOGK_CPUFREQ))
+		WARN_ON(register_trace_cpu_frequency(msm_rtb_cpu_frequency,
+						     NULL));
+	if (msm_rtb.filter & (1 << LOGK_IDLE))
+		WARN_ON(register_trace_cpu_idle(msm_rtb_cpu_idle, NULL));
+}
+
 static int msm_rtb_probe(struct platform_device *pdev)
 {
 	struct msm_rtb_platform_data *d = pdev->dev.platform_data;
@@ -317,6 +373,11 @@ static int msm_rtb_probe(struct platform_device *pdev)
 	atomic_notifier_chain_register(&panic_notifier_list,
 						&msm_rtb_panic_blk);
 	msm_rtb.initialized = 1;
+
+	if (IS_ENABLED(CONFIG_TRACEPOINTS) &&
+	    (msm_rtb.filter & RTB_TRACE_EVENTS))
+		msm_rtb_register_trace_events();
+
 	return 0;
 }
 
@@ -16,6 +16,7 @@
 
 #include <linux/module.h>
 #include <linux/kallsyms.h>
+#include <linux/math64.h>
 #include <linux/mutex.h>
 #include <linux/slab.h>
 #include <linux/stacktrace.h>
@@ -34,6 +35,8 @@ struct hist_field {
 	hist_field_fn_t			fn;
 	unsigned int			size;
 	unsigned int			offset;
+	hist_field_fn_t			val_fn;	/* raw value, log2/buckets */
+	u64				buckets;
 };
 
 static u64 hist_field_none(struct hist_field *field, void *event)
@@ -71,11 +74,18 @@ static u64 hist_field_pstring(struct hist_field *hist_field, void *event)
 
 static u64 hist_field_log2(struct hist_field *hist_field, void *event)
 {
-	u64 val = *(u64 *)(event + hist_field->field->offset);
+	u64 val = hist_field->val_fn(hist_field, event);
 
 	return (u64) ilog2(roundup_pow_of_two(val));
 }
 
+static u64 hist_field_bucket(struct hist_field *hist_field, void *event)
+{
+	u64 val = hist_field->val_fn(hist_field, event);
+
+	return div64_u64(val, hist_field->buckets) * hist_field->buckets;
+}
+
 #define DEFINE_HIST_FIELD_FN(type)					\
 static u64 hist_field_##type(struct hist_field *hist_field, void *event)\
 {									\
@@ -120,6 +130,7 @@ enum hist_field_flags {
 	HIST_FIELD_FL_SYSCALL		= 128,
 	HIST_FIELD_FL_STACKTRACE	= 256,
 	HIST_FIELD_FL_LOG2		= 512,
+	HIST_FIELD_FL_BUCKET		= 1024,
 };
 
 struct hist_trigger_attrs {
@@ -367,8 +378,17 @@ static struct hist_field *create_hist_field(struct ftrace_event_field *field,
 		goto out;
 	}
 
-	if (flags & HIST_FIELD_FL_LOG2) {
-		hist_field->fn = hist_field_log2;
+	if (flags & (HIST_FIELD_FL_LOG2 | HIST_FIELD_FL_BUCKET)) {
+		hist_field->val_fn = select_value_fn(field->size,
+						     field->is_signed);
+		if (!hist_field->val_fn) {
+			destroy_hist_field(hist_field);
+			return NULL;
+		}
+		if (flags & HIST_FIELD_FL_LOG2)
+			hist_field->fn = hist_field_log2;
+		else
+			hist_field->fn = hist_field_bucket;
 		goto out;
 	}
 
@@ -516,6 +536,7 @@ static int create_key_field(struct hist_trigger_data *hist_data,
 	struct ftrace_event_field *field = NULL;
 	unsigned long flags = 0;
 	unsigned int key_size;
+	u64 buckets = 0;
 	int ret = 0;
 
 	if (WARN_ON(key_idx >= TRACING_MAP_FIELDS_MAX))
@@ -543,7 +564,14 @@ static int create_key_field(struct hist_trigger_data *hist_data,
 				flags |= HIST_FIELD_FL_SYSCALL;
 			else if (strcmp(field_str, "log2") == 0)
 				flags |= HIST_FIELD_FL_LOG2;
-			else {
+			else if (strncmp(field_str, "buckets=", 8) == 0) {
+				if (kstrtoull(field_str + 8, 0, &buckets) ||
+				    !buckets) {
+					ret = -EINVAL;
+					goto out;
+				}
+				flags |= HIST_FIELD_FL_BUCKET;
+			} else {
 				ret = -EINVAL;
 				goto out;
 			}
@@ -566,6 +594,7 @@ static int create_key_field(struct hist_trigger_data *hist_data,
 		ret = -ENOMEM;
 		goto out;
 	}
+	hist_data->fields[key_idx]->buckets = buckets;
 
 	key_size = ALIGN(key_size, sizeof(u64));
 	hist_data->fields[key_idx]->size = key_size;
@@ -1003,6 +1032,10 @@ hist_trigger_entry_print(struct seq_file *m,
 		} else if (key_field->flags & HIST_FIELD_FL_LOG2) {
 			seq_printf(m, "%s: ~ 2^%-2llu", key_field->field->name,
 				   *(u64 *)(key + key_field->offset));
+		} else if (key_field->flags & HIST_FIELD_FL_BUCKET) {
+			uval = *(u64 *)(key + key_field->offset);
+			seq_printf(m, "%s: ~ %llu-%llu", key_field->field->name,
+				   uval, uval + key_field->buckets - 1);
 		} else if (key_field->flags & HIST_FIELD_FL_STRING) {
 			seq_printf(m, "%s: %-50s", key_field->field->name,
 				   (char *)(key + key_field->offset));
@@ -1137,6 +1170,8 @@ static const char *get_hist_field_flags(struct hist_field *hist_field)
 		flags_str = "syscall";
 	else if (hist_field->flags & HIST_FIELD_FL_LOG2)
 		flags_str = "log2";
+	else if (hist_field->flags & HIST_FIELD_FL_BUCKET)
+		flags_str = "buckets";
 
 	return flags_str;
 }
@@ -1149,6 +1184,8 @@ static void hist_field_print(struct seq_file *m, struct hist_field *hist_field)
 
 		if (flags_str)
 			seq_printf(m, ".%s", flags_str);
+		if (hist_field->flags & HIST_FIELD_FL_BUCKET)
+			seq_printf(m, "=%llu", hist_field->buckets);
 	}
 }
 
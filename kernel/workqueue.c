@@ -294,6 +294,13 @@ module_param_named(disable_numa, wq_disable_numa, bool, 0444);
 static bool wq_power_efficient = IS_ENABLED(CONFIG_WQ_POWER_EFFICIENT_DEFAULT);
 module_param_named(power_efficient, wq_power_efficient, bool, 0444);
 
+/*
+ * CPUs that unbound WQ_POWER_EFFICIENT workqueues are confined to, as a
+ * cpulist, e.g. the little cluster.  Unset means wq_unbound_cpumask.
+ */
+static char *wq_power_efficient_cpus;
+module_param_named(power_efficient_cpus, wq_power_efficient_cpus, charp, 0444);
+
 static bool wq_online;			/* can kworkers be created yet? */
 
 static bool wq_numa_enabled;		/* unbound NUMA affinity enabled */
@@ -340,6 +347,10 @@ static struct workqueue_attrs *unbound_std_wq_attrs[NR_STD_WORKER_POOLS];
 /* I: attributes used when instantiating ordered pools on demand */
 static struct workqueue_attrs *ordered_wq_attrs[NR_STD_WORKER_POOLS];
 
+/* I: as above for WQ_POWER_EFFICIENT wqs, NULL without power_efficient_cpus */
+static struct workqueue_attrs *unbound_pe_wq_attrs[NR_STD_WORKER_POOLS];
+static struct workqueue_attrs *ordered_pe_wq_attrs[NR_STD_WORKER_POOLS];
+
 struct workqueue_struct *system_wq __read_mostly;
 EXPORT_SYMBOL(system_wq);
 struct workqueue_struct *system_highpri_wq __read_mostly;
@@ -3968,6 +3979,7 @@ static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
 static int alloc_and_link_pwqs(struct workqueue_struct *wq)
 {
 	bool highpri = wq->flags & WQ_HIGHPRI;
+	bool pe = (wq->flags & WQ_POWER_EFFICIENT) && unbound_pe_wq_attrs[0];
 	int cpu, ret;
 
 	if (!(wq->flags & WQ_UNBOUND)) {
@@ -3989,14 +4001,18 @@ static int alloc_and_link_pwqs(struct workqueue_struct *wq)
 		}
 		return 0;
 	} else if (wq->flags & __WQ_ORDERED) {
-		ret = apply_workqueue_attrs(wq, ordered_wq_attrs[highpri]);
+		ret = apply_workqueue_attrs(wq, pe ?
+					    ordered_pe_wq_attrs[highpri] :
+					    ordered_wq_attrs[highpri]);
 		/* there should only be single pwq for ordering guarantee */
 		WARN(!ret && (wq->pwqs.next != &wq->dfl_pwq->pwqs_node ||
 			      wq->pwqs.prev != &wq->dfl_pwq->pwqs_node),
 		     "ordering guarantee broken for workqueue %s\n", wq->name);
 		return ret;
 	} else {
-		return apply_workqueue_attrs(wq, unbound_std_wq_attrs[highpri]);
+		return apply_workqueue_attrs(wq, pe ?
+					     unbound_pe_wq_attrs[highpri] :
+					     unbound_std_wq_attrs[highpri]);
 	}
 }
 
@@ -5674,6 +5690,44 @@ static void __init wq_numa_init(void)
 	wq_numa_enabled = true;
 }
 
+/*
+ * Build the attrs WQ_POWER_EFFICIENT workqueues use once they are unbound,
+ * restricted to workqueue.power_efficient_cpus.  A bad or empty list is
+ * ignored and those workqueues stay on wq_unbound_cpumask.
+ */
+static void __init wq_init_power_efficient_attrs(void)
+{
+	cpumask_var_t mask;
+	int i;
+
+	BUG_ON(!alloc_cpumask_var(&mask, GFP_KERNEL));
+	if (cpulist_parse(wq_power_efficient_cpus, mask) ||
+	    !cpumask_intersects(mask, cpu_possible_mask)) {
+		pr_warn("workqueue: ignoring power_efficient_cpus=%s\n",
+			wq_power_efficient_cpus);
+		goto out;
+	}
+
+	for (i = 0; i < NR_STD_WORKER_POOLS; i++) {
+		struct workqueue_attrs *attrs;
+
+		BUG_ON(!(attrs = alloc_workqueue_attrs(GFP_KERNEL)));
+		copy_workqueue_attrs(attrs, unbound_std_wq_attrs[i]);
+		cpumask_and(attrs->cpumask, mask, cpu_possible_mask);
+		unbound_pe_wq_attrs[i] = attrs;
+
+		BUG_ON(!(attrs = alloc_workqueue_attrs(GFP_KERNEL)));
+		copy_workqueue_attrs(attrs, ordered_wq_attrs[i]);
+		cpumask_and(attrs->cpumask, mask, cpu_possible_mask);
+		ordered_pe_wq_attrs[i] = attrs;
+	}
+
+	pr_info("workqueue: power efficient workqueues limited to CPUs %*pbl\n",
+		cpumask_pr_args(unbound_pe_wq_attrs[0]->cpumask));
+out:
+	free_cpumask_var(mask);
+}
+
 /**
  * workqueue_init_early - early init for workqueue subsystem
  *
@@ -5734,6 +5788,9 @@ int __init workqueue_init_early(void)
 		ordered_wq_attrs[i] = attrs;
 	}
 
+	if (wq_power_efficient_cpus)
+		wq_init_power_efficient_attrs();
+
 	system_wq = alloc_workqueue("events", 0, 0);
 	system_highpri_wq = alloc_workqueue("events_highpri", WQ_HIGHPRI, 0);
 	system_long_wq = alloc_workqueue("events_long", 0, 0);
@@ -28,6 +28,7 @@
 #include <linux/memblock.h>
 #include <linux/err.h>
 #include <linux/mm.h>
+#include <linux/module.h>
 #include <linux/mutex.h>
 #include <linux/sizes.h>
 #include <linux/slab.h>
@@ -45,6 +46,14 @@ struct cma cma_areas[MAX_CMA_AREAS];
 unsigned cma_area_count;
 static DEFINE_MUTEX(cma_mutex);
 
+/*
+ * After a successful cma_alloc(), stop handing out the zone's free CMA
+ * pages to movable allocations for this long, so that a burst of CMA
+ * allocations does not keep migrating pages that were just put back.
+ */
+static unsigned int hot_ms;
+module_param(hot_ms, uint, 0644);
+
 phys_addr_t cma_get_base(const struct cma *cma)
 {
 	return PFN_PHYS(cma->base_pfn);
@@ -544,6 +553,10 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align,
 
 	trace_cma_alloc(pfn, page, count, align);
 
+	if (page && hot_ms)
+		WRITE_ONCE(page_zone(page)->cma_hot_until,
+			   jiffies + msecs_to_jiffies(hot_ms));
+
 	if (ret && !(gfp_mask & __GFP_NOWARN)) {
 		pr_info("%s: alloc failed, req-size: %zu pages, ret: %d\n",
 			__func__, count, ret);
@@ -1319,6 +1319,69 @@ static inline bool is_via_compact_memory(int order)
 	return order == -1;
 }
 
+/*
+ * Proactive compaction: with vm.compaction_proactiveness set, kcompactd
+ * wakes up every PROACTIVE_FRAG_CHECK_INTERVAL_MSEC and compacts the node
+ * in the background whenever its fragmentation score rises above a target
+ * derived from the tunable, so that high order allocations find free
+ * blocks instead of stalling in direct compaction.
+ *
+ * The score is the share of free memory unusable for an order
+ * PROACTIVE_COMPACTION_ORDER allocation, weighted by zone size. The order
+ * is the smallest "costly" one, which is where ION, KGSL and network
+ * drivers start to stall, rather than a huge page.
+ */
+#define PROACTIVE_COMPACTION_ORDER	(PAGE_ALLOC_COSTLY_ORDER + 1)
+#define PROACTIVE_FRAG_CHECK_INTERVAL_MSEC	500
+
+int sysctl_compaction_proactiveness __read_mostly;
+
+static inline bool kswapd_is_running(pg_data_t *pgdat)
+{
+	return pgdat->kswapd && (pgdat->kswapd->state == TASK_RUNNING);
+}
+
+static unsigned int fragmentation_score_zone(struct zone *zone)
+{
+	unsigned long score;
+
+	score = zone->present_pages *
+			extfrag_for_order(zone, PROACTIVE_COMPACTION_ORDER);
+	return div64_ul(score, zone->zone_pgdat->node_present_pages + 1);
+}
+
+static unsigned int fragmentation_score_node(pg_data_t *pgdat)
+{
+	unsigned int score = 0;
+	int zoneid;
+
+	for (zoneid = 0; zoneid < MAX_NR_ZONES; zoneid++)
+		score += fragmentation_score_zone(&pgdat->node_zones[zoneid]);
+
+	return score;
+}
+
+static unsigned int fragmentation_score_wmark(bool low)
+{
+	unsigned int wmark_low;
+
+	/*
+	 * Cap the low watermark to avoid excessive compaction activity
+	 * when the tunable is set close to 100.
+	 */
+	wmark_low = max(100U - sysctl_compaction_proactiveness, 5U);
+	return low ? wmark_low : min(wmark_low + 10, 100U);
+}
+
+static bool should_proactive_compact_node(pg_data_t *pgdat)
+{
+	if (!sysctl_compaction_proactiveness || kswapd_is_running(pgdat))
+		return false;
+
+	return fragmentation_score_node(pgdat) >
+		fragmentation_score_wmark(false);
+}
+
 static enum compact_result __compact_finished(struct zone *zone,
 						struct compact_control *cc)
 {
@@ -1348,6 +1411,19 @@ static enum compact_result __compact_finished(struct zone *zone,
 			return COMPACT_PARTIAL_SKIPPED;
 	}
 
+	if (cc->proactive_compaction) {
+		pg_data_t *pgdat = zone->zone_pgdat;
+
+		if (kswapd_is_running(pgdat))
+			return COMPACT_PARTIAL_SKIPPED;
+
+		if (fragmentation_score_zone(zone) >
+		    fragmentation_score_wmark(true))
+			return COMPACT_CONTINUE;
+
+		return COMPACT_SUCCESS;
+	}
+
 	if (is_via_compact_memory(cc->order))
 		return COMPACT_CONTINUE;
 
@@ -1851,6 +1927,35 @@ static void compact_node(int nid)
 	}
 }
 
+static void proactive_compact_node(pg_data_t *pgdat)
+{
+	int zoneid;
+	struct zone *zone;
+	struct compact_control cc = {
+		.order = -1,
+		.mode = MIGRATE_SYNC_LIGHT,
+		.ignore_skip_hint = true,
+		.whole_zone = true,
+		.gfp_mask = GFP_KERNEL,
+		.proactive_compaction = true,
+	};
+
+	count_compact_event(KCOMPACTD_PROACTIVE);
+
+	for (zoneid = 0; zoneid < MAX_NR_ZONES; zoneid++) {
+		zone = &pgdat->node_zones[zoneid];
+		if (!populated_zone(zone))
+			continue;
+
+		cc.zone = zone;
+
+		compact_zone(zone, &cc);
+
+		VM_BUG_ON(!list_empty(&cc.freepages));
+		VM_BUG_ON(!list_empty(&cc.migratepages));
+	}
+}
+
 /* Compact all nodes in the system */
 static void compact_nodes(void)
 {
@@ -1879,6 +1984,31 @@ int sysctl_compaction_handler(struct ctl_table *table, int write,
 	return 0;
 }
 
+int compaction_proactiveness_sysctl_handler(struct ctl_table *table,
+		int write, void __user *buffer, size_t *length, loff_t *ppos)
+{
+	int old = sysctl_compaction_proactiveness;
+	int ret, nid;
+
+	ret = proc_dointvec_minmax(table, write, buffer, length, ppos);
+	if (ret || !write)
+		return ret;
+
+	/* kcompactd sleeps without a timeout while this is off, kick it */
+	if (!old && sysctl_compaction_proactiveness) {
+		for_each_online_node(nid) {
+			pg_data_t *pgdat = NODE_DATA(nid);
+
+			if (!pgdat->kcompactd)
+				continue;
+			WRITE_ONCE(pgdat->proactive_compact_trigger, true);
+			wake_up_interruptible(&pgdat->kcompactd_wait);
+		}
+	}
+
+	return 0;
+}
+
 int sysctl_extfrag_handler(struct ctl_table *table, int write,
 			void __user *buffer, size_t *length, loff_t *ppos)
 {
@@ -1918,7 +2048,8 @@ void compaction_unregister_node(struct node *node)
 
 static inline bool kcompactd_work_requested(pg_data_t *pgdat)
 {
-	return pgdat->kcompactd_max_order > 0 || kthread_should_stop();
+	return pgdat->kcompactd_max_order > 0 || kthread_should_stop() ||
+		READ_ONCE(pgdat->proactive_compact_trigger);
 }
 
 static bool kcompactd_node_suitable(pg_data_t *pgdat)
@@ -2045,6 +2176,7 @@ static int kcompactd(void *p)
 {
 	pg_data_t *pgdat = (pg_data_t*)p;
 	struct task_struct *tsk = current;
+	unsigned int proactive_defer = 0;
 
 	const struct cpumask *cpumask = cpumask_of_node(pgdat->node_id);
 
@@ -2058,14 +2190,42 @@ static int kcompactd(void *p)
 
 	while (!kthread_should_stop()) {
 		unsigned long pflags;
+		unsigned int prev_score, score;
+		long timeout;
+
+		timeout = sysctl_compaction_proactiveness ?
+			msecs_to_jiffies(PROACTIVE_FRAG_CHECK_INTERVAL_MSEC) :
+			MAX_SCHEDULE_TIMEOUT;
 
 		trace_mm_compaction_kcompactd_sleep(pgdat->node_id);
-		wait_event_freezable(pgdat->kcompactd_wait,
-				kcompactd_work_requested(pgdat));
+		if (wait_event_freezable_timeout(pgdat->kcompactd_wait,
+				kcompactd_work_requested(pgdat), timeout) &&
+		    !READ_ONCE(pgdat->proactive_compact_trigger)) {
+			psi_memstall_enter(&pflags);
+			kcompactd_do_work(pgdat);
+			psi_memstall_leave(&pflags);
+			continue;
+		}
+
+		/* kcompactd wait timeout, or proactive compaction turned on */
+		WRITE_ONCE(pgdat->proactive_compact_trigger, false);
+		if (!should_proactive_compact_node(pgdat))
+			continue;
 
+		if (proactive_defer) {
+			proactive_defer--;
+			continue;
+		}
+
+		prev_score = fragmentation_score_node(pgdat);
 		psi_memstall_enter(&pflags);
-		kcompactd_do_work(pgdat);
+		proactive_compact_node(pgdat);
 		psi_memstall_leave(&pflags);
+		score = fragmentation_score_node(pgdat);
+
+		/* back off for a while if no progress was made */
+		proactive_defer = score < prev_score ?
+				0 : 1 << COMPACT_MAX_DEFER_SHIFT;
 	}
 
 	return 0;
@@ -72,6 +72,7 @@ static DEFINE_MUTEX(khugepaged_mutex);
 /* default scan 8*512 pte (or vmas) every 30 second */
 static unsigned int khugepaged_pages_to_scan __read_mostly;
 static unsigned int khugepaged_pages_collapsed;
+static unsigned int khugepaged_file_pages_collapsed;
 static unsigned int khugepaged_full_scans;
 static unsigned int khugepaged_scan_sleep_millisecs __read_mostly = 10000;
 /* during fragmentation poll the hugepage allocator once every minute */
@@ -213,6 +214,15 @@ static ssize_t pages_collapsed_show(struct kobject *kobj,
 static struct kobj_attribute pages_collapsed_attr =
 	__ATTR_RO(pages_collapsed);
 
+static ssize_t file_pages_collapsed_show(struct kobject *kobj,
+					 struct kobj_attribute *attr,
+					 char *buf)
+{
+	return sprintf(buf, "%u\n", khugepaged_file_pages_collapsed);
+}
+static struct kobj_attribute file_pages_collapsed_attr =
+	__ATTR_RO(file_pages_collapsed);
+
 static ssize_t full_scans_show(struct kobject *kobj,
 			       struct kobj_attribute *attr,
 			       char *buf)
@@ -304,6 +314,7 @@ static struct attribute *khugepaged_attr[] = {
 	&khugepaged_max_ptes_none_attr.attr,
 	&pages_to_scan_attr.attr,
 	&pages_collapsed_attr.attr,
+	&file_pages_collapsed_attr.attr,
 	&full_scans_attr.attr,
 	&scan_sleep_millisecs_attr.attr,
 	&alloc_sleep_millisecs_attr.attr,
@@ -446,17 +457,43 @@ int __khugepaged_enter(struct mm_struct *mm)
 	return 0;
 }
 
+/*
+ * Executable text of a regular file that opted in with MADV_HUGEPAGE.
+ * Only read-only mappings of files nobody has open for write qualify,
+ * so a collapsed huge page never has to be dirtied or written back.
+ */
+static bool file_thp_vma_check(struct vm_area_struct *vma,
+			       unsigned long vm_flags)
+{
+	struct inode *inode;
+
+	if (!IS_ENABLED(CONFIG_READ_ONLY_THP_FOR_FS) || !vma->vm_file)
+		return false;
+	if ((vm_flags & (VM_HUGEPAGE | VM_EXEC | VM_WRITE)) !=
+	    (VM_HUGEPAGE | VM_EXEC))
+		return false;
+	if (shmem_file(vma->vm_file))
+		return false;
+	inode = vma->vm_file->f_mapping->host;
+	if (!S_ISREG(inode->i_mode) || atomic_read(&inode->i_writecount) > 0)
+		return false;
+	return IS_ALIGNED((vma->vm_start >> PAGE_SHIFT) - vma->vm_pgoff,
+			  HPAGE_PMD_NR);
+}
+
 int khugepaged_enter_vma_merge(struct vm_area_struct *vma,
 			       unsigned long vm_flags)
 {
 	unsigned long hstart, hend;
-	if (!vma->anon_vma)
+	bool file_text = file_thp_vma_check(vma, vm_flags);
+
+	if (!vma->anon_vma && !file_text)
 		/*
 		 * Not yet faulted in so we will register later in the
 		 * page fault if needed.
 		 */
 		return 0;
-	if (vma->vm_ops || (vm_flags & VM_NO_KHUGEPAGED))
+	if ((vma->vm_ops && !file_text) || (vm_flags & VM_NO_KHUGEPAGED))
 		/* khugepaged not yet working on file or special mappings */
 		return 0;
 	hstart = (vma->vm_start + ~HPAGE_PMD_MASK) & HPAGE_PMD_MASK;
@@ -859,6 +896,8 @@ static bool hugepage_vma_check(struct vm_area_struct *vma)
 		return IS_ALIGNED((vma->vm_start >> PAGE_SHIFT) - vma->vm_pgoff,
 				HPAGE_PMD_NR);
 	}
+	if (file_thp_vma_check(vma, vma->vm_flags))
+		return true;
 	if (!vma->anon_vma || vma->vm_ops)
 		return false;
 	if (is_vma_temporary_stack(vma))
@@ -1331,7 +1370,7 @@ static void retract_page_tables(struct address_space *mapping, pgoff_t pgoff)
 }
 
 /**
- * collapse_shmem - collapse small tmpfs/shmem pages into huge one.
+ * collapse_file - collapse small tmpfs/shmem or file text pages into huge one.
  *
  * Basic scheme is simple, details are more complex:
  *  - allocate and lock a new huge page;
@@ -1347,8 +1386,12 @@ static void retract_page_tables(struct address_space *mapping, pgoff_t pgoff)
  *    + put all pages back and unfreeze them;
  *    + restore gaps in the radix-tree;
  *    + unlock and free huge page;
+ *
+ * Pages of a regular file can't be instantiated here, so for those every
+ * page must already be cached, uptodate and clean, and the file must not
+ * be open for write.
  */
-static void collapse_shmem(struct mm_struct *mm,
+static void collapse_file(struct mm_struct *mm,
 		struct address_space *mapping, pgoff_t start,
 		struct page **hpage, int node)
 {
@@ -1360,8 +1403,10 @@ static void collapse_shmem(struct mm_struct *mm,
 	struct radix_tree_iter iter;
 	void **slot;
 	int nr_none = 0, result = SCAN_SUCCEED;
+	bool is_shmem = shmem_mapping(mapping);
 
 	VM_BUG_ON(start & (HPAGE_PMD_NR - 1));
+	VM_BUG_ON(!IS_ENABLED(CONFIG_READ_ONLY_THP_FOR_FS) && !is_shmem);
 
 	/* Only allocate from the target node */
 	gfp = alloc_hugepage_khugepaged_gfpmask() | __GFP_THISNODE;
@@ -1380,7 +1425,8 @@ static void collapse_shmem(struct mm_struct *mm,
 	}
 
 	__SetPageLocked(new_page);
-	__SetPageSwapBacked(new_page);
+	if (is_shmem)
+		__SetPageSwapBacked(new_page);
 	new_page->index = start;
 	new_page->mapping = mapping;
 
@@ -1408,7 +1454,12 @@ static void collapse_shmem(struct mm_struct *mm,
 		/*
 		 * Handle holes in the radix tree: charge it from shmem and
 		 * insert relevant subpage of new_page into the radix-tree.
+		 * A hole in a regular file is data we don't have.
 		 */
+		if (n && !is_shmem) {
+			result = SCAN_EXCEED_NONE_PTE;
+			goto tree_locked;
+		}
 		if (n && !shmem_charge(mapping->host, n)) {
 			result = SCAN_FAIL;
 			goto tree_locked;
@@ -1426,6 +1477,10 @@ static void collapse_shmem(struct mm_struct *mm,
 		page = radix_tree_deref_slot_protected(slot,
 				&mapping->tree_lock);
 		if (radix_tree_exceptional_entry(page) || !PageUptodate(page)) {
+			if (!is_shmem) {
+				result = SCAN_FAIL;
+				goto tree_locked;
+			}
 			spin_unlock_irq(&mapping->tree_lock);
 			/* swap in or instantiate fallocated page */
 			if (shmem_getpage(mapping->host, index, &page,
@@ -1462,6 +1517,17 @@ static void collapse_shmem(struct mm_struct *mm,
 			goto out_unlock;
 		}
 
+		if (!is_shmem && (PageDirty(page) || PageWriteback(page))) {
+			result = SCAN_FAIL;
+			goto out_unlock;
+		}
+
+		if (page_has_private(page) &&
+		    !try_to_release_page(page, GFP_KERNEL)) {
+			result = SCAN_FAIL;
+			goto out_unlock;
+		}
+
 		if (isolate_lru_page(page)) {
 			result = SCAN_DEL_PAGE_LRU;
 			goto out_unlock;
@@ -1523,6 +1589,10 @@ static void collapse_shmem(struct mm_struct *mm,
 			result = SCAN_TRUNCATED;
 			goto tree_locked;
 		}
+		if (!is_shmem) {
+			result = SCAN_EXCEED_NONE_PTE;
+			goto tree_locked;
+		}
 		if (!shmem_charge(mapping->host, n)) {
 			result = SCAN_FAIL;
 			goto tree_locked;
@@ -1534,7 +1604,22 @@ static void collapse_shmem(struct mm_struct *mm,
 		nr_none += n;
 	}
 
-	__inc_node_page_state(new_page, NR_SHMEM_THPS);
+	if (is_shmem) {
+		__inc_node_page_state(new_page, NR_SHMEM_THPS);
+	} else {
+		/*
+		 * Publish the huge page before looking at i_writecount, pairs
+		 * with get_write_access() in do_dentry_open().
+		 */
+		filemap_nr_thps_inc(mapping);
+		smp_mb__after_atomic();
+		if (atomic_read(&mapping->host->i_writecount) > 0) {
+			filemap_nr_thps_dec(mapping);
+			result = SCAN_FAIL;
+			goto tree_locked;
+		}
+		__inc_node_page_state(new_page, NR_FILE_THPS);
+	}
 	if (nr_none) {
 		struct zone *zone = page_zone(new_page);
 
@@ -1575,9 +1660,14 @@ static void collapse_shmem(struct mm_struct *mm,
 
 		SetPageUptodate(new_page);
 		page_ref_add(new_page, HPAGE_PMD_NR - 1);
-		set_page_dirty(new_page);
 		mem_cgroup_commit_charge(new_page, memcg, false, true);
-		lru_cache_add_anon(new_page);
+		if (is_shmem) {
+			set_page_dirty(new_page);
+			lru_cache_add_anon(new_page);
+		} else {
+			lru_cache_add_file(new_page);
+			khugepaged_file_pages_collapsed++;
+		}
 
 		/*
 		 * Remove pte page tables, so we can re-fault the page as huge.
@@ -1588,7 +1678,8 @@ static void collapse_shmem(struct mm_struct *mm,
 		/* Something went wrong: rollback changes to the radix-tree */
 		spin_lock_irq(&mapping->tree_lock);
 		mapping->nrpages -= nr_none;
-		shmem_uncharge(mapping->host, nr_none);
+		if (is_shmem)
+			shmem_uncharge(mapping->host, nr_none);
 
 		radix_tree_for_each_slot(slot, &mapping->page_tree, &iter,
 				start) {
@@ -1632,7 +1723,7 @@ static void collapse_shmem(struct mm_struct *mm,
 	/* TODO: tracepoints */
 }
 
-static void khugepaged_scan_shmem(struct mm_struct *mm,
+static void khugepaged_scan_file(struct mm_struct *mm,
 		struct address_space *mapping,
 		pgoff_t start, struct page **hpage)
 {
@@ -1658,6 +1749,11 @@ static void khugepaged_scan_shmem(struct mm_struct *mm,
 		}
 
 		if (radix_tree_exception(page)) {
+			/* a shadow entry of a regular file is just a hole */
+			if (!shmem_mapping(mapping)) {
+				result = SCAN_EXCEED_NONE_PTE;
+				break;
+			}
 			if (++swap > khugepaged_max_ptes_swap) {
 				result = SCAN_EXCEED_SWAP_PTE;
 				break;
@@ -1682,7 +1778,8 @@ static void khugepaged_scan_shmem(struct mm_struct *mm,
 			break;
 		}
 
-		if (page_count(page) != 1 + page_mapcount(page)) {
+		if (page_count(page) !=
+		    1 + page_mapcount(page) + page_has_private(page)) {
 			result = SCAN_PAGE_COUNT;
 			break;
 		}
@@ -1703,18 +1800,20 @@ static void khugepaged_scan_shmem(struct mm_struct *mm,
 	rcu_read_unlock();
 
 	if (result == SCAN_SUCCEED) {
-		if (present < HPAGE_PMD_NR - khugepaged_max_ptes_none) {
+		if (!shmem_mapping(mapping) && present < HPAGE_PMD_NR) {
+			result = SCAN_EXCEED_NONE_PTE;
+		} else if (present < HPAGE_PMD_NR - khugepaged_max_ptes_none) {
 			result = SCAN_EXCEED_NONE_PTE;
 		} else {
 			node = khugepaged_find_target_node();
-			collapse_shmem(mm, mapping, start, hpage, node);
+			collapse_file(mm, mapping, start, hpage, node);
 		}
 	}
 
 	/* TODO: tracepoints */
 }
 #else
-static void khugepaged_scan_shmem(struct mm_struct *mm,
+static void khugepaged_scan_file(struct mm_struct *mm,
 		struct address_space *mapping,
 		pgoff_t start, struct page **hpage)
 {
@@ -1789,16 +1888,18 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages,
 			VM_BUG_ON(khugepaged_scan.address < hstart ||
 				  khugepaged_scan.address + HPAGE_PMD_SIZE >
 				  hend);
-			if (shmem_file(vma->vm_file)) {
+			if (shmem_file(vma->vm_file) ||
+			    file_thp_vma_check(vma, vma->vm_flags)) {
 				struct file *file;
 				pgoff_t pgoff = linear_page_index(vma,
 						khugepaged_scan.address);
-				if (!shmem_huge_enabled(vma))
+				if (shmem_file(vma->vm_file) &&
+				    !shmem_huge_enabled(vma))
 					goto skip;
 				file = get_file(vma->vm_file);
 				up_read(&mm->mmap_sem);
 				ret = 1;
-				khugepaged_scan_shmem(mm, file->f_mapping,
+				khugepaged_scan_file(mm, file->f_mapping,
 						pgoff, hpage);
 				fput(file);
 			} else {
@@ -0,0 +1,440 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Record and replay of page cache reads during app launch.
+ *
+ * A cold launch of the same app reads the same ranges of the same files
+ * in the same order every time. While a launch is being recorded, every
+ * range that readahead has to bring in for the launching process is
+ * logged as (device, inode, page range). When the launch ends the log is
+ * sorted and merged into the profile of its uid. The next launch of that
+ * uid first replays the profile from a worker as plain asynchronous
+ * readahead, so the I/O is issued in large, file ordered batches ahead of
+ * the app.
+ *
+ * Userspace drives it through /proc/launch_readahead:
+ *   echo "start <pid>" - replay the profile of <pid>'s uid, then record
+ *                        its reads for launch_window_ms
+ *   echo "stop"        - end the current recording early
+ *   echo "clear"       - drop all profiles
+ * Reading the file lists the stored profiles.
+ */
+
+#define pr_fmt(fmt) "launch_ra: " fmt
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/mm.h>
+#include <linux/fs.h>
+#include <linux/blkdev.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/uaccess.h>
+#include <linux/cred.h>
+#include <linux/sched/task.h>
+#include <linux/workqueue.h>
+#include <linux/launch_readahead.h>
+
+#include "internal.h"
+
+#define LAUNCH_RA_MAX_ENTRIES	2048
+#define LAUNCH_RA_MAX_PROFILES	32
+/* same chunking as force_page_cache_readahead() */
+#define LAUNCH_RA_CHUNK		((2 * 1024 * 1024) / PAGE_SIZE)
+
+/* How long after "start" the reads of a launch are recorded */
+static unsigned int launch_window_ms = 5000;
+module_param(launch_window_ms, uint, 0644);
+
+struct launch_ra_entry {
+	dev_t dev;
+	u32 gen;
+	unsigned long ino;
+	pgoff_t start;
+	unsigned long nr;
+};
+
+struct launch_ra_profile {
+	struct list_head list;
+	uid_t uid;
+	unsigned int nr_entries;
+	unsigned long nr_pages;
+	struct launch_ra_entry entries[];
+};
+
+pid_t launch_ra_tgid;
+
+/* protects the recording state below */
+static DEFINE_SPINLOCK(launch_ra_lock);
+static uid_t launch_ra_uid;
+static unsigned int launch_ra_nr;
+static struct launch_ra_entry *launch_ra_buf;
+
+/* protects the profile list, most recently used first */
+static DEFINE_MUTEX(launch_ra_mutex);
+static LIST_HEAD(launch_ra_profiles);
+static unsigned int launch_ra_nr_profiles;
+
+static uid_t launch_ra_replay_uid;
+static void launch_ra_replay_fn(struct work_struct *work);
+static DECLARE_WORK(launch_ra_replay_work, launch_ra_replay_fn);
+static void launch_ra_stop_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(launch_ra_stop_work, launch_ra_stop_fn);
+
+void __launch_ra_record(struct inode *inode, pgoff_t start, unsigned long nr)
+{
+	struct super_block *sb = inode->i_sb;
+	struct launch_ra_entry *e;
+
+	/* only regular files on block devices can be found again */
+	if (!S_ISREG(inode->i_mode) || !sb->s_bdev || !nr)
+		return;
+
+	spin_lock(&launch_ra_lock);
+	if (!launch_ra_buf)
+		goto out;
+
+	if (launch_ra_nr) {
+		e = &launch_ra_buf[launch_ra_nr - 1];
+		if (e->ino == inode->i_ino && e->dev == sb->s_dev &&
+		    start >= e->start && start <= e->start + e->nr) {
+			e->nr = max(e->nr, start + nr - e->start);
+			goto out;
+		}
+	}
+
+	if (launch_ra_nr == LAUNCH_RA_MAX_ENTRIES)
+		goto out;
+
+	e = &launch_ra_buf[launch_ra_nr++];
+	e->dev = sb->s_dev;
+	e->gen = inode->i_generation;
+	e->ino = inode->i_ino;
+	e->start = start;
+	e->nr = nr;
+out:
+	spin_unlock(&launch_ra_lock);
+}
+
+static int launch_ra_entry_cmp(const void *a, const void *b)
+{
+	const struct launch_ra_entry *x = a, *y = b;
+
+	if (x->dev != y->dev)
+		return x->dev < y->dev ? -1 : 1;
+	if (x->ino != y->ino)
+		return x->ino < y->ino ? -1 : 1;
+	if (x->start != y->start)
+		return x->start < y->start ? -1 : 1;
+	return 0;
+}
+
+/* Sort by file and offset and merge overlapping ranges in place */
+static unsigned int launch_ra_merge(struct launch_ra_entry *entries,
+				    unsigned int nr)
+{
+	unsigned int i, out = 0;
+
+	if (!nr)
+		return 0;
+
+	sort(entries, nr, sizeof(*entries), launch_ra_entry_cmp, NULL);
+
+	for (i = 1; i < nr; i++) {
+		struct launch_ra_entry *prev = &entries[out];
+		struct launch_ra_entry *e = &entries[i];
+
+		if (e->dev == prev->dev && e->ino == prev->ino &&
+		    e->start <= prev->start + prev->nr) {
+			prev->nr = max(prev->nr, e->start + e->nr - prev->start);
+			continue;
+		}
+		entries[++out] = *e;
+	}
+
+	return out + 1;
+}
+
+static struct launch_ra_profile *launch_ra_find(uid_t uid)
+{
+	struct launch_ra_profile *p;
+
+	list_for_each_entry(p, &launch_ra_profiles, list)
+		if (p->uid == uid)
+			return p;
+
+	return NULL;
+}
+
+static void launch_ra_drop(struct launch_ra_profile *p)
+{
+	list_del(&p->list);
+	launch_ra_nr_profiles--;
+	kvfree(p);
+}
+
+/*
+ * End the current recording, if any, and fold it into the uid's profile.
+ * Ranges the replay already brought in are hits and not recorded again,
+ * so the old profile is kept and the new misses are added to it.
+ */
+static void launch_ra_commit(void)
+{
+	struct launch_ra_entry *buf;
+	struct launch_ra_profile *p, *old;
+	unsigned int nr, total, i;
+	uid_t uid;
+
+	spin_lock(&launch_ra_lock);
+	buf = launch_ra_buf;
+	nr = launch_ra_nr;
+	uid = launch_ra_uid;
+	launch_ra_buf = NULL;
+	launch_ra_nr = 0;
+	WRITE_ONCE(launch_ra_tgid, 0);
+	spin_unlock(&launch_ra_lock);
+
+	if (!buf)
+		return;
+
+	mutex_lock(&launch_ra_mutex);
+	old = launch_ra_find(uid);
+	total = nr + (old ? old->nr_entries : 0);
+	if (!total)
+		goto unlock;
+
+	p = kvmalloc(sizeof(*p) + total * sizeof(*buf), GFP_KERNEL);
+	if (!p)
+		goto unlock;
+
+	memcpy(p->entries, buf, nr * sizeof(*buf));
+	if (old)
+		memcpy(p->entries + nr, old->entries,
+		       old->nr_entries * sizeof(*buf));
+
+	p->uid = uid;
+	p->nr_entries = min_t(unsigned int, launch_ra_merge(p->entries, total),
+			      LAUNCH_RA_MAX_ENTRIES);
+	p->nr_pages = 0;
+	for (i = 0; i < p->nr_entries; i++)
+		p->nr_pages += p->entries[i].nr;
+
+	if (old)
+		launch_ra_drop(old);
+	if (launch_ra_nr_profiles == LAUNCH_RA_MAX_PROFILES)
+		launch_ra_drop(list_last_entry(&launch_ra_profiles,
+					       struct launch_ra_profile, list));
+	list_add(&p->list, &launch_ra_profiles);
+	launch_ra_nr_profiles++;
+unlock:
+	mutex_unlock(&launch_ra_mutex);
+	kvfree(buf);
+}
+
+static void launch_ra_stop_fn(struct work_struct *work)
+{
+	launch_ra_commit();
+}
+
+static void launch_ra_replay_inode(struct inode *inode,
+				   struct launch_ra_entry *e)
+{
+	struct address_space *mapping = inode->i_mapping;
+	pgoff_t start = e->start;
+	unsigned long nr = e->nr;
+
+	if (!mapping->a_ops->readpage && !mapping->a_ops->readpages)
+		return;
+
+	while (nr) {
+		unsigned long chunk = min_t(unsigned long, nr,
+					    LAUNCH_RA_CHUNK);
+
+		if (__do_page_cache_readahead(mapping, NULL, start,
+					      chunk, 0) < 0)
+			break;
+		start += chunk;
+		nr -= chunk;
+	}
+}
+
+static void launch_ra_replay_fn(struct work_struct *work)
+{
+	struct launch_ra_profile *p;
+	struct super_block *sb = NULL;
+	struct inode *inode = NULL;
+	struct blk_plug plug;
+	dev_t dev = 0;
+	unsigned int i;
+
+	mutex_lock(&launch_ra_mutex);
+	p = launch_ra_find(READ_ONCE(launch_ra_replay_uid));
+	if (!p)
+		goto unlock;
+	list_move(&p->list, &launch_ra_profiles);
+
+	blk_start_plug(&plug);
+	for (i = 0; i < p->nr_entries; i++) {
+		struct launch_ra_entry *e = &p->entries[i];
+
+		if (!sb || e->dev != dev) {
+			struct block_device *bdev;
+
+			if (inode)
+				iput(inode);
+			inode = NULL;
+			if (sb)
+				drop_super(sb);
+			sb = NULL;
+			dev = e->dev;
+
+			bdev = bdget(dev);
+			if (!bdev)
+				continue;
+			sb = get_super(bdev);
+			bdput(bdev);
+			if (!sb)
+				continue;
+		}
+
+		if (!inode || inode->i_ino != e->ino) {
+			if (inode)
+				iput(inode);
+			/* files evicted from the icache are skipped */
+			inode = ilookup(sb, e->ino);
+			if (inode && (inode->i_generation != e->gen ||
+				      !S_ISREG(inode->i_mode))) {
+				iput(inode);
+				inode = NULL;
+			}
+		}
+
+		if (inode)
+			launch_ra_replay_inode(inode, e);
+		cond_resched();
+	}
+	blk_finish_plug(&plug);
+
+	if (inode)
+		iput(inode);
+	if (sb)
+		drop_super(sb);
+unlock:
+	mutex_unlock(&launch_ra_mutex);
+}
+
+static int launch_ra_start(pid_t pid)
+{
+	struct launch_ra_entry *buf;
+	struct task_struct *task;
+	pid_t tgid;
+	uid_t uid;
+
+	rcu_read_lock();
+	task = find_task_by_vpid(pid);
+	if (!task) {
+		rcu_read_unlock();
+		return -ESRCH;
+	}
+	tgid = task->tgid;
+	uid = from_kuid(&init_user_ns, task_uid(task));
+	rcu_read_unlock();
+
+	cancel_delayed_work_sync(&launch_ra_stop_work);
+	launch_ra_commit();
+
+	WRITE_ONCE(launch_ra_replay_uid, uid);
+	queue_work(system_unbound_wq, &launch_ra_replay_work);
+
+	buf = kvmalloc_array(LAUNCH_RA_MAX_ENTRIES, sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	spin_lock(&launch_ra_lock);
+	/* lost a race with another start, let that one record */
+	if (launch_ra_buf) {
+		spin_unlock(&launch_ra_lock);
+		kvfree(buf);
+		return -EBUSY;
+	}
+	launch_ra_buf = buf;
+	launch_ra_nr = 0;
+	launch_ra_uid = uid;
+	WRITE_ONCE(launch_ra_tgid, tgid);
+	spin_unlock(&launch_ra_lock);
+
+	schedule_delayed_work(&launch_ra_stop_work,
+			      msecs_to_jiffies(launch_window_ms));
+	return 0;
+}
+
+static void launch_ra_clear(void)
+{
+	struct launch_ra_profile *p, *tmp;
+
+	mutex_lock(&launch_ra_mutex);
+	list_for_each_entry_safe(p, tmp, &launch_ra_profiles, list)
+		launch_ra_drop(p);
+	mutex_unlock(&launch_ra_mutex);
+}
+
+static ssize_t launch_ra_write(struct file *file, const char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	char buf[32];
+	int pid, ret = 0;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "start %d", &pid) == 1) {
+		ret = launch_ra_start(pid);
+	} else if (sysfs_streq(buf, "stop")) {
+		cancel_delayed_work_sync(&launch_ra_stop_work);
+		launch_ra_commit();
+	} else if (sysfs_streq(buf, "clear")) {
+		launch_ra_clear();
+	} else {
+		ret = -EINVAL;
+	}
+
+	return ret ? ret : count;
+}
+
+static int launch_ra_show(struct seq_file *m, void *v)
+{
+	struct launch_ra_profile *p;
+
+	mutex_lock(&launch_ra_mutex);
+	list_for_each_entry(p, &launch_ra_profiles, list)
+		seq_printf(m, "uid %u ranges %u pages %lu\n",
+			   p->uid, p->nr_entries, p->nr_pages);
+	mutex_unlock(&launch_ra_mutex);
+
+	return 0;
+}
+
+static int launch_ra_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, launch_ra_show, NULL);
+}
+
+static const struct file_operations launch_ra_fops = {
+	.open		= launch_ra_open,
+	.read		= seq_read,
+	.write		= launch_ra_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init launch_ra_init(void)
+{
+	if (!proc_create("launch_readahead", 0600, NULL, &launch_ra_fops))
+		return -ENOMEM;
+	return 0;
+}
+module_init(launch_ra_init);
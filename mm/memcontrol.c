@@ -2736,6 +2736,86 @@ static ssize_t mem_cgroup_force_empty_write(struct kernfs_open_file *of,
 	return mem_cgroup_force_empty(memcg) ?: nbytes;
 }
 
+/*
+ * memory.reclaim: "<size> [file]"
+ *
+ * Reclaim up to <size> bytes from the cgroup without touching its limits,
+ * so userspace can trim cached memory ahead of demand. With "file" only
+ * page cache is reclaimed and anon pages are left alone. Fails with
+ * -EAGAIN when the target could not be met after a few attempts.
+ */
+static ssize_t mem_cgroup_reclaim_write(struct kernfs_open_file *of,
+					char *buf, size_t nbytes, loff_t off)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(of_css(of));
+	unsigned int nr_retries = MEM_CGROUP_RECLAIM_RETRIES;
+	unsigned long nr_to_reclaim, nr_reclaimed = 0;
+	bool may_swap = true;
+	char *opt;
+	u64 start;
+	int err;
+
+	buf = strstrip(buf);
+	opt = strpbrk(buf, " \t");
+	if (opt) {
+		*opt++ = '\0';
+		if (strcmp(skip_spaces(opt), "file"))
+			return -EINVAL;
+		may_swap = false;
+	}
+
+	err = page_counter_memparse(buf, "", &nr_to_reclaim);
+	if (err)
+		return err;
+
+	start = ktime_get_ns();
+	while (nr_reclaimed < nr_to_reclaim) {
+		unsigned long reclaimed;
+
+		if (signal_pending(current)) {
+			err = -EINTR;
+			break;
+		}
+
+		/*
+		 * This is the final attempt, drain percpu lru caches in the
+		 * hope of introducing more evictable pages.
+		 */
+		if (!nr_retries)
+			lru_add_drain_all();
+
+		reclaimed = try_to_free_mem_cgroup_pages(memcg,
+					nr_to_reclaim - nr_reclaimed,
+					GFP_KERNEL, may_swap);
+
+		if (!reclaimed && !nr_retries--) {
+			err = -EAGAIN;
+			break;
+		}
+
+		nr_reclaimed += reclaimed;
+	}
+
+	atomic_long_add(nr_reclaimed, &memcg->proactive_reclaimed);
+	atomic64_add(ktime_get_ns() - start, &memcg->proactive_reclaim_ns);
+
+	return err ?: nbytes;
+}
+
+static int mem_cgroup_reclaim_show(struct seq_file *m, void *v)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(seq_css(m));
+
+	seq_printf(m, "reclaimed %llu\n",
+		   (u64)atomic_long_read(&memcg->proactive_reclaimed) *
+		   PAGE_SIZE);
+	seq_printf(m, "reclaim_usec %llu\n",
+		   div_u64(atomic64_read(&memcg->proactive_reclaim_ns),
+			   NSEC_PER_USEC));
+
+	return 0;
+}
+
 static u64 mem_cgroup_hierarchy_read(struct cgroup_subsys_state *css,
 				     struct cftype *cft)
 {
@@ -4051,6 +4131,12 @@ static struct cftype mem_cgroup_legacy_files[] = {
 		.name = "force_empty",
 		.write = mem_cgroup_force_empty_write,
 	},
+	{
+		.name = "reclaim",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = mem_cgroup_reclaim_show,
+		.write = mem_cgroup_reclaim_write,
+	},
 	{
 		.name = "use_hierarchy",
 		.write_u64 = mem_cgroup_hierarchy_write,
@@ -5474,6 +5560,12 @@ static struct cftype memory_files[] = {
 		.flags = CFTYPE_NOT_ON_ROOT,
 		.seq_show = memory_stat_show,
 	},
+	{
+		.name = "reclaim",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = mem_cgroup_reclaim_show,
+		.write = mem_cgroup_reclaim_write,
+	},
 	{ }	/* terminate */
 };
 
@@ -1105,6 +1105,27 @@ copy_one_pte(struct mm_struct *dst_mm, struct mm_struct *src_mm,
 	return 0;
 }
 
+/*
+ * Leave page cache ptes of file mappings out of the child's page tables on
+ * fork, even where the vma has anon pages that must be copied. A read fault
+ * maps them again, so a child that only touches a fraction of a large
+ * parent (typically a zygote) no longer pays for copying all of them.
+ */
+int sysctl_fork_skip_pagecache __read_mostly;
+
+static inline bool fork_skip_pte(struct vm_area_struct *vma,
+				 unsigned long addr, pte_t pte)
+{
+	struct page *page;
+
+	if (!pte_present(pte))
+		return false;
+
+	page = vm_normal_page(vma, addr, pte);
+
+	return page && !PageAnon(page);
+}
+
 static int copy_pte_range(struct mm_struct *dst_mm, struct mm_struct *src_mm,
 		   pmd_t *dst_pmd, pmd_t *src_pmd, struct vm_area_struct *vma,
 		   unsigned long addr, unsigned long end)
@@ -1116,6 +1137,8 @@ static int copy_pte_range(struct mm_struct *dst_mm, struct mm_struct *src_mm,
 	int rss[NR_MM_COUNTERS];
 	unsigned long orig_addr = addr;
 	swp_entry_t entry = (swp_entry_t){0};
+	bool skip_pagecache = sysctl_fork_skip_pagecache && vma->vm_file &&
+		!(vma->vm_flags & (VM_PFNMAP | VM_MIXEDMAP));
 
 again:
 	init_rss_vec(rss);
@@ -1145,6 +1168,10 @@ static int copy_pte_range(struct mm_struct *dst_mm, struct mm_struct *src_mm,
 			progress++;
 			continue;
 		}
+		if (skip_pagecache && fork_skip_pte(vma, addr, *src_pte)) {
+			progress++;
+			continue;
+		}
 		entry.val = copy_one_pte(dst_mm, src_mm, dst_pte, src_pte,
 							vma, addr, rss);
 		if (entry.val)
@@ -2371,6 +2398,7 @@ static bool pte_spinlock(struct vm_fault *vmf)
 
 	local_irq_disable();
 	if (vma_has_changed(vmf)) {
+		count_vm_event(SPF_ABORT_VMA_CHANGED);
 		trace_spf_vma_changed(_RET_IP_, vmf->vma, vmf->address);
 		goto out;
 	}
@@ -2382,6 +2410,7 @@ static bool pte_spinlock(struct vm_fault *vmf)
 	 */
 	pmdval = READ_ONCE(*vmf->pmd);
 	if (!pmd_same(pmdval, vmf->orig_pmd)) {
+		count_vm_event(SPF_ABORT_PMD_CHANGED);
 		trace_spf_pmd_changed(_RET_IP_, vmf->vma, vmf->address);
 		goto out;
 	}
@@ -2389,12 +2418,14 @@ static bool pte_spinlock(struct vm_fault *vmf)
 
 	vmf->ptl = pte_lockptr(vmf->vma->vm_mm, vmf->pmd);
 	if (unlikely(!spin_trylock(vmf->ptl))) {
+		count_vm_event(SPF_ABORT_PTE_LOCK);
 		trace_spf_pte_lock(_RET_IP_, vmf->vma, vmf->address);
 		goto out;
 	}
 
 	if (vma_has_changed(vmf)) {
 		spin_unlock(vmf->ptl);
+		count_vm_event(SPF_ABORT_VMA_CHANGED);
 		trace_spf_vma_changed(_RET_IP_, vmf->vma, vmf->address);
 		goto out;
 	}
@@ -2429,6 +2460,7 @@ static bool pte_map_lock(struct vm_fault *vmf)
 	 */
 	local_irq_disable();
 	if (vma_has_changed(vmf)) {
+		count_vm_event(SPF_ABORT_VMA_CHANGED);
 		trace_spf_vma_changed(_RET_IP_, vmf->vma, vmf->address);
 		goto out;
 	}
@@ -2440,6 +2472,7 @@ static bool pte_map_lock(struct vm_fault *vmf)
 	 */
 	pmdval = READ_ONCE(*vmf->pmd);
 	if (!pmd_same(pmdval, vmf->orig_pmd)) {
+		count_vm_event(SPF_ABORT_PMD_CHANGED);
 		trace_spf_pmd_changed(_RET_IP_, vmf->vma, vmf->address);
 		goto out;
 	}
@@ -2456,12 +2489,14 @@ static bool pte_map_lock(struct vm_fault *vmf)
 	pte = pte_offset_map(vmf->pmd, vmf->address);
 	if (unlikely(!spin_trylock(ptl))) {
 		pte_unmap(pte);
+		count_vm_event(SPF_ABORT_PTE_LOCK);
 		trace_spf_pte_lock(_RET_IP_, vmf->vma, vmf->address);
 		goto out;
 	}
 
 	if (vma_has_changed(vmf)) {
 		pte_unmap_unlock(pte, ptl);
+		count_vm_event(SPF_ABORT_VMA_CHANGED);
 		trace_spf_vma_changed(_RET_IP_, vmf->vma, vmf->address);
 		goto out;
 	}
@@ -3366,6 +3401,7 @@ int do_swap_page(struct vm_fault *vmf)
 	}
 
 	swap_free(entry);
+	mm_count_swap_refault(vma->vm_mm);
 	if (mem_cgroup_swap_full(page) ||
 	    (vmf->vma_flags & VM_LOCKED) || PageMlocked(page))
 		try_to_free_swap(page);
@@ -3905,6 +3941,101 @@ static int __init fault_around_debugfs(void)
 late_initcall(fault_around_debugfs);
 #endif
 
+#ifdef CONFIG_ADAPTIVE_FAULT_AROUND
+/*
+ * vma->fault_around_info holds the start of the last fault-around window
+ * in the page bits and its order + 1 in the low bits, 0 until the first
+ * fault-around of the vma. Prefaulted ptes are made old, so the young
+ * ones in the last window are the pages that got used.
+ */
+#define FAULT_AROUND_ORDER_MASK	0x1fUL
+#define FAULT_AROUND_ADDR(v)	((v) & PAGE_MASK)
+#define FAULT_AROUND_ORDER(v)	(((v) & FAULT_AROUND_ORDER_MASK) - 1)
+#define FAULT_AROUND_VAL(addr, order)	((addr) | ((order) + 1))
+
+unsigned long vma_fault_around_bytes(struct vm_area_struct *vma)
+{
+	unsigned long max = READ_ONCE(fault_around_bytes);
+	unsigned long v = atomic_long_read(&vma->fault_around_info);
+
+	if (!v)
+		return max;
+	return min(PAGE_SIZE << FAULT_AROUND_ORDER(v), max);
+}
+
+/*
+ * Grow the window when at least half of the pages prefaulted last time
+ * were touched, shrink it when less than a quarter were. Only the last
+ * window in the page table of this fault is looked at, and without the
+ * pte lock: it's a hint.
+ */
+static unsigned long fault_around_adapt(struct vm_fault *vmf,
+					unsigned long max_pages)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	unsigned long v = atomic_long_read(&vma->fault_around_info);
+	unsigned long addr, end, nr_pages;
+	int present = 0, young = 0;
+	pmd_t pmdval;
+	pte_t *start_pte, *pte;
+
+	if (!v)
+		return max_pages;
+
+	nr_pages = min(1UL << FAULT_AROUND_ORDER(v), max_pages);
+	addr = FAULT_AROUND_ADDR(v);
+	if ((addr & PMD_MASK) != (vmf->address & PMD_MASK))
+		return nr_pages;
+
+	pmdval = READ_ONCE(*vmf->pmd);
+	if (pmd_none(pmdval) || pmd_trans_huge(pmdval) || pmd_bad(pmdval))
+		return nr_pages;
+
+	end = min3(addr + (nr_pages << PAGE_SHIFT), vma->vm_end,
+		   (addr & PMD_MASK) + PMD_SIZE);
+	start_pte = pte = pte_offset_map(vmf->pmd, addr);
+	for (; addr < end; addr += PAGE_SIZE, pte++) {
+		pte_t ptent = READ_ONCE(*pte);
+
+		if (!pte_present(ptent))
+			continue;
+		present++;
+		if (pte_young(ptent))
+			young++;
+	}
+	pte_unmap(start_pte);
+
+	/* the page that faulted last time is young and doesn't count */
+	if (present <= 1)
+		return nr_pages;
+	present--;
+	young = max(young - 1, 0);
+
+	if (young * 2 >= present)
+		nr_pages = min(nr_pages * 2, max_pages);
+	else if (young * 4 < present && nr_pages > 2)
+		nr_pages /= 2;
+	return nr_pages;
+}
+
+static void fault_around_record(struct vm_fault *vmf, unsigned long nr_pages)
+{
+	atomic_long_set(&vmf->vma->fault_around_info,
+			FAULT_AROUND_VAL(vmf->address, ilog2(nr_pages)));
+}
+#else
+static inline unsigned long fault_around_adapt(struct vm_fault *vmf,
+					       unsigned long max_pages)
+{
+	return max_pages;
+}
+
+static inline void fault_around_record(struct vm_fault *vmf,
+				       unsigned long nr_pages)
+{
+}
+#endif
+
 /*
  * do_fault_around() tries to map few pages around the fault address. The hope
  * is that the pages will be needed soon and this will lower the number of
@@ -3927,6 +4058,9 @@ late_initcall(fault_around_debugfs);
  * The virtual address of the area that we map is naturally aligned to the
  * fault_around_pages() value (and therefore to page order).  This way it's
  * easier to guarantee that we don't cross page table boundaries.
+ *
+ * With CONFIG_ADAPTIVE_FAULT_AROUND the number of pages is tuned per vma,
+ * see fault_around_adapt().
  */
 static int do_fault_around(struct vm_fault *vmf)
 {
@@ -3936,6 +4070,7 @@ static int do_fault_around(struct vm_fault *vmf)
 	int off, ret = 0;
 
 	nr_pages = READ_ONCE(fault_around_bytes) >> PAGE_SHIFT;
+	nr_pages = fault_around_adapt(vmf, nr_pages);
 	mask = ~(nr_pages * PAGE_SIZE - 1) & PAGE_MASK;
 
 	vmf->address = max(address & mask, vmf->vma->vm_start);
@@ -3960,6 +4095,7 @@ static int do_fault_around(struct vm_fault *vmf)
 		smp_wmb(); /* See comment in __pte_alloc() */
 	}
 
+	fault_around_record(vmf, nr_pages);
 	vmf->vma->vm_ops->map_pages(vmf, start_pgoff, end_pgoff);
 
 	/* Huge page is mapped? Page fault is solved */
@@ -4546,6 +4682,7 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 	/* rmb <-> seqlock,vma_rb_erase() */
 	seq = raw_read_seqcount(&vmf.vma->vm_sequence);
 	if (seq & 1) {
+		count_vm_event(SPF_ABORT_VMA_CHANGED);
 		trace_spf_vma_changed(_RET_IP_, vmf.vma, address);
 		return VM_FAULT_RETRY;
 	}
@@ -4556,6 +4693,7 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 	 * This include huge page from hugetlbfs.
 	 */
 	if (vmf.vma->vm_ops) {
+		count_vm_event(SPF_ABORT_VMA_NOTSUP);
 		trace_spf_vma_notsup(_RET_IP_, vmf.vma, address);
 		return VM_FAULT_RETRY;
 	}
@@ -4566,6 +4704,7 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 	 * in the speculative path.
 	 */
 	if (unlikely(!vmf.vma->anon_vma)) {
+		count_vm_event(SPF_ABORT_VMA_NOTSUP);
 		trace_spf_vma_notsup(_RET_IP_, vmf.vma, address);
 		return VM_FAULT_RETRY;
 	}
@@ -4575,6 +4714,7 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 
 	/* Can't call userland page fault handler in the speculative path */
 	if (unlikely(vmf.vma_flags & VM_UFFD_MISSING)) {
+		count_vm_event(SPF_ABORT_VMA_NOTSUP);
 		trace_spf_vma_notsup(_RET_IP_, vmf.vma, address);
 		return VM_FAULT_RETRY;
 	}
@@ -4585,12 +4725,14 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 		 * boundaries but we want to trace it as not supported instead
 		 * of changed.
 		 */
+		count_vm_event(SPF_ABORT_VMA_NOTSUP);
 		trace_spf_vma_notsup(_RET_IP_, vmf.vma, address);
 		return VM_FAULT_RETRY;
 	}
 
 	if (address < READ_ONCE(vmf.vma->vm_start)
 	    || READ_ONCE(vmf.vma->vm_end) <= address) {
+		count_vm_event(SPF_ABORT_VMA_CHANGED);
 		trace_spf_vma_changed(_RET_IP_, vmf.vma, address);
 		return VM_FAULT_RETRY;
 	}
@@ -4620,6 +4762,7 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 		pol = get_task_policy(current);
 	if (!pol)
 		if (pol && pol->mode == MPOL_INTERLEAVE) {
+			count_vm_event(SPF_ABORT_VMA_NOTSUP);
 			trace_spf_vma_notsup(_RET_IP_, vmf.vma, address);
 			return VM_FAULT_RETRY;
 		}
@@ -4695,6 +4838,7 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 	 * we might have a false positive on the bounds.
 	 */
 	if (read_seqcount_retry(&vmf.vma->vm_sequence, seq)) {
+		count_vm_event(SPF_ABORT_VMA_CHANGED);
 		trace_spf_vma_changed(_RET_IP_, vmf.vma, address);
 		return VM_FAULT_RETRY;
 	}
@@ -4723,11 +4867,13 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 	return ret;
 
 out_walk:
+	count_vm_event(SPF_ABORT_NO_PGTABLE);
 	trace_spf_vma_notsup(_RET_IP_, vmf.vma, address);
 	local_irq_enable();
 	return VM_FAULT_RETRY;
 
 out_segv:
+	count_vm_event(SPF_ABORT_VMA_ACCESS);
 	trace_spf_vma_access(_RET_IP_, vmf.vma, address);
 	/*
 	 * We don't return VM_FAULT_RETRY so the caller is not expected to
@@ -2788,12 +2788,16 @@ int split_vma(struct mm_struct *mm, struct vm_area_struct *vma,
  * what needs doing, and the areas themselves, which do the
  * work.  This now handles partial unmappings.
  * Jeremy Fitzhardinge <jeremy@goop.org>
+ *
+ * With @downgrade the mmap_sem is downgraded to read once the vmas are
+ * detached, so page faults and other readers don't wait for the zap and
+ * the TLB flush. Returns 1 in that case and the caller must up_read().
  */
-int do_munmap(struct mm_struct *mm, unsigned long start, size_t len,
-	      struct list_head *uf)
+static int __do_munmap(struct mm_struct *mm, unsigned long start, size_t len,
+		       struct list_head *uf, bool downgrade)
 {
 	unsigned long end;
-	struct vm_area_struct *vma, *prev, *last;
+	struct vm_area_struct *vma, *prev, *last, *next;
 
 	if ((offset_in_page(start)) || start > TASK_SIZE || len > TASK_SIZE-start)
 		return -EINVAL;
@@ -2880,18 +2884,40 @@ int do_munmap(struct mm_struct *mm, unsigned long start, size_t len,
 	 * Remove the vma's, and unmap the actual pages
 	 */
 	detach_vmas_to_be_unmapped(mm, vma, prev, end);
-	unmap_region(mm, vma, prev, start, end);
 
+	/* arch_unmap() needs the mmap_sem held for write */
 	arch_unmap(mm, vma, start, end);
 
+	/*
+	 * free_pgtables() may free tables up to the neighbouring vmas, a
+	 * stack growing into the hole under the read lock would race with
+	 * it.
+	 */
+	next = prev ? prev->vm_next : mm->mmap;
+	if (downgrade) {
+		if ((next && (next->vm_flags & VM_GROWSDOWN)) ||
+		    (prev && (prev->vm_flags & VM_GROWSUP)))
+			downgrade = false;
+		else
+			downgrade_write(&mm->mmap_sem);
+	}
+
+	unmap_region(mm, vma, prev, start, end);
+
 	/* Fix up all other VM information */
 	remove_vma_list(mm, vma);
 
-	return 0;
+	return downgrade ? 1 : 0;
+}
+
+int do_munmap(struct mm_struct *mm, unsigned long start, size_t len,
+	      struct list_head *uf)
+{
+	return __do_munmap(mm, start, len, uf, false);
 }
 EXPORT_SYMBOL(do_munmap);
 
-int vm_munmap(unsigned long start, size_t len)
+static int __vm_munmap(unsigned long start, size_t len, bool downgrade)
 {
 	int ret;
 	struct mm_struct *mm = current->mm;
@@ -2900,18 +2926,29 @@ int vm_munmap(unsigned long start, size_t len)
 	if (down_write_killable(&mm->mmap_sem))
 		return -EINTR;
 
-	ret = do_munmap(mm, start, len, &uf);
-	up_write(&mm->mmap_sem);
+	ret = __do_munmap(mm, start, len, &uf, downgrade);
+	if (ret == 1) {
+		up_read(&mm->mmap_sem);
+		ret = 0;
+	} else {
+		up_write(&mm->mmap_sem);
+	}
+
 	userfaultfd_unmap_complete(mm, &uf);
 	return ret;
 }
+
+int vm_munmap(unsigned long start, size_t len)
+{
+	return __vm_munmap(start, len, false);
+}
 EXPORT_SYMBOL(vm_munmap);
 
 SYSCALL_DEFINE2(munmap, unsigned long, addr, size_t, len)
 {
 	addr = untagged_addr(addr);
 	profile_munmap(addr);
-	return vm_munmap(addr, len);
+	return __vm_munmap(addr, len, true);
 }
 
 
@@ -1170,10 +1170,39 @@ static bool bulkfree_pcp_prepare(struct page *page)
 }
 #endif /* CONFIG_DEBUG_VM */
 
+/*
+ * pcp_high_order=N keeps orders 1..N (N <= PAGE_ALLOC_COSTLY_ORDER) on the
+ * per-cpu lists as well, so that kernel stacks, slab pages and network
+ * buffers do not take zone->lock on every allocation and free. Pages of a
+ * cached order count towards pcp->high like order-0 pages do.
+ */
+static unsigned int pcp_high_order __read_mostly;
+
+static int __init setup_pcp_high_order(char *str)
+{
+	unsigned int order;
+
+	if (kstrtouint(str, 0, &order))
+		return 0;
+	pcp_high_order = min_t(unsigned int, order, PAGE_ALLOC_COSTLY_ORDER);
+	return 1;
+}
+__setup("pcp_high_order=", setup_pcp_high_order);
+
+static inline unsigned int pcp_list_index(unsigned int order, int migratetype)
+{
+	return order * MIGRATE_PCPTYPES + migratetype;
+}
+
+static inline unsigned int pcp_list_order(unsigned int pindex)
+{
+	return pindex / MIGRATE_PCPTYPES;
+}
+
 /*
  * Frees a number of pages from the PCP lists
- * Assumes all pages on list are in same zone, and of same order.
- * count is the number of pages to free.
+ * Assumes all pages on list are in same zone, and of the order of the list.
+ * count is the number of pages to free, pcp->count is updated here.
  *
  * If the zone was previously in an "all pages pinned" state then look to
  * see if this freeing clears that state.
@@ -1184,7 +1213,7 @@ static bool bulkfree_pcp_prepare(struct page *page)
 static void free_pcppages_bulk(struct zone *zone, int count,
 					struct per_cpu_pages *pcp)
 {
-	int migratetype = 0;
+	int pindex = 0;
 	int batch_free = 0;
 	bool isolated_pageblocks;
 
@@ -1196,9 +1225,10 @@ static void free_pcppages_bulk(struct zone *zone, int count,
 	 * below while (list_empty(list)) loop.
 	 */
 	count = min(pcp->count, count);
-	while (count) {
+	while (count > 0) {
 		struct page *page;
 		struct list_head *list;
+		unsigned int order;
 
 		/*
 		 * Remove pages from lists in a round-robin fashion. A
@@ -1209,21 +1239,24 @@ static void free_pcppages_bulk(struct zone *zone, int count,
 		 */
 		do {
 			batch_free++;
-			if (++migratetype == MIGRATE_PCPTYPES)
-				migratetype = 0;
-			list = &pcp->lists[migratetype];
+			if (++pindex == NR_PCP_LISTS)
+				pindex = 0;
+			list = &pcp->lists[pindex];
 		} while (list_empty(list));
 
 		/* This is the only non-empty list. Free them all. */
-		if (batch_free == MIGRATE_PCPTYPES)
+		if (batch_free == NR_PCP_LISTS)
 			batch_free = count;
 
+		order = pcp_list_order(pindex);
 		do {
 			int mt;	/* migratetype of the to-be-freed page */
 
 			page = list_last_entry(list, struct page, lru);
 			/* must delete as __free_one_page list manipulates */
 			list_del(&page->lru);
+			pcp->count -= 1 << order;
+			count -= 1 << order;
 
 			mt = get_pcppage_migratetype(page);
 			/* MIGRATE_ISOLATE page should not go to pcplists */
@@ -1235,9 +1268,10 @@ static void free_pcppages_bulk(struct zone *zone, int count,
 			if (bulkfree_pcp_prepare(page))
 				continue;
 
-			__free_one_page(page, page_to_pfn(page), zone, 0, mt);
-			trace_mm_page_pcpu_drain(page, 0, mt);
-		} while (--count && --batch_free && !list_empty(list));
+			__free_one_page(page, page_to_pfn(page), zone, order,
+					mt);
+			trace_mm_page_pcpu_drain(page, order, mt);
+		} while (count > 0 && --batch_free && !list_empty(list));
 	}
 	spin_unlock(&zone->lock);
 }
@@ -1329,6 +1363,24 @@ void __meminit reserve_bootmem_region(phys_addr_t start, phys_addr_t end)
 	}
 }
 
+/*
+ * Queue a page of a cached order on the pcp lists, interrupts must be
+ * disabled. Unlike order-0 pages, highatomic and isolated pages are left
+ * to free_one_page() by the caller.
+ */
+static void free_pcp_high_order(struct page *page, unsigned int order,
+				int migratetype)
+{
+	struct zone *zone = page_zone(page);
+	struct per_cpu_pages *pcp = &this_cpu_ptr(zone->pageset)->pcp;
+
+	set_pcppage_migratetype(page, migratetype);
+	list_add(&page->lru, &pcp->lists[pcp_list_index(order, migratetype)]);
+	pcp->count += 1 << order;
+	if (pcp->count >= pcp->high)
+		free_pcppages_bulk(zone, READ_ONCE(pcp->batch), pcp);
+}
+
 static void __free_pages_ok(struct page *page, unsigned int order)
 {
 	unsigned long flags;
@@ -1341,7 +1393,11 @@ static void __free_pages_ok(struct page *page, unsigned int order)
 	migratetype = get_pfnblock_migratetype(page, pfn);
 	local_irq_save(flags);
 	__count_vm_events(PGFREE, 1 << order);
-	free_one_page(page_zone(page), page, pfn, order, migratetype);
+	if (order && order <= pcp_high_order &&
+	    migratetype < MIGRATE_PCPTYPES)
+		free_pcp_high_order(page, order, migratetype);
+	else
+		free_one_page(page_zone(page), page, pfn, order, migratetype);
 	local_irq_restore(flags);
 }
 
@@ -2392,12 +2448,25 @@ static struct page *__rmqueue(struct zone *zone, unsigned int order,
 }
 
 #ifdef CONFIG_CMA
+/*
+ * A CMA allocation happened in this zone recently, more are likely to
+ * follow (e.g. a camera allocating its buffers), so keep movable pages out
+ * of CMA for a while instead of refilling it with page cache that the next
+ * cma_alloc() has to migrate again.
+ */
+static inline bool cma_zone_hot(struct zone *zone)
+{
+	unsigned long until = READ_ONCE(zone->cma_hot_until);
+
+	return until && time_before(jiffies, until);
+}
+
 static struct page *__rmqueue_cma(struct zone *zone, unsigned int order)
 {
 	struct page *page = 0;
 
 	if (IS_ENABLED(CONFIG_CMA))
-		if (!zone->cma_alloc)
+		if (!zone->cma_alloc && !cma_zone_hot(zone))
 			page = __rmqueue_cma_fallback(zone, order);
 	trace_mm_page_alloc_zone_locked(page, order, MIGRATE_CMA);
 	return page;
@@ -2480,12 +2549,15 @@ static struct list_head *get_populated_pcp_list(struct zone *zone,
 			unsigned int order, struct per_cpu_pages *pcp,
 			int migratetype, int cold)
 {
-	struct list_head *list = &pcp->lists[migratetype];
+	unsigned int pindex = pcp_list_index(order, migratetype);
+	struct list_head *list = &pcp->lists[pindex];
 
 	if (list_empty(list)) {
-		pcp->count += rmqueue_bulk(zone, order,
-				pcp->batch, list,
-				migratetype, cold);
+		/* refill about pcp->batch pages whatever the order */
+		int batch = max(READ_ONCE(pcp->batch) >> order, 1);
+
+		pcp->count += rmqueue_bulk(zone, order, batch, list,
+				migratetype, cold) << order;
 
 		if (list_empty(list))
 			list = NULL;
@@ -2510,10 +2582,8 @@ void drain_zone_pages(struct zone *zone, struct per_cpu_pages *pcp)
 	local_irq_save(flags);
 	batch = READ_ONCE(pcp->batch);
 	to_drain = min(pcp->count, batch);
-	if (to_drain > 0) {
+	if (to_drain > 0)
 		free_pcppages_bulk(zone, to_drain, pcp);
-		pcp->count -= to_drain;
-	}
 	local_irq_restore(flags);
 }
 #endif
@@ -2535,10 +2605,8 @@ static void drain_pages_zone(unsigned int cpu, struct zone *zone)
 	pset = per_cpu_ptr(zone->pageset, cpu);
 
 	pcp = &pset->pcp;
-	if (pcp->count) {
+	if (pcp->count)
 		free_pcppages_bulk(zone, pcp->count, pcp);
-		pcp->count = 0;
-	}
 	local_irq_restore(flags);
 }
 
@@ -2761,11 +2829,8 @@ void free_hot_cold_page(struct page *page, bool cold)
 	else
 		list_add_tail(&page->lru, &pcp->lists[migratetype]);
 	pcp->count++;
-	if (pcp->count >= pcp->high) {
-		unsigned long batch = READ_ONCE(pcp->batch);
-		free_pcppages_bulk(zone, batch, pcp);
-		pcp->count -= batch;
-	}
+	if (pcp->count >= pcp->high)
+		free_pcppages_bulk(zone, READ_ONCE(pcp->batch), pcp);
 
 out:
 	local_irq_restore(flags);
@@ -2878,8 +2943,8 @@ static inline void zone_statistics(struct zone *preferred_zone, struct zone *z)
 }
 
 /* Remove page from the per-cpu list, caller must protect the list */
-static struct page *__rmqueue_pcplist(struct zone *zone, int migratetype,
-			bool cold, struct per_cpu_pages *pcp,
+static struct page *__rmqueue_pcplist(struct zone *zone, unsigned int order,
+			int migratetype, bool cold, struct per_cpu_pages *pcp,
 			gfp_t gfp_flags)
 {
 	struct page *page = NULL;
@@ -2889,7 +2954,7 @@ static struct page *__rmqueue_pcplist(struct zone *zone, int migratetype,
 		/* First try to get CMA pages */
 		if (migratetype == MIGRATE_MOVABLE &&
 				gfp_flags & __GFP_CMA) {
-			list = get_populated_pcp_list(zone, 0, pcp,
+			list = get_populated_pcp_list(zone, order, pcp,
 					get_cma_migrate_type(), cold);
 		}
 
@@ -2898,7 +2963,7 @@ static struct page *__rmqueue_pcplist(struct zone *zone, int migratetype,
 			 * Either CMA is not suitable or there are no
 			 * free CMA pages.
 			 */
-			list = get_populated_pcp_list(zone, 0, pcp,
+			list = get_populated_pcp_list(zone, order, pcp,
 					migratetype, cold);
 			if (unlikely(list == NULL) ||
 					unlikely(list_empty(list)))
@@ -2912,8 +2977,8 @@ static struct page *__rmqueue_pcplist(struct zone *zone, int migratetype,
 			page = list_first_entry(list, struct page, lru);
 
 		list_del(&page->lru);
-		pcp->count--;
-	} while (check_new_pcp(page));
+		pcp->count -= 1 << order;
+	} while (order ? check_new_pages(page, order) : check_new_pcp(page));
 
 	return page;
 }
@@ -2930,7 +2995,7 @@ static struct page *rmqueue_pcplist(struct zone *preferred_zone,
 
 	local_irq_save(flags);
 	pcp = &this_cpu_ptr(zone->pageset)->pcp;
-	page = __rmqueue_pcplist(zone,  migratetype, cold, pcp,
+	page = __rmqueue_pcplist(zone, order, migratetype, cold, pcp,
 				 gfp_flags);
 	if (page) {
 		__count_zid_vm_events(PGALLOC, page_zonenum(page), 1 << order);
@@ -2941,7 +3006,9 @@ static struct page *rmqueue_pcplist(struct zone *preferred_zone,
 }
 
 /*
- * Allocate a page from the given zone. Use pcplists for order-0 allocations.
+ * Allocate a page from the given zone. Use pcplists for order-0 allocations,
+ * and for orders up to pcp_high_order unless the highatomic reserve may be
+ * needed.
  */
 static inline
 struct page *rmqueue(struct zone *preferred_zone,
@@ -2952,10 +3019,12 @@ struct page *rmqueue(struct zone *preferred_zone,
 	unsigned long flags;
 	struct page *page;
 
-	if (likely(order == 0)) {
+	if (likely(order == 0) || (order <= pcp_high_order &&
+				   !(alloc_flags & ALLOC_HARDER))) {
 		page = rmqueue_pcplist(preferred_zone, zone, order,
 				gfp_flags, migratetype);
-		goto out;
+		if (likely(page) || !order)
+			goto out;
 	}
 
 	/*
@@ -5750,14 +5819,14 @@ static void pageset_set_batch(struct per_cpu_pageset *p, unsigned long batch)
 static void pageset_init(struct per_cpu_pageset *p)
 {
 	struct per_cpu_pages *pcp;
-	int migratetype;
+	int pindex;
 
 	memset(p, 0, sizeof(*p));
 
 	pcp = &p->pcp;
 	pcp->count = 0;
-	for (migratetype = 0; migratetype < MIGRATE_PCPTYPES; migratetype++)
-		INIT_LIST_HEAD(&pcp->lists[migratetype]);
+	for (pindex = 0; pindex < NR_PCP_LISTS; pindex++)
+		INIT_LIST_HEAD(&pcp->lists[pindex]);
 }
 
 static void setup_pageset(struct per_cpu_pageset *p, unsigned long batch)
@@ -371,7 +371,14 @@ int swap_readpage(struct page *page, bool synchronous)
 		return ret;
 	}
 
-	ret = bdev_read_page(sis->bdev, map_swap_page(page, &sis->bdev), page);
+	/*
+	 * Readahead goes through a bio even if the device has ->rw_page, so
+	 * that the device can complete it off the faulting task.
+	 */
+	ret = -EOPNOTSUPP;
+	if (synchronous || !PageReadahead(page))
+		ret = bdev_read_page(sis->bdev, map_swap_page(page, &sis->bdev),
+				     page);
 	if (!ret) {
 		if (trylock_page(page)) {
 			swap_slot_free_notify(page);
@@ -396,7 +403,8 @@ int swap_readpage(struct page *page, bool synchronous)
 	 */
 	get_task_struct(current);
 	bio->bi_private = current;
-	bio_set_op_attrs(bio, REQ_OP_READ, 0);
+	bio_set_op_attrs(bio, REQ_OP_READ,
+			 PageReadahead(page) ? REQ_RAHEAD : 0);
 	count_vm_event(PSWPIN);
 	bio_get(bio);
 	qc = submit_bio(bio);
@@ -20,6 +20,8 @@
 #include <linux/rcupdate.h>
 #include <linux/notifier.h>
 #include <linux/vmpressure.h>
+#include <linux/workqueue.h>
+#include <linux/sched/topology.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/process_reclaim.h>
@@ -29,6 +31,10 @@
 static void swap_fn(struct work_struct *work);
 DECLARE_WORK(swap_work, swap_fn);
 
+/* Per task reclaim runs here, restricted to the lowest capacity CPUs */
+static struct workqueue_struct *reclaim_wq;
+static bool reclaim_wq_affine;
+
 /* User knob to enable/disable process reclaim feature */
 static int enable_process_reclaim;
 module_param_named(enable_process_reclaim, enable_process_reclaim, int, 0644);
@@ -68,12 +74,27 @@ static atomic_t skip_reclaim = ATOMIC_INIT(0);
 /* Not atomic since only a single instance of swap_fn run at a time */
 static int monitor_eff;
 
+/*
+ * Tasks whose reclaimed pages are swapped back in quickly get a
+ * smaller share of per_swap_size. refault_min_share is the share, in
+ * percent of the anon size, a task keeps at a 100% refault rate, so
+ * its rate keeps being sampled.
+ */
+static int refault_min_share = 6;
+module_param_named(refault_min_share, refault_min_share, int, 0644);
+
 struct selected_task {
 	struct task_struct *p;
 	int tasksize;
+	int weight;
+	int nr_to_reclaim;
 	short oom_score_adj;
+	struct reclaim_param rp;
+	struct work_struct work;
 };
 
+static struct selected_task selected[MAX_SWAP_TASKS];
+
 int selected_cmp(const void *a, const void *b)
 {
 	const struct selected_task *x = a;
@@ -104,22 +125,84 @@ static int test_task_flag(struct task_struct *p, int flag)
 	return 0;
 }
 
+/*
+ * Percentage of the pages reclaimed from @mm on the previous run that
+ * have been swapped back in since.
+ */
+static int task_refault_pct(struct mm_struct *mm)
+{
+	unsigned long refaults;
+
+	if (!mm->reclaim_last_nr)
+		return 0;
+
+	refaults = atomic_long_read(&mm->swap_refaults) -
+			mm->reclaim_refault_snap;
+
+	return min_t(unsigned long, refaults * 100 / mm->reclaim_last_nr, 100);
+}
+
+static void reclaim_task_fn(struct work_struct *work)
+{
+	struct selected_task *st = container_of(work, struct selected_task,
+						work);
+	struct mm_struct *mm;
+
+	st->rp = reclaim_task_anon(st->p, st->nr_to_reclaim);
+
+	mm = get_task_mm(st->p);
+	if (mm) {
+		if (st->rp.nr_reclaimed) {
+			mm->reclaim_refault_snap =
+				atomic_long_read(&mm->swap_refaults);
+			mm->reclaim_last_nr = st->rp.nr_reclaimed;
+		}
+		mmput(mm);
+	}
+}
+
+static void reclaim_wq_set_affinity(void)
+{
+	struct workqueue_attrs *attrs;
+	unsigned long min_cap = ULONG_MAX;
+	int cpu;
+
+	/* CPU capacities are only final once cpufreq is up */
+	reclaim_wq_affine = true;
+
+	attrs = alloc_workqueue_attrs(GFP_KERNEL);
+	if (!attrs)
+		return;
+
+	for_each_possible_cpu(cpu)
+		min_cap = min(min_cap, arch_scale_cpu_capacity(NULL, cpu));
+
+	for_each_possible_cpu(cpu)
+		if (arch_scale_cpu_capacity(NULL, cpu) == min_cap)
+			cpumask_set_cpu(cpu, attrs->cpumask);
+
+	apply_workqueue_attrs(reclaim_wq, attrs);
+	free_workqueue_attrs(attrs);
+}
+
 static void swap_fn(struct work_struct *work)
 {
 	struct task_struct *tsk;
-	struct reclaim_param rp;
 
 	/* Pick the best MAX_SWAP_TASKS tasks in terms of anon size */
-	struct selected_task selected[MAX_SWAP_TASKS] = {{0, 0, 0},};
 	int si = 0;
 	int i;
 	int tasksize;
+	int refault_pct;
 	int total_sz = 0;
+	long total_weight = 0;
 	int total_scan = 0;
 	int total_reclaimed = 0;
-	int nr_to_reclaim;
 	int efficiency;
 
+	if (!reclaim_wq_affine)
+		reclaim_wq_set_affinity();
+
 	rcu_read_lock();
 	for_each_process(tsk) {
 		struct task_struct *p;
@@ -142,6 +225,7 @@ static void swap_fn(struct work_struct *work)
 		}
 
 		tasksize = get_mm_counter(p->mm, MM_ANONPAGES);
+		refault_pct = task_refault_pct(p->mm);
 		task_unlock(p);
 
 		if (tasksize <= 0)
@@ -153,19 +237,23 @@ static void swap_fn(struct work_struct *work)
 					&selected_cmp, NULL);
 			if (tasksize < selected[0].tasksize)
 				continue;
-			selected[0].p = p;
-			selected[0].oom_score_adj = oom_score_adj;
-			selected[0].tasksize = tasksize;
+			i = 0;
 		} else {
-			selected[si].p = p;
-			selected[si].oom_score_adj = oom_score_adj;
-			selected[si].tasksize = tasksize;
-			si++;
+			i = si++;
 		}
+		selected[i].p = p;
+		selected[i].oom_score_adj = oom_score_adj;
+		selected[i].tasksize = tasksize;
+		selected[i].weight = max(tasksize * (100 - refault_pct) / 100,
+					 tasksize * refault_min_share / 100);
+		if (!selected[i].weight)
+			selected[i].weight = 1;
 	}
 
-	for (i = 0; i < si; i++)
+	for (i = 0; i < si; i++) {
 		total_sz += selected[i].tasksize;
+		total_weight += selected[i].weight;
+	}
 
 	/* Skip reclaim if total size is too less */
 	if (total_sz < SWAP_CLUSTER_MAX) {
@@ -178,21 +266,28 @@ static void swap_fn(struct work_struct *work)
 
 	rcu_read_unlock();
 
-	while (si--) {
-		nr_to_reclaim =
-			(selected[si].tasksize * per_swap_size) / total_sz;
+	for (i = 0; i < si; i++) {
+		selected[i].nr_to_reclaim = div64_s64(
+			(s64)selected[i].weight * per_swap_size, total_weight);
 		/* scan atleast a page */
-		if (!nr_to_reclaim)
-			nr_to_reclaim = 1;
+		if (!selected[i].nr_to_reclaim)
+			selected[i].nr_to_reclaim = 1;
 
-		rp = reclaim_task_anon(selected[si].p, nr_to_reclaim);
+		INIT_WORK(&selected[i].work, reclaim_task_fn);
+		queue_work(reclaim_wq, &selected[i].work);
+	}
+
+	flush_workqueue(reclaim_wq);
+
+	while (si--) {
+		struct reclaim_param *rp = &selected[si].rp;
 
 		trace_process_reclaim(selected[si].tasksize,
-				selected[si].oom_score_adj, rp.nr_scanned,
-				rp.nr_reclaimed, per_swap_size, total_sz,
-				nr_to_reclaim);
-		total_scan += rp.nr_scanned;
-		total_reclaimed += rp.nr_reclaimed;
+				selected[si].oom_score_adj, rp->nr_scanned,
+				rp->nr_reclaimed, per_swap_size, total_sz,
+				selected[si].nr_to_reclaim);
+		total_scan += rp->nr_scanned;
+		total_reclaimed += rp->nr_reclaimed;
 		put_task_struct(selected[si].p);
 	}
 
@@ -240,6 +335,11 @@ static struct notifier_block vmpr_nb = {
 
 static int __init process_reclaim_init(void)
 {
+	reclaim_wq = alloc_workqueue("process_reclaim",
+				     WQ_UNBOUND | WQ_FREEZABLE, MAX_SWAP_TASKS);
+	if (!reclaim_wq)
+		return -ENOMEM;
+
 	vmpressure_notifier_register(&vmpr_nb);
 	return 0;
 }
@@ -247,6 +347,8 @@ static int __init process_reclaim_init(void)
 static void __exit process_reclaim_exit(void)
 {
 	vmpressure_notifier_unregister(&vmpr_nb);
+	cancel_work_sync(&swap_work);
+	destroy_workqueue(reclaim_wq);
 }
 
 module_init(process_reclaim_init);
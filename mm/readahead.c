@@ -19,6 +19,7 @@
 #include <linux/syscalls.h>
 #include <linux/file.h>
 #include <linux/mm_inline.h>
+#include <linux/launch_readahead.h>
 
 #include "internal.h"
 
@@ -195,8 +196,10 @@ int __do_page_cache_readahead(struct address_space *mapping, struct file *filp,
 	 * uptodate then the caller will launch readpage again, and
 	 * will then handle the error.
 	 */
-	if (ret)
+	if (ret) {
+		launch_ra_record(inode, offset, page_idx);
 		read_pages(mapping, filp, &page_pool, ret, gfp_mask);
+	}
 	BUG_ON(!list_empty(&page_pool));
 out:
 	return ret;
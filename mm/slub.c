@@ -3538,9 +3538,45 @@ static void set_min_partial(struct kmem_cache *s, unsigned long min)
 	s->min_partial = min;
 }
 
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+/*
+ * slub_cpu_partial=<cache>:<objects>[,<cache>:<objects>...] overrides the
+ * size based cpu_partial default for the named caches from the moment they
+ * are created, for hot caches that bounce slabs between CPUs and keep
+ * refilling from the node partial list.
+ */
+static char slub_cpu_partial_override[256];
+
+static bool slub_cpu_partial_lookup(const char *name, unsigned int *objects)
+{
+	const char *p = slub_cpu_partial_override;
+	size_t len = strlen(name);
+
+	while (*p) {
+		const char *sep = strchr(p, ':');
+		char *end;
+
+		if (!sep)
+			break;
+		if (sep - p == len && !strncmp(p, name, len)) {
+			*objects = simple_strtoul(sep + 1, &end, 0);
+			return end != sep + 1;
+		}
+		p = strchr(sep, ',');
+		if (!p)
+			break;
+		p++;
+	}
+
+	return false;
+}
+#endif
+
 static void set_cpu_partial(struct kmem_cache *s)
 {
 #ifdef CONFIG_SLUB_CPU_PARTIAL
+	unsigned int objects;
+
 	/*
 	 * cpu_partial determined the maximum number of objects kept in the
 	 * per cpu partial lists of a processor.
@@ -3568,6 +3604,9 @@ static void set_cpu_partial(struct kmem_cache *s)
 		s->cpu_partial = 13;
 	else
 		s->cpu_partial = 30;
+
+	if (s->cpu_partial && slub_cpu_partial_lookup(s->name, &objects))
+		s->cpu_partial = objects;
 #endif
 }
 
@@ -3863,6 +3902,18 @@ static int __init setup_slub_min_objects(char *str)
 
 __setup("slub_min_objects=", setup_slub_min_objects);
 
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+static int __init setup_slub_cpu_partial(char *str)
+{
+	strlcpy(slub_cpu_partial_override, str,
+		sizeof(slub_cpu_partial_override));
+
+	return 1;
+}
+
+__setup("slub_cpu_partial=", setup_slub_cpu_partial);
+#endif
+
 void *__kmalloc(size_t size, gfp_t flags)
 {
 	struct kmem_cache *s;
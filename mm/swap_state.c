@@ -749,6 +749,17 @@ struct page *swap_vma_readahead(swp_entry_t fentry, gfp_t gfp_mask,
 	if (ra_info.win == 1)
 		goto skip;
 
+	/*
+	 * Devices like zram read in the caller's context: get the faulting
+	 * page first so that it does not wait behind the readahead.
+	 */
+	if (swp_swap_info(fentry)->flags & SWP_SYNCHRONOUS_IO) {
+		page = read_swap_cache_async(fentry, gfp_mask, vma,
+					     vmf->address, false);
+		if (page)
+			put_page(page);
+	}
+
 	blk_start_plug(&plug);
 	for (i = 0, pte = ra_info.ptes; i < ra_info.nr_pte;
 	     i++, pte++) {
@@ -765,12 +776,12 @@ struct page *swap_vma_readahead(swp_entry_t fentry, gfp_t gfp_mask,
 		if (!page)
 			continue;
 		if (page_allocated) {
-			swap_readpage(page, false);
 			if (i != ra_info.offset &&
 			    likely(!PageTransCompound(page))) {
 				SetPageReadahead(page);
 				count_vm_event(SWAP_RA);
 			}
+			swap_readpage(page, false);
 		}
 		put_page(page);
 	}
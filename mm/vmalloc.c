@@ -1380,17 +1380,21 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end)
 }
 
 /*
- * Kick off a purge of the outstanding lazy areas. Don't bother if somebody
- * is already purging.
+ * Purge the outstanding lazy areas from a worker, so that the TLB flush and
+ * the merge back into the free tree are not charged to whoever happened to
+ * cross lazy_max_pages() in vfree(). Keep going while frees outpace us.
  */
-static void try_purge_vmap_area_lazy(void)
+static void drain_vmap_area_work(struct work_struct *work)
 {
-	if (mutex_trylock(&vmap_purge_lock)) {
+	do {
+		mutex_lock(&vmap_purge_lock);
 		__purge_vmap_area_lazy(ULONG_MAX, 0);
 		mutex_unlock(&vmap_purge_lock);
-	}
+	} while (atomic_long_read(&vmap_lazy_nr) > lazy_max_pages());
 }
 
+static DECLARE_WORK(drain_vmap_work, drain_vmap_area_work);
+
 /*
  * Kick off a purge of the outstanding lazy areas.
  */
@@ -1422,7 +1426,7 @@ static void free_vmap_area_noflush(struct vmap_area *va)
 	llist_add(&va->purge_list, &vmap_purge_list);
 
 	if (unlikely(nr_lazy > lazy_max_pages()))
-		try_purge_vmap_area_lazy();
+		schedule_work(&drain_vmap_work);
 }
 
 /*
@@ -859,6 +859,203 @@ void putback_lru_page(struct page *page)
 	put_page(page);		/* drop ref from isolate */
 }
 
+#ifdef CONFIG_LRU_PT_AGING
+/*
+ * Page table walk aging for anon pages.
+ *
+ * kswapd periodically walks the page tables of every mm and moves the
+ * accessed bit of each young anon pte into PG_referenced. While the
+ * result of the last walk is recent, reclaim uses PG_referenced for
+ * anon pages and skips the rmap walk in page_referenced(), which is
+ * what dominates kswapd time when most memory is anon.
+ */
+int sysctl_lru_pt_aging;
+int sysctl_lru_pt_aging_interval_ms = 500;
+
+static LIST_HEAD(lru_pt_aging_mm_list);
+static DEFINE_SPINLOCK(lru_pt_aging_mm_lock);
+static unsigned long lru_pt_aging_nr_mm;
+/* bumped for every new mm, whose ptes a walk in progress may miss */
+static unsigned long lru_pt_aging_mm_gen;
+static DEFINE_MUTEX(lru_pt_aging_mutex);
+/* jiffies at the end of the last complete walk, 0 if none */
+static unsigned long lru_pt_aging_stamp;
+
+void lru_pt_aging_add_mm(struct mm_struct *mm)
+{
+	spin_lock(&lru_pt_aging_mm_lock);
+	list_add_tail(&mm->lru_pt_aging_list, &lru_pt_aging_mm_list);
+	lru_pt_aging_nr_mm++;
+	lru_pt_aging_mm_gen++;
+	spin_unlock(&lru_pt_aging_mm_lock);
+}
+
+void lru_pt_aging_del_mm(struct mm_struct *mm)
+{
+	spin_lock(&lru_pt_aging_mm_lock);
+	list_del(&mm->lru_pt_aging_list);
+	lru_pt_aging_nr_mm--;
+	spin_unlock(&lru_pt_aging_mm_lock);
+}
+
+static int lru_pt_aging_pte_range(pmd_t *pmd, unsigned long addr,
+				  unsigned long end, struct mm_walk *walk)
+{
+	struct vm_area_struct *vma = walk->vma;
+	pte_t *orig_pte, *pte;
+	spinlock_t *ptl;
+
+	/* THP keeps using rmap, see lru_pt_aging_page() */
+	if (pmd_trans_unstable(pmd))
+		return 0;
+
+	orig_pte = pte = pte_offset_map_lock(walk->mm, pmd, addr, &ptl);
+	for (; addr != end; pte++, addr += PAGE_SIZE) {
+		struct page *page;
+
+		if (!pte_present(*pte) || !pte_young(*pte))
+			continue;
+
+		page = vm_normal_page(vma, addr, *pte);
+		if (!page || !PageAnon(page))
+			continue;
+
+		if (ptep_test_and_clear_young(vma, addr, pte))
+			SetPageReferenced(page);
+	}
+	pte_unmap_unlock(orig_pte, ptl);
+	cond_resched();
+
+	return 0;
+}
+
+/* Returns false if the anon ptes of @mm could not be walked */
+static bool lru_pt_aging_walk_mm(struct mm_struct *mm)
+{
+	struct mm_walk walk = {
+		.pmd_entry = lru_pt_aging_pte_range,
+		.mm = mm,
+	};
+	struct vm_area_struct *vma;
+
+	if (!get_mm_counter(mm, MM_ANONPAGES))
+		return true;
+
+	/* Never wait for a writer, the next walk catches up */
+	if (!down_read_trylock(&mm->mmap_sem))
+		return false;
+
+	for (vma = mm->mmap; vma; vma = vma->vm_next) {
+		if (!vma->anon_vma || is_vm_hugetlb_page(vma) ||
+		    (vma->vm_flags & (VM_LOCKED | VM_PFNMAP | VM_IO)))
+			continue;
+
+		walk_page_range(vma->vm_start, vma->vm_end, &walk);
+	}
+	up_read(&mm->mmap_sem);
+
+	return true;
+}
+
+/* Returns true if every mm that can map an anon page was walked */
+static bool lru_pt_aging_walk(void)
+{
+	unsigned long nr, gen;
+	bool complete = true;
+
+	spin_lock(&lru_pt_aging_mm_lock);
+	nr = lru_pt_aging_nr_mm;
+	gen = lru_pt_aging_mm_gen;
+	spin_unlock(&lru_pt_aging_mm_lock);
+
+	/* Rotate the list once; exiting mms drop out under the lock */
+	while (nr--) {
+		struct mm_struct *mm = NULL;
+
+		spin_lock(&lru_pt_aging_mm_lock);
+		if (!list_empty(&lru_pt_aging_mm_list)) {
+			mm = list_first_entry(&lru_pt_aging_mm_list,
+					      struct mm_struct,
+					      lru_pt_aging_list);
+			list_move_tail(&mm->lru_pt_aging_list,
+				       &lru_pt_aging_mm_list);
+			if (!mmget_not_zero(mm))
+				mm = NULL;
+		}
+		spin_unlock(&lru_pt_aging_mm_lock);
+
+		if (!mm)
+			continue;
+
+		if (!lru_pt_aging_walk_mm(mm))
+			complete = false;
+		/* keep exit_mmap() out of kswapd */
+		mmput_async(mm);
+	}
+
+	spin_lock(&lru_pt_aging_mm_lock);
+	if (gen != lru_pt_aging_mm_gen)
+		complete = false;
+	spin_unlock(&lru_pt_aging_mm_lock);
+
+	return complete;
+}
+
+static void lru_pt_aging_age(void)
+{
+	unsigned long interval;
+
+	if (!READ_ONCE(sysctl_lru_pt_aging))
+		return;
+
+	interval = msecs_to_jiffies(sysctl_lru_pt_aging_interval_ms);
+	if (lru_pt_aging_stamp &&
+	    time_before(jiffies, lru_pt_aging_stamp + interval))
+		return;
+
+	if (!mutex_trylock(&lru_pt_aging_mutex))
+		return;
+
+	/*
+	 * A page mapped by an mm the walk missed may be hot without
+	 * PG_referenced, so only a complete walk lets reclaim skip rmap.
+	 */
+	if (lru_pt_aging_walk())
+		WRITE_ONCE(lru_pt_aging_stamp, jiffies ? jiffies : 1);
+	else
+		WRITE_ONCE(lru_pt_aging_stamp, 0);
+	mutex_unlock(&lru_pt_aging_mutex);
+}
+
+/*
+ * PG_referenced reflects the anon pte accessed bits if a walk over every
+ * mm completed within two intervals. Otherwise fall back to rmap. Shmem
+ * is swap backed too, but the walk only harvests anon ptes.
+ */
+static bool lru_pt_aging_page(struct page *page)
+{
+	unsigned long stamp = READ_ONCE(lru_pt_aging_stamp);
+
+	if (!READ_ONCE(sysctl_lru_pt_aging) || !stamp)
+		return false;
+
+	if (!PageAnon(page) || PageTransHuge(page))
+		return false;
+
+	return time_before(jiffies, stamp +
+		2 * msecs_to_jiffies(sysctl_lru_pt_aging_interval_ms));
+}
+
+static bool lru_pt_aging_enabled(void)
+{
+	return READ_ONCE(sysctl_lru_pt_aging);
+}
+#else
+static inline void lru_pt_aging_age(void) { }
+static inline bool lru_pt_aging_page(struct page *page) { return false; }
+static inline bool lru_pt_aging_enabled(void) { return false; }
+#endif
+
 enum page_references {
 	PAGEREF_RECLAIM,
 	PAGEREF_RECLAIM_CLEAN,
@@ -872,6 +1069,16 @@ static enum page_references page_check_references(struct page *page,
 	int referenced_ptes, referenced_page;
 	unsigned long vm_flags;
 
+	/*
+	 * The page table walk already harvested the accessed bits,
+	 * mlocked pages are left to try_to_unmap() as below.
+	 */
+	if (lru_pt_aging_page(page)) {
+		if (TestClearPageReferenced(page))
+			return PAGEREF_ACTIVATE;
+		return PAGEREF_RECLAIM;
+	}
+
 	referenced_ptes = page_referenced(page, 1, sc->target_mem_cgroup,
 					  &vm_flags);
 	referenced_page = TestClearPageReferenced(page);
@@ -918,6 +1125,10 @@ static enum page_references page_check_references(struct page *page,
 	if (referenced_page && !PageSwapBacked(page))
 		return PAGEREF_RECLAIM_CLEAN;
 
+	/* A stale walk moved the pte accessed bit into PG_referenced */
+	if (referenced_page && lru_pt_aging_enabled())
+		return PAGEREF_ACTIVATE;
+
 	return PAGEREF_RECLAIM;
 }
 
@@ -2071,7 +2282,7 @@ static void shrink_active_list(unsigned long nr_to_scan,
 {
 	unsigned long nr_taken;
 	unsigned long nr_scanned;
-	unsigned long vm_flags;
+	unsigned long vm_flags = 0;
 	LIST_HEAD(l_hold);	/* The pages which were snipped off */
 	LIST_HEAD(l_active);
 	LIST_HEAD(l_inactive);
@@ -2083,6 +2294,9 @@ static void shrink_active_list(unsigned long nr_to_scan,
 	int file = is_file_lru(lru);
 	struct pglist_data *pgdat = lruvec_pgdat(lruvec);
 
+	if (!file && current_is_kswapd())
+		lru_pt_aging_age();
+
 	lru_add_drain();
 
 	if (!sc->may_unmap)
@@ -2119,7 +2333,8 @@ static void shrink_active_list(unsigned long nr_to_scan,
 			}
 		}
 
-		if (page_referenced(page, 0, sc->target_mem_cgroup,
+		if (lru_pt_aging_page(page) ? PageReferenced(page) :
+		    page_referenced(page, 0, sc->target_mem_cgroup,
 				    &vm_flags)) {
 			nr_rotated += hpage_nr_pages(page);
 			/*
@@ -1010,6 +1010,23 @@ int fragmentation_index(struct zone *zone, unsigned int order)
 	fill_contig_page_info(zone, order, &info);
 	return __fragmentation_index(order, &info);
 }
+
+/*
+ * Share of the zone's free memory, in percent, that sits in blocks too
+ * small for an allocation of @order.
+ */
+unsigned int extfrag_for_order(struct zone *zone, unsigned int order)
+{
+	struct contig_page_info info;
+
+	fill_contig_page_info(zone, order, &info);
+	if (info.free_pages == 0)
+		return 0;
+
+	return div_u64((info.free_pages -
+			(info.free_blocks_suitable << order)) * 100,
+		       info.free_pages);
+}
 #endif
 
 #if defined(CONFIG_PROC_FS) || defined(CONFIG_SYSFS) || defined(CONFIG_NUMA)
@@ -1088,6 +1105,8 @@ const char * const vmstat_text[] = {
 	"nr_shmem",
 	"nr_shmem_hugepages",
 	"nr_shmem_pmdmapped",
+	"nr_file_hugepages",
+	"nr_file_pmdmapped",
 	"nr_anon_transparent_hugepages",
 	"nr_unstable",
 	"nr_vmscan_write",
@@ -1167,6 +1186,7 @@ const char * const vmstat_text[] = {
 	"compact_daemon_wake",
 	"compact_daemon_migrate_scanned",
 	"compact_daemon_free_scanned",
+	"compact_daemon_proactive",
 #endif
 
 #ifdef CONFIG_HUGETLB_PAGE
@@ -1223,7 +1243,13 @@ const char * const vmstat_text[] = {
 	"swap_ra_hit",
 #endif
 #ifdef CONFIG_SPECULATIVE_PAGE_FAULT
-	"speculative_pgfault"
+	"speculative_pgfault",
+	"spf_abort_vma_changed",
+	"spf_abort_vma_notsup",
+	"spf_abort_vma_access",
+	"spf_abort_pmd_changed",
+	"spf_abort_pte_lock",
+	"spf_abort_no_pgtable",
 #endif
 #endif /* CONFIG_VM_EVENT_COUNTERS */
 };
@@ -1720,6 +1746,12 @@ static const struct file_operations vmstat_file_operations = {
 #ifdef CONFIG_SMP
 static DEFINE_PER_CPU(struct delayed_work, vmstat_work);
 int sysctl_stat_interval __read_mostly = HZ;
+/*
+ * Don't let the shepherd wake up idle cpus to fold their diffs. They are
+ * folded when the cpu goes idle with the tick stopped or runs again, and
+ * stay bounded by the stat thresholds in the meantime.
+ */
+int sysctl_stat_skip_idle __read_mostly;
 
 #ifdef CONFIG_PROC_FS
 static void refresh_vm_stats(struct work_struct *work)
@@ -1837,7 +1869,12 @@ void quiet_vmstat(void)
 	if (system_state != SYSTEM_RUNNING)
 		return;
 
-	if (!delayed_work_pending(this_cpu_ptr(&vmstat_work)))
+	/*
+	 * Diffs made after vmstat_update stopped rearming itself would
+	 * otherwise be left for the shepherd, which has to wake us up.
+	 */
+	if (!sysctl_stat_skip_idle &&
+	    !delayed_work_pending(this_cpu_ptr(&vmstat_work)))
 		return;
 
 	if (!need_update(smp_processor_id()))
@@ -1871,6 +1908,9 @@ static void vmstat_shepherd(struct work_struct *w)
 	for_each_online_cpu(cpu) {
 		struct delayed_work *dw = &per_cpu(vmstat_work, cpu);
 
+		if (sysctl_stat_skip_idle && idle_cpu(cpu))
+			continue;
+
 		if (!delayed_work_pending(dw) && need_update(cpu) &&
 		     !cpu_isolated(cpu))
 			queue_delayed_work_on(cpu, mm_percpu_wq, dw, 0);
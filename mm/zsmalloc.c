@@ -54,6 +54,9 @@
 #include <linux/migrate.h>
 #include <linux/wait.h>
 #include <linux/pagemap.h>
+#include <linux/workqueue.h>
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
 
 #define ZSPAGE_MAGIC	0x58
 
@@ -193,6 +196,20 @@ static struct vfsmount *zsmalloc_mnt;
  */
 static const int fullness_threshold_frac = 4;
 
+/*
+ * Frees kick a background compaction once the pages that compaction
+ * could release exceed bg_compact_frag percent of the pool; 0 disables
+ * it. The worker migrates at most ZS_BG_COMPACT_BATCH source zspages
+ * of a class before it looks for the most fragmented class again.
+ */
+static unsigned int bg_compact_frag = 20;
+module_param(bg_compact_frag, uint, 0644);
+MODULE_PARM_DESC(bg_compact_frag,
+	"Fragmentation percentage that triggers background compaction");
+
+#define ZS_BG_COMPACT_BATCH	32
+#define ZS_BG_COMPACT_DELAY	HZ
+
 struct size_class {
 	spinlock_t lock;
 	struct list_head fullness_list[NR_ZS_FULLNESS];
@@ -207,6 +224,11 @@ struct size_class {
 
 	unsigned int index;
 	struct zs_size_stat stats;
+
+	/* compaction cost, protected by class->lock */
+	unsigned long objs_migrated;
+	unsigned long pages_compacted;
+	u64 compact_ns;
 };
 
 /* huge object: pages_per_zspage == 1 && maxobj_per_zspage == 1 */
@@ -263,6 +285,8 @@ struct zs_pool {
 	 * and unregister_shrinker() will not Oops.
 	 */
 	bool shrinker_enabled;
+	/* Compact the most fragmented classes off the allocation path */
+	struct delayed_work compact_work;
 #ifdef CONFIG_ZSMALLOC_STAT
 	struct dentry *stat_dentry;
 #endif
@@ -302,6 +326,8 @@ struct mapping_area {
 	enum zs_mapmode vm_mm; /* mapping mode */
 };
 
+static void kick_background_compaction(struct zs_pool *pool);
+
 #ifdef CONFIG_COMPACTION
 static int zs_register_migration(struct zs_pool *pool);
 static void zs_unregister_migration(struct zs_pool *pool);
@@ -669,6 +695,59 @@ static const struct file_operations zs_stat_size_ops = {
 	.release        = single_release,
 };
 
+static int zs_stats_compact_show(struct seq_file *s, void *v)
+{
+	int i;
+	struct zs_pool *pool = s->private;
+	struct size_class *class;
+	unsigned long obj_allocated, obj_used, freeable;
+	unsigned long objs_migrated, pages_compacted;
+	u64 compact_ns;
+
+	seq_printf(s, " %5s %5s %5s %8s %13s %15s %12s\n",
+			"class", "size", "frag%", "freeable",
+			"objs_migrated", "pages_compacted", "compact_us");
+
+	for (i = 0; i < ZS_SIZE_CLASSES; i++) {
+		class = pool->size_class[i];
+
+		if (class->index != i)
+			continue;
+
+		spin_lock(&class->lock);
+		obj_allocated = zs_stat_get(class, OBJ_ALLOCATED);
+		obj_used = zs_stat_get(class, OBJ_USED);
+		freeable = zs_can_compact(class);
+		objs_migrated = class->objs_migrated;
+		pages_compacted = class->pages_compacted;
+		compact_ns = class->compact_ns;
+		spin_unlock(&class->lock);
+
+		if (!obj_allocated)
+			continue;
+
+		seq_printf(s, " %5u %5u %5lu %8lu %13lu %15lu %12llu\n",
+			i, class->size,
+			(obj_allocated - obj_used) * 100 / obj_allocated,
+			freeable, objs_migrated, pages_compacted,
+			div_u64(compact_ns, NSEC_PER_USEC));
+	}
+
+	return 0;
+}
+
+static int zs_stats_compact_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, zs_stats_compact_show, inode->i_private);
+}
+
+static const struct file_operations zs_stat_compact_ops = {
+	.open           = zs_stats_compact_open,
+	.read           = seq_read,
+	.llseek         = seq_lseek,
+	.release        = single_release,
+};
+
 static void zs_pool_stat_create(struct zs_pool *pool, const char *name)
 {
 	struct dentry *entry;
@@ -692,7 +771,14 @@ static void zs_pool_stat_create(struct zs_pool *pool, const char *name)
 				name, "classes");
 		debugfs_remove_recursive(pool->stat_dentry);
 		pool->stat_dentry = NULL;
+		return;
 	}
+
+	entry = debugfs_create_file("compaction", S_IFREG | S_IRUGO,
+			pool->stat_dentry, pool, &zs_stat_compact_ops);
+	if (!entry)
+		pr_warn("%s: debugfs file entry <%s> creation failed\n",
+				name, "compaction");
 }
 
 static void zs_pool_stat_destroy(struct zs_pool *pool)
@@ -1636,6 +1722,8 @@ void zs_free(struct zs_pool *pool, unsigned long handle)
 	spin_unlock(&class->lock);
 	unpin_tag(handle);
 	cache_free_handle(pool, handle);
+
+	kick_background_compaction(pool);
 }
 EXPORT_SYMBOL_GPL(zs_free);
 
@@ -1747,6 +1835,8 @@ struct zs_compact_control {
 	 /* Starting object index within @s_page which used for live object
 	  * in the subpage. */
 	int obj_idx;
+	/* Number of objects moved so far */
+	unsigned long nr_migrated;
 };
 
 static int migrate_zspage(struct zs_pool *pool, struct size_class *class,
@@ -1790,6 +1880,7 @@ static int migrate_zspage(struct zs_pool *pool, struct size_class *class,
 		record_obj(handle, free_obj);
 		unpin_tag(handle);
 		obj_free(class, used_obj);
+		cc->nr_migrated++;
 	}
 
 	/* Remember last position in this iteration */
@@ -2312,13 +2403,23 @@ static unsigned long zs_can_compact(struct size_class *class)
 	return obj_wasted * class->pages_per_zspage;
 }
 
+/*
+ * Migrate objects out of at most @max_zspages source zspages, so that
+ * the background worker only holds off zs_map_object() users of the
+ * class for a bounded time.
+ */
 static unsigned long __zs_compact(struct zs_pool *pool,
-				  struct size_class *class)
+				  struct size_class *class,
+				  unsigned long max_zspages)
 {
 	struct zs_compact_control cc;
 	struct zspage *src_zspage;
 	struct zspage *dst_zspage = NULL;
 	unsigned long pages_freed = 0;
+	unsigned long nr_zspages = 0;
+	u64 start = ktime_get_ns();
+
+	cc.nr_migrated = 0;
 
 	spin_lock(&class->lock);
 	while ((src_zspage = isolate_zspage(class, true))) {
@@ -2350,6 +2451,11 @@ static unsigned long __zs_compact(struct zs_pool *pool,
 			free_zspage(pool, class, src_zspage);
 			pages_freed += class->pages_per_zspage;
 		}
+		src_zspage = NULL;
+
+		if (++nr_zspages >= max_zspages)
+			break;
+
 		spin_unlock(&class->lock);
 		cond_resched();
 		spin_lock(&class->lock);
@@ -2358,6 +2464,9 @@ static unsigned long __zs_compact(struct zs_pool *pool,
 	if (src_zspage)
 		putback_zspage(class, src_zspage);
 
+	class->objs_migrated += cc.nr_migrated;
+	class->pages_compacted += pages_freed;
+	class->compact_ns += ktime_get_ns() - start;
 	spin_unlock(&class->lock);
 
 	return pages_freed;
@@ -2375,7 +2484,7 @@ unsigned long zs_compact(struct zs_pool *pool)
 			continue;
 		if (class->index != i)
 			continue;
-		pages_freed += __zs_compact(pool, class);
+		pages_freed += __zs_compact(pool, class, ULONG_MAX);
 	}
 	atomic_long_add(pages_freed, &pool->stats.pages_compacted);
 
@@ -2383,6 +2492,68 @@ unsigned long zs_compact(struct zs_pool *pool)
 }
 EXPORT_SYMBOL_GPL(zs_compact);
 
+/*
+ * Return true if the pages that compaction could free exceed
+ * bg_compact_frag percent of the pool, and the class with the
+ * most freeable pages in @best.
+ */
+static bool zs_pool_fragmented(struct zs_pool *pool,
+				struct size_class **best)
+{
+	int i;
+	struct size_class *class;
+	unsigned long freeable, total = 0, max = 0;
+	unsigned int frag = READ_ONCE(bg_compact_frag);
+
+	*best = NULL;
+	for (i = ZS_SIZE_CLASSES - 1; i >= 0; i--) {
+		class = pool->size_class[i];
+		if (!class)
+			continue;
+		if (class->index != i)
+			continue;
+
+		freeable = zs_can_compact(class);
+		total += freeable;
+		if (freeable > max) {
+			max = freeable;
+			*best = class;
+		}
+	}
+
+	if (!frag || !*best)
+		return false;
+
+	return total * 100 > frag * atomic_long_read(&pool->pages_allocated);
+}
+
+static void zs_compact_work(struct work_struct *work)
+{
+	struct zs_pool *pool = container_of(to_delayed_work(work),
+				struct zs_pool, compact_work);
+	struct size_class *class;
+	unsigned long pages_freed = 0;
+	unsigned long freed;
+
+	while (zs_pool_fragmented(pool, &class)) {
+		freed = __zs_compact(pool, class, ZS_BG_COMPACT_BATCH);
+		if (!freed)
+			break;
+		pages_freed += freed;
+	}
+	atomic_long_add(pages_freed, &pool->stats.pages_compacted);
+}
+
+static void kick_background_compaction(struct zs_pool *pool)
+{
+	if (!READ_ONCE(bg_compact_frag) ||
+	    delayed_work_pending(&pool->compact_work))
+		return;
+
+	queue_delayed_work(system_unbound_wq, &pool->compact_work,
+			   ZS_BG_COMPACT_DELAY);
+}
+
 void zs_pool_stats(struct zs_pool *pool, struct zs_pool_stats *stats)
 {
 	memcpy(stats, &pool->stats, sizeof(struct zs_pool_stats));
@@ -2467,6 +2638,7 @@ struct zs_pool *zs_create_pool(const char *name)
 		return NULL;
 
 	init_deferred_free(pool);
+	INIT_DELAYED_WORK(&pool->compact_work, zs_compact_work);
 
 	pool->name = kstrdup(name, GFP_KERNEL);
 	if (!pool->name)
@@ -2554,6 +2726,7 @@ void zs_destroy_pool(struct zs_pool *pool)
 	int i;
 
 	zs_unregister_shrinker(pool);
+	cancel_delayed_work_sync(&pool->compact_work);
 	zs_unregister_migration(pool);
 	zs_pool_stat_destroy(pool);
 
@@ -3878,21 +3878,14 @@ static bool skb_flow_limit(struct sk_buff *skb, unsigned int qlen)
 }
 
 /*
- * enqueue_to_backlog is called to queue an skb to a per CPU backlog
- * queue (may be a remote CPU queue).
+ * Queue @skb to the backlog of @sd, called with irqs disabled and the
+ * backlog locked. Returns false if @skb has to be dropped by the caller.
  */
-static int enqueue_to_backlog(struct sk_buff *skb, int cpu,
-			      unsigned int *qtail)
+static bool __enqueue_to_backlog(struct softnet_data *sd, struct sk_buff *skb,
+				 unsigned int *qtail)
 {
-	struct softnet_data *sd;
-	unsigned long flags;
 	unsigned int qlen;
 
-	sd = &per_cpu(softnet_data, cpu);
-
-	local_irq_save(flags);
-
-	rps_lock(sd);
 	if (!netif_running(skb->dev))
 		goto drop;
 	qlen = skb_queue_len(&sd->input_pkt_queue);
@@ -3901,9 +3894,7 @@ static int enqueue_to_backlog(struct sk_buff *skb, int cpu,
 enqueue:
 			__skb_queue_tail(&sd->input_pkt_queue, skb);
 			input_queue_tail_incr_save(sd, qtail);
-			rps_unlock(sd);
-			local_irq_restore(flags);
-			return NET_RX_SUCCESS;
+			return true;
 		}
 
 		/* Schedule NAPI for backlog device
@@ -3918,15 +3909,141 @@ static int enqueue_to_backlog(struct sk_buff *skb, int cpu,
 
 drop:
 	sd->dropped++;
-	rps_unlock(sd);
+	return false;
+}
 
+/*
+ * enqueue_to_backlog is called to queue an skb to a per CPU backlog
+ * queue (may be a remote CPU queue).
+ */
+static int enqueue_to_backlog(struct sk_buff *skb, int cpu,
+			      unsigned int *qtail)
+{
+	struct softnet_data *sd;
+	unsigned long flags;
+	bool queued;
+
+	sd = &per_cpu(softnet_data, cpu);
+
+	local_irq_save(flags);
+	rps_lock(sd);
+	queued = __enqueue_to_backlog(sd, skb, qtail);
+	rps_unlock(sd);
 	local_irq_restore(flags);
 
+	if (queued)
+		return NET_RX_SUCCESS;
+
 	atomic_long_inc(&skb->dev->rx_dropped);
 	kfree_skb(skb);
 	return NET_RX_DROP;
 }
 
+#ifdef CONFIG_RPS
+/*
+ * Packets steered to remote CPUs during one NAPI poll are staged here and
+ * queued to their backlogs together when the poll returns, taking the lock
+ * of each remote backlog once per batch instead of once per packet. The
+ * IPIs are already sent once per net_rx_action() run, see rps_ipi_queued().
+ */
+struct rps_batch {
+	bool		open;
+	unsigned int	len;
+	struct {
+		struct sk_buff	*skb;
+		int		cpu;
+	} ent[NETDEV_RPS_BATCH_MAX];
+};
+
+static DEFINE_PER_CPU(struct rps_batch, rps_batch);
+
+/* Max packets staged per batch, 0 queues every packet on its own */
+unsigned int netdev_rps_batch __read_mostly;
+
+static void rps_batch_flush(struct rps_batch *b)
+{
+	struct softnet_data *mysd = this_cpu_ptr(&softnet_data);
+	unsigned int i, j, n = b->len;
+	unsigned int qtail;
+
+	if (!n)
+		return;
+	b->len = 0;
+
+	for (i = 0; i < n; i++) {
+		struct softnet_data *sd;
+		int cpu = b->ent[i].cpu;
+
+		if (!b->ent[i].skb || cpu < 0)
+			continue;
+
+		sd = &per_cpu(softnet_data, cpu);
+
+		local_irq_disable();
+		rps_lock(sd);
+		for (j = i; j < n; j++) {
+			if (!b->ent[j].skb || b->ent[j].cpu != cpu)
+				continue;
+			if (__enqueue_to_backlog(sd, b->ent[j].skb, &qtail))
+				b->ent[j].skb = NULL;
+			else
+				b->ent[j].cpu = -1;
+		}
+		rps_unlock(sd);
+		local_irq_enable();
+
+		mysd->rps_batch_locks++;
+	}
+
+	/* whatever is left did not fit into its backlog */
+	for (i = 0; i < n; i++) {
+		struct sk_buff *skb = b->ent[i].skb;
+
+		if (skb) {
+			atomic_long_inc(&skb->dev->rx_dropped);
+			kfree_skb(skb);
+		}
+	}
+}
+
+/*
+ * Stage @skb for the backlog of @cpu, only from within a NAPI poll run by
+ * net_rx_action(), which flushes the batch when the poll returns.
+ */
+static bool rps_batch_queue(struct sk_buff *skb, int cpu)
+{
+	unsigned int max = READ_ONCE(netdev_rps_batch);
+	struct rps_batch *b = this_cpu_ptr(&rps_batch);
+
+	if (!max || !b->open || cpu == smp_processor_id())
+		return false;
+
+	b->ent[b->len].skb = skb;
+	b->ent[b->len].cpu = cpu;
+	this_cpu_inc(softnet_data.rps_batched);
+	if (++b->len >= min_t(unsigned int, max, NETDEV_RPS_BATCH_MAX))
+		rps_batch_flush(b);
+
+	return true;
+}
+
+static inline void rps_batch_open(void)
+{
+	this_cpu_write(rps_batch.open, true);
+}
+
+static inline void rps_batch_close(void)
+{
+	struct rps_batch *b = this_cpu_ptr(&rps_batch);
+
+	b->open = false;
+	rps_batch_flush(b);
+}
+#else
+static inline void rps_batch_open(void) { }
+static inline void rps_batch_close(void) { }
+#endif /* CONFIG_RPS */
+
 static struct netdev_rx_queue *netif_get_rxqueue(struct sk_buff *skb)
 {
 	struct net_device *dev = skb->dev;
@@ -4664,7 +4781,12 @@ static int netif_receive_skb_internal(struct sk_buff *skb)
 		int cpu = get_rps_cpu(skb->dev, skb, &rflow);
 
 		if (cpu >= 0) {
-			ret = enqueue_to_backlog(skb, cpu, &rflow->last_qtail);
+			/* RFS needs the exact queue tail of every skb */
+			if (rflow == &voidflow && rps_batch_queue(skb, cpu))
+				ret = NET_RX_SUCCESS;
+			else
+				ret = enqueue_to_backlog(skb, cpu,
+							 &rflow->last_qtail);
 			rcu_read_unlock();
 			return ret;
 		}
@@ -5780,7 +5902,9 @@ static __latent_entropy void net_rx_action(struct softirq_action *h)
 		}
 
 		n = list_first_entry(&list, struct napi_struct, poll_list);
+		rps_batch_open();
 		budget -= napi_poll(n, &repoll);
+		rps_batch_close();
 
 		/* If softirq window is exhausted then punt.
 		 * Allow this to run for 2 jiffies since which will allow
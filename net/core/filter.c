@@ -63,6 +63,7 @@
 #include <net/inet_hashtables.h>
 #include <net/inet6_hashtables.h>
 #include <net/bpf_sk_storage.h>
+#include <net/uid_traffic.h>
 
 /**
  *	sk_filter_trim_cap - run a packet through a socket filter
@@ -112,6 +113,9 @@ int sk_filter_trim_cap(struct sock *sk, struct sk_buff *skb, unsigned int cap)
 	}
 	rcu_read_unlock();
 
+	if (!err)
+		uid_traffic_rx(sk, skb);
+
 	return err;
 }
 EXPORT_SYMBOL(sk_filter_trim_cap);
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * page_pool.c - recycling of DMA mapped RX pages
+ *
+ * Pages given back with page_pool_put_page() are parked in a ring,
+ * oldest first. Allocation takes the oldest one once its reference
+ * count fell back to the single reference of the pool, meaning every
+ * skb using it was freed. A page still in use is rotated to the end of
+ * the ring so a long lived skb cannot stall the others.
+ */
+#include <linux/kernel.h>
+#include <linux/export.h>
+#include <linux/slab.h>
+#include <linux/log2.h>
+#include <linux/page_ref.h>
+#include <net/page_pool.h>
+
+struct page_pool *page_pool_create(const struct page_pool_params *params)
+{
+	struct page_pool *pool;
+	unsigned int size;
+
+	if (!params->pool_size || params->pool_size > 32768)
+		return ERR_PTR(-E2BIG);
+
+	if ((params->flags & PP_FLAG_DMA_MAP) &&
+	    (!params->dev || (params->dma_dir != DMA_FROM_DEVICE &&
+			      params->dma_dir != DMA_BIDIRECTIONAL)))
+		return ERR_PTR(-EINVAL);
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return ERR_PTR(-ENOMEM);
+
+	/* one free slot tells a full ring from an empty one */
+	size = roundup_pow_of_two(params->pool_size + 1);
+	pool->ring = kcalloc(size, sizeof(*pool->ring), GFP_KERNEL);
+	if (!pool->ring) {
+		kfree(pool);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	pool->p = *params;
+	pool->ring_mask = size - 1;
+	spin_lock_init(&pool->ring_lock);
+
+	return pool;
+}
+EXPORT_SYMBOL(page_pool_create);
+
+static void page_pool_release_page(struct page_pool *pool, struct page *page)
+{
+	if (pool->p.flags & PP_FLAG_DMA_MAP) {
+		/* The stack may still read the page, the CPU side was
+		 * synced when the driver received it.
+		 */
+		dma_unmap_page_attrs(pool->p.dev,
+				     page_pool_get_dma_addr(page),
+				     page_pool_buf_size(pool), pool->p.dma_dir,
+				     DMA_ATTR_SKIP_CPU_SYNC);
+		set_page_private(page, 0);
+	}
+	put_page(page);
+}
+
+static struct page *page_pool_alloc_pages_slow(struct page_pool *pool,
+					       gfp_t gfp)
+{
+	struct page *page;
+	dma_addr_t dma;
+
+	if (pool->p.order)
+		gfp |= __GFP_COMP;
+
+	page = alloc_pages_node(dev_to_node(pool->p.dev), gfp, pool->p.order);
+	if (!page)
+		return NULL;
+
+	if (pool->p.flags & PP_FLAG_DMA_MAP) {
+		dma = dma_map_page(pool->p.dev, page, 0,
+				   page_pool_buf_size(pool), pool->p.dma_dir);
+		if (dma_mapping_error(pool->p.dev, dma)) {
+			put_page(page);
+			return NULL;
+		}
+		set_page_private(page, (unsigned long)dma);
+	}
+
+	pool->stats.alloc_slow++;
+	return page;
+}
+
+/**
+ * page_pool_alloc_pages() - get a page ready to be given to the device
+ * @pool: pool to allocate from
+ * @gfp: allocation flags used when the ring has no free page
+ *
+ * Recycled pages are synced for the device again, their DMA mapping
+ * is the one created when the page first came from the page allocator.
+ */
+struct page *page_pool_alloc_pages(struct page_pool *pool, gfp_t gfp)
+{
+	struct page *page = NULL;
+
+	spin_lock_bh(&pool->ring_lock);
+	if (pool->head != pool->tail) {
+		page = pool->ring[pool->head];
+		pool->head = (pool->head + 1) & pool->ring_mask;
+
+		if (page_ref_count(page) != 1) {
+			/* still in use, retry it after the others */
+			pool->ring[pool->tail] = page;
+			pool->tail = (pool->tail + 1) & pool->ring_mask;
+			pool->stats.recycle_busy++;
+			page = NULL;
+		} else {
+			pool->stats.alloc_fast++;
+		}
+	}
+	spin_unlock_bh(&pool->ring_lock);
+
+	if (!page)
+		return page_pool_alloc_pages_slow(pool, gfp);
+
+	if (pool->p.flags & PP_FLAG_DMA_MAP)
+		dma_sync_single_for_device(pool->p.dev,
+					   page_pool_get_dma_addr(page),
+					   page_pool_buf_size(pool),
+					   pool->p.dma_dir);
+	return page;
+}
+EXPORT_SYMBOL(page_pool_alloc_pages);
+
+/**
+ * page_pool_put_page() - give a page back to its pool
+ * @pool: pool the page was allocated from
+ * @page: the page
+ *
+ * The reference of the caller becomes the reference of the pool. Any
+ * other reference, like the ones of skbs using the page as a frag, may
+ * still be around, the page is only handed out again once they are
+ * dropped.
+ */
+void page_pool_put_page(struct page_pool *pool, struct page *page)
+{
+	unsigned int next;
+
+	spin_lock_bh(&pool->ring_lock);
+	next = (pool->tail + 1) & pool->ring_mask;
+	if (next != pool->head) {
+		pool->ring[pool->tail] = page;
+		pool->tail = next;
+		page = NULL;
+	} else {
+		pool->stats.ring_full++;
+	}
+	spin_unlock_bh(&pool->ring_lock);
+
+	if (page)
+		page_pool_release_page(pool, page);
+}
+EXPORT_SYMBOL(page_pool_put_page);
+
+/**
+ * page_pool_destroy() - release every page parked in @pool and free it
+ * @pool: pool to destroy
+ *
+ * Pages the device still owns must have been put back before. Pages
+ * the stack still uses are freed when their last skb is.
+ */
+void page_pool_destroy(struct page_pool *pool)
+{
+	if (IS_ERR_OR_NULL(pool))
+		return;
+
+	while (pool->head != pool->tail) {
+		page_pool_release_page(pool, pool->ring[pool->head]);
+		pool->head = (pool->head + 1) & pool->ring_mask;
+	}
+
+	kfree(pool->ring);
+	kfree(pool);
+}
+EXPORT_SYMBOL(page_pool_destroy);
@@ -13,6 +13,7 @@
 
 #include <linux/inet_diag.h>
 #include <linux/sock_diag.h>
+#include <net/uid_traffic.h>
 
 static const struct sock_diag_handler *sock_diag_handlers[AF_MAX];
 static int (*inet_rcv_compat)(struct sk_buff *skb, struct nlmsghdr *nlh);
@@ -259,6 +260,8 @@ static int sock_diag_rcv_msg(struct sk_buff *skb, struct nlmsghdr *nlh,
 	case SOCK_DIAG_BY_FAMILY:
 	case SOCK_DESTROY:
 		return __sock_diag_cmd(skb, nlh);
+	case SOCK_DIAG_UID_STATS:
+		return uid_traffic_rcv_msg(skb, nlh);
 	default:
 		return -EINVAL;
 	}
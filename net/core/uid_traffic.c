@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Per-UID socket traffic counters.
+ *
+ * Every local socket's traffic is added to a per-cpu counter set of
+ * the socket owner's UID at the point where the cgroup BPF ingress and
+ * egress programs run. Counters are only summed when user space dumps
+ * them over NETLINK_SOCK_DIAG with SOCK_DIAG_UID_STATS, which by
+ * default returns what each UID did since the previous dump, so a
+ * poller never has to walk the socket tables.
+ */
+
+#include <linux/hashtable.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/sock_diag.h>
+#include <net/netlink.h>
+#include <net/uid_traffic.h>
+
+#define UID_TRAFFIC_HASH_BITS 8
+
+struct uid_traffic_counters {
+	u64 rx_bytes;
+	u64 rx_packets;
+	u64 tx_bytes;
+	u64 tx_packets;
+};
+
+struct uid_traffic_entry {
+	struct hlist_node node;
+	kuid_t uid;
+	struct uid_traffic_counters __percpu *pcpu;
+	/* totals reported by the last delta dump */
+	struct uid_traffic_counters last;
+};
+
+/* Entries are never freed, UIDs are a small and stable set */
+static DEFINE_HASHTABLE(uid_traffic_ht, UID_TRAFFIC_HASH_BITS);
+/* protects insertions and the delta base of every entry */
+static DEFINE_SPINLOCK(uid_traffic_lock);
+
+static struct uid_traffic_entry *uid_traffic_find(kuid_t uid)
+{
+	struct uid_traffic_entry *e;
+
+	hash_for_each_possible_rcu(uid_traffic_ht, e, node, __kuid_val(uid))
+		if (uid_eq(e->uid, uid))
+			return e;
+
+	return NULL;
+}
+
+static struct uid_traffic_entry *uid_traffic_create(kuid_t uid)
+{
+	struct uid_traffic_entry *e;
+
+	spin_lock_bh(&uid_traffic_lock);
+	e = uid_traffic_find(uid);
+	if (e)
+		goto out;
+
+	e = kzalloc(sizeof(*e), GFP_ATOMIC);
+	if (!e)
+		goto out;
+
+	e->pcpu = alloc_percpu_gfp(struct uid_traffic_counters, GFP_ATOMIC);
+	if (!e->pcpu) {
+		kfree(e);
+		e = NULL;
+		goto out;
+	}
+
+	e->uid = uid;
+	hash_add_rcu(uid_traffic_ht, &e->node, __kuid_val(uid));
+out:
+	spin_unlock_bh(&uid_traffic_lock);
+	return e;
+}
+
+void __uid_traffic_account(struct sock *sk, const struct sk_buff *skb,
+			   bool tx)
+{
+	struct uid_traffic_entry *e;
+	u32 segs = 1;
+
+	sk = sk_to_full_sk(sk);
+	if (!sk || !sk_fullsock(sk))
+		return;
+
+	if (skb_is_gso(skb))
+		segs = max_t(u16, 1, skb_shinfo(skb)->gso_segs);
+
+	rcu_read_lock();
+	e = uid_traffic_find(sk->sk_uid);
+	if (unlikely(!e))
+		e = uid_traffic_create(sk->sk_uid);
+	if (likely(e)) {
+		if (tx) {
+			this_cpu_add(e->pcpu->tx_bytes, skb->len);
+			this_cpu_add(e->pcpu->tx_packets, segs);
+		} else {
+			this_cpu_add(e->pcpu->rx_bytes, skb->len);
+			this_cpu_add(e->pcpu->rx_packets, segs);
+		}
+	}
+	rcu_read_unlock();
+}
+
+static void uid_traffic_sum(const struct uid_traffic_entry *e,
+			    struct uid_traffic_counters *sum)
+{
+	int cpu;
+
+	memset(sum, 0, sizeof(*sum));
+	for_each_possible_cpu(cpu) {
+		const struct uid_traffic_counters *c = per_cpu_ptr(e->pcpu, cpu);
+
+		sum->rx_bytes += READ_ONCE(c->rx_bytes);
+		sum->rx_packets += READ_ONCE(c->rx_packets);
+		sum->tx_bytes += READ_ONCE(c->tx_bytes);
+		sum->tx_packets += READ_ONCE(c->tx_packets);
+	}
+}
+
+static int uid_traffic_fill(struct sk_buff *skb, struct netlink_callback *cb,
+			    struct uid_traffic_entry *e, bool totals)
+{
+	struct uid_traffic_counters sum, base = {};
+	struct uid_traffic_msg *m;
+	struct nlmsghdr *nlh;
+
+	uid_traffic_sum(e, &sum);
+
+	spin_lock_bh(&uid_traffic_lock);
+	if (!totals) {
+		base = e->last;
+		if (sum.rx_packets == base.rx_packets &&
+		    sum.tx_packets == base.tx_packets) {
+			spin_unlock_bh(&uid_traffic_lock);
+			return 0;
+		}
+	}
+
+	nlh = nlmsg_put(skb, NETLINK_CB(cb->skb).portid, cb->nlh->nlmsg_seq,
+			SOCK_DIAG_UID_STATS, sizeof(*m), NLM_F_MULTI);
+	if (!nlh) {
+		spin_unlock_bh(&uid_traffic_lock);
+		return -EMSGSIZE;
+	}
+
+	if (!totals)
+		e->last = sum;
+	spin_unlock_bh(&uid_traffic_lock);
+
+	m = nlmsg_data(nlh);
+	m->uid = from_kuid_munged(&init_user_ns, e->uid);
+	m->pad = 0;
+	m->rx_bytes = sum.rx_bytes - base.rx_bytes;
+	m->rx_packets = sum.rx_packets - base.rx_packets;
+	m->tx_bytes = sum.tx_bytes - base.tx_bytes;
+	m->tx_packets = sum.tx_packets - base.tx_packets;
+	nlmsg_end(skb, nlh);
+	return 0;
+}
+
+static int uid_traffic_dump(struct sk_buff *skb, struct netlink_callback *cb)
+{
+	const struct uid_traffic_req *req = nlmsg_data(cb->nlh);
+	bool totals = req->flags & UID_TRAFFIC_F_TOTALS;
+	int bucket, idx, s_idx = cb->args[1];
+	struct uid_traffic_entry *e;
+
+	for (bucket = cb->args[0]; bucket < HASH_SIZE(uid_traffic_ht);
+	     bucket++, s_idx = 0) {
+		idx = 0;
+		rcu_read_lock();
+		hlist_for_each_entry_rcu(e, &uid_traffic_ht[bucket], node) {
+			if (idx++ < s_idx)
+				continue;
+			if (uid_traffic_fill(skb, cb, e, totals) < 0) {
+				rcu_read_unlock();
+				cb->args[0] = bucket;
+				cb->args[1] = idx - 1;
+				return skb->len;
+			}
+		}
+		rcu_read_unlock();
+	}
+
+	cb->args[0] = bucket;
+	cb->args[1] = 0;
+	return skb->len;
+}
+
+int uid_traffic_rcv_msg(struct sk_buff *skb, struct nlmsghdr *nlh)
+{
+	struct net *net = sock_net(skb->sk);
+	struct netlink_dump_control c = {
+		.dump = uid_traffic_dump,
+	};
+
+	if (nlmsg_len(nlh) < sizeof(struct uid_traffic_req))
+		return -EINVAL;
+
+	if (!(nlh->nlmsg_flags & NLM_F_DUMP))
+		return -EINVAL;
+
+	/* Counters are global, keep them out of other namespaces */
+	if (!net_eq(net, &init_net))
+		return -EOPNOTSUPP;
+
+	if (!netlink_net_capable(skb, CAP_NET_ADMIN))
+		return -EPERM;
+
+	return netlink_dump_start(net->diag_nlsk, skb, nlh, &c);
+}
@@ -75,6 +75,7 @@
 #include <net/inetpeer.h>
 #include <net/inet_ecn.h>
 #include <net/lwtunnel.h>
+#include <net/uid_traffic.h>
 #include <linux/bpf-cgroup.h>
 #include <linux/igmp.h>
 #include <linux/netfilter_ipv4.h>
@@ -308,6 +309,8 @@ static int ip_finish_output(struct net *net, struct sock *sk, struct sk_buff *sk
 		return ret;
 	}
 
+	uid_traffic_tx(sk, skb);
+
 #if defined(CONFIG_NETFILTER) && defined(CONFIG_XFRM)
 	/* Policy lookup after SNAT yielded a new policy */
 	if (skb_dst(skb)->xfrm) {
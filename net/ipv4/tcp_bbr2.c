@@ -0,0 +1,1203 @@
+/* BBR v2 (Bottleneck Bandwidth and RTT) congestion control
+ *
+ * BBR v2 keeps the model based design of BBR v1 (see tcp_bbr.c): it paces
+ * at the estimated bottleneck bandwidth and sizes the flight from the
+ * estimated BDP. On top of that it uses packet loss and ECN marks as
+ * explicit signals that the path can't hold more data, which keeps the
+ * retransmit rate bounded on shallow buffered paths such as cellular links
+ * where v1 tends to overshoot.
+ *
+ * The model is bounded from two sides:
+ *
+ *   bw_hi, inflight_hi: the highest bandwidth and volume of data in flight
+ *      that were found to be safe. inflight_hi is cut when a bandwidth probe
+ *      sees more than bbr2_loss_thresh loss, or more than bbr2_ecn_thresh of
+ *      the data delivered in a round carrying an ECN mark.
+ *
+ *   bw_lo, inflight_lo: short term lower bounds, cut by bbr2_beta on every
+ *      round trip that sees loss or ECN while not probing, and reset when
+ *      the next probe starts.
+ *
+ * PROBE_BW is split into four phases:
+ *
+ *      DOWN  ---->  CRUISE  ---->  REFILL  ---->  UP
+ *       ^                                          |
+ *       +------------------------------------------+
+ *
+ * DOWN drains the queue a probe may have built, CRUISE paces at the
+ * estimated bw with some headroom below inflight_hi, REFILL spends a round
+ * refilling the pipe without the lower bounds and UP probes with a gain of
+ * 1.25, growing inflight_hi exponentially per round until the path pushes
+ * back. Probes are spaced out in wall clock time (2-3 seconds), or after as
+ * many rounds as a Reno flow would need to grow a BDP, whichever is first.
+ *
+ * Loss and ECN are accounted per round trip, as a fraction of the data
+ * delivered in that round. ECN is only acted on when the connection
+ * negotiated it, which can be enabled per route with "features ecn" the
+ * same way this module can be selected per route with "congctl bbr2".
+ *
+ * BBR v2 is described in the IETF ICCRG presentations by Neal Cardwell,
+ * Yuchung Cheng et al. (IETF 104 and 105, 2019).
+ */
+#include <linux/module.h>
+#include <net/tcp.h>
+#include <linux/inet_diag.h>
+#include <linux/inet.h>
+#include <linux/random.h>
+
+#define BW_SCALE 24
+#define BW_UNIT (1 << BW_SCALE)
+
+#define BBR_SCALE 8	/* scaling factor for fractions in BBR (e.g. gains) */
+#define BBR_UNIT (1 << BBR_SCALE)
+
+enum bbr2_mode {
+	BBR_STARTUP,	/* ramp up sending rate rapidly to fill pipe */
+	BBR_DRAIN,	/* drain any queue created during startup */
+	BBR_PROBE_BW,	/* discover, share bw: pace around estimated bw */
+	BBR_PROBE_RTT,	/* cut inflight to min to probe min_rtt */
+};
+
+/* Phases of the PROBE_BW cycle */
+enum bbr2_pacing_gain_phase {
+	BBR_BW_PROBE_UP,	/* push up inflight to probe for bw/vol */
+	BBR_BW_PROBE_DOWN,	/* drain excess inflight from the queue */
+	BBR_BW_PROBE_CRUISE,	/* use pipe, w/ headroom in queue/pipe */
+	BBR_BW_PROBE_REFILL,	/* v2: refill the pipe again to 100% */
+};
+
+struct bbr2 {
+	u64	cycle_mstamp;	     /* start of this probe or down phase */
+	u32	min_rtt_us;	     /* min RTT in min_rtt_win_sec window */
+	u32	min_rtt_stamp;	     /* timestamp of min_rtt_us */
+	u32	probe_rtt_done_stamp;   /* end time for BBR_PROBE_RTT mode */
+	u32	next_rtt_delivered;  /* tp->delivered at end of round */
+	u32	mode:2,		     /* current bbr2_mode in state machine */
+		prev_ca_state:3,     /* CA state on previous ACK */
+		packet_conservation:1,  /* use packet conservation? */
+		restore_cwnd:1,	     /* decided to revert cwnd to old value */
+		round_start:1,	     /* start of packet-timed tx->ack round? */
+		tso_segs_goal:7,     /* segments we want in each skb we send */
+		idle_restart:1,	     /* restarting after idle? */
+		probe_rtt_round_done:1,  /* a BBR_PROBE_RTT round done? */
+		full_bw_reached:1,   /* reached full bw in Startup? */
+		full_bw_cnt:2,	     /* rounds without large bw gains */
+		has_seen_rtt:1,	     /* have we seen an RTT sample yet? */
+		loss_round_start:1,  /* loss_round_delivered round trip? */
+		loss_in_round:1,     /* saw loss in this loss round? */
+		ecn_in_round:1,	     /* saw ECN in this loss round? */
+		ece_ack:1,	     /* current ACK has ECE set? */
+		startup_ecn_rounds:2,   /* rounds in startup with high ECN */
+		cycle_idx:2,	     /* current bbr2_pacing_gain_phase */
+		prev_probe_too_high:1,  /* did last probe see loss/ECN? */
+		stopped_risky_probe:1,  /* last probe stopped at inflight_hi? */
+		bw_probe_samples:1;  /* rate samples reflect bw probing? */
+	u32	pacing_gain:10,	     /* current gain for setting pacing rate */
+		cwnd_gain:10,	     /* current gain for setting cwnd */
+		rounds_since_probe:8,   /* packet-timed rounds since probed bw */
+		bw_probe_up_rounds:4;   /* cwnd-limited rounds in PROBE_UP */
+	u32	prior_cwnd;	     /* prior cwnd upon entering loss recovery */
+	u32	full_bw;	     /* recent bw, to estimate if pipe is full */
+	u32	bw_hi[2];	     /* max bw sampled in last/current cycle */
+	u32	bw_lo;		     /* lower bound on bw while not probing */
+	u32	inflight_lo;	     /* lower bound on inflight while not probing */
+	u32	inflight_hi;	     /* upper bound on inflight */
+	u32	bw_latest;	     /* max bw sampled in this loss round */
+	u32	inflight_latest;     /* max delivered in this loss round */
+	u32	loss_round_delivered;   /* tp->delivered at loss round start */
+	u32	loss_round_lost;     /* tp->lost at loss round start */
+	u32	ce_in_round;	     /* packets delivered w/ ECE in loss round */
+	u32	ecn_alpha;	     /* EWMA of the per round ECN mark ratio */
+	u32	probe_wait_us;	     /* PROBE_DOWN until next clock-driven probe */
+	u32	bw_probe_up_cnt;     /* packets delivered per inflight_hi incr */
+	u32	bw_probe_up_acks;    /* packets (S)ACKed since inflight_hi incr */
+};
+
+/* Window length of min_rtt filter (in sec): */
+static const u32 bbr2_min_rtt_win_sec = 10;
+/* Re-probe min_rtt if it hasn't been seen for this long (in sec): */
+static const u32 bbr2_probe_rtt_win_sec = 5;
+/* Minimum time (in ms) spent at the PROBE_RTT cwnd: */
+static const u32 bbr2_probe_rtt_mode_ms = 200;
+/* Cwnd in PROBE_RTT as a fraction of the estimated BDP: */
+static const u32 bbr2_probe_rtt_cwnd_gain = BBR_UNIT * 1 / 2;
+/* Skip TSO below the following bandwidth (bits/sec): */
+static const int bbr2_min_tso_rate = 1200000;
+
+static const int bbr2_high_gain  = BBR_UNIT * 2885 / 1000 + 1;
+static const int bbr2_drain_gain = BBR_UNIT * 1000 / 2885;
+static const int bbr2_cwnd_gain  = BBR_UNIT * 2;
+/* The pacing_gain values of the PROBE_BW phases, by bbr2_pacing_gain_phase */
+static const int bbr2_pacing_gain[] = {
+	BBR_UNIT * 5 / 4,	/* UP: probe for more available bw */
+	BBR_UNIT * 3 / 4,	/* DOWN: drain queue and/or yield bw */
+	BBR_UNIT,		/* CRUISE: try to use pipe w/ some headroom */
+	BBR_UNIT,		/* REFILL: refill pipe to estimated 100% */
+};
+
+static const u32 bbr2_cwnd_min_target = 4;
+
+static const u32 bbr2_full_bw_thresh = BBR_UNIT * 5 / 4;
+static const u32 bbr2_full_bw_cnt = 3;
+/* Exit STARTUP after this many lost packets in a round over loss_thresh: */
+static const u32 bbr2_full_loss_cnt = 8;
+/* Exit STARTUP after this many rounds with ECN over ecn_thresh: */
+static const u32 bbr2_full_ecn_cnt = 2;
+
+/* Keep this much of inflight_hi free while cruising: */
+static const u32 bbr2_inflight_headroom = BBR_UNIT * 15 / 100;
+/* Wall clock time between bw probes is base + [0, rand) usec: */
+static const u32 bbr2_bw_probe_base_us = 2 * USEC_PER_SEC;
+static const u32 bbr2_bw_probe_rand_us = 1 * USEC_PER_SEC;
+/* Probe at least this often in round trips, for Reno/CUBIC coexistence: */
+static const u32 bbr2_bw_probe_max_rounds = 63;
+/* Gain used to exit PROBE_UP once inflight reaches that many BDPs: */
+static const u32 bbr2_bw_probe_pif_gain = BBR_UNIT * 5 / 4;
+/* EWMA gain of ecn_alpha, as a shift: */
+static const u32 bbr2_ecn_alpha_shift = 4;
+
+/* Fraction of a round's delivered data that may be lost while probing. */
+static u32 bbr2_loss_thresh __read_mostly = BBR_UNIT * 2 / 100;
+module_param_named(loss_thresh, bbr2_loss_thresh, uint, 0644);
+MODULE_PARM_DESC(loss_thresh, "probe loss tolerance, in 1/256");
+
+/* Multiplicative cut of the lower bounds per lossy round. */
+static u32 bbr2_beta __read_mostly = BBR_UNIT * 30 / 100;
+module_param_named(beta, bbr2_beta, uint, 0644);
+MODULE_PARM_DESC(beta, "lower bound cut per lossy round, in 1/256");
+
+/* React to ECN marks on connections that negotiated ECN. */
+static bool bbr2_ecn_enable __read_mostly = true;
+module_param_named(ecn_enable, bbr2_ecn_enable, bool, 0644);
+MODULE_PARM_DESC(ecn_enable, "use ECN marks as a congestion signal");
+
+/* Fraction of a round's delivered data that may carry an ECN mark. */
+static u32 bbr2_ecn_thresh __read_mostly = BBR_UNIT * 1 / 2;
+module_param_named(ecn_thresh, bbr2_ecn_thresh, uint, 0644);
+MODULE_PARM_DESC(ecn_thresh, "ECN mark tolerance, in 1/256");
+
+/* Scale of the ECN driven cut of the lower bounds relative to ecn_alpha. */
+static u32 bbr2_ecn_factor __read_mostly = BBR_UNIT * 1 / 3;
+module_param_named(ecn_factor, bbr2_ecn_factor, uint, 0644);
+MODULE_PARM_DESC(ecn_factor, "lower bound cut per ecn_alpha, in 1/256");
+
+static bool bbr2_full_bw_reached(const struct sock *sk)
+{
+	const struct bbr2 *bbr = inet_csk_ca(sk);
+
+	return bbr->full_bw_reached;
+}
+
+static bool bbr2_ecn_eligible(const struct sock *sk)
+{
+	return bbr2_ecn_enable && (tcp_sk(sk)->ecn_flags & TCP_ECN_OK);
+}
+
+/* Return the windowed max recent bandwidth sample, in pkts/uS << BW_SCALE. */
+static u32 bbr2_max_bw(const struct sock *sk)
+{
+	const struct bbr2 *bbr = inet_csk_ca(sk);
+
+	return max(bbr->bw_hi[0], bbr->bw_hi[1]);
+}
+
+/* Return the estimated bandwidth of the path, in pkts/uS << BW_SCALE. */
+static u32 bbr2_bw(const struct sock *sk)
+{
+	const struct bbr2 *bbr = inet_csk_ca(sk);
+
+	return min(bbr2_max_bw(sk), bbr->bw_lo);
+}
+
+static u64 bbr2_rate_bytes_per_sec(struct sock *sk, u64 rate, int gain)
+{
+	rate *= tcp_mss_to_mtu(sk, tcp_sk(sk)->mss_cache);
+	rate *= gain;
+	rate >>= BBR_SCALE;
+	rate *= USEC_PER_SEC;
+	return rate >> BW_SCALE;
+}
+
+static u32 bbr2_bw_to_pacing_rate(struct sock *sk, u32 bw, int gain)
+{
+	u64 rate = bw;
+
+	rate = bbr2_rate_bytes_per_sec(sk, rate, gain);
+	rate = min_t(u64, rate, sk->sk_max_pacing_rate);
+	return rate;
+}
+
+static void bbr2_init_pacing_rate_from_rtt(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u64 bw;
+	u32 rtt_us;
+
+	if (tp->srtt_us) {		/* any RTT sample yet? */
+		rtt_us = max(tp->srtt_us >> 3, 1U);
+		bbr->has_seen_rtt = 1;
+	} else {			 /* no RTT sample yet */
+		rtt_us = USEC_PER_MSEC;	 /* use nominal default RTT */
+	}
+	bw = (u64)tp->snd_cwnd * BW_UNIT;
+	do_div(bw, rtt_us);
+	sk->sk_pacing_rate = bbr2_bw_to_pacing_rate(sk, bw, bbr2_high_gain);
+}
+
+static void bbr2_set_pacing_rate(struct sock *sk, u32 bw, int gain)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 rate = bbr2_bw_to_pacing_rate(sk, bw, gain);
+
+	if (unlikely(!bbr->has_seen_rtt && tp->srtt_us))
+		bbr2_init_pacing_rate_from_rtt(sk);
+	if (bbr2_full_bw_reached(sk) || rate > sk->sk_pacing_rate)
+		sk->sk_pacing_rate = rate;
+}
+
+static u32 bbr2_tso_segs_goal(struct sock *sk)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	return bbr->tso_segs_goal;
+}
+
+static void bbr2_set_tso_segs_goal(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 min_segs;
+
+	min_segs = sk->sk_pacing_rate < (bbr2_min_tso_rate >> 3) ? 1 : 2;
+	bbr->tso_segs_goal = min(tcp_tso_autosize(sk, tp->mss_cache, min_segs),
+				 0x7FU);
+}
+
+static void bbr2_save_cwnd(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	if (bbr->prev_ca_state < TCP_CA_Recovery && bbr->mode != BBR_PROBE_RTT)
+		bbr->prior_cwnd = tp->snd_cwnd;  /* this cwnd is good enough */
+	else  /* loss recovery or BBR_PROBE_RTT have temporarily cut cwnd */
+		bbr->prior_cwnd = max(bbr->prior_cwnd, tp->snd_cwnd);
+}
+
+static void bbr2_cwnd_event(struct sock *sk, enum tcp_ca_event event)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	if (event == CA_EVENT_TX_START && tp->app_limited) {
+		bbr->idle_restart = 1;
+		if (bbr->mode == BBR_PROBE_BW)
+			bbr2_set_pacing_rate(sk, bbr2_bw(sk), BBR_UNIT);
+	}
+}
+
+static void bbr2_in_ack_event(struct sock *sk, u32 flags)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	bbr->ece_ack = !!(flags & CA_ACK_ECE);
+}
+
+/* Estimated BDP in packets for the given bw and gain, without any headroom
+ * for the end hosts.
+ */
+static u32 bbr2_bdp(struct sock *sk, u32 bw, int gain)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u64 w;
+
+	if (unlikely(bbr->min_rtt_us == ~0U))	 /* no valid RTT samples yet? */
+		return TCP_INIT_CWND;  /* be safe: cap at default initial cwnd*/
+
+	w = (u64)bw * bbr->min_rtt_us;
+
+	/* Apply a gain to the given value, then remove the BW_SCALE shift. */
+	return (((w * gain) >> BBR_SCALE) + BW_UNIT - 1) / BW_UNIT;
+}
+
+/* Budget for full sized skbs in the end host pipelines, as in BBR v1. */
+static u32 bbr2_quantization_budget(struct sock *sk, u32 cwnd)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	cwnd += 3 * bbr->tso_segs_goal;
+
+	/* Reduce delayed ACKs by rounding up cwnd to the next even number. */
+	cwnd = (cwnd + 1) & ~1U;
+
+	/* Ensure gain cycling gets inflight above BDP even for small BDPs. */
+	if (bbr->mode == BBR_PROBE_BW && bbr->cycle_idx == BBR_BW_PROBE_UP)
+		cwnd += 2;
+
+	return cwnd;
+}
+
+static u32 bbr2_inflight(struct sock *sk, u32 bw, int gain)
+{
+	return bbr2_quantization_budget(sk, bbr2_bdp(sk, bw, gain));
+}
+
+/* The volume of data we aim to keep in flight when not probing. */
+static u32 bbr2_target_inflight(struct sock *sk)
+{
+	u32 bdp = bbr2_inflight(sk, bbr2_bw(sk), BBR_UNIT);
+
+	return min(bdp, tcp_sk(sk)->snd_cwnd);
+}
+
+/* inflight_hi minus some headroom, so flows that cruise leave some space
+ * for new flows to ramp up.
+ */
+static u32 bbr2_inflight_with_headroom(const struct sock *sk)
+{
+	const struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 headroom, headroom_fraction;
+
+	if (bbr->inflight_hi == ~0U)
+		return ~0U;
+
+	headroom_fraction = bbr2_inflight_headroom;
+	headroom = ((u64)bbr->inflight_hi * headroom_fraction) >> BBR_SCALE;
+	headroom = max(headroom, 1U);
+	return max_t(s32, bbr->inflight_hi - headroom, bbr2_cwnd_min_target);
+}
+
+static u32 bbr2_tx_in_flight(const struct sock *sk,
+			     const struct rate_sample *rs)
+{
+	return DIV_ROUND_UP(rs->tx_in_flight, tcp_sk(sk)->mss_cache);
+}
+
+static bool bbr2_is_probing_bandwidth(struct sock *sk)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	return bbr->mode == BBR_STARTUP ||
+	       (bbr->mode == BBR_PROBE_BW &&
+		(bbr->cycle_idx == BBR_BW_PROBE_REFILL ||
+		 bbr->cycle_idx == BBR_BW_PROBE_UP));
+}
+
+/* Same loss recovery behaviour as BBR v1: packet conservation in the first
+ * round of recovery, then restoring the cwnd saved before it.
+ */
+static bool bbr2_set_cwnd_to_recover_or_restore(
+	struct sock *sk, const struct rate_sample *rs, u32 acked, u32 *new_cwnd)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u8 prev_state = bbr->prev_ca_state, state = inet_csk(sk)->icsk_ca_state;
+	u32 cwnd = tp->snd_cwnd;
+
+	if (rs->losses > 0)
+		cwnd = max_t(s32, cwnd - rs->losses, 1);
+
+	if (state == TCP_CA_Recovery && prev_state != TCP_CA_Recovery) {
+		/* Starting 1st round of Recovery, so do packet conservation. */
+		bbr->packet_conservation = 1;
+		bbr->next_rtt_delivered = tp->delivered;  /* start round now */
+		/* Cut unused cwnd from app behavior, TSQ, or TSO deferral: */
+		cwnd = tcp_packets_in_flight(tp) + acked;
+	} else if (prev_state >= TCP_CA_Recovery && state < TCP_CA_Recovery) {
+		/* Exiting loss recovery; restore cwnd saved before recovery. */
+		bbr->restore_cwnd = 1;
+		bbr->packet_conservation = 0;
+	}
+	bbr->prev_ca_state = state;
+
+	if (bbr->restore_cwnd) {
+		cwnd = max(cwnd, bbr->prior_cwnd);
+		bbr->restore_cwnd = 0;
+	}
+
+	if (bbr->packet_conservation) {
+		*new_cwnd = max(cwnd, tcp_packets_in_flight(tp) + acked);
+		return true;	/* yes, using packet conservation */
+	}
+	*new_cwnd = cwnd;
+	return false;
+}
+
+/* Cap the cwnd by the inflight bounds of the model that apply right now. */
+static u32 bbr2_bound_cwnd_for_inflight_model(struct sock *sk, u32 cwnd)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 cap = ~0U;
+
+	if (bbr->mode == BBR_PROBE_BW &&
+	    bbr->cycle_idx != BBR_BW_PROBE_CRUISE) {
+		/* Probe safely: stay at or below the known safe volume. */
+		cap = bbr->inflight_hi;
+	} else if (bbr->mode == BBR_PROBE_RTT ||
+		   (bbr->mode == BBR_PROBE_BW &&
+		    bbr->cycle_idx == BBR_BW_PROBE_CRUISE)) {
+		/* Leave headroom for other flows to ramp up. */
+		cap = bbr2_inflight_with_headroom(sk);
+	}
+	/* Adapt to any loss or ECN since our last bw probe. */
+	cap = min(cap, bbr->inflight_lo);
+
+	cap = max(cap, bbr2_cwnd_min_target);
+	return min(cwnd, cap);
+}
+
+static u32 bbr2_probe_rtt_cwnd(struct sock *sk)
+{
+	return max(bbr2_bdp(sk, bbr2_bw(sk), bbr2_probe_rtt_cwnd_gain),
+		   bbr2_cwnd_min_target);
+}
+
+static void bbr2_set_cwnd(struct sock *sk, const struct rate_sample *rs,
+			  u32 acked, u32 bw, int gain)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 cwnd = 0, target_cwnd = 0;
+
+	if (!acked)
+		goto done;
+
+	if (bbr2_set_cwnd_to_recover_or_restore(sk, rs, acked, &cwnd))
+		goto done;
+
+	target_cwnd = bbr2_inflight(sk, bw, gain);
+	if (bbr2_full_bw_reached(sk))  /* only cut cwnd if we filled the pipe */
+		cwnd = min(cwnd + acked, target_cwnd);
+	else if (cwnd < target_cwnd || tp->delivered < TCP_INIT_CWND)
+		cwnd = cwnd + acked;
+	cwnd = max(cwnd, bbr2_cwnd_min_target);
+
+done:
+	if (!cwnd)
+		cwnd = tp->snd_cwnd;
+	cwnd = bbr2_bound_cwnd_for_inflight_model(sk, cwnd);
+	tp->snd_cwnd = min(cwnd, tp->snd_cwnd_clamp);	/* apply global cap */
+	if (bbr->mode == BBR_PROBE_RTT)  /* drain queue, refresh min_rtt */
+		tp->snd_cwnd = min(tp->snd_cwnd, bbr2_probe_rtt_cwnd(sk));
+}
+
+static void bbr2_reset_lower_bounds(struct sock *sk)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	bbr->bw_lo = ~0U;
+	bbr->inflight_lo = ~0U;
+}
+
+static void bbr2_reset_congestion_signals(struct sock *sk)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	bbr->loss_in_round = 0;
+	bbr->ecn_in_round = 0;
+	bbr->ce_in_round = 0;
+	bbr->bw_latest = 0;
+	bbr->inflight_latest = 0;
+}
+
+static void bbr2_set_cycle_idx(struct sock *sk, int cycle_idx)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	bbr->cycle_idx = cycle_idx;
+	bbr->pacing_gain = bbr2_pacing_gain[cycle_idx];
+}
+
+/* Grow inflight_hi by 1, 2, 4, ... packets per round while probing up. */
+static void bbr2_raise_inflight_hi_slope(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 growth_this_round, cnt;
+
+	growth_this_round = 1 << bbr->bw_probe_up_rounds;
+	bbr->bw_probe_up_rounds = min_t(u32, bbr->bw_probe_up_rounds + 1, 15);
+	cnt = tp->snd_cwnd / growth_this_round;
+	bbr->bw_probe_up_cnt = max(cnt, 1U);
+}
+
+static void bbr2_probe_inflight_hi_upward(struct sock *sk,
+					  const struct rate_sample *rs)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 delta;
+
+	if (!tp->is_cwnd_limited || tp->snd_cwnd < bbr->inflight_hi) {
+		bbr->bw_probe_up_acks = 0;  /* don't accumulate unused credits */
+		return;  /* not fully using inflight_hi, so don't grow it */
+	}
+
+	/* For each bw_probe_up_cnt packets ACKed, increase inflight_hi by 1. */
+	bbr->bw_probe_up_acks += rs->acked_sacked;
+	if (bbr->bw_probe_up_acks >= bbr->bw_probe_up_cnt) {
+		delta = bbr->bw_probe_up_acks / bbr->bw_probe_up_cnt;
+		bbr->bw_probe_up_acks -= delta * bbr->bw_probe_up_cnt;
+		bbr->inflight_hi += delta;
+	}
+
+	if (bbr->round_start)
+		bbr2_raise_inflight_hi_slope(sk);
+}
+
+static void bbr2_pick_probe_wait(struct sock *sk)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	/* Decide the random round-trip bound for wait until probe: */
+	bbr->rounds_since_probe = prandom_u32_max(2);
+	/* Decide the random wall clock bound for wait until probe: */
+	bbr->probe_wait_us = bbr2_bw_probe_base_us +
+			     prandom_u32_max(bbr2_bw_probe_rand_us);
+}
+
+static void bbr2_start_bw_probe_down(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	bbr2_reset_congestion_signals(sk);
+	bbr->bw_probe_up_cnt = ~0U;	/* not growing inflight_hi any more */
+	bbr2_pick_probe_wait(sk);
+	bbr->cycle_mstamp = tp->tcp_mstamp;	/* start wall clock */
+	bbr2_set_cycle_idx(sk, BBR_BW_PROBE_DOWN);
+}
+
+static void bbr2_start_bw_probe_cruise(struct sock *sk)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	if (bbr->inflight_lo != ~0U)
+		bbr->inflight_lo = min(bbr->inflight_lo, bbr->inflight_hi);
+
+	bbr2_set_cycle_idx(sk, BBR_BW_PROBE_CRUISE);
+}
+
+/* Loss and ECN seen since the last probe are history once we refill the
+ * pipe; the bw filter also moves on to a new cycle here.
+ */
+static void bbr2_start_bw_probe_refill(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	bbr2_reset_lower_bounds(sk);
+	bbr->bw_hi[0] = bbr->bw_hi[1];
+	bbr->bw_hi[1] = 0;
+	bbr->bw_probe_up_rounds = 0;
+	bbr->bw_probe_up_acks = 0;
+	bbr->stopped_risky_probe = 0;
+	bbr->next_rtt_delivered = tp->delivered;  /* start round now */
+	bbr2_set_cycle_idx(sk, BBR_BW_PROBE_REFILL);
+}
+
+static void bbr2_start_bw_probe_up(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	bbr->next_rtt_delivered = tp->delivered;  /* start round now */
+	bbr->cycle_mstamp = tp->tcp_mstamp;
+	bbr2_set_cycle_idx(sk, BBR_BW_PROBE_UP);
+	bbr2_raise_inflight_hi_slope(sk);
+}
+
+static bool bbr2_has_elapsed_in_phase(const struct sock *sk, u32 interval_us)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+	const struct bbr2 *bbr = inet_csk_ca(sk);
+
+	return tcp_stamp_us_delta(tp->tcp_mstamp,
+				  bbr->cycle_mstamp + interval_us) > 0;
+}
+
+/* A Reno flow would take about a BDP worth of round trips to grow its cwnd
+ * by a BDP, so probe at least that often to stay TCP friendly.
+ */
+static bool bbr2_is_reno_coexistence_probe_time(struct sock *sk)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 rounds;
+
+	rounds = min(bbr2_bw_probe_max_rounds, bbr2_target_inflight(sk));
+	return bbr->rounds_since_probe >= rounds;
+}
+
+static bool bbr2_check_time_to_probe_bw(struct sock *sk)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	if (bbr2_has_elapsed_in_phase(sk, bbr->probe_wait_us) ||
+	    bbr2_is_reno_coexistence_probe_time(sk)) {
+		bbr2_start_bw_probe_refill(sk);
+		return true;
+	}
+	return false;
+}
+
+static bool bbr2_check_time_to_cruise(struct sock *sk, u32 inflight, u32 bw)
+{
+	if (inflight > bbr2_inflight_with_headroom(sk))
+		return false;
+
+	return inflight <= bbr2_inflight(sk, bw, BBR_UNIT);
+}
+
+/* Did this probe put more in flight than the path can hold? Lost packets
+ * are counted over the current loss round and compared with what was in
+ * flight when the sampled packet was sent.
+ */
+static bool bbr2_is_inflight_too_high(struct sock *sk,
+				      const struct rate_sample *rs)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 inflight, lost, delivered;
+
+	inflight = bbr2_tx_in_flight(sk, rs);
+	lost = tp->lost - bbr->loss_round_lost;
+	if (rs->losses && inflight &&
+	    (u64)lost * BBR_UNIT > (u64)inflight * bbr2_loss_thresh)
+		return true;
+
+	delivered = tp->delivered - bbr->loss_round_delivered;
+	if (bbr->ce_in_round && delivered && bbr2_ecn_eligible(sk) &&
+	    (u64)bbr->ce_in_round * BBR_UNIT >
+	    (u64)delivered * bbr2_ecn_thresh)
+		return true;
+
+	return false;
+}
+
+static void bbr2_handle_inflight_too_high(struct sock *sk,
+					  const struct rate_sample *rs)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 target;
+
+	bbr->prev_probe_too_high = 1;
+	bbr->bw_probe_samples = 0;  /* only react once per probe */
+	if (!rs->is_app_limited) {
+		target = ((u64)bbr2_target_inflight(sk) *
+			  (BBR_UNIT - bbr2_beta)) >> BBR_SCALE;
+		bbr->inflight_hi = max(bbr2_tx_in_flight(sk, rs), target);
+	}
+	if (bbr->mode == BBR_PROBE_BW && bbr->cycle_idx == BBR_BW_PROBE_UP)
+		bbr2_start_bw_probe_down(sk);
+}
+
+/* Move inflight_hi down when a probe hits loss or ECN, and up when the
+ * flight it allows is used without trouble. Returns true if a probe was
+ * just ended.
+ */
+static bool bbr2_adapt_upper_bounds(struct sock *sk,
+				    const struct rate_sample *rs)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 inflight;
+
+	if (bbr->bw_probe_samples && bbr2_is_inflight_too_high(sk, rs)) {
+		bbr2_handle_inflight_too_high(sk, rs);
+		return true;
+	}
+
+	if (bbr->inflight_hi == ~0U)
+		return false;
+
+	inflight = bbr2_tx_in_flight(sk, rs);
+	if (inflight > bbr->inflight_hi)
+		bbr->inflight_hi = inflight;
+
+	if (bbr->mode == BBR_PROBE_BW && bbr->cycle_idx == BBR_BW_PROBE_UP)
+		bbr2_probe_inflight_hi_upward(sk, rs);
+
+	return false;
+}
+
+static void bbr2_update_cycle_phase(struct sock *sk,
+				    const struct rate_sample *rs)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 inflight, bw;
+
+	if (!bbr2_full_bw_reached(sk))
+		return;
+
+	if (bbr2_adapt_upper_bounds(sk, rs))
+		return;		/* already decided state transition */
+
+	if (bbr->mode != BBR_PROBE_BW)
+		return;
+
+	inflight = rs->prior_in_flight;
+	bw = bbr2_max_bw(sk);
+
+	if (bbr->round_start && bbr->rounds_since_probe < 0xFF)
+		bbr->rounds_since_probe++;
+
+	switch (bbr->cycle_idx) {
+	case BBR_BW_PROBE_CRUISE:
+		bbr2_check_time_to_probe_bw(sk);
+		break;
+
+	case BBR_BW_PROBE_REFILL:
+		/* After one round of refilling, start probing. */
+		if (bbr->round_start) {
+			bbr->bw_probe_samples = 1;
+			bbr2_start_bw_probe_up(sk);
+		}
+		break;
+
+	case BBR_BW_PROBE_UP:
+		/* Don't push past the volume that hurt last time, and stop
+		 * once the probe put enough in flight for a min_rtt.
+		 */
+		if (bbr->prev_probe_too_high && inflight >= bbr->inflight_hi) {
+			bbr->stopped_risky_probe = 1;
+			bbr2_start_bw_probe_down(sk);
+		} else if (bbr2_has_elapsed_in_phase(sk, bbr->min_rtt_us) &&
+			   inflight >=
+			   bbr2_inflight(sk, bw, bbr2_bw_probe_pif_gain)) {
+			bbr->prev_probe_too_high = 0;
+			bbr2_start_bw_probe_down(sk);
+		}
+		break;
+
+	case BBR_BW_PROBE_DOWN:
+		if (bbr2_check_time_to_probe_bw(sk))
+			return;		/* already decided state transition */
+		if (bbr2_check_time_to_cruise(sk, inflight, bw))
+			bbr2_start_bw_probe_cruise(sk);
+		break;
+	}
+}
+
+static void bbr2_reset_startup_mode(struct sock *sk)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	bbr->mode = BBR_STARTUP;
+	bbr->pacing_gain = bbr2_high_gain;
+	bbr->cwnd_gain	 = bbr2_high_gain;
+}
+
+static void bbr2_enter_probe_bw(struct sock *sk)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	bbr->mode = BBR_PROBE_BW;
+	bbr->cwnd_gain = bbr2_cwnd_gain;
+	bbr2_start_bw_probe_down(sk);
+}
+
+/* Packet-timed round trips, for the bw filter and the probing phases. */
+static void bbr2_update_round(struct sock *sk, const struct rate_sample *rs)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	bbr->round_start = 0;
+	bbr->loss_round_start = 0;
+	if (rs->delivered < 0 || rs->interval_us <= 0)
+		return; /* Not a valid observation */
+
+	if (!before(rs->prior_delivered, bbr->next_rtt_delivered)) {
+		bbr->next_rtt_delivered = tp->delivered;
+		bbr->round_start = 1;
+		bbr->packet_conservation = 0;
+	}
+
+	/* Loss rounds are kept separately since recovery and the probing
+	 * phases restart the round above.
+	 */
+	if (!before(rs->prior_delivered, bbr->loss_round_delivered))
+		bbr->loss_round_start = 1;
+}
+
+static void bbr2_update_bw(struct sock *sk, const struct rate_sample *rs)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u64 bw;
+
+	if (rs->delivered < 0 || rs->interval_us <= 0)
+		return;
+
+	bw = div64_long((u64)rs->delivered * BW_UNIT, rs->interval_us);
+
+	bbr->bw_latest = max_t(u32, bbr->bw_latest, bw);
+	bbr->inflight_latest = max_t(u32, bbr->inflight_latest, rs->delivered);
+
+	/* Filter out app-limited samples unless they beat the model. */
+	if (!rs->is_app_limited || bw >= bbr2_max_bw(sk))
+		bbr->bw_hi[1] = max_t(u32, bbr->bw_hi[1], bw);
+}
+
+static void bbr2_update_ecn_alpha(struct sock *sk, u32 delivered)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 ce_ratio = 0;
+
+	if (!bbr2_ecn_eligible(sk))
+		return;
+
+	if (delivered)
+		ce_ratio = min_t(u64, (u64)bbr->ce_in_round * BBR_UNIT /
+				 delivered, BBR_UNIT);
+
+	bbr->ecn_alpha -= bbr->ecn_alpha >> bbr2_ecn_alpha_shift;
+	bbr->ecn_alpha += ce_ratio >> bbr2_ecn_alpha_shift;
+
+	if (!bbr2_full_bw_reached(sk)) {
+		if (ce_ratio > bbr2_ecn_thresh)
+			bbr->startup_ecn_rounds = min_t(u32, 3,
+					bbr->startup_ecn_rounds + 1);
+		else
+			bbr->startup_ecn_rounds = 0;
+	}
+}
+
+/* Exit STARTUP on persistent loss or ECN instead of waiting for the bw to
+ * plateau, and remember the volume that caused it.
+ */
+static void bbr2_check_startup_congestion(struct sock *sk, u32 lost,
+					  u32 delivered)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	bool too_high = false;
+
+	if (bbr2_full_bw_reached(sk))
+		return;
+
+	if (lost >= bbr2_full_loss_cnt &&
+	    (u64)lost * BBR_UNIT >
+	    (u64)(lost + delivered) * bbr2_loss_thresh)
+		too_high = true;
+
+	if (bbr->startup_ecn_rounds >= bbr2_full_ecn_cnt)
+		too_high = true;
+
+	if (!too_high)
+		return;
+
+	bbr->full_bw_reached = 1;
+	bbr->inflight_hi = max(bbr2_bdp(sk, bbr2_max_bw(sk), BBR_UNIT),
+			       bbr->inflight_latest);
+}
+
+/* Cut the short term lower bounds on a round trip that saw loss or ECN. */
+static void bbr2_adapt_lower_bounds(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 cut = BBR_UNIT;
+
+	if (bbr2_is_probing_bandwidth(sk))
+		return;
+
+	if (bbr->ecn_in_round && bbr2_ecn_eligible(sk) && bbr2_ecn_factor)
+		cut -= min_t(u32, BBR_UNIT,
+			     (bbr->ecn_alpha * bbr2_ecn_factor) >> BBR_SCALE);
+	if (bbr->loss_in_round)
+		cut = min(cut, BBR_UNIT - bbr2_beta);
+	if (cut == BBR_UNIT)
+		return;
+
+	if (bbr->bw_lo == ~0U)
+		bbr->bw_lo = bbr2_max_bw(sk);
+	if (bbr->inflight_lo == ~0U)
+		bbr->inflight_lo = tp->snd_cwnd;
+
+	bbr->bw_lo = max_t(u32, bbr->bw_latest,
+			   ((u64)bbr->bw_lo * cut) >> BBR_SCALE);
+	bbr->inflight_lo = max_t(u32, bbr->inflight_latest,
+				 ((u64)bbr->inflight_lo * cut) >> BBR_SCALE);
+}
+
+static void bbr2_update_congestion_signals(struct sock *sk,
+					   const struct rate_sample *rs)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 lost, delivered;
+
+	if (rs->losses)
+		bbr->loss_in_round = 1;
+	if (bbr->ece_ack && rs->acked_sacked) {
+		bbr->ecn_in_round = 1;
+		bbr->ce_in_round += rs->acked_sacked;
+	}
+
+	if (!bbr->loss_round_start)
+		return;
+
+	lost = tp->lost - bbr->loss_round_lost;
+	delivered = tp->delivered - bbr->loss_round_delivered;
+
+	bbr2_update_ecn_alpha(sk, delivered);
+	bbr2_check_startup_congestion(sk, lost, delivered);
+	bbr2_adapt_lower_bounds(sk);
+
+	bbr->loss_round_delivered = tp->delivered;
+	bbr->loss_round_lost = tp->lost;
+	bbr2_reset_congestion_signals(sk);
+}
+
+static void bbr2_check_full_bw_reached(struct sock *sk,
+				       const struct rate_sample *rs)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 bw_thresh;
+
+	if (bbr2_full_bw_reached(sk) || !bbr->round_start ||
+	    rs->is_app_limited)
+		return;
+
+	bw_thresh = (u64)bbr->full_bw * bbr2_full_bw_thresh >> BBR_SCALE;
+	if (bbr2_max_bw(sk) >= bw_thresh) {
+		bbr->full_bw = bbr2_max_bw(sk);
+		bbr->full_bw_cnt = 0;
+		return;
+	}
+	++bbr->full_bw_cnt;
+	bbr->full_bw_reached = bbr->full_bw_cnt >= bbr2_full_bw_cnt;
+}
+
+static void bbr2_check_drain(struct sock *sk, const struct rate_sample *rs)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	if (bbr->mode == BBR_STARTUP && bbr2_full_bw_reached(sk)) {
+		bbr->mode = BBR_DRAIN;	/* drain queue we created */
+		bbr->pacing_gain = bbr2_drain_gain;	/* pace slow to drain */
+		bbr->cwnd_gain = bbr2_high_gain;	/* maintain cwnd */
+	}	/* fall through to check if in-flight is already small: */
+	if (bbr->mode == BBR_DRAIN &&
+	    tcp_packets_in_flight(tcp_sk(sk)) <=
+	    bbr2_inflight(sk, bbr2_max_bw(sk), BBR_UNIT))
+		bbr2_enter_probe_bw(sk);  /* we estimate queue is drained */
+}
+
+static void bbr2_exit_probe_rtt(struct sock *sk)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	bbr2_reset_lower_bounds(sk);
+	if (bbr2_full_bw_reached(sk)) {
+		bbr->mode = BBR_PROBE_BW;
+		bbr->cwnd_gain = bbr2_cwnd_gain;
+		/* Raising inflight after PROBE_RTT may cause loss, so reset
+		 * the PROBE_BW clock and schedule the next probing phase.
+		 */
+		bbr2_start_bw_probe_down(sk);
+		bbr2_start_bw_probe_cruise(sk);
+	} else {
+		bbr2_reset_startup_mode(sk);
+	}
+}
+
+/* As in BBR v1, but PROBE_RTT is entered when the min RTT hasn't been
+ * refreshed for bbr2_probe_rtt_win_sec and only cuts the cwnd to half the
+ * BDP, which costs far less throughput on long RTT cellular paths.
+ */
+static void bbr2_update_min_rtt(struct sock *sk, const struct rate_sample *rs)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	bool filter_expired, probe_rtt_expired;
+
+	filter_expired = after(tcp_jiffies32,
+			       bbr->min_rtt_stamp + bbr2_min_rtt_win_sec * HZ);
+	if (rs->rtt_us >= 0 &&
+	    (rs->rtt_us <= bbr->min_rtt_us || filter_expired)) {
+		bbr->min_rtt_us = rs->rtt_us;
+		bbr->min_rtt_stamp = tcp_jiffies32;
+	}
+
+	probe_rtt_expired = after(tcp_jiffies32, bbr->min_rtt_stamp +
+				  bbr2_probe_rtt_win_sec * HZ);
+	if (bbr2_probe_rtt_mode_ms > 0 && probe_rtt_expired &&
+	    !bbr->idle_restart && bbr->mode != BBR_PROBE_RTT) {
+		bbr->mode = BBR_PROBE_RTT;  /* dip, drain queue */
+		bbr->pacing_gain = BBR_UNIT;
+		bbr->cwnd_gain = BBR_UNIT;
+		bbr2_save_cwnd(sk);  /* note cwnd so we can restore it */
+		bbr->probe_rtt_done_stamp = 0;
+	}
+
+	if (bbr->mode == BBR_PROBE_RTT) {
+		/* Ignore low rate samples during this mode. */
+		tp->app_limited =
+			(tp->delivered + tcp_packets_in_flight(tp)) ? : 1;
+		if (!bbr->probe_rtt_done_stamp &&
+		    tcp_packets_in_flight(tp) <= bbr2_probe_rtt_cwnd(sk)) {
+			bbr->probe_rtt_done_stamp = tcp_jiffies32 +
+				msecs_to_jiffies(bbr2_probe_rtt_mode_ms);
+			bbr->probe_rtt_round_done = 0;
+			bbr->next_rtt_delivered = tp->delivered;
+		} else if (bbr->probe_rtt_done_stamp) {
+			if (bbr->round_start)
+				bbr->probe_rtt_round_done = 1;
+			if (bbr->probe_rtt_round_done &&
+			    after(tcp_jiffies32, bbr->probe_rtt_done_stamp)) {
+				bbr->min_rtt_stamp = tcp_jiffies32;
+				bbr->restore_cwnd = 1;  /* snap to prior_cwnd */
+				bbr2_exit_probe_rtt(sk);
+			}
+		}
+	}
+	/* Restart after idle ends only once we process a new S/ACK for data */
+	if (rs->delivered > 0)
+		bbr->idle_restart = 0;
+}
+
+static void bbr2_update_model(struct sock *sk, const struct rate_sample *rs)
+{
+	bbr2_update_round(sk, rs);
+	bbr2_update_bw(sk, rs);
+	bbr2_update_congestion_signals(sk, rs);
+	bbr2_update_cycle_phase(sk, rs);
+	bbr2_check_full_bw_reached(sk, rs);
+	bbr2_check_drain(sk, rs);
+	bbr2_update_min_rtt(sk, rs);
+}
+
+static void bbr2_main(struct sock *sk, const struct rate_sample *rs)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+	u32 bw;
+
+	bbr2_update_model(sk, rs);
+
+	bw = bbr2_bw(sk);
+	bbr2_set_pacing_rate(sk, bw, bbr->pacing_gain);
+	bbr2_set_tso_segs_goal(sk);
+	bbr2_set_cwnd(sk, rs, rs->acked_sacked, bw, bbr->cwnd_gain);
+}
+
+static void bbr2_init(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	memset(bbr, 0, sizeof(*bbr));
+	bbr->next_rtt_delivered = tp->delivered;
+	bbr->loss_round_delivered = tp->delivered;
+	bbr->loss_round_lost = tp->lost;
+	bbr->prev_ca_state = TCP_CA_Open;
+
+	bbr->min_rtt_us = tcp_min_rtt(tp);
+	bbr->min_rtt_stamp = tcp_jiffies32;
+
+	bbr2_init_pacing_rate_from_rtt(sk);
+
+	bbr->inflight_hi = ~0U;
+	bbr2_reset_lower_bounds(sk);
+	bbr->bw_probe_up_cnt = ~0U;
+	bbr2_reset_startup_mode(sk);
+
+	cmpxchg(&sk->sk_pacing_status, SK_PACING_NONE, SK_PACING_NEEDED);
+}
+
+static u32 bbr2_sndbuf_expand(struct sock *sk)
+{
+	/* Provision 3 * cwnd since BBR may slow-start even during recovery. */
+	return 3;
+}
+
+static u32 bbr2_undo_cwnd(struct sock *sk)
+{
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	bbr->full_bw = 0;   /* spurious slow-down; reset full pipe detection */
+	bbr->full_bw_cnt = 0;
+	bbr2_reset_lower_bounds(sk);
+	return tcp_sk(sk)->snd_cwnd;
+}
+
+static u32 bbr2_ssthresh(struct sock *sk)
+{
+	bbr2_save_cwnd(sk);
+	return TCP_INFINITE_SSTHRESH;	 /* BBR does not use ssthresh */
+}
+
+static size_t bbr2_get_info(struct sock *sk, u32 ext, int *attr,
+			    union tcp_cc_info *info)
+{
+	if (ext & (1 << (INET_DIAG_BBRINFO - 1)) ||
+	    ext & (1 << (INET_DIAG_VEGASINFO - 1))) {
+		struct tcp_sock *tp = tcp_sk(sk);
+		struct bbr2 *bbr = inet_csk_ca(sk);
+		u64 bw = bbr2_bw(sk);
+
+		bw = bw * tp->mss_cache * USEC_PER_SEC >> BW_SCALE;
+		memset(&info->bbr, 0, sizeof(info->bbr));
+		info->bbr.bbr_bw_lo		= (u32)bw;
+		info->bbr.bbr_bw_hi		= (u32)(bw >> 32);
+		info->bbr.bbr_min_rtt		= bbr->min_rtt_us;
+		info->bbr.bbr_pacing_gain	= bbr->pacing_gain;
+		info->bbr.bbr_cwnd_gain		= bbr->cwnd_gain;
+		*attr = INET_DIAG_BBRINFO;
+		return sizeof(info->bbr);
+	}
+	return 0;
+}
+
+static void bbr2_set_state(struct sock *sk, u8 new_state)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr2 *bbr = inet_csk_ca(sk);
+
+	if (new_state == TCP_CA_Loss) {
+		bbr->prev_ca_state = TCP_CA_Loss;
+		bbr->full_bw = 0;
+		bbr->loss_in_round = 1;
+		/* bbr2_adapt_lower_bounds() needs the cwnd from before the
+		 * RTO to set inflight_lo from.
+		 */
+		if (!bbr2_is_probing_bandwidth(sk) && bbr->inflight_lo == ~0U)
+			bbr->inflight_lo = max(tp->snd_cwnd, bbr->prior_cwnd);
+	} else if (bbr->prev_ca_state == TCP_CA_Loss &&
+		   new_state != TCP_CA_Loss) {
+		tp->snd_cwnd = max(tp->snd_cwnd, bbr->prior_cwnd);
+	}
+}
+
+static struct tcp_congestion_ops tcp_bbr2_cong_ops __read_mostly = {
+	.flags		= TCP_CONG_NON_RESTRICTED,
+	.name		= "bbr2",
+	.owner		= THIS_MODULE,
+	.init		= bbr2_init,
+	.cong_control	= bbr2_main,
+	.sndbuf_expand	= bbr2_sndbuf_expand,
+	.undo_cwnd	= bbr2_undo_cwnd,
+	.cwnd_event	= bbr2_cwnd_event,
+	.in_ack_event	= bbr2_in_ack_event,
+	.ssthresh	= bbr2_ssthresh,
+	.tso_segs_goal	= bbr2_tso_segs_goal,
+	.get_info	= bbr2_get_info,
+	.set_state	= bbr2_set_state,
+};
+
+static int __init bbr2_register(void)
+{
+	BUILD_BUG_ON(sizeof(struct bbr2) > ICSK_CA_PRIV_SIZE);
+	return tcp_register_congestion_control(&tcp_bbr2_cong_ops);
+}
+
+static void __exit bbr2_unregister(void)
+{
+	tcp_unregister_congestion_control(&tcp_bbr2_cong_ops);
+}
+
+module_init(bbr2_register);
+module_exit(bbr2_unregister);
+
+MODULE_LICENSE("Dual BSD/GPL");
+MODULE_DESCRIPTION("TCP BBR v2 (Bottleneck Bandwidth and RTT)");
@@ -88,6 +88,7 @@ static const struct nlmsg_perm nlmsg_tcpdiag_perms[] =
 	{ DCCPDIAG_GETSOCK,	NETLINK_TCPDIAG_SOCKET__NLMSG_READ },
 	{ SOCK_DIAG_BY_FAMILY,	NETLINK_TCPDIAG_SOCKET__NLMSG_READ },
 	{ SOCK_DESTROY,		NETLINK_TCPDIAG_SOCKET__NLMSG_WRITE },
+	{ SOCK_DIAG_UID_STATS,	NETLINK_TCPDIAG_SOCKET__NLMSG_READ },
 };
 
 static const struct nlmsg_perm nlmsg_xfrm_perms[] =
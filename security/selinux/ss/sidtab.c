@@ -8,6 +8,7 @@
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/errno.h>
+#include <linux/jhash.h>
 #include "flask.h"
 #include "security.h"
 #include "sidtab.h"
@@ -15,6 +16,30 @@
 #define SIDTAB_HASH(sid) \
 (sid & SIDTAB_HASH_MASK)
 
+/*
+ * Hash everything context_cmp() looks at. Equal category sets are made of
+ * the same ebitmap nodes, so hashing the nodes is consistent with it.
+ */
+static u32 sidtab_context_hash(struct context *c)
+{
+	struct ebitmap_node *node;
+	u32 hash;
+	int l;
+
+	if (c->len)
+		return jhash(c->str, c->len, 0) & SIDTAB_CTX_HASH_MASK;
+
+	hash = jhash_3words(c->user, c->role, c->type, 0);
+	for (l = 0; l < 2; l++) {
+		hash = jhash_1word(c->range.level[l].sens, hash);
+		for (node = c->range.level[l].cat.node; node; node = node->next)
+			hash = jhash(node->maps, sizeof(node->maps),
+				     hash ^ node->startbit);
+	}
+
+	return hash & SIDTAB_CTX_HASH_MASK;
+}
+
 int sidtab_init(struct sidtab *s)
 {
 	int i;
@@ -22,6 +47,13 @@ int sidtab_init(struct sidtab *s)
 	s->htable = kmalloc_array(SIDTAB_SIZE, sizeof(*s->htable), GFP_ATOMIC);
 	if (!s->htable)
 		return -ENOMEM;
+	s->rhtable = kcalloc(SIDTAB_CTX_HASH_BUCKETS, sizeof(*s->rhtable),
+			     GFP_ATOMIC);
+	if (!s->rhtable) {
+		kfree(s->htable);
+		s->htable = NULL;
+		return -ENOMEM;
+	}
 	for (i = 0; i < SIDTAB_SIZE; i++)
 		s->htable[i] = NULL;
 	s->nel = 0;
@@ -33,7 +65,7 @@ int sidtab_init(struct sidtab *s)
 
 int sidtab_insert(struct sidtab *s, u32 sid, struct context *context)
 {
-	int hvalue;
+	int hvalue, rhvalue;
 	struct sidtab_node *prev, *cur, *newnode;
 
 	if (!s)
@@ -59,6 +91,8 @@ int sidtab_insert(struct sidtab *s, u32 sid, struct context *context)
 		kfree(newnode);
 		return -ENOMEM;
 	}
+	rhvalue = sidtab_context_hash(&newnode->context);
+	newnode->rnext = s->rhtable[rhvalue];
 
 	if (prev) {
 		newnode->next = prev->next;
@@ -69,6 +103,7 @@ int sidtab_insert(struct sidtab *s, u32 sid, struct context *context)
 		wmb();
 		s->htable[hvalue] = newnode;
 	}
+	s->rhtable[rhvalue] = newnode;
 
 	s->nel++;
 	if (sid >= s->next_sid)
@@ -155,22 +190,40 @@ static void sidtab_update_cache(struct sidtab *s, struct sidtab_node *n, int loc
 static inline u32 sidtab_search_context(struct sidtab *s,
 						  struct context *context)
 {
-	int i;
 	struct sidtab_node *cur;
 
-	for (i = 0; i < SIDTAB_SIZE; i++) {
-		cur = s->htable[i];
-		while (cur) {
-			if (context_cmp(&cur->context, context)) {
-				sidtab_update_cache(s, cur, SIDTAB_CACHE_LEN - 1);
-				return cur->sid;
-			}
-			cur = cur->next;
+	cur = s->rhtable[sidtab_context_hash(context)];
+	while (cur) {
+		if (context_cmp(&cur->context, context)) {
+			sidtab_update_cache(s, cur, SIDTAB_CACHE_LEN - 1);
+			return cur->sid;
 		}
+		cur = cur->rnext;
 	}
 	return 0;
 }
 
+/*
+ * Rebuild the context hash after the contexts were changed in place, as
+ * done on the new table by a policy reload before it is installed.
+ */
+void sidtab_rehash(struct sidtab *s)
+{
+	struct sidtab_node *cur;
+	int i, rhvalue;
+
+	for (i = 0; i < SIDTAB_CTX_HASH_BUCKETS; i++)
+		s->rhtable[i] = NULL;
+
+	for (i = 0; i < SIDTAB_SIZE; i++) {
+		for (cur = s->htable[i]; cur; cur = cur->next) {
+			rhvalue = sidtab_context_hash(&cur->context);
+			cur->rnext = s->rhtable[rhvalue];
+			s->rhtable[rhvalue] = cur;
+		}
+	}
+}
+
 static inline u32 sidtab_search_cache(struct sidtab *s, struct context *context)
 {
 	int i;
@@ -278,6 +331,8 @@ void sidtab_destroy(struct sidtab *s)
 	}
 	kfree(s->htable);
 	s->htable = NULL;
+	kfree(s->rhtable);
+	s->rhtable = NULL;
 	s->nel = 0;
 	s->next_sid = 1;
 }
@@ -289,6 +344,7 @@ void sidtab_set(struct sidtab *dst, struct sidtab *src)
 
 	spin_lock_irqsave(&src->lock, flags);
 	dst->htable = src->htable;
+	dst->rhtable = src->rhtable;
 	dst->nel = src->nel;
 	dst->next_sid = src->next_sid;
 	dst->shutdown = 0;
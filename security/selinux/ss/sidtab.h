@@ -14,6 +14,7 @@ struct sidtab_node {
 	u32 sid;		/* security identifier */
 	struct context context;	/* security context structure */
 	struct sidtab_node *next;
+	struct sidtab_node *rnext;	/* next node in the context hash */
 };
 
 #define SIDTAB_HASH_BITS 7
@@ -22,8 +23,14 @@ struct sidtab_node {
 
 #define SIDTAB_SIZE SIDTAB_HASH_BUCKETS
 
+/* Reverse hash, so that context_to_sid does not walk the whole table */
+#define SIDTAB_CTX_HASH_BITS 9
+#define SIDTAB_CTX_HASH_BUCKETS (1 << SIDTAB_CTX_HASH_BITS)
+#define SIDTAB_CTX_HASH_MASK (SIDTAB_CTX_HASH_BUCKETS-1)
+
 struct sidtab {
 	struct sidtab_node **htable;
+	struct sidtab_node **rhtable;	/* hashed by context */
 	unsigned int nel;	/* number of elements */
 	unsigned int next_sid;	/* next SID to allocate */
 	unsigned char shutdown;
@@ -47,6 +54,7 @@ int sidtab_context_to_sid(struct sidtab *s,
 			  struct context *context,
 			  u32 *sid);
 
+void sidtab_rehash(struct sidtab *s);
 void sidtab_hash_eval(struct sidtab *h, char *tag);
 void sidtab_destroy(struct sidtab *s);
 void sidtab_set(struct sidtab *dst, struct sidtab *src);
@@ -615,15 +615,15 @@ void apr_cb_func(void *buf, int len, void *priv)
 	uint16_t clnt;
 	int i;
 	int temp_port = 0;
-	uint32_t *ptr;
 
 	pr_debug("APR2: len = %d\n", len);
-	ptr = buf;
-	pr_debug("\n*****************\n");
-	for (i = 0; i < len/4; i++)
-		pr_debug("%x  ", ptr[i]);
-	pr_debug("\n");
-	pr_debug("\n*****************\n");
+	/*
+	 * One call per packet rather than one pr_debug() per word: this
+	 * runs for every position and buffer-done event on the rx path.
+	 */
+	if (buf)
+		print_hex_dump_debug("APR2: ", DUMP_PREFIX_NONE, 16, 4,
+				     buf, len, false);
 
 	if (!buf || len <= APR_HDR_SIZE) {
 		pr_err("APR: Improper apr pkt received:%pK %d\n", buf, len);
@@ -20,6 +20,7 @@
 #include <linux/wait.h>
 #include "generic_sw_bridge.h"
 #include "gsb_debugfs.h"
+#include "gsb_flow.h"
 #include <linux/hashtable.h>
 #include <linux/hash.h>
 #include <linux/timer.h>
@@ -760,6 +761,21 @@ static int add_entry_to_ht(struct gsb_if_info *info)
 	return 0;
 }
 
+bool gsb_flow_if_bridged(const struct net_device *dev)
+{
+	struct gsb_ctx *pgsb_ctx = __gc;
+	struct gsb_if_info *if_info = NULL;
+
+	if (IS_ERR_OR_NULL(pgsb_ctx) || dev == NULL)
+		return false;
+
+	spin_lock_bh(&pgsb_ctx->gsb_lock);
+	if_info = get_node_info_from_ht((char *)dev->name);
+	spin_unlock_bh(&pgsb_ctx->gsb_lock);
+
+	return if_info != NULL;
+}
+
 static void display_cache(void)
 {
 	struct gsb_if_info *curr;
@@ -2087,6 +2103,14 @@ static int __init gsb_init_module(void)
 
 	setup_timer(&INACTIVITY_TIMER, inactivity_timer_cb, 0);
 
+	/*
+	* Flow offload is optional, carry on without it on failure.
+	*/
+	if (gsb_flow_init(pgsb_ctx->dbg_dir_root) != 0)
+	{
+		DEBUG_ERROR("software flow offload init failed\n");
+	}
+
 
 	/*
 	* Hook the receive path in the network stack.
@@ -2122,6 +2146,8 @@ static void __exit gsb_exit_module(void)
 		return -EFAULT;
 	}
 
+	gsb_flow_exit();
+
 	unregister_netdevice_notifier(&pgsb_ctx->gsb_dev_notifier);
 	unregister_pm_notifier(&pgsb_ctx->gsb_pm_notifier);
 
@@ -0,0 +1,590 @@
+/* Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Software flow offload for tethered IPv4 traffic the IPA bridge does
+ * not take. Once conntrack has seen a TCP or UDP connection through a
+ * GSB interface established, the forward hook records the route and
+ * the NAT translation of each direction. Later packets of the flow are
+ * matched at the start of PREROUTING, translated, and handed straight
+ * to the neighbour layer, skipping routing, conntrack, NAT and the
+ * filter chains.
+ */
+
+#define pr_fmt(fmt) "gsb_flow: " fmt
+
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/hashtable.h>
+#include <linux/jhash.h>
+#include <linux/random.h>
+#include <linux/seq_file.h>
+#include <linux/ip.h>
+#include <linux/tcp.h>
+#include <linux/udp.h>
+#include <linux/netfilter.h>
+#include <linux/netfilter_ipv4.h>
+#include <net/ip.h>
+#include <net/route.h>
+#include <net/neighbour.h>
+#include <net/checksum.h>
+#include <net/netfilter/nf_conntrack.h>
+#include <net/netfilter/nf_conntrack_helper.h>
+#include "gsb_flow.h"
+
+#define GSB_FLOW_HASH_BITS 10
+/* idle time after which a flow falls back to the slow path */
+#define GSB_FLOW_TIMEOUT (30 * HZ)
+#define GSB_FLOW_GC_INTERVAL HZ
+
+static bool flow_offload;
+module_param(flow_offload, bool, 0444);
+MODULE_PARM_DESC(flow_offload,
+		 "Forward established tethered IPv4 flows in software fast path");
+
+struct gsb_flow_key {
+	__be32 saddr;
+	__be32 daddr;
+	__be16 sport;
+	__be16 dport;
+	u8 l4proto;
+	u8 pad[3];
+};
+
+/* One direction of a flow, hashed once the direction has been learnt */
+struct gsb_flow_dir {
+	struct hlist_node node;
+	struct gsb_flow_key key;
+	struct dst_entry *dst;
+	int iifindex;
+	__be32 nat_saddr;
+	__be32 nat_daddr;
+	__be16 nat_sport;
+	__be16 nat_dport;
+	u8 dir;
+};
+
+struct gsb_flow {
+	struct gsb_flow_dir d[IP_CT_DIR_MAX];
+	struct nf_conn *ct;
+	unsigned long timeout;
+	bool teardown;
+	struct list_head list;
+	struct rcu_head rcu;
+};
+
+struct gsb_flow_pcpu_stats {
+	u64 fast_pkts;
+	u64 fast_bytes;
+};
+
+static DEFINE_HASHTABLE(gsb_flow_ht, GSB_FLOW_HASH_BITS);
+static LIST_HEAD(gsb_flow_list);
+/* protects the hash table and list for writers */
+static DEFINE_SPINLOCK(gsb_flow_lock);
+static atomic_t gsb_flow_count = ATOMIC_INIT(0);
+static u32 gsb_flow_seed __read_mostly;
+static u64 gsb_flow_learnt;
+static u64 gsb_flow_removed;
+static struct gsb_flow_pcpu_stats __percpu *gsb_flow_stats;
+
+static void gsb_flow_gc_work(struct work_struct *work);
+static DECLARE_DELAYED_WORK(gsb_flow_gc, gsb_flow_gc_work);
+
+static u32 gsb_flow_hash(const struct gsb_flow_key *key)
+{
+	return jhash2((const u32 *)key, sizeof(*key) / sizeof(u32),
+		      gsb_flow_seed);
+}
+
+static void gsb_flow_key_from_tuple(struct gsb_flow_key *key,
+				    const struct nf_conntrack_tuple *t)
+{
+	memset(key, 0, sizeof(*key));
+	key->saddr = t->src.u3.ip;
+	key->daddr = t->dst.u3.ip;
+	key->sport = t->src.u.all;
+	key->dport = t->dst.u.all;
+	key->l4proto = t->dst.protonum;
+}
+
+/* Called under rcu_read_lock() or gsb_flow_lock */
+static struct gsb_flow_dir *gsb_flow_lookup(const struct gsb_flow_key *key)
+{
+	struct gsb_flow_dir *fd;
+
+	hash_for_each_possible_rcu(gsb_flow_ht, fd, node, gsb_flow_hash(key))
+		if (!memcmp(&fd->key, key, sizeof(*key)))
+			return fd;
+
+	return NULL;
+}
+
+static struct gsb_flow *gsb_flow_from_dir(struct gsb_flow_dir *fd)
+{
+	return container_of(fd, struct gsb_flow, d[fd->dir]);
+}
+
+static void gsb_flow_free(struct rcu_head *head)
+{
+	struct gsb_flow *flow = container_of(head, struct gsb_flow, rcu);
+	int dir;
+
+	for (dir = 0; dir < IP_CT_DIR_MAX; dir++)
+		dst_release(flow->d[dir].dst);
+
+	nf_ct_put(flow->ct);
+	kfree(flow);
+}
+
+/* Called with gsb_flow_lock held */
+static void gsb_flow_del(struct gsb_flow *flow)
+{
+	int dir;
+
+	for (dir = 0; dir < IP_CT_DIR_MAX; dir++)
+		if (flow->d[dir].dst)
+			hash_del_rcu(&flow->d[dir].node);
+
+	list_del(&flow->list);
+	atomic_dec(&gsb_flow_count);
+	gsb_flow_removed++;
+	call_rcu(&flow->rcu, gsb_flow_free);
+}
+
+/* Called with gsb_flow_lock held */
+static void gsb_flow_dir_add(struct gsb_flow *flow, enum ip_conntrack_dir dir,
+			     const struct net_device *in,
+			     struct dst_entry *dst)
+{
+	const struct nf_conntrack_tuple *rt = &flow->ct->tuplehash[!dir].tuple;
+	struct gsb_flow_dir *fd = &flow->d[dir];
+
+	gsb_flow_key_from_tuple(&fd->key, &flow->ct->tuplehash[dir].tuple);
+	dst_hold(dst);
+	fd->dst = dst;
+	fd->iifindex = in->ifindex;
+	fd->dir = dir;
+
+	/* The other direction's tuple, inverted, is what leaves the box */
+	fd->nat_saddr = rt->dst.u3.ip;
+	fd->nat_daddr = rt->src.u3.ip;
+	fd->nat_sport = rt->dst.u.all;
+	fd->nat_dport = rt->src.u.all;
+
+	hash_add_rcu(gsb_flow_ht, &fd->node, gsb_flow_hash(&fd->key));
+}
+
+static bool gsb_flow_ct_offloadable(struct nf_conn *ct)
+{
+	if (nf_ct_l3num(ct) != NFPROTO_IPV4 || nfct_help(ct) ||
+	    nf_ct_is_dying(ct))
+		return false;
+
+	switch (nf_ct_protonum(ct)) {
+	case IPPROTO_TCP:
+		return ct->proto.tcp.state == TCP_CONNTRACK_ESTABLISHED;
+	case IPPROTO_UDP:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static unsigned int gsb_flow_learn_hook(void *priv, struct sk_buff *skb,
+					const struct nf_hook_state *state)
+{
+	struct dst_entry *dst = skb_dst(skb);
+	enum ip_conntrack_info ctinfo;
+	enum ip_conntrack_dir dir;
+	struct gsb_flow_key key;
+	struct gsb_flow_dir *fd;
+	struct gsb_flow *flow;
+	struct nf_conn *ct;
+
+	ct = nf_ct_get(skb, &ctinfo);
+	if (!ct || !dst || dst_xfrm(dst))
+		return NF_ACCEPT;
+
+	if (ctinfo != IP_CT_ESTABLISHED && ctinfo != IP_CT_ESTABLISHED_REPLY)
+		return NF_ACCEPT;
+
+	if (!gsb_flow_ct_offloadable(ct))
+		return NF_ACCEPT;
+
+	if (!gsb_flow_if_bridged(state->in) && !gsb_flow_if_bridged(state->out))
+		return NF_ACCEPT;
+
+	dir = CTINFO2DIR(ctinfo);
+	gsb_flow_key_from_tuple(&key, &ct->tuplehash[dir].tuple);
+
+	/* Hooks run under rcu_read_lock(), only take the lock to learn */
+	if (gsb_flow_lookup(&key))
+		return NF_ACCEPT;
+
+	spin_lock_bh(&gsb_flow_lock);
+	if (gsb_flow_lookup(&key))
+		goto out;
+
+	/* The other direction may already be known */
+	gsb_flow_key_from_tuple(&key, &ct->tuplehash[!dir].tuple);
+	fd = gsb_flow_lookup(&key);
+	if (fd) {
+		flow = gsb_flow_from_dir(fd);
+		if (flow->ct != ct)
+			goto out;
+	} else {
+		flow = kzalloc(sizeof(*flow), GFP_ATOMIC);
+		if (!flow)
+			goto out;
+
+		nf_conntrack_get(&ct->ct_general);
+		flow->ct = ct;
+		list_add_tail(&flow->list, &gsb_flow_list);
+		atomic_inc(&gsb_flow_count);
+	}
+
+	/* conntrack no longer sees every segment of the connection */
+	if (nf_ct_protonum(ct) == IPPROTO_TCP) {
+		ct->proto.tcp.seen[0].flags |= IP_CT_TCP_FLAG_BE_LIBERAL;
+		ct->proto.tcp.seen[1].flags |= IP_CT_TCP_FLAG_BE_LIBERAL;
+	}
+
+	gsb_flow_dir_add(flow, dir, state->in, dst);
+	WRITE_ONCE(flow->timeout, jiffies + GSB_FLOW_TIMEOUT);
+	gsb_flow_learnt++;
+out:
+	spin_unlock_bh(&gsb_flow_lock);
+	return NF_ACCEPT;
+}
+
+static void gsb_flow_nat(struct sk_buff *skb, struct iphdr *iph,
+			 unsigned int thoff, const struct gsb_flow_dir *fd)
+{
+	void *l4 = skb_network_header(skb) + thoff;
+	__be16 *ports = l4;
+	__sum16 *check = NULL;
+
+	switch (iph->protocol) {
+	case IPPROTO_TCP:
+		check = &((struct tcphdr *)l4)->check;
+		break;
+	case IPPROTO_UDP:
+		if (((struct udphdr *)l4)->check ||
+		    skb->ip_summed == CHECKSUM_PARTIAL)
+			check = &((struct udphdr *)l4)->check;
+		break;
+	}
+
+	if (iph->saddr != fd->nat_saddr) {
+		if (check)
+			inet_proto_csum_replace4(check, skb, iph->saddr,
+						 fd->nat_saddr, true);
+		csum_replace4(&iph->check, iph->saddr, fd->nat_saddr);
+		iph->saddr = fd->nat_saddr;
+	}
+
+	if (iph->daddr != fd->nat_daddr) {
+		if (check)
+			inet_proto_csum_replace4(check, skb, iph->daddr,
+						 fd->nat_daddr, true);
+		csum_replace4(&iph->check, iph->daddr, fd->nat_daddr);
+		iph->daddr = fd->nat_daddr;
+	}
+
+	if (ports[0] != fd->nat_sport) {
+		if (check)
+			inet_proto_csum_replace2(check, skb, ports[0],
+						 fd->nat_sport, false);
+		ports[0] = fd->nat_sport;
+	}
+
+	if (ports[1] != fd->nat_dport) {
+		if (check)
+			inet_proto_csum_replace2(check, skb, ports[1],
+						 fd->nat_dport, false);
+		ports[1] = fd->nat_dport;
+	}
+
+	if (iph->protocol == IPPROTO_UDP && check && !*check)
+		*check = CSUM_MANGLED_0;
+}
+
+static unsigned int gsb_flow_fast_hook(void *priv, struct sk_buff *skb,
+				       const struct nf_hook_state *state)
+{
+	struct gsb_flow_pcpu_stats *stats;
+	unsigned int thoff, hdrsize, mtu;
+	struct gsb_flow_key key;
+	struct gsb_flow_dir *fd;
+	struct gsb_flow *flow;
+	struct dst_entry *dst;
+	const struct iphdr *iph;
+	__be16 *ports;
+	__be32 nexthop;
+
+	if (!atomic_read(&gsb_flow_count))
+		return NF_ACCEPT;
+
+	if (!pskb_may_pull(skb, sizeof(*iph)))
+		return NF_ACCEPT;
+
+	iph = ip_hdr(skb);
+	if (iph->ihl != 5 || ip_is_fragment(iph) || iph->ttl <= 1)
+		return NF_ACCEPT;
+
+	thoff = sizeof(*iph);
+	switch (iph->protocol) {
+	case IPPROTO_TCP:
+		hdrsize = sizeof(struct tcphdr);
+		break;
+	case IPPROTO_UDP:
+		hdrsize = sizeof(struct udphdr);
+		break;
+	default:
+		return NF_ACCEPT;
+	}
+
+	if (!pskb_may_pull(skb, thoff + hdrsize))
+		return NF_ACCEPT;
+
+	iph = ip_hdr(skb);
+	ports = (__be16 *)(skb_network_header(skb) + thoff);
+
+	memset(&key, 0, sizeof(key));
+	key.saddr = iph->saddr;
+	key.daddr = iph->daddr;
+	key.sport = ports[0];
+	key.dport = ports[1];
+	key.l4proto = iph->protocol;
+
+	fd = gsb_flow_lookup(&key);
+	if (!fd || fd->iifindex != state->in->ifindex)
+		return NF_ACCEPT;
+
+	flow = gsb_flow_from_dir(fd);
+	if (READ_ONCE(flow->teardown))
+		return NF_ACCEPT;
+
+	/* Let conntrack see the end of the connection */
+	if (iph->protocol == IPPROTO_TCP) {
+		const struct tcphdr *tcph = (const struct tcphdr *)ports;
+
+		if (tcph->fin || tcph->rst) {
+			WRITE_ONCE(flow->teardown, true);
+			return NF_ACCEPT;
+		}
+	}
+
+	dst = fd->dst;
+	if (!dst_check(dst, 0)) {
+		WRITE_ONCE(flow->teardown, true);
+		return NF_ACCEPT;
+	}
+
+	/* Fragmentation and ICMP errors are left to the slow path */
+	mtu = dst_mtu(dst);
+	if (skb->len > mtu &&
+	    (!skb_is_gso(skb) || !skb_gso_validate_mtu(skb, mtu)))
+		return NF_ACCEPT;
+
+	if (skb_try_make_writable(skb, thoff + hdrsize))
+		return NF_DROP;
+
+	gsb_flow_nat(skb, ip_hdr(skb), thoff, fd);
+	ip_decrease_ttl(ip_hdr(skb));
+	WRITE_ONCE(flow->timeout, jiffies + GSB_FLOW_TIMEOUT);
+
+	stats = this_cpu_ptr(gsb_flow_stats);
+	stats->fast_pkts++;
+	stats->fast_bytes += skb->len;
+
+	nexthop = rt_nexthop((struct rtable *)dst, ip_hdr(skb)->daddr);
+	skb->dev = dst->dev;
+	skb_dst_drop(skb);
+	skb_dst_set_noref(skb, dst);
+	neigh_xmit(NEIGH_ARP_TABLE, skb->dev, &nexthop, skb);
+
+	return NF_STOLEN;
+}
+
+static void gsb_flow_refresh_ct(struct nf_conn *ct)
+{
+	/* Hold the conntrack entry while the fast path owns the flow */
+	if (nf_ct_expires(ct) < 2 * GSB_FLOW_TIMEOUT)
+		WRITE_ONCE(ct->timeout, nfct_time_stamp + 2 * GSB_FLOW_TIMEOUT);
+}
+
+static void gsb_flow_gc_work(struct work_struct *work)
+{
+	struct gsb_flow *flow, *tmp;
+
+	spin_lock_bh(&gsb_flow_lock);
+	list_for_each_entry_safe(flow, tmp, &gsb_flow_list, list) {
+		if (READ_ONCE(flow->teardown) || nf_ct_is_dying(flow->ct) ||
+		    time_after(jiffies, READ_ONCE(flow->timeout))) {
+			gsb_flow_del(flow);
+			continue;
+		}
+
+		gsb_flow_refresh_ct(flow->ct);
+	}
+	spin_unlock_bh(&gsb_flow_lock);
+
+	queue_delayed_work(system_power_efficient_wq, &gsb_flow_gc,
+			   GSB_FLOW_GC_INTERVAL);
+}
+
+static void gsb_flow_flush(const struct net_device *dev)
+{
+	struct gsb_flow *flow, *tmp;
+	int dir;
+
+	spin_lock_bh(&gsb_flow_lock);
+	list_for_each_entry_safe(flow, tmp, &gsb_flow_list, list) {
+		for (dir = 0; dir < IP_CT_DIR_MAX; dir++) {
+			struct gsb_flow_dir *fd = &flow->d[dir];
+
+			if (!dev || (fd->dst && (fd->dst->dev == dev ||
+						 fd->iifindex == dev->ifindex))) {
+				gsb_flow_del(flow);
+				break;
+			}
+		}
+	}
+	spin_unlock_bh(&gsb_flow_lock);
+}
+
+static int gsb_flow_netdev_event(struct notifier_block *nb,
+				 unsigned long event, void *ptr)
+{
+	struct net_device *dev = netdev_notifier_info_to_dev(ptr);
+
+	switch (event) {
+	case NETDEV_DOWN:
+	case NETDEV_UNREGISTER:
+	case NETDEV_CHANGEMTU:
+		gsb_flow_flush(dev);
+		break;
+	}
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block gsb_flow_netdev_notifier = {
+	.notifier_call = gsb_flow_netdev_event,
+};
+
+static const struct nf_hook_ops gsb_flow_ops[] = {
+	{
+		.hook = gsb_flow_fast_hook,
+		.pf = NFPROTO_IPV4,
+		.hooknum = NF_INET_PRE_ROUTING,
+		.priority = NF_IP_PRI_CONNTRACK_DEFRAG - 1,
+	},
+	{
+		.hook = gsb_flow_learn_hook,
+		.pf = NFPROTO_IPV4,
+		.hooknum = NF_INET_FORWARD,
+		.priority = NF_IP_PRI_LAST,
+	},
+};
+
+static int gsb_flow_stats_show(struct seq_file *s, void *unused)
+{
+	u64 pkts = 0, bytes = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct gsb_flow_pcpu_stats *stats;
+
+		stats = per_cpu_ptr(gsb_flow_stats, cpu);
+		pkts += stats->fast_pkts;
+		bytes += stats->fast_bytes;
+	}
+
+	seq_printf(s, "active flows: %d\n", atomic_read(&gsb_flow_count));
+	seq_printf(s, "learnt directions: %llu\n", gsb_flow_learnt);
+	seq_printf(s, "removed flows: %llu\n", gsb_flow_removed);
+	seq_printf(s, "fast path packets: %llu\n", pkts);
+	seq_printf(s, "fast path bytes: %llu\n", bytes);
+	return 0;
+}
+
+static int gsb_flow_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, gsb_flow_stats_show, NULL);
+}
+
+static const struct file_operations gsb_flow_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = gsb_flow_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+int gsb_flow_init(struct dentry *dbg_root)
+{
+	int ret;
+
+	if (!flow_offload)
+		return 0;
+
+	get_random_bytes(&gsb_flow_seed, sizeof(gsb_flow_seed));
+
+	gsb_flow_stats = alloc_percpu(struct gsb_flow_pcpu_stats);
+	if (!gsb_flow_stats)
+		return -ENOMEM;
+
+	ret = register_netdevice_notifier(&gsb_flow_netdev_notifier);
+	if (ret)
+		goto free_stats;
+
+	ret = nf_register_net_hooks(&init_net, gsb_flow_ops,
+				    ARRAY_SIZE(gsb_flow_ops));
+	if (ret)
+		goto unregister_notifier;
+
+	if (!IS_ERR_OR_NULL(dbg_root))
+		debugfs_create_file("flow_stats", 0400, dbg_root, NULL,
+				    &gsb_flow_stats_fops);
+
+	queue_delayed_work(system_power_efficient_wq, &gsb_flow_gc,
+			   GSB_FLOW_GC_INTERVAL);
+	pr_info("software flow offload enabled\n");
+	return 0;
+
+unregister_notifier:
+	unregister_netdevice_notifier(&gsb_flow_netdev_notifier);
+free_stats:
+	free_percpu(gsb_flow_stats);
+	gsb_flow_stats = NULL;
+	return ret;
+}
+
+void gsb_flow_exit(void)
+{
+	if (!gsb_flow_stats)
+		return;
+
+	nf_unregister_net_hooks(&init_net, gsb_flow_ops,
+				ARRAY_SIZE(gsb_flow_ops));
+	unregister_netdevice_notifier(&gsb_flow_netdev_notifier);
+	cancel_delayed_work_sync(&gsb_flow_gc);
+
+	gsb_flow_flush(NULL);
+	rcu_barrier();
+
+	free_percpu(gsb_flow_stats);
+	gsb_flow_stats = NULL;
+}
@@ -0,0 +1,36 @@
+/* Copyright (c) 2019, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef _GSB_FLOW_H_
+#define _GSB_FLOW_H_
+
+#include <linux/netdevice.h>
+#include <linux/debugfs.h>
+
+/* Provided by the bridge core: is @dev configured in GSB */
+bool gsb_flow_if_bridged(const struct net_device *dev);
+
+#if IS_ENABLED(CONFIG_NF_CONNTRACK)
+int gsb_flow_init(struct dentry *dbg_root);
+void gsb_flow_exit(void);
+#else
+static inline int gsb_flow_init(struct dentry *dbg_root)
+{
+	return 0;
+}
+
+static inline void gsb_flow_exit(void)
+{
+}
+#endif
+
+#endif
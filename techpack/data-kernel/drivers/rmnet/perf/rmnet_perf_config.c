@@ -16,6 +16,7 @@
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/netdevice.h>
+#include <linux/percpu.h>
 #include "rmnet_perf_core.h"
 #include "rmnet_perf_opt.h"
 #include "rmnet_perf_config.h"
@@ -124,24 +125,32 @@ static void rmnet_perf_config_free_64k_buffs(struct rmnet_perf *perf)
 static enum rmnet_perf_resource_management_e
 rmnet_perf_config_free_resources(struct rmnet_perf *perf)
 {
+	int cpu;
+
 	if (!perf) {
 		pr_err("%s(): Cannot free resources without proper perf\n",
 		       __func__);
 		return RMNET_PERF_RESOURCE_MGMT_FAIL;
 	}
 
-	/* Free everything flow nodes currently hold */
-	rmnet_perf_opt_flush_all_flow_nodes();
+	/* Free everything flow nodes currently hold. Before we free
+	 * tcp_opt's structures, make sure we arent holding any SKB's hostage
+	 */
+	rmnet_perf_core_flush_all_cpus();
 
 	/* Get rid of 64k sk_buff cache */
 	rmnet_perf_config_free_64k_buffs(perf);
-	/* Before we free tcp_opt's structures, make sure we arent holding
-	 * any SKB's hostage
-	 */
-	rmnet_perf_core_free_held_skbs();
 
-	/* Clean up any remaining nodes in the flow table before freeing */
-	rmnet_perf_free_hash_table();
+	for_each_possible_cpu(cpu) {
+		struct rmnet_perf_cpu *pcpu = per_cpu_ptr(perf->cpu_state, cpu);
+
+		/* Clean up any remaining nodes in the flow table before
+		 * freeing
+		 */
+		rmnet_perf_free_hash_table(pcpu->opt_meta);
+		kfree(pcpu->opt_meta);
+	}
+	free_percpu(perf->cpu_state);
 
 	/* Since we allocated in one chunk, we will also free in one chunk */
 	kfree(perf);
@@ -149,51 +158,33 @@ rmnet_perf_config_free_resources(struct rmnet_perf *perf)
 	return RMNET_PERF_RESOURCE_MGMT_SUCCESS;
 }
 
-/* rmnet_perf_config_allocate_resources() - Allocates and assigns all tcp_opt
- *		required meta data
- * @perf: allows access to our required global structures
- *
- * Prepares node pool, the nodes themselves, the skb list from the
- * physical device, and the recycled skb pool
- * TODO separate out things which are not tcp_opt specific
+/* rmnet_perf_config_alloc_opt_meta() - Allocates the flow nodes of one CPU
  *
  * Return:
- *		- status of the freeing dependent on the validity of the perf
+ *		- opt_meta: the node pool and hash table of the CPU
+ *		- NULL: memory failure
  **/
-static int rmnet_perf_config_allocate_resources(struct rmnet_perf **perf)
+static struct rmnet_perf_opt_meta *rmnet_perf_config_alloc_opt_meta(void)
 {
 	int i;
 	void *buffer_head;
 	struct rmnet_perf_opt_meta *opt_meta;
-	struct rmnet_perf_core_meta *core_meta;
-	struct rmnet_perf *local_perf;
 
-	int perf_size = sizeof(**perf);
 	int opt_meta_size = sizeof(struct rmnet_perf_opt_meta);
 	int flow_node_pool_size =
 			sizeof(struct rmnet_perf_opt_flow_node_pool);
-	int bm_state_size = sizeof(struct rmnet_perf_core_burst_marker_state);
 	int flow_node_size = sizeof(struct rmnet_perf_opt_flow_node);
-	int core_meta_size = sizeof(struct rmnet_perf_core_meta);
-	int skb_list_size = sizeof(struct rmnet_perf_core_skb_list);
-	int skb_buff_pool_size = sizeof(struct rmnet_perf_core_64k_buff_pool);
 
-	int total_size = perf_size + opt_meta_size + flow_node_pool_size +
-			(flow_node_size * RMNET_PERF_NUM_FLOW_NODES) +
-			core_meta_size + skb_list_size + skb_buff_pool_size
-			+ bm_state_size;
+	int total_size = opt_meta_size + flow_node_pool_size +
+			(flow_node_size * RMNET_PERF_NUM_FLOW_NODES);
 
 	/* allocate all the memory in one chunk for cache coherency sake */
 	buffer_head = kmalloc(total_size, GFP_KERNEL);
-	*perf = buffer_head;
 	if (!buffer_head)
-		return RMNET_PERF_RESOURCE_MGMT_FAIL;
+		return NULL;
 
-	local_perf = *perf;
-	buffer_head += perf_size;
-
-	local_perf->opt_meta = buffer_head;
-	opt_meta = local_perf->opt_meta;
+	opt_meta = buffer_head;
+	hash_init(opt_meta->fht);
 	buffer_head += opt_meta_size;
 
 	/* assign the node pool */
@@ -213,28 +204,83 @@ static int rmnet_perf_config_allocate_resources(struct rmnet_perf **perf)
 		(*flow_node)->len = 0;
 	}
 
+	return opt_meta;
+}
+
+/* rmnet_perf_config_allocate_resources() - Allocates and assigns all tcp_opt
+ *		required meta data
+ * @perf: allows access to our required global structures
+ *
+ * Prepares the per CPU node pools, the nodes themselves, the skb lists
+ * from the physical device, and the recycled skb pool
+ * TODO separate out things which are not tcp_opt specific
+ *
+ * Return:
+ *		- status of the freeing dependent on the validity of the perf
+ **/
+static int rmnet_perf_config_allocate_resources(struct rmnet_perf **perf)
+{
+	int cpu;
+	void *buffer_head;
+	struct rmnet_perf_core_meta *core_meta;
+	struct rmnet_perf *local_perf;
+
+	int perf_size = sizeof(**perf);
+	int core_meta_size = sizeof(struct rmnet_perf_core_meta);
+	int skb_buff_pool_size = sizeof(struct rmnet_perf_core_64k_buff_pool);
+
+	int total_size = perf_size + core_meta_size + skb_buff_pool_size;
+
+	buffer_head = kmalloc(total_size, GFP_KERNEL);
+	*perf = buffer_head;
+	if (!buffer_head)
+		return RMNET_PERF_RESOURCE_MGMT_FAIL;
+
+	local_perf = *perf;
+	buffer_head += perf_size;
+
 	local_perf->core_meta = buffer_head;
 	core_meta = local_perf->core_meta;
 	buffer_head += core_meta_size;
 
-	/* Assign common (not specific to something like opt) structures */
-	core_meta->skb_needs_free_list = buffer_head;
-	core_meta->skb_needs_free_list->num_skbs_held = 0;
-	buffer_head += skb_list_size;
-
-	/* allocate buffer pool struct (also not specific to opt) */
+	/* allocate buffer pool struct (not specific to opt) */
 	core_meta->buff_pool = buffer_head;
 	buffer_head += skb_buff_pool_size;
 
-	/* assign the burst marker state */
-	core_meta->bm_state = buffer_head;
-	core_meta->bm_state->curr_seq = 0;
-	core_meta->bm_state->expect_packets = 0;
-	core_meta->bm_state->wait_for_start = true;
-	core_meta->bm_state->callbacks_valid = false;
-	buffer_head += bm_state_size;
+	cpumask_clear(&local_perf->held_mask);
+	local_perf->cpu_state = alloc_percpu(struct rmnet_perf_cpu);
+	if (!local_perf->cpu_state)
+		goto free_perf;
+
+	for_each_possible_cpu(cpu) {
+		struct rmnet_perf_cpu *pcpu;
+
+		pcpu = per_cpu_ptr(local_perf->cpu_state, cpu);
+		spin_lock_init(&pcpu->lock);
+		pcpu->opt_meta = rmnet_perf_config_alloc_opt_meta();
+		if (!pcpu->opt_meta)
+			goto free_cpus;
+
+		pcpu->skb_needs_free_list.num_skbs_held = 0;
+
+		/* assign the burst marker state */
+		pcpu->bm_state.curr_seq = 0;
+		pcpu->bm_state.expect_packets = 0;
+		pcpu->bm_state.wait_for_start = true;
+		pcpu->bm_state.callbacks_valid = false;
+	}
 
 	return RMNET_PERF_RESOURCE_MGMT_SUCCESS;
+
+free_cpus:
+	/* alloc_percpu() zeroed the opt_meta of the CPUs we didn't reach */
+	for_each_possible_cpu(cpu)
+		kfree(per_cpu_ptr(local_perf->cpu_state, cpu)->opt_meta);
+	free_percpu(local_perf->cpu_state);
+free_perf:
+	kfree(local_perf);
+	*perf = NULL;
+	return RMNET_PERF_RESOURCE_MGMT_FAIL;
 }
 
 enum rmnet_perf_resource_management_e
@@ -292,8 +338,13 @@ rmnet_perf_config_register_callbacks(struct net_device *dev,
 		pr_err("%s(): Failed to allocate ps_ind\n", __func__);
 	}
 
-	if (rc == RMNET_PERF_RESOURCE_MGMT_SUCCESS)
-		perf->core_meta->bm_state->callbacks_valid = true;
+	if (rc == RMNET_PERF_RESOURCE_MGMT_SUCCESS) {
+		int cpu;
+
+		for_each_possible_cpu(cpu)
+			per_cpu_ptr(perf->cpu_state,
+				    cpu)->bm_state.callbacks_valid = true;
+	}
 
 	return rc;
 }
@@ -124,17 +124,72 @@ MODULE_PARM_DESC(rmnet_perf_ingress_deag,
 #define SHS_FLUSH				0
 #define RECYCLE_BUFF_SIZE_THRESH		51200
 
-/* Lock around flow nodes for syncornization with rmnet_perf_opt_mode changes */
-static DEFINE_SPINLOCK(rmnet_perf_core_lock);
+/* Lock around the recycled buffer pool, shared by all CPUs */
+static DEFINE_SPINLOCK(rmnet_perf_core_buff_lock);
 
+/* rmnet_perf_core_grab_lock() - Lock the coalescing state of this CPU
+ *
+ * Flow nodes, held SKBs and burst marker state are per CPU, so ingress on
+ * different CPUs never waits on each other. The lock only synchronizes
+ * with rmnet_perf_opt_mode changes, teardown and flushes of a CPU that
+ * ingress moved away from. Bottom halves stay disabled until
+ * rmnet_perf_core_release_lock(), which keeps us on this CPU.
+ *
+ * Return:
+ *		- void
+ **/
 void rmnet_perf_core_grab_lock(void)
 {
-	spin_lock_bh(&rmnet_perf_core_lock);
+	local_bh_disable();
+	spin_lock(&rmnet_perf_core_get_cpu()->lock);
 }
 
 void rmnet_perf_core_release_lock(void)
 {
-	spin_unlock_bh(&rmnet_perf_core_lock);
+	spin_unlock(&rmnet_perf_core_get_cpu()->lock);
+	local_bh_enable();
+}
+
+/* rmnet_perf_core_get_cpu() - Get the coalescing state of this CPU
+ *
+ * Caller must have bottom halves disabled.
+ *
+ * Return:
+ *		- the per CPU state
+ **/
+struct rmnet_perf_cpu *rmnet_perf_core_get_cpu(void)
+{
+	struct rmnet_perf *perf = rmnet_perf_config_get_perf();
+
+	return this_cpu_ptr(perf->cpu_state);
+}
+
+/* rmnet_perf_core_flush_cpu() - Flush everything a CPU is holding
+ * @cpu: the CPU to flush, may be a remote one
+ *
+ * Must not be called with the lock of any CPU held.
+ *
+ * Return:
+ *		- void
+ **/
+void rmnet_perf_core_flush_cpu(int cpu)
+{
+	struct rmnet_perf *perf = rmnet_perf_config_get_perf();
+	struct rmnet_perf_cpu *pcpu = per_cpu_ptr(perf->cpu_state, cpu);
+
+	spin_lock_bh(&pcpu->lock);
+	__rmnet_perf_opt_flush_all_flow_nodes(pcpu->opt_meta);
+	__rmnet_perf_core_free_held_skbs(pcpu);
+	cpumask_clear_cpu(cpu, &perf->held_mask);
+	spin_unlock_bh(&pcpu->lock);
+}
+
+void rmnet_perf_core_flush_all_cpus(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		rmnet_perf_core_flush_cpu(cpu);
 }
 
 /* rmnet_perf_core_set_ingress_hook() - sets appropriate ingress hook
@@ -179,17 +234,21 @@ inline bool rmnet_perf_core_is_deag_mode(void)
  * Return:
  *		- void
  **/
-void rmnet_perf_core_free_held_skbs(void)
+void __rmnet_perf_core_free_held_skbs(struct rmnet_perf_cpu *pcpu)
 {
-	struct rmnet_perf *perf = rmnet_perf_config_get_perf();
 	struct rmnet_perf_core_skb_list *skb_list;
 
-	skb_list = perf->core_meta->skb_needs_free_list;
+	skb_list = &pcpu->skb_needs_free_list;
 	if (skb_list->num_skbs_held > 0)
 		kfree_skb_list(skb_list->head);
 	skb_list->num_skbs_held = 0;
 }
 
+void rmnet_perf_core_free_held_skbs(void)
+{
+	__rmnet_perf_core_free_held_skbs(rmnet_perf_core_get_cpu());
+}
+
 /* rmnet_perf_core_reset_recycled_skb() - Clear/prepare recycled SKB to be
  *		used again
  * @skb: recycled buffer we are clearing out
@@ -251,6 +310,7 @@ struct sk_buff *rmnet_perf_core_elligible_for_cache_skb(u32 len)
 	if (len < RECYCLE_BUFF_SIZE_THRESH || !buff_pool->available[0])
 		return NULL;
 
+	spin_lock(&rmnet_perf_core_buff_lock);
 	circ_index = buff_pool->index;
 	iterations = 0;
 	while (iterations < RMNET_PERF_NUM_64K_BUFFS) {
@@ -268,12 +328,14 @@ struct sk_buff *rmnet_perf_core_elligible_for_cache_skb(u32 len)
 		buff_pool->index = (circ_index + 1) %
 				   RMNET_PERF_NUM_64K_BUFFS;
 		rmnet_perf_core_skb_recycle_iterations[iterations]++;
+		spin_unlock(&rmnet_perf_core_buff_lock);
 		return skbn;
 	}
 	/* if we increment this stat, then we know we did'nt find a
 	 * suitable buffer
 	 */
 	rmnet_perf_core_skb_recycle_iterations[iterations]++;
+	spin_unlock(&rmnet_perf_core_buff_lock);
 	return NULL;
 }
 
@@ -342,10 +404,9 @@ u32 rmnet_perf_core_compute_flow_hash(struct rmnet_perf_pkt_info *pkt_info)
  **/
 void rmnet_perf_core_accept_new_skb(struct sk_buff *skb)
 {
-	struct rmnet_perf *perf = rmnet_perf_config_get_perf();
 	struct rmnet_perf_core_skb_list *skb_needs_free_list;
 
-	skb_needs_free_list = perf->core_meta->skb_needs_free_list;
+	skb_needs_free_list = &rmnet_perf_core_get_cpu()->skb_needs_free_list;
 	if (!skb_needs_free_list->num_skbs_held) {
 		skb_needs_free_list->head = skb;
 		skb_needs_free_list->tail = skb;
@@ -473,10 +534,12 @@ void rmnet_perf_core_flush_curr_pkt(struct rmnet_perf_pkt_info *pkt_info,
 void rmnet_perf_core_ps_on(void *port)
 {
 	struct rmnet_perf *perf = rmnet_perf_config_get_perf();
+	int cpu;
 
 	rmnet_perf_core_bm_flush_on = 0;
 	/* Essentially resets expected packet count to safe state */
-	perf->core_meta->bm_state->expect_packets = -1;
+	for_each_possible_cpu(cpu)
+		per_cpu_ptr(perf->cpu_state, cpu)->bm_state.expect_packets = -1;
 }
 
 /* DL marker on, we can try to coalesce more packets */
@@ -495,10 +558,9 @@ rmnet_perf_core_handle_map_control_start_v2(struct rmnet_map_dl_ind_hdr *dlhdr,
 void
 rmnet_perf_core_handle_map_control_start(struct rmnet_map_dl_ind_hdr *dlhdr)
 {
-	struct rmnet_perf *perf = rmnet_perf_config_get_perf();
 	struct rmnet_perf_core_burst_marker_state *bm_state;
 
-	bm_state = perf->core_meta->bm_state;
+	bm_state = &rmnet_perf_core_get_cpu()->bm_state;
 	/* if we get two starts in a row, without an end, then we flush
 	 * and carry on
 	 */
@@ -526,10 +588,9 @@ void rmnet_perf_core_handle_map_control_end_v2(struct rmnet_map_dl_ind_trl *dltr
 
 void rmnet_perf_core_handle_map_control_end(struct rmnet_map_dl_ind_trl *dltrl)
 {
-	struct rmnet_perf *perf = rmnet_perf_config_get_perf();
 	struct rmnet_perf_core_burst_marker_state *bm_state;
 
-	bm_state = perf->core_meta->bm_state;
+	bm_state = &rmnet_perf_core_get_cpu()->bm_state;
 	rmnet_perf_opt_flush_all_flow_nodes();
 	rmnet_perf_core_flush_reason_cnt[RMNET_PERF_CORE_DL_MARKER_FLUSHES]++;
 	bm_state->wait_for_start = true;
@@ -996,6 +1057,27 @@ int __rmnet_perf_core_deaggregate(struct sk_buff *skb, struct rmnet_port *port)
 	return count;
 }
 
+/* rmnet_perf_core_flush_stale_cpus() - Flush CPUs ingress moved away from
+ * @perf: allows access to our required global structures
+ *
+ * Coalesced packets can be held across SKB chains while waiting for the
+ * DL marker trailer. If the next chain is processed elsewhere, that
+ * trailer never reaches the CPU holding them, so push them up now.
+ *
+ * Return:
+ *		- void
+ **/
+static void rmnet_perf_core_flush_stale_cpus(struct rmnet_perf *perf)
+{
+	int this_cpu = smp_processor_id();
+	int cpu;
+
+	for_each_cpu(cpu, &perf->held_mask) {
+		if (cpu != this_cpu)
+			rmnet_perf_core_flush_cpu(cpu);
+	}
+}
+
 /* rmnet_perf_core_deaggregate() - Deaggregate ip packets from map frame
  * @skb: the incoming aggregated MAP frame from PND
  * @port: rmnet_port struct from core driver
@@ -1007,13 +1089,18 @@ void rmnet_perf_core_deaggregate(struct sk_buff *skb,
 				 struct rmnet_port *port)
 {
 	struct rmnet_perf *perf;
+	struct rmnet_perf_cpu *pcpu;
 	struct rmnet_perf_core_burst_marker_state *bm_state;
 	int co = 0;
 	int chain_count = 0;
 
 	perf = rmnet_perf_config_get_perf();
 	perf->rmnet_port = port;
+	if (unlikely(!cpumask_empty(&perf->held_mask)))
+		rmnet_perf_core_flush_stale_cpus(perf);
+
 	rmnet_perf_core_grab_lock();
+	pcpu = rmnet_perf_core_get_cpu();
 	while (skb) {
 		struct sk_buff *skb_frag = skb_shinfo(skb)->frag_list;
 
@@ -1024,7 +1111,7 @@ void rmnet_perf_core_deaggregate(struct sk_buff *skb,
 		skb = skb_frag;
 	}
 
-	bm_state = perf->core_meta->bm_state;
+	bm_state = &pcpu->bm_state;
 	bm_state->expect_packets -= co;
 	/* if we ran out of data and should have gotten an end marker,
 	 * then we can flush everything
@@ -1036,12 +1123,16 @@ void rmnet_perf_core_deaggregate(struct sk_buff *skb,
 		rmnet_perf_core_free_held_skbs();
 		rmnet_perf_core_flush_reason_cnt[
 					RMNET_PERF_CORE_IPA_ZERO_FLUSH]++;
-	} else if (perf->core_meta->skb_needs_free_list->num_skbs_held >=
+		cpumask_clear_cpu(smp_processor_id(), &perf->held_mask);
+	} else if (pcpu->skb_needs_free_list.num_skbs_held >=
 		   rmnet_perf_core_num_skbs_max) {
 		rmnet_perf_opt_flush_all_flow_nodes();
 		rmnet_perf_core_free_held_skbs();
 		rmnet_perf_core_flush_reason_cnt[
 					RMNET_PERF_CORE_SK_BUFF_HELD_LIMIT]++;
+		cpumask_clear_cpu(smp_processor_id(), &perf->held_mask);
+	} else {
+		cpumask_set_cpu(smp_processor_id(), &perf->held_mask);
 	}
 
 	rmnet_perf_core_pre_ip_count += co;
@@ -9,7 +9,9 @@
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
  * GNU General Public License for more details.
  */
+#include <linux/cpumask.h>
 #include <linux/skbuff.h>
+#include <linux/spinlock.h>
 #include <../drivers/net/ethernet/qualcomm/rmnet/rmnet_config.h>
 #include <../drivers/net/ethernet/qualcomm/rmnet/rmnet_map.h>
 #include <../drivers/net/ethernet/qualcomm/rmnet/rmnet_descriptor.h>
@@ -20,10 +22,15 @@
 #define RMNET_PERF_NUM_64K_BUFFS              50
 #define RMNET_PERF_CORE_RECYCLE_SKB_SIZE    65600//33000//32768//65600
 
+struct rmnet_perf_cpu;
+
 struct rmnet_perf {
-	struct rmnet_perf_opt_meta *opt_meta;
 	struct rmnet_perf_core_meta *core_meta;
 	struct rmnet_port *rmnet_port;
+	/* Coalescing state, one per CPU. See rmnet_perf_core_grab_lock() */
+	struct rmnet_perf_cpu __percpu *cpu_state;
+	/* CPUs still holding coalesced packets after their last SKB chain */
+	cpumask_t held_mask;
 };
 
 /* Identifying info for the current packet being deaggregated
@@ -96,16 +103,26 @@ struct rmnet_perf_core_skb_list {
 };
 
 struct rmnet_perf_core_meta {
-	/* skbs from physical device */
-	struct rmnet_perf_core_skb_list *skb_needs_free_list;
 	/* recycled buffer pool */
 	struct rmnet_perf_core_64k_buff_pool *buff_pool;
 	struct net_device *dev;
-	struct rmnet_perf_core_burst_marker_state *bm_state;
 	struct rmnet_map_dl_ind *dl_ind;
 	struct qmi_rmnet_ps_ind *ps_ind;
 };
 
+/* Everything the ingress path of one CPU coalesces with. Ingress running
+ * on different CPUs never shares flow nodes, held SKBs or burst marker
+ * accounting, so the lock is only contended by the rare paths that flush
+ * every CPU.
+ */
+struct rmnet_perf_cpu {
+	spinlock_t lock;
+	struct rmnet_perf_opt_meta *opt_meta;
+	/* skbs from physical device */
+	struct rmnet_perf_core_skb_list skb_needs_free_list;
+	struct rmnet_perf_core_burst_marker_state bm_state;
+};
+
 enum rmnet_perf_core_flush_reasons {
 	RMNET_PERF_CORE_IPA_ZERO_FLUSH,
 	RMNET_PERF_CORE_SK_BUFF_HELD_LIMIT,
@@ -138,6 +155,9 @@ enum rmnet_perf_trace_evt {
 
 void rmnet_perf_core_grab_lock(void);
 void rmnet_perf_core_release_lock(void);
+struct rmnet_perf_cpu *rmnet_perf_core_get_cpu(void);
+void rmnet_perf_core_flush_cpu(int cpu);
+void rmnet_perf_core_flush_all_cpus(void);
 void rmnet_perf_core_ps_on(void *port);
 void rmnet_perf_core_ps_off(void *port);
 bool rmnet_perf_core_is_deag_mode(void);
@@ -145,6 +165,7 @@ void rmnet_perf_core_set_ingress_hook(void);
 void rmnet_perf_core_reset_recycled_skb(struct sk_buff *skb);
 struct sk_buff *rmnet_perf_core_elligible_for_cache_skb(u32 len);
 void rmnet_perf_core_free_held_skbs(void);
+void __rmnet_perf_core_free_held_skbs(struct rmnet_perf_cpu *pcpu);
 void rmnet_perf_core_send_skb(struct sk_buff *skb, struct rmnet_endpoint *ep);
 void rmnet_perf_core_send_desc(struct rmnet_frag_descriptor *frag_desc);
 void rmnet_perf_core_flush_curr_pkt(struct rmnet_perf_pkt_info *pkt_info,
@@ -57,18 +57,35 @@ enum {
 /* What protocols we optimize */
 static int rmnet_perf_opt_mode = RMNET_PERF_OPT_MODE_ALL;
 
-/* flow hash table */
-DEFINE_HASHTABLE(rmnet_perf_opt_fht, RMNET_PERF_FLOW_HASH_TABLE_BITS);
-
+/* rmnet_perf_opt_flush_flow_nodes_by_protocol() - Flush the flow nodes of
+ *		every CPU
+ * @protocol: only flush nodes of this transport protocol, 0 for all nodes
+ *
+ * Return:
+ *    - void
+ **/
 static void rmnet_perf_opt_flush_flow_nodes_by_protocol(u8 protocol)
 {
+	struct rmnet_perf *perf = rmnet_perf_config_get_perf();
 	struct rmnet_perf_opt_flow_node *flow_node;
+	struct rmnet_perf_cpu *pcpu;
 	int bkt_cursor;
+	int cpu;
 
-	hash_for_each(rmnet_perf_opt_fht, bkt_cursor, flow_node, list) {
-		if (flow_node->num_pkts_held > 0 &&
-		    flow_node->trans_proto == protocol)
-			rmnet_perf_opt_flush_single_flow_node(flow_node);
+	if (!perf)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		pcpu = per_cpu_ptr(perf->cpu_state, cpu);
+		spin_lock_bh(&pcpu->lock);
+		hash_for_each(pcpu->opt_meta->fht, bkt_cursor, flow_node,
+			      list) {
+			if (flow_node->num_pkts_held > 0 &&
+			    (!protocol || flow_node->trans_proto == protocol))
+				rmnet_perf_opt_flush_single_flow_node(
+								flow_node);
+		}
+		spin_unlock_bh(&pcpu->lock);
 	}
 }
 
@@ -82,8 +99,6 @@ static int rmnet_perf_set_opt_mode(const char *val,
 	strlcpy(value, val, 4);
 	value[3] = '\0';
 
-	rmnet_perf_core_grab_lock();
-
 	if (!strcmp(value, "tcp"))
 		rmnet_perf_opt_mode = RMNET_PERF_OPT_MODE_TCP;
 	else if (!strcmp(value, "udp"))
@@ -104,7 +119,10 @@ static int rmnet_perf_set_opt_mode(const char *val,
 	    rmnet_perf_opt_mode == RMNET_PERF_OPT_MODE_ALL)
 		goto out;
 
-	/* Flush out any nodes of the protocol we are no longer optimizing */
+	/* Flush out any nodes of the protocol we are no longer optimizing.
+	 * Ingress picks up the new mode under its CPU lock, so once we have
+	 * been through every CPU no such node is left.
+	 */
 	switch (rmnet_perf_opt_mode) {
 	case RMNET_PERF_OPT_MODE_TCP:
 		rmnet_perf_opt_flush_flow_nodes_by_protocol(IPPROTO_UDP);
@@ -113,13 +131,11 @@ static int rmnet_perf_set_opt_mode(const char *val,
 		rmnet_perf_opt_flush_flow_nodes_by_protocol(IPPROTO_TCP);
 		break;
 	case RMNET_PERF_OPT_MODE_NON:
-		rmnet_perf_opt_flush_all_flow_nodes();
+		rmnet_perf_opt_flush_flow_nodes_by_protocol(0);
 		break;
 	}
 
 out:
-	rmnet_perf_core_release_lock();
-
 	return rc;
 }
 
@@ -487,11 +503,10 @@ rmnet_perf_opt_flow_skb_fixup(struct sk_buff *skb,
  **/
 static struct rmnet_perf_opt_flow_node *rmnet_perf_opt_get_new_flow_index(void)
 {
-	struct rmnet_perf *perf = rmnet_perf_config_get_perf();
 	struct rmnet_perf_opt_flow_node_pool *node_pool;
 	struct rmnet_perf_opt_flow_node *flow_node_ejected;
 
-	node_pool = perf->opt_meta->node_pool;
+	node_pool = rmnet_perf_core_get_cpu()->opt_meta->node_pool;
 	/* once this value gets too big it never goes back down.
 	 * from that point forward we use flow node repurposing techniques
 	 * instead
@@ -583,29 +598,33 @@ void rmnet_perf_opt_flush_single_flow_node(
  **/
 void rmnet_perf_opt_flush_flow_by_hash(u32 hash_val)
 {
+	struct rmnet_perf_opt_meta *opt_meta;
 	struct rmnet_perf_opt_flow_node *flow_node;
 
-	hash_for_each_possible(rmnet_perf_opt_fht, flow_node, list, hash_val) {
+	opt_meta = rmnet_perf_core_get_cpu()->opt_meta;
+	hash_for_each_possible(opt_meta->fht, flow_node, list, hash_val) {
 		if (hash_val == flow_node->hash_value &&
 		    flow_node->num_pkts_held > 0)
 			rmnet_perf_opt_flush_single_flow_node(flow_node);
 	}
 }
 
-/* rmnet_perf_opt_flush_all_flow_nodes() - Iterate through all flow nodes
- *		and flush them individually
+/* __rmnet_perf_opt_flush_all_flow_nodes() - Iterate through all flow nodes
+ *		of one CPU and flush them individually
+ * @opt_meta: the flow nodes of the CPU, caller holds the lock of that CPU
  *
  * Return:
  *    - void
  **/
-void rmnet_perf_opt_flush_all_flow_nodes(void)
+void
+__rmnet_perf_opt_flush_all_flow_nodes(struct rmnet_perf_opt_meta *opt_meta)
 {
 	struct rmnet_perf_opt_flow_node *flow_node;
 	int bkt_cursor;
 	int num_pkts_held;
 	u32 hash_val;
 
-	hash_for_each(rmnet_perf_opt_fht, bkt_cursor, flow_node, list) {
+	hash_for_each(opt_meta->fht, bkt_cursor, flow_node, list) {
 		hash_val = flow_node->hash_value;
 		num_pkts_held = flow_node->num_pkts_held;
 		if (num_pkts_held > 0) {
@@ -614,6 +633,19 @@ void rmnet_perf_opt_flush_all_flow_nodes(void)
 	}
 }
 
+/* rmnet_perf_opt_flush_all_flow_nodes() - Flush all flow nodes of the
+ *		current CPU
+ *
+ * Return:
+ *    - void
+ **/
+void rmnet_perf_opt_flush_all_flow_nodes(void)
+{
+	struct rmnet_perf_cpu *pcpu = rmnet_perf_core_get_cpu();
+
+	__rmnet_perf_opt_flush_all_flow_nodes(pcpu->opt_meta);
+}
+
 /* rmnet_perf_opt_chain_end() - Handle end of SKB chain notification
  *
  * Return:
@@ -712,13 +744,13 @@ void rmnet_perf_opt_insert_pkt_in_flow(
 		flow_node->next_seq += payload_len;
 }
 void
-rmnet_perf_free_hash_table(void)
+rmnet_perf_free_hash_table(struct rmnet_perf_opt_meta *opt_meta)
 {
 	int i;
 	struct rmnet_perf_opt_flow_node *flow_node;
 	struct hlist_node *tmp;
 
-	hash_for_each_safe(rmnet_perf_opt_fht, i, tmp, flow_node, list) {
+	hash_for_each_safe(opt_meta->fht, i, tmp, flow_node, list) {
 		hash_del(&flow_node->list);
 	}
 
@@ -738,6 +770,7 @@ rmnet_perf_free_hash_table(void)
  **/
 bool rmnet_perf_opt_ingress(struct rmnet_perf_pkt_info *pkt_info)
 {
+	struct rmnet_perf_opt_meta *opt_meta;
 	struct rmnet_perf_opt_flow_node *flow_node;
 	struct rmnet_perf_opt_flow_node *flow_node_recycled;
 	bool flush;
@@ -747,8 +780,9 @@ bool rmnet_perf_opt_ingress(struct rmnet_perf_pkt_info *pkt_info)
 	if (!rmnet_perf_optimize_protocol(pkt_info->trans_proto))
 		goto out;
 
+	opt_meta = rmnet_perf_core_get_cpu()->opt_meta;
 handle_pkt:
-	hash_for_each_possible(rmnet_perf_opt_fht, flow_node, list,
+	hash_for_each_possible(opt_meta->fht, flow_node, list,
 			       pkt_info->hash_key) {
 		if (!rmnet_perf_opt_identify_flow(flow_node, pkt_info))
 			continue;
@@ -782,7 +816,7 @@ bool rmnet_perf_opt_ingress(struct rmnet_perf_pkt_info *pkt_info)
 		flow_node_recycled = rmnet_perf_opt_get_new_flow_index();
 		flow_node_recycled->hash_value = pkt_info->hash_key;
 		rmnet_perf_opt_update_flow(flow_node_recycled, pkt_info);
-		hash_add(rmnet_perf_opt_fht, &flow_node_recycled->list,
+		hash_add(opt_meta->fht, &flow_node_recycled->list,
 			 pkt_info->hash_key);
 		goto handle_pkt;
 	}
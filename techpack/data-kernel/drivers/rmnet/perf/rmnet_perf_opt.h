@@ -13,6 +13,7 @@
 #ifndef _RMNET_PERF_OPT_H_
 #define _RMNET_PERF_OPT_H_
 
+#include <linux/hashtable.h>
 #include <linux/skbuff.h>
 #include "rmnet_perf_core.h"
 
@@ -87,6 +88,8 @@ struct rmnet_perf_opt_flow_node_pool {
 
 struct rmnet_perf_opt_meta {
 	struct rmnet_perf_opt_flow_node_pool *node_pool;
+	/* flow hash table */
+	DECLARE_HASHTABLE(fht, RMNET_PERF_FLOW_HASH_TABLE_BITS);
 };
 
 enum rmnet_perf_opt_flush_reasons {
@@ -102,11 +105,13 @@ void rmnet_perf_opt_flush_single_flow_node(
 				struct rmnet_perf_opt_flow_node *flow_node);
 void rmnet_perf_opt_flush_flow_by_hash(u32 hash_val);
 void rmnet_perf_opt_flush_all_flow_nodes(void);
+void
+__rmnet_perf_opt_flush_all_flow_nodes(struct rmnet_perf_opt_meta *opt_meta);
 void rmnet_perf_opt_chain_end(void);
 void rmnet_perf_opt_insert_pkt_in_flow(
 			struct rmnet_perf_opt_flow_node *flow_node,
 			struct rmnet_perf_pkt_info *pkt_info);
 bool rmnet_perf_opt_ingress(struct rmnet_perf_pkt_info *pkt_info);
-void rmnet_perf_free_hash_table(void);
+void rmnet_perf_free_hash_table(struct rmnet_perf_opt_meta *opt_meta);
 
 #endif /* _RMNET_PERF_OPT_H_ */
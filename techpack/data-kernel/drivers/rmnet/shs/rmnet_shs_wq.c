@@ -20,6 +20,9 @@
 #include <linux/list_sort.h>
 #include <net/sock.h>
 #include <linux/skbuff.h>
+#include <linux/arch_topology.h>
+#include <linux/cpufreq.h>
+#include <linux/kernel_stat.h>
 
 MODULE_LICENSE("GPL v2");
 /* Local Macros */
@@ -166,6 +169,33 @@ unsigned long long rmnet_shs_flow_gold_balance[MAX_SUPPORTED_FLOWS_DEBUG];
 module_param_array(rmnet_shs_flow_gold_balance, ullong, 0, 0444);
 MODULE_PARM_DESC(rmnet_shs_flow_gold_balance, "SHS Suggest Gold Balance");
 
+unsigned int rmnet_shs_wq_cost_placement __read_mostly;
+module_param(rmnet_shs_wq_cost_placement, uint, 0644);
+MODULE_PARM_DESC(rmnet_shs_wq_cost_placement,
+		 "Place flows by softirq cost and core capacity");
+
+unsigned int rmnet_shs_wq_elephant_pct __read_mostly = 60;
+module_param(rmnet_shs_wq_elephant_pct, uint, 0644);
+MODULE_PARM_DESC(rmnet_shs_wq_elephant_pct,
+		 "Flow load in % of its lpwr core to move it to a perf core");
+
+unsigned int rmnet_shs_wq_mice_pct __read_mostly = 10;
+module_param(rmnet_shs_wq_mice_pct, uint, 0644);
+MODULE_PARM_DESC(rmnet_shs_wq_mice_pct,
+		 "Flow load in % of a lpwr core to move it off a perf core");
+
+unsigned int rmnet_shs_cpu_capacity[MAX_CPUS];
+module_param_array(rmnet_shs_cpu_capacity, uint, 0, 0444);
+MODULE_PARM_DESC(rmnet_shs_cpu_capacity, "Core capacity at current freq");
+
+unsigned int rmnet_shs_cpu_softirq_util[MAX_CPUS];
+module_param_array(rmnet_shs_cpu_softirq_util, uint, 0, 0444);
+MODULE_PARM_DESC(rmnet_shs_cpu_softirq_util, "Core time in softirq (/1024)");
+
+unsigned int rmnet_shs_flow_rx_load[MAX_SUPPORTED_FLOWS_DEBUG];
+module_param_array(rmnet_shs_flow_rx_load, uint, 0, 0444);
+MODULE_PARM_DESC(rmnet_shs_flow_rx_load, "Flow softirq load in capacity units");
+
 static DEFINE_SPINLOCK(rmnet_shs_hstat_tbl_lock);
 static DEFINE_SPINLOCK(rmnet_shs_ep_lock);
 
@@ -585,6 +615,7 @@ void rmnet_shs_wq_update_hash_stats_debug(struct rmnet_shs_wq_hstat_s *hstats_p,
 		hstats_p->rmnet_shs_wq_suggs[RMNET_SHS_WQ_SUGG_GOLD_TO_SILVER];
 	rmnet_shs_flow_gold_balance[hstats_p->stat_idx] =
 		hstats_p->rmnet_shs_wq_suggs[RMNET_SHS_WQ_SUGG_GOLD_BALANCE];
+	rmnet_shs_flow_rx_load[hstats_p->stat_idx] = hstats_p->rx_load;
 
 }
 
@@ -702,6 +733,38 @@ static void rmnet_shs_wq_refresh_cpu_rates_debug(u16 cpu,
 	rmnet_shs_cpu_rx_pkts[cpu] = cpu_p->rx_skbs;
 	rmnet_shs_cpu_qhead_diff[cpu] = cpu_p->qhead_diff;
 	rmnet_shs_cpu_qhead_total[cpu] = cpu_p->qhead_total;
+	rmnet_shs_cpu_capacity[cpu] = cpu_p->capacity;
+	rmnet_shs_cpu_softirq_util[cpu] = cpu_p->softirq_util;
+}
+
+/* Refresh the share of the last tick the core spent in softirq and its
+ * capacity at the frequency it currently runs at. Softirq time covers
+ * more than NET_RX but on the rmnet cores it is dominated by it.
+ */
+static void rmnet_shs_wq_refresh_cpu_cost(u16 cpu,
+				struct rmnet_shs_wq_cpu_rx_pkt_q_s *cpu_p)
+{
+	unsigned int cur_freq, max_freq;
+	u64 softirq_ns, tdiff;
+
+	if (!cpu_possible(cpu))
+		return;
+
+	softirq_ns = kcpustat_cpu(cpu).cpustat[CPUTIME_SOFTIRQ];
+	tdiff = rmnet_shs_wq_tnsec - cpu_p->l_epoch;
+	if (cpu_p->last_softirq_ns && tdiff)
+		cpu_p->softirq_util =
+			min_t(u64, div64_u64((softirq_ns -
+					      cpu_p->last_softirq_ns) <<
+					     SCHED_CAPACITY_SHIFT, tdiff),
+			      SCHED_CAPACITY_SCALE);
+	cpu_p->last_softirq_ns = softirq_ns;
+
+	cpu_p->capacity = topology_get_cpu_scale(NULL, cpu);
+	cur_freq = cpufreq_quick_get(cpu);
+	max_freq = cpufreq_quick_get_max(cpu);
+	if (cur_freq && cur_freq < max_freq)
+		cpu_p->capacity = cpu_p->capacity * cur_freq / max_freq;
 }
 
 static void rmnet_shs_wq_refresh_dl_mrkr_stats(void)
@@ -773,6 +836,7 @@ static void rmnet_shs_wq_refresh_cpu_stats(u16 cpu)
 
 	cpu_p = &rmnet_shs_rx_flow_tbl.cpu_list[cpu];
 	new_skbs = cpu_p->rx_skbs - cpu_p->last_rx_skbs;
+	rmnet_shs_wq_refresh_cpu_cost(cpu, cpu_p);
 
 	new_qhead = rmnet_shs_get_cpu_qhead(cpu);
 	if (cpu_p->qhead_start == 0)
@@ -1523,6 +1587,130 @@ void rmnet_shs_wq_eval_suggested_cpu(void)
 
 }
 
+/* Load a flow puts on its core, in capacity units. The softirq time of
+ * the core is split between its flows by their share of its packets.
+ */
+static u32 rmnet_shs_wq_get_flow_load(struct rmnet_shs_wq_hstat_s *hnode)
+{
+	struct rmnet_shs_wq_cpu_rx_pkt_q_s *cpu_p;
+
+	cpu_p = &rmnet_shs_rx_flow_tbl.cpu_list[hnode->current_cpu];
+	if (!cpu_p->rx_pps)
+		return 0;
+
+	return div64_u64((u64)cpu_p->softirq_util * cpu_p->capacity *
+			 min(hnode->rx_pps, cpu_p->rx_pps),
+			 (u64)cpu_p->rx_pps << SCHED_CAPACITY_SHIFT);
+}
+
+/* Core in @msk with the most (@most) or least spare capacity that can
+ * still take @load without going past the elephant threshold.
+ */
+static int rmnet_shs_wq_get_cost_core(u32 msk, u32 load, bool most)
+{
+	struct rmnet_shs_wq_cpu_rx_pkt_q_s *cpu_p;
+	int best_cpu = -1;
+	u32 best_spare = 0;
+	u32 limit, spare;
+	u16 cpu;
+
+	for (cpu = 0; cpu < MAX_CPUS; cpu++) {
+		if (!((1 << cpu) & msk) || !cpu_online(cpu) ||
+		    cpu_isolated(cpu))
+			continue;
+
+		cpu_p = &rmnet_shs_rx_flow_tbl.cpu_list[cpu];
+		limit = topology_get_cpu_scale(NULL, cpu) *
+			rmnet_shs_wq_elephant_pct / 100;
+		if (cpu_p->rx_load + load > limit)
+			continue;
+
+		spare = limit - cpu_p->rx_load;
+		if (best_cpu < 0 || (most && spare > best_spare) ||
+		    (!most && spare < best_spare)) {
+			best_cpu = cpu;
+			best_spare = spare;
+		}
+	}
+
+	return best_cpu;
+}
+
+/* Cost based wq evaluation, used instead of the pps thresholds when
+ * rmnet_shs_wq_cost_placement is set. A flow on a lpwr core whose load
+ * reaches rmnet_shs_wq_elephant_pct of the core's current capacity goes
+ * to the perf core with the most spare capacity, before the backlog of
+ * the lpwr core builds up. A flow on a perf core that would take less
+ * than rmnet_shs_wq_mice_pct of a lpwr core is packed onto the busiest
+ * lpwr core that can still take it, so the perf cluster can idle.
+ */
+static void rmnet_shs_wq_eval_flow_cost(void)
+{
+	struct rmnet_shs_wq_rx_flow_s *rx_flow_tbl_p = &rmnet_shs_rx_flow_tbl;
+	struct rmnet_shs_wq_cpu_rx_pkt_q_s *cpu_p;
+	struct rmnet_shs_wq_hstat_s *hnode;
+	u32 lpwr_cap;
+	u16 cpu;
+	int new_cpu;
+
+	for (cpu = 0; cpu < MAX_CPUS; cpu++)
+		rx_flow_tbl_p->cpu_list[cpu].rx_load = 0;
+
+	list_for_each_entry(hnode, &rmnet_shs_wq_hstat_tbl, hstat_node_id) {
+		if (!hnode->in_use || !hnode->node)
+			continue;
+
+		hnode->rx_load = rmnet_shs_wq_get_flow_load(hnode);
+		rx_flow_tbl_p->cpu_list[hnode->current_cpu].rx_load +=
+			hnode->rx_load;
+	}
+
+	lpwr_cap = topology_get_cpu_scale(NULL, 0);
+
+	list_for_each_entry(hnode, &rmnet_shs_wq_hstat_tbl, hstat_node_id) {
+		if (!hnode->in_use || !hnode->node || !hnode->rx_load)
+			continue;
+
+		/* A move is already pending for this flow */
+		if (hnode->suggested_cpu != hnode->current_cpu)
+			continue;
+
+		cpu = hnode->current_cpu;
+		cpu_p = &rx_flow_tbl_p->cpu_list[cpu];
+		if (rmnet_shs_cpu_node_tbl[cpu].wqprio)
+			continue;
+
+		if (rmnet_shs_is_lpwr_cpu(cpu)) {
+			if (hnode->rx_load * 100 <
+			    cpu_p->capacity * rmnet_shs_wq_elephant_pct)
+				continue;
+
+			new_cpu = rmnet_shs_wq_get_cost_core(
+				hnode->rps_config_msk & PERF_MASK,
+				hnode->rx_load, true);
+			if (new_cpu < 0 ||
+			    !rmnet_shs_wq_try_to_move_flow(cpu, new_cpu,
+				hnode->hash, RMNET_SHS_WQ_SUGG_SILVER_TO_GOLD))
+				continue;
+		} else {
+			if (hnode->rx_load * 100 >=
+			    lpwr_cap * rmnet_shs_wq_mice_pct)
+				continue;
+
+			new_cpu = rmnet_shs_wq_get_cost_core(
+				hnode->rps_config_msk & ~PERF_MASK,
+				hnode->rx_load, false);
+			if (new_cpu < 0 ||
+			    !rmnet_shs_wq_try_to_move_flow(cpu, new_cpu,
+				hnode->hash, RMNET_SHS_WQ_SUGG_GOLD_TO_SILVER))
+				continue;
+		}
+
+		cpu_p->rx_load -= hnode->rx_load;
+		rx_flow_tbl_p->cpu_list[new_cpu].rx_load += hnode->rx_load;
+	}
+}
+
 void rmnet_shs_wq_refresh_new_flow_list_per_ep(struct rmnet_shs_wq_ep_s *ep)
 {
 	int lo_core;
@@ -1937,7 +2125,10 @@ void rmnet_shs_wq_update_stats(void)
 		rmnet_shs_wq_cleanup_cpu_caps_list(&cpu_caps);
 	} else {
 		rm_err("%s", "SHS_UPDATE: shs userspace not connected, using default logic");
-		rmnet_shs_wq_eval_suggested_cpu();
+		if (rmnet_shs_wq_cost_placement)
+			rmnet_shs_wq_eval_flow_cost();
+		else
+			rmnet_shs_wq_eval_suggested_cpu();
 	}
 
 	rmnet_shs_wq_refresh_new_flow_list();
@@ -83,6 +83,7 @@ struct rmnet_shs_wq_hstat_s {
 	u64 avg_pps;
 	u64 last_rx_skb;
 	u64 last_rx_bytes;
+	u32 rx_load; /* softirq load on current core, in capacity units */
 	u32 rps_config_msk; /*configured rps mask for net device*/
 	u32 current_core_msk; /*mask where the current core's bit is set*/
 	u32 def_core_msk; /*(little cluster) avaialble core mask*/
@@ -117,6 +118,10 @@ struct rmnet_shs_wq_cpu_rx_pkt_q_s {
 	u32 qhead_diff; /* diff in pp in last tick*/
 	u32 qhead_start; /* start mark of total pp*/
 	u32 qhead_total; /* end mark of total pp*/
+	u64 last_softirq_ns; /* softirq time at the last tick */
+	u32 softirq_util; /* share of the last tick in softirq, in 1/1024 */
+	u32 capacity; /* capacity at the current frequency */
+	u32 rx_load; /* sum of the loads of the flows on this core */
 	int flows;
 	u16 cpu_num;
 };
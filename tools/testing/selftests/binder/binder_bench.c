@@ -0,0 +1,526 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * binder_bench - binder transaction throughput and latency
+ *
+ * A forked server process becomes the context manager of the given binder
+ * device and serves transactions from a pool of looper threads. Client
+ * threads in the parent send transactions to handle 0 and time them:
+ *
+ *	sync	BC_TRANSACTION with the payload inline, waits for BR_REPLY
+ *	oneway	BC_TRANSACTION with TF_ONE_WAY, waits for completion only
+ *	sg	BC_TRANSACTION_SG with the payload in a BINDER_TYPE_PTR buffer
+ *
+ * With -P the client threads run SCHED_FIFO against one busy loop per CPU
+ * and the server node is created with FLAT_BINDER_FLAG_INHERIT_RT, so that
+ * the cost of priority inheritance under contention shows up. The server
+ * reports its policy back in every reply, and the number of calls that did
+ * not run at real-time priority is printed.
+ *
+ * Becoming the context manager fails if the device already has one, so
+ * use a binder device that isn't otherwise in use. -P needs root.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <linux/android/binder.h>
+
+#define BINDER_VM_SIZE	(4 << 20)
+#define CMD_BUF_SIZE	256
+
+enum bench_mode {
+	MODE_SYNC,
+	MODE_ONEWAY,
+	MODE_SG,
+};
+
+static const char *mode_names[] = { "sync", "oneway", "sg" };
+
+struct cmd_buf {
+	char data[CMD_BUF_SIZE];
+	size_t len;
+};
+
+struct client {
+	pthread_t thread;
+	int fd;
+	uint64_t *lat_ns;
+	unsigned long nr;
+	unsigned long not_rt;
+	unsigned long throttled;
+	int err;
+};
+
+static const char *dev_path = "/dev/binder";
+static enum bench_mode mode = MODE_SYNC;
+static size_t payload_size = 128;
+static unsigned int nr_threads = 1;
+static unsigned long nr_iters = 10000;
+static int pi_test;
+static volatile int hogs_stop;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void put(struct cmd_buf *cb, const void *p, size_t len)
+{
+	if (cb->len + len > sizeof(cb->data)) {
+		fprintf(stderr, "command buffer overflow\n");
+		exit(1);
+	}
+	memcpy(cb->data + cb->len, p, len);
+	cb->len += len;
+}
+
+static void put_cmd(struct cmd_buf *cb, uint32_t cmd, const void *arg,
+		    size_t len)
+{
+	put(cb, &cmd, sizeof(cmd));
+	if (len)
+		put(cb, arg, len);
+}
+
+static int binder_open(void)
+{
+	void *map;
+	int fd;
+
+	fd = open(dev_path, O_RDWR | O_CLOEXEC);
+	if (fd < 0) {
+		perror(dev_path);
+		return -1;
+	}
+
+	map = mmap(NULL, BINDER_VM_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		perror("mmap");
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+static int binder_rw(int fd, struct cmd_buf *cb, void *rbuf, size_t rsize,
+		     size_t *rlen)
+{
+	struct binder_write_read bwr = {
+		.write_size = cb->len,
+		.write_buffer = (binder_uintptr_t)cb->data,
+		.read_size = rsize,
+		.read_buffer = (binder_uintptr_t)rbuf,
+	};
+
+	while (ioctl(fd, BINDER_WRITE_READ, &bwr) < 0) {
+		if (errno != EINTR)
+			return -errno;
+		/* resume with whatever wasn't consumed yet */
+		bwr.write_size -= bwr.write_consumed;
+		bwr.write_buffer += bwr.write_consumed;
+		bwr.write_consumed = 0;
+	}
+	cb->len = 0;
+	*rlen = bwr.read_consumed;
+
+	return 0;
+}
+
+static void *server_thread(void *arg)
+{
+	int fd = (long)arg;
+	struct binder_transaction_data txn, reply;
+	struct binder_ptr_cookie pc;
+	struct cmd_buf cb = { .len = 0 };
+	char rbuf[CMD_BUF_SIZE];
+	int32_t policy;
+	size_t rlen, pos;
+	uint32_t cmd;
+
+	put_cmd(&cb, BC_ENTER_LOOPER, NULL, 0);
+
+	for (;;) {
+		if (binder_rw(fd, &cb, rbuf, sizeof(rbuf), &rlen))
+			break;
+
+		for (pos = 0; pos + sizeof(cmd) <= rlen;) {
+			memcpy(&cmd, rbuf + pos, sizeof(cmd));
+			pos += sizeof(cmd);
+
+			switch (cmd) {
+			case BR_TRANSACTION:
+				memcpy(&txn, rbuf + pos, sizeof(txn));
+				put_cmd(&cb, BC_FREE_BUFFER,
+					&txn.data.ptr.buffer,
+					sizeof(binder_uintptr_t));
+				if (txn.flags & TF_ONE_WAY)
+					break;
+
+				policy = sched_getscheduler(0);
+				memset(&reply, 0, sizeof(reply));
+				reply.data_size = sizeof(policy);
+				reply.data.ptr.buffer =
+					(binder_uintptr_t)&policy;
+				put_cmd(&cb, BC_REPLY, &reply, sizeof(reply));
+				break;
+			case BR_INCREFS:
+			case BR_ACQUIRE:
+				memcpy(&pc, rbuf + pos, sizeof(pc));
+				put_cmd(&cb, cmd == BR_INCREFS ?
+					BC_INCREFS_DONE : BC_ACQUIRE_DONE,
+					&pc, sizeof(pc));
+				break;
+			}
+			pos += _IOC_SIZE(cmd);
+		}
+	}
+
+	return NULL;
+}
+
+static void run_server(int ready_fd)
+{
+	struct flat_binder_object obj = {
+		.flags = pi_test ? FLAT_BINDER_FLAG_INHERIT_RT : 0,
+	};
+	uint32_t max_threads = 0;
+	pthread_t thread;
+	unsigned int i;
+	char ok = 'E';
+	int fd;
+
+	fd = binder_open();
+	if (fd < 0)
+		goto out;
+
+	/* don't get asked to spawn loopers, the pool is fixed */
+	ioctl(fd, BINDER_SET_MAX_THREADS, &max_threads);
+	if (ioctl(fd, BINDER_SET_CONTEXT_MGR_EXT, &obj) &&
+	    ioctl(fd, BINDER_SET_CONTEXT_MGR, 0)) {
+		perror("BINDER_SET_CONTEXT_MGR");
+		goto out;
+	}
+
+	for (i = 0; i < nr_threads + 1; i++) {
+		if (pthread_create(&thread, NULL, server_thread,
+				   (void *)(long)fd)) {
+			perror("pthread_create");
+			goto out;
+		}
+	}
+	ok = 'K';
+out:
+	if (write(ready_fd, &ok, 1) != 1 || ok != 'K')
+		exit(1);
+	for (;;)
+		pause();
+}
+
+/* Returns 1 when the call is complete, 0 to retry and <0 on error */
+static int client_call(struct client *c, struct cmd_buf *cb, void *payload)
+{
+	struct binder_transaction_data_sg sg;
+	struct binder_transaction_data *txn = &sg.transaction_data;
+	struct binder_buffer_object bbo;
+	binder_size_t offset = 0;
+	char rbuf[CMD_BUF_SIZE];
+	struct binder_transaction_data reply;
+	size_t rlen, pos;
+	uint32_t cmd;
+	int32_t policy;
+	int ret;
+
+	memset(&sg, 0, sizeof(sg));
+	txn->target.handle = 0;
+	txn->code = 1;
+	txn->flags = mode == MODE_ONEWAY ? TF_ONE_WAY : 0;
+
+	if (mode == MODE_SG) {
+		memset(&bbo, 0, sizeof(bbo));
+		bbo.hdr.type = BINDER_TYPE_PTR;
+		bbo.buffer = (binder_uintptr_t)payload;
+		bbo.length = payload_size;
+		txn->data_size = sizeof(bbo);
+		txn->offsets_size = sizeof(offset);
+		txn->data.ptr.buffer = (binder_uintptr_t)&bbo;
+		txn->data.ptr.offsets = (binder_uintptr_t)&offset;
+		sg.buffers_size = (payload_size + 7) & ~7UL;
+		put_cmd(cb, BC_TRANSACTION_SG, &sg, sizeof(sg));
+	} else {
+		txn->data_size = payload_size;
+		txn->data.ptr.buffer = (binder_uintptr_t)payload;
+		put_cmd(cb, BC_TRANSACTION, txn, sizeof(*txn));
+	}
+
+	for (;;) {
+		ret = binder_rw(c->fd, cb, rbuf, sizeof(rbuf), &rlen);
+		if (ret)
+			return ret;
+
+		for (pos = 0; pos + sizeof(cmd) <= rlen;) {
+			memcpy(&cmd, rbuf + pos, sizeof(cmd));
+			pos += sizeof(cmd);
+
+			switch (cmd) {
+			case BR_TRANSACTION_COMPLETE:
+				if (mode == MODE_ONEWAY)
+					return 1;
+				break;
+			case BR_REPLY:
+				memcpy(&reply, rbuf + pos, sizeof(reply));
+				if (reply.data_size >= sizeof(policy)) {
+					memcpy(&policy, (void *)(uintptr_t)
+					       reply.data.ptr.buffer,
+					       sizeof(policy));
+					if (pi_test && policy != SCHED_FIFO)
+						c->not_rt++;
+				}
+				/* freed with the next write */
+				put_cmd(cb, BC_FREE_BUFFER,
+					&reply.data.ptr.buffer,
+					sizeof(binder_uintptr_t));
+				return 1;
+			case BR_FAILED_REPLY:
+				/* async space of the server is full */
+				if (mode == MODE_ONEWAY)
+					return 0;
+				return -ENOSPC;
+			case BR_DEAD_REPLY:
+				return -EPIPE;
+			}
+			pos += _IOC_SIZE(cmd);
+		}
+	}
+}
+
+static void *client_thread(void *arg)
+{
+	struct client *c = arg;
+	struct cmd_buf cb = { .len = 0 };
+	struct sched_param sp = { .sched_priority = 1 };
+	size_t rlen;
+	char rbuf[CMD_BUF_SIZE];
+	void *payload;
+	uint64_t t;
+	int ret;
+
+	if (pi_test && sched_setscheduler(0, SCHED_FIFO, &sp)) {
+		perror("sched_setscheduler");
+		c->err = -errno;
+		return NULL;
+	}
+
+	payload = calloc(1, payload_size ? payload_size : 1);
+	if (!payload) {
+		c->err = -ENOMEM;
+		return NULL;
+	}
+
+	while (c->nr < nr_iters) {
+		t = now_ns();
+		ret = client_call(c, &cb, payload);
+		if (ret < 0) {
+			c->err = ret;
+			break;
+		}
+		if (!ret) {
+			c->throttled++;
+			usleep(50);
+			continue;
+		}
+		c->lat_ns[c->nr++] = now_ns() - t;
+	}
+
+	/* hand back the last reply buffer */
+	if (cb.len)
+		binder_rw(c->fd, &cb, rbuf, 0, &rlen);
+	free(payload);
+
+	return NULL;
+}
+
+static void *hog_thread(void *arg)
+{
+	while (!hogs_stop)
+		;
+	return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-d dev] [-m sync|oneway|sg] [-s payload bytes]\n"
+		"       [-t client threads] [-n calls per thread] [-P]\n",
+		prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	static const double pct[] = { 50, 90, 99, 99.9 };
+	unsigned long i, j, total = 0, not_rt = 0, throttled = 0;
+	struct client *clients;
+	pthread_t *hogs = NULL;
+	long nr_hogs = 0;
+	int pipefd[2], c, fd, ret = 0;
+	uint64_t *lat, start, elapsed;
+	pid_t server;
+	char ok;
+
+	while ((c = getopt(argc, argv, "d:m:s:t:n:P")) != -1) {
+		switch (c) {
+		case 'd':
+			dev_path = optarg;
+			break;
+		case 'm':
+			for (i = 0; i < 3; i++)
+				if (!strcmp(optarg, mode_names[i]))
+					break;
+			if (i == 3)
+				usage(argv[0]);
+			mode = i;
+			break;
+		case 's':
+			payload_size = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			nr_threads = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			nr_iters = strtoul(optarg, NULL, 0);
+			break;
+		case 'P':
+			pi_test = 1;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!nr_threads || !nr_iters)
+		usage(argv[0]);
+
+	if (pipe(pipefd)) {
+		perror("pipe");
+		return 1;
+	}
+	server = fork();
+	if (server < 0) {
+		perror("fork");
+		return 1;
+	}
+	if (!server) {
+		close(pipefd[0]);
+		run_server(pipefd[1]);
+	}
+	close(pipefd[1]);
+	if (read(pipefd[0], &ok, 1) != 1 || ok != 'K') {
+		fprintf(stderr, "server failed to start\n");
+		waitpid(server, NULL, 0);
+		return 1;
+	}
+
+	/* one binder_proc shared by all client threads, like an app */
+	fd = binder_open();
+	if (fd < 0) {
+		ret = 1;
+		goto out_server;
+	}
+
+	clients = calloc(nr_threads, sizeof(*clients));
+	lat = malloc(nr_threads * nr_iters * sizeof(*lat));
+	if (!clients || !lat) {
+		perror("malloc");
+		ret = 1;
+		goto out_server;
+	}
+
+	if (pi_test) {
+		nr_hogs = sysconf(_SC_NPROCESSORS_ONLN);
+		hogs = calloc(nr_hogs, sizeof(*hogs));
+		for (i = 0; hogs && i < (unsigned long)nr_hogs; i++)
+			pthread_create(&hogs[i], NULL, hog_thread, NULL);
+	}
+
+	start = now_ns();
+	for (i = 0; i < nr_threads; i++) {
+		clients[i].fd = fd;
+		clients[i].lat_ns = lat + i * nr_iters;
+		pthread_create(&clients[i].thread, NULL, client_thread,
+			       &clients[i]);
+	}
+	for (i = 0; i < nr_threads; i++)
+		pthread_join(clients[i].thread, NULL);
+	elapsed = now_ns() - start;
+
+	hogs_stop = 1;
+	for (i = 0; hogs && i < (unsigned long)nr_hogs; i++)
+		pthread_join(hogs[i], NULL);
+
+	/* compact the per-thread samples for the percentiles */
+	for (i = 0; i < nr_threads; i++) {
+		struct client *cl = &clients[i];
+
+		if (cl->err) {
+			fprintf(stderr, "thread %lu: %s\n", i,
+				strerror(-cl->err));
+			ret = 1;
+		}
+		for (j = 0; j < cl->nr; j++)
+			lat[total++] = cl->lat_ns[j];
+		not_rt += cl->not_rt;
+		throttled += cl->throttled;
+	}
+	if (!total)
+		goto out_server;
+
+	qsort(lat, total, sizeof(*lat), cmp_u64);
+	printf("%s %zu bytes, %u threads%s: %lu calls in %.3fs\n",
+	       mode_names[mode], payload_size, nr_threads,
+	       pi_test ? ", rt vs. cpu hogs" : "", total, elapsed / 1e9);
+	printf("throughput %.0f calls/s, %.1f MB/s\n",
+	       total / (elapsed / 1e9),
+	       total * payload_size / (elapsed / 1e9) / (1 << 20));
+	printf("latency   ");
+	for (i = 0; i < sizeof(pct) / sizeof(pct[0]); i++)
+		printf(" p%g %.1fus", pct[i],
+		       lat[(unsigned long)(total * pct[i] / 100)] / 1000.0);
+	printf(" max %.1fus\n", lat[total - 1] / 1000.0);
+	if (mode == MODE_ONEWAY)
+		printf("throttled  %lu retries on full async space\n",
+		       throttled);
+	if (pi_test && mode != MODE_ONEWAY) {
+		printf("inherit   %lu of %lu calls not run at SCHED_FIFO\n",
+		       not_rt, total);
+		if (not_rt)
+			ret = 1;
+	}
+
+out_server:
+	kill(server, SIGKILL);
+	waitpid(server, NULL, 0);
+
+	return ret;
+}
@@ -0,0 +1,477 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * sched_bench - periodic workload for scheduler latency and placement
+ *
+ * A number of threads wake up every period and run for a share of it, in
+ * the style of rt-app. The run starts with a light duty cycle and switches
+ * to a heavy one halfway through, so that the same run exercises task
+ * placement on little CPUs, upmigration, frequency ramp up and core_ctl
+ * unisolation:
+ *
+ *	./sched_bench -t 4 -p 16000 -l 10 -H 80 -d 3
+ *
+ * Reported are:
+ * - wakeup latency, from the programmed timer expiry to the thread running,
+ *   for each phase;
+ * - upmigration delay, from the switch to the heavy phase until a thread is
+ *   first seen on a CPU of the highest cpu_capacity;
+ * - frequency ramp time, until a CPU of the highest capacity runs at its
+ *   maximum frequency, also in units of the WALT window (-w);
+ * - core_ctl unisolation latency, until the number of active CPUs reported
+ *   by core_ctl grows;
+ * - an energy estimate per phase, from the cap_states of the energy model
+ *   in /proc/sys/kernel/sched_domain (CONFIG_SCHED_DEBUG), cpufreq
+ *   time_in_state and the busy time of each CPU in /proc/stat.
+ *
+ * Missing interfaces are skipped, so the tool also runs on symmetric
+ * systems and kernels without WALT or core_ctl.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_CPUS	64
+#define MAX_FREQS	64
+#define MAX_THREADS	64
+#define NR_SNAPS	3	/* start, switch to heavy, end */
+#define POLL_NS		1000000ULL
+
+struct cpu_info {
+	unsigned long capacity;
+	unsigned long max_freq;
+	int nr_cap;
+	unsigned long cap_freq[MAX_FREQS];
+	unsigned long cap_power[MAX_FREQS];
+	int nr_tis;
+	unsigned long tis_freq[MAX_FREQS];
+	unsigned long long tis[NR_SNAPS][MAX_FREQS];
+	unsigned long long busy[NR_SNAPS];
+	unsigned long long total[NR_SNAPS];
+};
+
+struct worker {
+	pthread_t tid;
+	uint64_t *lat[2];
+	unsigned long nr_lat[2];
+	int64_t upmig_ns;
+};
+
+static struct cpu_info cpus[MAX_CPUS];
+static int nr_cpus;
+static unsigned long max_capacity;
+
+static uint64_t period_ns = 16000000ULL;
+static uint64_t phase_ns = 3000000000ULL;
+static unsigned int duty[2] = { 10, 80 };
+static uint64_t start_ns;
+static unsigned long max_lat;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t t)
+{
+	struct timespec ts = {
+		.tv_sec = t / 1000000000ULL,
+		.tv_nsec = t % 1000000000ULL,
+	};
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+	       EINTR)
+		;
+}
+
+static int read_ulong(const char *path, unsigned long *val)
+{
+	FILE *f = fopen(path, "r");
+	int ret;
+
+	if (!f)
+		return -1;
+	ret = fscanf(f, "%lu", val) == 1 ? 0 : -1;
+	fclose(f);
+	return ret;
+}
+
+static int is_big(int cpu)
+{
+	return cpu >= 0 && cpu < nr_cpus && cpus[cpu].capacity == max_capacity;
+}
+
+/* cap_states is a flat list of (capacity, frequency, power) triples */
+static void read_energy_model(int cpu)
+{
+	struct cpu_info *c = &cpus[cpu];
+	unsigned long cap, freq, power;
+	char path[128];
+	FILE *f;
+
+	snprintf(path, sizeof(path),
+		 "/proc/sys/kernel/sched_domain/cpu%d/domain0/group0/energy/cap_states",
+		 cpu);
+	f = fopen(path, "r");
+	if (!f)
+		return;
+	while (c->nr_cap < MAX_FREQS &&
+	       fscanf(f, "%lu %lu %lu", &cap, &freq, &power) == 3) {
+		c->cap_freq[c->nr_cap] = freq;
+		c->cap_power[c->nr_cap] = power;
+		c->nr_cap++;
+	}
+	fclose(f);
+}
+
+static void read_topology(void)
+{
+	char path[128];
+	int cpu;
+
+	nr_cpus = sysconf(_SC_NPROCESSORS_CONF);
+	if (nr_cpus > MAX_CPUS)
+		nr_cpus = MAX_CPUS;
+
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		struct cpu_info *c = &cpus[cpu];
+
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/cpu/cpu%d/cpu_capacity", cpu);
+		if (read_ulong(path, &c->capacity))
+			c->capacity = 1024;
+		if (c->capacity > max_capacity)
+			max_capacity = c->capacity;
+
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq",
+			 cpu);
+		read_ulong(path, &c->max_freq);
+		read_energy_model(cpu);
+	}
+}
+
+static void snapshot(int s)
+{
+	unsigned long long v[10];
+	unsigned long freq;
+	unsigned long long t;
+	char path[128], line[256];
+	FILE *f;
+	int cpu, i, n;
+
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		struct cpu_info *c = &cpus[cpu];
+
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/cpu/cpu%d/cpufreq/stats/time_in_state",
+			 cpu);
+		f = fopen(path, "r");
+		if (!f)
+			continue;
+		for (i = 0; i < MAX_FREQS &&
+		     fscanf(f, "%lu %llu", &freq, &t) == 2; i++) {
+			c->tis_freq[i] = freq;
+			c->tis[s][i] = t;
+		}
+		c->nr_tis = i;
+		fclose(f);
+	}
+
+	f = fopen("/proc/stat", "r");
+	if (!f)
+		return;
+	while (fgets(line, sizeof(line), f)) {
+		memset(v, 0, sizeof(v));
+		n = sscanf(line,
+			   "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+			   &cpu, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5],
+			   &v[6], &v[7], &v[8], &v[9]);
+		if (n < 5 || cpu < 0 || cpu >= nr_cpus)
+			continue;
+		cpus[cpu].total[s] = 0;
+		for (i = 0; i < 8; i++)
+			cpus[cpu].total[s] += v[i];
+		/* idle and iowait */
+		cpus[cpu].busy[s] = cpus[cpu].total[s] - v[3] - v[4];
+	}
+	fclose(f);
+}
+
+static unsigned long freq_power(struct cpu_info *c, unsigned long freq)
+{
+	int i;
+
+	for (i = 0; i < c->nr_cap; i++)
+		if (c->cap_freq[i] >= freq)
+			return c->cap_power[i];
+	return c->nr_cap ? c->cap_power[c->nr_cap - 1] : 0;
+}
+
+/* energy model power times seconds, between snapshots s and s + 1 */
+static double phase_energy(int s)
+{
+	double energy = 0, busy;
+	int cpu, i;
+
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		struct cpu_info *c = &cpus[cpu];
+		unsigned long long total = c->total[s + 1] - c->total[s];
+
+		if (!c->nr_cap || !total)
+			continue;
+		busy = (double)(c->busy[s + 1] - c->busy[s]) / total;
+		/* time_in_state is in units of 10ms */
+		for (i = 0; i < c->nr_tis; i++)
+			energy += (c->tis[s + 1][i] - c->tis[s][i]) / 100.0 *
+				  busy * freq_power(c, c->tis_freq[i]);
+	}
+	return energy;
+}
+
+static void *worker_fn(void *arg)
+{
+	struct worker *w = arg;
+	uint64_t heavy = start_ns + phase_ns, stop = heavy + phase_ns;
+	uint64_t next = start_ns, t, end;
+	int ph;
+
+	while (next < stop) {
+		sleep_until(next);
+		t = now_ns();
+		ph = next >= heavy;
+		if (w->nr_lat[ph] < max_lat)
+			w->lat[ph][w->nr_lat[ph]++] = t - next;
+
+		end = t + period_ns * duty[ph] / 100;
+		do {
+			if (ph && w->upmig_ns < 0 && is_big(sched_getcpu()))
+				w->upmig_ns = t - heavy;
+			t = now_ns();
+		} while (t < end);
+
+		/* overruns skip the missed activations, as rt-app does */
+		next += period_ns;
+		while (next < t)
+			next += period_ns;
+	}
+	return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void report_lat(const char *what, uint64_t *ns, unsigned long nr)
+{
+	static const double pct[] = { 50, 90, 99, 99.9 };
+	unsigned int i;
+
+	if (!nr)
+		return;
+
+	qsort(ns, nr, sizeof(*ns), cmp_u64);
+	printf("%-10s %8lu wakeups", what, nr);
+	for (i = 0; i < sizeof(pct) / sizeof(pct[0]); i++)
+		printf("  p%g %6.1fus", pct[i],
+		       ns[(unsigned long)(nr * pct[i] / 100)] / 1000.0);
+	printf("  max %6.1fus\n", ns[nr - 1] / 1000.0);
+}
+
+static int core_ctl_active(void)
+{
+	unsigned long val;
+	char path[128];
+	int cpu, found = 0, active = 0;
+
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/cpu/cpu%d/core_ctl/active_cpus",
+			 cpu);
+		if (read_ulong(path, &val))
+			continue;
+		found = 1;
+		active += val;
+	}
+	return found ? active : -1;
+}
+
+static int big_at_max_freq(void)
+{
+	unsigned long cur;
+	char path[128];
+	int cpu;
+
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		if (!is_big(cpu) || !cpus[cpu].max_freq)
+			continue;
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq",
+			 cpu);
+		if (!read_ulong(path, &cur) && cur >= cpus[cpu].max_freq)
+			return 1;
+	}
+	return 0;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-t threads] [-p period us] [-l light duty %%] "
+		"[-H heavy duty %%] [-d seconds per phase] "
+		"[-w WALT window ms]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct worker workers[MAX_THREADS] = { 0 };
+	unsigned long i, nr_threads = 4, nr[2] = { 0 }, nr_upmig = 0;
+	uint64_t *all[2], *upmig, heavy, stop, t;
+	int64_t ramp_ns = -1, unisolate_ns = -1;
+	double window_ms = 20;
+	int active0, active, big_at_start, c, ph;
+
+	while ((c = getopt(argc, argv, "t:p:l:H:d:w:")) != -1) {
+		switch (c) {
+		case 't':
+			nr_threads = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			period_ns = strtoull(optarg, NULL, 0) * 1000;
+			break;
+		case 'l':
+			duty[0] = strtoul(optarg, NULL, 0);
+			break;
+		case 'H':
+			duty[1] = strtoul(optarg, NULL, 0);
+			break;
+		case 'd':
+			phase_ns = strtoull(optarg, NULL, 0) * 1000000000ULL;
+			break;
+		case 'w':
+			window_ms = strtod(optarg, NULL);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!nr_threads || nr_threads > MAX_THREADS || !period_ns ||
+	    !phase_ns || duty[0] > 100 || duty[1] > 100 || window_ms <= 0)
+		usage(argv[0]);
+
+	read_topology();
+
+	max_lat = phase_ns / period_ns + 1;
+	all[0] = malloc(nr_threads * max_lat * sizeof(uint64_t));
+	all[1] = malloc(nr_threads * max_lat * sizeof(uint64_t));
+	upmig = malloc(nr_threads * sizeof(uint64_t));
+	if (!all[0] || !all[1] || !upmig) {
+		perror("malloc");
+		return 1;
+	}
+
+	/* leave the threads time to be created before the first period */
+	start_ns = now_ns() + 100000000ULL;
+	heavy = start_ns + phase_ns;
+	stop = heavy + phase_ns;
+
+	for (i = 0; i < nr_threads; i++) {
+		struct worker *w = &workers[i];
+
+		w->upmig_ns = -1;
+		w->lat[0] = malloc(max_lat * sizeof(uint64_t));
+		w->lat[1] = malloc(max_lat * sizeof(uint64_t));
+		if (!w->lat[0] || !w->lat[1]) {
+			perror("malloc");
+			return 1;
+		}
+		errno = pthread_create(&w->tid, NULL, worker_fn, w);
+		if (errno) {
+			perror("pthread_create");
+			return 1;
+		}
+	}
+
+	snapshot(0);
+	sleep_until(heavy);
+	snapshot(1);
+
+	active0 = core_ctl_active();
+	big_at_start = big_at_max_freq();
+	for (t = now_ns(); t < stop; t = now_ns()) {
+		if (ramp_ns < 0 && !big_at_start && big_at_max_freq())
+			ramp_ns = t - heavy;
+		if (unisolate_ns < 0 && active0 >= 0) {
+			active = core_ctl_active();
+			if (active > active0)
+				unisolate_ns = t - heavy;
+		}
+		sleep_until(t + POLL_NS);
+	}
+	snapshot(2);
+
+	for (i = 0; i < nr_threads; i++) {
+		struct worker *w = &workers[i];
+
+		pthread_join(w->tid, NULL);
+		for (ph = 0; ph < 2; ph++) {
+			memcpy(all[ph] + nr[ph], w->lat[ph],
+			       w->nr_lat[ph] * sizeof(uint64_t));
+			nr[ph] += w->nr_lat[ph];
+		}
+		if (w->upmig_ns >= 0)
+			upmig[nr_upmig++] = w->upmig_ns;
+	}
+
+	printf("threads    %lu, period %llu us, duty %u%% -> %u%%, %llu s per phase\n",
+	       nr_threads, (unsigned long long)period_ns / 1000, duty[0],
+	       duty[1], (unsigned long long)phase_ns / 1000000000ULL);
+	report_lat("light", all[0], nr[0]);
+	report_lat("heavy", all[1], nr[1]);
+
+	qsort(upmig, nr_upmig, sizeof(*upmig), cmp_u64);
+	if (nr_upmig)
+		printf("upmigrate  %lu/%lu threads, p50 %.1f ms, max %.1f ms\n",
+		       nr_upmig, nr_threads, upmig[nr_upmig / 2] / 1e6,
+		       upmig[nr_upmig - 1] / 1e6);
+	else
+		printf("upmigrate  no thread reached a CPU of capacity %lu\n",
+		       max_capacity);
+
+	if (big_at_start)
+		printf("freq ramp  already at max frequency\n");
+	else if (ramp_ns >= 0)
+		printf("freq ramp  %.1f ms, %.1f WALT windows\n", ramp_ns / 1e6,
+		       ramp_ns / 1e6 / window_ms);
+	else
+		printf("freq ramp  max frequency not reached\n");
+
+	if (active0 >= 0) {
+		if (unisolate_ns >= 0)
+			printf("core_ctl   unisolated after %.1f ms\n",
+			       unisolate_ns / 1e6);
+		else
+			printf("core_ctl   %d active cpus, none unisolated\n",
+			       active0);
+	}
+
+	if (cpus[0].nr_cap)
+		printf("energy     light %.1f, heavy %.1f (energy model power * s)\n",
+		       phase_energy(0), phase_energy(1));
+
+	return 0;
+}
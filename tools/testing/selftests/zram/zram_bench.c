@@ -0,0 +1,418 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * zram_bench - replay page contents and an access trace through zram
+ *
+ * The device has to be set up beforehand (comp_algorithm, use_dedup,
+ * disksize), so that the same page set can be run against different
+ * configurations:
+ *
+ *	echo lz4 > /sys/block/zram0/comp_algorithm
+ *	echo 1 > /sys/block/zram0/use_dedup
+ *	echo 512M > /sys/block/zram0/disksize
+ *	./zram_bench -d /dev/zram0 -i pages.bin -t trace.txt
+ *
+ * Pages come from a file of raw 4K pages, e.g. anonymous memory dumped
+ * from a running process, or are generated from a fixed seed when no file
+ * is given. The trace holds one access per line, "w <slot> <page>" writes
+ * page <page> of the input to <slot> of the device and "r <slot>" reads
+ * it back. Without a trace every page is written once and then read back
+ * in random order.
+ *
+ * zram compresses and decompresses in the context of the submitting
+ * thread, so per I/O latency and thread CPU time measure the compressor,
+ * dedup and zsmalloc paths rather than the block layer. The exception is
+ * a device with async_write set: writes and readahead then run on
+ * kworkers, so only latency is reported and the CPU time is left out.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define PAGE_SZ		4096
+#define NR_SYNTH_PAGES	65536
+
+struct access {
+	char op;
+	unsigned long slot;
+	unsigned long page;
+};
+
+struct lat_stats {
+	uint64_t *ns;
+	unsigned long nr;
+	uint64_t cpu_ns;
+};
+
+static char *pages;
+static unsigned long nr_pages;
+static struct access *trace;
+static unsigned long nr_trace;
+static int async_io;
+
+static uint64_t now_ns(clockid_t clk)
+{
+	struct timespec ts;
+
+	clock_gettime(clk, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t rnd_state = 0x2545f491;
+
+static uint32_t rnd(void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+/*
+ * A rough stand-in for anonymous memory: zero filled pages, copies of
+ * earlier pages, sparse pointer-like data and incompressible data.
+ */
+static void synth_pages(unsigned long nr)
+{
+	unsigned long i, j;
+
+	pages = calloc(nr, PAGE_SZ);
+	if (!pages) {
+		perror("calloc");
+		exit(1);
+	}
+	nr_pages = nr;
+
+	for (i = 0; i < nr; i++) {
+		char *p = pages + i * PAGE_SZ;
+		uint32_t kind = rnd() % 100;
+
+		if (kind < 15)
+			continue;
+		if (kind < 25 && i) {
+			memcpy(p, pages + (rnd() % i) * PAGE_SZ, PAGE_SZ);
+			continue;
+		}
+		if (kind < 85) {
+			uint64_t base = 0x7f0000000000ULL + (rnd() & 0xffff000);
+
+			for (j = 0; j < PAGE_SZ / 8; j += 1 + rnd() % 4)
+				((uint64_t *)p)[j] = base + (rnd() & 0xfff8);
+			continue;
+		}
+		for (j = 0; j < PAGE_SZ / 4; j++)
+			((uint32_t *)p)[j] = rnd();
+	}
+}
+
+static void load_pages(const char *path)
+{
+	struct stat st;
+	ssize_t ret;
+	size_t done = 0;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st)) {
+		perror(path);
+		exit(1);
+	}
+
+	nr_pages = st.st_size / PAGE_SZ;
+	if (!nr_pages) {
+		fprintf(stderr, "%s: no full page in file\n", path);
+		exit(1);
+	}
+	pages = malloc(nr_pages * PAGE_SZ);
+	if (!pages) {
+		perror("malloc");
+		exit(1);
+	}
+
+	while (done < nr_pages * PAGE_SZ) {
+		ret = read(fd, pages + done, nr_pages * PAGE_SZ - done);
+		if (ret <= 0) {
+			perror(path);
+			exit(1);
+		}
+		done += ret;
+	}
+	close(fd);
+}
+
+static void add_access(char op, unsigned long slot, unsigned long page)
+{
+	static unsigned long max;
+
+	if (nr_trace == max) {
+		max = max ? max * 2 : 4096;
+		trace = realloc(trace, max * sizeof(*trace));
+		if (!trace) {
+			perror("realloc");
+			exit(1);
+		}
+	}
+	trace[nr_trace].op = op;
+	trace[nr_trace].slot = slot;
+	trace[nr_trace].page = page;
+	nr_trace++;
+}
+
+static void load_trace(const char *path)
+{
+	unsigned long slot, page;
+	char line[128], op;
+	FILE *f;
+	int n;
+
+	f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		page = 0;
+		n = sscanf(line, " %c %lu %lu", &op, &slot, &page);
+		if (n < 2 || (op != 'w' && op != 'r'))
+			continue;
+		if (op == 'w' && n < 3) {
+			fprintf(stderr, "%s: write without page: %s", path,
+				line);
+			exit(1);
+		}
+		add_access(op, slot, page % nr_pages);
+	}
+	fclose(f);
+}
+
+static void default_trace(void)
+{
+	unsigned long i, j, tmp, *order;
+
+	order = malloc(nr_pages * sizeof(*order));
+	if (!order) {
+		perror("malloc");
+		exit(1);
+	}
+
+	for (i = 0; i < nr_pages; i++) {
+		add_access('w', i, i);
+		order[i] = i;
+	}
+	for (i = nr_pages - 1; i > 0; i--) {
+		j = rnd() % (i + 1);
+		tmp = order[i];
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+	for (i = 0; i < nr_pages; i++)
+		add_access('r', order[i], 0);
+
+	free(order);
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void report_lat(const char *what, struct lat_stats *s)
+{
+	static const double pct[] = { 50, 90, 99, 99.9 };
+	unsigned int i;
+
+	if (!s->nr)
+		return;
+
+	qsort(s->ns, s->nr, sizeof(*s->ns), cmp_u64);
+	printf("%-10s %8lu ops", what, s->nr);
+	for (i = 0; i < sizeof(pct) / sizeof(pct[0]); i++)
+		printf("  p%g %6.1fus", pct[i],
+		       s->ns[(unsigned long)(s->nr * pct[i] / 100)] / 1000.0);
+	printf("  max %6.1fus\n", s->ns[s->nr - 1] / 1000.0);
+	if (async_io)
+		printf("%-10s cpu not measured, async_write is set\n", what);
+	else
+		printf("%-10s cpu %.1f ms/GB\n", what,
+		       s->cpu_ns / 1e6 / ((double)s->nr * PAGE_SZ / (1 << 30)));
+}
+
+/* 0 when the attribute is missing, i.e. without CONFIG_ZRAM_ASYNC_WRITE */
+static int read_async_write(const char *dev)
+{
+	const char *name = strrchr(dev, '/');
+	char path[256];
+	int val = 0;
+	FILE *f;
+
+	snprintf(path, sizeof(path), "/sys/block/%s/async_write",
+		 name ? name + 1 : dev);
+	f = fopen(path, "r");
+	if (!f)
+		return 0;
+	if (fscanf(f, "%d", &val) != 1)
+		val = 0;
+	fclose(f);
+
+	return val;
+}
+
+/* mm_stat: orig compr mem_used limit max_used same compacted dup meta */
+static void report_mm_stat(const char *dev)
+{
+	unsigned long long v[9] = { 0 };
+	const char *name = strrchr(dev, '/');
+	char path[256];
+	FILE *f;
+
+	snprintf(path, sizeof(path), "/sys/block/%s/mm_stat",
+		 name ? name + 1 : dev);
+	f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return;
+	}
+	if (fscanf(f, "%llu %llu %llu %llu %llu %llu %llu %llu %llu",
+		   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7],
+		   &v[8]) < 6) {
+		fprintf(stderr, "%s: unexpected format\n", path);
+		fclose(f);
+		return;
+	}
+	fclose(f);
+
+	printf("stored     %llu KB, compressed %llu KB, pool %llu KB\n",
+	       v[0] >> 10, v[1] >> 10, v[2] >> 10);
+	if (v[1])
+		printf("ratio      %.2f data, %.2f incl. pool overhead\n",
+		       (double)v[0] / v[1], v[2] ? (double)v[0] / v[2] : 0);
+	printf("same pages %llu\n", v[5]);
+	if (v[7] || v[8])
+		printf("dedup      %llu KB saved (%.1f%% of compressed data), "
+		       "%llu KB metadata\n", v[7] >> 10,
+		       100.0 * v[7] / (v[1] + v[7]), v[8] >> 10);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s -d <zram dev> [-i <pages file>] [-t <trace>] "
+		"[-n <synthetic pages>]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct lat_stats wr = { 0 }, rd = { 0 };
+	const char *dev = NULL, *in = NULL, *tr = NULL;
+	unsigned long i, nr = NR_SYNTH_PAGES, bad = 0;
+	uint64_t t, cpu;
+	char *buf;
+	int fd, c;
+
+	while ((c = getopt(argc, argv, "d:i:t:n:")) != -1) {
+		switch (c) {
+		case 'd':
+			dev = optarg;
+			break;
+		case 'i':
+			in = optarg;
+			break;
+		case 't':
+			tr = optarg;
+			break;
+		case 'n':
+			nr = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!dev || !nr)
+		usage(argv[0]);
+	async_io = read_async_write(dev);
+
+	if (in)
+		load_pages(in);
+	else
+		synth_pages(nr);
+	if (tr)
+		load_trace(tr);
+	else
+		default_trace();
+
+	wr.ns = malloc(nr_trace * sizeof(uint64_t));
+	rd.ns = malloc(nr_trace * sizeof(uint64_t));
+	if (!wr.ns || !rd.ns ||
+	    posix_memalign((void **)&buf, PAGE_SZ, PAGE_SZ)) {
+		perror("malloc");
+		return 1;
+	}
+
+	/* O_DIRECT keeps the page cache from absorbing reads and writes */
+	fd = open(dev, O_RDWR | O_DIRECT);
+	if (fd < 0) {
+		perror(dev);
+		return 1;
+	}
+
+	for (i = 0; i < nr_trace; i++) {
+		struct access *a = &trace[i];
+		off_t off = (off_t)a->slot * PAGE_SZ;
+		struct lat_stats *s = a->op == 'w' ? &wr : &rd;
+		ssize_t ret;
+
+		if (a->op == 'w')
+			memcpy(buf, pages + a->page * PAGE_SZ, PAGE_SZ);
+
+		cpu = now_ns(CLOCK_THREAD_CPUTIME_ID);
+		t = now_ns(CLOCK_MONOTONIC);
+		if (a->op == 'w')
+			ret = pwrite(fd, buf, PAGE_SZ, off);
+		else
+			ret = pread(fd, buf, PAGE_SZ, off);
+		s->ns[s->nr++] = now_ns(CLOCK_MONOTONIC) - t;
+		s->cpu_ns += now_ns(CLOCK_THREAD_CPUTIME_ID) - cpu;
+
+		if (ret != PAGE_SZ) {
+			fprintf(stderr, "%s slot %lu: %s\n",
+				a->op == 'w' ? "write" : "read", a->slot,
+				ret < 0 ? strerror(errno) : "short I/O");
+			return 1;
+		}
+	}
+
+	/* check the last write of every slot read back by the default trace */
+	if (!tr) {
+		for (i = 0; i < nr_pages; i++) {
+			if (pread(fd, buf, PAGE_SZ, (off_t)i * PAGE_SZ) !=
+			    PAGE_SZ ||
+			    memcmp(buf, pages + i * PAGE_SZ, PAGE_SZ))
+				bad++;
+		}
+	}
+	close(fd);
+
+	printf("pages      %lu input, %lu accesses\n", nr_pages, nr_trace);
+	report_lat("write", &wr);
+	report_lat("read", &rd);
+	report_mm_stat(dev);
+
+	if (bad) {
+		fprintf(stderr, "%lu pages read back corrupted\n", bad);
+		return 1;
+	}
+
+	return 0;
+}